@@ -17,8 +17,28 @@
 #include "core_cm55.h"
 #include "cmsis_gcc.h"
 #include "DevM_Runtime.h"
-#include "test_swc.h" // Include the header for Test SWC
-#include "SysM.h"     /* System Manager API */
+#include "test_swc.h"  // Include the header for Test SWC
+#include "SysM.h"      /* System Manager API */
+#include "DmaPool.h"   /* Non-cacheable DMA buffers */
+#include "IsrMgr.h"    /* RAM vector table and IRQ accounting */
+#include "DmaAlloc.h"  /* GPDMA1/HPDMA1 channel allocator */
+#include "DmaMem.h"    /* DMA memcpy/memset offload */
+#include "Dma2d.h"     /* DMA2D pixel conversion and blits */
+#include "Crc.h"       /* CRC unit, DMA feeding and software fallback */
+#include "Rng.h"       /* Interrupt-filled entropy pool */
+#include "Pka.h"       /* PKA signature verification */
+#include "SpiDma.h"    /* SPI transaction queue on DMA */
+#include "I2cDma.h"    /* I2C transaction engine on DMA */
+#include "I3cCtrl.h"   /* I3C controller with dynamic addressing and IBIs */
+#include "AdcAcq.h"    /* Timer-paced ADC acquisition on DMA */
+#include "HrTimer.h"   /* Microsecond hardware timers */
+#include "LpTick.h"    /* LPTIM1 kernel tick with tickless idle */
+#include "SdBlk.h"     /* SD card block device on SDMMC1 */
+#include "LogStore.h"  /* Persistent log store on SPI NOR flash */
+#include "UsbDev.h"    /* USB CDC port and trace channel on OTG1 */
+#include "GpioWave.h"  /* DMA-timed GPIO waveforms */
+#include "ExtiEvt.h"   /* Timestamped GPIO edge events */
+#include "WallClock.h" /* RTC-backed monotonic and UTC time */
 
 /* Logger */
 #include "logger.h"     /* Logger API */
@@ -106,6 +126,15 @@ static DevM_ReturnType DevM_InitInfra(void)
     /* Allow all master to AXI SRAM1/2 */
     DevM_DisableResourceSecurity();
 
+    /* Enable the DWT cycle counter used for driver timing statistics */
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Move the vector table to SRAM so drivers can bind their handlers */
+    if (!IsrMgr_Init())
+        return DEVM_ERROR;
+
     /* Configure priority grouping */
     NVIC_SetPriorityGrouping(4U);
 
@@ -132,6 +161,62 @@ static DevM_ReturnType DevM_InitInfra(void)
  */
 static DevM_ReturnType DevM_StateInitBswPreOS(void)
 {
+    if (!DmaAlloc_Init())
+        return DEVM_ERROR;
+
+    if (!DmaPool_Init())
+        return DEVM_ERROR;
+
+    if (!DmaMem_Init())
+        return DEVM_ERROR;
+
+    if (!Dma2d_Init())
+        return DEVM_ERROR;
+
+    if (!Crc_Init())
+        return DEVM_ERROR;
+
+    if (!Rng_Init())
+        return DEVM_ERROR;
+
+    if (!Pka_Init())
+        return DEVM_ERROR;
+
+    if (!SpiDma_Init())
+        return DEVM_ERROR;
+
+    if (!I2cDma_Init())
+        return DEVM_ERROR;
+
+    if (!I3cCtrl_Init())
+        return DEVM_ERROR;
+
+    if (!AdcAcq_Init())
+        return DEVM_ERROR;
+
+    if (!HrTimer_Init())
+        return DEVM_ERROR;
+
+    /* Without LPTIM1 the scheduler falls back to SysTick, so this is not fatal */
+    (void)LpTick_Init();
+
+    if (!SdBlk_Init())
+        return DEVM_ERROR;
+
+    if (!LogStore_Init())
+        return DEVM_ERROR;
+
+    if (!UsbDev_Init())
+        return DEVM_ERROR;
+
+    if (!GpioWave_Init())
+        return DEVM_ERROR;
+
+    if (!ExtiEvt_Init())
+        return DEVM_ERROR;
+
+    if (!WallClock_Init())
+        return DEVM_ERROR;
 
     return DEVM_OK;
 }
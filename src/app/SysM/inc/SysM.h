@@ -10,9 +10,17 @@
 
 /* Includes -----------------------------------------------------------------*/
 #include "logger.h"
+#include "UartDma.h"
 /* Macros and Defines -------------------------------------------------------*/
 
 /* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Health snapshot collected from the platform drivers.
+ */
+typedef struct
+{
+    UartDma_Status_T uart; /**< UART DMA link counters and latency histogram */
+} SysM_Diagnostics_T;
 
 /* Exported Variables -------------------------------------------------------*/
 
@@ -29,4 +37,11 @@ Logger_Context_T *Cfg_Logger_GetContext(void);
  */
 void Cfg_Logger_Init(void);
 
+/**
+ * @brief Collect a diagnostics snapshot from the platform drivers.
+ *
+ * @param[out] diag Destination for the snapshot.
+ */
+void SysM_GetDiagnostics(SysM_Diagnostics_T *diag);
+
 #endif /* SYSM_H */
@@ -8,7 +8,10 @@
 /* Includes -----------------------------------------------------------------*/
 #include "logger.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include "cfg_logger.h"
+#include "SysM.h"
+#include "UartDma.h"
 /* Defines ------------------------------------------------------------------*/
 
 /* Local Types and Typedefs -------------------------------------------------*/
@@ -44,6 +47,21 @@ void Cfg_Logger_Init(void)
                              CFG_LOGGER_ALLOC_FAILED,
                              &hp_alloc_failed);
 }
+
+/**
+ * @brief Collect a diagnostics snapshot from the platform drivers.
+ *
+ * @param[out] diag Destination for the snapshot.
+ */
+void SysM_GetDiagnostics(SysM_Diagnostics_T *diag)
+{
+    if (diag == NULL)
+    {
+        return;
+    }
+
+    UartDma_GetStatus(&diag->uart);
+}
 /* Private Functions Implementation -----------------------------------------*/
 /**
  * @brief Brief description of private helper function
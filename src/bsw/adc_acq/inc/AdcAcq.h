@@ -0,0 +1,151 @@
+/**
+ * @file AdcAcq.h
+ * @brief Timer-paced multi-channel ADC acquisition into a DMA double buffer
+ *
+ * TIM2 update events trigger one scan of up to ::ADCACQ_MAX_CHANNELS ADC1
+ * inputs, a frame. GPDMA1 stores the frames into a caller buffer split in
+ * two halves that it fills in turn without ever stopping; the half-transfer
+ * and transfer-complete interrupts hand each completed half, a block, to a
+ * processing task without copying it.
+ *
+ * The task takes a block, works on it in place and releases it. A block
+ * not taken before the DMA comes back to it is dropped; a block still held
+ * when the DMA comes back is overwritten and its release reports it. An
+ * ADC overrun restarts the acquisition at the start of the buffer.
+ *
+ * Hardware oversampling averages up to 1024 conversions per sample and
+ * keeps up to four extra bits of resolution.
+ */
+
+#ifndef ADC_ACQ_H
+#define ADC_ACQ_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef ADCACQ_MAX_CHANNELS
+#define ADCACQ_MAX_CHANNELS (8U) /**< Inputs in one frame */
+#endif
+
+#ifndef ADCACQ_ADC_MAX_HZ
+#define ADCACQ_ADC_MAX_HZ (50000000U) /**< Highest ADC kernel clock programmed by ::AdcAcq_Init */
+#endif
+
+#define ADCACQ_MAX_OVERSAMPLING (1024U) /**< Largest oversampling ratio */
+#define ADCACQ_NOTIFY_INDEX (0U)        /**< Task notification index set when a block completes */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Acquisition settings.
+ *
+ * The buffer holds two blocks of @ref frames_per_block frames, each frame
+ * one sample per channel in scan order. Unless it lies in the non-cacheable
+ * pool it must start on a cache line and each block must span whole lines.
+ */
+typedef struct
+{
+    uint8_t channels[ADCACQ_MAX_CHANNELS]; /**< ADC1 inputs, 0 to 19, in scan order */
+    uint32_t channel_count;                /**< Entries used in @ref channels */
+    uint32_t rate_hz;                      /**< Frames per second */
+    uint32_t oversampling;                 /**< Conversions averaged per sample, power of two up to 1024 */
+    uint32_t sampling_time;                /**< LL_ADC_SAMPLINGTIME_* of every input */
+    uint16_t *buffer;                      /**< Two blocks of samples */
+    uint32_t frames_per_block;             /**< Frames in one block */
+    TaskHandle_t task;                     /**< Task notified of every completed block, may be NULL */
+    uint32_t notify_bits;                  /**< Notification bits set for @ref task */
+} AdcAcq_Config_T;
+
+/**
+ * @brief Completed block lent to the processing task.
+ */
+typedef struct
+{
+    const uint16_t *samples; /**< @ref frames frames of one sample per channel */
+    uint32_t frames;         /**< Frames in the block */
+    uint32_t seq;            /**< Blocks completed before this one since the start */
+    uint32_t index;          /**< Half of the buffer, 0 or 1 */
+    bool restarted;          /**< An overrun restart lies between this block and the previous one taken */
+} AdcAcq_Block_T;
+
+/**
+ * @brief Acquisition counters.
+ */
+typedef struct
+{
+    uint32_t blocks;      /**< Blocks completed by the DMA */
+    uint32_t taken;       /**< Blocks handed to the processing task */
+    uint32_t dropped;     /**< Blocks lost before they were taken */
+    uint32_t overwritten; /**< Blocks overwritten while held */
+    uint32_t overruns;    /**< ADC overruns, each followed by a restart */
+    uint32_t dma_errors;  /**< DMA errors, each followed by a restart */
+    uint32_t irqs;        /**< ADC and DMA interrupts handled */
+    uint32_t actual_hz;   /**< Frame rate programmed into TIM2 */
+    uint32_t adc_hz;      /**< ADC kernel clock */
+    uint32_t sample_bits; /**< Significant bits of a sample */
+} AdcAcq_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable and calibrate ADC1, enable TIM2 and take the DMA channel.
+ *
+ * The inputs rely on the analog reset state of their pins.
+ *
+ * @retval true  Ready to start.
+ * @retval false No DMA channel or interrupt available, or the ADC did not become ready.
+ */
+bool AdcAcq_Init(void);
+
+/**
+ * @brief Start the acquisition.
+ *
+ * @param[in] config Settings, copied; the buffer is used in place until ::AdcAcq_Stop.
+ *
+ * @retval true  Running; the first block completes after @ref AdcAcq_Config_T::frames_per_block frames.
+ * @retval false Already running, invalid settings, or a frame does not fit in one timer period.
+ */
+bool AdcAcq_Start(const AdcAcq_Config_T *config);
+
+/**
+ * @brief Stop the timer, the ADC and the DMA; blocks not released are lost.
+ */
+void AdcAcq_Stop(void);
+
+/**
+ * @brief Take the oldest completed block.
+ *
+ * Waits on notification index ::ADCACQ_NOTIFY_INDEX of the calling task,
+ * which should be the task given to ::AdcAcq_Start.
+ *
+ * @param[out] block Block lent until ::AdcAcq_Release.
+ * @param[in]  wait  Ticks to wait for a block.
+ *
+ * @retval true  Block taken.
+ * @retval false No block completed in time.
+ */
+bool AdcAcq_Take(AdcAcq_Block_T *block, TickType_t wait);
+
+/**
+ * @brief Give a block back to the DMA.
+ *
+ * @param[in] block Block from ::AdcAcq_Take.
+ *
+ * @retval true  The samples were intact the whole time the block was held.
+ * @retval false The DMA overwrote the block while it was held, or it was not taken.
+ */
+bool AdcAcq_Release(const AdcAcq_Block_T *block);
+
+/**
+ * @brief Copy the acquisition counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void AdcAcq_GetStatus(AdcAcq_Status_T *status);
+
+#endif /* ADC_ACQ_H */
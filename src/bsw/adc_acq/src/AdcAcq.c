@@ -0,0 +1,780 @@
+/**
+ * @file AdcAcq.c
+ * @brief Implementation of the timer-paced ADC acquisition.
+ * @ingroup AdcAcq
+ * @{
+ *
+ * TIM2 runs free with TRGO on update; each edge starts one scan of the
+ * regular sequence. The ADC requests a DMA transfer per sample in circular
+ * DMA mode and the channel runs one block over the whole buffer whose
+ * linked-list item reloads the length and destination, so the buffer is
+ * refilled forever without software. HT marks the first half complete and
+ * TC the second.
+ *
+ * Each half is filling, ready or held. When the DMA moves into a half that
+ * is still ready, the block is dropped; when it moves into a held one the
+ * holder is told at release. A half completing while held is dropped, the
+ * holder still owning it.
+ *
+ * An overrun leaves the sequence and the buffer out of step, so the scan
+ * and the DMA are restarted from the first half; DMA errors do the same.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "AdcAcq.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_adc.h"
+#include "stm32n6xx_ll_tim.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define ADCACQ_ADC ADC1                   /**< ADC instance used */
+#define ADCACQ_TIM TIM2                   /**< Timer pacing the frames */
+#define ADCACQ_CONV_HALF_CYCLES (25U)     /**< 12-bit conversion, 12.5 ADC clock cycles after sampling */
+#define ADCACQ_RESOLUTION_BITS (12U)      /**< ADC resolution */
+#define ADCACQ_EXTRA_BITS_MAX (4U)        /**< Oversampling bits kept above the resolution */
+#define ADCACQ_MAX_BLOCK_BYTES (0xFFFFU / 2U) /**< Two blocks must fit in one DMA block length */
+#define ADCACQ_MAX_INPUT (19U)            /**< Highest ADC1 input */
+#define ADCACQ_LLI_ALIGN (16U)            /**< Keeps the item inside one 64 KiB linked-list window */
+#define ADCACQ_LLI_UPDATE (LL_DMA_UPDATE_CBR1 | LL_DMA_UPDATE_CDAR | LL_DMA_UPDATE_CLLR) /**< Registers reloaded per lap */
+#define ADCACQ_DMA_ERRORS (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF) /**< Channel flags restarting the acquisition */
+#define ADCACQ_SPIN_LIMIT (10000U)        /**< Polls of the ADC or a channel before giving up on it */
+
+#if (ADCACQ_MAX_CHANNELS > 8U)
+#error "ADCACQ_MAX_CHANNELS is limited to the ranks of SQR1 and SQR2 listed in g_adcAcqRanks"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Linked-list item reloading the buffer after each lap.
+ *
+ * Words follow the register order of CLLR's update bits.
+ */
+typedef struct
+{
+    uint32_t cbr1;
+    uint32_t cdar;
+    uint32_t cllr;
+} AdcAcq_Lli_T;
+
+/**
+ * @brief Owner of one half of the buffer.
+ */
+typedef enum
+{
+    ADCACQ_HALF_FILLING = 0, /**< Written by the DMA, or waiting for it */
+    ADCACQ_HALF_READY,       /**< Complete, not taken yet */
+    ADCACQ_HALF_HELD,        /**< Lent to the processing task */
+} AdcAcq_HalfState_T;
+
+/**
+ * @brief One half of the buffer.
+ */
+typedef struct
+{
+    AdcAcq_HalfState_T state; /**< Owner */
+    uint32_t seq;             /**< Block number of the samples it holds */
+    bool restarted;           /**< First block after a restart */
+    bool overwritten;         /**< The DMA wrote into it while held */
+} AdcAcq_Half_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Item looping the channel back to the start of the buffer. */
+static AdcAcq_Lli_T g_adcAcqLli __attribute__((section("noncacheable_buffer"), aligned(ADCACQ_LLI_ALIGN)));
+/** Channel moving the samples. */
+static DmaAlloc_Channel_T g_adcAcqChannel = {0};
+/** Settings of the running acquisition. */
+static AdcAcq_Config_T g_adcAcqConfig;
+/** Bytes in one block. */
+static uint32_t g_adcAcqBlockBytes = 0U;
+/** State of both halves of the buffer. */
+static AdcAcq_Half_T g_adcAcqHalf[2];
+/** Number of the next block to complete. */
+static uint32_t g_adcAcqSeq = 0U;
+/** A restart happened since the last block made ready. */
+static bool g_adcAcqRestarted = false;
+/** The acquisition runs. */
+static volatile bool g_adcAcqRunning = false;
+/** Counters reported by ::AdcAcq_GetStatus. */
+static AdcAcq_Status_T g_adcAcqStatus = {0};
+
+/** Regular sequence ranks, in scan order. */
+static const uint32_t g_adcAcqRanks[8] = {LL_ADC_REG_RANK_1, LL_ADC_REG_RANK_2, LL_ADC_REG_RANK_3,
+                                          LL_ADC_REG_RANK_4, LL_ADC_REG_RANK_5, LL_ADC_REG_RANK_6,
+                                          LL_ADC_REG_RANK_7, LL_ADC_REG_RANK_8};
+/** Sampling time of each LL_ADC_SAMPLINGTIME_* value, in half ADC clock cycles. */
+static const uint16_t g_adcAcqSampleHalfCycles[8] = {3U, 5U, 13U, 23U, 47U, 93U, 493U, 2999U};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Select and divide the ADC kernel clock, return its rate. */
+static uint32_t AdcAcq_InitClock(void);
+/** Calibrate and enable ADC1 with the settings common to every acquisition. */
+static bool AdcAcq_InitAdc(void);
+/** Take and configure the DMA channel. */
+static bool AdcAcq_InitChannel(void);
+/** Settings are acceptable. */
+static bool AdcAcq_IsValid(const AdcAcq_Config_T *config);
+/** Kernel clock of TIM2. */
+static uint32_t AdcAcq_TimerClock(void);
+/** Program the sequence, the sampling times and the oversampling. */
+static void AdcAcq_ConfigAdc(const AdcAcq_Config_T *config);
+/** Arm the channel at the start of the buffer. */
+static void AdcAcq_StartDma(void);
+/** Stop the scans and wait for the ADC to acknowledge. */
+static void AdcAcq_StopAdc(void);
+/** Stop the channel. */
+static void AdcAcq_ResetChannel(void);
+/** Restart the scans and the channel from the first half. */
+static void AdcAcq_Restart(void);
+/** The DMA moves into a half. */
+static void AdcAcq_Enter(uint32_t index);
+/** The DMA completed a half. */
+static void AdcAcq_Complete(uint32_t index);
+/** Lend the oldest ready half, if any. */
+static bool AdcAcq_Pop(AdcAcq_Block_T *block);
+/** First sample of a half. */
+static uint16_t *AdcAcq_HalfSamples(uint32_t index);
+/** ADC interrupt, only raised by overruns. */
+static void AdcAcq_AdcIrqHandler(void *ctx);
+/** DMA channel interrupt. */
+static void AdcAcq_DmaIrqHandler(void *ctx);
+/** Register block of the channel. */
+static DMA_Channel_TypeDef *AdcAcq_Regs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable and calibrate ADC1, enable TIM2 and take the DMA channel.
+ *
+ * The ADC runs from HCLK divided down to ::ADCACQ_ADC_MAX_HZ at most.
+ * TIM2 stays stopped with its update event routed to TRGO.
+ */
+bool AdcAcq_Init(void)
+{
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_ADC12);
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM2);
+    g_adcAcqStatus.adc_hz = AdcAcq_InitClock();
+    if ((g_adcAcqStatus.adc_hz == 0U) || !AdcAcq_InitAdc())
+    {
+        return false;
+    }
+
+    if (!AdcAcq_InitChannel() || !IsrMgr_Register(ADC1_2_IRQn, AdcAcq_AdcIrqHandler, NULL))
+    {
+        return false;
+    }
+
+    LL_TIM_DisableCounter(ADCACQ_TIM);
+    LL_TIM_SetPrescaler(ADCACQ_TIM, 0U);
+    LL_TIM_SetTriggerOutput(ADCACQ_TIM, LL_TIM_TRGO_UPDATE);
+
+    NVIC_SetPriority(ADC1_2_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                      configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(ADC1_2_IRQn);
+    return true;
+}
+
+/**
+ * @brief Start the acquisition.
+ *
+ * The timer period is the nearest whole number of timer clocks; a frame,
+ * with its oversampling, must convert within it or every frame would
+ * overrun.
+ */
+bool AdcAcq_Start(const AdcAcq_Config_T *config)
+{
+    if (g_adcAcqRunning || !AdcAcq_IsValid(config))
+    {
+        return false;
+    }
+
+    uint32_t timerHz = AdcAcq_TimerClock();
+    uint32_t ticks = (timerHz + (config->rate_hz / 2U)) / config->rate_hz;
+    uint64_t frameHalfCycles = (uint64_t)config->channel_count * config->oversampling *
+                               (g_adcAcqSampleHalfCycles[config->sampling_time] + ADCACQ_CONV_HALF_CYCLES);
+    if ((ticks < 2U) ||
+        ((frameHalfCycles * timerHz) >= ((uint64_t)ticks * 2U * g_adcAcqStatus.adc_hz)))
+    {
+        return false;
+    }
+
+    g_adcAcqConfig = *config;
+    g_adcAcqBlockBytes = config->frames_per_block * config->channel_count * sizeof(uint16_t);
+    if (!DmaPool_IsNonCacheable(config->buffer, 2U * g_adcAcqBlockBytes))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(config->buffer, (int32_t)(2U * g_adcAcqBlockBytes));
+    }
+
+    AdcAcq_ConfigAdc(config);
+    LL_TIM_SetAutoReload(ADCACQ_TIM, ticks - 1U);
+    LL_TIM_SetCounter(ADCACQ_TIM, 0U);
+
+    g_adcAcqLli.cbr1 = 2U * g_adcAcqBlockBytes;
+    g_adcAcqLli.cdar = (uint32_t)config->buffer;
+    g_adcAcqLli.cllr = ADCACQ_LLI_UPDATE | ((uint32_t)&g_adcAcqLli & DMA_CLLR_LA);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_adcAcqHalf[0] = (AdcAcq_Half_T){0};
+    g_adcAcqHalf[1] = (AdcAcq_Half_T){0};
+    g_adcAcqSeq = 0U;
+    g_adcAcqRestarted = false;
+    g_adcAcqStatus.actual_hz = (timerHz + (ticks / 2U)) / ticks;
+    g_adcAcqRunning = true;
+    AdcAcq_StartDma();
+    LL_ADC_ClearFlag_OVR(ADCACQ_ADC);
+    LL_ADC_REG_StartConversion(ADCACQ_ADC);
+    LL_TIM_EnableCounter(ADCACQ_TIM);
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Stop the timer, the ADC and the DMA.
+ */
+void AdcAcq_Stop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_adcAcqRunning)
+    {
+        g_adcAcqRunning = false;
+        LL_TIM_DisableCounter(ADCACQ_TIM);
+        AdcAcq_StopAdc();
+        AdcAcq_ResetChannel();
+        g_adcAcqHalf[0].state = ADCACQ_HALF_FILLING;
+        g_adcAcqHalf[1].state = ADCACQ_HALF_FILLING;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Take the oldest completed block, waiting for one up to @p wait ticks.
+ *
+ * Without a task to notify the wait polls every tick.
+ */
+bool AdcAcq_Take(AdcAcq_Block_T *block, TickType_t wait)
+{
+    TimeOut_t timeOut;
+    TickType_t remaining = wait;
+
+    if (block == NULL)
+    {
+        return false;
+    }
+
+    vTaskSetTimeOutState(&timeOut);
+    while (!AdcAcq_Pop(block))
+    {
+        if (xTaskCheckForTimeOut(&timeOut, &remaining) != pdFALSE)
+        {
+            return false;
+        }
+        if (g_adcAcqConfig.task != NULL)
+        {
+            (void)xTaskNotifyWaitIndexed(ADCACQ_NOTIFY_INDEX, 0U, g_adcAcqConfig.notify_bits, NULL, remaining);
+        }
+        else
+        {
+            vTaskDelay(1);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Give a block back to the DMA.
+ */
+bool AdcAcq_Release(const AdcAcq_Block_T *block)
+{
+    if ((block == NULL) || (block->index > 1U))
+    {
+        return false;
+    }
+
+    bool intact = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    AdcAcq_Half_T *half = &g_adcAcqHalf[block->index];
+    if ((half->state == ADCACQ_HALF_HELD) && (half->seq == block->seq))
+    {
+        intact = !half->overwritten;
+        half->state = ADCACQ_HALF_FILLING;
+        half->overwritten = false;
+    }
+    __set_PRIMASK(primask);
+    return intact;
+}
+
+/**
+ * @brief Copy the acquisition counters into @p status.
+ */
+void AdcAcq_GetStatus(AdcAcq_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_adcAcqStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Run the ADC from HCLK with the smallest prescaler keeping it within ::ADCACQ_ADC_MAX_HZ.
+ *
+ * @return ADC kernel clock, 0 if HCLK is unknown.
+ */
+static uint32_t AdcAcq_InitClock(void)
+{
+    LL_RCC_SetADCClockSource(LL_RCC_ADC_CLKSOURCE_HCLK);
+    uint32_t sourceHz = LL_RCC_GetADCClockFreq(LL_RCC_ADC_CLKSOURCE);
+    if (sourceHz == LL_RCC_PERIPH_FREQUENCY_NO)
+    {
+        return 0U;
+    }
+
+    uint32_t divider = (sourceHz + ADCACQ_ADC_MAX_HZ - 1U) / ADCACQ_ADC_MAX_HZ;
+    if (divider == 0U)
+    {
+        divider = 1U;
+    }
+    else if (divider > 256U)
+    {
+        divider = 256U;
+    }
+    LL_RCC_SetADCPrescaler(divider - 1U);
+    return sourceHz / divider;
+}
+
+/**
+ * @brief Calibrate and enable ADC1 with the settings common to every acquisition.
+ *
+ * Conversions start on a rising TIM2 TRGO, one sequence per edge, and an
+ * overrun keeps the unread sample so the DMA stream stays in order until
+ * the restart.
+ */
+static bool AdcAcq_InitAdc(void)
+{
+    uint32_t spin = ADCACQ_SPIN_LIMIT;
+
+    LL_ADC_DisableDeepPowerDown(ADCACQ_ADC);
+    LL_ADC_StartCalibration(ADCACQ_ADC, LL_ADC_SINGLE_ENDED);
+    while ((LL_ADC_IsCalibrationOnGoing(ADCACQ_ADC) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    if (spin == 0U)
+    {
+        return false;
+    }
+
+    spin = ADCACQ_SPIN_LIMIT;
+    LL_ADC_ClearFlag_ADRDY(ADCACQ_ADC);
+    LL_ADC_Enable(ADCACQ_ADC);
+    while ((LL_ADC_IsActiveFlag_ADRDY(ADCACQ_ADC) == 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    if (spin == 0U)
+    {
+        return false;
+    }
+
+    LL_ADC_SetResolution(ADCACQ_ADC, LL_ADC_RESOLUTION_12B);
+    LL_ADC_REG_SetTriggerSource(ADCACQ_ADC, LL_ADC_REG_TRIG_EXT_TIM2_TRGO);
+    LL_ADC_REG_SetTriggerEdge(ADCACQ_ADC, LL_ADC_REG_TRIG_EXT_RISING);
+    LL_ADC_REG_SetContinuousMode(ADCACQ_ADC, LL_ADC_REG_CONV_SINGLE);
+    LL_ADC_REG_SetDataTransferMode(ADCACQ_ADC, LL_ADC_REG_DMA_TRANSFER_UNLIMITED);
+    LL_ADC_REG_SetOverrun(ADCACQ_ADC, LL_ADC_REG_OVR_DATA_PRESERVED);
+    LL_ADC_ClearFlag_OVR(ADCACQ_ADC);
+    LL_ADC_EnableIT_OVR(ADCACQ_ADC);
+    return true;
+}
+
+/**
+ * @brief Take a linked-list channel for the stream and enable its interrupts.
+ */
+static bool AdcAcq_InitChannel(void)
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = DMAALLOC_CLASS_STREAM,
+        .caps = DMAALLOC_CAP_LINKED_LIST,
+        .burst_bytes = 0U,
+        .owner = "AdcAcq",
+        .handler = AdcAcq_DmaIrqHandler,
+        .ctx = NULL,
+    };
+
+    if (!DmaAlloc_Request(&request, &g_adcAcqChannel))
+    {
+        return false;
+    }
+
+    DMA_TypeDef *dma = g_adcAcqChannel.instance;
+    uint32_t ch = g_adcAcqChannel.channel;
+    LL_DMA_ConfigControl(dma, ch, g_adcAcqChannel.priority | LL_DMA_LINK_ALLOCATED_PORT0 | LL_DMA_LSM_FULL_EXECUTION);
+    LL_DMA_SetLinkedListBaseAddr(dma, ch, (uint32_t)&g_adcAcqLli);
+    LL_DMA_EnableIT_HT(dma, ch);
+    LL_DMA_EnableIT_TC(dma, ch);
+    LL_DMA_EnableIT_DTE(dma, ch);
+    LL_DMA_EnableIT_ULE(dma, ch);
+    LL_DMA_EnableIT_USE(dma, ch);
+    NVIC_SetPriority(g_adcAcqChannel.irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                              configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(g_adcAcqChannel.irq);
+    return true;
+}
+
+/**
+ * @brief Settings are acceptable.
+ *
+ * Both blocks must fit in one DMA block length and, outside the
+ * non-cacheable pool, cover whole cache lines so invalidating a completed
+ * block cannot discard anything else.
+ */
+static bool AdcAcq_IsValid(const AdcAcq_Config_T *config)
+{
+    if ((config == NULL) || (config->buffer == NULL) || (config->channel_count == 0U) ||
+        (config->channel_count > ADCACQ_MAX_CHANNELS) || (config->rate_hz == 0U) ||
+        (config->frames_per_block == 0U) || (config->sampling_time > LL_ADC_SAMPLINGTIME_1499CYCLES_5) ||
+        (config->oversampling == 0U) || (config->oversampling > ADCACQ_MAX_OVERSAMPLING) ||
+        ((config->oversampling & (config->oversampling - 1U)) != 0U))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < config->channel_count; i++)
+    {
+        if (config->channels[i] > ADCACQ_MAX_INPUT)
+        {
+            return false;
+        }
+    }
+
+    uint32_t blockBytes = config->frames_per_block * config->channel_count * sizeof(uint16_t);
+    if ((config->frames_per_block > ADCACQ_MAX_BLOCK_BYTES) || (blockBytes > ADCACQ_MAX_BLOCK_BYTES))
+    {
+        return false;
+    }
+    if (!DmaPool_IsNonCacheable(config->buffer, 2U * blockBytes) &&
+        ((((uint32_t)config->buffer % DMAPOOL_CACHE_LINE_SIZE) != 0U) || ((blockBytes % DMAPOOL_CACHE_LINE_SIZE) != 0U)))
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Kernel clock of TIM2: the system bus clock divided by the timer prescaler of the RCC.
+ */
+static uint32_t AdcAcq_TimerClock(void)
+{
+    return LL_RCC_GetSystemClockFreq() / (1UL << LL_RCC_GetTIMPrescaler());
+}
+
+/**
+ * @brief Program the sequence, the sampling times and the oversampling.
+ *
+ * The oversampled sum is shifted to keep at most ::ADCACQ_EXTRA_BITS_MAX
+ * bits above the resolution, so samples always fit in 16 bits.
+ */
+static void AdcAcq_ConfigAdc(const AdcAcq_Config_T *config)
+{
+    WRITE_REG(ADCACQ_ADC->PCSEL, 0U);
+    LL_ADC_REG_SetSequencerLength(ADCACQ_ADC, config->channel_count - 1U);
+    for (uint32_t i = 0U; i < config->channel_count; i++)
+    {
+        uint32_t channel = __LL_ADC_DECIMAL_NB_TO_CHANNEL(config->channels[i]);
+        LL_ADC_REG_SetSequencerRanks(ADCACQ_ADC, g_adcAcqRanks[i], channel);
+        LL_ADC_SetChannelPreselection(ADCACQ_ADC, channel);
+        LL_ADC_SetChannelSamplingTime(ADCACQ_ADC, channel, config->sampling_time);
+    }
+
+    uint32_t log2Ratio = (uint32_t)__builtin_ctz(config->oversampling);
+    uint32_t shift = (log2Ratio > ADCACQ_EXTRA_BITS_MAX) ? (log2Ratio - ADCACQ_EXTRA_BITS_MAX) : 0U;
+    if (config->oversampling > 1U)
+    {
+        LL_ADC_ConfigOverSamplingRatioShift(ADCACQ_ADC, config->oversampling, shift << ADC_CFGR2_OVSS_Pos);
+        LL_ADC_SetOverSamplingScope(ADCACQ_ADC, LL_ADC_OVS_GRP_REGULAR_CONTINUED);
+    }
+    else
+    {
+        LL_ADC_SetOverSamplingScope(ADCACQ_ADC, LL_ADC_OVS_DISABLE);
+    }
+    g_adcAcqStatus.sample_bits = ADCACQ_RESOLUTION_BITS + log2Ratio - shift;
+}
+
+/**
+ * @brief Arm the channel for one block over the whole buffer, reloaded by ::g_adcAcqLli.
+ */
+static void AdcAcq_StartDma(void)
+{
+    DMA_Channel_TypeDef *regs = AdcAcq_Regs();
+
+    WRITE_REG(regs->CTR1, LL_DMA_SRC_DATAWIDTH_HALFWORD | LL_DMA_DEST_DATAWIDTH_HALFWORD | LL_DMA_DEST_INCREMENT);
+    WRITE_REG(regs->CTR2, LL_GPDMA1_REQUEST_ADC1 | LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_TCEM_BLK_TRANSFER);
+    WRITE_REG(regs->CBR1, g_adcAcqLli.cbr1);
+    WRITE_REG(regs->CSAR, (uint32_t)&ADCACQ_ADC->DR);
+    WRITE_REG(regs->CDAR, g_adcAcqLli.cdar);
+    WRITE_REG(regs->CLLR, g_adcAcqLli.cllr);
+    DmaAlloc_NoteStart(&g_adcAcqChannel, g_adcAcqLli.cbr1);
+    __DMB();
+    LL_DMA_EnableChannel(g_adcAcqChannel.instance, g_adcAcqChannel.channel);
+}
+
+/**
+ * @brief Stop the scans; the trigger is ignored until the next ADSTART.
+ */
+static void AdcAcq_StopAdc(void)
+{
+    if (LL_ADC_REG_IsConversionOngoing(ADCACQ_ADC) == 0U)
+    {
+        return;
+    }
+
+    uint32_t spin = ADCACQ_SPIN_LIMIT;
+    LL_ADC_REG_StopConversion(ADCACQ_ADC);
+    while ((LL_ADC_REG_IsStopConversionOngoing(ADCACQ_ADC) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+}
+
+/**
+ * @brief Stop the channel.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void AdcAcq_ResetChannel(void)
+{
+    DMA_TypeDef *dma = g_adcAcqChannel.instance;
+    uint32_t ch = g_adcAcqChannel.channel;
+
+    if (LL_DMA_IsEnabledChannel(dma, ch) != 0U)
+    {
+        uint32_t spin = ADCACQ_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(dma, ch);
+        while ((LL_DMA_IsActiveFlag_SUSP(dma, ch) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(dma, ch);
+    DmaAlloc_NoteStop(&g_adcAcqChannel);
+    WRITE_REG(AdcAcq_Regs()->CFCR, DMA_CFCR_TCF | DMA_CFCR_HTF | DMA_CFCR_DTEF | DMA_CFCR_ULEF |
+                                       DMA_CFCR_USEF | DMA_CFCR_SUSPF | DMA_CFCR_TOF);
+}
+
+/**
+ * @brief Restart the scans and the channel from the first half.
+ *
+ * The samples of the half being filled are lost. Ready blocks stay
+ * ready; the first half is entered again as on a new lap.
+ */
+static void AdcAcq_Restart(void)
+{
+    AdcAcq_StopAdc();
+    AdcAcq_ResetChannel();
+    g_adcAcqRestarted = true;
+
+    AdcAcq_Enter(0U);
+    AdcAcq_StartDma();
+    LL_ADC_ClearFlag_OVR(ADCACQ_ADC);
+    LL_ADC_REG_StartConversion(ADCACQ_ADC);
+}
+
+/**
+ * @brief The DMA moves into half @p index: a ready block there is dropped, a held one overwritten.
+ */
+static void AdcAcq_Enter(uint32_t index)
+{
+    AdcAcq_Half_T *half = &g_adcAcqHalf[index];
+
+    if (half->state == ADCACQ_HALF_READY)
+    {
+        half->state = ADCACQ_HALF_FILLING;
+        g_adcAcqRestarted = g_adcAcqRestarted || half->restarted;
+        g_adcAcqStatus.dropped++;
+    }
+    else if ((half->state == ADCACQ_HALF_HELD) && !half->overwritten)
+    {
+        half->overwritten = true;
+        g_adcAcqStatus.overwritten++;
+    }
+}
+
+/**
+ * @brief The DMA completed half @p index and moved into the other one.
+ *
+ * The block is made ready and the task notified, unless the half is
+ * still held from an earlier lap.
+ */
+static void AdcAcq_Complete(uint32_t index)
+{
+    AdcAcq_Half_T *half = &g_adcAcqHalf[index];
+    uint32_t seq = g_adcAcqSeq++;
+
+    g_adcAcqStatus.blocks++;
+    AdcAcq_Enter(index ^ 1U);
+
+    if (half->state == ADCACQ_HALF_HELD)
+    {
+        g_adcAcqStatus.dropped++;
+        return;
+    }
+
+    uint16_t *samples = AdcAcq_HalfSamples(index);
+    if (!DmaPool_IsNonCacheable(samples, g_adcAcqBlockBytes))
+    {
+        SCB_InvalidateDCache_by_Addr(samples, (int32_t)g_adcAcqBlockBytes);
+    }
+    half->state = ADCACQ_HALF_READY;
+    half->seq = seq;
+    half->restarted = g_adcAcqRestarted;
+    g_adcAcqRestarted = false;
+
+    if (g_adcAcqConfig.task != NULL)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(g_adcAcqConfig.task, ADCACQ_NOTIFY_INDEX, g_adcAcqConfig.notify_bits, eSetBits,
+                                  &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Lend the ready half holding the oldest block.
+ */
+static bool AdcAcq_Pop(AdcAcq_Block_T *block)
+{
+    bool found = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    int32_t pick = -1;
+    for (uint32_t i = 0U; i < 2U; i++)
+    {
+        if ((g_adcAcqHalf[i].state == ADCACQ_HALF_READY) &&
+            ((pick < 0) || ((int32_t)(g_adcAcqHalf[i].seq - g_adcAcqHalf[pick].seq) < 0)))
+        {
+            pick = (int32_t)i;
+        }
+    }
+
+    if (pick >= 0)
+    {
+        AdcAcq_Half_T *half = &g_adcAcqHalf[pick];
+        half->state = ADCACQ_HALF_HELD;
+        half->overwritten = false;
+        block->samples = AdcAcq_HalfSamples((uint32_t)pick);
+        block->frames = g_adcAcqConfig.frames_per_block;
+        block->seq = half->seq;
+        block->index = (uint32_t)pick;
+        block->restarted = half->restarted;
+        g_adcAcqStatus.taken++;
+        found = true;
+    }
+    __set_PRIMASK(primask);
+    return found;
+}
+
+/**
+ * @brief First sample of half @p index.
+ */
+static uint16_t *AdcAcq_HalfSamples(uint32_t index)
+{
+    return g_adcAcqConfig.buffer + (index * g_adcAcqConfig.frames_per_block * g_adcAcqConfig.channel_count);
+}
+
+/**
+ * @brief ADC interrupt: an overrun restarts the acquisition.
+ *
+ * @param[in] ctx Unused.
+ */
+static void AdcAcq_AdcIrqHandler(void *ctx)
+{
+    (void)ctx;
+    g_adcAcqStatus.irqs++;
+    if (LL_ADC_IsActiveFlag_OVR(ADCACQ_ADC) == 0U)
+    {
+        return;
+    }
+
+    LL_ADC_ClearFlag_OVR(ADCACQ_ADC);
+    if (g_adcAcqRunning)
+    {
+        g_adcAcqStatus.overruns++;
+        AdcAcq_Restart();
+    }
+}
+
+/**
+ * @brief DMA channel interrupt: completed halves, or an error restarting the acquisition.
+ *
+ * With both HT and TC pending the interrupt came late; the position of
+ * the channel tells which happened first. In the second half, TC ended
+ * the previous lap before HT of this one.
+ *
+ * @param[in] ctx Unused.
+ */
+static void AdcAcq_DmaIrqHandler(void *ctx)
+{
+    (void)ctx;
+    DMA_Channel_TypeDef *regs = AdcAcq_Regs();
+    uint32_t csr = READ_REG(regs->CSR);
+
+    g_adcAcqStatus.irqs++;
+    if (!g_adcAcqRunning)
+    {
+        WRITE_REG(regs->CFCR, csr & (DMA_CSR_TCF | DMA_CSR_HTF | ADCACQ_DMA_ERRORS));
+        return;
+    }
+    if ((csr & ADCACQ_DMA_ERRORS) != 0U)
+    {
+        g_adcAcqStatus.dma_errors++;
+        AdcAcq_Restart();
+        return;
+    }
+
+    WRITE_REG(regs->CFCR, csr & (DMA_CSR_TCF | DMA_CSR_HTF));
+    bool half = (csr & DMA_CSR_HTF) != 0U;
+    bool full = (csr & DMA_CSR_TCF) != 0U;
+    if (half && full && ((READ_REG(regs->CBR1) & DMA_CBR1_BNDT) <= g_adcAcqBlockBytes))
+    {
+        AdcAcq_Complete(1U);
+        AdcAcq_Complete(0U);
+        return;
+    }
+    if (half)
+    {
+        AdcAcq_Complete(0U);
+    }
+    if (full)
+    {
+        AdcAcq_Complete(1U);
+    }
+}
+
+/**
+ * @brief Register block of the channel.
+ */
+static DMA_Channel_TypeDef *AdcAcq_Regs(void)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)g_adcAcqChannel.instance +
+                                   LL_DMA_CH_OFFSET_TAB[g_adcAcqChannel.channel]);
+}
+
+/** @} */ // end of AdcAcq group
@@ -0,0 +1,200 @@
+/**
+ * @file Crc.h
+ * @brief CRC calculation on the CRC unit, fed by the CPU or DMA, with a software fallback
+ *
+ * A CRC is described by its parameters in the usual Rocksoft form (width,
+ * polynomial, initial value, input and output reflection, final XOR) and
+ * computed incrementally through a context: ::Crc_Begin, any number of
+ * updates, ::Crc_Final. Contexts only hold the running register, so
+ * several of them can be in progress at once and each update may take a
+ * different path:
+ *  - the CRC unit fed by the CPU, for 7, 8, 16 and 32-bit CRCs with an odd
+ *    polynomial, when the unit is free,
+ *  - the CRC unit fed by a DMA channel, for large buffers through
+ *    ::Crc_UpdateAsync,
+ *  - a slice-by-8 software implementation otherwise, for any width from 1
+ *    to 32 bits.
+ *
+ * Every path gives bit-identical results. The software tables are built
+ * on first use of a parameter set and kept in ::CRC_SW_TABLE_SLOTS slots;
+ * when every slot is taken by another parameter set the update falls
+ * back to a bytewise calculation.
+ */
+
+#ifndef CRC_H
+#define CRC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef CRC_SW_TABLE_SLOTS
+#define CRC_SW_TABLE_SLOTS (2U) /**< Slice-by-8 tables kept, 8 KiB each */
+#endif
+
+#ifndef CRC_DMA_THRESHOLD
+#define CRC_DMA_THRESHOLD (1024U) /**< Smallest update ::Crc_UpdateAsync sends to DMA */
+#endif
+
+#define CRC_DMA_MAX_BLOCK (0xFFFCU) /**< Largest DMA block, word multiple below the 16-bit BNDT */
+
+/** CRC-32 (ISO-HDLC), as used by Ethernet, zlib and PNG. */
+#define CRC_MODEL_CRC32 {32U, 0x04C11DB7U, 0xFFFFFFFFU, true, true, 0xFFFFFFFFU}
+/** CRC-32C (Castagnoli), as used by iSCSI and ext4. */
+#define CRC_MODEL_CRC32C {32U, 0x1EDC6F41U, 0xFFFFFFFFU, true, true, 0xFFFFFFFFU}
+/** CRC-16/CCITT-FALSE. */
+#define CRC_MODEL_CRC16_CCITT {16U, 0x1021U, 0xFFFFU, false, false, 0x0000U}
+/** CRC-8 (SMBus). */
+#define CRC_MODEL_CRC8 {8U, 0x07U, 0x00U, false, false, 0x00U}
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Parameters of a CRC.
+ */
+typedef struct
+{
+    uint8_t width;     /**< Bits, 1 to 32 */
+    uint32_t poly;     /**< Polynomial without its top bit, MSB first */
+    uint32_t init;     /**< Initial register value */
+    bool reflect_in;   /**< Bytes enter LSB first */
+    bool reflect_out;  /**< Register reflected before the final XOR */
+    uint32_t xor_out;  /**< Value XORed into the result */
+} Crc_Model_T;
+
+/**
+ * @brief Calculation in progress.
+ */
+typedef struct
+{
+    Crc_Model_T model; /**< Parameters */
+    uint32_t reg;      /**< Register, MSB-first form */
+} Crc_Ctx_T;
+
+/**
+ * @brief Completion callback of ::Crc_UpdateAsync.
+ *
+ * Runs from the DMA interrupt, or from the caller before
+ * ::Crc_UpdateAsync returns when the update was done by the CPU.
+ *
+ * @param[in] ctx     Context pointer given at submission.
+ * @param[in] success false if the DMA reported a transfer error, the
+ *                    calculation is then unchanged.
+ */
+typedef void (*Crc_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief Counters of the service.
+ */
+typedef struct
+{
+    uint64_t hw_bytes;    /**< Bytes fed to the CRC unit by the CPU */
+    uint64_t dma_bytes;   /**< Bytes fed to the CRC unit by DMA */
+    uint64_t sw_bytes;    /**< Bytes processed in software */
+    uint32_t hw_busy;     /**< Updates moved to software, unit in use */
+    uint32_t table_builds; /**< Slice-by-8 tables built */
+    uint32_t dma_errors;  /**< DMA updates that ended with a transfer error */
+} Crc_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable the CRC unit and take its DMA channel.
+ *
+ * Must run once after ::DmaAlloc_Init.
+ *
+ * @return true on success, false if no DMA channel was available.
+ */
+bool Crc_Init(void);
+
+/**
+ * @brief Start a calculation.
+ *
+ * @param[out] ctx   Context to initialise.
+ * @param[in]  model Parameters, copied into @p ctx.
+ *
+ * @return true on success, false for invalid parameters.
+ */
+bool Crc_Begin(Crc_Ctx_T *ctx, const Crc_Model_T *model);
+
+/**
+ * @brief Add @p size bytes to a calculation.
+ *
+ * Uses the CRC unit when it supports the parameters and is free, the
+ * software implementation otherwise.
+ *
+ * @param[in,out] ctx  Calculation.
+ * @param[in]     data Bytes to add.
+ * @param[in]     size Number of bytes.
+ */
+void Crc_Update(Crc_Ctx_T *ctx, const void *data, uint32_t size);
+
+/**
+ * @brief Add @p size bytes to a calculation in software only.
+ *
+ * Reentrant, safe from any context.
+ *
+ * @param[in,out] ctx  Calculation.
+ * @param[in]     data Bytes to add.
+ * @param[in]     size Number of bytes.
+ */
+void Crc_UpdateSw(Crc_Ctx_T *ctx, const void *data, uint32_t size);
+
+/**
+ * @brief Add @p size bytes to a calculation with the CRC unit fed by DMA.
+ *
+ * Updates below ::CRC_DMA_THRESHOLD, parameters the unit cannot compute or
+ * a busy unit are served by ::Crc_Update before the call returns. The
+ * context and the data must stay valid until @p cb runs.
+ *
+ * @param[in,out] ctx   Calculation.
+ * @param[in]     data  Bytes to add.
+ * @param[in]     size  Number of bytes.
+ * @param[in]     cb    Completion callback, may be NULL.
+ * @param[in]     cbCtx Passed unchanged to @p cb.
+ *
+ * @retval true  Update done or started, @p cb will run exactly once.
+ * @retval false Invalid parameters.
+ */
+bool Crc_UpdateAsync(Crc_Ctx_T *ctx, const void *data, uint32_t size, Crc_Callback_T cb, void *cbCtx);
+
+/**
+ * @brief Result of a calculation.
+ *
+ * The context stays valid, more data may be added afterwards.
+ *
+ * @param[in] ctx Calculation.
+ *
+ * @return CRC value in the low @ref Crc_Model_T::width bits.
+ */
+uint32_t Crc_Final(const Crc_Ctx_T *ctx);
+
+/**
+ * @brief One-shot calculation with ::Crc_Update.
+ *
+ * @param[in] model Parameters.
+ * @param[in] data  Bytes.
+ * @param[in] size  Number of bytes.
+ *
+ * @return CRC value, 0 for invalid parameters.
+ */
+uint32_t Crc_Compute(const Crc_Model_T *model, const void *data, uint32_t size);
+
+/**
+ * @brief Check whether the CRC unit can compute a parameter set.
+ *
+ * @param[in] model Parameters.
+ *
+ * @return true for 7, 8, 16 and 32-bit CRCs with an odd polynomial.
+ */
+bool Crc_IsHwCapable(const Crc_Model_T *model);
+
+/**
+ * @brief Copy the service counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void Crc_GetStatus(Crc_Status_T *status);
+
+#endif /* CRC_H */
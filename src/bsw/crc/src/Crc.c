@@ -0,0 +1,724 @@
+/**
+ * @file Crc.c
+ * @brief Implementation of the CRC service.
+ * @ingroup Crc
+ * @{
+ *
+ * Contexts keep the register in its MSB-first form, the form the CRC unit
+ * holds in DR when REV_OUT is off. The unit is loaded with it through INIT
+ * and a reset, so an update can resume any calculation, and read back
+ * from DR when the update ends. Input reflection is done by the unit:
+ * bytes are written with a bit reversal by byte, words with a bit
+ * reversal by word for reflected CRCs and a byte reversal by word for
+ * the others, so a little-endian word enters in memory order.
+ *
+ * The software path runs the reflected form of the register for reflected
+ * inputs and the MSB-first form left aligned on 32 bits otherwise, eight
+ * bytes per step through eight 256-entry tables.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Crc.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_crc.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define CRC_SLICES (8U)        /**< Bytes per software step */
+#define CRC_BURST_BEATS (4U)   /**< Word beats per DMA read burst */
+#define CRC_CR_BYTES_REFLECTED (LL_CRC_INDATA_REVERSE_BIT_BYBYTE) /**< Byte writes, reflected input */
+#define CRC_CR_WORDS_REFLECTED (LL_CRC_INDATA_REVERSE_BIT_BYWORD) /**< Word writes, reflected input */
+#define CRC_CR_BYTES_PLAIN (LL_CRC_INDATA_REVERSE_NONE)           /**< Byte writes, MSB-first input */
+#define CRC_CR_WORDS_PLAIN (LL_CRC_INDATA_REVERSE_BYTE_BYWORD)    /**< Word writes, MSB-first input */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Slice-by-8 tables of one parameter set.
+ */
+typedef struct
+{
+    uint8_t width;                       /**< Key: bits */
+    uint32_t poly;                       /**< Key: polynomial */
+    bool reflect_in;                     /**< Key: table direction */
+    bool ready;                          /**< Tables built */
+    uint32_t users;                      /**< Updates using the tables, or building them */
+    uint32_t table[CRC_SLICES][256];     /**< table[k][b]: byte b followed by k zero bytes */
+} Crc_Table_T;
+
+/**
+ * @brief DMA update in progress.
+ */
+typedef struct
+{
+    Crc_Ctx_T *ctx;        /**< Calculation updated */
+    const uint8_t *next;   /**< Next word-aligned byte for the DMA */
+    uint32_t remaining;    /**< Word-multiple bytes left for the DMA */
+    const uint8_t *tail;   /**< Bytes after the last word */
+    uint32_t tail_size;    /**< Bytes in @ref tail */
+    uint32_t bytes;        /**< Bytes of the update */
+    Crc_Callback_T cb;     /**< Completion callback */
+    void *cb_ctx;          /**< Passed unchanged to @ref cb */
+} Crc_DmaJob_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Software tables, built on demand. */
+static Crc_Table_T g_crcTables[CRC_SW_TABLE_SLOTS];
+/** The CRC unit is loaded with a calculation. */
+static bool g_crcHwBusy = false;
+/** Channel feeding the CRC unit. */
+static DmaAlloc_Channel_T g_crcChannel = {0};
+/** ::g_crcChannel was granted. */
+static bool g_crcDmaReady = false;
+/** Update running on the channel. */
+static Crc_DmaJob_T g_crcJob;
+/** Counters reported by ::Crc_GetStatus. */
+static Crc_Status_T g_crcStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Claim the CRC unit, false if in use. */
+static bool Crc_HwClaim(void);
+/** Release the CRC unit. */
+static void Crc_HwRelease(void);
+/** Load a calculation into the CRC unit. */
+static void Crc_HwLoad(const Crc_Ctx_T *ctx);
+/** Feed bytes one at a time to the loaded unit. */
+static void Crc_HwFeedBytes(const Crc_Model_T *model, const uint8_t *data, uint32_t size);
+/** Read the register back from the loaded unit. */
+static uint32_t Crc_HwRead(const Crc_Model_T *model);
+/** Program and start the next DMA block. */
+static void Crc_DmaStartBlock(void);
+/** DMA channel interrupt, bound through the DMA allocator. */
+static void Crc_DmaIrqHandler(void *ctx);
+/** Register block of the channel. */
+static DMA_Channel_TypeDef *Crc_DmaRegs(void);
+/** Take the tables of a parameter set, building them if needed. */
+static Crc_Table_T *Crc_TableAcquire(const Crc_Model_T *model);
+/** Return tables taken with ::Crc_TableAcquire. */
+static void Crc_TableRelease(Crc_Table_T *table);
+/** Fill the tables of a slot. */
+static void Crc_TableBuild(Crc_Table_T *table);
+/** Bitwise update, used without tables. */
+static uint32_t Crc_SwBitwise(const Crc_Model_T *model, uint32_t reg, const uint8_t *data, uint32_t size);
+/** Mask of the low @p width bits. */
+static uint32_t Crc_Mask(uint32_t width);
+/** Reverse the low @p bits bits of @p value. */
+static uint32_t Crc_Reflect(uint32_t value, uint32_t bits);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable the CRC unit and take its DMA channel.
+ *
+ * The channel copies words from memory to DR on software request, in the
+ * bulk class since integrity checks are background work.
+ */
+bool Crc_Init(void)
+{
+    LL_AHB4_GRP1_EnableClock(LL_AHB4_GRP1_PERIPH_CRC);
+
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_ANY,
+        .prio_class = DMAALLOC_CLASS_BULK,
+        .caps = 0U,
+        .burst_bytes = CRC_BURST_BEATS * 4U,
+        .owner = "Crc",
+        .handler = Crc_DmaIrqHandler,
+        .ctx = NULL,
+    };
+    if (!DmaAlloc_Request(&request, &g_crcChannel))
+    {
+        return false;
+    }
+
+    LL_DMA_ConfigControl(g_crcChannel.instance, g_crcChannel.channel, g_crcChannel.priority);
+    LL_DMA_EnableIT_TC(g_crcChannel.instance, g_crcChannel.channel);
+    LL_DMA_EnableIT_DTE(g_crcChannel.instance, g_crcChannel.channel);
+    LL_DMA_EnableIT_USE(g_crcChannel.instance, g_crcChannel.channel);
+    NVIC_SetPriority(g_crcChannel.irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                           configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(g_crcChannel.irq);
+
+    g_crcDmaReady = true;
+    return true;
+}
+
+/**
+ * @brief Start a calculation.
+ */
+bool Crc_Begin(Crc_Ctx_T *ctx, const Crc_Model_T *model)
+{
+    if ((ctx == NULL) || (model == NULL) || (model->width == 0U) || (model->width > 32U))
+    {
+        return false;
+    }
+
+    uint32_t mask = Crc_Mask(model->width);
+    ctx->model = *model;
+    ctx->model.poly &= mask;
+    ctx->model.init &= mask;
+    ctx->model.xor_out &= mask;
+    ctx->reg = ctx->model.init;
+    return true;
+}
+
+/**
+ * @brief Add @p size bytes to a calculation.
+ *
+ * Bytes up to the first word boundary and after the last one are written
+ * one at a time, the rest one word per store.
+ */
+void Crc_Update(Crc_Ctx_T *ctx, const void *data, uint32_t size)
+{
+    if ((ctx == NULL) || (data == NULL) || (size == 0U))
+    {
+        return;
+    }
+
+    if (!Crc_IsHwCapable(&ctx->model) || !Crc_HwClaim())
+    {
+        Crc_UpdateSw(ctx, data, size);
+        return;
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t head = (4U - ((uintptr_t)p & 3U)) & 3U;
+    head = (head < size) ? head : size;
+    uint32_t words = (size - head) / 4U;
+
+    Crc_HwLoad(ctx);
+    Crc_HwFeedBytes(&ctx->model, p, head);
+    p += head;
+    if (words != 0U)
+    {
+        LL_CRC_SetInputDataReverseMode(CRC, ctx->model.reflect_in ? CRC_CR_WORDS_REFLECTED : CRC_CR_WORDS_PLAIN);
+        for (uint32_t i = 0U; i < words; i++)
+        {
+            WRITE_REG(CRC->DR, *(const uint32_t *)p);
+            p += 4U;
+        }
+    }
+    Crc_HwFeedBytes(&ctx->model, p, size - head - (words * 4U));
+    ctx->reg = Crc_HwRead(&ctx->model);
+    Crc_HwRelease();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_crcStatus.hw_bytes += size;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Add @p size bytes to a calculation in software only.
+ */
+void Crc_UpdateSw(Crc_Ctx_T *ctx, const void *data, uint32_t size)
+{
+    if ((ctx == NULL) || (data == NULL) || (size == 0U))
+    {
+        return;
+    }
+
+    const Crc_Model_T *model = &ctx->model;
+    const uint8_t *p = (const uint8_t *)data;
+    Crc_Table_T *tables = Crc_TableAcquire(model);
+
+    if (tables == NULL)
+    {
+        ctx->reg = Crc_SwBitwise(model, ctx->reg, p, size);
+    }
+    else if (model->reflect_in)
+    {
+        const uint32_t(*t)[256] = tables->table;
+        uint32_t crc = Crc_Reflect(ctx->reg, model->width);
+
+        for (; size >= CRC_SLICES; size -= CRC_SLICES, p += CRC_SLICES)
+        {
+            uint32_t one = crc ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+                                  ((uint32_t)p[3] << 24));
+            uint32_t two = (uint32_t)p[4] | ((uint32_t)p[5] << 8) | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+            crc = t[7][one & 0xFFU] ^ t[6][(one >> 8) & 0xFFU] ^ t[5][(one >> 16) & 0xFFU] ^ t[4][one >> 24] ^
+                  t[3][two & 0xFFU] ^ t[2][(two >> 8) & 0xFFU] ^ t[1][(two >> 16) & 0xFFU] ^ t[0][two >> 24];
+        }
+        for (; size != 0U; size--, p++)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xFFU];
+        }
+        ctx->reg = Crc_Reflect(crc, model->width);
+    }
+    else
+    {
+        const uint32_t(*t)[256] = tables->table;
+        uint32_t shift = 32U - model->width;
+        uint32_t crc = ctx->reg << shift;
+
+        for (; size >= CRC_SLICES; size -= CRC_SLICES, p += CRC_SLICES)
+        {
+            uint32_t one = crc ^ (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) |
+                                  (uint32_t)p[3]);
+            uint32_t two = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | (uint32_t)p[7];
+            crc = t[7][one >> 24] ^ t[6][(one >> 16) & 0xFFU] ^ t[5][(one >> 8) & 0xFFU] ^ t[4][one & 0xFFU] ^
+                  t[3][two >> 24] ^ t[2][(two >> 16) & 0xFFU] ^ t[1][(two >> 8) & 0xFFU] ^ t[0][two & 0xFFU];
+        }
+        for (; size != 0U; size--, p++)
+        {
+            crc = (crc << 8) ^ t[0][(crc >> 24) ^ *p];
+        }
+        ctx->reg = crc >> shift;
+    }
+    Crc_TableRelease(tables);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_crcStatus.sw_bytes += (uint32_t)(p - (const uint8_t *)data) + size;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Add @p size bytes to a calculation with the CRC unit fed by DMA.
+ *
+ * The unaligned head is written by the CPU before the channel starts and
+ * the tail from the interrupt after the last block, so the channel only
+ * moves whole words.
+ */
+bool Crc_UpdateAsync(Crc_Ctx_T *ctx, const void *data, uint32_t size, Crc_Callback_T cb, void *cbCtx)
+{
+    if ((ctx == NULL) || ((data == NULL) && (size != 0U)))
+    {
+        return false;
+    }
+
+    if ((size < CRC_DMA_THRESHOLD) || !g_crcDmaReady || !Crc_IsHwCapable(&ctx->model) || !Crc_HwClaim())
+    {
+        Crc_Update(ctx, data, size);
+        if (cb != NULL)
+        {
+            cb(cbCtx, true);
+        }
+        return true;
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t head = (4U - ((uintptr_t)p & 3U)) & 3U;
+    uint32_t body = (size - head) & ~3U;
+
+    g_crcJob.ctx = ctx;
+    g_crcJob.next = p + head;
+    g_crcJob.remaining = body;
+    g_crcJob.tail = p + head + body;
+    g_crcJob.tail_size = size - head - body;
+    g_crcJob.bytes = size;
+    g_crcJob.cb = cb;
+    g_crcJob.cb_ctx = cbCtx;
+
+    if (!DmaPool_IsNonCacheable(g_crcJob.next, body))
+    {
+        SCB_CleanDCache_by_Addr((void *)g_crcJob.next, (int32_t)body);
+    }
+
+    Crc_HwLoad(ctx);
+    Crc_HwFeedBytes(&ctx->model, p, head);
+    LL_CRC_SetInputDataReverseMode(CRC, ctx->model.reflect_in ? CRC_CR_WORDS_REFLECTED : CRC_CR_WORDS_PLAIN);
+    Crc_DmaStartBlock();
+    return true;
+}
+
+/**
+ * @brief Result of a calculation.
+ */
+uint32_t Crc_Final(const Crc_Ctx_T *ctx)
+{
+    if (ctx == NULL)
+    {
+        return 0U;
+    }
+
+    uint32_t reg = ctx->model.reflect_out ? Crc_Reflect(ctx->reg, ctx->model.width) : ctx->reg;
+    return (reg ^ ctx->model.xor_out) & Crc_Mask(ctx->model.width);
+}
+
+/**
+ * @brief One-shot calculation with ::Crc_Update.
+ */
+uint32_t Crc_Compute(const Crc_Model_T *model, const void *data, uint32_t size)
+{
+    Crc_Ctx_T ctx;
+
+    if (!Crc_Begin(&ctx, model))
+    {
+        return 0U;
+    }
+    Crc_Update(&ctx, data, size);
+    return Crc_Final(&ctx);
+}
+
+/**
+ * @brief Check whether the CRC unit can compute a parameter set.
+ */
+bool Crc_IsHwCapable(const Crc_Model_T *model)
+{
+    return (model != NULL) &&
+           ((model->width == 7U) || (model->width == 8U) || (model->width == 16U) || (model->width == 32U)) &&
+           ((model->poly & 1U) != 0U);
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void Crc_GetStatus(Crc_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_crcStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Claim the CRC unit.
+ *
+ * @return true if the caller now owns the unit.
+ */
+static bool Crc_HwClaim(void)
+{
+    bool claimed = false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!g_crcHwBusy)
+    {
+        g_crcHwBusy = true;
+        claimed = true;
+    }
+    else
+    {
+        g_crcStatus.hw_busy++;
+    }
+    __set_PRIMASK(primask);
+
+    return claimed;
+}
+
+/**
+ * @brief Release the CRC unit.
+ */
+static void Crc_HwRelease(void)
+{
+    __DMB();
+    g_crcHwBusy = false;
+}
+
+/**
+ * @brief Load a calculation into the CRC unit, set up for byte writes.
+ */
+static void Crc_HwLoad(const Crc_Ctx_T *ctx)
+{
+    static const uint32_t polySize[33] = {
+        [7] = LL_CRC_POLYLENGTH_7B,
+        [8] = LL_CRC_POLYLENGTH_8B,
+        [16] = LL_CRC_POLYLENGTH_16B,
+        [32] = LL_CRC_POLYLENGTH_32B,
+    };
+    uint32_t cr = polySize[ctx->model.width] |
+                  (ctx->model.reflect_in ? CRC_CR_BYTES_REFLECTED : CRC_CR_BYTES_PLAIN);
+
+    WRITE_REG(CRC->POL, ctx->model.poly);
+    WRITE_REG(CRC->INIT, ctx->reg);
+    WRITE_REG(CRC->CR, cr | CRC_CR_RESET);
+}
+
+/**
+ * @brief Feed bytes one at a time to the loaded unit.
+ */
+static void Crc_HwFeedBytes(const Crc_Model_T *model, const uint8_t *data, uint32_t size)
+{
+    if (size == 0U)
+    {
+        return;
+    }
+
+    LL_CRC_SetInputDataReverseMode(CRC, model->reflect_in ? CRC_CR_BYTES_REFLECTED : CRC_CR_BYTES_PLAIN);
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        WRITE_REG(*(__IO uint8_t *)&CRC->DR, data[i]);
+    }
+}
+
+/**
+ * @brief Read the register back from the loaded unit.
+ */
+static uint32_t Crc_HwRead(const Crc_Model_T *model)
+{
+    return READ_REG(CRC->DR) & Crc_Mask(model->width);
+}
+
+/**
+ * @brief Program and start the next block of the DMA update.
+ *
+ * Memory-to-memory on software request: word reads in bursts from the
+ * buffer, single word writes to the fixed data register.
+ */
+static void Crc_DmaStartBlock(void)
+{
+    DMA_Channel_TypeDef *regs = Crc_DmaRegs();
+    uint32_t block = (g_crcJob.remaining < CRC_DMA_MAX_BLOCK) ? g_crcJob.remaining : CRC_DMA_MAX_BLOCK;
+
+    WRITE_REG(regs->CTR1, LL_DMA_SRC_INCREMENT | LL_DMA_SRC_DATAWIDTH_WORD | LL_DMA_DEST_DATAWIDTH_WORD |
+                              ((CRC_BURST_BEATS - 1U) << DMA_CTR1_SBL_1_Pos));
+    WRITE_REG(regs->CTR2, LL_DMA_DIRECTION_MEMORY_TO_MEMORY);
+    WRITE_REG(regs->CBR1, block);
+    WRITE_REG(regs->CSAR, (uint32_t)(uintptr_t)g_crcJob.next);
+    WRITE_REG(regs->CDAR, (uint32_t)(uintptr_t)&CRC->DR);
+    WRITE_REG(regs->CLLR, 0U);
+
+    g_crcJob.next += block;
+    g_crcJob.remaining -= block;
+
+    DmaAlloc_NoteStart(&g_crcChannel, block);
+    __DMB();
+    LL_DMA_EnableChannel(g_crcChannel.instance, g_crcChannel.channel);
+}
+
+/**
+ * @brief DMA channel interrupt.
+ *
+ * Starts the next block, or finishes the update: tail bytes, register
+ * read back, unit released, then the callback.
+ *
+ * @param[in] ctx Unused.
+ */
+static void Crc_DmaIrqHandler(void *ctx)
+{
+    (void)ctx;
+    DMA_TypeDef *dma = g_crcChannel.instance;
+    uint32_t ch = g_crcChannel.channel;
+    bool success;
+
+    if (LL_DMA_IsActiveFlag_TC(dma, ch) != 0U)
+    {
+        LL_DMA_ClearFlag_TC(dma, ch);
+        LL_DMA_ClearFlag_HT(dma, ch);
+        if (g_crcJob.remaining != 0U)
+        {
+            Crc_DmaStartBlock();
+            return;
+        }
+        success = true;
+    }
+    else if ((LL_DMA_IsActiveFlag_DTE(dma, ch) != 0U) || (LL_DMA_IsActiveFlag_USE(dma, ch) != 0U))
+    {
+        LL_DMA_ClearFlag_DTE(dma, ch);
+        LL_DMA_ClearFlag_USE(dma, ch);
+        LL_DMA_ClearFlag_HT(dma, ch);
+        LL_DMA_ResetChannel(dma, ch);
+        success = false;
+    }
+    else
+    {
+        return;
+    }
+
+    Crc_Ctx_T *job = g_crcJob.ctx;
+    if (success)
+    {
+        Crc_HwFeedBytes(&job->model, g_crcJob.tail, g_crcJob.tail_size);
+        job->reg = Crc_HwRead(&job->model);
+        g_crcStatus.dma_bytes += g_crcJob.bytes;
+    }
+    else
+    {
+        g_crcStatus.dma_errors++;
+    }
+    Crc_HwRelease();
+
+    if (g_crcJob.cb != NULL)
+    {
+        g_crcJob.cb(g_crcJob.cb_ctx, success);
+    }
+}
+
+/**
+ * @brief Register block of the channel.
+ */
+static DMA_Channel_TypeDef *Crc_DmaRegs(void)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)g_crcChannel.instance +
+                                   LL_DMA_CH_OFFSET_TAB[g_crcChannel.channel]);
+}
+
+/**
+ * @brief Take the tables of a parameter set.
+ *
+ * A free slot is claimed with interrupts masked and filled after, the
+ * user count keeping it from being reclaimed meanwhile.
+ *
+ * @return Tables, NULL if none are available and the update must go bitwise.
+ */
+static Crc_Table_T *Crc_TableAcquire(const Crc_Model_T *model)
+{
+    Crc_Table_T *found = NULL;
+    Crc_Table_T *spare = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0U; i < CRC_SW_TABLE_SLOTS; i++)
+    {
+        Crc_Table_T *t = &g_crcTables[i];
+        if ((t->width == model->width) && (t->poly == model->poly) && (t->reflect_in == model->reflect_in))
+        {
+            found = t;
+            break;
+        }
+        if ((t->users == 0U) && ((spare == NULL) || !t->ready))
+        {
+            spare = t;
+        }
+    }
+
+    bool build = false;
+    if (found != NULL)
+    {
+        /* Still being built by another caller */
+        found = found->ready ? found : NULL;
+    }
+    else if (spare != NULL)
+    {
+        found = spare;
+        found->width = model->width;
+        found->poly = model->poly;
+        found->reflect_in = model->reflect_in;
+        found->ready = false;
+        build = true;
+    }
+    if (found != NULL)
+    {
+        found->users++;
+    }
+    __set_PRIMASK(primask);
+
+    if (build)
+    {
+        Crc_TableBuild(found);
+        __DMB();
+        found->ready = true;
+        g_crcStatus.table_builds++;
+    }
+    return found;
+}
+
+/**
+ * @brief Return tables taken with ::Crc_TableAcquire.
+ */
+static void Crc_TableRelease(Crc_Table_T *table)
+{
+    if (table == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    table->users--;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Fill the tables of a slot.
+ *
+ * table[0] is the classic bytewise table, each further slice is the
+ * previous one advanced over one more zero byte.
+ */
+static void Crc_TableBuild(Crc_Table_T *table)
+{
+    uint32_t (*t)[256] = table->table;
+
+    if (table->reflect_in)
+    {
+        uint32_t poly = Crc_Reflect(table->poly, table->width);
+        for (uint32_t b = 0U; b < 256U; b++)
+        {
+            uint32_t c = b;
+            for (uint32_t k = 0U; k < 8U; k++)
+            {
+                c = ((c & 1U) != 0U) ? ((c >> 1) ^ poly) : (c >> 1);
+            }
+            t[0][b] = c;
+        }
+        for (uint32_t s = 1U; s < CRC_SLICES; s++)
+        {
+            for (uint32_t b = 0U; b < 256U; b++)
+            {
+                t[s][b] = (t[s - 1U][b] >> 8) ^ t[0][t[s - 1U][b] & 0xFFU];
+            }
+        }
+    }
+    else
+    {
+        uint32_t poly = table->poly << (32U - table->width);
+        for (uint32_t b = 0U; b < 256U; b++)
+        {
+            uint32_t c = b << 24;
+            for (uint32_t k = 0U; k < 8U; k++)
+            {
+                c = ((c & 0x80000000U) != 0U) ? ((c << 1) ^ poly) : (c << 1);
+            }
+            t[0][b] = c;
+        }
+        for (uint32_t s = 1U; s < CRC_SLICES; s++)
+        {
+            for (uint32_t b = 0U; b < 256U; b++)
+            {
+                t[s][b] = (t[s - 1U][b] << 8) ^ t[0][t[s - 1U][b] >> 24];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Bitwise update of an MSB-first register.
+ *
+ * @return Updated register.
+ */
+static uint32_t Crc_SwBitwise(const Crc_Model_T *model, uint32_t reg, const uint8_t *data, uint32_t size)
+{
+    uint32_t top = 1UL << (model->width - 1U);
+    uint32_t mask = Crc_Mask(model->width);
+
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        uint32_t byte = model->reflect_in ? Crc_Reflect(data[i], 8U) : data[i];
+        for (uint32_t k = 8U; k > 0U; k--)
+        {
+            bool feedback = (((reg & top) != 0U) != (((byte >> (k - 1U)) & 1U) != 0U));
+            reg = (reg << 1) & mask;
+            reg ^= feedback ? model->poly : 0U;
+        }
+    }
+    return reg;
+}
+
+/**
+ * @brief Mask of the low @p width bits.
+ */
+static uint32_t Crc_Mask(uint32_t width)
+{
+    return (width >= 32U) ? 0xFFFFFFFFU : ((1UL << width) - 1U);
+}
+
+/**
+ * @brief Reverse the low @p bits bits of @p value.
+ */
+static uint32_t Crc_Reflect(uint32_t value, uint32_t bits)
+{
+    return __RBIT(value) >> (32U - bits);
+}
+
+/** @} */ // end of Crc group
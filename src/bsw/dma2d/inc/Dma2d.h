@@ -0,0 +1,217 @@
+/**
+ * @file Dma2d.h
+ * @brief DMA2D job queue for pixel-format conversion, blending, 2D blits and fills
+ *
+ * Jobs describe rectangular areas inside larger images: each area is given
+ * by the address of its first pixel and the pitch of the image it lives
+ * in, so cropping an input or padding into a model input tensor is a
+ * matter of choosing the addresses. Jobs are queued and run back to back
+ * by the DMA2D, the completion callback of each one runs from the DMA2D
+ * interrupt.
+ *
+ * Cache maintenance is done by the service: input areas are cleaned and
+ * output areas cleaned and invalidated before the job, output areas are
+ * invalidated again on completion, except for buffers in the non-cacheable
+ * DMA pool.
+ *
+ * ::Dma2d_RunReference executes any job on the CPU with the pixel rules
+ * below, so results can be checked bit for bit and throughput compared:
+ *  - inputs are expanded to 8 bits per channel by bit replication, formats
+ *    without alpha read as opaque, 1-bit alpha as 0 or 255,
+ *  - the alpha of an input is kept, replaced by or multiplied with the
+ *    constant of the job, products being divided by 255 with truncation,
+ *  - blending computes aM = aFG * aBG / 255, aOUT = aFG + aBG - aM and
+ *    C = (C_FG * aFG + C_BG * aBG - C_BG * aM) / aOUT, all truncated,
+ *  - outputs keep the most significant bits of each channel.
+ */
+
+#ifndef DMA2D_H
+#define DMA2D_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef DMA2D_QUEUE_LEN
+#define DMA2D_QUEUE_LEN (8U) /**< Jobs waiting behind the running one */
+#endif
+
+#define DMA2D_MAX_WIDTH (0x3FFFU)  /**< Pixels per line, NLR.PL */
+#define DMA2D_MAX_HEIGHT (0xFFFFU) /**< Lines, NLR.NL */
+#define DMA2D_MAX_GAP (0xFFFFU)    /**< Pitch minus width, in pixels */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Pixel formats, encoded as the DMA2D colour mode.
+ *
+ * Multi-byte pixels are stored little endian: ARGB8888 is the word
+ * 0xAARRGGBB, RGB888 the bytes B, G, R.
+ */
+typedef enum
+{
+    DMA2D_FMT_ARGB8888 = 0, /**< 32 bpp with alpha */
+    DMA2D_FMT_RGB888 = 1,   /**< 24 bpp */
+    DMA2D_FMT_RGB565 = 2,   /**< 16 bpp */
+    DMA2D_FMT_ARGB1555 = 3, /**< 16 bpp with 1-bit alpha */
+    DMA2D_FMT_ARGB4444 = 4, /**< 16 bpp with 4-bit alpha */
+} Dma2d_Format_T;
+
+/**
+ * @brief Operation of a job.
+ */
+typedef enum
+{
+    DMA2D_OP_COPY = 0, /**< Strided copy, input and output share their format */
+    DMA2D_OP_CONVERT,  /**< Copy with pixel-format conversion and alpha handling */
+    DMA2D_OP_BLEND,    /**< Foreground blended over background into the output */
+    DMA2D_OP_FILL,     /**< Output area filled with a constant colour */
+} Dma2d_Op_T;
+
+/**
+ * @brief Alpha applied to an input.
+ */
+typedef enum
+{
+    DMA2D_ALPHA_KEEP = 0,     /**< Alpha of the pixel */
+    DMA2D_ALPHA_REPLACE = 1,  /**< Constant alpha of the input */
+    DMA2D_ALPHA_MULTIPLY = 2, /**< Alpha of the pixel times the constant */
+} Dma2d_AlphaMode_T;
+
+/**
+ * @brief Input area of a job.
+ */
+typedef struct
+{
+    const void *addr;             /**< First pixel of the area */
+    uint32_t pitch;               /**< Pixels from one line start to the next */
+    Dma2d_Format_T format;        /**< Pixel format */
+    Dma2d_AlphaMode_T alpha_mode; /**< Alpha handling */
+    uint8_t alpha;                /**< Constant used by @ref alpha_mode */
+    bool rb_swap;                 /**< Pixels store blue where the format has red */
+} Dma2d_Input_T;
+
+/**
+ * @brief Output area of a job.
+ */
+typedef struct
+{
+    void *addr;            /**< First pixel of the area */
+    uint32_t pitch;        /**< Pixels from one line start to the next */
+    Dma2d_Format_T format; /**< Pixel format */
+    bool rb_swap;          /**< Store blue where the format has red, e.g. R, G, B tensors from RGB888 */
+} Dma2d_Output_T;
+
+/**
+ * @brief Completion callback.
+ *
+ * Runs from the DMA2D interrupt.
+ *
+ * @param[in] ctx     Context pointer of the job.
+ * @param[in] success false on a transfer or configuration error.
+ */
+typedef void (*Dma2d_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief One DMA2D job.
+ */
+typedef struct
+{
+    Dma2d_Op_T op;       /**< Operation */
+    uint32_t width;      /**< Pixels per line */
+    uint32_t height;     /**< Lines */
+    Dma2d_Input_T fg;    /**< Source of a copy or conversion, foreground of a blend */
+    Dma2d_Input_T bg;    /**< Background of a blend */
+    Dma2d_Output_T out;  /**< Destination */
+    uint32_t color;      /**< Fill colour as ARGB8888 */
+    Dma2d_Callback_T cb; /**< Completion callback, may be NULL */
+    void *ctx;           /**< Passed unchanged to @ref cb */
+} Dma2d_Job_T;
+
+/**
+ * @brief Counters of the service.
+ */
+typedef struct
+{
+    uint32_t jobs_done;   /**< Jobs completed */
+    uint32_t jobs_failed; /**< Jobs ended by a transfer or configuration error */
+    uint32_t queue_full;  /**< Submissions rejected, queue full */
+    uint32_t queue_peak;  /**< Most jobs waiting at once */
+    uint64_t pixels;      /**< Output pixels written */
+    uint64_t busy_cycles; /**< CPU cycles the DMA2D was running */
+} Dma2d_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable the DMA2D and bind its interrupt.
+ *
+ * Must run once after ::IsrMgr_Init.
+ *
+ * @return true on success, false if the interrupt could not be bound.
+ */
+bool Dma2d_Init(void);
+
+/**
+ * @brief Queue a job.
+ *
+ * The job is copied, its buffers must stay valid until its callback runs.
+ *
+ * @param[in] job Job description.
+ *
+ * @retval true  Job queued, its callback will run exactly once.
+ * @retval false Invalid job or queue full.
+ */
+bool Dma2d_Submit(const Dma2d_Job_T *job);
+
+/**
+ * @brief Execute a job on the CPU.
+ *
+ * Produces the same pixels as the DMA2D. The callback of the job is not
+ * called.
+ *
+ * @param[in] job Job description.
+ *
+ * @return true on success, false for an invalid job.
+ */
+bool Dma2d_RunReference(const Dma2d_Job_T *job);
+
+/**
+ * @brief Check that a job can run on the DMA2D.
+ *
+ * @param[in] job Job description.
+ *
+ * @return true if sizes, pitches, formats and alignments are supported.
+ */
+bool Dma2d_IsValid(const Dma2d_Job_T *job);
+
+/**
+ * @brief Bytes per pixel of a format.
+ *
+ * @param[in] format Pixel format.
+ *
+ * @return 2, 3 or 4, 0 for an unknown format.
+ */
+uint32_t Dma2d_BytesPerPixel(Dma2d_Format_T format);
+
+/**
+ * @brief Encode an ARGB8888 colour as a pixel of @p format.
+ *
+ * Channels keep their most significant bits.
+ *
+ * @param[in] format Pixel format.
+ * @param[in] argb   Colour as 0xAARRGGBB.
+ *
+ * @return Pixel value in the low bits.
+ */
+uint32_t Dma2d_EncodeColor(Dma2d_Format_T format, uint32_t argb);
+
+/**
+ * @brief Copy the service counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void Dma2d_GetStatus(Dma2d_Status_T *status);
+
+#endif /* DMA2D_H */
@@ -0,0 +1,346 @@
+/**
+ * @file Dma2d.c
+ * @brief Implementation of the DMA2D job queue.
+ * @ingroup Dma2d
+ * @{
+ *
+ * Jobs wait in a ring behind the running one. Each job is written to the
+ * DMA2D with one store per register, line offsets in pixels, and started;
+ * the completion interrupt reports it and starts the next one, so back to
+ * back jobs keep the DMA2D busy without a task in the loop.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Dma2d.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_dma2d.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define DMA2D_IT_ENABLE (DMA2D_CR_TCIE | DMA2D_CR_TEIE | DMA2D_CR_CEIE) /**< Interrupts used */
+#define DMA2D_IT_ERRORS (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)               /**< Flags ending a job in error */
+#define DMA2D_IT_FLAGS (DMA2D_ISR_TCIF | DMA2D_IT_ERRORS)               /**< Flags handled */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** Jobs waiting to run. */
+static Dma2d_Job_T g_dma2dQueue[DMA2D_QUEUE_LEN];
+/** Index of the oldest waiting job. */
+static uint32_t g_dma2dHead = 0U;
+/** Waiting jobs. */
+static uint32_t g_dma2dCount = 0U;
+/** Job on the DMA2D. */
+static Dma2d_Job_T g_dma2dCurrent;
+/** A job is on the DMA2D. */
+static volatile bool g_dma2dRunning = false;
+/** CYCCNT when the current job started. */
+static uint32_t g_dma2dStartCycles = 0U;
+/** Counters reported by ::Dma2d_GetStatus. */
+static Dma2d_Status_T g_dma2dStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Program the DMA2D for a job and start it. */
+static void Dma2d_Start(const Dma2d_Job_T *job);
+/** DMA2D interrupt, bound through the ISR manager. */
+static void Dma2d_IrqHandler(void *ctx);
+/** Check an input area. */
+static bool Dma2d_IsValidInput(const Dma2d_Input_T *in, uint32_t width);
+/** Check an area of an image. */
+static bool Dma2d_IsValidArea(const void *addr, uint32_t pitch, Dma2d_Format_T format, uint32_t width);
+/** Bytes spanned by an area, from its first to its last pixel. */
+static uint32_t Dma2d_AreaBytes(uint32_t pitch, Dma2d_Format_T format, uint32_t width, uint32_t height);
+/** PFC control word of an input. */
+static uint32_t Dma2d_InputPfc(const Dma2d_Input_T *in);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable the DMA2D and bind its interrupt.
+ */
+bool Dma2d_Init(void)
+{
+    LL_AHB5_GRP1_EnableClock(LL_AHB5_GRP1_PERIPH_DMA2D);
+
+    if (!IsrMgr_Register(DMA2D_IRQn, Dma2d_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    NVIC_SetPriority(DMA2D_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                     configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(DMA2D_IRQn);
+    return true;
+}
+
+/**
+ * @brief Queue a job.
+ *
+ * Cache maintenance runs in the caller, before the job is visible to the
+ * interrupt, so the interrupt only has to program registers.
+ */
+bool Dma2d_Submit(const Dma2d_Job_T *job)
+{
+    if ((job == NULL) || !Dma2d_IsValid(job))
+    {
+        return false;
+    }
+
+    if (job->op != DMA2D_OP_FILL)
+    {
+        uint32_t bytes = Dma2d_AreaBytes(job->fg.pitch, job->fg.format, job->width, job->height);
+        if (!DmaPool_IsNonCacheable(job->fg.addr, bytes))
+        {
+            SCB_CleanDCache_by_Addr((void *)job->fg.addr, (int32_t)bytes);
+        }
+    }
+    if (job->op == DMA2D_OP_BLEND)
+    {
+        uint32_t bytes = Dma2d_AreaBytes(job->bg.pitch, job->bg.format, job->width, job->height);
+        if (!DmaPool_IsNonCacheable(job->bg.addr, bytes))
+        {
+            SCB_CleanDCache_by_Addr((void *)job->bg.addr, (int32_t)bytes);
+        }
+    }
+    uint32_t outBytes = Dma2d_AreaBytes(job->out.pitch, job->out.format, job->width, job->height);
+    if (!DmaPool_IsNonCacheable(job->out.addr, outBytes))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(job->out.addr, (int32_t)outBytes);
+    }
+
+    bool queued = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!g_dma2dRunning)
+    {
+        g_dma2dCurrent = *job;
+        Dma2d_Start(&g_dma2dCurrent);
+    }
+    else if (g_dma2dCount < DMA2D_QUEUE_LEN)
+    {
+        g_dma2dQueue[(g_dma2dHead + g_dma2dCount) % DMA2D_QUEUE_LEN] = *job;
+        g_dma2dCount++;
+        if (g_dma2dCount > g_dma2dStatus.queue_peak)
+        {
+            g_dma2dStatus.queue_peak = g_dma2dCount;
+        }
+    }
+    else
+    {
+        g_dma2dStatus.queue_full++;
+        queued = false;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Check that a job can run on the DMA2D.
+ *
+ * 16 and 32-bit pixels must be aligned to their size.
+ */
+bool Dma2d_IsValid(const Dma2d_Job_T *job)
+{
+    if ((job->op > DMA2D_OP_FILL) || (job->width == 0U) || (job->width > DMA2D_MAX_WIDTH) ||
+        (job->height == 0U) || (job->height > DMA2D_MAX_HEIGHT) ||
+        !Dma2d_IsValidArea(job->out.addr, job->out.pitch, job->out.format, job->width))
+    {
+        return false;
+    }
+
+    switch (job->op)
+    {
+    case DMA2D_OP_COPY:
+        return Dma2d_IsValidInput(&job->fg, job->width) && (job->fg.format == job->out.format);
+    case DMA2D_OP_CONVERT:
+        return Dma2d_IsValidInput(&job->fg, job->width);
+    case DMA2D_OP_BLEND:
+        return Dma2d_IsValidInput(&job->fg, job->width) && Dma2d_IsValidInput(&job->bg, job->width);
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Bytes per pixel of a format.
+ */
+uint32_t Dma2d_BytesPerPixel(Dma2d_Format_T format)
+{
+    switch (format)
+    {
+    case DMA2D_FMT_ARGB8888:
+        return 4U;
+    case DMA2D_FMT_RGB888:
+        return 3U;
+    case DMA2D_FMT_RGB565:
+    case DMA2D_FMT_ARGB1555:
+    case DMA2D_FMT_ARGB4444:
+        return 2U;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void Dma2d_GetStatus(Dma2d_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_dma2dStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Program the DMA2D for a job and start it.
+ *
+ * Fills carry their colour already encoded in the output format, red and
+ * blue swapped by the CPU, so OCOLR never depends on OPFCCR.RBS.
+ */
+static void Dma2d_Start(const Dma2d_Job_T *job)
+{
+    static const uint32_t mode[] = {LL_DMA2D_MODE_M2M, LL_DMA2D_MODE_M2M_PFC, LL_DMA2D_MODE_M2M_BLEND,
+                                    LL_DMA2D_MODE_R2M};
+    uint32_t opfccr = (uint32_t)job->out.format << DMA2D_OPFCCR_CM_Pos;
+
+    if (job->op == DMA2D_OP_FILL)
+    {
+        uint32_t color = job->color;
+        if (job->out.rb_swap)
+        {
+            color = (color & 0xFF00FF00U) | ((color >> 16) & 0xFFU) | ((color & 0xFFU) << 16);
+        }
+        WRITE_REG(DMA2D->OCOLR, Dma2d_EncodeColor(job->out.format, color));
+    }
+    else
+    {
+        opfccr |= job->out.rb_swap ? DMA2D_OPFCCR_RBS : 0U;
+        WRITE_REG(DMA2D->FGMAR, (uint32_t)job->fg.addr);
+        WRITE_REG(DMA2D->FGOR, job->fg.pitch - job->width);
+        WRITE_REG(DMA2D->FGPFCCR, Dma2d_InputPfc(&job->fg));
+    }
+    if (job->op == DMA2D_OP_BLEND)
+    {
+        WRITE_REG(DMA2D->BGMAR, (uint32_t)job->bg.addr);
+        WRITE_REG(DMA2D->BGOR, job->bg.pitch - job->width);
+        WRITE_REG(DMA2D->BGPFCCR, Dma2d_InputPfc(&job->bg));
+    }
+
+    WRITE_REG(DMA2D->OPFCCR, opfccr);
+    WRITE_REG(DMA2D->OMAR, (uint32_t)job->out.addr);
+    WRITE_REG(DMA2D->OOR, job->out.pitch - job->width);
+    WRITE_REG(DMA2D->NLR, (job->width << DMA2D_NLR_PL_Pos) | (job->height << DMA2D_NLR_NL_Pos));
+
+    g_dma2dRunning = true;
+    g_dma2dStartCycles = DWT->CYCCNT;
+    WRITE_REG(DMA2D->CR, mode[job->op] | LL_DMA2D_LINE_OFFSET_PIXELS | DMA2D_IT_ENABLE | DMA2D_CR_START);
+}
+
+/**
+ * @brief DMA2D interrupt.
+ *
+ * Reports the finished job and starts the next one before running the
+ * callback, so the DMA2D is idle only while the queue is empty.
+ *
+ * @param[in] ctx Unused.
+ */
+static void Dma2d_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t isr = READ_REG(DMA2D->ISR) & DMA2D_IT_FLAGS;
+
+    if ((isr == 0U) || !g_dma2dRunning)
+    {
+        WRITE_REG(DMA2D->IFCR, isr);
+        return;
+    }
+    WRITE_REG(DMA2D->IFCR, isr);
+
+    bool success = (isr & DMA2D_IT_ERRORS) == 0U;
+    Dma2d_Job_T done = g_dma2dCurrent;
+    g_dma2dStatus.busy_cycles += DWT->CYCCNT - g_dma2dStartCycles;
+
+    if (success)
+    {
+        uint32_t bytes = Dma2d_AreaBytes(done.out.pitch, done.out.format, done.width, done.height);
+        if (!DmaPool_IsNonCacheable(done.out.addr, bytes))
+        {
+            SCB_InvalidateDCache_by_Addr(done.out.addr, (int32_t)bytes);
+        }
+        g_dma2dStatus.jobs_done++;
+        g_dma2dStatus.pixels += (uint64_t)done.width * done.height;
+    }
+    else
+    {
+        /* A configuration error leaves START set until aborted */
+        LL_DMA2D_Abort(DMA2D);
+        g_dma2dStatus.jobs_failed++;
+    }
+
+    g_dma2dRunning = false;
+    if (g_dma2dCount != 0U)
+    {
+        g_dma2dCurrent = g_dma2dQueue[g_dma2dHead];
+        g_dma2dHead = (g_dma2dHead + 1U) % DMA2D_QUEUE_LEN;
+        g_dma2dCount--;
+        Dma2d_Start(&g_dma2dCurrent);
+    }
+
+    if (done.cb != NULL)
+    {
+        done.cb(done.ctx, success);
+    }
+}
+
+/**
+ * @brief Check an input area.
+ */
+static bool Dma2d_IsValidInput(const Dma2d_Input_T *in, uint32_t width)
+{
+    return (in->alpha_mode <= DMA2D_ALPHA_MULTIPLY) && Dma2d_IsValidArea(in->addr, in->pitch, in->format, width);
+}
+
+/**
+ * @brief Check an area of an image: format, pitch and pixel alignment.
+ */
+static bool Dma2d_IsValidArea(const void *addr, uint32_t pitch, Dma2d_Format_T format, uint32_t width)
+{
+    uint32_t bpp = Dma2d_BytesPerPixel(format);
+
+    if ((addr == NULL) || (bpp == 0U) || (pitch < width) || ((pitch - width) > DMA2D_MAX_GAP))
+    {
+        return false;
+    }
+
+    return (bpp == 3U) || (((uintptr_t)addr % bpp) == 0U);
+}
+
+/**
+ * @brief Bytes spanned by an area, from its first to its last pixel.
+ */
+static uint32_t Dma2d_AreaBytes(uint32_t pitch, Dma2d_Format_T format, uint32_t width, uint32_t height)
+{
+    return (((height - 1U) * pitch) + width) * Dma2d_BytesPerPixel(format);
+}
+
+/**
+ * @brief PFC control word of an input: colour mode, alpha and R/B swap.
+ */
+static uint32_t Dma2d_InputPfc(const Dma2d_Input_T *in)
+{
+    return ((uint32_t)in->format << DMA2D_FGPFCCR_CM_Pos) | ((uint32_t)in->alpha_mode << DMA2D_FGPFCCR_AM_Pos) |
+           ((uint32_t)in->alpha << DMA2D_FGPFCCR_ALPHA_Pos) | (in->rb_swap ? DMA2D_FGPFCCR_RBS : 0U);
+}
+
+/** @} */ // end of Dma2d group
@@ -0,0 +1,221 @@
+/**
+ * @file Dma2d_Ref.c
+ * @brief CPU reference of the DMA2D operations.
+ * @ingroup Dma2d
+ * @{
+ *
+ * Straight per-pixel code following the rules listed in Dma2d.h. It is the
+ * oracle the DMA2D results are compared against and the CPU baseline of
+ * the throughput comparison, so it favours clarity over speed.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Dma2d.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define DMA2D_REF_A(c) (((c) >> 24) & 0xFFU) /**< Alpha of an ARGB8888 colour */
+#define DMA2D_REF_R(c) (((c) >> 16) & 0xFFU) /**< Red of an ARGB8888 colour */
+#define DMA2D_REF_G(c) (((c) >> 8) & 0xFFU)  /**< Green of an ARGB8888 colour */
+#define DMA2D_REF_B(c) ((c) & 0xFFU)         /**< Blue of an ARGB8888 colour */
+#define DMA2D_REF_ARGB(a, r, g, b) (((uint32_t)(a) << 24) | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Read one pixel as ARGB8888. */
+static uint32_t Dma2d_RefLoad(const Dma2d_Input_T *in, const uint8_t *pixel);
+/** Write one ARGB8888 pixel. */
+static void Dma2d_RefStore(const Dma2d_Output_T *out, uint8_t *pixel, uint32_t argb);
+/** Swap the red and blue channels. */
+static uint32_t Dma2d_RefSwapRb(uint32_t argb);
+/** Widen an @p bits wide channel to 8 bits. */
+static uint32_t Dma2d_RefExpand(uint32_t value, uint32_t bits);
+/** Blend a foreground over a background pixel. */
+static uint32_t Dma2d_RefBlend(uint32_t fg, uint32_t bg);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Execute a job on the CPU.
+ */
+bool Dma2d_RunReference(const Dma2d_Job_T *job)
+{
+    if ((job == NULL) || !Dma2d_IsValid(job))
+    {
+        return false;
+    }
+
+    uint32_t outBpp = Dma2d_BytesPerPixel(job->out.format);
+    uint32_t fgBpp = Dma2d_BytesPerPixel(job->fg.format);
+    uint32_t bgBpp = Dma2d_BytesPerPixel(job->bg.format);
+
+    for (uint32_t y = 0U; y < job->height; y++)
+    {
+        uint8_t *out = (uint8_t *)job->out.addr + ((size_t)y * job->out.pitch * outBpp);
+        const uint8_t *fg = (const uint8_t *)job->fg.addr + ((size_t)y * job->fg.pitch * fgBpp);
+        const uint8_t *bg = (const uint8_t *)job->bg.addr + ((size_t)y * job->bg.pitch * bgBpp);
+
+        if (job->op == DMA2D_OP_COPY)
+        {
+            memcpy(out, fg, (size_t)job->width * outBpp);
+            continue;
+        }
+
+        for (uint32_t x = 0U; x < job->width; x++)
+        {
+            uint32_t argb;
+            switch (job->op)
+            {
+            case DMA2D_OP_CONVERT:
+                argb = Dma2d_RefLoad(&job->fg, fg + (x * fgBpp));
+                break;
+            case DMA2D_OP_BLEND:
+                argb = Dma2d_RefBlend(Dma2d_RefLoad(&job->fg, fg + (x * fgBpp)),
+                                      Dma2d_RefLoad(&job->bg, bg + (x * bgBpp)));
+                break;
+            default:
+                argb = job->color;
+                break;
+            }
+            Dma2d_RefStore(&job->out, out + (x * outBpp), argb);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Encode an ARGB8888 colour as a pixel of @p format.
+ */
+uint32_t Dma2d_EncodeColor(Dma2d_Format_T format, uint32_t argb)
+{
+    uint32_t a = DMA2D_REF_A(argb);
+    uint32_t r = DMA2D_REF_R(argb);
+    uint32_t g = DMA2D_REF_G(argb);
+    uint32_t b = DMA2D_REF_B(argb);
+
+    switch (format)
+    {
+    case DMA2D_FMT_ARGB8888:
+        return argb;
+    case DMA2D_FMT_RGB888:
+        return argb & 0x00FFFFFFU;
+    case DMA2D_FMT_RGB565:
+        return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    case DMA2D_FMT_ARGB1555:
+        return ((a >> 7) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+    case DMA2D_FMT_ARGB4444:
+        return ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+    default:
+        return 0U;
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Read one pixel as ARGB8888, then apply R/B swap and alpha mode.
+ */
+static uint32_t Dma2d_RefLoad(const Dma2d_Input_T *in, const uint8_t *pixel)
+{
+    uint32_t argb;
+    uint32_t v;
+
+    switch (in->format)
+    {
+    case DMA2D_FMT_ARGB8888:
+        argb = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8) | ((uint32_t)pixel[2] << 16) | ((uint32_t)pixel[3] << 24);
+        break;
+    case DMA2D_FMT_RGB888:
+        argb = DMA2D_REF_ARGB(0xFFU, pixel[2], pixel[1], pixel[0]);
+        break;
+    case DMA2D_FMT_RGB565:
+        v = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8);
+        argb = DMA2D_REF_ARGB(0xFFU, Dma2d_RefExpand(v >> 11, 5U), Dma2d_RefExpand((v >> 5) & 0x3FU, 6U),
+                              Dma2d_RefExpand(v & 0x1FU, 5U));
+        break;
+    case DMA2D_FMT_ARGB1555:
+        v = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8);
+        argb = DMA2D_REF_ARGB(((v >> 15) != 0U) ? 0xFFU : 0U, Dma2d_RefExpand((v >> 10) & 0x1FU, 5U),
+                              Dma2d_RefExpand((v >> 5) & 0x1FU, 5U), Dma2d_RefExpand(v & 0x1FU, 5U));
+        break;
+    default:
+        v = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8);
+        argb = DMA2D_REF_ARGB(Dma2d_RefExpand(v >> 12, 4U), Dma2d_RefExpand((v >> 8) & 0xFU, 4U),
+                              Dma2d_RefExpand((v >> 4) & 0xFU, 4U), Dma2d_RefExpand(v & 0xFU, 4U));
+        break;
+    }
+
+    if (in->rb_swap)
+    {
+        argb = Dma2d_RefSwapRb(argb);
+    }
+
+    uint32_t a = DMA2D_REF_A(argb);
+    if (in->alpha_mode == DMA2D_ALPHA_REPLACE)
+    {
+        a = in->alpha;
+    }
+    else if (in->alpha_mode == DMA2D_ALPHA_MULTIPLY)
+    {
+        a = (a * in->alpha) / 255U;
+    }
+
+    return (argb & 0x00FFFFFFU) | (a << 24);
+}
+
+/**
+ * @brief Write one ARGB8888 pixel, R/B swapped first if requested.
+ */
+static void Dma2d_RefStore(const Dma2d_Output_T *out, uint8_t *pixel, uint32_t argb)
+{
+    uint32_t v = Dma2d_EncodeColor(out->format, out->rb_swap ? Dma2d_RefSwapRb(argb) : argb);
+
+    pixel[0] = (uint8_t)v;
+    pixel[1] = (uint8_t)(v >> 8);
+    if (out->format == DMA2D_FMT_RGB888)
+    {
+        pixel[2] = (uint8_t)(v >> 16);
+    }
+    else if (out->format == DMA2D_FMT_ARGB8888)
+    {
+        pixel[2] = (uint8_t)(v >> 16);
+        pixel[3] = (uint8_t)(v >> 24);
+    }
+}
+
+/**
+ * @brief Swap the red and blue channels.
+ */
+static uint32_t Dma2d_RefSwapRb(uint32_t argb)
+{
+    return (argb & 0xFF00FF00U) | (DMA2D_REF_R(argb)) | (DMA2D_REF_B(argb) << 16);
+}
+
+/**
+ * @brief Widen an @p bits wide channel to 8 bits by bit replication.
+ */
+static uint32_t Dma2d_RefExpand(uint32_t value, uint32_t bits)
+{
+    return ((value << (8U - bits)) | (value >> ((2U * bits) - 8U))) & 0xFFU;
+}
+
+/**
+ * @brief Blend a foreground over a background pixel.
+ */
+static uint32_t Dma2d_RefBlend(uint32_t fg, uint32_t bg)
+{
+    uint32_t af = DMA2D_REF_A(fg);
+    uint32_t ab = DMA2D_REF_A(bg);
+    uint32_t am = (af * ab) / 255U;
+    uint32_t ao = af + ab - am;
+
+    if (ao == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t r = ((DMA2D_REF_R(fg) * af) + (DMA2D_REF_R(bg) * ab) - (DMA2D_REF_R(bg) * am)) / ao;
+    uint32_t g = ((DMA2D_REF_G(fg) * af) + (DMA2D_REF_G(bg) * ab) - (DMA2D_REF_G(bg) * am)) / ao;
+    uint32_t b = ((DMA2D_REF_B(fg) * af) + (DMA2D_REF_B(bg) * ab) - (DMA2D_REF_B(bg) * am)) / ao;
+    return DMA2D_REF_ARGB(ao, r, g, b);
+}
+
+/** @} */ // end of Dma2d group
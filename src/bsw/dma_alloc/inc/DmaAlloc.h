@@ -0,0 +1,209 @@
+/**
+ * @file DmaAlloc.h
+ * @brief Channel allocator shared by every GPDMA1 and HPDMA1 user
+ *
+ * Drivers no longer pick hard-coded channels. They describe what they need,
+ * a priority class, the capabilities the transfer relies on and the largest
+ * burst it issues, and receive a free channel of GPDMA1 or HPDMA1 that
+ * provides them. The allocator binds the channel interrupt to the owner
+ * through the ISR manager and measures how long each channel is busy, so
+ * the load of the two controllers can be compared and balanced.
+ *
+ * Capabilities follow the channel implementation of both controllers:
+ * every channel supports linked-list transfers, channels 12 to 15 add 2D
+ * addressing and channels 0, 1 and 15 support peripheral flow control.
+ */
+
+#ifndef DMA_ALLOC_H
+#define DMA_ALLOC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "IsrMgr.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#define DMAALLOC_CHANNELS_PER_CTRL (16U) /**< Channels of one controller */
+#define DMAALLOC_CTRL_COUNT (2U)         /**< GPDMA1 and HPDMA1 */
+#define DMAALLOC_CHANNEL_COUNT (DMAALLOC_CHANNELS_PER_CTRL * DMAALLOC_CTRL_COUNT) /**< Channels managed */
+
+#define DMAALLOC_CAP_LINKED_LIST (1U << 0) /**< Transfers described by a linked list */
+#define DMAALLOC_CAP_2D (1U << 1)          /**< 2D addressing and block repeat */
+#define DMAALLOC_CAP_PFCTRL (1U << 2)      /**< Peripheral flow control */
+
+#ifndef DMAALLOC_RESERVED_CHANNELS
+#define DMAALLOC_RESERVED_CHANNELS (2U) /**< Free channels per controller kept for ::DMAALLOC_CLASS_REALTIME */
+#endif
+
+#ifndef DMAALLOC_GPDMA_FIFO_BYTES
+#define DMAALLOC_GPDMA_FIFO_BYTES (16U) /**< FIFO of GPDMA1 linear channels, largest burst in bytes */
+#endif
+
+#ifndef DMAALLOC_GPDMA_2D_FIFO_BYTES
+#define DMAALLOC_GPDMA_2D_FIFO_BYTES (64U) /**< FIFO of GPDMA1 2D channels */
+#endif
+
+#ifndef DMAALLOC_HPDMA_FIFO_BYTES
+#define DMAALLOC_HPDMA_FIFO_BYTES (64U) /**< FIFO of HPDMA1 linear channels */
+#endif
+
+#ifndef DMAALLOC_HPDMA_2D_FIFO_BYTES
+#define DMAALLOC_HPDMA_2D_FIFO_BYTES (256U) /**< FIFO of HPDMA1 2D channels */
+#endif
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Controller a channel is taken from.
+ */
+typedef enum
+{
+    DMAALLOC_CTRL_GPDMA1 = 0, /**< General purpose DMA on AHB */
+    DMAALLOC_CTRL_HPDMA1 = 1, /**< High performance DMA on AXI */
+    DMAALLOC_CTRL_ANY = 2,    /**< Least loaded controller that fits */
+} DmaAlloc_Ctrl_T;
+
+/**
+ * @brief Priority class, mapped onto the channel arbitration priority.
+ */
+typedef enum
+{
+    DMAALLOC_CLASS_BULK = 0, /**< Background copies, low priority low weight */
+    DMAALLOC_CLASS_NORMAL,   /**< Default, low priority mid weight */
+    DMAALLOC_CLASS_STREAM,   /**< Continuous peripheral streams, low priority high weight */
+    DMAALLOC_CLASS_REALTIME, /**< Deadline bound traffic, high priority, may use reserved channels */
+} DmaAlloc_Class_T;
+
+/**
+ * @brief Channel interrupt handler of the owner.
+ *
+ * @param[in] ctx Context pointer given in ::DmaAlloc_Request_T.
+ */
+typedef IsrMgr_Handler_T DmaAlloc_Handler_T;
+
+/**
+ * @brief Description of the channel a driver needs.
+ */
+typedef struct
+{
+    DmaAlloc_Ctrl_T controller; /**< Controller, ::DMAALLOC_CTRL_ANY if the request line allows both */
+    DmaAlloc_Class_T prio_class; /**< Arbitration class */
+    uint32_t caps;               /**< Required DMAALLOC_CAP_* flags */
+    uint32_t burst_bytes;        /**< Largest burst issued, beats times data width, 0 for single */
+    const char *owner;           /**< Name reported by ::DmaAlloc_GetStats */
+    DmaAlloc_Handler_T handler;  /**< Channel interrupt handler, NULL to leave it unbound */
+    void *ctx;                   /**< Passed unchanged to @ref handler */
+} DmaAlloc_Request_T;
+
+/**
+ * @brief Channel granted by ::DmaAlloc_Request.
+ *
+ * The fields plug straight into the LL DMA API.
+ */
+typedef struct
+{
+    DMA_TypeDef *instance; /**< GPDMA1 or HPDMA1 */
+    uint32_t channel;      /**< LL_DMA_CHANNEL_x */
+    IRQn_Type irq;         /**< Channel interrupt line */
+    uint32_t priority;     /**< LL_DMA_*_PRIORITY_* of the class, for LL_DMA_InitTypeDef */
+    uint8_t id;            /**< Allocator index, 0 to ::DMAALLOC_CHANNEL_COUNT - 1 */
+} DmaAlloc_Channel_T;
+
+/**
+ * @brief Usage of one channel since the last ::DmaAlloc_ResetStats.
+ */
+typedef struct
+{
+    const char *owner;    /**< Current owner, NULL when free */
+    uint32_t caps;        /**< DMAALLOC_CAP_* flags of the channel */
+    uint32_t transfers;   /**< Runs that completed or stopped */
+    uint64_t bytes;       /**< Bytes announced by ::DmaAlloc_NoteStart */
+    uint64_t busy_cycles; /**< CPU cycles the channel was enabled */
+} DmaAlloc_Stats_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable both controllers and mark every channel free.
+ *
+ * Must run once after ::IsrMgr_Init and before any driver requests a channel.
+ *
+ * @return true on success, false if called twice.
+ */
+bool DmaAlloc_Init(void);
+
+/**
+ * @brief Allocate a channel matching @p request.
+ *
+ * Among the free channels that provide the capabilities and burst, the one
+ * with the fewest unneeded capabilities wins, so 2D channels stay available
+ * for the users that need them. With ::DMAALLOC_CTRL_ANY the controller
+ * with the lowest busy time is preferred. Classes below
+ * ::DMAALLOC_CLASS_REALTIME cannot take the last
+ * ::DMAALLOC_RESERVED_CHANNELS free channels of a controller.
+ *
+ * The channel is reset and its interrupt bound to the handler; priority
+ * and enable of the interrupt stay with the owner.
+ *
+ * @param[in]  request Needs of the caller.
+ * @param[out] channel Granted channel.
+ *
+ * @return true on success, false if no channel fits.
+ */
+bool DmaAlloc_Request(const DmaAlloc_Request_T *request, DmaAlloc_Channel_T *channel);
+
+/**
+ * @brief Return a channel to the allocator.
+ *
+ * The channel interrupt is disabled and unbound, the channel is reset.
+ *
+ * @param[in] channel Channel obtained from ::DmaAlloc_Request.
+ */
+void DmaAlloc_Release(const DmaAlloc_Channel_T *channel);
+
+/**
+ * @brief Record that the owner is about to enable the channel.
+ *
+ * The run ends when the channel is found disabled after its interrupt, or
+ * on ::DmaAlloc_NoteStop. Safe from tasks and interrupts.
+ *
+ * @param[in] channel Channel about to run.
+ * @param[in] bytes   Bytes the run moves, for the statistics.
+ */
+void DmaAlloc_NoteStart(const DmaAlloc_Channel_T *channel, uint32_t bytes);
+
+/**
+ * @brief Close the current run of a channel the owner stopped itself.
+ *
+ * For aborts and channel resets, which do not raise an interrupt.
+ *
+ * @param[in] channel Channel that stopped.
+ */
+void DmaAlloc_NoteStop(const DmaAlloc_Channel_T *channel);
+
+/**
+ * @brief Copy the usage of one channel.
+ *
+ * @param[in]  id    Allocator index, see ::DmaAlloc_Channel_T.
+ * @param[out] stats Destination for the snapshot.
+ *
+ * @return true on success, false for an invalid index.
+ */
+bool DmaAlloc_GetStats(uint32_t id, DmaAlloc_Stats_T *stats);
+
+/**
+ * @brief Sum of the busy cycles of every channel of a controller.
+ *
+ * @param[in] controller ::DMAALLOC_CTRL_GPDMA1 or ::DMAALLOC_CTRL_HPDMA1.
+ *
+ * @return Busy cycles since the last ::DmaAlloc_ResetStats.
+ */
+uint64_t DmaAlloc_GetControllerLoad(DmaAlloc_Ctrl_T controller);
+
+/**
+ * @brief Clear the usage of every channel, ownership is kept.
+ */
+void DmaAlloc_ResetStats(void);
+
+#endif /* DMA_ALLOC_H */
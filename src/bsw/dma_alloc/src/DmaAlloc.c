@@ -0,0 +1,455 @@
+/**
+ * @file DmaAlloc.c
+ * @brief Channel allocator shared by every GPDMA1 and HPDMA1 user.
+ * @ingroup DmaAlloc
+ * @{
+ *
+ * Every allocated channel with a handler has its interrupt bound to
+ * ::DmaAlloc_IrqHandler, which calls the owner and then closes the busy
+ * period of the channel once the hardware has disabled it.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "DmaAlloc.h"
+#include <stddef.h>
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_bus.h"
+#include "cmsis_gcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define DMAALLOC_SUSPEND_SPIN_LIMIT (10000U) /**< Polls of SUSPF before a release resets the channel anyway */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Ownership and usage of one channel.
+ */
+typedef struct
+{
+    const char *owner;          /**< Owner name, NULL when free */
+    DmaAlloc_Handler_T handler; /**< Owner interrupt handler */
+    void *ctx;                  /**< Context passed to @ref handler */
+    uint32_t run_start;         /**< CYCCNT when the current run started */
+    uint8_t running;            /**< A run is open, see ::DmaAlloc_NoteStart */
+    DmaAlloc_Stats_T stats;     /**< Usage, see ::DmaAlloc_GetStats */
+} DmaAlloc_Slot_T;
+
+/* Global Variables ---------------------------------------------------------*/
+/** Per-channel state, GPDMA1 channels first. */
+static DmaAlloc_Slot_T g_dmaAllocSlots[DMAALLOC_CHANNEL_COUNT];
+
+/** Set once ::DmaAlloc_Init has run. */
+static bool g_dmaAllocReady = false;
+
+/** Channel arbitration priority of each class. */
+static const uint32_t g_dmaAllocPriority[] = {
+    LL_DMA_LOW_PRIORITY_LOW_WEIGHT,
+    LL_DMA_LOW_PRIORITY_MID_WEIGHT,
+    LL_DMA_LOW_PRIORITY_HIGH_WEIGHT,
+    LL_DMA_HIGH_PRIORITY,
+};
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void DmaAlloc_IrqHandler(void *ctx);
+static void DmaAlloc_Describe(uint32_t id, DmaAlloc_Channel_T *channel);
+static uint32_t DmaAlloc_Caps(uint32_t channel);
+static uint32_t DmaAlloc_FifoBytes(uint32_t controller, uint32_t channel);
+static uint32_t DmaAlloc_FreeCount(uint32_t controller);
+static uint32_t DmaAlloc_PopCount(uint32_t value);
+static void DmaAlloc_CloseRun(DmaAlloc_Slot_T *slot);
+static void DmaAlloc_StopChannel(const DmaAlloc_Channel_T *channel);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable both controllers and mark every channel free.
+ */
+bool DmaAlloc_Init(void)
+{
+    if (g_dmaAllocReady)
+    {
+        return false;
+    }
+
+    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPDMA1);
+    LL_AHB5_GRP1_EnableClock(LL_AHB5_GRP1_PERIPH_HPDMA1);
+
+    for (uint32_t i = 0U; i < DMAALLOC_CHANNEL_COUNT; i++)
+    {
+        g_dmaAllocSlots[i] = (DmaAlloc_Slot_T){0};
+        g_dmaAllocSlots[i].stats.caps = DmaAlloc_Caps(i % DMAALLOC_CHANNELS_PER_CTRL);
+    }
+
+    g_dmaAllocReady = true;
+    return true;
+}
+
+/**
+ * @brief Allocate a channel matching @p request.
+ *
+ * Candidates are ranked by unneeded capabilities, then by controller load
+ * and finally by channel number, so the choice is deterministic for a
+ * given history.
+ */
+bool DmaAlloc_Request(const DmaAlloc_Request_T *request, DmaAlloc_Channel_T *channel)
+{
+    if (!g_dmaAllocReady || (request == NULL) || (channel == NULL) ||
+        ((uint32_t)request->prio_class > (uint32_t)DMAALLOC_CLASS_REALTIME) ||
+        ((uint32_t)request->controller > (uint32_t)DMAALLOC_CTRL_ANY))
+    {
+        return false;
+    }
+
+    uint32_t best = DMAALLOC_CHANNEL_COUNT;
+    uint32_t bestWaste = UINT32_MAX;
+    uint64_t bestLoad = UINT64_MAX;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint32_t ctrl = 0U; ctrl < DMAALLOC_CTRL_COUNT; ctrl++)
+    {
+        if ((request->controller != DMAALLOC_CTRL_ANY) && ((uint32_t)request->controller != ctrl))
+        {
+            continue;
+        }
+
+        if ((request->prio_class != DMAALLOC_CLASS_REALTIME) &&
+            (DmaAlloc_FreeCount(ctrl) <= DMAALLOC_RESERVED_CHANNELS))
+        {
+            continue;
+        }
+
+        uint64_t load = DmaAlloc_GetControllerLoad((DmaAlloc_Ctrl_T)ctrl);
+
+        for (uint32_t ch = 0U; ch < DMAALLOC_CHANNELS_PER_CTRL; ch++)
+        {
+            uint32_t id = (ctrl * DMAALLOC_CHANNELS_PER_CTRL) + ch;
+            uint32_t caps = DmaAlloc_Caps(ch);
+
+            if ((g_dmaAllocSlots[id].owner != NULL) || ((caps & request->caps) != request->caps) ||
+                (DmaAlloc_FifoBytes(ctrl, ch) < request->burst_bytes))
+            {
+                continue;
+            }
+
+            uint32_t waste = DmaAlloc_PopCount(caps & ~request->caps);
+            if ((waste < bestWaste) || ((waste == bestWaste) && (load < bestLoad)))
+            {
+                best = id;
+                bestWaste = waste;
+                bestLoad = load;
+            }
+        }
+    }
+
+    if (best < DMAALLOC_CHANNEL_COUNT)
+    {
+        DmaAlloc_Slot_T *slot = &g_dmaAllocSlots[best];
+        slot->owner = (request->owner != NULL) ? request->owner : "?";
+        slot->handler = request->handler;
+        slot->ctx = request->ctx;
+        slot->running = 0U;
+        slot->stats.owner = slot->owner;
+    }
+
+    __set_PRIMASK(primask);
+
+    if (best >= DMAALLOC_CHANNEL_COUNT)
+    {
+        return false;
+    }
+
+    DmaAlloc_Describe(best, channel);
+    channel->priority = g_dmaAllocPriority[request->prio_class];
+
+    NVIC_DisableIRQ(channel->irq);
+    DmaAlloc_StopChannel(channel);
+    NVIC_ClearPendingIRQ(channel->irq);
+
+    if ((request->handler != NULL) &&
+        !IsrMgr_Register(channel->irq, DmaAlloc_IrqHandler, &g_dmaAllocSlots[best]))
+    {
+        DmaAlloc_Release(channel);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Return a channel to the allocator.
+ */
+void DmaAlloc_Release(const DmaAlloc_Channel_T *channel)
+{
+    if ((channel == NULL) || (channel->id >= DMAALLOC_CHANNEL_COUNT))
+    {
+        return;
+    }
+
+    DmaAlloc_Slot_T *slot = &g_dmaAllocSlots[channel->id];
+
+    NVIC_DisableIRQ(channel->irq);
+    IsrMgr_Unregister(channel->irq);
+    DmaAlloc_StopChannel(channel);
+    NVIC_ClearPendingIRQ(channel->irq);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    DmaAlloc_CloseRun(slot);
+    slot->handler = NULL;
+    slot->ctx = NULL;
+    slot->stats.owner = NULL;
+    slot->owner = NULL;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Record that the owner is about to enable the channel.
+ */
+void DmaAlloc_NoteStart(const DmaAlloc_Channel_T *channel, uint32_t bytes)
+{
+    if ((channel == NULL) || (channel->id >= DMAALLOC_CHANNEL_COUNT))
+    {
+        return;
+    }
+
+    DmaAlloc_Slot_T *slot = &g_dmaAllocSlots[channel->id];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    DmaAlloc_CloseRun(slot);
+    slot->stats.bytes += bytes;
+    slot->run_start = DWT->CYCCNT;
+    slot->running = 1U;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Close the current run of a channel the owner stopped itself.
+ */
+void DmaAlloc_NoteStop(const DmaAlloc_Channel_T *channel)
+{
+    if ((channel == NULL) || (channel->id >= DMAALLOC_CHANNEL_COUNT))
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    DmaAlloc_CloseRun(&g_dmaAllocSlots[channel->id]);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Copy the usage of one channel.
+ *
+ * A run still open is included up to now, so a channel stuck enabled shows
+ * up as busy.
+ */
+bool DmaAlloc_GetStats(uint32_t id, DmaAlloc_Stats_T *stats)
+{
+    if ((id >= DMAALLOC_CHANNEL_COUNT) || (stats == NULL))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_dmaAllocSlots[id].stats;
+    if (g_dmaAllocSlots[id].running != 0U)
+    {
+        stats->busy_cycles += DWT->CYCCNT - g_dmaAllocSlots[id].run_start;
+    }
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+/**
+ * @brief Sum of the busy cycles of every channel of a controller.
+ */
+uint64_t DmaAlloc_GetControllerLoad(DmaAlloc_Ctrl_T controller)
+{
+    uint64_t load = 0U;
+
+    if ((uint32_t)controller >= DMAALLOC_CTRL_COUNT)
+    {
+        return 0U;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t ch = 0U; ch < DMAALLOC_CHANNELS_PER_CTRL; ch++)
+    {
+        load += g_dmaAllocSlots[((uint32_t)controller * DMAALLOC_CHANNELS_PER_CTRL) + ch].stats.busy_cycles;
+    }
+    __set_PRIMASK(primask);
+
+    return load;
+}
+
+/**
+ * @brief Clear the usage of every channel, ownership is kept.
+ */
+void DmaAlloc_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0U; i < DMAALLOC_CHANNEL_COUNT; i++)
+    {
+        DmaAlloc_Slot_T *slot = &g_dmaAllocSlots[i];
+        slot->stats.transfers = 0U;
+        slot->stats.bytes = 0U;
+        slot->stats.busy_cycles = 0U;
+        slot->run_start = DWT->CYCCNT;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Common interrupt entry of every allocated channel.
+ *
+ * The owner handles and clears its flags first. A channel the hardware has
+ * disabled meanwhile, on completion or on an error, ends its run.
+ *
+ * @param[in] ctx Slot of the channel.
+ */
+static void DmaAlloc_IrqHandler(void *ctx)
+{
+    DmaAlloc_Slot_T *slot = (DmaAlloc_Slot_T *)ctx;
+    uint32_t id = (uint32_t)(slot - g_dmaAllocSlots);
+    DmaAlloc_Channel_T channel;
+
+    slot->handler(slot->ctx);
+
+    DmaAlloc_Describe(id, &channel);
+    if ((slot->running != 0U) && (LL_DMA_IsEnabledChannel(channel.instance, channel.channel) == 0U))
+    {
+        DmaAlloc_CloseRun(slot);
+    }
+}
+
+/**
+ * @brief Fill the hardware coordinates of channel @p id.
+ */
+static void DmaAlloc_Describe(uint32_t id, DmaAlloc_Channel_T *channel)
+{
+    uint32_t ch = id % DMAALLOC_CHANNELS_PER_CTRL;
+
+    if (id < DMAALLOC_CHANNELS_PER_CTRL)
+    {
+        channel->instance = GPDMA1;
+        channel->irq = (IRQn_Type)((uint32_t)GPDMA1_Channel0_IRQn + ch);
+    }
+    else
+    {
+        channel->instance = HPDMA1;
+        channel->irq = (IRQn_Type)((uint32_t)HPDMA1_Channel0_IRQn + ch);
+    }
+    channel->channel = LL_DMA_CHANNEL_0 + ch;
+    channel->id = (uint8_t)id;
+}
+
+/**
+ * @brief Capabilities of a channel, identical on both controllers.
+ */
+static uint32_t DmaAlloc_Caps(uint32_t channel)
+{
+    uint32_t caps = DMAALLOC_CAP_LINKED_LIST;
+
+    if (channel >= 12U)
+    {
+        caps |= DMAALLOC_CAP_2D;
+    }
+    if ((channel == 0U) || (channel == 1U) || (channel == 15U))
+    {
+        caps |= DMAALLOC_CAP_PFCTRL;
+    }
+
+    return caps;
+}
+
+/**
+ * @brief FIFO size of a channel, which bounds its burst length.
+ */
+static uint32_t DmaAlloc_FifoBytes(uint32_t controller, uint32_t channel)
+{
+    bool is2d = (channel >= 12U);
+
+    if (controller == (uint32_t)DMAALLOC_CTRL_GPDMA1)
+    {
+        return is2d ? DMAALLOC_GPDMA_2D_FIFO_BYTES : DMAALLOC_GPDMA_FIFO_BYTES;
+    }
+
+    return is2d ? DMAALLOC_HPDMA_2D_FIFO_BYTES : DMAALLOC_HPDMA_FIFO_BYTES;
+}
+
+/**
+ * @brief Number of free channels on a controller, interrupts masked.
+ */
+static uint32_t DmaAlloc_FreeCount(uint32_t controller)
+{
+    uint32_t count = 0U;
+
+    for (uint32_t ch = 0U; ch < DMAALLOC_CHANNELS_PER_CTRL; ch++)
+    {
+        if (g_dmaAllocSlots[(controller * DMAALLOC_CHANNELS_PER_CTRL) + ch].owner == NULL)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Number of bits set in @p value.
+ */
+static uint32_t DmaAlloc_PopCount(uint32_t value)
+{
+    return (uint32_t)__builtin_popcount(value);
+}
+
+/**
+ * @brief Add the open run of @p slot to its usage, interrupts masked.
+ */
+static void DmaAlloc_CloseRun(DmaAlloc_Slot_T *slot)
+{
+    if (slot->running != 0U)
+    {
+        slot->stats.busy_cycles += DWT->CYCCNT - slot->run_start;
+        slot->stats.transfers++;
+        slot->running = 0U;
+    }
+}
+
+/**
+ * @brief Bring a channel back to its reset state.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void DmaAlloc_StopChannel(const DmaAlloc_Channel_T *channel)
+{
+    if (LL_DMA_IsEnabledChannel(channel->instance, channel->channel) != 0U)
+    {
+        uint32_t spin = DMAALLOC_SUSPEND_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(channel->instance, channel->channel);
+        while ((LL_DMA_IsActiveFlag_SUSP(channel->instance, channel->channel) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_TC(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_HT(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_DTE(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_ULE(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_USE(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_SUSP(channel->instance, channel->channel);
+    LL_DMA_ClearFlag_TO(channel->instance, channel->channel);
+}
+
+/** @} */ // end of DmaAlloc group
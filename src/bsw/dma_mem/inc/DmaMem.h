@@ -0,0 +1,210 @@
+/**
+ * @file DmaMem.h
+ * @brief Asynchronous memory copy and fill offloaded to DMA
+ *
+ * Copies and fills run on memory-to-memory channels taken from the DMA
+ * allocator, with word bursts whenever source and destination share their
+ * word alignment. Cache maintenance is done by the service: sources are
+ * cleaned before the transfer, destinations are cleaned and invalidated
+ * before and invalidated again on completion, except for buffers in the
+ * non-cacheable DMA pool.
+ *
+ * Requests smaller than a crossover threshold are served by the CPU
+ * instead, since below it programming the channel and taking its interrupt
+ * costs more CPU time than the copy itself. ::DmaMem_Calibrate measures
+ * the crossover on the running system.
+ *
+ * Several small copies and fills can be submitted as one batch. They are
+ * chained into a single linked list and complete with a single interrupt.
+ *
+ * Destination cache lines shared with other data must not be written by
+ * the CPU while a transfer to them is in flight.
+ */
+
+#ifndef DMA_MEM_H
+#define DMA_MEM_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef DMAMEM_CHANNELS
+#define DMAMEM_CHANNELS (2U) /**< Memory-to-memory channels, requests run in parallel up to this count */
+#endif
+
+#ifndef DMAMEM_LLI_PER_CHANNEL
+#define DMAMEM_LLI_PER_CHANNEL (32U) /**< Linked-list items per channel, bounds batch length and copy size */
+#endif
+
+#ifndef DMAMEM_DEFAULT_THRESHOLD
+#define DMAMEM_DEFAULT_THRESHOLD (1024U) /**< Smallest request sent to DMA until ::DmaMem_Calibrate runs */
+#endif
+
+#ifndef DMAMEM_ENABLE_BENCH
+#define DMAMEM_ENABLE_BENCH (1U) /**< Build ::DmaMem_Calibrate and its buffers */
+#endif
+
+#define DMAMEM_MAX_BLOCK (0xFFE0U)   /**< Largest linked-list item, cache line multiple below the 16-bit BNDT */
+#define DMAMEM_BURST_BEATS (4U)      /**< Word beats per burst, fits the FIFO of every channel */
+#define DMAMEM_BENCH_POINTS (8U)     /**< Sizes measured by ::DmaMem_Calibrate */
+#define DMAMEM_BENCH_MIN_SIZE (64U)  /**< Smallest size measured, each point doubles it */
+#define DMAMEM_BENCH_RUNS (4U)       /**< Runs per size, the fastest one is kept */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Completion callback.
+ *
+ * Runs from the DMA interrupt, or from the caller before the submit
+ * function returns when the CPU served the request.
+ *
+ * @param[in] ctx     Context pointer given at submission.
+ * @param[in] success false if the channel reported a transfer error.
+ */
+typedef void (*DmaMem_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief Operation of a batch entry.
+ */
+typedef enum
+{
+    DMAMEM_OP_COPY = 0, /**< Copy @ref DmaMem_Op_T::src to @ref DmaMem_Op_T::dst */
+    DMAMEM_OP_FILL,     /**< Fill @ref DmaMem_Op_T::dst with @ref DmaMem_Op_T::value */
+} DmaMem_OpType_T;
+
+/**
+ * @brief One entry of ::DmaMem_SubmitBatch.
+ */
+typedef struct
+{
+    DmaMem_OpType_T type; /**< Copy or fill */
+    void *dst;            /**< Destination */
+    const void *src;      /**< Source of a copy, unused for a fill */
+    uint8_t value;        /**< Byte written by a fill */
+    uint32_t size;        /**< Bytes to copy or fill */
+} DmaMem_Op_T;
+
+/**
+ * @brief Cost of one size measured by ::DmaMem_Calibrate, in CPU cycles.
+ */
+typedef struct
+{
+    uint32_t size;       /**< Bytes copied */
+    uint32_t cpu_cycles; /**< CPU copy */
+    uint32_t dma_cycles; /**< CPU time of the DMA path: submit, cache maintenance and interrupt */
+    uint32_t dma_latency; /**< Submit to completion of the DMA path */
+} DmaMem_BenchPoint_T;
+
+/**
+ * @brief Result of ::DmaMem_Calibrate.
+ */
+typedef struct
+{
+    DmaMem_BenchPoint_T point[DMAMEM_BENCH_POINTS]; /**< Measured sizes, ascending */
+    uint32_t threshold;                             /**< Crossover applied by the calibration */
+} DmaMem_Bench_T;
+
+/**
+ * @brief Counters of the service.
+ */
+typedef struct
+{
+    uint32_t threshold;    /**< Current crossover in bytes */
+    uint32_t dma_requests; /**< Requests completed by DMA */
+    uint32_t cpu_requests; /**< Requests served by the CPU */
+    uint64_t dma_bytes;    /**< Bytes moved by DMA */
+    uint64_t cpu_bytes;    /**< Bytes moved by the CPU */
+    uint32_t items;        /**< Linked-list items executed */
+    uint32_t busy;         /**< Submissions rejected, every channel busy */
+    uint32_t errors;       /**< Requests that ended with a transfer error */
+} DmaMem_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Take the memory-to-memory channels from the DMA allocator.
+ *
+ * Must run once after ::DmaAlloc_Init.
+ *
+ * @return true on success, false if the channels could not be allocated.
+ */
+bool DmaMem_Init(void);
+
+/**
+ * @brief Copy @p size bytes from @p src to @p dst in the background.
+ *
+ * The buffers must not overlap and must stay valid until @p cb runs.
+ *
+ * @param[out] dst  Destination.
+ * @param[in]  src  Source.
+ * @param[in]  size Bytes to copy.
+ * @param[in]  cb   Completion callback, may be NULL.
+ * @param[in]  ctx  Passed unchanged to @p cb.
+ *
+ * @retval true  Copy done or started, @p cb will run exactly once.
+ * @retval false Invalid parameters, request too large or every channel busy.
+ */
+bool DmaMem_CopyAsync(void *dst, const void *src, uint32_t size, DmaMem_Callback_T cb, void *ctx);
+
+/**
+ * @brief Fill @p size bytes at @p dst with @p value in the background.
+ *
+ * @param[out] dst   Destination.
+ * @param[in]  value Byte written.
+ * @param[in]  size  Bytes to fill.
+ * @param[in]  cb    Completion callback, may be NULL.
+ * @param[in]  ctx   Passed unchanged to @p cb.
+ *
+ * @retval true  Fill done or started, @p cb will run exactly once.
+ * @retval false Invalid parameters, request too large or every channel busy.
+ */
+bool DmaMem_FillAsync(void *dst, uint8_t value, uint32_t size, DmaMem_Callback_T cb, void *ctx);
+
+/**
+ * @brief Run several copies and fills as one linked-list transfer.
+ *
+ * The entries run in order on one channel and @p cb runs once after the
+ * last one. The threshold applies to the total size of the batch.
+ *
+ * @param[in] ops   Entries, copied by the call.
+ * @param[in] count Number of entries.
+ * @param[in] cb    Completion callback, may be NULL.
+ * @param[in] ctx   Passed unchanged to @p cb.
+ *
+ * @retval true  Batch done or started, @p cb will run exactly once.
+ * @retval false Invalid entry, more items than ::DMAMEM_LLI_PER_CHANNEL or
+ *               every channel busy.
+ */
+bool DmaMem_SubmitBatch(const DmaMem_Op_T *ops, uint32_t count, DmaMem_Callback_T cb, void *ctx);
+
+/**
+ * @brief Measure CPU and DMA copy cost and apply the crossover.
+ *
+ * Copies ::DMAMEM_BENCH_POINTS sizes from ::DMAMEM_BENCH_MIN_SIZE upward
+ * with both paths and sets the threshold to the smallest size for which
+ * the DMA path costs less CPU time than the copy. Blocks the caller for
+ * the duration of the runs; call it from a task while the DMA channels
+ * are otherwise idle.
+ *
+ * @param[out] bench Measurements, may be NULL.
+ *
+ * @return true on success, false if a channel could not be used.
+ */
+bool DmaMem_Calibrate(DmaMem_Bench_T *bench);
+
+/**
+ * @brief Override the CPU/DMA crossover.
+ *
+ * @param[in] bytes Smallest request sent to DMA, 0 sends everything to DMA.
+ */
+void DmaMem_SetThreshold(uint32_t bytes);
+
+/**
+ * @brief Copy the service counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void DmaMem_GetStatus(DmaMem_Status_T *status);
+
+#endif /* DMA_MEM_H */
@@ -0,0 +1,732 @@
+/**
+ * @file DmaMem.c
+ * @brief Implementation of the DMA memory copy and fill service.
+ * @ingroup DmaMem
+ * @{
+ *
+ * Every request becomes a list of linked-list items of at most
+ * ::DMAMEM_MAX_BLOCK bytes. The first item is written straight into the
+ * channel registers, the others are read by the channel from a per-channel
+ * item table in the non-cacheable section, so neither side needs cache
+ * maintenance for them. The transfer complete event is raised at the end
+ * of the last item only, so a request costs one interrupt whatever its
+ * length or number of entries.
+ *
+ * Bytes before the first and after the last aligned word of an entry are
+ * handled by the CPU when source and destination share their alignment,
+ * which lets the channel use word bursts for the rest. Otherwise the entry
+ * runs with byte transfers.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "DmaMem.h"
+#include <stddef.h>
+#include <string.h>
+#include "DmaAlloc.h"
+#include "DmaPool.h"
+#include "stm32n6xx_ll_dma.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define DMAMEM_LLI_WORDS (6U) /**< CTR1, CTR2, CBR1, CSAR, CDAR and CLLR of a linear channel item */
+#define DMAMEM_LLI_UPDATE (LL_DMA_UPDATE_CTR1 | LL_DMA_UPDATE_CTR2 | LL_DMA_UPDATE_CBR1 | \
+                           LL_DMA_UPDATE_CSAR | LL_DMA_UPDATE_CDAR | LL_DMA_UPDATE_CLLR) /**< Registers loaded per item */
+#define DMAMEM_LLI_POOL_ALIGN (2048U) /**< Keeps every item table inside one 64 KiB linked-list window */
+#define DMAMEM_WORD_MASK (3U)         /**< Low address bits of a word */
+#define DMAMEM_FILL_PATTERN (0x01010101U) /**< Replicates a fill byte over a word */
+#define DMAMEM_BENCH_MAX_SIZE (DMAMEM_BENCH_MIN_SIZE << (DMAMEM_BENCH_POINTS - 1U)) /**< Largest measured size */
+#define DMAMEM_BENCH_WAIT_LIMIT (100U) /**< Wake-ups waited for a benchmark transfer before giving up */
+
+#if ((DMAMEM_CHANNELS * DMAMEM_LLI_PER_CHANNEL * DMAMEM_LLI_WORDS * 4U) > DMAMEM_LLI_POOL_ALIGN)
+#error "DMAMEM_LLI_POOL_ALIGN must cover the linked-list item tables"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Linked-list item in the layout the channel loads it.
+ */
+typedef struct
+{
+    uint32_t ctr1; /**< Widths, increments and burst lengths */
+    uint32_t ctr2; /**< Software request and transfer event mode */
+    uint32_t cbr1; /**< Block length in bytes */
+    uint32_t csar; /**< Source address */
+    uint32_t cdar; /**< Destination address */
+    uint32_t cllr; /**< Next item offset and update flags, 0 for the last */
+} DmaMem_Lli_T;
+
+/**
+ * @brief One memory-to-memory channel and the request it runs.
+ */
+typedef struct
+{
+    DmaAlloc_Channel_T channel;      /**< Channel granted by the allocator */
+    volatile uint8_t busy;           /**< A request owns the channel */
+    DmaMem_Callback_T cb;            /**< Completion callback of the request */
+    void *ctx;                       /**< Context passed to @ref cb */
+    uint32_t items;                  /**< Linked-list items of the request */
+    uint32_t bytes;                  /**< Bytes moved by the channel */
+    uint32_t inval_count;            /**< Destinations invalidated on completion */
+    uintptr_t inval_addr[DMAMEM_LLI_PER_CHANNEL]; /**< Cacheable destinations */
+    uint32_t inval_size[DMAMEM_LLI_PER_CHANNEL];  /**< Their sizes */
+} DmaMem_Engine_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Linked-list items, one table per channel. */
+static DmaMem_Lli_T g_dmaMemLli[DMAMEM_CHANNELS][DMAMEM_LLI_PER_CHANNEL]
+    __attribute__((section("noncacheable_buffer"), aligned(DMAMEM_LLI_POOL_ALIGN)));
+
+/** Fill patterns read by fixed-source items, one word per item. */
+static uint32_t g_dmaMemPattern[DMAMEM_CHANNELS][DMAMEM_LLI_PER_CHANNEL]
+    __attribute__((section("noncacheable_buffer"), aligned(DMAPOOL_CACHE_LINE_SIZE)));
+
+/** Channel state. */
+static DmaMem_Engine_T g_dmaMemEngines[DMAMEM_CHANNELS];
+
+/** Smallest request sent to DMA. */
+static volatile uint32_t g_dmaMemThreshold = DMAMEM_DEFAULT_THRESHOLD;
+
+/** Counters reported by ::DmaMem_GetStatus. */
+static DmaMem_Status_T g_dmaMemStatus = {0};
+
+/** CPU cycles of the last completion interrupt, for ::DmaMem_Calibrate. */
+static volatile uint32_t g_dmaMemIrqCycles = 0U;
+
+#if (DMAMEM_ENABLE_BENCH == 1U)
+/** Calibration source buffer. */
+static uint8_t g_dmaMemBenchSrc[DMAMEM_BENCH_MAX_SIZE] __attribute__((aligned(DMAPOOL_CACHE_LINE_SIZE)));
+/** Calibration destination buffer. */
+static uint8_t g_dmaMemBenchDst[DMAMEM_BENCH_MAX_SIZE] __attribute__((aligned(DMAPOOL_CACHE_LINE_SIZE)));
+/** CYCCNT at the completion of the last calibration transfer, 0 while pending. */
+static volatile uint32_t g_dmaMemBenchDone = 0U;
+#endif
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Validate, route and start a request. */
+static bool DmaMem_Submit(const DmaMem_Op_T *ops, uint32_t count, DmaMem_Callback_T cb, void *ctx, bool forceDma);
+/** Run a request on the CPU. */
+static void DmaMem_RunOnCpu(const DmaMem_Op_T *ops, uint32_t count);
+/** Linked-list items needed by one entry. */
+static uint32_t DmaMem_CountItems(const DmaMem_Op_T *op);
+/** Write the items of one entry, handling unaligned ends on the CPU. */
+static uint32_t DmaMem_BuildItems(DmaMem_Engine_T *engine, uint32_t first, const DmaMem_Op_T *op);
+/** Bytes the CPU handles before the first aligned word of an entry. */
+static uint32_t DmaMem_HeadBytes(const DmaMem_Op_T *op);
+/** Load the first item and start the channel. */
+static void DmaMem_Start(DmaMem_Engine_T *engine);
+/** Claim a free channel. */
+static DmaMem_Engine_T *DmaMem_Claim(void);
+/** Completion interrupt of a channel, bound through the DMA allocator. */
+static void DmaMem_IrqHandler(void *ctx);
+/** Register block of a channel. */
+static DMA_Channel_TypeDef *DmaMem_Regs(const DmaAlloc_Channel_T *channel);
+#if (DMAMEM_ENABLE_BENCH == 1U)
+/** Completion callback of the calibration transfers. */
+static void DmaMem_BenchDone(void *ctx, bool success);
+#endif
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Take the memory-to-memory channels from the DMA allocator.
+ *
+ * Channels are requested from either controller in the bulk class, so
+ * peripheral streams win arbitration against background copies. The
+ * allocator balances them between GPDMA1 and HPDMA1.
+ */
+bool DmaMem_Init(void)
+{
+    for (uint32_t i = 0U; i < DMAMEM_CHANNELS; i++)
+    {
+        DmaMem_Engine_T *engine = &g_dmaMemEngines[i];
+        const DmaAlloc_Request_T request = {
+            .controller = DMAALLOC_CTRL_ANY,
+            .prio_class = DMAALLOC_CLASS_BULK,
+            .caps = DMAALLOC_CAP_LINKED_LIST,
+            .burst_bytes = DMAMEM_BURST_BEATS * 4U,
+            .owner = "DmaMem",
+            .handler = DmaMem_IrqHandler,
+            .ctx = engine,
+        };
+
+        if (!DmaAlloc_Request(&request, &engine->channel))
+        {
+            return false;
+        }
+
+        LL_DMA_ConfigControl(engine->channel.instance, engine->channel.channel,
+                             engine->channel.priority | LL_DMA_LINK_ALLOCATED_PORT0 | LL_DMA_LSM_FULL_EXECUTION);
+        LL_DMA_SetLinkedListBaseAddr(engine->channel.instance, engine->channel.channel,
+                                     (uint32_t)&g_dmaMemLli[i][0]);
+        LL_DMA_EnableIT_TC(engine->channel.instance, engine->channel.channel);
+        LL_DMA_EnableIT_DTE(engine->channel.instance, engine->channel.channel);
+        LL_DMA_EnableIT_ULE(engine->channel.instance, engine->channel.channel);
+        LL_DMA_EnableIT_USE(engine->channel.instance, engine->channel.channel);
+
+        NVIC_SetPriority(engine->channel.irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                                  configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+        NVIC_EnableIRQ(engine->channel.irq);
+    }
+
+    g_dmaMemStatus.threshold = g_dmaMemThreshold;
+    return true;
+}
+
+/**
+ * @brief Copy @p size bytes from @p src to @p dst in the background.
+ */
+bool DmaMem_CopyAsync(void *dst, const void *src, uint32_t size, DmaMem_Callback_T cb, void *ctx)
+{
+    const DmaMem_Op_T op = {DMAMEM_OP_COPY, dst, src, 0U, size};
+    return DmaMem_Submit(&op, 1U, cb, ctx, false);
+}
+
+/**
+ * @brief Fill @p size bytes at @p dst with @p value in the background.
+ */
+bool DmaMem_FillAsync(void *dst, uint8_t value, uint32_t size, DmaMem_Callback_T cb, void *ctx)
+{
+    const DmaMem_Op_T op = {DMAMEM_OP_FILL, dst, NULL, value, size};
+    return DmaMem_Submit(&op, 1U, cb, ctx, false);
+}
+
+/**
+ * @brief Run several copies and fills as one linked-list transfer.
+ */
+bool DmaMem_SubmitBatch(const DmaMem_Op_T *ops, uint32_t count, DmaMem_Callback_T cb, void *ctx)
+{
+    return DmaMem_Submit(ops, count, cb, ctx, false);
+}
+
+#if (DMAMEM_ENABLE_BENCH == 1U)
+/**
+ * @brief Measure CPU and DMA copy cost and apply the crossover.
+ *
+ * Both paths copy between the same cacheable buffers. The CPU cost is the
+ * copy itself; the DMA cost is the submission, including cache
+ * maintenance, plus the completion interrupt. The fastest of
+ * ::DMAMEM_BENCH_RUNS runs is kept for each, which removes the cold cache
+ * first run. The caller sleeps with WFI while a transfer is in flight and
+ * every DMA copy is checked against its source.
+ */
+bool DmaMem_Calibrate(DmaMem_Bench_T *bench)
+{
+    DmaMem_Bench_T result;
+    uint32_t threshold = UINT32_MAX;
+
+    for (uint32_t i = 0U; i < DMAMEM_BENCH_MAX_SIZE; i++)
+    {
+        g_dmaMemBenchSrc[i] = (uint8_t)i;
+    }
+
+    for (uint32_t p = 0U; p < DMAMEM_BENCH_POINTS; p++)
+    {
+        DmaMem_BenchPoint_T *point = &result.point[p];
+        point->size = DMAMEM_BENCH_MIN_SIZE << p;
+        point->cpu_cycles = UINT32_MAX;
+        point->dma_cycles = UINT32_MAX;
+        point->dma_latency = UINT32_MAX;
+
+        for (uint32_t run = 0U; run < DMAMEM_BENCH_RUNS; run++)
+        {
+            uint32_t start = DWT->CYCCNT;
+            memcpy(g_dmaMemBenchDst, g_dmaMemBenchSrc, point->size);
+            __COMPILER_BARRIER(); /* The copy is otherwise dead to the compiler */
+            uint32_t cycles = DWT->CYCCNT - start;
+            if (cycles < point->cpu_cycles)
+            {
+                point->cpu_cycles = cycles;
+            }
+
+            const DmaMem_Op_T op = {DMAMEM_OP_COPY, g_dmaMemBenchDst, g_dmaMemBenchSrc, 0U, point->size};
+            g_dmaMemBenchDone = 0U;
+            start = DWT->CYCCNT;
+            if (!DmaMem_Submit(&op, 1U, DmaMem_BenchDone, NULL, true))
+            {
+                return false;
+            }
+            uint32_t submit = DWT->CYCCNT - start;
+
+            for (uint32_t wait = 0U; wait < DMAMEM_BENCH_WAIT_LIMIT; wait++)
+            {
+                __disable_irq();
+                if (g_dmaMemBenchDone != 0U)
+                {
+                    __enable_irq();
+                    break;
+                }
+                __WFI();
+                __enable_irq();
+            }
+            if ((g_dmaMemBenchDone == 0U) || (memcmp(g_dmaMemBenchDst, g_dmaMemBenchSrc, point->size) != 0))
+            {
+                return false;
+            }
+
+            cycles = submit + g_dmaMemIrqCycles;
+            if (cycles < point->dma_cycles)
+            {
+                point->dma_cycles = cycles;
+            }
+            cycles = g_dmaMemBenchDone - start;
+            if (cycles < point->dma_latency)
+            {
+                point->dma_latency = cycles;
+            }
+        }
+
+        if ((threshold == UINT32_MAX) && (point->dma_cycles < point->cpu_cycles))
+        {
+            threshold = point->size;
+        }
+    }
+
+    DmaMem_SetThreshold(threshold);
+    result.threshold = threshold;
+    if (bench != NULL)
+    {
+        *bench = result;
+    }
+    return true;
+}
+#else
+/**
+ * @brief Calibration is compiled out, the threshold is left unchanged.
+ */
+bool DmaMem_Calibrate(DmaMem_Bench_T *bench)
+{
+    (void)bench;
+    return false;
+}
+#endif
+
+/**
+ * @brief Override the CPU/DMA crossover.
+ */
+void DmaMem_SetThreshold(uint32_t bytes)
+{
+    g_dmaMemThreshold = bytes;
+    g_dmaMemStatus.threshold = bytes;
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void DmaMem_GetStatus(DmaMem_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_dmaMemStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Validate a request, serve it on the CPU or start it on a channel.
+ *
+ * Items are counted before anything is written so a request that does not
+ * fit the item table is rejected without side effects.
+ *
+ * @param[in] ops      Entries.
+ * @param[in] count    Number of entries.
+ * @param[in] cb       Completion callback, may be NULL.
+ * @param[in] ctx      Passed unchanged to @p cb.
+ * @param[in] forceDma Ignore the threshold, used by the calibration.
+ *
+ * @retval true  Request done or started.
+ * @retval false Invalid request or every channel busy.
+ */
+static bool DmaMem_Submit(const DmaMem_Op_T *ops, uint32_t count, DmaMem_Callback_T cb, void *ctx, bool forceDma)
+{
+    uint32_t total = 0U;
+    uint32_t items = 0U;
+
+    if ((ops == NULL) || (count == 0U) || (count > DMAMEM_LLI_PER_CHANNEL))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        if ((ops[i].dst == NULL) || (ops[i].size == 0U) ||
+            ((ops[i].type == DMAMEM_OP_COPY) && (ops[i].src == NULL)) ||
+            ((ops[i].type != DMAMEM_OP_COPY) && (ops[i].type != DMAMEM_OP_FILL)))
+        {
+            return false;
+        }
+        total += ops[i].size;
+        items += DmaMem_CountItems(&ops[i]);
+    }
+
+    if (items > DMAMEM_LLI_PER_CHANNEL)
+    {
+        return false;
+    }
+
+    if ((items == 0U) || (!forceDma && (total < g_dmaMemThreshold)))
+    {
+        DmaMem_RunOnCpu(ops, count);
+        if (cb != NULL)
+        {
+            cb(ctx, true);
+        }
+        return true;
+    }
+
+    DmaMem_Engine_T *engine = DmaMem_Claim();
+    if (engine == NULL)
+    {
+        __atomic_add_fetch(&g_dmaMemStatus.busy, 1U, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    engine->cb = cb;
+    engine->ctx = ctx;
+    engine->items = 0U;
+    engine->bytes = 0U;
+    engine->inval_count = 0U;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        engine->items += DmaMem_BuildItems(engine, engine->items, &ops[i]);
+    }
+
+    if (engine->items == 0U)
+    {
+        /* Every entry was short enough to be finished by its unaligned ends */
+        engine->cb = NULL;
+        __DMB();
+        engine->busy = 0U;
+        if (cb != NULL)
+        {
+            cb(ctx, true);
+        }
+        return true;
+    }
+
+    DmaMem_Start(engine);
+    return true;
+}
+
+/**
+ * @brief Run a request on the CPU.
+ *
+ * The C library routines are the optimised word and burst copies of the
+ * toolchain, which beat any hand-written loop on small sizes.
+ */
+static void DmaMem_RunOnCpu(const DmaMem_Op_T *ops, uint32_t count)
+{
+    uint32_t bytes = 0U;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        if (ops[i].type == DMAMEM_OP_COPY)
+        {
+            memcpy(ops[i].dst, ops[i].src, ops[i].size);
+        }
+        else
+        {
+            memset(ops[i].dst, ops[i].value, ops[i].size);
+        }
+        bytes += ops[i].size;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_dmaMemStatus.cpu_requests++;
+    g_dmaMemStatus.cpu_bytes += bytes;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Linked-list items needed by one entry.
+ */
+static uint32_t DmaMem_CountItems(const DmaMem_Op_T *op)
+{
+    uint32_t head = DmaMem_HeadBytes(op);
+    uint32_t body = op->size - head;
+
+    if (head != UINT32_MAX)
+    {
+        body &= ~DMAMEM_WORD_MASK;
+    }
+    else
+    {
+        body = op->size;
+    }
+
+    return (body + DMAMEM_MAX_BLOCK - 1U) / DMAMEM_MAX_BLOCK;
+}
+
+/**
+ * @brief Bytes the CPU handles before the first aligned word of an entry.
+ *
+ * @return Head length, or UINT32_MAX when the entry runs with byte
+ *         transfers because source and destination alignments differ or
+ *         the entry is too short for a word body.
+ */
+static uint32_t DmaMem_HeadBytes(const DmaMem_Op_T *op)
+{
+    uintptr_t dst = (uintptr_t)op->dst;
+    uint32_t head = (uint32_t)((4U - (dst & DMAMEM_WORD_MASK)) & DMAMEM_WORD_MASK);
+
+    if ((op->type == DMAMEM_OP_COPY) && ((((uintptr_t)op->src ^ dst) & DMAMEM_WORD_MASK) != 0U))
+    {
+        return UINT32_MAX;
+    }
+    if (op->size < (head + 4U))
+    {
+        return UINT32_MAX;
+    }
+
+    return head;
+}
+
+/**
+ * @brief Write the items of one entry starting at index @p first.
+ *
+ * Unaligned ends are copied or filled by the CPU first, then the source is
+ * cleaned and the destination cleaned and invalidated so the channel
+ * reads current data and no dirty line is evicted over its writes.
+ *
+ * @return Number of items written.
+ */
+static uint32_t DmaMem_BuildItems(DmaMem_Engine_T *engine, uint32_t first, const DmaMem_Op_T *op)
+{
+    uint32_t slot = (uint32_t)(engine - g_dmaMemEngines);
+    uint32_t head = DmaMem_HeadBytes(op);
+    bool wordMode = (head != UINT32_MAX);
+    uint8_t *dst = (uint8_t *)op->dst;
+    const uint8_t *src = (const uint8_t *)op->src;
+    uint32_t body = op->size;
+
+    if (wordMode)
+    {
+        body = (op->size - head) & ~DMAMEM_WORD_MASK;
+        uint32_t tail = op->size - head - body;
+        if (op->type == DMAMEM_OP_COPY)
+        {
+            memcpy(dst, src, head);
+            memcpy(dst + head + body, src + head + body, tail);
+            src += head;
+        }
+        else
+        {
+            memset(dst, op->value, head);
+            memset(dst + head + body, op->value, tail);
+        }
+        dst += head;
+    }
+
+    if (body == 0U)
+    {
+        return 0U;
+    }
+
+    if ((op->type == DMAMEM_OP_COPY) && !DmaPool_IsNonCacheable(src, body))
+    {
+        SCB_CleanDCache_by_Addr((void *)src, (int32_t)body);
+    }
+    if (!DmaPool_IsNonCacheable(dst, body))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(dst, (int32_t)body);
+        engine->inval_addr[engine->inval_count] = (uintptr_t)dst;
+        engine->inval_size[engine->inval_count] = body;
+        engine->inval_count++;
+    }
+
+    uint32_t ctr1 = LL_DMA_DEST_INCREMENT;
+    if (op->type == DMAMEM_OP_COPY)
+    {
+        ctr1 |= LL_DMA_SRC_INCREMENT;
+    }
+    if (wordMode)
+    {
+        ctr1 |= LL_DMA_SRC_DATAWIDTH_WORD | LL_DMA_DEST_DATAWIDTH_WORD |
+                ((DMAMEM_BURST_BEATS - 1U) << DMA_CTR1_SBL_1_Pos) | ((DMAMEM_BURST_BEATS - 1U) << DMA_CTR1_DBL_1_Pos);
+    }
+
+    uint32_t count = 0U;
+    while (body > 0U)
+    {
+        uint32_t idx = first + count;
+        uint32_t len = (body > DMAMEM_MAX_BLOCK) ? DMAMEM_MAX_BLOCK : body;
+        DmaMem_Lli_T *item = &g_dmaMemLli[slot][idx];
+        uint32_t source = (uint32_t)src;
+
+        if (op->type == DMAMEM_OP_FILL)
+        {
+            g_dmaMemPattern[slot][idx] = (uint32_t)op->value * DMAMEM_FILL_PATTERN;
+            source = (uint32_t)&g_dmaMemPattern[slot][idx];
+        }
+
+        item->ctr1 = ctr1;
+        item->ctr2 = LL_DMA_DIRECTION_MEMORY_TO_MEMORY | LL_DMA_TCEM_LAST_LLITEM_TRANSFER;
+        item->cbr1 = len;
+        item->csar = source;
+        item->cdar = (uint32_t)dst;
+        item->cllr = 0U;
+        if (idx > 0U)
+        {
+            g_dmaMemLli[slot][idx - 1U].cllr = DMAMEM_LLI_UPDATE | ((uint32_t)item & DMA_CLLR_LA);
+        }
+
+        if (op->type == DMAMEM_OP_COPY)
+        {
+            src += len;
+        }
+        dst += len;
+        body -= len;
+        engine->bytes += len;
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Load the first item into the channel and enable it.
+ *
+ * The registers are written in the order the channel loads an item, the
+ * remaining items follow through CLLR.
+ */
+static void DmaMem_Start(DmaMem_Engine_T *engine)
+{
+    uint32_t slot = (uint32_t)(engine - g_dmaMemEngines);
+    const DmaMem_Lli_T *item = &g_dmaMemLli[slot][0];
+    DMA_Channel_TypeDef *regs = DmaMem_Regs(&engine->channel);
+
+    WRITE_REG(regs->CTR1, item->ctr1);
+    WRITE_REG(regs->CTR2, item->ctr2);
+    WRITE_REG(regs->CBR1, item->cbr1);
+    WRITE_REG(regs->CSAR, item->csar);
+    WRITE_REG(regs->CDAR, item->cdar);
+    WRITE_REG(regs->CLLR, item->cllr);
+
+    DmaAlloc_NoteStart(&engine->channel, engine->bytes);
+    __DMB();
+    LL_DMA_EnableChannel(engine->channel.instance, engine->channel.channel);
+}
+
+/**
+ * @brief Claim the first idle channel.
+ *
+ * @return Channel now owned by the caller, or NULL if all are busy.
+ */
+static DmaMem_Engine_T *DmaMem_Claim(void)
+{
+    DmaMem_Engine_T *engine = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0U; i < DMAMEM_CHANNELS; i++)
+    {
+        if (g_dmaMemEngines[i].busy == 0U)
+        {
+            g_dmaMemEngines[i].busy = 1U;
+            engine = &g_dmaMemEngines[i];
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return engine;
+}
+
+/**
+ * @brief Completion interrupt of a memory-to-memory channel.
+ *
+ * The destination lines are invalidated so the CPU does not read lines
+ * speculatively fetched during the transfer. A channel stopped by an error
+ * has already been disabled by the hardware and only needs a reset. The
+ * channel is released before the callback so the callback may submit the
+ * next request.
+ *
+ * @param[in] ctx Channel state.
+ */
+static void DmaMem_IrqHandler(void *ctx)
+{
+    uint32_t start = DWT->CYCCNT;
+    DmaMem_Engine_T *engine = (DmaMem_Engine_T *)ctx;
+    DMA_TypeDef *dma = engine->channel.instance;
+    uint32_t ch = engine->channel.channel;
+    bool success;
+
+    if (LL_DMA_IsActiveFlag_TC(dma, ch) != 0U)
+    {
+        LL_DMA_ClearFlag_TC(dma, ch);
+        LL_DMA_ClearFlag_HT(dma, ch);
+        success = true;
+    }
+    else if ((LL_DMA_IsActiveFlag_DTE(dma, ch) != 0U) || (LL_DMA_IsActiveFlag_ULE(dma, ch) != 0U) ||
+             (LL_DMA_IsActiveFlag_USE(dma, ch) != 0U))
+    {
+        LL_DMA_ClearFlag_DTE(dma, ch);
+        LL_DMA_ClearFlag_ULE(dma, ch);
+        LL_DMA_ClearFlag_USE(dma, ch);
+        LL_DMA_ClearFlag_HT(dma, ch);
+        LL_DMA_ResetChannel(dma, ch);
+        success = false;
+    }
+    else
+    {
+        return;
+    }
+
+    for (uint32_t i = 0U; i < engine->inval_count; i++)
+    {
+        SCB_InvalidateDCache_by_Addr((void *)engine->inval_addr[i], (int32_t)engine->inval_size[i]);
+    }
+
+    if (success)
+    {
+        g_dmaMemStatus.dma_requests++;
+        g_dmaMemStatus.dma_bytes += engine->bytes;
+        g_dmaMemStatus.items += engine->items;
+    }
+    else
+    {
+        g_dmaMemStatus.errors++;
+    }
+
+    DmaMem_Callback_T cb = engine->cb;
+    void *cbCtx = engine->ctx;
+    engine->cb = NULL;
+    engine->ctx = NULL;
+    g_dmaMemIrqCycles = DWT->CYCCNT - start;
+    __DMB();
+    engine->busy = 0U;
+
+    if (cb != NULL)
+    {
+        cb(cbCtx, success);
+    }
+}
+
+/**
+ * @brief Register block of a channel, for the raw item loads.
+ */
+static DMA_Channel_TypeDef *DmaMem_Regs(const DmaAlloc_Channel_T *channel)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)channel->instance + LL_DMA_CH_OFFSET_TAB[channel->channel]);
+}
+
+#if (DMAMEM_ENABLE_BENCH == 1U)
+/**
+ * @brief Record when a calibration transfer completed.
+ */
+static void DmaMem_BenchDone(void *ctx, bool success)
+{
+    (void)ctx;
+    (void)success;
+    uint32_t now = DWT->CYCCNT;
+    g_dmaMemBenchDone = (now != 0U) ? now : 1U;
+}
+#endif
+
+/** @} */ // end of DmaMem group
@@ -0,0 +1,89 @@
+/**
+ * @file DmaPool.h
+ * @brief Fixed-size DMA buffer pool in non-cacheable memory
+ *
+ * Blocks are carved out of the `.noncacheable` linker section, which an MPU
+ * region maps as normal non-cacheable memory. Buffers taken from the pool
+ * can be handed to any DMA master without cache clean or invalidate
+ * operations, and each block starts on its own cache line so a block never
+ * shares a line with unrelated data.
+ */
+
+#ifndef DMA_POOL_H
+#define DMA_POOL_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef DMAPOOL_BLOCK_SIZE
+#define DMAPOOL_BLOCK_SIZE (288U) /**< Bytes per block, multiple of the cache line */
+#endif
+
+#ifndef DMAPOOL_BLOCK_COUNT
+#define DMAPOOL_BLOCK_COUNT (32U) /**< Number of blocks, at most 32 */
+#endif
+
+#ifndef DMAPOOL_MPU_REGION
+#define DMAPOOL_MPU_REGION (0U) /**< MPU region number covering the pool */
+#endif
+
+#ifndef DMAPOOL_MPU_ATTR_IDX
+#define DMAPOOL_MPU_ATTR_IDX (0U) /**< MAIR attribute index used by the region */
+#endif
+
+#define DMAPOOL_CACHE_LINE_SIZE (32U) /**< Cortex-M55 data cache line size */
+
+/* Typedefs -----------------------------------------------------------------*/
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Map the pool as non-cacheable and mark every block free.
+ *
+ * Must run once before the scheduler starts and before any DMA user
+ * allocates from the pool.
+ *
+ * @return true on success, false if the section is misaligned.
+ */
+bool DmaPool_Init(void);
+
+/**
+ * @brief Take one block from the pool.
+ *
+ * Lock-free and safe to call from tasks and interrupts.
+ *
+ * @return Pointer to a ::DMAPOOL_BLOCK_SIZE byte block or NULL when empty.
+ */
+void *DmaPool_Alloc(void);
+
+/**
+ * @brief Return a block to the pool.
+ *
+ * @param[in] block Pointer previously returned by ::DmaPool_Alloc.
+ */
+void DmaPool_Free(void *block);
+
+/**
+ * @brief Check whether a buffer lies completely in non-cacheable memory.
+ *
+ * Drivers use this to decide whether cache maintenance can be skipped.
+ *
+ * @param[in] ptr  Start of the buffer.
+ * @param[in] size Length of the buffer in bytes.
+ *
+ * @return true if the whole range is inside the `.noncacheable` section.
+ */
+bool DmaPool_IsNonCacheable(const void *ptr, size_t size);
+
+/**
+ * @brief Number of blocks currently allocated.
+ *
+ * @return Count of blocks in use.
+ */
+uint32_t DmaPool_GetUsedCount(void);
+
+#endif /* DMA_POOL_H */
@@ -0,0 +1,164 @@
+/**
+ * @file DmaPool.c
+ * @brief Implementation of the non-cacheable DMA buffer pool.
+ * @ingroup DmaPool
+ * @{
+ *
+ * The pool storage is placed in the `noncacheable_buffer` input section that
+ * the linker script collects into `.noncacheable`. ::DmaPool_Init programs
+ * one MPU region over that section with a normal, non-cacheable memory
+ * attribute. Allocation state is a single bitmap updated with atomic
+ * compare-and-exchange so tasks and interrupts can allocate without locks.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "DmaPool.h"
+#include "stm32n6xx.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#if (DMAPOOL_BLOCK_SIZE % DMAPOOL_CACHE_LINE_SIZE) != 0U
+#error "DMAPOOL_BLOCK_SIZE must be a multiple of the cache line size"
+#endif
+
+#if (DMAPOOL_BLOCK_COUNT == 0U) || (DMAPOOL_BLOCK_COUNT > 32U)
+#error "DMAPOOL_BLOCK_COUNT must be between 1 and 32"
+#endif
+
+/** Bitmap value with one bit set per pool block. */
+#define DMAPOOL_ALL_BLOCKS_MASK \
+    ((DMAPOOL_BLOCK_COUNT == 32U) ? 0xFFFFFFFFU : ((1UL << DMAPOOL_BLOCK_COUNT) - 1U))
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** Start of the `.noncacheable` section, provided by the linker script. */
+extern uint8_t __snoncacheable[];
+/** End of the `.noncacheable` section, provided by the linker script. */
+extern uint8_t __enoncacheable[];
+
+/**
+ * @brief Pool storage, one cache-line aligned row per block.
+ */
+static uint8_t g_dmaPoolStorage[DMAPOOL_BLOCK_COUNT][DMAPOOL_BLOCK_SIZE]
+    __attribute__((section("noncacheable_buffer"), aligned(DMAPOOL_CACHE_LINE_SIZE)));
+
+/** Bitmap of allocated blocks, bit n set means block n is in use. */
+static volatile uint32_t g_dmaPoolUsedMask = 0U;
+
+/* Private Function Prototypes -----------------------------------------------*/
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Configure the MPU region for the pool and reset the bitmap.
+ *
+ * Any line of the section still held in the data cache is cleaned and
+ * invalidated first so no stale copy can be written back over DMA data
+ * once the region becomes non-cacheable.
+ *
+ * @retval true  Region configured.
+ * @retval false Section bounds are not cache-line aligned.
+ */
+bool DmaPool_Init(void)
+{
+    uint32_t base = (uint32_t)__snoncacheable;
+    uint32_t limit = (uint32_t)__enoncacheable;
+
+    if ((limit <= base) || (((base | limit) & (DMAPOOL_CACHE_LINE_SIZE - 1U)) != 0U))
+    {
+        return false;
+    }
+
+    SCB_CleanInvalidateDCache_by_Addr((void *)base, (int32_t)(limit - base));
+
+    ARM_MPU_Disable();
+    ARM_MPU_SetMemAttr(DMAPOOL_MPU_ATTR_IDX,
+                       ARM_MPU_ATTR(ARM_MPU_ATTR_NON_CACHEABLE, ARM_MPU_ATTR_NON_CACHEABLE));
+    ARM_MPU_SetRegion(DMAPOOL_MPU_REGION,
+                      ARM_MPU_RBAR(base, ARM_MPU_SH_NON, 0U, 1U, 1U),
+                      ARM_MPU_RLAR(limit - 1U, DMAPOOL_MPU_ATTR_IDX));
+    ARM_MPU_Enable(MPU_CTRL_PRIVDEFENA_Msk);
+
+    __atomic_store_n(&g_dmaPoolUsedMask, 0U, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief Allocate the lowest free block.
+ *
+ * @return Block pointer or NULL when every block is in use.
+ */
+void *DmaPool_Alloc(void)
+{
+    uint32_t used = __atomic_load_n(&g_dmaPoolUsedMask, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        uint32_t freeMask = ~used & DMAPOOL_ALL_BLOCKS_MASK;
+        if (freeMask == 0U)
+        {
+            return NULL;
+        }
+
+        uint32_t idx = (uint32_t)__builtin_ctz(freeMask);
+        /* On failure `used` is refreshed and the search restarts. */
+        if (__atomic_compare_exchange_n(&g_dmaPoolUsedMask,
+                                        &used,
+                                        used | (1UL << idx),
+                                        false,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+        {
+            return &g_dmaPoolStorage[idx][0];
+        }
+    }
+}
+
+/**
+ * @brief Release a block back to the pool.
+ *
+ * Pointers that do not address the start of a pool block are ignored.
+ *
+ * @param[in] block Block returned by ::DmaPool_Alloc.
+ */
+void DmaPool_Free(void *block)
+{
+    uintptr_t offset = (uintptr_t)block - (uintptr_t)&g_dmaPoolStorage[0][0];
+
+    if ((block == NULL) || (offset >= sizeof(g_dmaPoolStorage)) || ((offset % DMAPOOL_BLOCK_SIZE) != 0U))
+    {
+        return;
+    }
+
+    uint32_t idx = (uint32_t)(offset / DMAPOOL_BLOCK_SIZE);
+    __atomic_and_fetch(&g_dmaPoolUsedMask, ~(1UL << idx), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Report whether [ptr, ptr + size) is inside `.noncacheable`.
+ *
+ * @param[in] ptr  Start of the buffer.
+ * @param[in] size Length of the buffer in bytes.
+ *
+ * @return true if no cache maintenance is needed for DMA on this range.
+ */
+bool DmaPool_IsNonCacheable(const void *ptr, size_t size)
+{
+    uintptr_t start = (uintptr_t)ptr;
+    uintptr_t base = (uintptr_t)__snoncacheable;
+    uintptr_t limit = (uintptr_t)__enoncacheable;
+
+    return (start >= base) && (start <= limit) && (size <= (limit - start));
+}
+
+/**
+ * @brief Count the blocks currently allocated.
+ *
+ * @return Number of set bits in the allocation bitmap.
+ */
+uint32_t DmaPool_GetUsedCount(void)
+{
+    return (uint32_t)__builtin_popcount(__atomic_load_n(&g_dmaPoolUsedMask, __ATOMIC_RELAXED));
+}
+
+/** @} */ // end of DmaPool group
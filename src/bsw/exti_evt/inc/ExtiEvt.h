@@ -0,0 +1,158 @@
+/**
+ * @file ExtiEvt.h
+ * @brief Timestamped GPIO edge events on EXTI lines 0 to 15, debounced and dispatched from a task
+ *
+ * Each registered line takes its edges through its own EXTIn interrupt.
+ * The handler does as little as possible: it reads the cycle counter
+ * first, clears the pending flags of the line, stores one event of the
+ * edge direction and its time in a ring, and wakes the dispatch task
+ * only if no wake-up is already on its way. A burst of edges on several
+ * lines thus costs a single task switch.
+ *
+ * The vectors point straight at the handler through
+ * ::IsrMgr_RegisterDirect rather than at the IsrMgr dispatcher, which
+ * would read IPSR, look up the line and sample its accounting before the
+ * stamp. A stamp trails its edge by the EXTI input synchroniser and the
+ * exception entry only; the lines do not show in the IsrMgr statistics.
+ *
+ * The dispatch task turns the 32-bit cycle stamps into the 64-bit time
+ * base of ::ExtiEvt_Now, debounces each line and calls its callback in
+ * task context, in the order the edges arrived.
+ *
+ * Debouncing locks a line out after each edge it reports: the first edge
+ * is reported at once with its own time, the edges that follow within
+ * the debounce window are counted as bounces and dropped. When the
+ * window closes on a line taking both edges and the bounces left the
+ * pin at the other level, that level is reported too, stamped with the
+ * time of the last bounce.
+ */
+
+#ifndef EXTI_EVT_H
+#define EXTI_EVT_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef EXTIEVT_RING_LEN
+#define EXTIEVT_RING_LEN (64U) /**< Edges waiting for the task, a power of two */
+#endif
+
+#ifndef EXTIEVT_TASK_STACK_SIZE
+#define EXTIEVT_TASK_STACK_SIZE (256U) /**< Stack of the dispatch task, in words */
+#endif
+
+#define EXTIEVT_LINES (16U)       /**< GPIO lines, one per pin number */
+#define EXTIEVT_NOTIFY_INDEX (0U) /**< Task notification index of the dispatch task */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Edges a line reacts to.
+ */
+typedef enum
+{
+    EXTIEVT_RISING = 1,  /**< Low to high */
+    EXTIEVT_FALLING = 2, /**< High to low */
+    EXTIEVT_BOTH = 3,    /**< Either */
+} ExtiEvt_Edges_T;
+
+/**
+ * @brief One reported edge.
+ */
+typedef struct
+{
+    uint64_t cycles; /**< Time of the edge on the ::ExtiEvt_Now time base */
+    uint8_t line;    /**< Line, the pin number */
+    bool rising;     /**< Low to high */
+    bool settled;    /**< Level found at the end of a debounce window rather than an edge taken on its own */
+} ExtiEvt_Event_T;
+
+/**
+ * @brief Edge callback.
+ *
+ * Runs in the dispatch task; it may block, delaying the edges behind it.
+ *
+ * @param[in] ctx   Context given at registration.
+ * @param[in] event The edge, only valid during the call.
+ */
+typedef void (*ExtiEvt_Callback_T)(void *ctx, const ExtiEvt_Event_T *event);
+
+/**
+ * @brief Line settings.
+ */
+typedef struct
+{
+    GPIO_TypeDef *port;          /**< Port of the pin; one port per line number */
+    uint8_t pin;                 /**< Pin number, which is the line */
+    ExtiEvt_Edges_T edges;       /**< Edges reported */
+    uint32_t pull;               /**< LL_GPIO_PULL_NO, LL_GPIO_PULL_UP or LL_GPIO_PULL_DOWN */
+    uint32_t debounce_us;        /**< Lockout after a reported edge, 0 reports every edge */
+    ExtiEvt_Callback_T callback; /**< Called for each reported edge */
+    void *ctx;                   /**< Passed unchanged to @ref callback */
+} ExtiEvt_Config_T;
+
+/**
+ * @brief Service counters.
+ */
+typedef struct
+{
+    uint32_t lines;      /**< Lines registered */
+    uint32_t events;     /**< Edges stored by the interrupt handlers */
+    uint32_t dispatched; /**< Callbacks made, settled levels included */
+    uint32_t settled;    /**< Levels reported at the end of a debounce window */
+    uint32_t bounces;    /**< Edges dropped inside a debounce window */
+    uint32_t overflows;  /**< Edges lost on a full ring */
+    uint32_t wakeups;    /**< Notifications sent to the dispatch task */
+    uint32_t ring_peak;  /**< Largest number of edges waiting */
+    uint32_t irqs;       /**< EXTI interrupts handled */
+} ExtiEvt_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Start the dispatch task.
+ *
+ * @retval true  Lines can be registered.
+ * @retval false The task could not be created.
+ */
+bool ExtiEvt_Init(void);
+
+/**
+ * @brief Make a pin an input and report its edges.
+ *
+ * The line is taken from the pin number and routed to the port; its
+ * edges are reported from the next one on.
+ *
+ * @retval true  The line is armed.
+ * @retval false Invalid settings, the line is taken, or its interrupt
+ *               could not be bound.
+ */
+bool ExtiEvt_Register(const ExtiEvt_Config_T *config);
+
+/**
+ * @brief Stop reporting the edges of a line and free it.
+ *
+ * Edges of the line still waiting in the ring are dropped.
+ */
+void ExtiEvt_Unregister(uint8_t line);
+
+/**
+ * @brief Current time on the 64-bit time base of the events.
+ *
+ * Counts core clock cycles; the cycle counter is extended with the
+ * kernel tick count, so its wraps are tracked without a periodic task.
+ * Callable from tasks only.
+ */
+uint64_t ExtiEvt_Now(void);
+
+/**
+ * @brief Copy the service counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void ExtiEvt_GetStatus(ExtiEvt_Status_T *status);
+
+#endif /* EXTI_EVT_H */
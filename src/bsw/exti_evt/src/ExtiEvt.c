@@ -0,0 +1,539 @@
+/**
+ * @file ExtiEvt.c
+ * @brief Implementation of the timestamped EXTI edge service.
+ * @ingroup ExtiEvt
+ * @{
+ *
+ * Every line has its own EXTIn vector, pointed straight at the handler
+ * rather than through the IsrMgr dispatcher, and all of them share one NVIC
+ * priority, so the handlers never preempt each other and the ring has a
+ * single producer at a time: the handler fills the slot at the head and
+ * then publishes the new head, the task frees a slot by moving the tail
+ * once it has copied it. Neither side needs a lock.
+ *
+ * The wake-up is coalesced through a flag the handler sets with an
+ * atomic exchange; only the handler that finds it clear notifies the
+ * task, and the task clears it before draining, so an edge stored after
+ * the drain started always brings a new notification.
+ *
+ * Edges are stamped with the 32-bit cycle counter. The task reads the
+ * head before the clock, so every edge it drains is older than the time
+ * it extends them against, by less than one counter period.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ExtiEvt.h"
+#include <stddef.h>
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_exti.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define EXTIEVT_RING_MASK (EXTIEVT_RING_LEN - 1U) /**< Slot index of a ring position */
+#define EXTIEVT_HALF_WRAP (0x80000000ULL)         /**< Half a cycle counter period */
+#define EXTIEVT_NO_LOCKOUT (UINT64_MAX)           /**< No line is locked out */
+
+#if ((EXTIEVT_RING_LEN & (EXTIEVT_RING_LEN - 1U)) != 0U)
+#error "EXTIEVT_RING_LEN must be a power of two"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Edge as stored by the interrupt handler.
+ */
+typedef struct
+{
+    uint32_t cycles; /**< Cycle counter at handler entry */
+    uint8_t line;    /**< Line */
+    uint8_t rising;  /**< Low to high */
+} ExtiEvt_Slot_T;
+
+/**
+ * @brief State of a registered line.
+ *
+ * Owned by the dispatch task once registered, except @ref used and
+ * @ref config which change under a critical section.
+ */
+typedef struct
+{
+    bool used;               /**< Registered */
+    ExtiEvt_Config_T config; /**< Settings */
+    uint64_t debounce;       /**< Lockout length in cycles */
+    bool level;              /**< Level after the last reported edge */
+    bool locked;             /**< Inside a debounce window */
+    uint64_t lockoutEnd;     /**< End of the window */
+    uint32_t bounces;        /**< Edges dropped in the window */
+    uint64_t lastAt;         /**< Time of the last dropped edge */
+    bool lastRising;         /**< Direction of the last dropped edge */
+} ExtiEvt_Line_T;
+
+/**
+ * @brief Last reading of the 64-bit time base.
+ */
+typedef struct
+{
+    uint64_t cycles;  /**< Extended count */
+    uint32_t counter; /**< Cycle counter it was read from */
+    TickType_t tick;  /**< Kernel tick count at the same moment */
+} ExtiEvt_Clock_T;
+
+/**
+ * @brief EXTI port selection of a GPIO port.
+ */
+typedef struct
+{
+    uintptr_t base;  /**< GPIO port address */
+    uint32_t source; /**< LL_EXTI_EXTI_PORTx */
+} ExtiEvt_Port_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Ports the EXTI multiplexer can route. */
+static const ExtiEvt_Port_T g_extiEvtPorts[] = {
+    {GPIOA_BASE, LL_EXTI_EXTI_PORTA}, {GPIOB_BASE, LL_EXTI_EXTI_PORTB}, {GPIOC_BASE, LL_EXTI_EXTI_PORTC},
+    {GPIOD_BASE, LL_EXTI_EXTI_PORTD}, {GPIOE_BASE, LL_EXTI_EXTI_PORTE}, {GPIOF_BASE, LL_EXTI_EXTI_PORTF},
+    {GPIOG_BASE, LL_EXTI_EXTI_PORTG}, {GPIOH_BASE, LL_EXTI_EXTI_PORTH}, {GPION_BASE, LL_EXTI_EXTI_PORTN},
+    {GPIOO_BASE, LL_EXTI_EXTI_PORTO}, {GPIOP_BASE, LL_EXTI_EXTI_PORTP}, {GPIOQ_BASE, LL_EXTI_EXTI_PORTQ},
+};
+/** EXTICR field of each line. */
+static const uint32_t g_extiEvtSourceLines[EXTIEVT_LINES] = {
+    LL_EXTI_EXTI_LINE0,  LL_EXTI_EXTI_LINE1,  LL_EXTI_EXTI_LINE2,  LL_EXTI_EXTI_LINE3,
+    LL_EXTI_EXTI_LINE4,  LL_EXTI_EXTI_LINE5,  LL_EXTI_EXTI_LINE6,  LL_EXTI_EXTI_LINE7,
+    LL_EXTI_EXTI_LINE8,  LL_EXTI_EXTI_LINE9,  LL_EXTI_EXTI_LINE10, LL_EXTI_EXTI_LINE11,
+    LL_EXTI_EXTI_LINE12, LL_EXTI_EXTI_LINE13, LL_EXTI_EXTI_LINE14, LL_EXTI_EXTI_LINE15,
+};
+/** Edges waiting for the task. */
+static ExtiEvt_Slot_T g_extiEvtRing[EXTIEVT_RING_LEN];
+/** Next position written by the handlers. */
+static uint32_t g_extiEvtHead = 0U;
+/** Next position read by the task. */
+static uint32_t g_extiEvtTail = 0U;
+/** A notification is on its way to the task. */
+static bool g_extiEvtWakePending = false;
+/** Lines by number. */
+static ExtiEvt_Line_T g_extiEvtLines[EXTIEVT_LINES];
+/** Time base of the events. */
+static ExtiEvt_Clock_T g_extiEvtClock = {0};
+/** Core clock cycles per kernel tick. */
+static uint32_t g_extiEvtCyclesPerTick = 0U;
+/** Dispatch task. */
+static TaskHandle_t g_extiEvtTask = NULL;
+/** Counters reported by ::ExtiEvt_GetStatus. */
+static ExtiEvt_Status_T g_extiEvtStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Settings are acceptable; gives the EXTI port selection. */
+static bool ExtiEvt_IsValid(const ExtiEvt_Config_T *config, uint32_t *source);
+/** Make the pin an input. */
+static void ExtiEvt_InitPin(const ExtiEvt_Config_T *config);
+/** Store one edge in the ring. */
+static inline void ExtiEvt_Push(uint32_t cycles, uint32_t line, bool rising);
+/** Drain the ring and debounce, forever. */
+static void ExtiEvt_Task(void *argument);
+/** Debounce one edge and report it. */
+static void ExtiEvt_Edge(uint32_t line, uint64_t at, bool rising);
+/** Close the debounce windows ended by @p at; gives the end of the next one. */
+static uint64_t ExtiEvt_Expire(uint64_t at);
+/** Call the callback of a line. */
+static void ExtiEvt_Dispatch(ExtiEvt_Line_T *l, uint32_t line, uint64_t at, bool rising, bool settled);
+/** Ticks to wait until @p end. */
+static TickType_t ExtiEvt_WaitTicks(uint64_t now, uint64_t end);
+/** EXTIn interrupt, the vector of every registered line. */
+static void ExtiEvt_IrqHandler(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start the time base and the dispatch task.
+ */
+bool ExtiEvt_Init(void)
+{
+    g_extiEvtCyclesPerTick = SystemCoreClock / configTICK_RATE_HZ;
+    g_extiEvtClock.counter = DWT->CYCCNT;
+    g_extiEvtClock.cycles = g_extiEvtClock.counter;
+    g_extiEvtClock.tick = xTaskGetTickCount();
+
+    return xTaskCreate(ExtiEvt_Task, "ExtiEvt", EXTIEVT_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                       &g_extiEvtTask) == pdPASS;
+}
+
+/**
+ * @brief Make a pin an input, route it to its line and arm the line.
+ *
+ * The pending flags are cleared after the pin is configured, so setting
+ * up the pull cannot report an edge.
+ */
+bool ExtiEvt_Register(const ExtiEvt_Config_T *config)
+{
+    uint32_t source = 0U;
+    if ((g_extiEvtTask == NULL) || !ExtiEvt_IsValid(config, &source))
+    {
+        return false;
+    }
+
+    uint32_t line = config->pin;
+    uint32_t mask = 1UL << line;
+    IRQn_Type irq = (IRQn_Type)((int32_t)EXTI0_IRQn + (int32_t)line);
+    ExtiEvt_Line_T *l = &g_extiEvtLines[line];
+
+    taskENTER_CRITICAL();
+    bool taken = l->used;
+    if (!taken)
+    {
+        l->used = true;
+        l->config = *config;
+        l->debounce = (uint64_t)config->debounce_us * (SystemCoreClock / 1000000U);
+        l->locked = false;
+        l->bounces = 0U;
+    }
+    taskEXIT_CRITICAL();
+    if (taken)
+    {
+        return false;
+    }
+
+    ExtiEvt_InitPin(config);
+    l->level = (LL_GPIO_IsInputPinSet(config->port, mask) != 0U);
+    if (!IsrMgr_RegisterDirect(irq, ExtiEvt_IrqHandler))
+    {
+        l->used = false;
+        return false;
+    }
+
+    LL_EXTI_SetEXTISource(source, g_extiEvtSourceLines[line]);
+    LL_EXTI_ClearRisingFlag_0_31(mask);
+    LL_EXTI_ClearFallingFlag_0_31(mask);
+    LL_EXTI_InitTypeDef exti_h;
+    exti_h.Line_0_31 = mask;
+    exti_h.Line_32_63 = LL_EXTI_LINE_NONE;
+    exti_h.Line_64_95 = LL_EXTI_LINE_NONE;
+    exti_h.LineCommand = ENABLE;
+    exti_h.Mode = LL_EXTI_MODE_IT;
+    exti_h.Trigger = (config->edges == EXTIEVT_RISING)    ? LL_EXTI_TRIGGER_RISING
+                     : (config->edges == EXTIEVT_FALLING) ? LL_EXTI_TRIGGER_FALLING
+                                                          : LL_EXTI_TRIGGER_RISING_FALLING;
+    (void)LL_EXTI_Init(&exti_h);
+
+    /* One priority for every line, so the handlers never nest */
+    NVIC_SetPriority(irq,
+                     NVIC_EncodePriority(NVIC_GetPriorityGrouping(), configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_ClearPendingIRQ(irq);
+    NVIC_EnableIRQ(irq);
+
+    taskENTER_CRITICAL();
+    g_extiEvtStatus.lines++;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+/**
+ * @brief Disarm a line, unbind its interrupt and free it.
+ */
+void ExtiEvt_Unregister(uint8_t line)
+{
+    if ((line >= EXTIEVT_LINES) || !g_extiEvtLines[line].used)
+    {
+        return;
+    }
+
+    uint32_t mask = 1UL << line;
+    IRQn_Type irq = (IRQn_Type)((int32_t)EXTI0_IRQn + (int32_t)line);
+    LL_EXTI_DisableIT_0_31(mask);
+    LL_EXTI_DisableRisingTrig_0_31(mask);
+    LL_EXTI_DisableFallingTrig_0_31(mask);
+    NVIC_DisableIRQ(irq);
+    IsrMgr_Unregister(irq);
+    LL_EXTI_ClearRisingFlag_0_31(mask);
+    LL_EXTI_ClearFallingFlag_0_31(mask);
+    NVIC_ClearPendingIRQ(irq);
+
+    taskENTER_CRITICAL();
+    g_extiEvtLines[line].used = false;
+    g_extiEvtStatus.lines--;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Extend the cycle counter to 64 bits.
+ *
+ * The low 32 bits come from the counter itself; the tick count elapsed
+ * since the previous reading says how many times it wrapped in between,
+ * as it is accurate to far better than half a counter period.
+ */
+uint64_t ExtiEvt_Now(void)
+{
+    taskENTER_CRITICAL();
+    uint32_t counter = DWT->CYCCNT;
+    TickType_t tick = xTaskGetTickCount();
+    uint32_t delta = counter - g_extiEvtClock.counter;
+    uint64_t expected = (uint64_t)(TickType_t)(tick - g_extiEvtClock.tick) * g_extiEvtCyclesPerTick;
+    uint64_t wraps = ((expected + EXTIEVT_HALF_WRAP) > delta) ? ((expected + EXTIEVT_HALF_WRAP - delta) >> 32) : 0U;
+    g_extiEvtClock.cycles += (uint64_t)delta + (wraps << 32);
+    g_extiEvtClock.counter = counter;
+    g_extiEvtClock.tick = tick;
+    uint64_t now = g_extiEvtClock.cycles;
+    taskEXIT_CRITICAL();
+    return now;
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void ExtiEvt_GetStatus(ExtiEvt_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_extiEvtStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Settings are acceptable and the port can be routed to the EXTI.
+ */
+static bool ExtiEvt_IsValid(const ExtiEvt_Config_T *config, uint32_t *source)
+{
+    if ((config == NULL) || (config->port == NULL) || (config->pin >= EXTIEVT_LINES) ||
+        (config->callback == NULL) || ((config->edges & EXTIEVT_BOTH) == 0) || ((config->edges & ~EXTIEVT_BOTH) != 0))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < (sizeof(g_extiEvtPorts) / sizeof(g_extiEvtPorts[0])); i++)
+    {
+        if (g_extiEvtPorts[i].base == (uintptr_t)config->port)
+        {
+            *source = g_extiEvtPorts[i].source;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Clock the port and make the pin an input with the requested pull.
+ */
+static void ExtiEvt_InitPin(const ExtiEvt_Config_T *config)
+{
+    /* The enable bits of the GPIO ports follow their address order */
+    LL_AHB4_GRP1_EnableClock(1UL << (((uint32_t)(uintptr_t)config->port - GPIOA_BASE) / 0x400U));
+
+    LL_GPIO_InitTypeDef gpio_h;
+    gpio_h.Pin = 1UL << config->pin;
+    gpio_h.Mode = LL_GPIO_MODE_INPUT;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_LOW;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = config->pull;
+    gpio_h.Alternate = LL_GPIO_AF_0;
+    (void)LL_GPIO_Init(config->port, &gpio_h);
+}
+
+/**
+ * @brief Store one edge at the head of the ring, or count it lost.
+ */
+static inline void ExtiEvt_Push(uint32_t cycles, uint32_t line, bool rising)
+{
+    uint32_t head = g_extiEvtHead;
+    uint32_t level = head - __atomic_load_n(&g_extiEvtTail, __ATOMIC_ACQUIRE);
+    if (level >= EXTIEVT_RING_LEN)
+    {
+        g_extiEvtStatus.overflows++;
+        return;
+    }
+
+    ExtiEvt_Slot_T *slot = &g_extiEvtRing[head & EXTIEVT_RING_MASK];
+    slot->cycles = cycles;
+    slot->line = (uint8_t)line;
+    slot->rising = rising ? 1U : 0U;
+    __atomic_store_n(&g_extiEvtHead, head + 1U, __ATOMIC_RELEASE);
+    g_extiEvtStatus.events++;
+    if ((level + 1U) > g_extiEvtStatus.ring_peak)
+    {
+        g_extiEvtStatus.ring_peak = level + 1U;
+    }
+}
+
+/**
+ * @brief Drain the ring, debounce and report, then sleep until the next edge or window end.
+ */
+static void ExtiEvt_Task(void *argument)
+{
+    (void)argument;
+    TickType_t wait = portMAX_DELAY;
+
+    for (;;)
+    {
+        (void)ulTaskNotifyTakeIndexed(EXTIEVT_NOTIFY_INDEX, pdTRUE, wait);
+        /* Cleared before draining: an edge stored from now on sends a new wake-up */
+        __atomic_store_n(&g_extiEvtWakePending, false, __ATOMIC_SEQ_CST);
+
+        uint32_t head = __atomic_load_n(&g_extiEvtHead, __ATOMIC_ACQUIRE);
+        uint64_t now = ExtiEvt_Now();
+        for (uint32_t tail = g_extiEvtTail; tail != head; tail++)
+        {
+            ExtiEvt_Slot_T slot = g_extiEvtRing[tail & EXTIEVT_RING_MASK];
+            __atomic_store_n(&g_extiEvtTail, tail + 1U, __ATOMIC_RELEASE);
+            uint64_t at = now - (uint32_t)((uint32_t)now - slot.cycles);
+            (void)ExtiEvt_Expire(at);
+            ExtiEvt_Edge(slot.line, at, slot.rising != 0U);
+        }
+
+        now = ExtiEvt_Now();
+        wait = ExtiEvt_WaitTicks(now, ExtiEvt_Expire(now));
+    }
+}
+
+/**
+ * @brief Report an edge and open its debounce window, or count it as a bounce.
+ */
+static void ExtiEvt_Edge(uint32_t line, uint64_t at, bool rising)
+{
+    ExtiEvt_Line_T *l = &g_extiEvtLines[line];
+    if (!l->used)
+    {
+        return;
+    }
+
+    if (l->locked)
+    {
+        l->bounces++;
+        l->lastAt = at;
+        l->lastRising = rising;
+        g_extiEvtStatus.bounces++;
+        return;
+    }
+
+    l->level = rising;
+    if (l->debounce != 0U)
+    {
+        l->locked = true;
+        l->lockoutEnd = at + l->debounce;
+        l->bounces = 0U;
+    }
+    ExtiEvt_Dispatch(l, line, at, rising, false);
+}
+
+/**
+ * @brief Close every debounce window ended by @p at.
+ *
+ * A line taking both edges whose last bounce left it at the other level
+ * reports that level.
+ *
+ * @return End of the earliest window still open, ::EXTIEVT_NO_LOCKOUT if none.
+ */
+static uint64_t ExtiEvt_Expire(uint64_t at)
+{
+    uint64_t next = EXTIEVT_NO_LOCKOUT;
+
+    for (uint32_t line = 0U; line < EXTIEVT_LINES; line++)
+    {
+        ExtiEvt_Line_T *l = &g_extiEvtLines[line];
+        if (!l->used || !l->locked)
+        {
+            continue;
+        }
+        if (l->lockoutEnd > at)
+        {
+            next = (l->lockoutEnd < next) ? l->lockoutEnd : next;
+            continue;
+        }
+
+        l->locked = false;
+        if ((l->config.edges == EXTIEVT_BOTH) && (l->bounces != 0U) && (l->lastRising != l->level))
+        {
+            l->level = l->lastRising;
+            g_extiEvtStatus.settled++;
+            ExtiEvt_Dispatch(l, line, l->lastAt, l->lastRising, true);
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Call the callback of a line with one edge.
+ */
+static void ExtiEvt_Dispatch(ExtiEvt_Line_T *l, uint32_t line, uint64_t at, bool rising, bool settled)
+{
+    ExtiEvt_Event_T event = {
+        .cycles = at,
+        .line = (uint8_t)line,
+        .rising = rising,
+        .settled = settled,
+    };
+
+    g_extiEvtStatus.dispatched++;
+    l->config.callback(l->config.ctx, &event);
+}
+
+/**
+ * @brief Whole ticks from @p now until @p end, at least one.
+ */
+static TickType_t ExtiEvt_WaitTicks(uint64_t now, uint64_t end)
+{
+    if (end == EXTIEVT_NO_LOCKOUT)
+    {
+        return portMAX_DELAY;
+    }
+
+    uint64_t ticks = (end > now) ? (((end - now) + g_extiEvtCyclesPerTick - 1U) / g_extiEvtCyclesPerTick) : 1U;
+    return (ticks < (uint64_t)portMAX_DELAY) ? (TickType_t)((ticks != 0U) ? ticks : 1U) : (portMAX_DELAY - 1U);
+}
+
+/**
+ * @brief EXTIn interrupt: stamp, clear, store and wake.
+ *
+ * Installed straight in the vector table, so the stamp is the first read
+ * after exception entry; the line comes from the active exception number.
+ * Both flags set means the pin went both ways since the last entry; its
+ * present level tells which edge came last.
+ */
+static void ExtiEvt_IrqHandler(void)
+{
+    uint32_t cycles = DWT->CYCCNT;
+    uint32_t line = __get_IPSR() - ISRMGR_EXC_OFFSET - (uint32_t)EXTI0_IRQn;
+    uint32_t mask = 1UL << line;
+
+    bool rising = (LL_EXTI_ReadRisingFlag_0_31(mask) != 0U);
+    bool falling = (LL_EXTI_ReadFallingFlag_0_31(mask) != 0U);
+    if (rising)
+    {
+        LL_EXTI_ClearRisingFlag_0_31(mask);
+    }
+    if (falling)
+    {
+        LL_EXTI_ClearFallingFlag_0_31(mask);
+    }
+    g_extiEvtStatus.irqs++;
+
+    if (rising && falling)
+    {
+        bool high = (LL_GPIO_IsInputPinSet(g_extiEvtLines[line].config.port, mask) != 0U);
+        ExtiEvt_Push(cycles, line, !high);
+        ExtiEvt_Push(cycles, line, high);
+    }
+    else if (rising || falling)
+    {
+        ExtiEvt_Push(cycles, line, rising);
+    }
+    else
+    {
+        return;
+    }
+
+    if (!__atomic_exchange_n(&g_extiEvtWakePending, true, __ATOMIC_ACQ_REL))
+    {
+        BaseType_t woken = pdFALSE;
+        g_extiEvtStatus.wakeups++;
+        vTaskNotifyGiveIndexedFromISR(g_extiEvtTask, EXTIEVT_NOTIFY_INDEX, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/** @} */ // end of ExtiEvt group
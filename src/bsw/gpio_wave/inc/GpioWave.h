@@ -0,0 +1,167 @@
+/**
+ * @file GpioWave.h
+ * @brief DMA-timed GPIO waveforms played from precomputed BSRR words
+ *
+ * A waveform is described as a list of steps, each giving the level of
+ * every pin the waveform drives and how many timer periods it lasts.
+ * ::GpioWave_Compile turns the description into a buffer of 32-bit BSRR
+ * words, one per period: the first word of a step sets and resets the
+ * pins, the words holding it are zero and leave the port alone. Pins of
+ * the port outside the waveform are never touched.
+ *
+ * Each TIM3 update event requests one GPDMA1 transfer that writes the
+ * next word to the BSRR of the port, so the edges are paced by the timer
+ * with no CPU involvement and no jitter from interrupts. A playback runs
+ * the buffer once, or loops over it until ::GpioWave_Stop through a
+ * linked-list item that reloads the channel at the end of each lap,
+ * without a gap between laps.
+ *
+ * The compiler touches no hardware and can run anywhere, including
+ * before ::GpioWave_Init.
+ */
+
+#ifndef GPIO_WAVE_H
+#define GPIO_WAVE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef GPIOWAVE_MAX_HZ
+#define GPIOWAVE_MAX_HZ (10000000U) /**< Highest step rate, one DMA transfer per period */
+#endif
+
+#define GPIOWAVE_MAX_WORDS (0xFFFFU / 4U) /**< Words of one buffer, one DMA block */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief One step of a waveform.
+ */
+typedef struct
+{
+    uint16_t levels; /**< Level of each driven pin during the step, bit n for pin n */
+    uint32_t ticks;  /**< Timer periods the step lasts, at least 1 */
+} GpioWave_Step_T;
+
+/**
+ * @brief Waveform description.
+ */
+typedef struct
+{
+    uint16_t pins;                /**< Pins the waveform drives, bit n for pin n */
+    const GpioWave_Step_T *steps; /**< Steps in playing order */
+    uint32_t step_count;          /**< Entries in @ref steps */
+} GpioWave_Pattern_T;
+
+/**
+ * @brief Playback end callback.
+ *
+ * Runs from interrupt context once a single playback has written its
+ * last word, or when a DMA error stopped any playback. Not called by
+ * ::GpioWave_Stop.
+ *
+ * @param[in] ctx     Context given with the playback.
+ * @param[in] success Every word was written.
+ */
+typedef void (*GpioWave_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief Playback settings.
+ *
+ * The buffer must be 4-byte aligned and DMA-reachable, and stay untouched
+ * while it plays. Unless it lies in the non-cacheable pool it must start
+ * on a cache line and span whole lines; the driver cleans it.
+ */
+typedef struct
+{
+    GPIO_TypeDef *port;           /**< Port written */
+    uint16_t pins;                /**< Pins made push-pull outputs before the start */
+    const uint32_t *buffer;       /**< BSRR words from ::GpioWave_Compile */
+    uint32_t words;               /**< Words in @ref buffer, 1 to ::GPIOWAVE_MAX_WORDS */
+    uint32_t rate_hz;             /**< Words written per second, up to ::GPIOWAVE_MAX_HZ */
+    bool circular;                /**< Loop over the buffer until ::GpioWave_Stop */
+    GpioWave_Callback_T callback; /**< End callback, may be NULL */
+    void *ctx;                    /**< Passed unchanged to @ref callback */
+} GpioWave_Config_T;
+
+/**
+ * @brief Engine counters.
+ */
+typedef struct
+{
+    bool running;        /**< A playback is in progress */
+    bool circular;       /**< The last playback loops */
+    uint32_t actual_hz;  /**< Step rate of the last playback after rounding the timer period */
+    uint32_t starts;     /**< Playbacks started */
+    uint32_t completed;  /**< Single playbacks that wrote their last word */
+    uint32_t stopped;    /**< Playbacks ended by ::GpioWave_Stop */
+    uint32_t laps;       /**< Passes over the buffer finished by the DMA */
+    uint32_t dma_errors; /**< Playbacks ended by a DMA error */
+    uint32_t irqs;       /**< Channel interrupts handled */
+} GpioWave_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable TIM3 and take the DMA channel.
+ *
+ * @retval true  Ready for ::GpioWave_Start.
+ * @retval false No DMA channel or its interrupt could be taken.
+ */
+bool GpioWave_Init(void);
+
+/**
+ * @brief Words the compiled form of @p pattern takes.
+ *
+ * @return Sum of the step lengths, 0 for an invalid description.
+ */
+uint32_t GpioWave_Words(const GpioWave_Pattern_T *pattern);
+
+/**
+ * @brief Compile a waveform description into BSRR words.
+ *
+ * Levels outside @ref GpioWave_Pattern_T::pins are ignored.
+ *
+ * @param[in]  pattern Description: at least one step, no step of 0 ticks,
+ *                     at least one pin.
+ * @param[out] buf     Destination.
+ * @param[in]  size    Words available at @p buf.
+ *
+ * @return Words written, 0 for an invalid description or one that does not
+ *         fit in @p size words.
+ */
+uint32_t GpioWave_Compile(const GpioWave_Pattern_T *pattern, uint32_t *buf, uint32_t size);
+
+/**
+ * @brief Start playing a buffer.
+ *
+ * The first word is written one period after the call, then one word per
+ * period.
+ *
+ * @retval true  Playing.
+ * @retval false Invalid settings, a rate the timer cannot reach, or a
+ *               playback is already in progress.
+ */
+bool GpioWave_Start(const GpioWave_Config_T *config);
+
+/**
+ * @brief Stop the playback in progress; the pins keep their last level.
+ */
+void GpioWave_Stop(void);
+
+/**
+ * @brief A playback is in progress.
+ */
+bool GpioWave_IsRunning(void);
+
+/**
+ * @brief Copy the engine counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void GpioWave_GetStatus(GpioWave_Status_T *status);
+
+#endif /* GPIO_WAVE_H */
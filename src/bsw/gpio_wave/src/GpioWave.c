@@ -0,0 +1,463 @@
+/**
+ * @file GpioWave.c
+ * @brief Implementation of the DMA-timed GPIO waveform engine.
+ * @ingroup GpioWave
+ * @{
+ *
+ * TIM3 runs free with its update DMA request enabled; GPDMA1 serves each
+ * request with one word from the buffer to the BSRR of the port, the
+ * source incrementing and the destination fixed. A single playback is
+ * one block and the channel stops by itself after it; a circular one is
+ * the same block whose linked-list item reloads the length and the source
+ * address at its end, so the next lap starts on the next update.
+ *
+ * TC marks the end of every lap. It counts laps and ends a single
+ * playback, stopping the timer. DMA errors end any playback.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "GpioWave.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_tim.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+#include "FreeRTOSConfig.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define GPIOWAVE_TIM TIM3                  /**< Timer pacing the words */
+#define GPIOWAVE_TIM_MAX_ARR (0xFFFFU)     /**< TIM3 has a 16-bit counter */
+#define GPIOWAVE_TIM_MAX_PSC (0xFFFFU)     /**< Largest prescaler */
+#define GPIOWAVE_LLI_ALIGN (16U)           /**< Keeps the item inside one 64 KiB linked-list window */
+#define GPIOWAVE_LLI_UPDATE (LL_DMA_UPDATE_CBR1 | LL_DMA_UPDATE_CSAR | LL_DMA_UPDATE_CLLR) /**< Registers reloaded per lap */
+#define GPIOWAVE_DMA_ERRORS (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF) /**< Channel flags ending a playback */
+#define GPIOWAVE_SPIN_LIMIT (10000U)       /**< Polls of the channel before giving up on a suspend */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Linked-list item restarting the buffer after each lap.
+ *
+ * Words follow the register order of CLLR's update bits.
+ */
+typedef struct
+{
+    uint32_t cbr1;
+    uint32_t csar;
+    uint32_t cllr;
+} GpioWave_Lli_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Item looping the channel back to the start of the buffer. */
+static GpioWave_Lli_T g_gpioWaveLli __attribute__((section("noncacheable_buffer"), aligned(GPIOWAVE_LLI_ALIGN)));
+/** Channel writing the words. */
+static DmaAlloc_Channel_T g_gpioWaveChannel = {0};
+/** Settings of the running playback. */
+static GpioWave_Config_T g_gpioWaveConfig;
+/** A playback is in progress. */
+static volatile bool g_gpioWaveRunning = false;
+/** Counters reported by ::GpioWave_GetStatus. */
+static GpioWave_Status_T g_gpioWaveStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Take and configure the DMA channel. */
+static bool GpioWave_InitChannel(void);
+/** Settings are acceptable. */
+static bool GpioWave_IsValid(const GpioWave_Config_T *config);
+/** Kernel clock of TIM3. */
+static uint32_t GpioWave_TimerClock(void);
+/** Make the pins of the playback push-pull outputs. */
+static void GpioWave_InitPins(const GpioWave_Config_T *config);
+/** Arm the channel at the start of the buffer. */
+static void GpioWave_StartDma(void);
+/** Stop the timer and the channel. */
+static void GpioWave_Halt(void);
+/** Stop the channel. */
+static void GpioWave_ResetChannel(void);
+/** End the playback from the interrupt and report it. */
+static void GpioWave_Finish(bool success);
+/** DMA channel interrupt. */
+static void GpioWave_DmaIrqHandler(void *ctx);
+/** Register block of the channel. */
+static DMA_Channel_TypeDef *GpioWave_Regs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable TIM3 and take the DMA channel.
+ *
+ * TIM3 stays stopped; an update generated by software only reloads the
+ * prescaler and raises neither a flag nor a DMA request.
+ */
+bool GpioWave_Init(void)
+{
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM3);
+    if (!GpioWave_InitChannel())
+    {
+        return false;
+    }
+
+    LL_TIM_DisableCounter(GPIOWAVE_TIM);
+    LL_TIM_DisableDMAReq_UPDATE(GPIOWAVE_TIM);
+    LL_TIM_SetUpdateSource(GPIOWAVE_TIM, LL_TIM_UPDATESOURCE_COUNTER);
+    LL_TIM_SetPrescaler(GPIOWAVE_TIM, 0U);
+    return true;
+}
+
+/**
+ * @brief Words the compiled form of @p pattern takes.
+ */
+uint32_t GpioWave_Words(const GpioWave_Pattern_T *pattern)
+{
+    if ((pattern == NULL) || (pattern->steps == NULL) || (pattern->step_count == 0U) || (pattern->pins == 0U))
+    {
+        return 0U;
+    }
+
+    uint64_t words = 0U;
+    for (uint32_t i = 0U; i < pattern->step_count; i++)
+    {
+        if (pattern->steps[i].ticks == 0U)
+        {
+            return 0U;
+        }
+        words += pattern->steps[i].ticks;
+    }
+    return (words <= UINT32_MAX) ? (uint32_t)words : 0U;
+}
+
+/**
+ * @brief Compile a waveform description into BSRR words.
+ *
+ * The first word of a step carries the set bits in its low half and the
+ * reset bits in its high half; the words holding the step are zero.
+ */
+uint32_t GpioWave_Compile(const GpioWave_Pattern_T *pattern, uint32_t *buf, uint32_t size)
+{
+    uint32_t words = GpioWave_Words(pattern);
+    if ((words == 0U) || (buf == NULL) || (words > size))
+    {
+        return 0U;
+    }
+
+    uint32_t *out = buf;
+    for (uint32_t i = 0U; i < pattern->step_count; i++)
+    {
+        const GpioWave_Step_T *step = &pattern->steps[i];
+        uint32_t set = (uint32_t)(step->levels & pattern->pins);
+        uint32_t reset = (uint32_t)((uint16_t)~step->levels & pattern->pins);
+        *out++ = set | (reset << 16U);
+        for (uint32_t t = 1U; t < step->ticks; t++)
+        {
+            *out++ = 0U;
+        }
+    }
+    return words;
+}
+
+/**
+ * @brief Start playing a buffer.
+ *
+ * The timer period is split into a prescaler and a 16-bit reload so the
+ * slowest rates still land on the nearest whole number of timer clocks
+ * the prescaler allows.
+ */
+bool GpioWave_Start(const GpioWave_Config_T *config)
+{
+    if (g_gpioWaveRunning || !GpioWave_IsValid(config))
+    {
+        return false;
+    }
+
+    uint32_t timerHz = GpioWave_TimerClock();
+    uint32_t ticks = (timerHz + (config->rate_hz / 2U)) / config->rate_hz;
+    uint32_t psc = (ticks - 1U) / (GPIOWAVE_TIM_MAX_ARR + 1U);
+    if ((ticks < 2U) || (psc > GPIOWAVE_TIM_MAX_PSC))
+    {
+        return false;
+    }
+    uint32_t reload = (ticks + ((psc + 1U) / 2U)) / (psc + 1U);
+    if (reload < 2U)
+    {
+        return false;
+    }
+
+    g_gpioWaveConfig = *config;
+    GpioWave_InitPins(config);
+    uint32_t bytes = config->words * sizeof(uint32_t);
+    if (!DmaPool_IsNonCacheable(config->buffer, bytes))
+    {
+        SCB_CleanDCache_by_Addr((void *)(uintptr_t)config->buffer, (int32_t)bytes);
+    }
+
+    LL_TIM_DisableCounter(GPIOWAVE_TIM);
+    LL_TIM_DisableDMAReq_UPDATE(GPIOWAVE_TIM);
+    LL_TIM_SetPrescaler(GPIOWAVE_TIM, psc);
+    LL_TIM_SetAutoReload(GPIOWAVE_TIM, reload - 1U);
+    LL_TIM_GenerateEvent_UPDATE(GPIOWAVE_TIM);
+    LL_TIM_SetCounter(GPIOWAVE_TIM, 0U);
+
+    g_gpioWaveLli.cbr1 = bytes;
+    g_gpioWaveLli.csar = (uint32_t)config->buffer;
+    g_gpioWaveLli.cllr = config->circular ? (GPIOWAVE_LLI_UPDATE | ((uint32_t)&g_gpioWaveLli & DMA_CLLR_LA)) : 0U;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_gpioWaveStatus.circular = config->circular;
+    g_gpioWaveStatus.actual_hz = (uint32_t)(((uint64_t)timerHz + ((psc + 1U) * reload / 2U)) /
+                                            ((uint64_t)(psc + 1U) * reload));
+    g_gpioWaveStatus.starts++;
+    g_gpioWaveRunning = true;
+    GpioWave_StartDma();
+    LL_TIM_EnableDMAReq_UPDATE(GPIOWAVE_TIM);
+    LL_TIM_EnableCounter(GPIOWAVE_TIM);
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Stop the timer and the DMA.
+ */
+void GpioWave_Stop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_gpioWaveRunning)
+    {
+        g_gpioWaveRunning = false;
+        g_gpioWaveStatus.stopped++;
+        GpioWave_Halt();
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief A playback is in progress.
+ */
+bool GpioWave_IsRunning(void)
+{
+    return g_gpioWaveRunning;
+}
+
+/**
+ * @brief Copy the engine counters into @p status.
+ */
+void GpioWave_GetStatus(GpioWave_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_gpioWaveStatus;
+    status->running = g_gpioWaveRunning;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Take a linked-list channel for the playback and enable its interrupts.
+ *
+ * The channel is real-time class: a word served late moves its edge.
+ */
+static bool GpioWave_InitChannel(void)
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = DMAALLOC_CLASS_REALTIME,
+        .caps = DMAALLOC_CAP_LINKED_LIST,
+        .burst_bytes = 0U,
+        .owner = "GpioWave",
+        .handler = GpioWave_DmaIrqHandler,
+        .ctx = NULL,
+    };
+
+    if (!DmaAlloc_Request(&request, &g_gpioWaveChannel))
+    {
+        return false;
+    }
+
+    DMA_TypeDef *dma = g_gpioWaveChannel.instance;
+    uint32_t ch = g_gpioWaveChannel.channel;
+    LL_DMA_ConfigControl(dma, ch, g_gpioWaveChannel.priority | LL_DMA_LINK_ALLOCATED_PORT0 | LL_DMA_LSM_FULL_EXECUTION);
+    LL_DMA_SetLinkedListBaseAddr(dma, ch, (uint32_t)&g_gpioWaveLli);
+    LL_DMA_EnableIT_TC(dma, ch);
+    LL_DMA_EnableIT_DTE(dma, ch);
+    LL_DMA_EnableIT_ULE(dma, ch);
+    LL_DMA_EnableIT_USE(dma, ch);
+    NVIC_SetPriority(g_gpioWaveChannel.irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                                configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(g_gpioWaveChannel.irq);
+    return true;
+}
+
+/**
+ * @brief Settings are acceptable.
+ *
+ * Outside the non-cacheable pool the buffer must cover whole cache lines
+ * so cleaning it cannot write back anything else.
+ */
+static bool GpioWave_IsValid(const GpioWave_Config_T *config)
+{
+    if ((config == NULL) || (config->port == NULL) || (config->pins == 0U) || (config->buffer == NULL) ||
+        (config->words == 0U) || (config->words > GPIOWAVE_MAX_WORDS) || (config->rate_hz == 0U) ||
+        (config->rate_hz > GPIOWAVE_MAX_HZ) || (((uint32_t)config->buffer % sizeof(uint32_t)) != 0U))
+    {
+        return false;
+    }
+
+    uint32_t bytes = config->words * sizeof(uint32_t);
+    if (!DmaPool_IsNonCacheable(config->buffer, bytes) &&
+        ((((uint32_t)config->buffer % DMAPOOL_CACHE_LINE_SIZE) != 0U) || ((bytes % DMAPOOL_CACHE_LINE_SIZE) != 0U)))
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Kernel clock of TIM3: the system bus clock divided by the timer prescaler of the RCC.
+ */
+static uint32_t GpioWave_TimerClock(void)
+{
+    return LL_RCC_GetSystemClockFreq() / (1UL << LL_RCC_GetTIMPrescaler());
+}
+
+/**
+ * @brief Clock the port and make the pins of the playback push-pull outputs.
+ *
+ * The pins keep the level they had, the first word sets them.
+ */
+static void GpioWave_InitPins(const GpioWave_Config_T *config)
+{
+    /* The enable bits of the GPIO ports follow their address order */
+    LL_AHB4_GRP1_EnableClock(1UL << (((uint32_t)(uintptr_t)config->port - GPIOA_BASE) / 0x400U));
+
+    LL_GPIO_InitTypeDef gpio_h;
+    gpio_h.Pin = config->pins;
+    gpio_h.Mode = LL_GPIO_MODE_OUTPUT;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = LL_GPIO_PULL_NO;
+    gpio_h.Alternate = LL_GPIO_AF_0;
+    (void)LL_GPIO_Init(config->port, &gpio_h);
+}
+
+/**
+ * @brief Arm the channel for one block over the whole buffer, reloaded by ::g_gpioWaveLli when circular.
+ */
+static void GpioWave_StartDma(void)
+{
+    DMA_Channel_TypeDef *regs = GpioWave_Regs();
+
+    WRITE_REG(regs->CTR1, LL_DMA_SRC_DATAWIDTH_WORD | LL_DMA_SRC_INCREMENT | LL_DMA_DEST_DATAWIDTH_WORD);
+    WRITE_REG(regs->CTR2, LL_GPDMA1_REQUEST_TIM3_UP | LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_TCEM_BLK_TRANSFER);
+    WRITE_REG(regs->CBR1, g_gpioWaveLli.cbr1);
+    WRITE_REG(regs->CSAR, g_gpioWaveLli.csar);
+    WRITE_REG(regs->CDAR, (uint32_t)&g_gpioWaveConfig.port->BSRR);
+    WRITE_REG(regs->CLLR, g_gpioWaveLli.cllr);
+    DmaAlloc_NoteStart(&g_gpioWaveChannel, g_gpioWaveLli.cbr1);
+    __DMB();
+    LL_DMA_EnableChannel(g_gpioWaveChannel.instance, g_gpioWaveChannel.channel);
+}
+
+/**
+ * @brief Stop the timer, so no request is left pending, then the channel.
+ */
+static void GpioWave_Halt(void)
+{
+    LL_TIM_DisableCounter(GPIOWAVE_TIM);
+    LL_TIM_DisableDMAReq_UPDATE(GPIOWAVE_TIM);
+    GpioWave_ResetChannel();
+}
+
+/**
+ * @brief Stop the channel.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void GpioWave_ResetChannel(void)
+{
+    DMA_TypeDef *dma = g_gpioWaveChannel.instance;
+    uint32_t ch = g_gpioWaveChannel.channel;
+
+    if (LL_DMA_IsEnabledChannel(dma, ch) != 0U)
+    {
+        uint32_t spin = GPIOWAVE_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(dma, ch);
+        while ((LL_DMA_IsActiveFlag_SUSP(dma, ch) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(dma, ch);
+    DmaAlloc_NoteStop(&g_gpioWaveChannel);
+    WRITE_REG(GpioWave_Regs()->CFCR, DMA_CFCR_TCF | DMA_CFCR_HTF | DMA_CFCR_DTEF | DMA_CFCR_ULEF |
+                                         DMA_CFCR_USEF | DMA_CFCR_SUSPF | DMA_CFCR_TOF);
+}
+
+/**
+ * @brief End the playback from the interrupt and call its callback.
+ */
+static void GpioWave_Finish(bool success)
+{
+    g_gpioWaveRunning = false;
+    GpioWave_Halt();
+    if (g_gpioWaveConfig.callback != NULL)
+    {
+        g_gpioWaveConfig.callback(g_gpioWaveConfig.ctx, success);
+    }
+}
+
+/**
+ * @brief DMA channel interrupt: a finished lap, or an error ending the playback.
+ *
+ * @param[in] ctx Unused.
+ */
+static void GpioWave_DmaIrqHandler(void *ctx)
+{
+    (void)ctx;
+    DMA_Channel_TypeDef *regs = GpioWave_Regs();
+    uint32_t csr = READ_REG(regs->CSR);
+
+    g_gpioWaveStatus.irqs++;
+    WRITE_REG(regs->CFCR, csr & (DMA_CSR_TCF | DMA_CSR_HTF | GPIOWAVE_DMA_ERRORS));
+    if (!g_gpioWaveRunning)
+    {
+        return;
+    }
+    if ((csr & GPIOWAVE_DMA_ERRORS) != 0U)
+    {
+        g_gpioWaveStatus.dma_errors++;
+        GpioWave_Finish(false);
+        return;
+    }
+
+    if ((csr & DMA_CSR_TCF) != 0U)
+    {
+        g_gpioWaveStatus.laps++;
+        if (!g_gpioWaveConfig.circular)
+        {
+            g_gpioWaveStatus.completed++;
+            GpioWave_Finish(true);
+        }
+    }
+}
+
+/**
+ * @brief Register block of the channel.
+ */
+static DMA_Channel_TypeDef *GpioWave_Regs(void)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)g_gpioWaveChannel.instance +
+                                   LL_DMA_CH_OFFSET_TAB[g_gpioWaveChannel.channel]);
+}
+
+/** @} */ // end of GpioWave group
@@ -0,0 +1,171 @@
+/**
+ * @file HrTimer.h
+ * @brief Microsecond one-shot and periodic timers on a 32-bit hardware timer
+ *
+ * TIM5 counts at ::HRTIMER_TICK_HZ without ever stopping. Pending timers
+ * are kept ordered by deadline and capture/compare channel 1 is programmed
+ * for the earliest one, so expiry does not wait for the next kernel tick.
+ * An expired timer runs its callback from the timer interrupt or sets
+ * notification bits of a task, or both.
+ *
+ * Deadlines are counter values and wrap with the counter; a timer may lie
+ * at most ::HRTIMER_MAX_DELAY_US ahead. The service measures how late
+ * every timer fires and reports it with ::HrTimer_GetStatus.
+ */
+
+#ifndef HR_TIMER_H
+#define HR_TIMER_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef HRTIMER_MAX_PENDING
+#define HRTIMER_MAX_PENDING (256U) /**< Timers that can be pending at once */
+#endif
+
+#ifndef HRTIMER_TICK_HZ
+#define HRTIMER_TICK_HZ (8000000U) /**< Counter rate, a whole number of ticks per microsecond */
+#endif
+
+#define HRTIMER_TICKS_PER_US (HRTIMER_TICK_HZ / 1000000U)            /**< Counter ticks in one microsecond */
+#define HRTIMER_MAX_DELAY_US (0x7FFFFFFFUL / HRTIMER_TICKS_PER_US)   /**< Longest delay or period */
+#define HRTIMER_LATE_BINS (8U)     /**< Lateness histogram bins: < 1, 2, 4 ... 64 us and beyond */
+#define HRTIMER_NOTIFY_INDEX (0U)  /**< Task notification index set when a timer fires */
+
+/** Convert microseconds to counter ticks. */
+#define HRTIMER_US_TO_TICKS(us) ((uint32_t)(us) * HRTIMER_TICKS_PER_US)
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Expiry callback, run from the timer interrupt at
+ *        configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * It may start or stop any timer, including its own.
+ */
+typedef void (*HrTimer_Callback_T)(void *ctx);
+
+/**
+ * @brief One timer, owned by the caller and set up with ::HrTimer_Setup.
+ *
+ * The memory must stay valid while the timer is pending.
+ */
+typedef struct
+{
+    HrTimer_Callback_T callback; /**< Run on expiry, may be NULL */
+    void *ctx;                   /**< Argument of @ref callback */
+    TaskHandle_t task;           /**< Task notified on expiry, may be NULL */
+    uint32_t notify_bits;        /**< Bits set at ::HRTIMER_NOTIFY_INDEX of @ref task */
+    uint32_t deadline;           /**< Counter value it fires at, managed by the service */
+    uint32_t period;             /**< Reload in ticks, 0 for one-shot, managed by the service */
+    uint32_t slot;               /**< Position in the pending set plus one, 0 when idle */
+} HrTimer_T;
+
+/**
+ * @brief Service counters.
+ */
+typedef struct
+{
+    uint32_t started;                       /**< Timers armed */
+    uint32_t fired;                         /**< Expiries, each period of a periodic timer counted */
+    uint32_t stopped;                       /**< Pending timers stopped before firing */
+    uint32_t missed_periods;                /**< Periods skipped because a periodic timer fired too late */
+    uint32_t full;                          /**< Starts rejected because the pending set was full */
+    uint32_t pending;                       /**< Timers pending now */
+    uint32_t pending_peak;                  /**< Most timers pending at once */
+    uint32_t irqs;                          /**< Timer interrupts handled */
+    uint32_t late_max_ns;                   /**< Worst time from deadline to expiry handling */
+    uint32_t late_avg_ns;                   /**< Mean time from deadline to expiry handling */
+    uint32_t late_hist[HRTIMER_LATE_BINS];  /**< Expiries per lateness bin */
+    uint32_t tick_hz;                       /**< Counter rate actually programmed */
+} HrTimer_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Start TIM5 counting at ::HRTIMER_TICK_HZ and enable its interrupt.
+ *
+ * @retval true  Ready.
+ * @retval false The timer clock is not a multiple of ::HRTIMER_TICK_HZ or
+ *               the interrupt is taken.
+ */
+bool HrTimer_Init(void);
+
+/**
+ * @brief Current counter value.
+ *
+ * @return Ticks of 1 / ::HRTIMER_TICK_HZ, wrapping at 2^32.
+ */
+uint32_t HrTimer_Now(void);
+
+/**
+ * @brief Prepare a timer; it must not be pending.
+ *
+ * @param[out] timer       Timer to set up.
+ * @param[in]  callback    Run on expiry, may be NULL.
+ * @param[in]  ctx         Argument of @p callback.
+ * @param[in]  task        Task notified on expiry, may be NULL.
+ * @param[in]  notify_bits Bits set at ::HRTIMER_NOTIFY_INDEX of @p task.
+ */
+void HrTimer_Setup(HrTimer_T *timer, HrTimer_Callback_T callback, void *ctx, TaskHandle_t task,
+                   uint32_t notify_bits);
+
+/**
+ * @brief Arm a timer @p delay_us from now, restarting it if pending.
+ *
+ * Callable from tasks and from interrupts up to
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @param[in,out] timer     Timer prepared by ::HrTimer_Setup.
+ * @param[in]     delay_us  Time to the first expiry.
+ * @param[in]     period_us Time between later expiries, 0 for one-shot.
+ *
+ * @retval true  Armed.
+ * @retval false A time exceeds ::HRTIMER_MAX_DELAY_US or the pending set is full.
+ */
+bool HrTimer_Start(HrTimer_T *timer, uint32_t delay_us, uint32_t period_us);
+
+/**
+ * @brief Arm a timer at an absolute counter value, restarting it if pending.
+ *
+ * Chaining deadlines from an earlier one keeps a sequence free of drift.
+ * A deadline already passed fires at once.
+ *
+ * @param[in,out] timer     Timer prepared by ::HrTimer_Setup.
+ * @param[in]     deadline  Counter value of the first expiry, within
+ *                          ::HRTIMER_MAX_DELAY_US of ::HrTimer_Now.
+ * @param[in]     period_us Time between later expiries, 0 for one-shot.
+ *
+ * @retval true  Armed.
+ * @retval false The period exceeds ::HRTIMER_MAX_DELAY_US or the pending set is full.
+ */
+bool HrTimer_StartAt(HrTimer_T *timer, uint32_t deadline, uint32_t period_us);
+
+/**
+ * @brief Disarm a timer.
+ *
+ * @param[in,out] timer Timer to stop.
+ *
+ * @retval true  It was pending and will not fire.
+ * @retval false It was not pending.
+ */
+bool HrTimer_Stop(HrTimer_T *timer);
+
+/**
+ * @brief A timer is pending.
+ */
+bool HrTimer_IsPending(const HrTimer_T *timer);
+
+/**
+ * @brief Copy the service counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void HrTimer_GetStatus(HrTimer_Status_T *status);
+
+#endif /* HR_TIMER_H */
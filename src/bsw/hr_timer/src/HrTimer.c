@@ -0,0 +1,467 @@
+/**
+ * @file HrTimer.c
+ * @brief Implementation of the microsecond timer service.
+ * @ingroup HrTimer
+ * @{
+ *
+ * Pending timers sit in a binary min-heap keyed by deadline, compared
+ * relative to each other so the order survives counter wrap; every timer
+ * remembers its heap position, which makes start, stop and expiry
+ * O(log n). CCR1 always holds the deadline of the heap root.
+ *
+ * A deadline can pass while it is being programmed. After writing CCR1
+ * the counter is read again and, if the deadline is no longer ahead, the
+ * interrupt is forced with a capture/compare event instead of waiting a
+ * full counter lap for the match.
+ *
+ * The interrupt handler fires every timer whose deadline has passed,
+ * re-reading the counter for each one. Callbacks run with the heap
+ * unlocked, so they can start and stop timers themselves.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "HrTimer.h"
+#include <stddef.h>
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_tim.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define HRTIMER_TIM TIM5        /**< 32-bit timer used */
+#define HRTIMER_IRQ TIM5_IRQn   /**< Its interrupt */
+
+#if ((HRTIMER_TICK_HZ % 1000000U) != 0U) || (HRTIMER_TICK_HZ == 0U)
+#error "HRTIMER_TICK_HZ must be a whole number of MHz"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** Pending timers, heap ordered by deadline. */
+static HrTimer_T *g_hrTimerHeap[HRTIMER_MAX_PENDING];
+/** Entries used in ::g_hrTimerHeap. */
+static uint32_t g_hrTimerCount = 0U;
+/** Sum of the lateness of every expiry, in ticks. */
+static uint64_t g_hrTimerLateSum = 0U;
+/** Counters reported by ::HrTimer_GetStatus. */
+static HrTimer_Status_T g_hrTimerStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** @p a is due before @p b. */
+static bool HrTimer_Before(uint32_t a, uint32_t b);
+/** Put @p timer at heap position @p pos. */
+static void HrTimer_Place(HrTimer_T *timer, uint32_t pos);
+/** Move the entry at @p pos towards the root while it is earlier than its parent. */
+static void HrTimer_SiftUp(uint32_t pos);
+/** Move the entry at @p pos towards the leaves while a child is earlier. */
+static void HrTimer_SiftDown(uint32_t pos);
+/** Add a timer to the heap. */
+static bool HrTimer_Insert(HrTimer_T *timer);
+/** Remove a pending timer from the heap. */
+static void HrTimer_Remove(HrTimer_T *timer);
+/** Program the compare for the earliest deadline. */
+static void HrTimer_Arm(void);
+/** Account for an expiry handled @p late ticks after its deadline. */
+static void HrTimer_NoteLate(uint32_t late);
+/** Compare interrupt: fire every timer due. */
+static void HrTimer_IrqHandler(void *ctx);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start TIM5 counting at ::HRTIMER_TICK_HZ and enable its interrupt.
+ *
+ * The kernel clock is the system bus clock divided by the timer
+ * prescaler of the RCC; the counter runs free over the full 32 bits and
+ * channel 1 stays in frozen output compare mode, used for its match flag
+ * only.
+ */
+bool HrTimer_Init(void)
+{
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_TIM5);
+    uint32_t timerHz = LL_RCC_GetSystemClockFreq() / (1UL << LL_RCC_GetTIMPrescaler());
+    if ((timerHz < HRTIMER_TICK_HZ) || ((timerHz % HRTIMER_TICK_HZ) != 0U) ||
+        ((timerHz / HRTIMER_TICK_HZ) > 0x10000U))
+    {
+        return false;
+    }
+
+    if (!IsrMgr_Register(HRTIMER_IRQ, HrTimer_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    LL_TIM_InitTypeDef init;
+    LL_TIM_StructInit(&init);
+    init.Prescaler = (uint16_t)((timerHz / HRTIMER_TICK_HZ) - 1U);
+    init.Autoreload = 0xFFFFFFFFUL;
+    LL_TIM_DisableCounter(HRTIMER_TIM);
+    if (LL_TIM_Init(HRTIMER_TIM, &init) != SUCCESS)
+    {
+        return false;
+    }
+    LL_TIM_OC_SetMode(HRTIMER_TIM, LL_TIM_CHANNEL_CH1, LL_TIM_OCMODE_FROZEN);
+    LL_TIM_OC_DisablePreload(HRTIMER_TIM, LL_TIM_CHANNEL_CH1);
+    LL_TIM_ClearFlag_UPDATE(HRTIMER_TIM);
+    LL_TIM_ClearFlag_CC1(HRTIMER_TIM);
+    LL_TIM_EnableIT_CC1(HRTIMER_TIM);
+    g_hrTimerStatus.tick_hz = HRTIMER_TICK_HZ;
+
+    NVIC_SetPriority(HRTIMER_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                      configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(HRTIMER_IRQ);
+    LL_TIM_EnableCounter(HRTIMER_TIM);
+    return true;
+}
+
+/**
+ * @brief Current counter value.
+ */
+uint32_t HrTimer_Now(void)
+{
+    return LL_TIM_GetCounter(HRTIMER_TIM);
+}
+
+/**
+ * @brief Prepare a timer; it must not be pending.
+ */
+void HrTimer_Setup(HrTimer_T *timer, HrTimer_Callback_T callback, void *ctx, TaskHandle_t task,
+                   uint32_t notify_bits)
+{
+    if (timer == NULL)
+    {
+        return;
+    }
+
+    timer->callback = callback;
+    timer->ctx = ctx;
+    timer->task = task;
+    timer->notify_bits = notify_bits;
+    timer->deadline = 0U;
+    timer->period = 0U;
+    timer->slot = 0U;
+}
+
+/**
+ * @brief Arm a timer @p delay_us from now, restarting it if pending.
+ */
+bool HrTimer_Start(HrTimer_T *timer, uint32_t delay_us, uint32_t period_us)
+{
+    if (delay_us > HRTIMER_MAX_DELAY_US)
+    {
+        return false;
+    }
+    return HrTimer_StartAt(timer, HrTimer_Now() + HRTIMER_US_TO_TICKS(delay_us), period_us);
+}
+
+/**
+ * @brief Arm a timer at an absolute counter value, restarting it if pending.
+ */
+bool HrTimer_StartAt(HrTimer_T *timer, uint32_t deadline, uint32_t period_us)
+{
+    if ((timer == NULL) || (period_us > HRTIMER_MAX_DELAY_US))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (timer->slot != 0U)
+    {
+        HrTimer_Remove(timer);
+    }
+    timer->deadline = deadline;
+    timer->period = HRTIMER_US_TO_TICKS(period_us);
+    bool armed = HrTimer_Insert(timer);
+    if (armed)
+    {
+        g_hrTimerStatus.started++;
+        if (timer->slot == 1U)
+        {
+            HrTimer_Arm();
+        }
+    }
+    __set_PRIMASK(primask);
+    return armed;
+}
+
+/**
+ * @brief Disarm a timer.
+ *
+ * The compare keeps the old deadline when the root goes away; the match
+ * then finds nothing due and reprograms it.
+ */
+bool HrTimer_Stop(HrTimer_T *timer)
+{
+    if (timer == NULL)
+    {
+        return false;
+    }
+
+    bool pending = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (timer->slot != 0U)
+    {
+        HrTimer_Remove(timer);
+        g_hrTimerStatus.stopped++;
+        pending = true;
+    }
+    __set_PRIMASK(primask);
+    return pending;
+}
+
+/**
+ * @brief A timer is pending.
+ */
+bool HrTimer_IsPending(const HrTimer_T *timer)
+{
+    return (timer != NULL) && (timer->slot != 0U);
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void HrTimer_GetStatus(HrTimer_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_hrTimerStatus;
+    status->pending = g_hrTimerCount;
+    if (g_hrTimerStatus.fired != 0U)
+    {
+        status->late_avg_ns = (uint32_t)((g_hrTimerLateSum * 1000000000ULL) /
+                                         ((uint64_t)g_hrTimerStatus.fired * HRTIMER_TICK_HZ));
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Deadline @p a is due before @p b; both lie within half the counter range of each other.
+ */
+static bool HrTimer_Before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/**
+ * @brief Put @p timer at heap position @p pos and record it in the timer.
+ */
+static void HrTimer_Place(HrTimer_T *timer, uint32_t pos)
+{
+    g_hrTimerHeap[pos] = timer;
+    timer->slot = pos + 1U;
+}
+
+/**
+ * @brief Move the entry at @p pos towards the root while it is earlier than its parent.
+ */
+static void HrTimer_SiftUp(uint32_t pos)
+{
+    HrTimer_T *timer = g_hrTimerHeap[pos];
+
+    while (pos > 0U)
+    {
+        uint32_t parent = (pos - 1U) / 2U;
+        if (!HrTimer_Before(timer->deadline, g_hrTimerHeap[parent]->deadline))
+        {
+            break;
+        }
+        HrTimer_Place(g_hrTimerHeap[parent], pos);
+        pos = parent;
+    }
+    HrTimer_Place(timer, pos);
+}
+
+/**
+ * @brief Move the entry at @p pos towards the leaves while a child is earlier.
+ */
+static void HrTimer_SiftDown(uint32_t pos)
+{
+    HrTimer_T *timer = g_hrTimerHeap[pos];
+
+    for (;;)
+    {
+        uint32_t child = (2U * pos) + 1U;
+        if (child >= g_hrTimerCount)
+        {
+            break;
+        }
+        if (((child + 1U) < g_hrTimerCount) &&
+            HrTimer_Before(g_hrTimerHeap[child + 1U]->deadline, g_hrTimerHeap[child]->deadline))
+        {
+            child++;
+        }
+        if (!HrTimer_Before(g_hrTimerHeap[child]->deadline, timer->deadline))
+        {
+            break;
+        }
+        HrTimer_Place(g_hrTimerHeap[child], pos);
+        pos = child;
+    }
+    HrTimer_Place(timer, pos);
+}
+
+/**
+ * @brief Add a timer to the heap; called with interrupts masked.
+ *
+ * @retval true  Added.
+ * @retval false The heap is full.
+ */
+static bool HrTimer_Insert(HrTimer_T *timer)
+{
+    if (g_hrTimerCount >= HRTIMER_MAX_PENDING)
+    {
+        g_hrTimerStatus.full++;
+        return false;
+    }
+
+    g_hrTimerHeap[g_hrTimerCount] = timer;
+    g_hrTimerCount++;
+    HrTimer_SiftUp(g_hrTimerCount - 1U);
+    if (g_hrTimerCount > g_hrTimerStatus.pending_peak)
+    {
+        g_hrTimerStatus.pending_peak = g_hrTimerCount;
+    }
+    return true;
+}
+
+/**
+ * @brief Remove a pending timer from the heap; called with interrupts masked.
+ *
+ * The last entry fills the hole and moves whichever way restores the order.
+ */
+static void HrTimer_Remove(HrTimer_T *timer)
+{
+    uint32_t pos = timer->slot - 1U;
+
+    timer->slot = 0U;
+    g_hrTimerCount--;
+    if (pos == g_hrTimerCount)
+    {
+        return;
+    }
+
+    HrTimer_Place(g_hrTimerHeap[g_hrTimerCount], pos);
+    if ((pos > 0U) && HrTimer_Before(g_hrTimerHeap[pos]->deadline, g_hrTimerHeap[(pos - 1U) / 2U]->deadline))
+    {
+        HrTimer_SiftUp(pos);
+    }
+    else
+    {
+        HrTimer_SiftDown(pos);
+    }
+}
+
+/**
+ * @brief Program the compare for the earliest deadline; called with interrupts masked.
+ *
+ * A deadline not ahead of the counter once CCR1 is written may have
+ * been passed before the match could see it, so the compare event is
+ * generated by software.
+ */
+static void HrTimer_Arm(void)
+{
+    if (g_hrTimerCount == 0U)
+    {
+        return;
+    }
+
+    uint32_t deadline = g_hrTimerHeap[0]->deadline;
+    LL_TIM_OC_SetCompareCH1(HRTIMER_TIM, deadline);
+    if (!HrTimer_Before(LL_TIM_GetCounter(HRTIMER_TIM), deadline))
+    {
+        LL_TIM_GenerateEvent_CC1(HRTIMER_TIM);
+    }
+}
+
+/**
+ * @brief Account for an expiry handled @p late ticks after its deadline.
+ */
+static void HrTimer_NoteLate(uint32_t late)
+{
+    uint32_t lateNs = (uint32_t)(((uint64_t)late * 1000000000ULL) / HRTIMER_TICK_HZ);
+    uint32_t bin = 0U;
+
+    for (uint32_t limit = HRTIMER_TICKS_PER_US; (late >= limit) && (bin < (HRTIMER_LATE_BINS - 1U)); limit *= 2U)
+    {
+        bin++;
+    }
+    g_hrTimerStatus.late_hist[bin]++;
+    g_hrTimerStatus.fired++;
+    g_hrTimerLateSum += late;
+    if (lateNs > g_hrTimerStatus.late_max_ns)
+    {
+        g_hrTimerStatus.late_max_ns = lateNs;
+    }
+}
+
+/**
+ * @brief Compare interrupt: fire every timer due, then program the next deadline.
+ *
+ * A periodic timer is re-armed from its previous deadline before its
+ * callback runs; periods that have already gone by are skipped and
+ * counted rather than fired in a burst.
+ */
+static void HrTimer_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    BaseType_t woken = pdFALSE;
+
+    LL_TIM_ClearFlag_CC1(HRTIMER_TIM);
+    g_hrTimerStatus.irqs++;
+
+    for (;;)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t now = LL_TIM_GetCounter(HRTIMER_TIM);
+        HrTimer_T *timer = (g_hrTimerCount != 0U) ? g_hrTimerHeap[0] : NULL;
+        if ((timer == NULL) || HrTimer_Before(now, timer->deadline))
+        {
+            HrTimer_Arm();
+            __set_PRIMASK(primask);
+            break;
+        }
+
+        HrTimer_Remove(timer);
+        HrTimer_NoteLate(now - timer->deadline);
+        HrTimer_Callback_T callback = timer->callback;
+        void *cbCtx = timer->ctx;
+        TaskHandle_t task = timer->task;
+        uint32_t bits = timer->notify_bits;
+        if (timer->period != 0U)
+        {
+            uint32_t next = timer->deadline + timer->period;
+            if (!HrTimer_Before(now, next))
+            {
+                uint32_t missed = ((now - next) / timer->period) + 1U;
+                g_hrTimerStatus.missed_periods += missed;
+                next += missed * timer->period;
+            }
+            timer->deadline = next;
+            (void)HrTimer_Insert(timer);
+        }
+        __set_PRIMASK(primask);
+
+        if (callback != NULL)
+        {
+            callback(cbCtx);
+        }
+        if (task != NULL)
+        {
+            (void)xTaskNotifyIndexedFromISR(task, HRTIMER_NOTIFY_INDEX, bits, eSetBits, &woken);
+        }
+    }
+
+    portYIELD_FROM_ISR(woken);
+}
+
+/** @} */ // end of HrTimer group
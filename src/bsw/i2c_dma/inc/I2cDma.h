@@ -0,0 +1,234 @@
+/**
+ * @file I2cDma.h
+ * @brief I2C master transaction engine on DMA and interrupts
+ *
+ * I2C1 runs as a master. A transaction addresses one target and is a list
+ * of messages, each a write or a read, separated by repeated STARTs and
+ * ended by a STOP: a register read is a one-byte write followed by a read.
+ * Message bytes move through one GPDMA1 channel per direction and the
+ * message boundaries, including transfers longer than the 255-byte NBYTES
+ * field, are handled from the I2C interrupt, so the CPU is not involved
+ * per byte.
+ *
+ * Transactions from any task or interrupt are queued and run one after
+ * the other, so a bus shared by several drivers needs no lock. Callbacks
+ * run from interrupt context once the STOP has been sent.
+ *
+ * A batch is a fixed list of register reads run periodically: every read
+ * is queued at once when the period elapses and the owner is called once,
+ * when the last one completes, instead of once per read.
+ */
+
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "timers.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef I2CDMA_QUEUE_LEN
+#define I2CDMA_QUEUE_LEN (16U) /**< Transactions waiting behind the running one */
+#endif
+
+#ifndef I2CDMA_BUS_HZ
+#define I2CDMA_BUS_HZ (400000U) /**< SCL rate programmed by ::I2cDma_Init */
+#endif
+
+#ifndef I2CDMA_BATCH_MAX_ITEMS
+#define I2CDMA_BATCH_MAX_ITEMS (8U) /**< Register reads of one batch */
+#endif
+
+#define I2CDMA_TIMEOUT_MS (25U)   /**< SCL held low longer than this is a bus error (SMBus tTIMEOUT) */
+#define I2CDMA_NOTIFY_INDEX (1U)  /**< Task notification index used by ::I2cDma_TransferWait */
+
+#define I2CDMA_MSG_READ (1U << 0) /**< Message reads from the target, writes otherwise */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Outcome of a transaction.
+ */
+typedef enum
+{
+    I2CDMA_OK = 0,      /**< Every message transferred */
+    I2CDMA_ERR_NACK,    /**< Address or data not acknowledged, STOP sent */
+    I2CDMA_ERR_BUS,     /**< Bus error, lost arbitration or SCL timeout */
+    I2CDMA_ERR_DMA,     /**< DMA transfer error */
+    I2CDMA_ERR_PARAM,   /**< Invalid transaction, not queued */
+} I2cDma_Result_T;
+
+/**
+ * @brief One message of a transaction.
+ */
+typedef struct
+{
+    void *buf;     /**< Bytes written or read */
+    uint16_t len;  /**< Byte count, 0 only for a lone write (address probe) */
+    uint8_t flags; /**< I2CDMA_MSG_x */
+} I2cDma_Msg_T;
+
+/**
+ * @brief Transaction completion callback.
+ *
+ * Runs from interrupt context. The driver no longer references the
+ * messages or their buffers once it runs.
+ *
+ * @param[in] ctx    Context given with the transaction.
+ * @param[in] result Outcome.
+ */
+typedef void (*I2cDma_Callback_T)(void *ctx, I2cDma_Result_T result);
+
+/**
+ * @brief Transaction.
+ */
+typedef struct
+{
+    uint8_t addr;              /**< 7-bit target address */
+    const I2cDma_Msg_T *msgs;  /**< Messages, used in place until the callback */
+    uint8_t count;             /**< Messages in @ref msgs */
+    I2cDma_Callback_T cb;      /**< Completion callback, may be NULL */
+    void *ctx;                 /**< Passed unchanged to @ref cb */
+} I2cDma_Xfer_T;
+
+/**
+ * @brief One register read of a batch.
+ */
+typedef struct
+{
+    uint8_t addr;  /**< 7-bit target address */
+    uint8_t reg;   /**< Register written before the read */
+    void *buf;     /**< Bytes read */
+    uint16_t len;  /**< Bytes to read */
+} I2cDma_BatchItem_T;
+
+/**
+ * @brief Batch completion callback, from interrupt context.
+ *
+ * @param[in] ctx    Context given with the batch.
+ * @param[in] failed Bit n set if item n failed.
+ */
+typedef void (*I2cDma_BatchCallback_T)(void *ctx, uint32_t failed);
+
+/**
+ * @brief Periodic batch of register reads.
+ *
+ * The caller fills the fields up to @ref ctx; the rest belongs to the
+ * driver. The batch must stay valid until ::I2cDma_BatchStop.
+ */
+typedef struct
+{
+    const I2cDma_BatchItem_T *items; /**< Reads, in bus order */
+    uint32_t count;                  /**< Items, up to ::I2CDMA_BATCH_MAX_ITEMS */
+    uint32_t period_ms;              /**< Interval between two batch starts */
+    I2cDma_BatchCallback_T cb;       /**< Called once per batch */
+    void *ctx;                       /**< Passed unchanged to @ref cb */
+
+    /* Driver state */
+    uint8_t regs[I2CDMA_BATCH_MAX_ITEMS];         /**< Register addresses sent */
+    I2cDma_Msg_T msgs[I2CDMA_BATCH_MAX_ITEMS][2]; /**< Write then read of each item */
+    volatile uint32_t pending;                    /**< Items of the running batch not yet complete */
+    uint32_t completed;                           /**< Items of the running batch completed, in bus order */
+    uint32_t failed;                              /**< Failed items of the running batch */
+    uint32_t runs;                                /**< Batches completed */
+    uint32_t overruns;                            /**< Periods skipped, previous batch still running */
+    TimerHandle_t timer;                          /**< Period timer */
+    StaticTimer_t timerBuf;                       /**< Period timer storage */
+} I2cDma_Batch_T;
+
+/**
+ * @brief Driver counters.
+ */
+typedef struct
+{
+    uint32_t xfers_done;  /**< Transactions completed */
+    uint32_t nacks;       /**< Transactions ended by a NACK */
+    uint32_t bus_errors;  /**< Transactions ended by a bus error or a timeout */
+    uint32_t dma_errors;  /**< Transactions ended by a DMA error */
+    uint64_t bytes;       /**< Message bytes of completed transactions */
+    uint32_t queue_peak;  /**< Largest number of waiting transactions */
+    uint32_t queue_full;  /**< Submissions rejected on a full queue */
+    uint32_t irqs;        /**< I2C interrupts handled */
+    uint32_t batches;     /**< Batches completed */
+    uint32_t actual_hz;   /**< SCL rate from TIMINGR */
+} I2cDma_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable I2C1 and its pins, program ::I2CDMA_BUS_HZ and take the DMA channels.
+ *
+ * @retval true  Driver ready.
+ * @retval false No DMA channel or interrupt available, or no timing fits.
+ */
+bool I2cDma_Init(void);
+
+/**
+ * @brief Queue a transaction.
+ *
+ * @param[in] xfer Transaction, copied; its messages are used in place.
+ *
+ * @retval true  Queued or started.
+ * @retval false Invalid transaction or queue full.
+ */
+bool I2cDma_Submit(const I2cDma_Xfer_T *xfer);
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ *
+ * Waits on task notification index ::I2CDMA_NOTIFY_INDEX. A stuck bus
+ * ends through the SCL timeout, so there is no timeout here; a full queue
+ * is retried every tick.
+ *
+ * @param[in] addr  7-bit target address.
+ * @param[in] msgs  Messages.
+ * @param[in] count Number of messages.
+ *
+ * @return Outcome of the transaction.
+ */
+I2cDma_Result_T I2cDma_TransferWait(uint8_t addr, const I2cDma_Msg_T *msgs, uint8_t count);
+
+/**
+ * @brief Write @p wlen bytes then read @p rlen bytes after a repeated START.
+ *
+ * @param[in]  addr 7-bit target address.
+ * @param[in]  wr   Bytes written, usually the register address.
+ * @param[in]  wlen Bytes to write.
+ * @param[out] rd   Bytes read.
+ * @param[in]  rlen Bytes to read, 0 for a plain write.
+ *
+ * @return Outcome of the transaction.
+ */
+I2cDma_Result_T I2cDma_WriteRead(uint8_t addr, const void *wr, uint16_t wlen, void *rd, uint16_t rlen);
+
+/**
+ * @brief Start running a batch every @p batch->period_ms.
+ *
+ * A period that elapses while the previous batch is still on the bus is
+ * skipped and counted in @ref I2cDma_Batch_T::overruns.
+ *
+ * @param[in,out] batch Batch to run, the first one after one period.
+ *
+ * @retval true  Batch running.
+ * @retval false Invalid batch or timer not started.
+ */
+bool I2cDma_BatchStart(I2cDma_Batch_T *batch);
+
+/**
+ * @brief Stop a batch; reads already queued still complete.
+ *
+ * @param[in,out] batch Batch to stop.
+ */
+void I2cDma_BatchStop(I2cDma_Batch_T *batch);
+
+/**
+ * @brief Copy the driver counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void I2cDma_GetStatus(I2cDma_Status_T *status);
+
+#endif /* I2C_DMA_H */
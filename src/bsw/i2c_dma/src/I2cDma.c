@@ -0,0 +1,871 @@
+/**
+ * @file I2cDma.c
+ * @brief Implementation of the I2C DMA transaction engine.
+ * @ingroup I2cDma
+ * @{
+ *
+ * Each message is one START (or repeated START) and one DMA block. NBYTES
+ * covers at most 255 bytes: longer messages set RELOAD and the next count
+ * is written on TCR. Messages other than the last one stop on TC with SCL
+ * stretched, where the next one is programmed; the last one uses AUTOEND
+ * and the transaction ends on STOPF, which also follows a NACK since the
+ * peripheral sends the STOP itself then.
+ *
+ * Bus errors, lost arbitration and the SCL timeout leave no STOP to wait
+ * for: the peripheral is reset through PE and the transaction ends at once.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "I2cDma.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_i2c.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "task.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define I2CDMA_INSTANCE I2C1                 /**< I2C instance used */
+#define I2CDMA_PINS_PORT GPIOB               /**< Port of SCL and SDA */
+#define I2CDMA_PINS (LL_GPIO_PIN_6 | LL_GPIO_PIN_7) /**< SCL and SDA */
+#define I2CDMA_PINS_AF LL_GPIO_AF_4          /**< Alternate function of I2C1 */
+#define I2CDMA_NBYTES_MAX (255U)             /**< Bytes one NBYTES count covers */
+#define I2CDMA_ISR_ERRORS (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR | I2C_ISR_TIMEOUT) /**< Error interrupt flags */
+#define I2CDMA_DMA_ERRORS (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF) /**< Channel flags ending a transaction */
+#define I2CDMA_SPIN_LIMIT (10000U)           /**< Polls of a channel before giving up on it */
+#define I2CDMA_PE_LOW_READS (4U)             /**< Reads keeping PE low, at least three APB cycles */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** Transmit channel. */
+static DmaAlloc_Channel_T g_i2cDmaTxChannel = {0};
+/** Receive channel. */
+static DmaAlloc_Channel_T g_i2cDmaRxChannel = {0};
+/** Transactions waiting to run. */
+static I2cDma_Xfer_T g_i2cDmaQueue[I2CDMA_QUEUE_LEN];
+/** Index of the oldest waiting transaction. */
+static uint32_t g_i2cDmaHead = 0U;
+/** Waiting transactions. */
+static uint32_t g_i2cDmaCount = 0U;
+/** Transaction on the bus. */
+static I2cDma_Xfer_T g_i2cDmaCur;
+/** Message of ::g_i2cDmaCur on the bus. */
+static uint32_t g_i2cDmaMsg = 0U;
+/** Bytes of the message not yet covered by an NBYTES count. */
+static uint32_t g_i2cDmaLeft = 0U;
+/** Outcome of the transaction so far. */
+static I2cDma_Result_T g_i2cDmaResult = I2CDMA_OK;
+/** Channel moving the current message, NULL if none. */
+static const DmaAlloc_Channel_T *g_i2cDmaActive = NULL;
+/** A transaction is on the bus. */
+static volatile bool g_i2cDmaRunning = false;
+/** I2C kernel clock. */
+static uint32_t g_i2cDmaKernelHz = 0U;
+/** Counters reported by ::I2cDma_GetStatus. */
+static I2cDma_Status_T g_i2cDmaStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Configure SCL and SDA. */
+static void I2cDma_InitGpio(void);
+/** Take and configure one DMA channel. */
+static bool I2cDma_InitChannel(DmaAlloc_Channel_T *channel, const char *owner);
+/** TIMINGR value for @p busHz. */
+static uint32_t I2cDma_Timing(uint32_t kernelHz, uint32_t busHz, uint32_t *actualHz);
+/** A transaction is acceptable. */
+static bool I2cDma_IsValid(const I2cDma_Xfer_T *xfer);
+/** Start the next transaction, if any. Interrupts masked or from an I2C or DMA interrupt. */
+static void I2cDma_StartNext(void);
+/** Put the current message on the bus. */
+static void I2cDma_StartMsg(void);
+/** CR2 value for the next NBYTES count of the current message, START excluded. */
+static uint32_t I2cDma_NextCount(void);
+/** Close the DMA block of the current message. */
+static void I2cDma_StopDma(void);
+/** End the transaction on the bus and start the next one. */
+static void I2cDma_Finish(void);
+/** Reset the peripheral and both channels after a failure. */
+static void I2cDma_Abort(I2cDma_Result_T result);
+/** Stop a channel after a failure. */
+static void I2cDma_ResetChannel(const DmaAlloc_Channel_T *channel);
+/** I2C event interrupt, bound through the ISR manager. */
+static void I2cDma_EvIrqHandler(void *ctx);
+/** I2C error interrupt, bound through the ISR manager. */
+static void I2cDma_ErIrqHandler(void *ctx);
+/** DMA channel interrupt, only raised by errors. */
+static void I2cDma_DmaIrqHandler(void *ctx);
+/** Completion callback of ::I2cDma_TransferWait. */
+static void I2cDma_WakeWaiter(void *ctx, I2cDma_Result_T result);
+/** Period timer of a batch, queues every read. */
+static void I2cDma_BatchTimer(TimerHandle_t timer);
+/** Completion callback of a batch read. */
+static void I2cDma_BatchXferDone(void *ctx, I2cDma_Result_T result);
+/** Account for @p items finished reads of a batch. */
+static void I2cDma_BatchItemsDone(I2cDma_Batch_T *batch, uint32_t items);
+/** Register block of a channel. */
+static DMA_Channel_TypeDef *I2cDma_Regs(const DmaAlloc_Channel_T *channel);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable I2C1 and its pins, program the bus rate and take the DMA channels.
+ *
+ * The SMBus SCL timeout is enabled so a target holding SCL low ends the
+ * transaction with a bus error instead of stalling the queue.
+ */
+bool I2cDma_Init(void)
+{
+    I2cDma_InitGpio();
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_I2C1);
+    LL_RCC_SetI2CClockSource(LL_RCC_I2C1_CLKSOURCE_PCLK1);
+    g_i2cDmaKernelHz = LL_RCC_GetI2CClockFreq(LL_RCC_I2C1_CLKSOURCE);
+
+    uint32_t timing = I2cDma_Timing(g_i2cDmaKernelHz, I2CDMA_BUS_HZ, &g_i2cDmaStatus.actual_hz);
+    if (timing == 0U)
+    {
+        return false;
+    }
+
+    if (!I2cDma_InitChannel(&g_i2cDmaTxChannel, "I2cDma tx") || !I2cDma_InitChannel(&g_i2cDmaRxChannel, "I2cDma rx"))
+    {
+        return false;
+    }
+
+    if (!IsrMgr_Register(I2C1_EV_IRQn, I2cDma_EvIrqHandler, NULL) ||
+        !IsrMgr_Register(I2C1_ER_IRQn, I2cDma_ErIrqHandler, NULL))
+    {
+        return false;
+    }
+
+    /* tTIMEOUT = (TIMEOUTA + 1) x 2048 kernel clocks */
+    uint32_t timeouta = ((g_i2cDmaKernelHz / 1000U) * I2CDMA_TIMEOUT_MS) / 2048U;
+    timeouta = (timeouta > 0U) ? (timeouta - 1U) : 0U;
+    timeouta = (timeouta > I2C_TIMEOUTR_TIMEOUTA_Msk) ? I2C_TIMEOUTR_TIMEOUTA_Msk : timeouta;
+
+    WRITE_REG(I2CDMA_INSTANCE->CR1, 0U);
+    WRITE_REG(I2CDMA_INSTANCE->TIMINGR, timing);
+    WRITE_REG(I2CDMA_INSTANCE->TIMEOUTR, timeouta);
+    WRITE_REG(I2CDMA_INSTANCE->TIMEOUTR, timeouta | I2C_TIMEOUTR_TIMOUTEN);
+    WRITE_REG(I2CDMA_INSTANCE->CR1,
+              I2C_CR1_PE | I2C_CR1_NACKIE | I2C_CR1_STOPIE | I2C_CR1_TCIE | I2C_CR1_ERRIE);
+
+    const IRQn_Type irqs[2] = {I2C1_EV_IRQn, I2C1_ER_IRQn};
+    for (uint32_t i = 0U; i < 2U; i++)
+    {
+        NVIC_SetPriority(irqs[i], NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                      configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+        NVIC_EnableIRQ(irqs[i]);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a transaction.
+ *
+ * Cache maintenance runs in the caller: write buffers are cleaned, read
+ * buffers cleaned and invalidated so no dirty line can be evicted over the
+ * received bytes.
+ */
+bool I2cDma_Submit(const I2cDma_Xfer_T *xfer)
+{
+    if (!I2cDma_IsValid(xfer))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < xfer->count; i++)
+    {
+        const I2cDma_Msg_T *msg = &xfer->msgs[i];
+        if ((msg->len == 0U) || DmaPool_IsNonCacheable(msg->buf, msg->len))
+        {
+            continue;
+        }
+        if ((msg->flags & I2CDMA_MSG_READ) != 0U)
+        {
+            SCB_CleanInvalidateDCache_by_Addr(msg->buf, (int32_t)msg->len);
+        }
+        else
+        {
+            SCB_CleanDCache_by_Addr(msg->buf, (int32_t)msg->len);
+        }
+    }
+
+    bool queued = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_i2cDmaCount < I2CDMA_QUEUE_LEN)
+    {
+        g_i2cDmaQueue[(g_i2cDmaHead + g_i2cDmaCount) % I2CDMA_QUEUE_LEN] = *xfer;
+        g_i2cDmaCount++;
+        if (!g_i2cDmaRunning)
+        {
+            I2cDma_StartNext();
+        }
+        if (g_i2cDmaCount > g_i2cDmaStatus.queue_peak)
+        {
+            g_i2cDmaStatus.queue_peak = g_i2cDmaCount;
+        }
+    }
+    else
+    {
+        g_i2cDmaStatus.queue_full++;
+        queued = false;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ */
+I2cDma_Result_T I2cDma_TransferWait(uint8_t addr, const I2cDma_Msg_T *msgs, uint8_t count)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+    const I2cDma_Xfer_T xfer = {
+        .addr = addr,
+        .msgs = msgs,
+        .count = count,
+        .cb = I2cDma_WakeWaiter,
+        .ctx = self,
+    };
+
+    if (!I2cDma_IsValid(&xfer))
+    {
+        return I2CDMA_ERR_PARAM;
+    }
+
+    xTaskNotifyStateClearIndexed(self, I2CDMA_NOTIFY_INDEX);
+    while (!I2cDma_Submit(&xfer))
+    {
+        vTaskDelay(1);
+    }
+    (void)xTaskNotifyWaitIndexed(I2CDMA_NOTIFY_INDEX, 0U, UINT32_MAX, &value, portMAX_DELAY);
+
+    return (I2cDma_Result_T)value;
+}
+
+/**
+ * @brief Write then read after a repeated START.
+ */
+I2cDma_Result_T I2cDma_WriteRead(uint8_t addr, const void *wr, uint16_t wlen, void *rd, uint16_t rlen)
+{
+    const I2cDma_Msg_T msgs[2] = {
+        {(void *)wr, wlen, 0U},
+        {rd, rlen, I2CDMA_MSG_READ},
+    };
+
+    return I2cDma_TransferWait(addr, msgs, (rlen != 0U) ? 2U : 1U);
+}
+
+/**
+ * @brief Start running a batch periodically.
+ *
+ * The write and read messages of every item are built once here, each
+ * period only queues them.
+ */
+bool I2cDma_BatchStart(I2cDma_Batch_T *batch)
+{
+    if ((batch == NULL) || (batch->items == NULL) || (batch->count == 0U) ||
+        (batch->count > I2CDMA_BATCH_MAX_ITEMS) || (batch->period_ms == 0U))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < batch->count; i++)
+    {
+        const I2cDma_BatchItem_T *item = &batch->items[i];
+        if ((item->addr > 0x7FU) || (item->buf == NULL) || (item->len == 0U))
+        {
+            return false;
+        }
+        batch->regs[i] = item->reg;
+        batch->msgs[i][0] = (I2cDma_Msg_T){&batch->regs[i], 1U, 0U};
+        batch->msgs[i][1] = (I2cDma_Msg_T){item->buf, item->len, I2CDMA_MSG_READ};
+    }
+    batch->pending = 0U;
+
+    TickType_t period = pdMS_TO_TICKS(batch->period_ms);
+    period = (period != 0U) ? period : 1U;
+    if (batch->timer == NULL)
+    {
+        batch->timer = xTimerCreateStatic("I2cBatch", period, pdTRUE, batch, I2cDma_BatchTimer, &batch->timerBuf);
+    }
+    else
+    {
+        (void)xTimerChangePeriod(batch->timer, period, 0U);
+    }
+
+    return (batch->timer != NULL) && (xTimerStart(batch->timer, 0U) == pdPASS);
+}
+
+/**
+ * @brief Stop a batch.
+ */
+void I2cDma_BatchStop(I2cDma_Batch_T *batch)
+{
+    if ((batch != NULL) && (batch->timer != NULL))
+    {
+        (void)xTimerStop(batch->timer, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Copy the driver counters into @p status.
+ */
+void I2cDma_GetStatus(I2cDma_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_i2cDmaStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Configure SCL and SDA as open-drain alternate function with pull-ups.
+ */
+static void I2cDma_InitGpio(void)
+{
+    LL_GPIO_InitTypeDef gpio_h;
+
+    LL_AHB4_GRP1_EnableClock(LL_AHB4_GRP1_PERIPH_GPIOB);
+
+    gpio_h.Pin = I2CDMA_PINS;
+    gpio_h.Mode = LL_GPIO_MODE_ALTERNATE;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_LOW;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_OPENDRAIN;
+    gpio_h.Pull = LL_GPIO_PULL_UP;
+    gpio_h.Alternate = I2CDMA_PINS_AF;
+    LL_GPIO_Init(I2CDMA_PINS_PORT, &gpio_h);
+}
+
+/**
+ * @brief Take a GPDMA1 channel and bind its error interrupt.
+ */
+static bool I2cDma_InitChannel(DmaAlloc_Channel_T *channel, const char *owner)
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = DMAALLOC_CLASS_NORMAL,
+        .caps = 0U,
+        .burst_bytes = 0U,
+        .owner = owner,
+        .handler = I2cDma_DmaIrqHandler,
+        .ctx = NULL,
+    };
+
+    if (!DmaAlloc_Request(&request, channel))
+    {
+        return false;
+    }
+
+    LL_DMA_ConfigControl(channel->instance, channel->channel, channel->priority);
+    LL_DMA_EnableIT_DTE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_ULE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_USE(channel->instance, channel->channel);
+    NVIC_SetPriority(channel->irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                       configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(channel->irq);
+    return true;
+}
+
+/**
+ * @brief TIMINGR value for @p busHz.
+ *
+ * The smallest prescaler whose SCL low and high counts fit is used, for
+ * the finest rate resolution. Low takes two thirds of the period in fast
+ * mode and half of it in standard mode; the data setup and hold delays
+ * cover the minimums of the I2C specification for the mode. The
+ * synchronisation delays of SCL edges, a few kernel clocks, are not
+ * included, so the real rate is slightly below @p actualHz.
+ *
+ * @return TIMINGR, 0 if no prescaler fits.
+ */
+static uint32_t I2cDma_Timing(uint32_t kernelHz, uint32_t busHz, uint32_t *actualHz)
+{
+    uint32_t setupNs = (busHz <= 100000U) ? 250U : ((busHz <= 400000U) ? 100U : 50U);
+    uint32_t holdNs = (busHz <= 400000U) ? 100U : 0U;
+
+    if (busHz == 0U)
+    {
+        return 0U;
+    }
+
+    for (uint32_t presc = 0U; presc < 16U; presc++)
+    {
+        uint32_t tickHz = kernelHz / (presc + 1U);
+        uint32_t total = (tickHz + (busHz / 2U)) / busHz;
+        uint32_t low = (busHz > 100000U) ? (((total * 2U) + 1U) / 3U) : (total / 2U);
+        uint32_t high = total - low;
+        uint32_t scldel = (uint32_t)((((uint64_t)setupNs * tickHz) + 999999999ULL) / 1000000000ULL);
+        uint32_t sdadel = (uint32_t)((((uint64_t)holdNs * tickHz) + 999999999ULL) / 1000000000ULL);
+
+        scldel = (scldel > 0U) ? (scldel - 1U) : 0U;
+        if ((low < 2U) || (high < 2U) || (low > 256U) || (high > 256U) || (scldel > 15U) || (sdadel > 15U))
+        {
+            continue;
+        }
+
+        *actualHz = tickHz / total;
+        return (presc << I2C_TIMINGR_PRESC_Pos) | (scldel << I2C_TIMINGR_SCLDEL_Pos) |
+               (sdadel << I2C_TIMINGR_SDADEL_Pos) | ((high - 1U) << I2C_TIMINGR_SCLH_Pos) |
+               ((low - 1U) << I2C_TIMINGR_SCLL_Pos);
+    }
+    return 0U;
+}
+
+/**
+ * @brief A transaction is acceptable.
+ *
+ * Every message needs bytes, except a lone write used to probe an
+ * address.
+ */
+static bool I2cDma_IsValid(const I2cDma_Xfer_T *xfer)
+{
+    if ((xfer == NULL) || (xfer->msgs == NULL) || (xfer->count == 0U) || (xfer->addr > 0x7FU))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0U; i < xfer->count; i++)
+    {
+        const I2cDma_Msg_T *msg = &xfer->msgs[i];
+        if ((msg->len == 0U) && ((xfer->count != 1U) || ((msg->flags & I2CDMA_MSG_READ) != 0U)))
+        {
+            return false;
+        }
+        if ((msg->len != 0U) && (msg->buf == NULL))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Start the next transaction, if any.
+ */
+static void I2cDma_StartNext(void)
+{
+    if (g_i2cDmaCount == 0U)
+    {
+        g_i2cDmaRunning = false;
+        return;
+    }
+
+    g_i2cDmaCur = g_i2cDmaQueue[g_i2cDmaHead];
+    g_i2cDmaHead = (g_i2cDmaHead + 1U) % I2CDMA_QUEUE_LEN;
+    g_i2cDmaCount--;
+    g_i2cDmaMsg = 0U;
+    g_i2cDmaResult = I2CDMA_OK;
+    g_i2cDmaRunning = true;
+    I2cDma_StartMsg();
+}
+
+/**
+ * @brief Put the current message on the bus.
+ *
+ * The DMA block covers the whole message and is armed before START, so
+ * the first data byte is requested as soon as the address is acknowledged.
+ */
+static void I2cDma_StartMsg(void)
+{
+    const I2cDma_Msg_T *msg = &g_i2cDmaCur.msgs[g_i2cDmaMsg];
+    bool read = (msg->flags & I2CDMA_MSG_READ) != 0U;
+    uint32_t cr1 = READ_REG(I2CDMA_INSTANCE->CR1) & ~(I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+
+    g_i2cDmaActive = NULL;
+    if (msg->len != 0U)
+    {
+        const DmaAlloc_Channel_T *channel = read ? &g_i2cDmaRxChannel : &g_i2cDmaTxChannel;
+        DMA_Channel_TypeDef *regs = I2cDma_Regs(channel);
+
+        WRITE_REG(regs->CTR1, (read ? LL_DMA_DEST_INCREMENT : LL_DMA_SRC_INCREMENT) | LL_DMA_SRC_DATAWIDTH_BYTE |
+                                  LL_DMA_DEST_DATAWIDTH_BYTE);
+        WRITE_REG(regs->CTR2, read ? (LL_GPDMA1_REQUEST_I2C1_RX | LL_DMA_DIRECTION_PERIPH_TO_MEMORY)
+                                   : (LL_GPDMA1_REQUEST_I2C1_TX | LL_DMA_DIRECTION_MEMORY_TO_PERIPH));
+        WRITE_REG(regs->CBR1, msg->len);
+        WRITE_REG(regs->CSAR, read ? (uint32_t)&I2CDMA_INSTANCE->RXDR : (uint32_t)msg->buf);
+        WRITE_REG(regs->CDAR, read ? (uint32_t)msg->buf : (uint32_t)&I2CDMA_INSTANCE->TXDR);
+        WRITE_REG(regs->CLLR, 0U);
+        DmaAlloc_NoteStart(channel, msg->len);
+        __DMB();
+        LL_DMA_EnableChannel(channel->instance, channel->channel);
+        g_i2cDmaActive = channel;
+        cr1 |= read ? I2C_CR1_RXDMAEN : I2C_CR1_TXDMAEN;
+    }
+    WRITE_REG(I2CDMA_INSTANCE->CR1, cr1);
+
+    g_i2cDmaLeft = msg->len;
+    WRITE_REG(I2CDMA_INSTANCE->CR2, I2cDma_NextCount() | ((uint32_t)g_i2cDmaCur.addr << 1U) |
+                                        (read ? I2C_CR2_RD_WRN : 0U) | I2C_CR2_START);
+}
+
+/**
+ * @brief NBYTES, RELOAD and AUTOEND for the next part of the current message.
+ *
+ * The last message ends with an automatic STOP; the others with TC, where
+ * the next message is started.
+ */
+static uint32_t I2cDma_NextCount(void)
+{
+    uint32_t nbytes = (g_i2cDmaLeft > I2CDMA_NBYTES_MAX) ? I2CDMA_NBYTES_MAX : g_i2cDmaLeft;
+    uint32_t cr2 = nbytes << I2C_CR2_NBYTES_Pos;
+
+    g_i2cDmaLeft -= nbytes;
+    if (g_i2cDmaLeft != 0U)
+    {
+        cr2 |= I2C_CR2_RELOAD;
+    }
+    else if ((g_i2cDmaMsg + 1U) == g_i2cDmaCur.count)
+    {
+        cr2 |= I2C_CR2_AUTOEND;
+    }
+    return cr2;
+}
+
+/**
+ * @brief Close the DMA block of the current message.
+ *
+ * A read block moves the last byte once it reaches RXDR, just after TC or
+ * STOPF is raised, so the channel is given a short time to finish.
+ */
+static void I2cDma_StopDma(void)
+{
+    const DmaAlloc_Channel_T *channel = g_i2cDmaActive;
+
+    if (channel == NULL)
+    {
+        return;
+    }
+
+    uint32_t spin = I2CDMA_SPIN_LIMIT;
+    while ((LL_DMA_IsEnabledChannel(channel->instance, channel->channel) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    if (spin == 0U)
+    {
+        I2cDma_ResetChannel(channel);
+        if (g_i2cDmaResult == I2CDMA_OK)
+        {
+            g_i2cDmaResult = I2CDMA_ERR_DMA;
+        }
+    }
+    else
+    {
+        DmaAlloc_NoteStop(channel);
+    }
+    g_i2cDmaActive = NULL;
+}
+
+/**
+ * @brief End the transaction on the bus and start the next one.
+ *
+ * The next transaction is started before the callback, so the bus only
+ * waits for the CPU while the queue is empty.
+ */
+static void I2cDma_Finish(void)
+{
+    I2cDma_Xfer_T done = g_i2cDmaCur;
+    I2cDma_Result_T result;
+
+    I2cDma_StopDma();
+    CLEAR_BIT(I2CDMA_INSTANCE->CR1, I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+    result = g_i2cDmaResult;
+
+    switch (result)
+    {
+    case I2CDMA_OK:
+        g_i2cDmaStatus.xfers_done++;
+        for (uint32_t i = 0U; i < done.count; i++)
+        {
+            const I2cDma_Msg_T *msg = &done.msgs[i];
+            g_i2cDmaStatus.bytes += msg->len;
+            if (((msg->flags & I2CDMA_MSG_READ) != 0U) && !DmaPool_IsNonCacheable(msg->buf, msg->len))
+            {
+                SCB_InvalidateDCache_by_Addr(msg->buf, (int32_t)msg->len);
+            }
+        }
+        break;
+    case I2CDMA_ERR_NACK:
+        g_i2cDmaStatus.nacks++;
+        break;
+    case I2CDMA_ERR_DMA:
+        g_i2cDmaStatus.dma_errors++;
+        break;
+    default:
+        g_i2cDmaStatus.bus_errors++;
+        break;
+    }
+
+    g_i2cDmaRunning = false;
+    I2cDma_StartNext();
+
+    if (done.cb != NULL)
+    {
+        done.cb(done.ctx, result);
+    }
+}
+
+/**
+ * @brief Reset the peripheral and both channels after a failure.
+ *
+ * Clearing PE releases SCL and SDA and clears the flags; it must stay low
+ * for three APB clocks, covered by reading CR1 back.
+ */
+static void I2cDma_Abort(I2cDma_Result_T result)
+{
+    I2cDma_ResetChannel(&g_i2cDmaTxChannel);
+    I2cDma_ResetChannel(&g_i2cDmaRxChannel);
+    g_i2cDmaActive = NULL;
+
+    uint32_t cr1 = READ_REG(I2CDMA_INSTANCE->CR1) & ~(I2C_CR1_TXDMAEN | I2C_CR1_RXDMAEN);
+    WRITE_REG(I2CDMA_INSTANCE->CR1, cr1 & ~I2C_CR1_PE);
+    for (uint32_t i = 0U; i < I2CDMA_PE_LOW_READS; i++)
+    {
+        (void)READ_REG(I2CDMA_INSTANCE->CR1);
+    }
+    WRITE_REG(I2CDMA_INSTANCE->CR1, cr1 | I2C_CR1_PE);
+
+    if (g_i2cDmaRunning)
+    {
+        g_i2cDmaResult = result;
+        I2cDma_Finish();
+    }
+}
+
+/**
+ * @brief Stop a channel after a failure.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void I2cDma_ResetChannel(const DmaAlloc_Channel_T *channel)
+{
+    if (LL_DMA_IsEnabledChannel(channel->instance, channel->channel) != 0U)
+    {
+        uint32_t spin = I2CDMA_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(channel->instance, channel->channel);
+        while ((LL_DMA_IsActiveFlag_SUSP(channel->instance, channel->channel) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(channel->instance, channel->channel);
+    DmaAlloc_NoteStop(channel);
+    WRITE_REG(I2cDma_Regs(channel)->CFCR, DMA_CFCR_TCF | DMA_CFCR_HTF | DMA_CFCR_DTEF | DMA_CFCR_ULEF |
+                                              DMA_CFCR_USEF | DMA_CFCR_SUSPF | DMA_CFCR_TOF);
+}
+
+/**
+ * @brief I2C event interrupt.
+ *
+ * - NACKF: the peripheral sends STOP itself, the transaction ends on STOPF.
+ * - TCR: the next NBYTES count of a long message.
+ * - TC: the message before the last one is done, the next one starts with
+ *   a repeated START.
+ * - STOPF: the transaction is over.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I2cDma_EvIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t isr = READ_REG(I2CDMA_INSTANCE->ISR);
+
+    g_i2cDmaStatus.irqs++;
+    if (!g_i2cDmaRunning)
+    {
+        WRITE_REG(I2CDMA_INSTANCE->ICR, I2C_ICR_NACKCF | I2C_ICR_STOPCF);
+        return;
+    }
+
+    if ((isr & I2C_ISR_NACKF) != 0U)
+    {
+        WRITE_REG(I2CDMA_INSTANCE->ICR, I2C_ICR_NACKCF);
+        g_i2cDmaResult = I2CDMA_ERR_NACK;
+    }
+
+    if ((isr & I2C_ISR_STOPF) != 0U)
+    {
+        WRITE_REG(I2CDMA_INSTANCE->ICR, I2C_ICR_STOPCF);
+        I2cDma_Finish();
+    }
+    else if ((isr & I2C_ISR_TCR) != 0U)
+    {
+        uint32_t cr2 = READ_REG(I2CDMA_INSTANCE->CR2) & (I2C_CR2_SADD | I2C_CR2_RD_WRN);
+        WRITE_REG(I2CDMA_INSTANCE->CR2, cr2 | I2cDma_NextCount());
+    }
+    else if ((isr & I2C_ISR_TC) != 0U)
+    {
+        I2cDma_StopDma();
+        g_i2cDmaMsg++;
+        I2cDma_StartMsg();
+    }
+}
+
+/**
+ * @brief I2C error interrupt: bus error, lost arbitration, overrun or SCL timeout.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I2cDma_ErIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t isr = READ_REG(I2CDMA_INSTANCE->ISR) & I2CDMA_ISR_ERRORS;
+
+    g_i2cDmaStatus.irqs++;
+    if (isr == 0U)
+    {
+        return;
+    }
+    /* The ICR clear bits sit at the positions of their flags */
+    WRITE_REG(I2CDMA_INSTANCE->ICR, isr);
+    I2cDma_Abort(I2CDMA_ERR_BUS);
+}
+
+/**
+ * @brief DMA channel interrupt, only raised by errors.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I2cDma_DmaIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t tx = READ_REG(I2cDma_Regs(&g_i2cDmaTxChannel)->CSR) & I2CDMA_DMA_ERRORS;
+    uint32_t rx = READ_REG(I2cDma_Regs(&g_i2cDmaRxChannel)->CSR) & I2CDMA_DMA_ERRORS;
+
+    if ((tx | rx) != 0U)
+    {
+        I2cDma_Abort(I2CDMA_ERR_DMA);
+    }
+}
+
+/**
+ * @brief Completion callback of ::I2cDma_TransferWait.
+ *
+ * Runs from an interrupt, so the notification uses the ISR API; the
+ * result is passed as the notification value.
+ *
+ * @param[in] ctx    Handle of the waiting task.
+ * @param[in] result Transaction outcome.
+ */
+static void I2cDma_WakeWaiter(void *ctx, I2cDma_Result_T result)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, I2CDMA_NOTIFY_INDEX, (uint32_t)result, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, I2CDMA_NOTIFY_INDEX, (uint32_t)result, eSetValueWithOverwrite);
+    }
+}
+
+/**
+ * @brief Period timer of a batch: queue every read.
+ *
+ * Reads complete in queue order, so their callbacks find their item from
+ * the completion count. A read the queue cannot take fails along with
+ * the ones after it.
+ */
+static void I2cDma_BatchTimer(TimerHandle_t timer)
+{
+    I2cDma_Batch_T *batch = (I2cDma_Batch_T *)pvTimerGetTimerID(timer);
+
+    if (batch->pending != 0U)
+    {
+        batch->overruns++;
+        return;
+    }
+
+    batch->pending = batch->count;
+    batch->completed = 0U;
+    batch->failed = 0U;
+    for (uint32_t i = 0U; i < batch->count; i++)
+    {
+        const I2cDma_Xfer_T xfer = {
+            .addr = batch->items[i].addr,
+            .msgs = batch->msgs[i],
+            .count = 2U,
+            .cb = I2cDma_BatchXferDone,
+            .ctx = batch,
+        };
+        if (!I2cDma_Submit(&xfer))
+        {
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            batch->failed |= ((1UL << batch->count) - 1U) & ~((1UL << i) - 1U);
+            __set_PRIMASK(primask);
+            I2cDma_BatchItemsDone(batch, batch->count - i);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Completion callback of a batch read.
+ */
+static void I2cDma_BatchXferDone(void *ctx, I2cDma_Result_T result)
+{
+    I2cDma_Batch_T *batch = (I2cDma_Batch_T *)ctx;
+
+    if (result != I2CDMA_OK)
+    {
+        batch->failed |= 1UL << batch->completed;
+    }
+    batch->completed++;
+    I2cDma_BatchItemsDone(batch, 1U);
+}
+
+/**
+ * @brief Account for @p items finished reads; the last one calls the owner.
+ */
+static void I2cDma_BatchItemsDone(I2cDma_Batch_T *batch, uint32_t items)
+{
+    bool last;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    batch->pending -= items;
+    last = batch->pending == 0U;
+    if (last)
+    {
+        batch->runs++;
+        g_i2cDmaStatus.batches++;
+    }
+    __set_PRIMASK(primask);
+
+    if (last && (batch->cb != NULL))
+    {
+        batch->cb(batch->ctx, batch->failed);
+    }
+}
+
+/**
+ * @brief Register block of a channel.
+ */
+static DMA_Channel_TypeDef *I2cDma_Regs(const DmaAlloc_Channel_T *channel)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)channel->instance + LL_DMA_CH_OFFSET_TAB[channel->channel]);
+}
+
+/** @} */ // end of I2cDma group
@@ -0,0 +1,270 @@
+/**
+ * @file I3cCtrl.h
+ * @brief I3C controller driver with dynamic addressing and in-band interrupts
+ *
+ * I3C1 runs as the controller of a pure I3C bus at ::I3CCTRL_SDR_HZ in SDR
+ * mode. ::I3cCtrl_AssignAddresses resets and assigns the dynamic addresses
+ * with ENTDAA, records the provisioned ID, BCR and DCR of every target and
+ * enables in-band interrupts on the targets that can raise them.
+ *
+ * A transaction is a private write, read or write-then-read to one target,
+ * or a CCC: broadcast with optional data, or direct to one target in one
+ * direction. Data moves through one GPDMA1 channel per direction; the
+ * control words are written by the driver from the I3C interrupt.
+ * Transactions from any task or interrupt are queued and run in order.
+ *
+ * In-band interrupts are acknowledged for the first four targets found
+ * with the IBI capability, their payload of up to four bytes is kept per
+ * target and the subscribed task is notified.
+ */
+
+#ifndef I3C_CTRL_H
+#define I3C_CTRL_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef I3CCTRL_QUEUE_LEN
+#define I3CCTRL_QUEUE_LEN (16U) /**< Transactions waiting behind the running one */
+#endif
+
+#ifndef I3CCTRL_SDR_HZ
+#define I3CCTRL_SDR_HZ (12500000U) /**< Push-pull SCL rate programmed by ::I3cCtrl_Init */
+#endif
+
+#ifndef I3CCTRL_MAX_TARGETS
+#define I3CCTRL_MAX_TARGETS (8U) /**< Targets recorded by ::I3cCtrl_AssignAddresses */
+#endif
+
+#ifndef I3CCTRL_DA_FIRST
+#define I3CCTRL_DA_FIRST (0x10U) /**< First dynamic address assigned */
+#endif
+
+#define I3CCTRL_NOTIFY_INDEX (1U)     /**< Task notification index used by the blocking calls */
+#define I3CCTRL_IBI_NOTIFY_INDEX (0U) /**< Task notification index set on an in-band interrupt */
+
+#define I3CCTRL_BROADCAST (0x7EU) /**< Address of broadcast CCCs */
+#define I3CCTRL_NO_CCC (0xFFU)    /**< CCC of a private transfer */
+
+#define I3CCTRL_CCC_ENEC (0x00U)      /**< Enable target events, broadcast */
+#define I3CCTRL_CCC_DISEC (0x01U)     /**< Disable target events, broadcast */
+#define I3CCTRL_CCC_RSTDAA (0x06U)    /**< Reset every dynamic address */
+#define I3CCTRL_CCC_ENTDAA (0x07U)    /**< Enter dynamic address assignment */
+#define I3CCTRL_CCC_ENEC_D (0x80U)    /**< Enable target events, direct */
+#define I3CCTRL_CCC_DISEC_D (0x81U)   /**< Disable target events, direct */
+#define I3CCTRL_CCC_GETPID (0x8DU)    /**< Read the provisioned ID, 6 bytes */
+#define I3CCTRL_CCC_GETBCR (0x8EU)    /**< Read the bus characteristics, 1 byte */
+#define I3CCTRL_CCC_GETDCR (0x8FU)    /**< Read the device characteristics, 1 byte */
+#define I3CCTRL_CCC_GETSTATUS (0x90U) /**< Read the target status, 2 bytes */
+
+#define I3CCTRL_EVENT_INT (0x01U) /**< ENEC/DISEC byte: in-band interrupts */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Outcome of a transaction.
+ */
+typedef enum
+{
+    I3CCTRL_OK = 0,     /**< Transaction done */
+    I3CCTRL_ERR_NACK,   /**< Address or data not acknowledged */
+    I3CCTRL_ERR_BUS,    /**< Protocol, parity or FIFO error on the bus */
+    I3CCTRL_ERR_DMA,    /**< DMA transfer error */
+    I3CCTRL_ERR_PARAM,  /**< Invalid transaction, not queued */
+} I3cCtrl_Result_T;
+
+/**
+ * @brief Transaction completion callback.
+ *
+ * Runs from interrupt context. The driver no longer references the
+ * buffers once it runs.
+ *
+ * @param[in] ctx      Context given with the transaction.
+ * @param[in] result   Outcome.
+ * @param[in] received Bytes read; a target may end a read early.
+ */
+typedef void (*I3cCtrl_Callback_T)(void *ctx, I3cCtrl_Result_T result, uint16_t received);
+
+/**
+ * @brief Transaction.
+ *
+ * With @ref ccc set to ::I3CCTRL_NO_CCC it is a private transfer: the
+ * write, if any, is followed by the read after a repeated START. A
+ * broadcast CCC (below 0x80) goes to ::I3CCTRL_BROADCAST and only writes;
+ * a direct CCC writes or reads, not both.
+ */
+typedef struct
+{
+    uint8_t addr;          /**< Dynamic address, or ::I3CCTRL_BROADCAST */
+    uint8_t ccc;           /**< Command code, ::I3CCTRL_NO_CCC for a private transfer */
+    const void *tx;        /**< Bytes written */
+    uint16_t tx_len;       /**< Bytes to write */
+    void *rx;              /**< Bytes read */
+    uint16_t rx_len;       /**< Bytes to read at most */
+    I3cCtrl_Callback_T cb; /**< Completion callback, may be NULL */
+    void *ctx;             /**< Passed unchanged to @ref cb */
+} I3cCtrl_Xfer_T;
+
+/**
+ * @brief Target found by dynamic address assignment.
+ */
+typedef struct
+{
+    uint8_t dyn_addr; /**< Dynamic address assigned */
+    uint8_t bcr;      /**< Bus characteristics register */
+    uint8_t dcr;      /**< Device characteristics register */
+    uint64_t pid;     /**< 48-bit provisioned ID */
+} I3cCtrl_Target_T;
+
+/**
+ * @brief Last in-band interrupt of a target.
+ */
+typedef struct
+{
+    uint32_t payload; /**< Payload, first byte in bits 7:0 */
+    uint8_t len;      /**< Payload bytes */
+    uint32_t count;   /**< In-band interrupts received from the target */
+} I3cCtrl_Ibi_T;
+
+/**
+ * @brief Driver counters.
+ */
+typedef struct
+{
+    uint32_t xfers_done;     /**< Transactions completed */
+    uint32_t nacks;          /**< Transactions ended by a NACK */
+    uint32_t bus_errors;     /**< Transactions ended by a bus error */
+    uint32_t dma_errors;     /**< Transactions ended by a DMA error */
+    uint64_t bytes;          /**< Data bytes of completed transactions */
+    uint32_t short_reads;    /**< Reads the target ended early */
+    uint32_t queue_peak;     /**< Largest number of waiting transactions */
+    uint32_t queue_full;     /**< Submissions rejected on a full queue */
+    uint32_t irqs;           /**< I3C interrupts handled */
+    uint32_t targets;        /**< Targets found by the last assignment */
+    uint32_t ibis;           /**< In-band interrupts delivered */
+    uint32_t ibis_unclaimed; /**< In-band interrupts without a subscriber */
+    uint32_t actual_hz;      /**< Push-pull SCL rate from TIMINGR0 */
+} I3cCtrl_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable I3C1 as controller and its pins, program the bus timing and take the DMA channels.
+ *
+ * @retval true  Driver ready, no dynamic address assigned yet.
+ * @retval false No DMA channel or interrupt available, or no timing fits.
+ */
+bool I3cCtrl_Init(void);
+
+/**
+ * @brief Queue a transaction.
+ *
+ * @param[in] xfer Transaction, copied; its buffers are used in place.
+ *
+ * @retval true  Queued or started.
+ * @retval false Invalid transaction or queue full.
+ */
+bool I3cCtrl_Submit(const I3cCtrl_Xfer_T *xfer);
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ *
+ * Waits on task notification index ::I3CCTRL_NOTIFY_INDEX; the callback
+ * and context of @p xfer are ignored. A full queue is retried every tick.
+ *
+ * @param[in]  xfer     Transaction.
+ * @param[out] received Bytes read, may be NULL.
+ *
+ * @return Outcome of the transaction.
+ */
+I3cCtrl_Result_T I3cCtrl_TransferWait(const I3cCtrl_Xfer_T *xfer, uint16_t *received);
+
+/**
+ * @brief Private write of @p wlen bytes then read of @p rlen bytes after a repeated START.
+ *
+ * @param[in]  addr Dynamic address.
+ * @param[in]  wr   Bytes written, usually the register address.
+ * @param[in]  wlen Bytes to write, 0 for a plain read.
+ * @param[out] rd   Bytes read.
+ * @param[in]  rlen Bytes to read, 0 for a plain write.
+ *
+ * @return Outcome of the transaction.
+ */
+I3cCtrl_Result_T I3cCtrl_WriteRead(uint8_t addr, const void *wr, uint16_t wlen, void *rd, uint16_t rlen);
+
+/**
+ * @brief Send a CCC with optional data, broadcast or to one target.
+ *
+ * @param[in] ccc  Command code.
+ * @param[in] addr ::I3CCTRL_BROADCAST for a broadcast CCC, else the target of a direct one.
+ * @param[in] data Bytes following the command.
+ * @param[in] len  Bytes in @p data.
+ *
+ * @return Outcome of the transaction.
+ */
+I3cCtrl_Result_T I3cCtrl_Ccc(uint8_t ccc, uint8_t addr, const void *data, uint16_t len);
+
+/**
+ * @brief Reset and assign the dynamic addresses, then enable in-band interrupts.
+ *
+ * Sends RSTDAA then ENTDAA; every target that takes part receives the
+ * next address from ::I3CCTRL_DA_FIRST. Targets with the IBI capability
+ * get the interrupt acknowledged, and ENEC enables their interrupts.
+ * From a task only.
+ *
+ * @param[out] found Targets that received an address, may be NULL.
+ *
+ * @return Outcome of the first failing step, ::I3CCTRL_OK otherwise.
+ */
+I3cCtrl_Result_T I3cCtrl_AssignAddresses(uint32_t *found);
+
+/**
+ * @brief Target of the last assignment.
+ *
+ * @param[in]  index  Position in assignment order.
+ * @param[out] target Destination.
+ *
+ * @retval true  Target copied.
+ * @retval false No such target.
+ */
+bool I3cCtrl_GetTarget(uint32_t index, I3cCtrl_Target_T *target);
+
+/**
+ * @brief Notify a task on every in-band interrupt of a target.
+ *
+ * The notification sets @p bits at index ::I3CCTRL_IBI_NOTIFY_INDEX;
+ * the payload is read with ::I3cCtrl_IbiRead.
+ *
+ * @param[in] addr Dynamic address of the target.
+ * @param[in] task Task to notify, NULL to unsubscribe.
+ * @param[in] bits Notification bits to set.
+ *
+ * @retval true  Subscription recorded.
+ * @retval false No target at @p addr.
+ */
+bool I3cCtrl_IbiSubscribe(uint8_t addr, TaskHandle_t task, uint32_t bits);
+
+/**
+ * @brief Last in-band interrupt of a target.
+ *
+ * @param[in]  addr Dynamic address of the target.
+ * @param[out] ibi  Destination.
+ *
+ * @retval true  Copied.
+ * @retval false No target at @p addr.
+ */
+bool I3cCtrl_IbiRead(uint8_t addr, I3cCtrl_Ibi_T *ibi);
+
+/**
+ * @brief Copy the driver counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void I3cCtrl_GetStatus(I3cCtrl_Status_T *status);
+
+#endif /* I3C_CTRL_H */
@@ -0,0 +1,1029 @@
+/**
+ * @file I3cCtrl.c
+ * @brief Implementation of the I3C controller driver.
+ * @ingroup I3cCtrl
+ * @{
+ *
+ * A transaction is one frame of at most two messages, each described by a
+ * control word: a private write and read, or a CCC followed for a direct
+ * CCC by the message to its target. The words are written while the
+ * control FIFO has room, the rest from the CFNF interrupt, so the bus never
+ * waits on the CPU inside a frame. Data goes through one DMA block per
+ * direction armed before the frame, and the frame ends on FCF.
+ *
+ * ENTDAA runs without DMA: for each target the controller receives its
+ * 8-byte ID in the RX FIFO and raises TXFNF for the address to give it,
+ * written from the interrupt. The frame ends once no target answers.
+ *
+ * Errors end the frame with a STOP sent by the peripheral; the FIFOs are
+ * flushed and the channels reset. In-band interrupts are handled between
+ * frames from IBIF, whatever transaction is running.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "I3cCtrl.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_i3c.h"
+#include "stm32n6xx_util_i3c.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define I3CCTRL_INSTANCE I3C1                /**< I3C instance used */
+#define I3CCTRL_PINS_PORT GPIOB              /**< Port of SCL and SDA */
+#define I3CCTRL_PINS (LL_GPIO_PIN_8 | LL_GPIO_PIN_9) /**< SCL and SDA */
+#define I3CCTRL_PINS_AF LL_GPIO_AF_3         /**< Alternate function of I3C1 */
+#define I3CCTRL_OD_HZ (1000000U)             /**< Open-drain rate, unused on a pure bus but must not be 0 */
+#define I3CCTRL_DEVR_SLOTS (4U)              /**< DEVRx registers, targets whose IBIs can be acknowledged */
+#define I3CCTRL_DAA_ID_BYTES (8U)            /**< PID, BCR and DCR sent by a target during ENTDAA */
+#define I3CCTRL_IBI_PAYLOAD_MAX (4U)         /**< IBIDR bytes, MAXRLR.IBIP */
+#define I3CCTRL_BCR_IBI (1U << 1)            /**< BCR: the target raises in-band interrupts */
+#define I3CCTRL_BCR_IBI_PAYLOAD (1U << 2)    /**< BCR: its interrupts carry a payload */
+#define I3CCTRL_IER_BASE (I3C_IER_FCIE | I3C_IER_ERRIE | I3C_IER_IBIIE) /**< Interrupts always enabled */
+#define I3CCTRL_FLUSH (I3C_CFGR_TXFLUSH | I3C_CFGR_RXFLUSH | I3C_CFGR_CFLUSH | I3C_CFGR_SFLUSH) /**< FIFO flushes */
+#define I3CCTRL_DMA_ERRORS (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF) /**< Channel flags ending a transaction */
+#define I3CCTRL_SPIN_LIMIT (10000U)          /**< Polls of a channel before giving up on it */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Target found by the assignment, with its in-band interrupt state.
+ */
+typedef struct
+{
+    I3cCtrl_Target_T info; /**< Address and characteristics */
+    I3cCtrl_Ibi_T ibi;     /**< Last in-band interrupt */
+    TaskHandle_t task;     /**< Task notified of its interrupts, NULL if none */
+    uint32_t bits;         /**< Notification bits set for @ref task */
+} I3cCtrl_Slot_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Transmit channel. */
+static DmaAlloc_Channel_T g_i3cCtrlTxChannel = {0};
+/** Receive channel. */
+static DmaAlloc_Channel_T g_i3cCtrlRxChannel = {0};
+/** Transactions waiting to run. */
+static I3cCtrl_Xfer_T g_i3cCtrlQueue[I3CCTRL_QUEUE_LEN];
+/** Index of the oldest waiting transaction. */
+static uint32_t g_i3cCtrlHead = 0U;
+/** Waiting transactions. */
+static uint32_t g_i3cCtrlCount = 0U;
+/** Transaction on the bus. */
+static I3cCtrl_Xfer_T g_i3cCtrlCur;
+/** Control words of the current frame. */
+static uint32_t g_i3cCtrlWords[2];
+/** Control words in ::g_i3cCtrlWords. */
+static uint32_t g_i3cCtrlWordCount = 0U;
+/** Next control word to write. */
+static uint32_t g_i3cCtrlWordNext = 0U;
+/** Outcome of the transaction so far. */
+static I3cCtrl_Result_T g_i3cCtrlResult = I3CCTRL_OK;
+/** A transaction is on the bus. */
+static volatile bool g_i3cCtrlRunning = false;
+/** Targets of the last assignment. */
+static I3cCtrl_Slot_T g_i3cCtrlTargets[I3CCTRL_MAX_TARGETS];
+/** Entries of ::g_i3cCtrlTargets in use. */
+static uint32_t g_i3cCtrlTargetCount = 0U;
+/** Address the next target of the assignment receives. */
+static uint8_t g_i3cCtrlNextDa = I3CCTRL_DA_FIRST;
+/** Counters reported by ::I3cCtrl_GetStatus. */
+static I3cCtrl_Status_T g_i3cCtrlStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Configure SCL and SDA. */
+static void I3cCtrl_InitGpio(void);
+/** Take and configure one DMA channel. */
+static bool I3cCtrl_InitChannel(DmaAlloc_Channel_T *channel, const char *owner);
+/** A transaction is acceptable. */
+static bool I3cCtrl_IsValid(const I3cCtrl_Xfer_T *xfer);
+/** Cache maintenance of the buffers before the transfer. */
+static void I3cCtrl_CleanBuffers(const I3cCtrl_Xfer_T *xfer);
+/** Queue a transaction without checking it. */
+static bool I3cCtrl_Enqueue(const I3cCtrl_Xfer_T *xfer);
+/** Queue a transaction and wait for it. */
+static I3cCtrl_Result_T I3cCtrl_Wait(const I3cCtrl_Xfer_T *xfer, uint16_t *received);
+/** Start the next transaction, if any. Interrupts masked or from an I3C or DMA interrupt. */
+static void I3cCtrl_StartNext(void);
+/** Arm one DMA block between memory and the data registers. */
+static void I3cCtrl_StartDma(const DmaAlloc_Channel_T *channel, bool read, void *buf, uint16_t len);
+/** Write control words while the control FIFO has room. */
+static void I3cCtrl_WriteWords(void);
+/** Give the next target of the assignment its address. */
+static void I3cCtrl_DaaTarget(void);
+/** Read and dispatch an in-band interrupt. */
+static void I3cCtrl_Ibi(void);
+/** Close the DMA blocks of the frame. */
+static uint16_t I3cCtrl_StopDma(void);
+/** End the transaction and start the next one. */
+static void I3cCtrl_Finish(void);
+/** Flush the FIFOs and reset both channels after a failure. */
+static void I3cCtrl_Abort(I3cCtrl_Result_T result);
+/** Stop a channel. */
+static void I3cCtrl_ResetChannel(const DmaAlloc_Channel_T *channel);
+/** Target slot of a dynamic address. */
+static I3cCtrl_Slot_T *I3cCtrl_FindSlot(uint8_t addr);
+/** I3C event interrupt, bound through the ISR manager. */
+static void I3cCtrl_EvIrqHandler(void *ctx);
+/** I3C error interrupt, bound through the ISR manager. */
+static void I3cCtrl_ErIrqHandler(void *ctx);
+/** DMA channel interrupt, only raised by errors. */
+static void I3cCtrl_DmaIrqHandler(void *ctx);
+/** Completion callback of the blocking calls. */
+static void I3cCtrl_WakeWaiter(void *ctx, I3cCtrl_Result_T result, uint16_t received);
+/** Register block of a channel. */
+static DMA_Channel_TypeDef *I3cCtrl_Regs(const DmaAlloc_Channel_T *channel);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable I3C1 as controller, program the bus timing and take the DMA channels.
+ *
+ * The SCL waveform comes from the ST timing utility for a pure I3C bus at
+ * a 50 % duty cycle. IBI payloads up to four bytes are accepted.
+ */
+bool I3cCtrl_Init(void)
+{
+    I3cCtrl_InitGpio();
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_I3C1);
+    LL_RCC_SetI3CClockSource(LL_RCC_I3C1_CLKSOURCE_PCLK1);
+    uint32_t kernelHz = LL_RCC_GetI3CClockFreq(LL_RCC_I3C1_CLKSOURCE);
+
+    const I3C_CtrlTimingTypeDef timing = {
+        .clockSrcFreq = kernelHz,
+        .i3cPPFreq = I3CCTRL_SDR_HZ,
+        .i2cODFreq = I3CCTRL_OD_HZ,
+        .dutyCycle = 50U,
+        .busType = I3C_PURE_I3C_BUS,
+    };
+    LL_I3C_InitTypeDef init;
+    LL_I3C_StructInit(&init);
+    if (I3C_CtrlTimingComputation(&timing, &init.CtrlBusCharacteristic) != SUCCESS)
+    {
+        return false;
+    }
+
+    if (!I3cCtrl_InitChannel(&g_i3cCtrlTxChannel, "I3cCtrl tx") ||
+        !I3cCtrl_InitChannel(&g_i3cCtrlRxChannel, "I3cCtrl rx"))
+    {
+        return false;
+    }
+
+    if (!IsrMgr_Register(I3C1_EV_IRQn, I3cCtrl_EvIrqHandler, NULL) ||
+        !IsrMgr_Register(I3C1_ER_IRQn, I3cCtrl_ErIrqHandler, NULL))
+    {
+        return false;
+    }
+
+    (void)LL_I3C_Init(I3CCTRL_INSTANCE, &init, LL_I3C_MODE_CONTROLLER);
+    WRITE_REG(I3CCTRL_INSTANCE->MAXRLR, I3CCTRL_IBI_PAYLOAD_MAX << I3C_MAXRLR_IBIP_Pos);
+    WRITE_REG(I3CCTRL_INSTANCE->IER, I3CCTRL_IER_BASE);
+
+    uint32_t period = (uint32_t)init.CtrlBusCharacteristic.SCLPPLowDuration +
+                      (uint32_t)init.CtrlBusCharacteristic.SCLI3CHighDuration + 2U;
+    g_i3cCtrlStatus.actual_hz = kernelHz / period;
+
+    const IRQn_Type irqs[2] = {I3C1_EV_IRQn, I3C1_ER_IRQn};
+    for (uint32_t i = 0U; i < 2U; i++)
+    {
+        NVIC_SetPriority(irqs[i], NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                      configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+        NVIC_EnableIRQ(irqs[i]);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a transaction.
+ *
+ * Cache maintenance runs in the caller.
+ */
+bool I3cCtrl_Submit(const I3cCtrl_Xfer_T *xfer)
+{
+    if (!I3cCtrl_IsValid(xfer))
+    {
+        return false;
+    }
+
+    I3cCtrl_CleanBuffers(xfer);
+    return I3cCtrl_Enqueue(xfer);
+}
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ */
+I3cCtrl_Result_T I3cCtrl_TransferWait(const I3cCtrl_Xfer_T *xfer, uint16_t *received)
+{
+    if (!I3cCtrl_IsValid(xfer))
+    {
+        return I3CCTRL_ERR_PARAM;
+    }
+    return I3cCtrl_Wait(xfer, received);
+}
+
+/**
+ * @brief Private write then read after a repeated START.
+ */
+I3cCtrl_Result_T I3cCtrl_WriteRead(uint8_t addr, const void *wr, uint16_t wlen, void *rd, uint16_t rlen)
+{
+    const I3cCtrl_Xfer_T xfer = {
+        .addr = addr,
+        .ccc = I3CCTRL_NO_CCC,
+        .tx = wr,
+        .tx_len = wlen,
+        .rx = rd,
+        .rx_len = rlen,
+    };
+
+    return I3cCtrl_TransferWait(&xfer, NULL);
+}
+
+/**
+ * @brief Send a CCC with optional data.
+ */
+I3cCtrl_Result_T I3cCtrl_Ccc(uint8_t ccc, uint8_t addr, const void *data, uint16_t len)
+{
+    const I3cCtrl_Xfer_T xfer = {
+        .addr = addr,
+        .ccc = ccc,
+        .tx = data,
+        .tx_len = len,
+    };
+
+    return I3cCtrl_TransferWait(&xfer, NULL);
+}
+
+/**
+ * @brief Reset and assign the dynamic addresses, then enable in-band interrupts.
+ *
+ * The first ::I3CCTRL_DEVR_SLOTS targets are entered in the DEVRx
+ * registers, which decide whether their in-band interrupts are
+ * acknowledged and whether a payload is read.
+ */
+I3cCtrl_Result_T I3cCtrl_AssignAddresses(uint32_t *found)
+{
+    const I3cCtrl_Xfer_T daa = {
+        .addr = I3CCTRL_BROADCAST,
+        .ccc = I3CCTRL_CCC_ENTDAA,
+    };
+    I3cCtrl_Result_T result = I3cCtrl_Ccc(I3CCTRL_CCC_RSTDAA, I3CCTRL_BROADCAST, NULL, 0U);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0U; i < I3CCTRL_DEVR_SLOTS; i++)
+    {
+        WRITE_REG(I3CCTRL_INSTANCE->DEVRX[i], 0U);
+    }
+    g_i3cCtrlTargetCount = 0U;
+    g_i3cCtrlNextDa = I3CCTRL_DA_FIRST;
+    g_i3cCtrlStatus.targets = 0U;
+    __set_PRIMASK(primask);
+
+    if (result == I3CCTRL_OK)
+    {
+        result = I3cCtrl_Wait(&daa, NULL);
+    }
+
+    bool events = false;
+    for (uint32_t i = 0U; (i < g_i3cCtrlTargetCount) && (i < I3CCTRL_DEVR_SLOTS); i++)
+    {
+        const I3cCtrl_Target_T *t = &g_i3cCtrlTargets[i].info;
+        uint32_t devr = (uint32_t)t->dyn_addr << I3C_DEVRX_DA_Pos;
+        if ((t->bcr & I3CCTRL_BCR_IBI) != 0U)
+        {
+            devr |= I3C_DEVRX_IBIACK;
+            events = true;
+        }
+        if ((t->bcr & I3CCTRL_BCR_IBI_PAYLOAD) != 0U)
+        {
+            devr |= I3C_DEVRX_IBIDEN;
+        }
+        WRITE_REG(I3CCTRL_INSTANCE->DEVRX[i], devr);
+    }
+
+    if ((result == I3CCTRL_OK) && events)
+    {
+        static const uint8_t enint = I3CCTRL_EVENT_INT;
+        result = I3cCtrl_Ccc(I3CCTRL_CCC_ENEC, I3CCTRL_BROADCAST, &enint, 1U);
+    }
+
+    if (found != NULL)
+    {
+        *found = g_i3cCtrlStatus.targets;
+    }
+    return result;
+}
+
+/**
+ * @brief Copy a target of the last assignment.
+ */
+bool I3cCtrl_GetTarget(uint32_t index, I3cCtrl_Target_T *target)
+{
+    if ((target == NULL) || (index >= g_i3cCtrlTargetCount))
+    {
+        return false;
+    }
+    *target = g_i3cCtrlTargets[index].info;
+    return true;
+}
+
+/**
+ * @brief Record the task notified of the in-band interrupts of a target.
+ */
+bool I3cCtrl_IbiSubscribe(uint8_t addr, TaskHandle_t task, uint32_t bits)
+{
+    I3cCtrl_Slot_T *slot = I3cCtrl_FindSlot(addr);
+
+    if (slot == NULL)
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    slot->task = task;
+    slot->bits = bits;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Copy the last in-band interrupt of a target.
+ */
+bool I3cCtrl_IbiRead(uint8_t addr, I3cCtrl_Ibi_T *ibi)
+{
+    I3cCtrl_Slot_T *slot = I3cCtrl_FindSlot(addr);
+
+    if ((slot == NULL) || (ibi == NULL))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *ibi = slot->ibi;
+    __set_PRIMASK(primask);
+    return true;
+}
+
+/**
+ * @brief Copy the driver counters into @p status.
+ */
+void I3cCtrl_GetStatus(I3cCtrl_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_i3cCtrlStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Configure SCL and SDA as push-pull alternate function.
+ *
+ * The controller drives both lines in push-pull phases and enables its
+ * own SDA pull-up in open-drain phases, so no GPIO pull is used.
+ */
+static void I3cCtrl_InitGpio(void)
+{
+    LL_GPIO_InitTypeDef gpio_h;
+
+    LL_AHB4_GRP1_EnableClock(LL_AHB4_GRP1_PERIPH_GPIOB);
+
+    gpio_h.Pin = I3CCTRL_PINS;
+    gpio_h.Mode = LL_GPIO_MODE_ALTERNATE;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = LL_GPIO_PULL_NO;
+    gpio_h.Alternate = I3CCTRL_PINS_AF;
+    LL_GPIO_Init(I3CCTRL_PINS_PORT, &gpio_h);
+}
+
+/**
+ * @brief Take a GPDMA1 channel and bind its error interrupt.
+ */
+static bool I3cCtrl_InitChannel(DmaAlloc_Channel_T *channel, const char *owner)
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = DMAALLOC_CLASS_NORMAL,
+        .caps = 0U,
+        .burst_bytes = 0U,
+        .owner = owner,
+        .handler = I3cCtrl_DmaIrqHandler,
+        .ctx = NULL,
+    };
+
+    if (!DmaAlloc_Request(&request, channel))
+    {
+        return false;
+    }
+
+    LL_DMA_ConfigControl(channel->instance, channel->channel, channel->priority);
+    LL_DMA_EnableIT_DTE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_ULE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_USE(channel->instance, channel->channel);
+    NVIC_SetPriority(channel->irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                       configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(channel->irq);
+    return true;
+}
+
+/**
+ * @brief A transaction is acceptable.
+ *
+ * ENTDAA is only run by ::I3cCtrl_AssignAddresses, which owns the address
+ * table it fills.
+ */
+static bool I3cCtrl_IsValid(const I3cCtrl_Xfer_T *xfer)
+{
+    if ((xfer == NULL) || ((xfer->tx_len != 0U) && (xfer->tx == NULL)) ||
+        ((xfer->rx_len != 0U) && (xfer->rx == NULL)))
+    {
+        return false;
+    }
+
+    bool targeted = (xfer->addr <= 0x7FU) && (xfer->addr != I3CCTRL_BROADCAST);
+    if (xfer->ccc == I3CCTRL_NO_CCC)
+    {
+        return targeted && ((xfer->tx_len != 0U) || (xfer->rx_len != 0U));
+    }
+    if (xfer->ccc == I3CCTRL_CCC_ENTDAA)
+    {
+        return false;
+    }
+    if (xfer->ccc < 0x80U)
+    {
+        return (xfer->addr == I3CCTRL_BROADCAST) && (xfer->rx_len == 0U);
+    }
+    return targeted && ((xfer->tx_len == 0U) != (xfer->rx_len == 0U));
+}
+
+/**
+ * @brief Clean the write buffer, clean and invalidate the read buffer.
+ *
+ * Invalidating the read buffer as well keeps a dirty line from being
+ * evicted over the received bytes.
+ */
+static void I3cCtrl_CleanBuffers(const I3cCtrl_Xfer_T *xfer)
+{
+    if ((xfer->tx_len != 0U) && !DmaPool_IsNonCacheable(xfer->tx, xfer->tx_len))
+    {
+        SCB_CleanDCache_by_Addr((void *)xfer->tx, (int32_t)xfer->tx_len);
+    }
+    if ((xfer->rx_len != 0U) && !DmaPool_IsNonCacheable(xfer->rx, xfer->rx_len))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(xfer->rx, (int32_t)xfer->rx_len);
+    }
+}
+
+/**
+ * @brief Queue a transaction, starting it if the bus is idle.
+ */
+static bool I3cCtrl_Enqueue(const I3cCtrl_Xfer_T *xfer)
+{
+    bool queued = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_i3cCtrlCount < I3CCTRL_QUEUE_LEN)
+    {
+        g_i3cCtrlQueue[(g_i3cCtrlHead + g_i3cCtrlCount) % I3CCTRL_QUEUE_LEN] = *xfer;
+        g_i3cCtrlCount++;
+        if (!g_i3cCtrlRunning)
+        {
+            I3cCtrl_StartNext();
+        }
+        if (g_i3cCtrlCount > g_i3cCtrlStatus.queue_peak)
+        {
+            g_i3cCtrlStatus.queue_peak = g_i3cCtrlCount;
+        }
+    }
+    else
+    {
+        g_i3cCtrlStatus.queue_full++;
+        queued = false;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Queue a transaction and block until its callback.
+ *
+ * The notification value carries the result in bits 15:0 and the bytes
+ * read in bits 31:16.
+ */
+static I3cCtrl_Result_T I3cCtrl_Wait(const I3cCtrl_Xfer_T *xfer, uint16_t *received)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+    I3cCtrl_Xfer_T copy = *xfer;
+
+    copy.cb = I3cCtrl_WakeWaiter;
+    copy.ctx = self;
+    I3cCtrl_CleanBuffers(&copy);
+
+    xTaskNotifyStateClearIndexed(self, I3CCTRL_NOTIFY_INDEX);
+    while (!I3cCtrl_Enqueue(&copy))
+    {
+        vTaskDelay(1);
+    }
+    (void)xTaskNotifyWaitIndexed(I3CCTRL_NOTIFY_INDEX, 0U, UINT32_MAX, &value, portMAX_DELAY);
+
+    if (received != NULL)
+    {
+        *received = (uint16_t)(value >> 16);
+    }
+    return (I3cCtrl_Result_T)(value & 0xFFFFU);
+}
+
+/**
+ * @brief Start the next transaction, if any.
+ *
+ * Builds the control words, arms the DMA blocks and writes the words the
+ * control FIFO takes; ENTDAA also enables TXFNF, where the addresses are
+ * given.
+ */
+static void I3cCtrl_StartNext(void)
+{
+    if (g_i3cCtrlCount == 0U)
+    {
+        g_i3cCtrlRunning = false;
+        return;
+    }
+
+    const I3cCtrl_Xfer_T *x = &g_i3cCtrlQueue[g_i3cCtrlHead];
+    g_i3cCtrlCur = *x;
+    g_i3cCtrlHead = (g_i3cCtrlHead + 1U) % I3CCTRL_QUEUE_LEN;
+    g_i3cCtrlCount--;
+    g_i3cCtrlResult = I3CCTRL_OK;
+    g_i3cCtrlRunning = true;
+    x = &g_i3cCtrlCur;
+
+    uint32_t addr = (uint32_t)x->addr << I3C_CR_ADD_Pos;
+    uint32_t ccc = (uint32_t)x->ccc << I3C_CR_CCC_Pos;
+    g_i3cCtrlWordCount = 0U;
+    g_i3cCtrlWordNext = 0U;
+    if (x->ccc == I3CCTRL_NO_CCC)
+    {
+        if (x->tx_len != 0U)
+        {
+            g_i3cCtrlWords[g_i3cCtrlWordCount++] = LL_I3C_CONTROLLER_MTYPE_PRIVATE | addr | x->tx_len |
+                                                   ((x->rx_len == 0U) ? I3C_CR_MEND : 0U);
+        }
+        if (x->rx_len != 0U)
+        {
+            g_i3cCtrlWords[g_i3cCtrlWordCount++] = LL_I3C_CONTROLLER_MTYPE_PRIVATE | addr | I3C_CR_RNW |
+                                                   x->rx_len | I3C_CR_MEND;
+        }
+    }
+    else if (x->ccc < 0x80U)
+    {
+        g_i3cCtrlWords[g_i3cCtrlWordCount++] = LL_I3C_CONTROLLER_MTYPE_CCC | ccc | x->tx_len | I3C_CR_MEND;
+    }
+    else
+    {
+        g_i3cCtrlWords[g_i3cCtrlWordCount++] = LL_I3C_CONTROLLER_MTYPE_CCC | ccc;
+        g_i3cCtrlWords[g_i3cCtrlWordCount++] = LL_I3C_CONTROLLER_MTYPE_DIRECT | addr | I3C_CR_MEND |
+                                               ((x->rx_len != 0U) ? (I3C_CR_RNW | x->rx_len) : x->tx_len);
+    }
+
+    uint32_t cfgr = READ_REG(I3CCTRL_INSTANCE->CFGR) & ~(I3C_CFGR_TXDMAEN | I3C_CFGR_RXDMAEN);
+    if (x->tx_len != 0U)
+    {
+        I3cCtrl_StartDma(&g_i3cCtrlTxChannel, false, (void *)x->tx, x->tx_len);
+        cfgr |= I3C_CFGR_TXDMAEN;
+    }
+    if (x->rx_len != 0U)
+    {
+        I3cCtrl_StartDma(&g_i3cCtrlRxChannel, true, x->rx, x->rx_len);
+        cfgr |= I3C_CFGR_RXDMAEN;
+    }
+    WRITE_REG(I3CCTRL_INSTANCE->CFGR, cfgr);
+
+    WRITE_REG(I3CCTRL_INSTANCE->IER,
+              I3CCTRL_IER_BASE | ((x->ccc == I3CCTRL_CCC_ENTDAA) ? I3C_IER_TXFNFIE : 0U));
+    I3cCtrl_WriteWords();
+}
+
+/**
+ * @brief Arm one DMA block between memory and RDR or TDR.
+ */
+static void I3cCtrl_StartDma(const DmaAlloc_Channel_T *channel, bool read, void *buf, uint16_t len)
+{
+    DMA_Channel_TypeDef *regs = I3cCtrl_Regs(channel);
+
+    WRITE_REG(regs->CTR1, (read ? LL_DMA_DEST_INCREMENT : LL_DMA_SRC_INCREMENT) | LL_DMA_SRC_DATAWIDTH_BYTE |
+                              LL_DMA_DEST_DATAWIDTH_BYTE);
+    WRITE_REG(regs->CTR2, read ? (LL_GPDMA1_REQUEST_I3C1_RX | LL_DMA_DIRECTION_PERIPH_TO_MEMORY)
+                               : (LL_GPDMA1_REQUEST_I3C1_TX | LL_DMA_DIRECTION_MEMORY_TO_PERIPH));
+    WRITE_REG(regs->CBR1, len);
+    WRITE_REG(regs->CSAR, read ? (uint32_t)&I3CCTRL_INSTANCE->RDR : (uint32_t)buf);
+    WRITE_REG(regs->CDAR, read ? (uint32_t)buf : (uint32_t)&I3CCTRL_INSTANCE->TDR);
+    WRITE_REG(regs->CLLR, 0U);
+    DmaAlloc_NoteStart(channel, len);
+    __DMB();
+    LL_DMA_EnableChannel(channel->instance, channel->channel);
+}
+
+/**
+ * @brief Write control words while the control FIFO has room.
+ *
+ * CFNF stays enabled only while words remain.
+ */
+static void I3cCtrl_WriteWords(void)
+{
+    while ((g_i3cCtrlWordNext < g_i3cCtrlWordCount) && ((READ_REG(I3CCTRL_INSTANCE->EVR) & I3C_EVR_CFNFF) != 0U))
+    {
+        WRITE_REG(I3CCTRL_INSTANCE->CR, g_i3cCtrlWords[g_i3cCtrlWordNext]);
+        g_i3cCtrlWordNext++;
+    }
+
+    if (g_i3cCtrlWordNext < g_i3cCtrlWordCount)
+    {
+        SET_BIT(I3CCTRL_INSTANCE->IER, I3C_IER_CFNFIE);
+    }
+    else
+    {
+        CLEAR_BIT(I3CCTRL_INSTANCE->IER, I3C_IER_CFNFIE);
+    }
+}
+
+/**
+ * @brief Give the next target of the assignment its address.
+ *
+ * The target ID arrives most significant byte first: 48-bit PID, BCR,
+ * DCR. Targets beyond ::I3CCTRL_MAX_TARGETS still get an address so the
+ * assignment completes, but are not recorded.
+ */
+static void I3cCtrl_DaaTarget(void)
+{
+    uint8_t id[I3CCTRL_DAA_ID_BYTES];
+
+    for (uint32_t i = 0U; i < I3CCTRL_DAA_ID_BYTES; i++)
+    {
+        id[i] = (uint8_t)READ_REG(I3CCTRL_INSTANCE->RDR);
+    }
+
+    uint8_t da = g_i3cCtrlNextDa++;
+    WRITE_REG(I3CCTRL_INSTANCE->TDR, da);
+
+    g_i3cCtrlStatus.targets++;
+    if (g_i3cCtrlTargetCount < I3CCTRL_MAX_TARGETS)
+    {
+        I3cCtrl_Slot_T *slot = &g_i3cCtrlTargets[g_i3cCtrlTargetCount++];
+        uint64_t pid = 0U;
+        for (uint32_t i = 0U; i < 6U; i++)
+        {
+            pid = (pid << 8) | id[i];
+        }
+        *slot = (I3cCtrl_Slot_T){0};
+        slot->info.dyn_addr = da;
+        slot->info.pid = pid;
+        slot->info.bcr = id[6];
+        slot->info.dcr = id[7];
+    }
+}
+
+/**
+ * @brief Read and dispatch an in-band interrupt.
+ *
+ * RMR gives the source address and payload size, IBIDR the payload. The
+ * subscribed task is notified at ::I3CCTRL_IBI_NOTIFY_INDEX.
+ */
+static void I3cCtrl_Ibi(void)
+{
+    uint32_t rmr = READ_REG(I3CCTRL_INSTANCE->RMR);
+    uint8_t addr = (uint8_t)((rmr & I3C_RMR_RADD) >> I3C_RMR_RADD_Pos);
+    uint8_t len = (uint8_t)(rmr & I3C_RMR_IBIRDCNT);
+    uint32_t payload = (len != 0U) ? READ_REG(I3CCTRL_INSTANCE->IBIDR) : 0U;
+
+    WRITE_REG(I3CCTRL_INSTANCE->CEVR, I3C_CEVR_CIBIF);
+
+    I3cCtrl_Slot_T *slot = I3cCtrl_FindSlot(addr);
+    if (slot == NULL)
+    {
+        g_i3cCtrlStatus.ibis_unclaimed++;
+        return;
+    }
+
+    slot->ibi.payload = payload;
+    slot->ibi.len = len;
+    slot->ibi.count++;
+    if (slot->task == NULL)
+    {
+        g_i3cCtrlStatus.ibis_unclaimed++;
+    }
+    else
+    {
+        BaseType_t woken = pdFALSE;
+        g_i3cCtrlStatus.ibis++;
+        xTaskNotifyIndexedFromISR(slot->task, I3CCTRL_IBI_NOTIFY_INDEX, slot->bits, eSetBits, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Close the DMA blocks of the frame.
+ *
+ * SR.XDCNT holds the bytes of the last message, the read when there is
+ * one. The receive channel is given a short time to move them; a read the
+ * target ended early leaves the channel waiting, so it is reset.
+ *
+ * @return Bytes read.
+ */
+static uint16_t I3cCtrl_StopDma(void)
+{
+    const I3cCtrl_Xfer_T *x = &g_i3cCtrlCur;
+    uint16_t received = 0U;
+
+    if (x->tx_len != 0U)
+    {
+        const DmaAlloc_Channel_T *tx = &g_i3cCtrlTxChannel;
+        uint32_t spin = I3CCTRL_SPIN_LIMIT;
+        while ((LL_DMA_IsEnabledChannel(tx->instance, tx->channel) != 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+        if (spin == 0U)
+        {
+            I3cCtrl_ResetChannel(tx);
+            g_i3cCtrlResult = (g_i3cCtrlResult == I3CCTRL_OK) ? I3CCTRL_ERR_DMA : g_i3cCtrlResult;
+        }
+        else
+        {
+            DmaAlloc_NoteStop(tx);
+        }
+    }
+
+    if (x->rx_len != 0U)
+    {
+        const DmaAlloc_Channel_T *rx = &g_i3cCtrlRxChannel;
+        uint32_t xdcnt = READ_REG(I3CCTRL_INSTANCE->SR) & I3C_SR_XDCNT;
+        received = (uint16_t)((xdcnt < x->rx_len) ? xdcnt : x->rx_len);
+
+        uint32_t left = (uint32_t)x->rx_len - received;
+        uint32_t spin = I3CCTRL_SPIN_LIMIT;
+        while ((LL_DMA_IsEnabledChannel(rx->instance, rx->channel) != 0U) &&
+               ((READ_REG(I3cCtrl_Regs(rx)->CBR1) & DMA_CBR1_BNDT) > left) && (spin > 0U))
+        {
+            spin--;
+        }
+        if (LL_DMA_IsEnabledChannel(rx->instance, rx->channel) != 0U)
+        {
+            I3cCtrl_ResetChannel(rx);
+            if (spin == 0U)
+            {
+                g_i3cCtrlResult = (g_i3cCtrlResult == I3CCTRL_OK) ? I3CCTRL_ERR_DMA : g_i3cCtrlResult;
+            }
+            else
+            {
+                g_i3cCtrlStatus.short_reads++;
+            }
+        }
+        else
+        {
+            DmaAlloc_NoteStop(rx);
+        }
+    }
+    return received;
+}
+
+/**
+ * @brief End the transaction and start the next one.
+ *
+ * The next transaction is started before the callback, so the bus only
+ * waits for the CPU while the queue is empty.
+ */
+static void I3cCtrl_Finish(void)
+{
+    I3cCtrl_Xfer_T done = g_i3cCtrlCur;
+    uint16_t received = I3cCtrl_StopDma();
+    I3cCtrl_Result_T result = g_i3cCtrlResult;
+
+    CLEAR_BIT(I3CCTRL_INSTANCE->CFGR, I3C_CFGR_TXDMAEN | I3C_CFGR_RXDMAEN);
+    WRITE_REG(I3CCTRL_INSTANCE->IER, I3CCTRL_IER_BASE);
+
+    switch (result)
+    {
+    case I3CCTRL_OK:
+        g_i3cCtrlStatus.xfers_done++;
+        g_i3cCtrlStatus.bytes += (uint64_t)done.tx_len + received;
+        if ((received != 0U) && !DmaPool_IsNonCacheable(done.rx, done.rx_len))
+        {
+            SCB_InvalidateDCache_by_Addr(done.rx, (int32_t)done.rx_len);
+        }
+        break;
+    case I3CCTRL_ERR_NACK:
+        g_i3cCtrlStatus.nacks++;
+        received = 0U;
+        break;
+    case I3CCTRL_ERR_DMA:
+        g_i3cCtrlStatus.dma_errors++;
+        received = 0U;
+        break;
+    default:
+        g_i3cCtrlStatus.bus_errors++;
+        received = 0U;
+        break;
+    }
+
+    g_i3cCtrlRunning = false;
+    I3cCtrl_StartNext();
+
+    if (done.cb != NULL)
+    {
+        done.cb(done.ctx, result, received);
+    }
+}
+
+/**
+ * @brief Flush the FIFOs and reset both channels after a failure.
+ *
+ * The peripheral has already sent STOP; the flush drops control words and
+ * data of the abandoned frame.
+ */
+static void I3cCtrl_Abort(I3cCtrl_Result_T result)
+{
+    I3cCtrl_ResetChannel(&g_i3cCtrlTxChannel);
+    I3cCtrl_ResetChannel(&g_i3cCtrlRxChannel);
+    SET_BIT(I3CCTRL_INSTANCE->CFGR, I3CCTRL_FLUSH);
+
+    if (g_i3cCtrlRunning)
+    {
+        /* Both channels are already stopped, nothing left for I3cCtrl_StopDma */
+        g_i3cCtrlCur.tx_len = 0U;
+        g_i3cCtrlCur.rx_len = 0U;
+        g_i3cCtrlResult = result;
+        I3cCtrl_Finish();
+    }
+}
+
+/**
+ * @brief Stop a channel.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void I3cCtrl_ResetChannel(const DmaAlloc_Channel_T *channel)
+{
+    if (LL_DMA_IsEnabledChannel(channel->instance, channel->channel) != 0U)
+    {
+        uint32_t spin = I3CCTRL_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(channel->instance, channel->channel);
+        while ((LL_DMA_IsActiveFlag_SUSP(channel->instance, channel->channel) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(channel->instance, channel->channel);
+    DmaAlloc_NoteStop(channel);
+    WRITE_REG(I3cCtrl_Regs(channel)->CFCR, DMA_CFCR_TCF | DMA_CFCR_HTF | DMA_CFCR_DTEF | DMA_CFCR_ULEF |
+                                               DMA_CFCR_USEF | DMA_CFCR_SUSPF | DMA_CFCR_TOF);
+}
+
+/**
+ * @brief Target slot of a dynamic address, NULL if none.
+ */
+static I3cCtrl_Slot_T *I3cCtrl_FindSlot(uint8_t addr)
+{
+    for (uint32_t i = 0U; i < g_i3cCtrlTargetCount; i++)
+    {
+        if (g_i3cCtrlTargets[i].info.dyn_addr == addr)
+        {
+            return &g_i3cCtrlTargets[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief I3C event interrupt.
+ *
+ * - IBIF: an in-band interrupt was received, between frames.
+ * - CFNF: room for the next control word of the frame.
+ * - TXFNF during ENTDAA: a target sent its ID and waits for its address.
+ * - FCF: the frame is over.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I3cCtrl_EvIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t evr = READ_REG(I3CCTRL_INSTANCE->EVR);
+    uint32_t ier = READ_REG(I3CCTRL_INSTANCE->IER);
+
+    g_i3cCtrlStatus.irqs++;
+    if ((evr & I3C_EVR_IBIF) != 0U)
+    {
+        I3cCtrl_Ibi();
+    }
+
+    if (!g_i3cCtrlRunning)
+    {
+        WRITE_REG(I3CCTRL_INSTANCE->CEVR, evr & I3C_CEVR_CFCF);
+        return;
+    }
+
+    if (((evr & I3C_EVR_CFNFF) != 0U) && ((ier & I3C_IER_CFNFIE) != 0U))
+    {
+        I3cCtrl_WriteWords();
+    }
+    if (((evr & I3C_EVR_TXFNFF) != 0U) && ((ier & I3C_IER_TXFNFIE) != 0U))
+    {
+        I3cCtrl_DaaTarget();
+    }
+    if ((evr & I3C_EVR_FCF) != 0U)
+    {
+        WRITE_REG(I3CCTRL_INSTANCE->CEVR, I3C_CEVR_CFCF);
+        I3cCtrl_Finish();
+    }
+}
+
+/**
+ * @brief I3C error interrupt.
+ *
+ * A NACK of the address or of the data is reported as such; protocol,
+ * parity, FIFO and stall errors as bus errors.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I3cCtrl_ErIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t evr = READ_REG(I3CCTRL_INSTANCE->EVR);
+
+    g_i3cCtrlStatus.irqs++;
+    if ((evr & I3C_EVR_ERRF) == 0U)
+    {
+        return;
+    }
+
+    uint32_t ser = READ_REG(I3CCTRL_INSTANCE->SER);
+    WRITE_REG(I3CCTRL_INSTANCE->CEVR, I3C_CEVR_CERRF);
+    I3cCtrl_Abort(((ser & (I3C_SER_ANACK | I3C_SER_DNACK)) != 0U) ? I3CCTRL_ERR_NACK : I3CCTRL_ERR_BUS);
+}
+
+/**
+ * @brief DMA channel interrupt, only raised by errors.
+ *
+ * @param[in] ctx Unused.
+ */
+static void I3cCtrl_DmaIrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t tx = READ_REG(I3cCtrl_Regs(&g_i3cCtrlTxChannel)->CSR) & I3CCTRL_DMA_ERRORS;
+    uint32_t rx = READ_REG(I3cCtrl_Regs(&g_i3cCtrlRxChannel)->CSR) & I3CCTRL_DMA_ERRORS;
+
+    if ((tx | rx) != 0U)
+    {
+        I3cCtrl_Abort(I3CCTRL_ERR_DMA);
+    }
+}
+
+/**
+ * @brief Completion callback of the blocking calls.
+ *
+ * Runs from an interrupt, so the notification uses the ISR API.
+ *
+ * @param[in] ctx      Handle of the waiting task.
+ * @param[in] result   Transaction outcome.
+ * @param[in] received Bytes read.
+ */
+static void I3cCtrl_WakeWaiter(void *ctx, I3cCtrl_Result_T result, uint16_t received)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+    uint32_t value = (uint32_t)result | ((uint32_t)received << 16);
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, I3CCTRL_NOTIFY_INDEX, value, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, I3CCTRL_NOTIFY_INDEX, value, eSetValueWithOverwrite);
+    }
+}
+
+/**
+ * @brief Register block of a channel.
+ */
+static DMA_Channel_TypeDef *I3cCtrl_Regs(const DmaAlloc_Channel_T *channel)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)channel->instance + LL_DMA_CH_OFFSET_TAB[channel->channel]);
+}
+
+/** @} */ // end of I3cCtrl group
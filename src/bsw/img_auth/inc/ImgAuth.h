@@ -0,0 +1,173 @@
+/**
+ * @file ImgAuth.h
+ * @brief Authentication of a next-stage image by its signed header
+ *
+ * An image starts with a header holding the SHA-256 digest of the
+ * payload and a signature over the header, so verification costs one
+ * signature check whatever the image size, plus one pass of SHA-256 over
+ * the payload:
+ *
+ * @verbatim
+   +-------------------+  0
+   | ImgAuth_Header_T  |  signed part, 60 bytes
+   +-------------------+
+   | signature         |  sig_size bytes
+   | padding           |
+   +-------------------+  header_size
+   | payload           |  image_size bytes
+   +-------------------+
+   @endverbatim
+ *
+ * Supported signatures, both over the SHA-256 digest of the signed part:
+ *  - ECDSA on P-256, r then s, 32 bytes each, big-endian,
+ *  - RSA PKCS#1 v1.5 with SHA-256, the size of the modulus, up to 4096
+ *    bits.
+ *
+ * The signature is checked on the PKA or by its software reference, as
+ * chosen by the caller, and the cost of each step is reported in CPU
+ * cycles so the boot time of both can be compared. Public keys are
+ * trusted: they are expected to come from the boot image itself or from
+ * OTP, and are not validated.
+ */
+
+#ifndef IMG_AUTH_H
+#define IMG_AUTH_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#define IMGAUTH_MAGIC          (0x41474D49U) /**< "IMGA" read as a little-endian word */
+#define IMGAUTH_HEADER_VERSION (1U)          /**< Header layout described here */
+#define IMGAUTH_HASH_SIZE      (32U)         /**< SHA-256 digest */
+#define IMGAUTH_MAX_SIG_SIZE   (512U)        /**< Largest signature, RSA-4096 */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Signature schemes.
+ */
+typedef enum
+{
+    IMGAUTH_SIG_ECDSA_P256 = 1,   /**< ECDSA P-256 with SHA-256 */
+    IMGAUTH_SIG_RSA_PKCS1 = 2,    /**< RSA PKCS#1 v1.5 with SHA-256 */
+} ImgAuth_SigType_T;
+
+/**
+ * @brief Where the signature is checked.
+ */
+typedef enum
+{
+    IMGAUTH_ENGINE_PKA = 0,  /**< PKA, ::Pka_Init must have run */
+    IMGAUTH_ENGINE_SW,       /**< Software reference */
+} ImgAuth_Engine_T;
+
+/**
+ * @brief Verification result.
+ */
+typedef enum
+{
+    IMGAUTH_OK = 0,          /**< Image authentic */
+    IMGAUTH_ERR_FORMAT,      /**< Bad magic, version or sizes */
+    IMGAUTH_ERR_KEY,         /**< No key with the header key id and signature type */
+    IMGAUTH_ERR_SIGNATURE,   /**< Signature does not verify */
+    IMGAUTH_ERR_HASH,        /**< Payload does not match the signed digest */
+    IMGAUTH_ERR_ENGINE,      /**< PKA busy or failed */
+} ImgAuth_Result_T;
+
+/**
+ * @brief Signed part of the image header, all fields little-endian.
+ */
+typedef struct
+{
+    uint32_t magic;          /**< ::IMGAUTH_MAGIC */
+    uint16_t header_version; /**< ::IMGAUTH_HEADER_VERSION */
+    uint16_t header_size;    /**< Offset of the payload */
+    uint32_t image_size;     /**< Payload bytes */
+    uint32_t load_addr;      /**< Where the payload is to be loaded */
+    uint32_t entry;          /**< Entry point */
+    uint32_t image_version;  /**< Image version, for anti-rollback by the caller */
+    uint8_t sig_type;        /**< ::ImgAuth_SigType_T */
+    uint8_t key_id;          /**< Key to verify with */
+    uint16_t sig_size;       /**< Signature bytes following the header */
+    uint8_t hash[IMGAUTH_HASH_SIZE]; /**< SHA-256 of the payload */
+} ImgAuth_Header_T;
+
+/**
+ * @brief Public key, big-endian numbers.
+ */
+typedef struct
+{
+    uint8_t sig_type;          /**< ::ImgAuth_SigType_T */
+    uint8_t key_id;            /**< Matched against the header */
+    const uint8_t *x;          /**< ECDSA: public point x, 32 bytes */
+    const uint8_t *y;          /**< ECDSA: public point y, 32 bytes */
+    const uint8_t *modulus;    /**< RSA: modulus */
+    uint32_t mod_size;         /**< RSA: bytes of the modulus, also the signature size */
+    const uint8_t *exponent;   /**< RSA: public exponent */
+    uint32_t exp_size;         /**< RSA: bytes of the exponent */
+} ImgAuth_Key_T;
+
+/**
+ * @brief Cost of a verification in CPU cycles.
+ */
+typedef struct
+{
+    ImgAuth_Engine_T engine;   /**< Engine used for the signature */
+    uint32_t header_cycles;    /**< Header checks and digest of the signed part */
+    uint32_t signature_cycles; /**< Signature check */
+    uint32_t payload_cycles;   /**< SHA-256 of the payload */
+    uint32_t total_cycles;     /**< Whole verification */
+    uint32_t payload_size;     /**< Payload bytes hashed */
+} ImgAuth_Report_T;
+
+/**
+ * @brief SHA-256 calculation in progress.
+ */
+typedef struct
+{
+    uint32_t state[8];     /**< Chaining value */
+    uint64_t bytes;        /**< Bytes added so far */
+    uint8_t block[64];     /**< Partial block */
+} ImgAuth_Sha256_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Authenticate an image.
+ *
+ * The header and the signature are checked first, so a forged image
+ * costs no more than one signature check, then the payload is hashed.
+ *
+ * @param[in]  image    Image, header first.
+ * @param[in]  size     Bytes available at @p image.
+ * @param[in]  keys     Trusted keys.
+ * @param[in]  keyCount Entries in @p keys.
+ * @param[in]  engine   Where to check the signature.
+ * @param[out] report   Cost of each step, may be NULL.
+ *
+ * @return ::IMGAUTH_OK if the image is authentic, the first failed check otherwise.
+ */
+ImgAuth_Result_T ImgAuth_Verify(const void *image, uint32_t size, const ImgAuth_Key_T *keys, uint32_t keyCount,
+                                ImgAuth_Engine_T engine, ImgAuth_Report_T *report);
+
+/**
+ * @brief Start a SHA-256 calculation.
+ */
+void ImgAuth_Sha256Init(ImgAuth_Sha256_T *ctx);
+
+/**
+ * @brief Add @p size bytes to a SHA-256 calculation.
+ */
+void ImgAuth_Sha256Update(ImgAuth_Sha256_T *ctx, const void *data, uint32_t size);
+
+/**
+ * @brief Finish a SHA-256 calculation.
+ *
+ * @param[in,out] ctx    Calculation, unusable afterwards.
+ * @param[out]    digest ::IMGAUTH_HASH_SIZE bytes.
+ */
+void ImgAuth_Sha256Final(ImgAuth_Sha256_T *ctx, uint8_t *digest);
+
+#endif /* IMG_AUTH_H */
@@ -0,0 +1,221 @@
+/**
+ * @file ImgAuth.c
+ * @brief Implementation of the image authentication.
+ * @ingroup ImgAuth
+ * @{
+ *
+ * The signed part of the header is copied out of the image before use,
+ * so the image may sit at any alignment and cannot change under the
+ * checks. RSA signatures are checked by rebuilding the expected PKCS#1
+ * v1.5 block and comparing it with the public operation result in full,
+ * rather than parsing the result.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ImgAuth.h"
+#include <stddef.h>
+#include <string.h>
+#include "Pka.h"
+#include "stm32n6xx.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define IMGAUTH_P256_SIZE (32U)
+
+#if IMGAUTH_MAX_SIG_SIZE != PKA_MAX_MOD_BYTES
+#error "IMGAUTH_MAX_SIG_SIZE must match the largest PKA modulus"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+_Static_assert(sizeof(ImgAuth_Header_T) == 60U, "ImgAuth_Header_T must match the image layout");
+
+/* Global Variables ----------------------------------------------------------*/
+/** DER prefix of the SHA-256 DigestInfo (RFC 8017, section 9.2). */
+static const uint8_t g_imgAuthSha256Info[] = {0x30U, 0x31U, 0x30U, 0x0DU, 0x06U, 0x09U, 0x60U, 0x86U, 0x48U, 0x01U,
+                                              0x65U, 0x03U, 0x04U, 0x02U, 0x01U, 0x05U, 0x00U, 0x04U, 0x20U};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Find the key named by the header. */
+static const ImgAuth_Key_T *ImgAuth_FindKey(const ImgAuth_Header_T *hdr, const ImgAuth_Key_T *keys,
+                                            uint32_t keyCount);
+/** Check an ECDSA P-256 signature over @p digest. */
+static ImgAuth_Result_T ImgAuth_CheckEcdsa(const ImgAuth_Key_T *key, const uint8_t *sig, const uint8_t *digest,
+                                           ImgAuth_Engine_T engine);
+/** Check an RSA PKCS#1 v1.5 signature over @p digest. */
+static ImgAuth_Result_T ImgAuth_CheckRsa(const ImgAuth_Key_T *key, const uint8_t *sig, const uint8_t *digest,
+                                         ImgAuth_Engine_T engine);
+/** Map a PKA result to a verification result. */
+static ImgAuth_Result_T ImgAuth_FromPka(Pka_Result_T result);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Authenticate an image.
+ */
+ImgAuth_Result_T ImgAuth_Verify(const void *image, uint32_t size, const ImgAuth_Key_T *keys, uint32_t keyCount,
+                                ImgAuth_Engine_T engine, ImgAuth_Report_T *report)
+{
+    ImgAuth_Report_T local;
+    ImgAuth_Report_T *rep = (report != NULL) ? report : &local;
+    memset(rep, 0, sizeof(*rep));
+    rep->engine = engine;
+
+    if ((image == NULL) || (keys == NULL) || (size < sizeof(ImgAuth_Header_T)))
+    {
+        return IMGAUTH_ERR_FORMAT;
+    }
+
+    const uint8_t *bytes = (const uint8_t *)image;
+    ImgAuth_Header_T hdr;
+    ImgAuth_Sha256_T sha;
+    uint8_t digest[IMGAUTH_HASH_SIZE];
+    uint32_t start = DWT->CYCCNT;
+    uint32_t mark = start;
+
+    /* Header */
+    memcpy(&hdr, bytes, sizeof(hdr));
+    if ((hdr.magic != IMGAUTH_MAGIC) || (hdr.header_version != IMGAUTH_HEADER_VERSION) ||
+        (hdr.header_size < (sizeof(hdr) + hdr.sig_size)) || (hdr.header_size > size) ||
+        (hdr.image_size > (size - hdr.header_size)))
+    {
+        return IMGAUTH_ERR_FORMAT;
+    }
+    const ImgAuth_Key_T *key = ImgAuth_FindKey(&hdr, keys, keyCount);
+    if (key == NULL)
+    {
+        return IMGAUTH_ERR_KEY;
+    }
+    ImgAuth_Sha256Init(&sha);
+    ImgAuth_Sha256Update(&sha, &hdr, sizeof(hdr));
+    ImgAuth_Sha256Final(&sha, digest);
+    uint32_t now = DWT->CYCCNT;
+    rep->header_cycles = now - mark;
+    mark = now;
+
+    /* Signature */
+    const uint8_t *sig = &bytes[sizeof(hdr)];
+    ImgAuth_Result_T result = (hdr.sig_type == (uint8_t)IMGAUTH_SIG_ECDSA_P256)
+                                  ? ImgAuth_CheckEcdsa(key, sig, digest, engine)
+                                  : ImgAuth_CheckRsa(key, sig, digest, engine);
+    now = DWT->CYCCNT;
+    rep->signature_cycles = now - mark;
+    mark = now;
+
+    /* Payload */
+    if (result == IMGAUTH_OK)
+    {
+        ImgAuth_Sha256Init(&sha);
+        ImgAuth_Sha256Update(&sha, &bytes[hdr.header_size], hdr.image_size);
+        ImgAuth_Sha256Final(&sha, digest);
+        result = (memcmp(digest, hdr.hash, IMGAUTH_HASH_SIZE) == 0) ? IMGAUTH_OK : IMGAUTH_ERR_HASH;
+        now = DWT->CYCCNT;
+        rep->payload_cycles = now - mark;
+        rep->payload_size = hdr.image_size;
+    }
+
+    rep->total_cycles = now - start;
+    return result;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Find the key named by the header.
+ *
+ * @return The key with the header key id and signature type whose size
+ *         matches the signature, NULL if none.
+ */
+static const ImgAuth_Key_T *ImgAuth_FindKey(const ImgAuth_Header_T *hdr, const ImgAuth_Key_T *keys,
+                                            uint32_t keyCount)
+{
+    for (uint32_t i = 0U; i < keyCount; i++)
+    {
+        const ImgAuth_Key_T *key = &keys[i];
+        if ((key->key_id != hdr->key_id) || (key->sig_type != hdr->sig_type))
+        {
+            continue;
+        }
+        if ((key->sig_type == (uint8_t)IMGAUTH_SIG_ECDSA_P256) && (hdr->sig_size == (2U * IMGAUTH_P256_SIZE)))
+        {
+            return key;
+        }
+        if ((key->sig_type == (uint8_t)IMGAUTH_SIG_RSA_PKCS1) && (hdr->sig_size == key->mod_size) &&
+            (key->mod_size >= (sizeof(g_imgAuthSha256Info) + IMGAUTH_HASH_SIZE + 11U)) &&
+            (key->mod_size <= IMGAUTH_MAX_SIG_SIZE))
+        {
+            return key;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Check an ECDSA P-256 signature, r then s, over @p digest.
+ */
+static ImgAuth_Result_T ImgAuth_CheckEcdsa(const ImgAuth_Key_T *key, const uint8_t *sig, const uint8_t *digest,
+                                           ImgAuth_Engine_T engine)
+{
+    uint8_t r[IMGAUTH_P256_SIZE];
+    uint8_t s[IMGAUTH_P256_SIZE];
+    memcpy(r, sig, IMGAUTH_P256_SIZE);
+    memcpy(s, &sig[IMGAUTH_P256_SIZE], IMGAUTH_P256_SIZE);
+
+    Pka_Ecdsa_T in = {.qx = key->x, .qy = key->y, .r = r, .s = s, .hash = digest};
+    Pka_Result_T result = (engine == IMGAUTH_ENGINE_PKA) ? Pka_EcdsaVerify(&Pka_CurveP256, &in)
+                                                          : Pka_RefEcdsaVerify(&Pka_CurveP256, &in);
+    return ImgAuth_FromPka(result);
+}
+
+/**
+ * @brief Check an RSA PKCS#1 v1.5 signature over @p digest.
+ *
+ * The expected block is 00 01 FF..FF 00 DigestInfo digest.
+ */
+static ImgAuth_Result_T ImgAuth_CheckRsa(const ImgAuth_Key_T *key, const uint8_t *sig, const uint8_t *digest,
+                                         ImgAuth_Engine_T engine)
+{
+    uint8_t em[IMGAUTH_MAX_SIG_SIZE];
+    uint8_t expected[IMGAUTH_MAX_SIG_SIZE];
+    uint32_t size = key->mod_size;
+
+    memcpy(em, sig, size);
+    Pka_Result_T result = (engine == IMGAUTH_ENGINE_PKA)
+                              ? Pka_ModExp(em, key->exponent, key->exp_size, key->modulus, size, em)
+                              : Pka_RefModExp(em, key->exponent, key->exp_size, key->modulus, size, em);
+    if (result != PKA_OK)
+    {
+        /* A signature not below the modulus is a bad signature, not a bad call */
+        return (result == PKA_ERR_PARAM) ? IMGAUTH_ERR_SIGNATURE : ImgAuth_FromPka(result);
+    }
+
+    uint32_t pad = size - sizeof(g_imgAuthSha256Info) - IMGAUTH_HASH_SIZE - 3U;
+    expected[0] = 0x00U;
+    expected[1] = 0x01U;
+    memset(&expected[2], 0xFF, pad);
+    expected[2U + pad] = 0x00U;
+    memcpy(&expected[3U + pad], g_imgAuthSha256Info, sizeof(g_imgAuthSha256Info));
+    memcpy(&expected[3U + pad + sizeof(g_imgAuthSha256Info)], digest, IMGAUTH_HASH_SIZE);
+
+    uint8_t diff = 0U;
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        diff |= (uint8_t)(em[i] ^ expected[i]);
+    }
+    return (diff == 0U) ? IMGAUTH_OK : IMGAUTH_ERR_SIGNATURE;
+}
+
+/**
+ * @brief Map a PKA result to a verification result.
+ */
+static ImgAuth_Result_T ImgAuth_FromPka(Pka_Result_T result)
+{
+    switch (result)
+    {
+    case PKA_OK:
+        return IMGAUTH_OK;
+    case PKA_INVALID:
+    case PKA_ERR_PARAM:
+        return IMGAUTH_ERR_SIGNATURE;
+    default:
+        return IMGAUTH_ERR_ENGINE;
+    }
+}
+
+/** @} */ // end of ImgAuth group
@@ -0,0 +1,168 @@
+/**
+ * @file ImgAuth_Sha256.c
+ * @brief SHA-256 (FIPS 180-4) used for the image digests.
+ * @ingroup ImgAuth
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "ImgAuth.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define IMGAUTH_ROTR(x, n) (((x) >> (n)) | ((x) << (32U - (n))))
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+static const uint32_t g_imgAuthSha256K[64] = {
+    0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+    0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+    0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+    0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+    0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+    0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+    0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+    0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Process one 64-byte block. */
+static void ImgAuth_Sha256Block(uint32_t *state, const uint8_t *block);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start a SHA-256 calculation.
+ */
+void ImgAuth_Sha256Init(ImgAuth_Sha256_T *ctx)
+{
+    static const uint32_t iv[8] = {0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+                                   0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U};
+
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->bytes = 0U;
+}
+
+/**
+ * @brief Add @p size bytes to a SHA-256 calculation.
+ *
+ * Whole blocks are processed in place, only the partial ones are copied.
+ */
+void ImgAuth_Sha256Update(ImgAuth_Sha256_T *ctx, const void *data, uint32_t size)
+{
+    const uint8_t *in = (const uint8_t *)data;
+    uint32_t used = (uint32_t)(ctx->bytes % 64U);
+
+    ctx->bytes += size;
+    if (used != 0U)
+    {
+        uint32_t take = ((64U - used) < size) ? (64U - used) : size;
+        memcpy(&ctx->block[used], in, take);
+        in += take;
+        size -= take;
+        if ((used + take) < 64U)
+        {
+            return;
+        }
+        ImgAuth_Sha256Block(ctx->state, ctx->block);
+    }
+
+    for (; size >= 64U; size -= 64U, in += 64U)
+    {
+        ImgAuth_Sha256Block(ctx->state, in);
+    }
+    memcpy(ctx->block, in, size);
+}
+
+/**
+ * @brief Finish a SHA-256 calculation.
+ */
+void ImgAuth_Sha256Final(ImgAuth_Sha256_T *ctx, uint8_t *digest)
+{
+    uint64_t bits = ctx->bytes * 8U;
+    uint32_t used = (uint32_t)(ctx->bytes % 64U);
+
+    ctx->block[used++] = 0x80U;
+    if (used > 56U)
+    {
+        memset(&ctx->block[used], 0, 64U - used);
+        ImgAuth_Sha256Block(ctx->state, ctx->block);
+        used = 0U;
+    }
+    memset(&ctx->block[used], 0, 56U - used);
+    for (uint32_t i = 0U; i < 8U; i++)
+    {
+        ctx->block[63U - i] = (uint8_t)(bits >> (i * 8U));
+    }
+    ImgAuth_Sha256Block(ctx->state, ctx->block);
+
+    for (uint32_t i = 0U; i < 8U; i++)
+    {
+        digest[(i * 4U) + 0U] = (uint8_t)(ctx->state[i] >> 24);
+        digest[(i * 4U) + 1U] = (uint8_t)(ctx->state[i] >> 16);
+        digest[(i * 4U) + 2U] = (uint8_t)(ctx->state[i] >> 8);
+        digest[(i * 4U) + 3U] = (uint8_t)ctx->state[i];
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Process one 64-byte block.
+ *
+ * The message schedule is kept as a 16-word window.
+ */
+static void ImgAuth_Sha256Block(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[16];
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for (uint32_t i = 0U; i < 64U; i++)
+    {
+        uint32_t wi;
+        if (i < 16U)
+        {
+            wi = ((uint32_t)block[i * 4U] << 24) | ((uint32_t)block[(i * 4U) + 1U] << 16) |
+                 ((uint32_t)block[(i * 4U) + 2U] << 8) | (uint32_t)block[(i * 4U) + 3U];
+        }
+        else
+        {
+            uint32_t w15 = w[(i - 15U) & 15U];
+            uint32_t w2 = w[(i - 2U) & 15U];
+            uint32_t s0 = IMGAUTH_ROTR(w15, 7U) ^ IMGAUTH_ROTR(w15, 18U) ^ (w15 >> 3);
+            uint32_t s1 = IMGAUTH_ROTR(w2, 17U) ^ IMGAUTH_ROTR(w2, 19U) ^ (w2 >> 10);
+            wi = w[i & 15U] + s0 + w[(i - 7U) & 15U] + s1;
+        }
+        w[i & 15U] = wi;
+
+        uint32_t t1 = h + (IMGAUTH_ROTR(e, 6U) ^ IMGAUTH_ROTR(e, 11U) ^ IMGAUTH_ROTR(e, 25U)) + ((e & f) ^ (~e & g)) +
+                      g_imgAuthSha256K[i] + wi;
+        uint32_t t2 = (IMGAUTH_ROTR(a, 2U) ^ IMGAUTH_ROTR(a, 13U) ^ IMGAUTH_ROTR(a, 22U)) +
+                      ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/** @} */ // end of ImgAuth group
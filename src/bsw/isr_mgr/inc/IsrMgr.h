@@ -0,0 +1,153 @@
+/**
+ * @file IsrMgr.h
+ * @brief Interrupt manager with a RAM vector table and per-IRQ accounting
+ *
+ * At start-up the vector table is copied from flash into SRAM and
+ * `SCB->VTOR` is switched to the copy. Drivers then bind their handlers at
+ * run time with a context pointer instead of overriding the weak symbols
+ * of the startup file. Interrupts nobody registers keep the handler from
+ * the startup table.
+ *
+ * Registered interrupts enter through a common dispatcher which, when
+ * ::ISRMGR_ENABLE_STATS is set, counts every call and measures its
+ * duration with the DWT cycle counter. Durations include any nested
+ * interrupt that preempted the handler.
+ *
+ * Lines whose handler must run its first instruction as early as
+ * possible, for example to timestamp an edge, can instead point their
+ * vector straight at the handler with ::IsrMgr_RegisterDirect. They skip
+ * the dispatcher, its context lookup and its accounting.
+ */
+
+#ifndef ISR_MGR_H
+#define ISR_MGR_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef ISRMGR_ENABLE_STATS
+#define ISRMGR_ENABLE_STATS (1U) /**< Record count, duration and latency per IRQ */
+#endif
+
+#define ISRMGR_EXC_OFFSET (16U)                       /**< Exception number of external line 0 */
+#define ISRMGR_IRQ_COUNT (LTDC_UP_ERR_IRQn + 1U)       /**< External interrupt lines of the device */
+#define ISRMGR_VECTOR_COUNT (ISRMGR_EXC_OFFSET + ISRMGR_IRQ_COUNT) /**< Core exceptions plus external lines */
+#define ISRMGR_VECTOR_ALIGN (1024U)                   /**< VTOR alignment for ::ISRMGR_VECTOR_COUNT entries */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Interrupt handler bound at run time.
+ *
+ * @param[in] ctx Context pointer given at registration.
+ */
+typedef void (*IsrMgr_Handler_T)(void *ctx);
+
+/**
+ * @brief Exception handler installed as is in the vector table.
+ */
+typedef void (*IsrMgr_Vector_T)(void);
+
+/**
+ * @brief Accounting of one interrupt line, in CPU cycles.
+ *
+ * Latency is only sampled for interrupts pended through ::IsrMgr_SetPending
+ * or announced with ::IsrMgr_MarkPending, since the CPU cannot observe when
+ * a hardware request was raised.
+ */
+typedef struct
+{
+    uint32_t count;           /**< Handler calls */
+    uint32_t max_cycles;      /**< Longest handler run */
+    uint64_t total_cycles;    /**< Sum of all handler runs */
+    uint32_t latency_samples; /**< Entries with a known pending time */
+    uint32_t max_latency;     /**< Longest pending-to-entry delay */
+} IsrMgr_Stats_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Copy the active vector table to SRAM and relocate VTOR to it.
+ *
+ * Must run once before any interrupt is registered, ideally before the
+ * first one is enabled. The DWT cycle counter must already be running for
+ * the accounting to be meaningful.
+ *
+ * @return true on success, false if called twice.
+ */
+bool IsrMgr_Init(void);
+
+/**
+ * @brief Bind a handler to an external interrupt line.
+ *
+ * The line is not enabled, priority and enable stay with the driver.
+ *
+ * @param[in] irq     Interrupt line, must be a device IRQ (>= 0).
+ * @param[in] handler Function called on each interrupt.
+ * @param[in] ctx     Passed unchanged to @p handler.
+ *
+ * @return true on success, false for an invalid line or handler.
+ */
+bool IsrMgr_Register(IRQn_Type irq, IsrMgr_Handler_T handler, void *ctx);
+
+/**
+ * @brief Point the vector of an external interrupt line straight at a handler.
+ *
+ * The handler runs without the dispatcher: no context, and no accounting
+ * in ::IsrMgr_GetStats. A handler shared by several lines finds its line
+ * from IPSR minus ::ISRMGR_EXC_OFFSET. The line is not enabled, priority
+ * and enable stay with the driver.
+ *
+ * @param[in] irq    Interrupt line, must be a device IRQ (>= 0).
+ * @param[in] vector Handler entered on each interrupt.
+ *
+ * @return true on success, false for an invalid line or handler.
+ */
+bool IsrMgr_RegisterDirect(IRQn_Type irq, IsrMgr_Vector_T vector);
+
+/**
+ * @brief Restore the startup handler of an interrupt line.
+ *
+ * The line should be disabled before its handler is removed.
+ *
+ * @param[in] irq Interrupt line previously registered.
+ */
+void IsrMgr_Unregister(IRQn_Type irq);
+
+/**
+ * @brief Pend an interrupt from software and time its entry latency.
+ *
+ * @param[in] irq Interrupt line to pend.
+ */
+void IsrMgr_SetPending(IRQn_Type irq);
+
+/**
+ * @brief Record now as the moment @p irq became pending.
+ *
+ * For drivers that know when their hardware raises the request, for
+ * example right after triggering a software DMA transfer that completes
+ * immediately.
+ *
+ * @param[in] irq Interrupt line about to be serviced.
+ */
+void IsrMgr_MarkPending(IRQn_Type irq);
+
+/**
+ * @brief Copy the accounting of one interrupt line.
+ *
+ * @param[in]  irq   Interrupt line.
+ * @param[out] stats Destination for the snapshot.
+ *
+ * @return true on success, false for an invalid line.
+ */
+bool IsrMgr_GetStats(IRQn_Type irq, IsrMgr_Stats_T *stats);
+
+/**
+ * @brief Clear the accounting of every interrupt line.
+ */
+void IsrMgr_ResetStats(void);
+
+#endif /* ISR_MGR_H */
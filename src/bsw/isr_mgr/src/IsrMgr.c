@@ -0,0 +1,259 @@
+/**
+ * @file IsrMgr.c
+ * @brief Interrupt manager with a RAM vector table and per-IRQ accounting.
+ * @ingroup IsrMgr
+ * @{
+ *
+ * Registered lines point their vector at ::IsrMgr_Dispatch, which finds the
+ * handler from the active exception number and wraps the call with the
+ * DWT cycle counter. Lines registered direct point it at their own
+ * handler. Every other vector keeps the startup handler.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "IsrMgr.h"
+#include <stddef.h>
+#include "cmsis_gcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Registration and accounting of one external line.
+ */
+typedef struct
+{
+    IsrMgr_Handler_T handler;         /**< Handler bound at run time */
+    void *ctx;                        /**< Context passed to @ref handler */
+    volatile uint32_t pending_cycles; /**< CYCCNT when the line was pended */
+    volatile uint8_t pending_marked;  /**< @ref pending_cycles is valid */
+    IsrMgr_Stats_T stats;             /**< Accounting, see ::IsrMgr_GetStats */
+} IsrMgr_Entry_T;
+
+/* Global Variables ---------------------------------------------------------*/
+/** Vector table in SRAM, active once ::IsrMgr_Init has run. */
+static uint32_t g_isrMgrVectors[ISRMGR_VECTOR_COUNT] __attribute__((aligned(ISRMGR_VECTOR_ALIGN)));
+
+/** Table that was active before relocation, used to restore handlers. */
+static const uint32_t *g_isrMgrStartupVectors = NULL;
+
+/** Per-line registration, indexed by IRQ number. */
+static IsrMgr_Entry_T g_isrMgrEntries[ISRMGR_IRQ_COUNT];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void IsrMgr_Dispatch(void);
+static bool IsrMgr_IsValid(IRQn_Type irq);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Copy the active vector table to SRAM and relocate VTOR to it.
+ */
+bool IsrMgr_Init(void)
+{
+    if (g_isrMgrStartupVectors != NULL)
+    {
+        return false;
+    }
+
+    g_isrMgrStartupVectors = (const uint32_t *)SCB->VTOR;
+    for (uint32_t i = 0U; i < ISRMGR_VECTOR_COUNT; i++)
+    {
+        g_isrMgrVectors[i] = g_isrMgrStartupVectors[i];
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __DSB();
+    SCB->VTOR = (uint32_t)g_isrMgrVectors;
+    __DSB();
+    __ISB();
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+/**
+ * @brief Bind a handler to an external interrupt line.
+ *
+ * The context is published before the vector so an interrupt already
+ * pending on the line never sees a half registered entry.
+ */
+bool IsrMgr_Register(IRQn_Type irq, IsrMgr_Handler_T handler, void *ctx)
+{
+    if (!IsrMgr_IsValid(irq) || (handler == NULL))
+    {
+        return false;
+    }
+
+    IsrMgr_Entry_T *entry = &g_isrMgrEntries[irq];
+    entry->ctx = ctx;
+    entry->handler = handler;
+    __DMB();
+    g_isrMgrVectors[ISRMGR_EXC_OFFSET + (uint32_t)irq] = (uint32_t)IsrMgr_Dispatch;
+    __DSB();
+    __ISB();
+
+    return true;
+}
+
+/**
+ * @brief Point the vector of an external interrupt line straight at a handler.
+ *
+ * The vector is swapped before the entry is cleared, as in
+ * ::IsrMgr_Unregister: an interrupt taken in between still dispatches to
+ * the earlier handler, and a dispatch that finds the entry already
+ * cleared returns without calling anything.
+ */
+bool IsrMgr_RegisterDirect(IRQn_Type irq, IsrMgr_Vector_T vector)
+{
+    if (!IsrMgr_IsValid(irq) || (vector == NULL))
+    {
+        return false;
+    }
+
+    g_isrMgrVectors[ISRMGR_EXC_OFFSET + (uint32_t)irq] = (uint32_t)vector;
+    __DSB();
+    __ISB();
+    g_isrMgrEntries[irq].handler = NULL;
+    g_isrMgrEntries[irq].ctx = NULL;
+
+    return true;
+}
+
+/**
+ * @brief Restore the startup handler of an interrupt line.
+ */
+void IsrMgr_Unregister(IRQn_Type irq)
+{
+    if (!IsrMgr_IsValid(irq))
+    {
+        return;
+    }
+
+    g_isrMgrVectors[ISRMGR_EXC_OFFSET + (uint32_t)irq] = g_isrMgrStartupVectors[ISRMGR_EXC_OFFSET + (uint32_t)irq];
+    __DSB();
+    __ISB();
+    g_isrMgrEntries[irq].handler = NULL;
+    g_isrMgrEntries[irq].ctx = NULL;
+}
+
+/**
+ * @brief Pend an interrupt from software and time its entry latency.
+ */
+void IsrMgr_SetPending(IRQn_Type irq)
+{
+    IsrMgr_MarkPending(irq);
+    NVIC_SetPendingIRQ(irq);
+    __DSB();
+}
+
+/**
+ * @brief Record now as the moment @p irq became pending.
+ */
+void IsrMgr_MarkPending(IRQn_Type irq)
+{
+#if (ISRMGR_ENABLE_STATS == 1U)
+    if (IsrMgr_IsValid(irq))
+    {
+        g_isrMgrEntries[irq].pending_cycles = DWT->CYCCNT;
+        __DMB();
+        g_isrMgrEntries[irq].pending_marked = 1U;
+    }
+#else
+    (void)irq;
+#endif
+}
+
+/**
+ * @brief Copy the accounting of one interrupt line.
+ *
+ * Interrupts are masked for the copy so the 64-bit total and the maxima
+ * belong to the same snapshot, whatever the priority of the line.
+ */
+bool IsrMgr_GetStats(IRQn_Type irq, IsrMgr_Stats_T *stats)
+{
+    if (!IsrMgr_IsValid(irq) || (stats == NULL))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_isrMgrEntries[irq].stats;
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+/**
+ * @brief Clear the accounting of every interrupt line.
+ */
+void IsrMgr_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0U; i < ISRMGR_IRQ_COUNT; i++)
+    {
+        g_isrMgrEntries[i].stats = (IsrMgr_Stats_T){0};
+        g_isrMgrEntries[i].pending_marked = 0U;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Common entry of every registered interrupt line.
+ *
+ * The line is taken from IPSR, so one vector serves all registrations.
+ * An entry cleared by ::IsrMgr_Unregister or ::IsrMgr_RegisterDirect
+ * while the interrupt was being taken has no handler; the call is
+ * skipped.
+ */
+static void IsrMgr_Dispatch(void)
+{
+    uint32_t irq = __get_IPSR() - ISRMGR_EXC_OFFSET;
+    IsrMgr_Entry_T *entry = &g_isrMgrEntries[irq];
+    IsrMgr_Handler_T handler = entry->handler;
+
+    if (handler == NULL)
+    {
+        return;
+    }
+
+#if (ISRMGR_ENABLE_STATS == 1U)
+    uint32_t start = DWT->CYCCNT;
+
+    if (entry->pending_marked != 0U)
+    {
+        uint32_t latency = start - entry->pending_cycles;
+        entry->pending_marked = 0U;
+        entry->stats.latency_samples++;
+        if (latency > entry->stats.max_latency)
+        {
+            entry->stats.max_latency = latency;
+        }
+    }
+#endif
+
+    handler(entry->ctx);
+
+#if (ISRMGR_ENABLE_STATS == 1U)
+    uint32_t cycles = DWT->CYCCNT - start;
+    entry->stats.count++;
+    entry->stats.total_cycles += cycles;
+    if (cycles > entry->stats.max_cycles)
+    {
+        entry->stats.max_cycles = cycles;
+    }
+#endif
+}
+
+/**
+ * @brief Whether @p irq is a device interrupt line.
+ */
+static bool IsrMgr_IsValid(IRQn_Type irq)
+{
+    return ((int32_t)irq >= 0) && ((uint32_t)irq < ISRMGR_IRQ_COUNT);
+}
+
+/** @} */ // end of IsrMgr group
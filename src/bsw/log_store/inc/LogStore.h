@@ -0,0 +1,200 @@
+/**
+ * @file LogStore.h
+ * @brief Persistent append-only log store on an external SPI NOR flash
+ *
+ * Log records are appended to a ring of 4 KiB flash sectors so they
+ * survive a reset or a detached console. Each sector starts with a header
+ * holding a sequence number and its erase count, protected by a CRC; the
+ * records that follow carry their length and a CRC-32 of their payload.
+ * Records never straddle sectors.
+ *
+ * ::LogStore_Append only copies the record into a RAM staging buffer, so
+ * producers never wait for the flash; a full buffer drops the record and
+ * counts it. The store task moves staged records into a page buffer and
+ * programs each 256-byte page once it is full, or what it holds once the
+ * oldest byte has waited ::LOGSTORE_FLUSH_MS.
+ *
+ * When the head sector is full the next one in the ring is erased and
+ * opened. If it still holds the oldest records it is reclaimed, so every
+ * sector is erased in turn and wears evenly. Mounting reads the header of
+ * every sector to find the oldest and newest ones, then only the records
+ * of the newest to find the write position. A head sector whose tail was
+ * cut by a power loss is closed and appending resumes in the next one.
+ *
+ * The flash shares SPI1 with the other devices of ::SpiDma and has its own
+ * chip select.
+ */
+
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef LOGSTORE_CS_PORT
+#define LOGSTORE_CS_PORT GPIOA /**< Port of the flash chip select */
+#endif
+
+#ifndef LOGSTORE_CS_PIN
+#define LOGSTORE_CS_PIN LL_GPIO_PIN_4 /**< Flash chip select pin */
+#endif
+
+#ifndef LOGSTORE_SPI_HZ
+#define LOGSTORE_SPI_HZ (50000000U) /**< Highest SCK rate of the flash */
+#endif
+
+#ifndef LOGSTORE_FLASH_OFFSET
+#define LOGSTORE_FLASH_OFFSET (0U) /**< Start of the ring in the flash, a multiple of the sector size */
+#endif
+
+#ifndef LOGSTORE_MAX_BYTES
+#define LOGSTORE_MAX_BYTES (16U * 1024U * 1024U) /**< Largest ring, the rest of the flash is left alone */
+#endif
+
+#ifndef LOGSTORE_STAGE_BYTES
+#define LOGSTORE_STAGE_BYTES (4096U) /**< Staging buffer between producers and the store task, a power of two */
+#endif
+
+#ifndef LOGSTORE_MAX_RECORD
+#define LOGSTORE_MAX_RECORD (512U) /**< Largest record payload */
+#endif
+
+#ifndef LOGSTORE_FLUSH_MS
+#define LOGSTORE_FLUSH_MS (100U) /**< Longest time an appended byte waits in the page buffer */
+#endif
+
+#ifndef LOGSTORE_TASK_STACK_SIZE
+#define LOGSTORE_TASK_STACK_SIZE (256U) /**< Store task stack in words */
+#endif
+
+#define LOGSTORE_SECTOR_SIZE (4096U) /**< Erase unit of the flash */
+#define LOGSTORE_PAGE_SIZE (256U)    /**< Program unit of the flash */
+#define LOGSTORE_NOTIFY_INDEX (0U)   /**< Task notification index the store waits on */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Read position, from the oldest record to the newest.
+ *
+ * Set up by ::LogStore_ReadBegin. A cursor whose sector is reclaimed
+ * while it is in use restarts at the oldest record still stored.
+ */
+typedef struct
+{
+    uint32_t sector; /**< Ring position of the sector being read */
+    uint32_t seq;    /**< Sequence number of that sector, 0 before the first read */
+    uint32_t offset; /**< Byte offset of the next record in the sector */
+} LogStore_Cursor_T;
+
+/**
+ * @brief Store counters.
+ */
+typedef struct
+{
+    bool mounted;           /**< The ring was found and records are being written */
+    uint32_t jedec_id;      /**< Manufacturer, type and capacity bytes of the flash */
+    uint32_t sectors;       /**< Sectors in the ring */
+    uint32_t sectors_used;  /**< Sectors holding records */
+    uint32_t head_seq;      /**< Sequence number of the newest sector */
+    uint32_t appended;      /**< Records accepted by ::LogStore_Append */
+    uint32_t dropped;       /**< Records refused on a full staging buffer or lost to a flash failure */
+    uint32_t stage_level;   /**< Bytes waiting in the staging buffer */
+    uint32_t stage_peak;    /**< Largest staging buffer level */
+    uint32_t records;       /**< Records placed in flash pages */
+    uint64_t bytes;         /**< Payload bytes of those records */
+    uint32_t pages;         /**< Page programs */
+    uint32_t erases;        /**< Sectors erased */
+    uint32_t reclaimed;     /**< Sectors of old records erased to make room */
+    uint32_t erase_min;     /**< Lowest erase count found at the last mount */
+    uint32_t erase_max;     /**< Highest erase count found or written */
+    uint32_t torn;          /**< Head sectors closed at mount after an interrupted write */
+    uint32_t crc_errors;    /**< Records or sector headers failing their CRC while reading */
+    uint32_t flash_errors;  /**< Flash operations that failed or timed out */
+    uint32_t mount_us;      /**< Duration of the last mount */
+} LogStore_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Set up the chip select and start the store task, which mounts the ring.
+ *
+ * Records appended before the mount completes wait in the staging buffer.
+ *
+ * @retval true  Store task running.
+ * @retval false The chip select, lock or task could not be set up.
+ */
+bool LogStore_Init(void);
+
+/**
+ * @brief Identify the flash and find the ring again.
+ *
+ * The store task mounts once when it starts, so this is only needed to
+ * bring the store back after a flash failure took it offline or the
+ * flash was power cycled. Blocks the calling task.
+ *
+ * @retval true  Mounted, appending resumes.
+ * @retval false No flash answers or the ring does not fit in it; staged
+ *               records are dropped until the next successful mount.
+ */
+bool LogStore_Mount(void);
+
+/**
+ * @brief Queue a record for the flash without waiting.
+ *
+ * Callable from tasks and from interrupts up to
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @param[in] data Record payload, copied.
+ * @param[in] size Bytes, 1 to ::LOGSTORE_MAX_RECORD.
+ *
+ * @retval true  Staged.
+ * @retval false Invalid size, store offline or staging buffer full.
+ */
+bool LogStore_Append(const void *data, uint32_t size);
+
+/**
+ * @brief Write every staged record and the partial page to the flash.
+ *
+ * Blocks the calling task.
+ *
+ * @retval true  Everything appended before the call is in flash.
+ * @retval false Store offline or a flash operation failed.
+ */
+bool LogStore_Flush(void);
+
+/**
+ * @brief Place a cursor before the oldest record.
+ *
+ * @param[out] cursor Cursor to set up.
+ */
+void LogStore_ReadBegin(LogStore_Cursor_T *cursor);
+
+/**
+ * @brief Read the record after the cursor and move past it.
+ *
+ * Blocks the calling task. Only records already programmed are seen, see
+ * ::LogStore_Flush. A record failing its CRC ends the reading of its
+ * sector.
+ *
+ * @param[in,out] cursor Cursor from ::LogStore_ReadBegin.
+ * @param[out]    buf    Payload destination.
+ * @param[in]     size   Bytes available at @p buf.
+ * @param[out]    length Payload bytes of the record.
+ *
+ * @retval true  A record was read.
+ * @retval false No newer record, store offline, or the record is larger
+ *               than @p size; the cursor does not move.
+ */
+bool LogStore_ReadNext(LogStore_Cursor_T *cursor, void *buf, uint32_t size, uint32_t *length);
+
+/**
+ * @brief Copy the store counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void LogStore_GetStatus(LogStore_Status_T *status);
+
+#endif /* LOG_STORE_H */
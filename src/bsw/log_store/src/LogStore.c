@@ -0,0 +1,1158 @@
+/**
+ * @file LogStore.c
+ * @brief Implementation of the persistent log store.
+ * @ingroup LogStore
+ * @{
+ *
+ * Flash layout, every sector of the ring:
+ *  - a 16-byte header: magic, sequence number, erase count and the CRC-32
+ *    of those three words; sequence numbers grow by one per opened sector,
+ *  - records packed from offset 16: a length, its complement and the
+ *    CRC-32 of the payload, then the payload padded to a word,
+ *  - erased bytes up to the end of the sector.
+ *
+ * Only the store task and callers of the blocking functions touch the
+ * flash, one at a time under a mutex. Producers reach the task through a
+ * byte ring of length-prefixed records filled with interrupts masked. The
+ * task is woken when a batch starts and when the ring is a quarter full,
+ * not on every record, and otherwise sleeps until the flush deadline.
+ *
+ * The flash stays busy after a program or an erase. A page program is
+ * polled every ::LOGSTORE_PROGRAM_POLL_US on a microsecond timer, an erase
+ * every tick, so waiting does not spin on the bus.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "LogStore.h"
+#include <stddef.h>
+#include <string.h>
+#include "SpiDma.h"
+#include "Crc.h"
+#include "HrTimer.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "cmsis_gcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define LOGSTORE_MAGIC (0x31474F4CUL)          /**< "LOG1", first word of a sector header */
+#define LOGSTORE_HDR_SIZE (16U)                /**< Bytes of a sector header */
+#define LOGSTORE_REC_HDR_SIZE (8U)             /**< Bytes of a record header */
+#define LOGSTORE_ERASED_LENGTH (0xFFFFU)       /**< Length field of erased flash */
+#define LOGSTORE_CMD_WREN (0x06U)              /**< WRITE ENABLE */
+#define LOGSTORE_CMD_RDSR (0x05U)              /**< READ STATUS REGISTER */
+#define LOGSTORE_CMD_READ (0x03U)              /**< READ DATA */
+#define LOGSTORE_CMD_PP (0x02U)                /**< PAGE PROGRAM */
+#define LOGSTORE_CMD_SE (0x20U)                /**< SECTOR ERASE, 4 KiB */
+#define LOGSTORE_CMD_JEDEC_ID (0x9FU)          /**< READ JEDEC ID */
+#define LOGSTORE_SR_WIP (0x01U)                /**< Status: program or erase in progress */
+#define LOGSTORE_SR_ABSENT (0xFFU)             /**< Status read with MISO left high, no flash answering */
+#define LOGSTORE_ADDR_LIMIT (16U * 1024U * 1024U) /**< Reach of 3-byte addresses */
+#define LOGSTORE_PROGRAM_POLL_US (100U)        /**< Status poll period while a page programs */
+#define LOGSTORE_PROGRAM_TIMEOUT_MS (10U)      /**< Longest page program */
+#define LOGSTORE_ERASE_TIMEOUT_MS (500U)       /**< Longest sector erase */
+#define LOGSTORE_STAGE_WAKE (LOGSTORE_STAGE_BYTES / 4U) /**< Staging level that wakes the task at once */
+#define LOGSTORE_EVT_DATA (1UL << 0)           /**< Notification bit: records staged */
+#define LOGSTORE_EVT_POLL (1UL << 1)           /**< Notification bit: time to poll the status again */
+
+/** Bytes a record takes in flash. */
+#define LOGSTORE_RECORD_SPAN(len) (LOGSTORE_REC_HDR_SIZE + (((len) + 3U) & ~3U))
+
+#if ((LOGSTORE_STAGE_BYTES & (LOGSTORE_STAGE_BYTES - 1U)) != 0U)
+#error "LOGSTORE_STAGE_BYTES must be a power of two"
+#endif
+
+#if (LOGSTORE_RECORD_SPAN(LOGSTORE_MAX_RECORD) > (LOGSTORE_SECTOR_SIZE - LOGSTORE_HDR_SIZE)) || \
+    (LOGSTORE_MAX_RECORD >= LOGSTORE_ERASED_LENGTH)
+#error "LOGSTORE_MAX_RECORD must fit in one sector"
+#endif
+
+#if (HRTIMER_NOTIFY_INDEX != LOGSTORE_NOTIFY_INDEX)
+#error "The status poll timer notifies the store on its own index"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Life cycle of the store.
+ */
+typedef enum
+{
+    LOGSTORE_MOUNTING = 0, /**< Not mounted yet, records are staged */
+    LOGSTORE_READY,        /**< Mounted, records go to the flash */
+    LOGSTORE_OFFLINE,      /**< No flash or a flash failure, records are refused */
+} LogStore_State_T;
+
+/**
+ * @brief Header at the start of every sector of the ring.
+ */
+typedef struct
+{
+    uint32_t magic;       /**< ::LOGSTORE_MAGIC */
+    uint32_t seq;         /**< Opening order of the sector */
+    uint32_t erase_count; /**< Erases of the sector so far */
+    uint32_t crc;         /**< CRC-32 of the three words above */
+} LogStore_SectorHdr_T;
+
+/**
+ * @brief Header in front of every record.
+ */
+typedef struct
+{
+    uint16_t length; /**< Payload bytes */
+    uint16_t check;  /**< Complement of @ref length */
+    uint32_t crc;    /**< CRC-32 of the payload */
+} LogStore_RecordHdr_T;
+
+/* Global Variables ---------------------------------------------------------*/
+/** The flash on SPI1, mode 0. */
+static const SpiDma_Device_T g_logStoreDev = {LOGSTORE_CS_PORT, LOGSTORE_CS_PIN, 0U, false, LOGSTORE_SPI_HZ};
+/** CRC of headers and payloads. */
+static const Crc_Model_T g_logStoreCrc = CRC_MODEL_CRC32;
+/** Serialises flash access and the ring state. */
+static SemaphoreHandle_t g_logStoreLock = NULL;
+/** Store task. */
+static TaskHandle_t g_logStoreTask = NULL;
+/** Wakes a task polling the flash status. */
+static HrTimer_T g_logStorePoll;
+/** Life cycle state. */
+static volatile LogStore_State_T g_logStoreState = LOGSTORE_MOUNTING;
+
+/** Length-prefixed records waiting for the store task. */
+static uint8_t g_logStoreStage[LOGSTORE_STAGE_BYTES];
+/** Free-running write index of ::g_logStoreStage. */
+static volatile uint32_t g_logStoreStageHead = 0U;
+/** Free-running read index of ::g_logStoreStage. */
+static volatile uint32_t g_logStoreStageTail = 0U;
+/** Tick the oldest staged record was appended at. */
+static volatile TickType_t g_logStoreStageTick = 0U;
+
+/** Sectors in the ring. */
+static uint32_t g_logStoreSectors = 0U;
+/** Ring position of the newest sector. */
+static uint32_t g_logStoreHead = 0U;
+/** Ring position of the oldest sector. */
+static uint32_t g_logStoreTail = 0U;
+/** Sectors from the oldest to the newest, 0 for an empty ring. */
+static uint32_t g_logStoreUsed = 0U;
+/** Sequence number of the newest sector. */
+static uint32_t g_logStoreHeadSeq = 0U;
+/** Erase count of the newest sector. */
+static uint32_t g_logStoreHeadErase = 0U;
+/** Records may be added to the newest sector. */
+static bool g_logStoreOpen = false;
+/** Offset in the newest sector the next record byte goes to. */
+static uint32_t g_logStoreWrite = 0U;
+/** Offset in the newest sector programmed up to. */
+static uint32_t g_logStoreDone = 0U;
+/** Tick the oldest byte of the page buffer was added at. */
+static TickType_t g_logStoreDirtyTick = 0U;
+
+/** Flash page the write offset lies in, bytes from ::g_logStoreDone on not programmed yet. */
+static uint8_t g_logStorePage[LOGSTORE_PAGE_SIZE] __attribute__((aligned(32)));
+/** Data read from the flash. */
+static uint8_t g_logStoreIo[LOGSTORE_PAGE_SIZE] __attribute__((aligned(32)));
+/** Command and address bytes. */
+static uint8_t g_logStoreCmd[32] __attribute__((aligned(32)));
+/** Padding after a payload. */
+static const uint8_t g_logStorePad[3] = {0xFFU, 0xFFU, 0xFFU};
+
+/** Counters reported by ::LogStore_GetStatus. */
+static LogStore_Status_T g_logStoreStatus = {0};
+
+/* Private Function Prototypes ----------------------------------------------*/
+/** Background task: mount, then move staged records to the flash. */
+static void LogStore_Task(void *arg);
+/** Identify the flash, read the sector headers and find the write position. */
+static bool LogStore_Scan(void);
+/** Drop every staged record, store offline. */
+static void LogStore_Discard(void);
+/** Take the store offline after a flash failure. */
+static void LogStore_Fail(void);
+/** Copy bytes into the staging ring at a free-running index. */
+static void LogStore_StageWrite(uint32_t pos, const void *src, uint32_t size);
+/** Move every staged record to the page buffer. */
+static bool LogStore_Drain(void);
+/** Add one record of the staging ring to the newest sector. */
+static bool LogStore_PutRecord(uint32_t pos, uint32_t length);
+/** Add bytes at the write offset, programming every page filled. */
+static bool LogStore_Put(const void *src, uint32_t size);
+/** Program the bytes of the page buffer not programmed yet. */
+static bool LogStore_FlushPage(void);
+/** Erase the next sector of the ring, reclaiming it if needed, and write its header. */
+static bool LogStore_OpenSector(void);
+/** Read and check the header of a sector. */
+static bool LogStore_ReadHeader(uint32_t sector, LogStore_SectorHdr_T *hdr, bool *valid);
+/** Check a record header at an offset of a sector, and its payload CRC. */
+static bool LogStore_CheckRecord(uint32_t sector, uint32_t offset, uint32_t *length, bool *valid, bool *erased);
+/** Move a cursor to the first sector with a valid header from @p sector on. */
+static bool LogStore_EnterSector(LogStore_Cursor_T *cursor, uint32_t sector);
+/** Read the record after the cursor. */
+static bool LogStore_ReadRecord(LogStore_Cursor_T *cursor, void *buf, uint32_t size, uint32_t *length);
+/** Flash address of a ring position. */
+static uint32_t LogStore_SectorAddr(uint32_t sector);
+/** Send a command with an optional address, then exchange its data bytes. */
+static bool LogStore_Command(uint8_t cmd, uint32_t addr, bool withAddr, const void *tx, void *rx, uint32_t size);
+/** Read up to one page into ::g_logStoreIo. */
+static bool LogStore_Read(uint32_t addr, uint32_t size);
+/** Program bytes within one page and wait for the end. */
+static bool LogStore_Program(uint32_t addr, const void *src, uint32_t size);
+/** Erase a sector and wait for the end. */
+static bool LogStore_Erase(uint32_t addr);
+/** Poll the status register until no operation is in progress. */
+static bool LogStore_WaitReady(uint32_t pollUs, uint32_t timeoutMs);
+/** Block the calling task for about @p us. */
+static void LogStore_Sleep(uint32_t us);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Prepare the chip select and start the store task.
+ */
+bool LogStore_Init(void)
+{
+    if (!SpiDma_InitDevice(&g_logStoreDev))
+    {
+        return false;
+    }
+
+    g_logStoreLock = xSemaphoreCreateMutex();
+    if (g_logStoreLock == NULL)
+    {
+        return false;
+    }
+
+    return xTaskCreate(LogStore_Task, "LogStore", LOGSTORE_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+                       &g_logStoreTask) == pdPASS;
+}
+
+/**
+ * @brief Find the ring on the flash and resume appending.
+ */
+bool LogStore_Mount(void)
+{
+    if (g_logStoreLock == NULL)
+    {
+        return false;
+    }
+
+    (void)xSemaphoreTake(g_logStoreLock, portMAX_DELAY);
+    if (g_logStoreState == LOGSTORE_READY)
+    {
+        /* What is buffered would not be found by the scan */
+        (void)(LogStore_Drain() && LogStore_FlushPage());
+    }
+    uint32_t start = DWT->CYCCNT;
+    bool ok = LogStore_Scan();
+    g_logStoreStatus.mount_us = (DWT->CYCCNT - start) / (SystemCoreClock / 1000000U);
+    if (ok)
+    {
+        g_logStoreState = LOGSTORE_READY;
+    }
+    else
+    {
+        g_logStoreState = LOGSTORE_OFFLINE;
+        LogStore_Discard();
+    }
+    (void)xSemaphoreGive(g_logStoreLock);
+
+    if (ok && (g_logStoreTask != NULL))
+    {
+        /* Records staged while mounting */
+        (void)xTaskNotifyIndexed(g_logStoreTask, LOGSTORE_NOTIFY_INDEX, LOGSTORE_EVT_DATA, eSetBits);
+    }
+    return ok;
+}
+
+/**
+ * @brief Copy a record into the staging ring.
+ *
+ * The task is only woken for the first record of a batch, which starts
+ * the flush deadline, and when the ring reaches a quarter of its size.
+ */
+bool LogStore_Append(const void *data, uint32_t size)
+{
+    if ((data == NULL) || (size == 0U) || (size > LOGSTORE_MAX_RECORD) || (g_logStoreState == LOGSTORE_OFFLINE))
+    {
+        return false;
+    }
+
+    uint16_t length = (uint16_t)size;
+    uint32_t need = sizeof(length) + size;
+    bool isr = (xPortIsInsideInterrupt() != pdFALSE);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t head = g_logStoreStageHead;
+    uint32_t level = head - g_logStoreStageTail;
+    if ((LOGSTORE_STAGE_BYTES - level) < need)
+    {
+        g_logStoreStatus.dropped++;
+        __set_PRIMASK(primask);
+        return false;
+    }
+    if (level == 0U)
+    {
+        g_logStoreStageTick = isr ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+    }
+    LogStore_StageWrite(head, &length, sizeof(length));
+    LogStore_StageWrite(head + sizeof(length), data, size);
+    g_logStoreStageHead = head + need;
+    g_logStoreStatus.appended++;
+    if ((level + need) > g_logStoreStatus.stage_peak)
+    {
+        g_logStoreStatus.stage_peak = level + need;
+    }
+    __set_PRIMASK(primask);
+
+    bool wake = (level == 0U) || ((level < LOGSTORE_STAGE_WAKE) && ((level + need) >= LOGSTORE_STAGE_WAKE));
+    if (wake && (g_logStoreTask != NULL))
+    {
+        if (isr)
+        {
+            BaseType_t woken = pdFALSE;
+            (void)xTaskNotifyIndexedFromISR(g_logStoreTask, LOGSTORE_NOTIFY_INDEX, LOGSTORE_EVT_DATA, eSetBits,
+                                            &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+        else
+        {
+            (void)xTaskNotifyIndexed(g_logStoreTask, LOGSTORE_NOTIFY_INDEX, LOGSTORE_EVT_DATA, eSetBits);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Program everything staged and buffered.
+ */
+bool LogStore_Flush(void)
+{
+    if (g_logStoreLock == NULL)
+    {
+        return false;
+    }
+
+    (void)xSemaphoreTake(g_logStoreLock, portMAX_DELAY);
+    bool ok = (g_logStoreState == LOGSTORE_READY);
+    if (ok)
+    {
+        ok = LogStore_Drain() && LogStore_FlushPage();
+        if (!ok)
+        {
+            LogStore_Fail();
+        }
+    }
+    (void)xSemaphoreGive(g_logStoreLock);
+    return ok;
+}
+
+/**
+ * @brief Place a cursor before the oldest record.
+ */
+void LogStore_ReadBegin(LogStore_Cursor_T *cursor)
+{
+    if (cursor != NULL)
+    {
+        cursor->sector = 0U;
+        cursor->seq = 0U;
+        cursor->offset = 0U;
+    }
+}
+
+/**
+ * @brief Read the record after the cursor.
+ */
+bool LogStore_ReadNext(LogStore_Cursor_T *cursor, void *buf, uint32_t size, uint32_t *length)
+{
+    if ((cursor == NULL) || (buf == NULL) || (length == NULL) || (g_logStoreLock == NULL))
+    {
+        return false;
+    }
+
+    (void)xSemaphoreTake(g_logStoreLock, portMAX_DELAY);
+    bool ok = (g_logStoreState == LOGSTORE_READY) && LogStore_ReadRecord(cursor, buf, size, length);
+    (void)xSemaphoreGive(g_logStoreLock);
+    return ok;
+}
+
+/**
+ * @brief Copy the store counters into @p status.
+ */
+void LogStore_GetStatus(LogStore_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_logStoreStatus;
+    status->mounted = (g_logStoreState == LOGSTORE_READY);
+    status->sectors = g_logStoreSectors;
+    status->sectors_used = g_logStoreUsed;
+    status->head_seq = g_logStoreHeadSeq;
+    status->stage_level = g_logStoreStageHead - g_logStoreStageTail;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Store task.
+ *
+ * Mounts the ring first: the scan blocks on SPI transfers, so it cannot
+ * run before the scheduler starts. Staged records are moved to the page buffer once the ring is a quarter
+ * full, which programs the pages they fill. When the oldest byte not in
+ * flash has waited ::LOGSTORE_FLUSH_MS, the rest is moved too and the
+ * partial page is programmed.
+ *
+ * @param[in] arg Unused.
+ */
+static void LogStore_Task(void *arg)
+{
+    (void)arg;
+    const TickType_t flushTicks = pdMS_TO_TICKS(LOGSTORE_FLUSH_MS);
+
+    (void)LogStore_Mount();
+
+    for (;;)
+    {
+        uint32_t level = g_logStoreStageHead - g_logStoreStageTail;
+        bool dirty = (g_logStoreWrite != g_logStoreDone);
+        TickType_t wait = portMAX_DELAY;
+        if ((g_logStoreState == LOGSTORE_READY) && (dirty || (level != 0U)))
+        {
+            TickType_t elapsed = xTaskGetTickCount() - (dirty ? g_logStoreDirtyTick : g_logStoreStageTick);
+            wait = (elapsed >= flushTicks) ? 0U : (flushTicks - elapsed);
+        }
+        if ((wait != 0U) && (level < LOGSTORE_STAGE_WAKE))
+        {
+            (void)xTaskNotifyWaitIndexed(LOGSTORE_NOTIFY_INDEX, 0U, LOGSTORE_EVT_DATA, NULL, wait);
+        }
+
+        (void)xSemaphoreTake(g_logStoreLock, portMAX_DELAY);
+        if (g_logStoreState == LOGSTORE_READY)
+        {
+            level = g_logStoreStageHead - g_logStoreStageTail;
+            dirty = (g_logStoreWrite != g_logStoreDone);
+            TickType_t since = dirty ? g_logStoreDirtyTick : g_logStoreStageTick;
+            bool due = (dirty || (level != 0U)) && ((xTaskGetTickCount() - since) >= flushTicks);
+            bool ok = true;
+            if (due || (level >= LOGSTORE_STAGE_WAKE))
+            {
+                ok = LogStore_Drain();
+            }
+            if (ok && due)
+            {
+                ok = LogStore_FlushPage();
+            }
+            if (!ok)
+            {
+                LogStore_Fail();
+            }
+        }
+        else if (g_logStoreState == LOGSTORE_OFFLINE)
+        {
+            LogStore_Discard();
+        }
+        (void)xSemaphoreGive(g_logStoreLock);
+    }
+}
+
+/**
+ * @brief Mount: identify the flash, size the ring and locate its ends.
+ *
+ * Reads every sector header; the valid one with the highest sequence
+ * number is the newest sector, the lowest the oldest. Only the records of
+ * the newest sector are checked, up to the first erased or invalid one.
+ * Anything but erased flash after it means a write was cut, and the
+ * sector is closed.
+ */
+static bool LogStore_Scan(void)
+{
+    g_logStoreOpen = false;
+    g_logStoreWrite = 0U;
+    g_logStoreDone = 0U;
+
+    if (!LogStore_Command(LOGSTORE_CMD_JEDEC_ID, 0U, false, NULL, g_logStoreIo, 3U))
+    {
+        return false;
+    }
+    g_logStoreStatus.jedec_id = ((uint32_t)g_logStoreIo[0] << 16) | ((uint32_t)g_logStoreIo[1] << 8) |
+                                g_logStoreIo[2];
+    uint32_t sizeCode = g_logStoreIo[2];
+    if ((g_logStoreIo[0] == 0x00U) || (g_logStoreIo[0] == 0xFFU) || (sizeCode < 12U) || (sizeCode > 31U))
+    {
+        return false;
+    }
+    uint32_t capacity = 1UL << sizeCode;
+    capacity = (capacity > LOGSTORE_ADDR_LIMIT) ? LOGSTORE_ADDR_LIMIT : capacity;
+    if (capacity <= LOGSTORE_FLASH_OFFSET)
+    {
+        return false;
+    }
+    uint32_t bytes = capacity - LOGSTORE_FLASH_OFFSET;
+    bytes = (bytes > LOGSTORE_MAX_BYTES) ? LOGSTORE_MAX_BYTES : bytes;
+    g_logStoreSectors = bytes / LOGSTORE_SECTOR_SIZE;
+    g_logStoreUsed = 0U;
+    if (g_logStoreSectors < 2U)
+    {
+        return false;
+    }
+
+    /* An erase started before a reset may still run */
+    if (!LogStore_WaitReady(1000U, LOGSTORE_ERASE_TIMEOUT_MS))
+    {
+        return false;
+    }
+
+    bool found = false;
+    uint32_t minSeq = 0U;
+    uint32_t eraseMin = 0U;
+    uint32_t eraseMax = 0U;
+    for (uint32_t sector = 0U; sector < g_logStoreSectors; sector++)
+    {
+        LogStore_SectorHdr_T hdr;
+        bool valid;
+        if (!LogStore_ReadHeader(sector, &hdr, &valid))
+        {
+            return false;
+        }
+        if (!valid)
+        {
+            continue;
+        }
+        if (!found || (hdr.seq > g_logStoreHeadSeq))
+        {
+            g_logStoreHead = sector;
+            g_logStoreHeadSeq = hdr.seq;
+            g_logStoreHeadErase = hdr.erase_count;
+        }
+        if (!found || (hdr.seq < minSeq))
+        {
+            g_logStoreTail = sector;
+            minSeq = hdr.seq;
+        }
+        eraseMin = (!found || (hdr.erase_count < eraseMin)) ? hdr.erase_count : eraseMin;
+        eraseMax = (!found || (hdr.erase_count > eraseMax)) ? hdr.erase_count : eraseMax;
+        found = true;
+    }
+    g_logStoreStatus.erase_min = eraseMin;
+    g_logStoreStatus.erase_max = eraseMax;
+
+    if (!found)
+    {
+        /* Empty ring: the first record opens sector 0 */
+        g_logStoreTail = 0U;
+        g_logStoreHead = 0U;
+        g_logStoreHeadSeq = 0U;
+        g_logStoreHeadErase = 0U;
+        return true;
+    }
+    g_logStoreUsed = ((g_logStoreHead + g_logStoreSectors - g_logStoreTail) % g_logStoreSectors) + 1U;
+
+    uint32_t offset = LOGSTORE_HDR_SIZE;
+    bool clean = true;
+    for (;;)
+    {
+        uint32_t length;
+        bool valid;
+        bool erased;
+        if (!LogStore_CheckRecord(g_logStoreHead, offset, &length, &valid, &erased))
+        {
+            return false;
+        }
+        if (!valid)
+        {
+            clean = erased;
+            break;
+        }
+        offset += LOGSTORE_RECORD_SPAN(length);
+    }
+
+    /* The rest of the sector must be erased to take more records */
+    uint32_t base = LogStore_SectorAddr(g_logStoreHead);
+    for (uint32_t at = offset; clean && (at < LOGSTORE_SECTOR_SIZE);)
+    {
+        uint32_t chunk = LOGSTORE_PAGE_SIZE - (at % LOGSTORE_PAGE_SIZE);
+        if (!LogStore_Read(base + at, chunk))
+        {
+            return false;
+        }
+        for (uint32_t i = 0U; i < chunk; i++)
+        {
+            clean = clean && (g_logStoreIo[i] == 0xFFU);
+        }
+        at += chunk;
+    }
+
+    if (clean)
+    {
+        g_logStoreOpen = true;
+        g_logStoreWrite = offset;
+        g_logStoreDone = offset;
+        memset(g_logStorePage, 0xFF, sizeof(g_logStorePage));
+    }
+    else
+    {
+        g_logStoreStatus.torn++;
+    }
+    return true;
+}
+
+/**
+ * @brief Empty the staging ring, counting its records as dropped.
+ */
+static void LogStore_Discard(void)
+{
+    uint32_t tail = g_logStoreStageTail;
+    while (tail != g_logStoreStageHead)
+    {
+        uint16_t length;
+        uint32_t at = tail % LOGSTORE_STAGE_BYTES;
+        length = (uint16_t)g_logStoreStage[at];
+        length |= (uint16_t)((uint16_t)g_logStoreStage[(at + 1U) % LOGSTORE_STAGE_BYTES] << 8);
+        tail += sizeof(length) + length;
+        g_logStoreStatus.dropped++;
+    }
+    g_logStoreStageTail = tail;
+}
+
+/**
+ * @brief Stop writing after a failed flash operation; ::LogStore_Mount brings the store back.
+ */
+static void LogStore_Fail(void)
+{
+    g_logStoreState = LOGSTORE_OFFLINE;
+    g_logStoreOpen = false;
+    g_logStoreDone = g_logStoreWrite;
+    LogStore_Discard();
+}
+
+/**
+ * @brief Copy bytes into the staging ring, wrapping at its end.
+ */
+static void LogStore_StageWrite(uint32_t pos, const void *src, uint32_t size)
+{
+    uint32_t at = pos % LOGSTORE_STAGE_BYTES;
+    uint32_t first = LOGSTORE_STAGE_BYTES - at;
+    first = (first > size) ? size : first;
+
+    memcpy(&g_logStoreStage[at], src, first);
+    memcpy(g_logStoreStage, (const uint8_t *)src + first, size - first);
+}
+
+/**
+ * @brief Move the staged records to the newest sector, oldest first.
+ *
+ * @retval true  Staging ring empty.
+ * @retval false A flash operation failed, the record was dropped.
+ */
+static bool LogStore_Drain(void)
+{
+    uint32_t tail = g_logStoreStageTail;
+
+    while (tail != g_logStoreStageHead)
+    {
+        uint32_t at = tail % LOGSTORE_STAGE_BYTES;
+        uint32_t length = g_logStoreStage[at];
+        length |= (uint32_t)g_logStoreStage[(at + 1U) % LOGSTORE_STAGE_BYTES] << 8;
+        bool ok = LogStore_PutRecord(tail + 2U, length);
+
+        /* The bytes are copied or lost either way */
+        tail += 2U + length;
+        g_logStoreStageTail = tail;
+        if (!ok)
+        {
+            g_logStoreStatus.dropped++;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Append one staged record, opening the next sector when it does not fit.
+ *
+ * @param[in] pos    Free-running staging index of the payload.
+ * @param[in] length Payload bytes.
+ */
+static bool LogStore_PutRecord(uint32_t pos, uint32_t length)
+{
+    if (!g_logStoreOpen || ((g_logStoreWrite + LOGSTORE_RECORD_SPAN(length)) > LOGSTORE_SECTOR_SIZE))
+    {
+        if (!LogStore_OpenSector())
+        {
+            return false;
+        }
+    }
+
+    uint32_t at = pos % LOGSTORE_STAGE_BYTES;
+    uint32_t first = LOGSTORE_STAGE_BYTES - at;
+    first = (first > length) ? length : first;
+
+    Crc_Ctx_T crc;
+    (void)Crc_Begin(&crc, &g_logStoreCrc);
+    Crc_Update(&crc, &g_logStoreStage[at], first);
+    Crc_Update(&crc, g_logStoreStage, length - first);
+    const LogStore_RecordHdr_T hdr = {
+        .length = (uint16_t)length,
+        .check = (uint16_t)~length,
+        .crc = Crc_Final(&crc),
+    };
+
+    bool ok = LogStore_Put(&hdr, sizeof(hdr)) && LogStore_Put(&g_logStoreStage[at], first) &&
+              LogStore_Put(g_logStoreStage, length - first) &&
+              LogStore_Put(g_logStorePad, LOGSTORE_RECORD_SPAN(length) - LOGSTORE_REC_HDR_SIZE - length);
+    if (ok)
+    {
+        g_logStoreStatus.records++;
+        g_logStoreStatus.bytes += length;
+    }
+    return ok;
+}
+
+/**
+ * @brief Add bytes at the write offset of the newest sector.
+ */
+static bool LogStore_Put(const void *src, uint32_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)src;
+
+    while (size != 0U)
+    {
+        uint32_t at = g_logStoreWrite % LOGSTORE_PAGE_SIZE;
+        uint32_t chunk = LOGSTORE_PAGE_SIZE - at;
+        chunk = (chunk > size) ? size : chunk;
+
+        if (g_logStoreWrite == g_logStoreDone)
+        {
+            g_logStoreDirtyTick = xTaskGetTickCount();
+        }
+        memcpy(&g_logStorePage[at], bytes, chunk);
+        g_logStoreWrite += chunk;
+        bytes += chunk;
+        size -= chunk;
+
+        if (((g_logStoreWrite % LOGSTORE_PAGE_SIZE) == 0U) && !LogStore_FlushPage())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Program the page buffer from the programmed offset to the write offset.
+ *
+ * Erased bytes of a page may be programmed later, so a partial page is
+ * completed by further programs of the same page.
+ */
+static bool LogStore_FlushPage(void)
+{
+    if (g_logStoreWrite == g_logStoreDone)
+    {
+        return true;
+    }
+
+    uint32_t at = g_logStoreDone % LOGSTORE_PAGE_SIZE;
+    uint32_t size = g_logStoreWrite - g_logStoreDone;
+    bool ok = LogStore_Program(LogStore_SectorAddr(g_logStoreHead) + g_logStoreDone, &g_logStorePage[at], size);
+
+    g_logStoreDone = g_logStoreWrite;
+    if ((g_logStoreWrite % LOGSTORE_PAGE_SIZE) == 0U)
+    {
+        memset(g_logStorePage, 0xFF, sizeof(g_logStorePage));
+    }
+    return ok;
+}
+
+/**
+ * @brief Open the sector after the newest one.
+ *
+ * When the ring is full that sector is the oldest, and its records are
+ * given up. Its erase count is carried over from its header when still
+ * readable; a blank sector starts from zero and one whose header was
+ * damaged takes the count of the newest sector, as the ring wears all
+ * sectors alike.
+ */
+static bool LogStore_OpenSector(void)
+{
+    if (!LogStore_FlushPage())
+    {
+        return false;
+    }
+    g_logStoreOpen = false;
+
+    uint32_t next = (g_logStoreUsed == 0U) ? g_logStoreTail : ((g_logStoreHead + 1U) % g_logStoreSectors);
+    LogStore_SectorHdr_T old;
+    bool valid;
+    if (!LogStore_ReadHeader(next, &old, &valid))
+    {
+        return false;
+    }
+    bool blank = (old.magic == UINT32_MAX) && (old.seq == UINT32_MAX) && (old.erase_count == UINT32_MAX) &&
+                 (old.crc == UINT32_MAX);
+    uint32_t eraseCount = valid ? (old.erase_count + 1U) : (blank ? 1U : g_logStoreHeadErase);
+
+    if (g_logStoreUsed == g_logStoreSectors)
+    {
+        g_logStoreTail = (g_logStoreTail + 1U) % g_logStoreSectors;
+        g_logStoreUsed--;
+        g_logStoreStatus.reclaimed++;
+    }
+    if (!LogStore_Erase(LogStore_SectorAddr(next)))
+    {
+        return false;
+    }
+
+    LogStore_SectorHdr_T hdr = {
+        .magic = LOGSTORE_MAGIC,
+        .seq = g_logStoreHeadSeq + 1U,
+        .erase_count = eraseCount,
+    };
+    hdr.crc = Crc_Compute(&g_logStoreCrc, &hdr, offsetof(LogStore_SectorHdr_T, crc));
+
+    if (g_logStoreUsed == 0U)
+    {
+        g_logStoreTail = next;
+    }
+    g_logStoreHead = next;
+    g_logStoreHeadSeq = hdr.seq;
+    g_logStoreHeadErase = eraseCount;
+    g_logStoreUsed++;
+    if (eraseCount > g_logStoreStatus.erase_max)
+    {
+        g_logStoreStatus.erase_max = eraseCount;
+    }
+
+    g_logStoreWrite = 0U;
+    g_logStoreDone = 0U;
+    memset(g_logStorePage, 0xFF, sizeof(g_logStorePage));
+    if (!LogStore_Put(&hdr, sizeof(hdr)) || !LogStore_FlushPage())
+    {
+        return false;
+    }
+    g_logStoreOpen = true;
+    return true;
+}
+
+/**
+ * @brief Read the header of a sector.
+ *
+ * @param[out] valid Magic, sequence number and CRC are right.
+ *
+ * @retval false The flash read failed.
+ */
+static bool LogStore_ReadHeader(uint32_t sector, LogStore_SectorHdr_T *hdr, bool *valid)
+{
+    if (!LogStore_Read(LogStore_SectorAddr(sector), sizeof(*hdr)))
+    {
+        return false;
+    }
+    memcpy(hdr, g_logStoreIo, sizeof(*hdr));
+    *valid = (hdr->magic == LOGSTORE_MAGIC) && (hdr->seq != 0U) && (hdr->seq != UINT32_MAX) &&
+             (Crc_Compute(&g_logStoreCrc, hdr, offsetof(LogStore_SectorHdr_T, crc)) == hdr->crc);
+    return true;
+}
+
+/**
+ * @brief Check the record at an offset of a sector without copying it.
+ *
+ * @param[out] length Payload bytes of a valid record.
+ * @param[out] valid  Header consistent, record inside the sector, payload CRC right.
+ * @param[out] erased The header is erased flash, nothing was written there.
+ *
+ * @retval false The flash read failed.
+ */
+static bool LogStore_CheckRecord(uint32_t sector, uint32_t offset, uint32_t *length, bool *valid, bool *erased)
+{
+    LogStore_RecordHdr_T hdr;
+    uint32_t base = LogStore_SectorAddr(sector);
+
+    *valid = false;
+    *erased = (offset + LOGSTORE_REC_HDR_SIZE) > LOGSTORE_SECTOR_SIZE;
+    if (*erased)
+    {
+        return true;
+    }
+    if (!LogStore_Read(base + offset, sizeof(hdr)))
+    {
+        return false;
+    }
+    memcpy(&hdr, g_logStoreIo, sizeof(hdr));
+    *erased = (hdr.length == LOGSTORE_ERASED_LENGTH) && (hdr.check == LOGSTORE_ERASED_LENGTH) &&
+              (hdr.crc == UINT32_MAX);
+    if (((uint16_t)(hdr.check ^ hdr.length) != 0xFFFFU) || (hdr.length == 0U) ||
+        (hdr.length > LOGSTORE_MAX_RECORD) || ((offset + LOGSTORE_RECORD_SPAN(hdr.length)) > LOGSTORE_SECTOR_SIZE))
+    {
+        return true;
+    }
+
+    Crc_Ctx_T crc;
+    (void)Crc_Begin(&crc, &g_logStoreCrc);
+    for (uint32_t done = 0U; done < hdr.length;)
+    {
+        uint32_t at = base + offset + LOGSTORE_REC_HDR_SIZE + done;
+        uint32_t chunk = LOGSTORE_PAGE_SIZE - (at % LOGSTORE_PAGE_SIZE);
+        chunk = (chunk > (hdr.length - done)) ? (hdr.length - done) : chunk;
+        if (!LogStore_Read(at, chunk))
+        {
+            return false;
+        }
+        Crc_Update(&crc, g_logStoreIo, chunk);
+        done += chunk;
+    }
+    *valid = (Crc_Final(&crc) == hdr.crc);
+    *length = hdr.length;
+    return true;
+}
+
+/**
+ * @brief Point a cursor at the start of the first valid sector from @p sector to the newest.
+ *
+ * @retval false No such sector or the flash read failed.
+ */
+static bool LogStore_EnterSector(LogStore_Cursor_T *cursor, uint32_t sector)
+{
+    for (;;)
+    {
+        LogStore_SectorHdr_T hdr;
+        bool valid;
+        if (!LogStore_ReadHeader(sector, &hdr, &valid))
+        {
+            return false;
+        }
+        if (valid)
+        {
+            cursor->sector = sector;
+            cursor->seq = hdr.seq;
+            cursor->offset = LOGSTORE_HDR_SIZE;
+            return true;
+        }
+        g_logStoreStatus.crc_errors++;
+        if (sector == g_logStoreHead)
+        {
+            return false;
+        }
+        sector = (sector + 1U) % g_logStoreSectors;
+    }
+}
+
+/**
+ * @brief Read the record after the cursor, moving to the next sector at the end of one.
+ *
+ * A cursor whose sector no longer carries the sequence number it entered
+ * with was overtaken by the reclamation and restarts at the oldest sector.
+ */
+static bool LogStore_ReadRecord(LogStore_Cursor_T *cursor, void *buf, uint32_t size, uint32_t *length)
+{
+    if (g_logStoreUsed == 0U)
+    {
+        return false;
+    }
+
+    if (cursor->seq != 0U)
+    {
+        LogStore_SectorHdr_T hdr;
+        bool valid;
+        if (!LogStore_ReadHeader(cursor->sector, &hdr, &valid))
+        {
+            return false;
+        }
+        if (!valid || (hdr.seq != cursor->seq))
+        {
+            cursor->seq = 0U;
+        }
+    }
+    if ((cursor->seq == 0U) && !LogStore_EnterSector(cursor, g_logStoreTail))
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        uint32_t found;
+        bool valid;
+        bool erased;
+        if (!LogStore_CheckRecord(cursor->sector, cursor->offset, &found, &valid, &erased))
+        {
+            return false;
+        }
+        if (valid)
+        {
+            if (found > size)
+            {
+                return false;
+            }
+            uint32_t at = LogStore_SectorAddr(cursor->sector) + cursor->offset + LOGSTORE_REC_HDR_SIZE;
+            for (uint32_t done = 0U; done < found;)
+            {
+                uint32_t chunk = LOGSTORE_PAGE_SIZE - ((at + done) % LOGSTORE_PAGE_SIZE);
+                chunk = (chunk > (found - done)) ? (found - done) : chunk;
+                if (!LogStore_Read(at + done, chunk))
+                {
+                    return false;
+                }
+                memcpy((uint8_t *)buf + done, g_logStoreIo, chunk);
+                done += chunk;
+            }
+            cursor->offset += LOGSTORE_RECORD_SPAN(found);
+            *length = found;
+            return true;
+        }
+        if (!erased)
+        {
+            g_logStoreStatus.crc_errors++;
+        }
+
+        /* End of this sector's records */
+        if (cursor->sector == g_logStoreHead)
+        {
+            return false;
+        }
+        if (!LogStore_EnterSector(cursor, (cursor->sector + 1U) % g_logStoreSectors))
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Flash address of a ring position.
+ */
+static uint32_t LogStore_SectorAddr(uint32_t sector)
+{
+    return LOGSTORE_FLASH_OFFSET + (sector * LOGSTORE_SECTOR_SIZE);
+}
+
+/**
+ * @brief Run one flash command.
+ *
+ * The command and address go out as one transaction that keeps the flash
+ * selected, the data bytes as a second one that ends the command.
+ *
+ * @param[in]  cmd      Command byte.
+ * @param[in]  addr     24-bit address.
+ * @param[in]  withAddr Send @p addr after the command byte.
+ * @param[in]  tx       Data sent, NULL sends filler bytes.
+ * @param[out] rx       Data received, NULL discards it.
+ * @param[in]  size     Data bytes, 0 for none.
+ */
+static bool LogStore_Command(uint8_t cmd, uint32_t addr, bool withAddr, const void *tx, void *rx, uint32_t size)
+{
+    g_logStoreCmd[0] = cmd;
+    g_logStoreCmd[1] = (uint8_t)(addr >> 16);
+    g_logStoreCmd[2] = (uint8_t)(addr >> 8);
+    g_logStoreCmd[3] = (uint8_t)addr;
+
+    bool ok = SpiDma_TransferWait(&g_logStoreDev, g_logStoreCmd, NULL, withAddr ? 4U : 1U,
+                                  (size != 0U) ? SPIDMA_XFER_KEEP_CS : 0U);
+    if (ok && (size != 0U))
+    {
+        ok = SpiDma_TransferWait(&g_logStoreDev, tx, rx, (uint16_t)size, 0U);
+    }
+    if (!ok)
+    {
+        g_logStoreStatus.flash_errors++;
+    }
+    return ok;
+}
+
+/**
+ * @brief Read @p size bytes, at most a page, into ::g_logStoreIo.
+ */
+static bool LogStore_Read(uint32_t addr, uint32_t size)
+{
+    return LogStore_Command(LOGSTORE_CMD_READ, addr, true, NULL, g_logStoreIo, size);
+}
+
+/**
+ * @brief Program bytes that do not cross a page boundary.
+ */
+static bool LogStore_Program(uint32_t addr, const void *src, uint32_t size)
+{
+    bool ok = LogStore_Command(LOGSTORE_CMD_WREN, 0U, false, NULL, NULL, 0U) &&
+              LogStore_Command(LOGSTORE_CMD_PP, addr, true, src, NULL, size);
+    if (ok)
+    {
+        g_logStoreStatus.pages++;
+        LogStore_Sleep(LOGSTORE_PROGRAM_POLL_US);
+        ok = LogStore_WaitReady(LOGSTORE_PROGRAM_POLL_US, LOGSTORE_PROGRAM_TIMEOUT_MS);
+    }
+    return ok;
+}
+
+/**
+ * @brief Erase the sector at @p addr.
+ */
+static bool LogStore_Erase(uint32_t addr)
+{
+    bool ok = LogStore_Command(LOGSTORE_CMD_WREN, 0U, false, NULL, NULL, 0U) &&
+              LogStore_Command(LOGSTORE_CMD_SE, addr, true, NULL, NULL, 0U);
+    if (ok)
+    {
+        g_logStoreStatus.erases++;
+        LogStore_Sleep(1000U);
+        ok = LogStore_WaitReady(1000U, LOGSTORE_ERASE_TIMEOUT_MS);
+    }
+    return ok;
+}
+
+/**
+ * @brief Poll WIP until it clears.
+ *
+ * @param[in] pollUs    Time between polls.
+ * @param[in] timeoutMs Time after which the flash is considered gone.
+ */
+static bool LogStore_WaitReady(uint32_t pollUs, uint32_t timeoutMs)
+{
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;)
+    {
+        if (!LogStore_Command(LOGSTORE_CMD_RDSR, 0U, false, NULL, g_logStoreIo, 1U))
+        {
+            return false;
+        }
+        if ((g_logStoreIo[0] & LOGSTORE_SR_WIP) == 0U)
+        {
+            return true;
+        }
+        if ((g_logStoreIo[0] == LOGSTORE_SR_ABSENT) || ((xTaskGetTickCount() - start) > pdMS_TO_TICKS(timeoutMs)))
+        {
+            g_logStoreStatus.flash_errors++;
+            return false;
+        }
+        LogStore_Sleep(pollUs);
+    }
+}
+
+/**
+ * @brief Sleep whole ticks from a millisecond on, else on a microsecond timer.
+ *
+ * The timer sets ::LOGSTORE_EVT_POLL of the calling task; other bits of
+ * the notification value are left for their owner.
+ */
+static void LogStore_Sleep(uint32_t us)
+{
+    if (us >= 1000U)
+    {
+        vTaskDelay(pdMS_TO_TICKS(us / 1000U));
+        return;
+    }
+
+    HrTimer_Setup(&g_logStorePoll, NULL, NULL, xTaskGetCurrentTaskHandle(), LOGSTORE_EVT_POLL);
+    if (!HrTimer_Start(&g_logStorePoll, us, 0U))
+    {
+        taskYIELD();
+        return;
+    }
+    uint32_t bits = 0U;
+    do
+    {
+        (void)xTaskNotifyWaitIndexed(LOGSTORE_NOTIFY_INDEX, 0U, LOGSTORE_EVT_POLL, &bits, portMAX_DELAY);
+    } while ((bits & LOGSTORE_EVT_POLL) == 0U);
+}
+
+/** @} */ // end of LogStore group
@@ -0,0 +1,106 @@
+/**
+ * @file LpTick.h
+ * @brief Kernel tick on LPTIM1 with tickless idle
+ *
+ * LPTIM1 counts the 32.768 kHz LSE, or the LSI when the crystal does not
+ * start, and its compare channel raises the kernel tick instead of SysTick.
+ * Tick k falls on count k x clock / configTICK_RATE_HZ of the counter,
+ * extended to 64 bits, so ticks never drift even when the clock is not a
+ * multiple of the tick rate.
+ *
+ * When every task is blocked for two ticks or more the kernel calls
+ * ::LpTick_SuppressTicksAndSleep through portSUPPRESS_TICKS_AND_SLEEP: the
+ * compare moves to the tick the next task wakes at and the core sleeps
+ * through the ticks in between. On wake-up the tick count is stepped by
+ * the tick boundaries the counter actually passed, keeping the phase of
+ * every later tick, and so vTaskDelayUntil() periods, unchanged.
+ */
+
+#ifndef LP_TICK_H
+#define LP_TICK_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef LPTICK_MAX_SLEEP_COUNTS
+#define LPTICK_MAX_SLEEP_COUNTS (0xC000U) /**< Longest sleep in counter periods, below one 16-bit lap */
+#endif
+
+#ifndef LPTICK_TICKLESS_DEFAULT
+#define LPTICK_TICKLESS_DEFAULT (true) /**< Ticks are suppressed at idle from the start */
+#endif
+
+#define LPTICK_MIN_LEAD (4U) /**< Counter periods a compare must lie ahead to be seen after its write */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Tick counters.
+ */
+typedef struct
+{
+    uint32_t clock_hz;         /**< LPTIM1 counter rate, 0 when the tick falls back to SysTick */
+    bool lse;                  /**< The counter runs on the LSE crystal, else on the LSI */
+    bool tickless;             /**< Ticks are suppressed at idle */
+    uint32_t tick_irqs;        /**< Tick interrupts handled */
+    uint32_t ticks;            /**< Ticks announced by the interrupt */
+    uint32_t sleeps;           /**< Tickless sleeps entered */
+    uint32_t sleep_aborts;     /**< Tickless sleeps abandoned because a task became ready */
+    uint32_t ticks_stepped;    /**< Ticks accounted for on wake-up instead of by an interrupt */
+    uint32_t sleep_max_ticks;  /**< Longest tickless sleep */
+    uint32_t max_idle_ticks;   /**< Longest sleep the counter allows */
+    uint32_t cmp_timeouts;     /**< Compare writes made without CMP1OK confirming the previous one */
+} LpTick_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Start the low-speed oscillator and LPTIM1 and take its interrupt.
+ *
+ * The tick itself starts with the scheduler. If this fails the scheduler
+ * drives the tick from SysTick and never suppresses it.
+ *
+ * @retval true  LPTIM1 counts and will drive the tick.
+ * @retval false No oscillator started or the interrupt is taken.
+ */
+bool LpTick_Init(void);
+
+/**
+ * @brief Allow or forbid suppressing ticks at idle.
+ *
+ * Callable from tasks; with tickless idle off the tick interrupt runs
+ * every tick as with SysTick.
+ *
+ * @param[in] enable Suppress ticks from the next idle period on.
+ */
+void LpTick_SetTickless(bool enable);
+
+/**
+ * @brief Current counter value extended to 64 bits.
+ *
+ * @return Periods of 1 / @ref LpTick_Status_T::clock_hz since LPTIM1 started.
+ */
+uint64_t LpTick_GetCount(void);
+
+/**
+ * @brief Sleep through the next ticks; portSUPPRESS_TICKS_AND_SLEEP of the kernel.
+ *
+ * Called by the idle task with the scheduler suspended.
+ *
+ * @param[in] expectedIdleTime Ticks until the next task wakes up.
+ */
+void LpTick_SuppressTicksAndSleep(TickType_t expectedIdleTime);
+
+/**
+ * @brief Copy the tick counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void LpTick_GetStatus(LpTick_Status_T *status);
+
+#endif /* LP_TICK_H */
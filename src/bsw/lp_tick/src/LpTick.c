@@ -0,0 +1,446 @@
+/**
+ * @file LpTick.c
+ * @brief Implementation of the LPTIM1 kernel tick and tickless idle.
+ * @ingroup LpTick
+ * @{
+ *
+ * LPTIM1 runs free over its 16-bit range and software extends the count to
+ * 64 bits whenever it is read; the compare interrupt or a tickless sleep
+ * reads it at least once per lap. Tick boundaries are computed from the
+ * tick index, never accumulated, so a clock that is not a multiple of the
+ * tick rate only makes single ticks a counter period early or late.
+ *
+ * The compare always holds the next boundary the tick must be announced
+ * at. LPTIM1 takes a few counter periods to apply a compare write, so a
+ * boundary closer than ::LPTICK_MIN_LEAD is programmed at the lead instead
+ * and the interrupt announces every boundary passed. A new compare is
+ * only written once CMP1OK reports the previous one applied, waiting at
+ * most ::LPTICK_SPIN_LIMIT polls: the wait runs with interrupts masked,
+ * and a stopped LPTIM1 clock must not hang the core.
+ *
+ * A tickless sleep programs the boundary the kernel expects to wake at and
+ * waits for any interrupt with PRIMASK set. Whatever wakes the core, the
+ * boundaries passed meanwhile are stepped into the tick count at once,
+ * capped to the expected idle time the kernel allows, and the compare
+ * returns to the next boundary not yet announced.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "LpTick.h"
+#include <stddef.h>
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_lptim.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_pwr.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define LPTICK_LPTIM LPTIM1              /**< Low-power timer used */
+#define LPTICK_IRQ LPTIM1_IRQn           /**< Its interrupt */
+#define LPTICK_LAP (0x10000U)            /**< Counter periods in one lap of the 16-bit counter */
+#define LPTICK_SPIN_LIMIT (10000U)       /**< Polls of an LPTIM1 register write before giving up on it */
+#define LPTICK_OSC_SPIN_LIMIT (1000000U) /**< Polls of an oscillator ready flag before falling back */
+
+#if (LPTICK_MAX_SLEEP_COUNTS >= LPTICK_LAP) || (LPTICK_MAX_SLEEP_COUNTS <= LPTICK_MIN_LEAD)
+#error "LPTICK_MAX_SLEEP_COUNTS must lie between LPTICK_MIN_LEAD and one counter lap"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** LPTIM1 counts and drives the tick. */
+static bool g_lpTickRunning = false;
+/** Ticks are suppressed at idle. */
+static volatile bool g_lpTickTickless = LPTICK_TICKLESS_DEFAULT;
+/** A compare write has not been confirmed by CMP1OK yet. */
+static bool g_lpTickCmpPending = false;
+/** Extended count of the start of the current counter lap. */
+static uint64_t g_lpTickLapBase = 0U;
+/** Counter value seen by the last read. */
+static uint32_t g_lpTickLastCnt = 0U;
+/** Index of the next tick boundary to announce. */
+static uint64_t g_lpTickNext = 0U;
+/** Counters reported by ::LpTick_GetStatus. */
+static LpTick_Status_T g_lpTickStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Start an oscillator and select it as the LPTIM1 kernel clock. */
+static bool LpTick_StartClock(void);
+/** Poll an LPTIM1 flag until it is set. */
+static bool LpTick_WaitFlag(uint32_t flag);
+/** Stable read of the asynchronous counter. */
+static uint32_t LpTick_ReadCounter(void);
+/** Counter extended to 64 bits. */
+static uint64_t LpTick_Count(void);
+/** Extended count tick @p index falls on. */
+static uint64_t LpTick_Boundary(uint64_t index);
+/** Index of the last tick boundary at or before @p count. */
+static uint64_t LpTick_LastIndex(uint64_t count);
+/** Program the compare for a boundary. */
+static void LpTick_Program(uint64_t target);
+/** Compare interrupt: announce every tick boundary passed. */
+static void LpTick_IrqHandler(void *ctx);
+
+/** Tick source setup of the kernel port, called when the scheduler starts. */
+void vPortSetupTimerInterrupt(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start the low-speed oscillator and LPTIM1 and take its interrupt.
+ *
+ * The counter runs continuously over the full 16-bit range from the
+ * undivided oscillator; channel 1 only raises its match flag.
+ */
+bool LpTick_Init(void)
+{
+    if (!LpTick_StartClock())
+    {
+        return false;
+    }
+
+    uint32_t clockHz = LL_RCC_GetLPTIMClockFreq(LL_RCC_LPTIM1_CLKSOURCE);
+    if ((clockHz == LL_RCC_PERIPH_FREQUENCY_NO) || (clockHz < configTICK_RATE_HZ))
+    {
+        return false;
+    }
+
+    if (!IsrMgr_Register(LPTICK_IRQ, LpTick_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    LL_APB1_GRP1_EnableClock(LL_APB1_GRP1_PERIPH_LPTIM1);
+    LL_LPTIM_Disable(LPTICK_LPTIM);
+    LL_LPTIM_InitTypeDef init;
+    LL_LPTIM_StructInit(&init);
+    init.ClockSource = LL_LPTIM_CLK_SOURCE_INTERNAL;
+    init.Prescaler = LL_LPTIM_PRESCALER_DIV1;
+    init.Waveform = LL_LPTIM_OUTPUT_WAVEFORM_PWM;
+    if (LL_LPTIM_Init(LPTICK_LPTIM, &init) != SUCCESS)
+    {
+        return false;
+    }
+
+    /* DIER and ARR are only written once the timer is enabled */
+    LL_LPTIM_Enable(LPTICK_LPTIM);
+    LL_LPTIM_ClearFlag_DIEROK(LPTICK_LPTIM);
+    LL_LPTIM_EnableIT_CC1(LPTICK_LPTIM);
+    if (!LpTick_WaitFlag(LPTIM_ISR_DIEROK))
+    {
+        return false;
+    }
+    LL_LPTIM_ClearFlag_ARROK(LPTICK_LPTIM);
+    LL_LPTIM_SetAutoReload(LPTICK_LPTIM, LPTICK_LAP - 1U);
+    if (!LpTick_WaitFlag(LPTIM_ISR_ARROK))
+    {
+        return false;
+    }
+    LL_LPTIM_ClearFlag_CC1(LPTICK_LPTIM);
+    LL_LPTIM_StartCounter(LPTICK_LPTIM, LL_LPTIM_OPERATING_MODE_CONTINUOUS);
+
+    g_lpTickLapBase = 0U;
+    g_lpTickLastCnt = 0U;
+    g_lpTickStatus.clock_hz = clockHz;
+    g_lpTickStatus.max_idle_ticks =
+        (uint32_t)(((uint64_t)LPTICK_MAX_SLEEP_COUNTS * configTICK_RATE_HZ) / clockHz);
+
+    /* The tick runs at the priority of SysTick, below every driver */
+    NVIC_SetPriority(LPTICK_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                     configLIBRARY_LOWEST_INTERRUPT_PRIORITY, 0));
+    g_lpTickRunning = true;
+    return true;
+}
+
+/**
+ * @brief Allow or forbid suppressing ticks at idle.
+ */
+void LpTick_SetTickless(bool enable)
+{
+    g_lpTickTickless = enable;
+}
+
+/**
+ * @brief Current counter value extended to 64 bits.
+ */
+uint64_t LpTick_GetCount(void)
+{
+    if (!g_lpTickRunning)
+    {
+        return 0U;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t count = LpTick_Count();
+    __set_PRIMASK(primask);
+    return count;
+}
+
+/**
+ * @brief Tick source of the kernel: LPTIM1 once initialised, SysTick otherwise.
+ *
+ * Replaces the weak SysTick setup of the port. The first tick falls on
+ * the first boundary after the current count.
+ */
+void vPortSetupTimerInterrupt(void)
+{
+    /* The HAL time base may have left SysTick running; it must not tick too */
+    SysTick->CTRL = 0UL;
+
+    if (!g_lpTickRunning)
+    {
+        SysTick->VAL = 0UL;
+        SysTick->LOAD = (configCPU_CLOCK_HZ / configTICK_RATE_HZ) - 1UL;
+        SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+        return;
+    }
+
+    g_lpTickNext = LpTick_LastIndex(LpTick_Count()) + 1U;
+    LpTick_Program(LpTick_Boundary(g_lpTickNext));
+    NVIC_EnableIRQ(LPTICK_IRQ);
+}
+
+/**
+ * @brief Sleep through the next ticks; portSUPPRESS_TICKS_AND_SLEEP of the kernel.
+ *
+ * The tick the kernel expects to wake at is the last of the
+ * @p expectedIdleTime boundaries ahead, the first of which is the pending
+ * regular tick.
+ */
+void LpTick_SuppressTicksAndSleep(TickType_t expectedIdleTime)
+{
+    if (!g_lpTickRunning || !g_lpTickTickless)
+    {
+        return;
+    }
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        g_lpTickStatus.sleep_aborts++;
+        __enable_irq();
+        return;
+    }
+
+    TickType_t sleepTicks = expectedIdleTime;
+    if (sleepTicks > g_lpTickStatus.max_idle_ticks)
+    {
+        sleepTicks = g_lpTickStatus.max_idle_ticks;
+    }
+    LpTick_Program(LpTick_Boundary(g_lpTickNext + sleepTicks - 1U));
+
+    /* A tick that came due meanwhile stays pending and ends the sleep at once */
+    configPRE_SLEEP_PROCESSING(sleepTicks);
+    if (sleepTicks > 0U)
+    {
+        __DSB();
+        __WFI();
+        __ISB();
+    }
+    configPOST_SLEEP_PROCESSING(sleepTicks);
+    g_lpTickStatus.sleeps++;
+
+    uint64_t last = LpTick_LastIndex(LpTick_Count());
+    if (last >= g_lpTickNext)
+    {
+        uint64_t passed = (last - g_lpTickNext) + 1U;
+        if (passed > expectedIdleTime)
+        {
+            passed = expectedIdleTime;
+        }
+        vTaskStepTick((TickType_t)passed);
+        g_lpTickNext += passed;
+        g_lpTickStatus.ticks_stepped += (uint32_t)passed;
+        if (passed > g_lpTickStatus.sleep_max_ticks)
+        {
+            g_lpTickStatus.sleep_max_ticks = (uint32_t)passed;
+        }
+    }
+
+    /* The match that woke the core is accounted for; a later one is found again by the lead */
+    LL_LPTIM_ClearFlag_CC1(LPTICK_LPTIM);
+    NVIC_ClearPendingIRQ(LPTICK_IRQ);
+    LpTick_Program(LpTick_Boundary(g_lpTickNext));
+    __enable_irq();
+}
+
+/**
+ * @brief Copy the tick counters into @p status.
+ */
+void LpTick_GetStatus(LpTick_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_lpTickStatus;
+    status->tickless = g_lpTickTickless;
+    if (!g_lpTickRunning)
+    {
+        status->clock_hz = 0U;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Start the LSE, or the LSI if the crystal does not start, and clock LPTIM1 from it.
+ *
+ * @retval true  An oscillator is ready and selected.
+ * @retval false Neither oscillator became ready.
+ */
+static bool LpTick_StartClock(void)
+{
+    LL_PWR_EnableBkUpAccess();
+    LL_RCC_LSE_Enable();
+    for (uint32_t spin = 0U; spin < LPTICK_OSC_SPIN_LIMIT; spin++)
+    {
+        if (LL_RCC_LSE_IsReady() != 0U)
+        {
+            LL_RCC_SetLPTIMClockSource(LL_RCC_LPTIM1_CLKSOURCE_LSE);
+            g_lpTickStatus.lse = true;
+            return true;
+        }
+    }
+
+    LL_RCC_LSI_Enable();
+    for (uint32_t spin = 0U; spin < LPTICK_OSC_SPIN_LIMIT; spin++)
+    {
+        if (LL_RCC_LSI_IsReady() != 0U)
+        {
+            LL_RCC_SetLPTIMClockSource(LL_RCC_LPTIM1_CLKSOURCE_LSI);
+            g_lpTickStatus.lse = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Poll an LPTIM1 ISR flag until it is set, then clear it.
+ *
+ * @retval true  The flag was set.
+ * @retval false It stayed clear for ::LPTICK_SPIN_LIMIT polls.
+ */
+static bool LpTick_WaitFlag(uint32_t flag)
+{
+    for (uint32_t spin = 0U; spin < LPTICK_SPIN_LIMIT; spin++)
+    {
+        if ((READ_REG(LPTICK_LPTIM->ISR) & flag) != 0U)
+        {
+            WRITE_REG(LPTICK_LPTIM->ICR, flag);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Stable read of the asynchronous counter: two equal consecutive reads.
+ */
+static uint32_t LpTick_ReadCounter(void)
+{
+    uint32_t cnt = LL_LPTIM_GetCounter(LPTICK_LPTIM);
+    uint32_t again = LL_LPTIM_GetCounter(LPTICK_LPTIM);
+
+    while (cnt != again)
+    {
+        cnt = again;
+        again = LL_LPTIM_GetCounter(LPTICK_LPTIM);
+    }
+    return cnt;
+}
+
+/**
+ * @brief Counter extended to 64 bits; called with interrupts masked at least once per lap.
+ */
+static uint64_t LpTick_Count(void)
+{
+    uint32_t cnt = LpTick_ReadCounter();
+
+    if (cnt < g_lpTickLastCnt)
+    {
+        g_lpTickLapBase += LPTICK_LAP;
+    }
+    g_lpTickLastCnt = cnt;
+    return g_lpTickLapBase + cnt;
+}
+
+/**
+ * @brief Extended count tick @p index falls on, rounded down.
+ */
+static uint64_t LpTick_Boundary(uint64_t index)
+{
+    return (index * g_lpTickStatus.clock_hz) / configTICK_RATE_HZ;
+}
+
+/**
+ * @brief Index of the last tick boundary at or before @p count.
+ *
+ * Inverse of ::LpTick_Boundary: the largest k with
+ * floor(k x clock / rate) <= count.
+ */
+static uint64_t LpTick_LastIndex(uint64_t count)
+{
+    return (((count + 1U) * configTICK_RATE_HZ) - 1U) / g_lpTickStatus.clock_hz;
+}
+
+/**
+ * @brief Program the compare for extended count @p target; called with interrupts masked.
+ *
+ * A target too close to be applied in time moves to the minimum lead,
+ * where the interrupt finds every boundary passed meanwhile. When CMP1OK
+ * does not confirm the previous write within ::LPTICK_SPIN_LIMIT polls,
+ * the compare is written anyway and the timeout counted.
+ */
+static void LpTick_Program(uint64_t target)
+{
+    uint64_t earliest = LpTick_Count() + LPTICK_MIN_LEAD;
+
+    if (target < earliest)
+    {
+        target = earliest;
+    }
+    if (g_lpTickCmpPending && !LpTick_WaitFlag(LPTIM_ISR_CMP1OK))
+    {
+        g_lpTickStatus.cmp_timeouts++;
+    }
+    LL_LPTIM_ClearFlag_CMP1OK(LPTICK_LPTIM);
+    LL_LPTIM_OC_SetCompareCH1(LPTICK_LPTIM, (uint32_t)(target % LPTICK_LAP));
+    g_lpTickCmpPending = true;
+}
+
+/**
+ * @brief Compare interrupt: announce every tick boundary passed, then program the next one.
+ */
+static void LpTick_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    BaseType_t switchNeeded = pdFALSE;
+
+    LL_LPTIM_ClearFlag_CC1(LPTICK_LPTIM);
+    uint32_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    g_lpTickStatus.tick_irqs++;
+    uint64_t now = LpTick_Count();
+    while (LpTick_Boundary(g_lpTickNext) <= now)
+    {
+        if (xTaskIncrementTick() != pdFALSE)
+        {
+            switchNeeded = pdTRUE;
+        }
+        g_lpTickNext++;
+        g_lpTickStatus.ticks++;
+    }
+    LpTick_Program(LpTick_Boundary(g_lpTickNext));
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    portYIELD_FROM_ISR(switchNeeded);
+}
+
+/** @} */ // end of LpTick group
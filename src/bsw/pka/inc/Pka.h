@@ -0,0 +1,159 @@
+/**
+ * @file Pka.h
+ * @brief Signature verification primitives on the PKA, with a software reference
+ *
+ * Two operations are offered, each on the PKA and in software with the
+ * same interface and results:
+ *  - ECDSA verification on a short Weierstrass curve given by its
+ *    parameters, ::Pka_CurveP256 being provided,
+ *  - modular exponentiation, the core of RSA verification, for moduli up
+ *    to ::PKA_MAX_MOD_BYTES bytes.
+ *
+ * Operands are big-endian byte strings, as found in certificates and
+ * signatures. The PKA functions block until the operation ends: on the
+ * PKA end of operation interrupt once the scheduler runs, on task
+ * notification index ::PKA_NOTIFY_INDEX, by polling before. The PKA is used by one caller at a time; a call made while it
+ * is busy fails with ::PKA_ERR_BUSY rather than waiting.
+ *
+ * The software reference has no dependency on the hardware and runs on
+ * the host, which is what it is meant for: checking the PKA results and
+ * giving the cost of verification without the PKA. It is written for
+ * clarity and constant memory use, not speed, and takes no measures
+ * against timing attacks, which verification of public data does not
+ * need.
+ */
+
+#ifndef PKA_H
+#define PKA_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#define PKA_MAX_MOD_BYTES (512U) /**< Largest modular exponentiation operand, 4096 bits */
+#define PKA_MAX_ECC_BYTES (66U)  /**< Largest curve modulus and order, 521 bits */
+#define PKA_NOTIFY_INDEX (1U)    /**< Task notification index the caller sleeps on during an operation */
+
+#ifndef PKA_TIMEOUT_MS
+#define PKA_TIMEOUT_MS (1000U) /**< Longest wait for an operation once the scheduler runs */
+#endif
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Result of an operation.
+ */
+typedef enum
+{
+    PKA_OK = 0,        /**< Done, signature valid */
+    PKA_INVALID,       /**< Signature does not verify */
+    PKA_ERR_PARAM,     /**< Operand sizes or values out of range */
+    PKA_ERR_BUSY,      /**< PKA in use by another caller */
+    PKA_ERR_HW,        /**< PKA reported an error or did not finish */
+} Pka_Result_T;
+
+/**
+ * @brief Curve y^2 = x^3 + ax + b over GF(p), with a base point of prime order n.
+ *
+ * Every field is @ref size bytes long, big-endian. b is not needed for
+ * verification.
+ */
+typedef struct
+{
+    uint32_t size;         /**< Bytes of p and n, at most ::PKA_MAX_ECC_BYTES */
+    uint32_t bits;         /**< Bits of p and n */
+    const uint8_t *p;      /**< Field modulus */
+    const uint8_t *a;      /**< |a| */
+    bool a_negative;       /**< a is -|a| */
+    const uint8_t *gx;     /**< Base point x */
+    const uint8_t *gy;     /**< Base point y */
+    const uint8_t *n;      /**< Order of the base point */
+} Pka_Curve_T;
+
+/**
+ * @brief Inputs of an ECDSA verification, each of the curve size.
+ */
+typedef struct
+{
+    const uint8_t *qx;     /**< Public key x */
+    const uint8_t *qy;     /**< Public key y */
+    const uint8_t *r;      /**< Signature r */
+    const uint8_t *s;      /**< Signature s */
+    const uint8_t *hash;   /**< Message digest, left-truncated to the curve size */
+} Pka_Ecdsa_T;
+
+/**
+ * @brief Counters of the service.
+ */
+typedef struct
+{
+    uint32_t ecdsa;        /**< ECDSA verifications run on the PKA */
+    uint32_t modexp;       /**< Modular exponentiations run on the PKA */
+    uint32_t busy;         /**< Calls refused, PKA in use */
+    uint32_t errors;       /**< Operations that ended with a PKA error or timeout */
+    uint32_t last_cycles;  /**< CPU cycles of the last operation, operand loading included */
+} Pka_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+/** NIST P-256 (secp256r1). */
+extern const Pka_Curve_T Pka_CurveP256;
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable the PKA, wait for its RAM initialisation and bind its interrupt.
+ *
+ * @return true on success, false if the PKA did not initialise or the
+ *         interrupt could not be bound.
+ */
+bool Pka_Init(void);
+
+/**
+ * @brief Verify an ECDSA signature on the PKA.
+ *
+ * @param[in] curve Curve parameters.
+ * @param[in] in    Public key, signature and digest.
+ *
+ * @retval PKA_OK      Signature valid.
+ * @retval PKA_INVALID Signature invalid.
+ * @return An error otherwise.
+ */
+Pka_Result_T Pka_EcdsaVerify(const Pka_Curve_T *curve, const Pka_Ecdsa_T *in);
+
+/**
+ * @brief Compute base^exp mod modulus on the PKA.
+ *
+ * @param[in]  base    Base, @p modSize bytes, below the modulus.
+ * @param[in]  exp     Exponent, @p expSize bytes.
+ * @param[in]  expSize Bytes of @p exp, at most @p modSize.
+ * @param[in]  mod     Odd modulus, @p modSize bytes.
+ * @param[in]  modSize Bytes of @p mod, at most ::PKA_MAX_MOD_BYTES.
+ * @param[out] out     Result, @p modSize bytes.
+ *
+ * @return ::PKA_OK or an error.
+ */
+Pka_Result_T Pka_ModExp(const uint8_t *base, const uint8_t *exp, uint32_t expSize, const uint8_t *mod,
+                        uint32_t modSize, uint8_t *out);
+
+/**
+ * @brief Software reference of ::Pka_EcdsaVerify.
+ *
+ * Reentrant, usable without ::Pka_Init and on the host.
+ */
+Pka_Result_T Pka_RefEcdsaVerify(const Pka_Curve_T *curve, const Pka_Ecdsa_T *in);
+
+/**
+ * @brief Software reference of ::Pka_ModExp.
+ *
+ * Reentrant, usable without ::Pka_Init and on the host.
+ */
+Pka_Result_T Pka_RefModExp(const uint8_t *base, const uint8_t *exp, uint32_t expSize, const uint8_t *mod,
+                           uint32_t modSize, uint8_t *out);
+
+/**
+ * @brief Copy the service counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void Pka_GetStatus(Pka_Status_T *status);
+
+#endif /* PKA_H */
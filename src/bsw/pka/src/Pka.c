@@ -0,0 +1,399 @@
+/**
+ * @file Pka.c
+ * @brief Implementation of the PKA service.
+ * @ingroup Pka
+ * @{
+ *
+ * Operands go into the PKA RAM as little-endian 32-bit words, each one
+ * followed by two zero words as the PKA expects, and sizes are given in
+ * bits. Results are read back the same way. The ECDSA verification
+ * result and the modular exponentiation error word hold ::PKA_RAM_OK
+ * when the operation succeeded.
+ *
+ * Once the scheduler runs the caller sleeps on its task notification
+ * until the end of operation interrupt; before that, or from an
+ * interrupt, the end of operation flag is polled against the cycle
+ * counter.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Pka.h"
+#include <stddef.h>
+#include "IsrMgr.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_pka.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define PKA_RAM_OK (0xD60DU) /**< Result word of a successful operation */
+#define PKA_SR_ERRORS (PKA_SR_ADDRERRF | PKA_SR_RAMERRF | PKA_SR_OPERRF)
+#define PKA_CLRFR_ALL (PKA_CLRFR_PROCENDFC | PKA_CLRFR_RAMERRFC | PKA_CLRFR_ADDRERRFC | PKA_CLRFR_OPERRFC)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+static const uint8_t g_pkaP256P[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t g_pkaP256A[32] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03};
+static const uint8_t g_pkaP256Gx[32] = {
+    0x6B, 0x17, 0xD1, 0xF2, 0xE1, 0x2C, 0x42, 0x47, 0xF8, 0xBC, 0xE6, 0xE5, 0x63, 0xA4, 0x40, 0xF2,
+    0x77, 0x03, 0x7D, 0x81, 0x2D, 0xEB, 0x33, 0xA0, 0xF4, 0xA1, 0x39, 0x45, 0xD8, 0x98, 0xC2, 0x96};
+static const uint8_t g_pkaP256Gy[32] = {
+    0x4F, 0xE3, 0x42, 0xE2, 0xFE, 0x1A, 0x7F, 0x9B, 0x8E, 0xE7, 0xEB, 0x4A, 0x7C, 0x0F, 0x9E, 0x16,
+    0x2B, 0xCE, 0x33, 0x57, 0x6B, 0x31, 0x5E, 0xCE, 0xCB, 0xB6, 0x40, 0x68, 0x37, 0xBF, 0x51, 0xF5};
+static const uint8_t g_pkaP256N[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84, 0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51};
+
+/** NIST P-256 (secp256r1), a = -3. */
+const Pka_Curve_T Pka_CurveP256 = {
+    .size = 32U,
+    .bits = 256U,
+    .p = g_pkaP256P,
+    .a = g_pkaP256A,
+    .a_negative = true,
+    .gx = g_pkaP256Gx,
+    .gy = g_pkaP256Gy,
+    .n = g_pkaP256N,
+};
+
+/** The PKA is in use. */
+static bool g_pkaBusy = false;
+/** Task sleeping on the running operation, NULL when polling. */
+static TaskHandle_t g_pkaWaiter = NULL;
+/** The PKA finished its RAM initialisation. */
+static bool g_pkaReady = false;
+/** Counters reported by ::Pka_GetStatus. */
+static Pka_Status_T g_pkaStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** PKA interrupt, bound through the ISR manager. */
+static void Pka_IrqHandler(void *ctx);
+/** Claim the PKA, false if in use. */
+static bool Pka_Claim(void);
+/** Release the PKA. */
+static void Pka_Release(void);
+/** Set EN and wait for INITOK. */
+static bool Pka_Enable(void);
+/** Write an operand into the PKA RAM. */
+static void Pka_WriteOperand(uint32_t index, const uint8_t *src, uint32_t size, uint32_t words);
+/** Read a result from the PKA RAM. */
+static void Pka_ReadOperand(uint32_t index, uint8_t *dst, uint32_t size);
+/** Run the loaded operation and wait for its end. */
+static Pka_Result_T Pka_Run(uint32_t mode);
+/** Check whether the cycle budget of an operation is spent. */
+static bool Pka_Expired(uint32_t start);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable the PKA, wait for its RAM initialisation and bind its interrupt.
+ */
+bool Pka_Init(void)
+{
+    LL_AHB3_GRP1_EnableClock(LL_AHB3_GRP1_PERIPH_PKA);
+
+    if (!IsrMgr_Register(PKA_IRQn, Pka_IrqHandler, NULL) || !Pka_Enable())
+    {
+        return false;
+    }
+
+    NVIC_SetPriority(PKA_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                   configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(PKA_IRQn);
+    g_pkaReady = true;
+    return true;
+}
+
+/**
+ * @brief Verify an ECDSA signature on the PKA.
+ */
+Pka_Result_T Pka_EcdsaVerify(const Pka_Curve_T *curve, const Pka_Ecdsa_T *in)
+{
+    if ((curve == NULL) || (in == NULL) || (curve->size == 0U) || (curve->size > PKA_MAX_ECC_BYTES) ||
+        (curve->bits > (curve->size * 8U)))
+    {
+        return PKA_ERR_PARAM;
+    }
+    if (!g_pkaReady || !Pka_Claim())
+    {
+        return PKA_ERR_BUSY;
+    }
+
+    uint32_t start = DWT->CYCCNT;
+    uint32_t words = (curve->size + 3U) / 4U;
+    WRITE_REG(PKA->RAM[PKA_ECDSA_VERIF_IN_ORDER_NB_BITS], curve->bits);
+    WRITE_REG(PKA->RAM[PKA_ECDSA_VERIF_IN_MOD_NB_BITS], curve->bits);
+    WRITE_REG(PKA->RAM[PKA_ECDSA_VERIF_IN_A_COEFF_SIGN], curve->a_negative ? 1U : 0U);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_A_COEFF, curve->a, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_MOD_GF, curve->p, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_INITIAL_POINT_X, curve->gx, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_INITIAL_POINT_Y, curve->gy, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_PUBLIC_KEY_POINT_X, in->qx, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_PUBLIC_KEY_POINT_Y, in->qy, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_SIGNATURE_R, in->r, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_SIGNATURE_S, in->s, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_HASH_E, in->hash, curve->size, words);
+    Pka_WriteOperand(PKA_ECDSA_VERIF_IN_ORDER_N, curve->n, curve->size, words);
+
+    Pka_Result_T result = Pka_Run(LL_PKA_MODE_ECDSA_VERIFICATION);
+    if (result == PKA_OK)
+    {
+        result = (READ_REG(PKA->RAM[PKA_ECDSA_VERIF_OUT_RESULT]) == PKA_RAM_OK) ? PKA_OK : PKA_INVALID;
+    }
+    g_pkaStatus.ecdsa++;
+    g_pkaStatus.last_cycles = DWT->CYCCNT - start;
+    Pka_Release();
+    return result;
+}
+
+/**
+ * @brief Compute base^exp mod modulus on the PKA.
+ */
+Pka_Result_T Pka_ModExp(const uint8_t *base, const uint8_t *exp, uint32_t expSize, const uint8_t *mod,
+                        uint32_t modSize, uint8_t *out)
+{
+    if ((base == NULL) || (exp == NULL) || (mod == NULL) || (out == NULL) || (modSize == 0U) ||
+        (modSize > PKA_MAX_MOD_BYTES) || (expSize == 0U) || (expSize > modSize) || ((mod[modSize - 1U] & 1U) == 0U))
+    {
+        return PKA_ERR_PARAM;
+    }
+    if (!g_pkaReady || !Pka_Claim())
+    {
+        return PKA_ERR_BUSY;
+    }
+
+    uint32_t start = DWT->CYCCNT;
+    uint32_t words = (modSize + 3U) / 4U;
+    WRITE_REG(PKA->RAM[PKA_MODULAR_EXP_IN_EXP_NB_BITS], expSize * 8U);
+    WRITE_REG(PKA->RAM[PKA_MODULAR_EXP_IN_OP_NB_BITS], modSize * 8U);
+    Pka_WriteOperand(PKA_MODULAR_EXP_IN_EXPONENT_BASE, base, modSize, words);
+    Pka_WriteOperand(PKA_MODULAR_EXP_IN_EXPONENT, exp, expSize, words);
+    Pka_WriteOperand(PKA_MODULAR_EXP_IN_MODULUS, mod, modSize, words);
+
+    Pka_Result_T result = Pka_Run(LL_PKA_MODE_MODULAR_EXP);
+    if ((result == PKA_OK) && (READ_REG(PKA->RAM[PKA_MODULAR_EXP_OUT_ERROR]) != PKA_RAM_OK))
+    {
+        result = PKA_ERR_PARAM;
+    }
+    if (result == PKA_OK)
+    {
+        Pka_ReadOperand(PKA_MODULAR_EXP_OUT_RESULT, out, modSize);
+    }
+    g_pkaStatus.modexp++;
+    g_pkaStatus.last_cycles = DWT->CYCCNT - start;
+    Pka_Release();
+    return result;
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void Pka_GetStatus(Pka_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_pkaStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief PKA interrupt: mask the PKA interrupts and wake the waiting task.
+ *
+ * The flags are left for the task to check and clear.
+ *
+ * @param[in] ctx Unused.
+ */
+static void Pka_IrqHandler(void *ctx)
+{
+    (void)ctx;
+
+    CLEAR_BIT(PKA->CR, PKA_CR_PROCENDIE | PKA_CR_RAMERRIE | PKA_CR_ADDRERRIE | PKA_CR_OPERRIE);
+    if (g_pkaWaiter != NULL)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveIndexedFromISR(g_pkaWaiter, PKA_NOTIFY_INDEX, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+/**
+ * @brief Claim the PKA.
+ *
+ * @return true if the caller now owns the PKA.
+ */
+static bool Pka_Claim(void)
+{
+    bool claimed = false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!g_pkaBusy)
+    {
+        g_pkaBusy = true;
+        claimed = true;
+    }
+    else
+    {
+        g_pkaStatus.busy++;
+    }
+    __set_PRIMASK(primask);
+
+    return claimed;
+}
+
+/**
+ * @brief Release the PKA.
+ */
+static void Pka_Release(void)
+{
+    __DMB();
+    g_pkaBusy = false;
+}
+
+/**
+ * @brief Set EN and wait for the PKA RAM initialisation.
+ *
+ * @return true once INITOK is set, false after ::PKA_TIMEOUT_MS.
+ */
+static bool Pka_Enable(void)
+{
+    LL_PKA_Enable(PKA);
+
+    uint32_t start = DWT->CYCCNT;
+    while (READ_BIT(PKA->SR, PKA_SR_INITOK) == 0U)
+    {
+        if (Pka_Expired(start))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write a big-endian operand into the PKA RAM at word @p index.
+ *
+ * The operand is zero-extended to @p words words and followed by the
+ * two zero words ending it.
+ */
+static void Pka_WriteOperand(uint32_t index, const uint8_t *src, uint32_t size, uint32_t words)
+{
+    for (uint32_t w = 0U; w < words; w++)
+    {
+        uint32_t word = 0U;
+        for (uint32_t b = 0U; b < 4U; b++)
+        {
+            uint32_t pos = (w * 4U) + b;
+            if (pos < size)
+            {
+                word |= (uint32_t)src[size - 1U - pos] << (b * 8U);
+            }
+        }
+        WRITE_REG(PKA->RAM[index + w], word);
+    }
+    WRITE_REG(PKA->RAM[index + words], 0U);
+    WRITE_REG(PKA->RAM[index + words + 1U], 0U);
+}
+
+/**
+ * @brief Read a big-endian result of @p size bytes from the PKA RAM at word @p index.
+ */
+static void Pka_ReadOperand(uint32_t index, uint8_t *dst, uint32_t size)
+{
+    uint32_t word = 0U;
+    for (uint32_t pos = 0U; pos < size; pos++)
+    {
+        if ((pos % 4U) == 0U)
+        {
+            word = READ_REG(PKA->RAM[index + (pos / 4U)]);
+        }
+        dst[size - 1U - pos] = (uint8_t)(word >> ((pos % 4U) * 8U));
+    }
+}
+
+/**
+ * @brief Start @p mode on the loaded operands and wait for its end.
+ *
+ * Only the status flags say the operation ended: a wake-up that finds
+ * neither the end nor an error flag, left by an earlier operation or
+ * given by someone else, sends the task back to sleep for the rest of
+ * the timeout. A PKA without the end flag once ::PKA_TIMEOUT_MS has
+ * passed is taken as still running and is disabled and enabled again,
+ * which aborts the operation.
+ *
+ * @return ::PKA_OK when the operation ended without error flag.
+ */
+static Pka_Result_T Pka_Run(uint32_t mode)
+{
+    bool sleep = (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) && (xPortIsInsideInterrupt() == pdFALSE);
+    bool done;
+
+    WRITE_REG(PKA->CLRFR, PKA_CLRFR_ALL);
+    LL_PKA_SetMode(PKA, mode);
+    if (sleep)
+    {
+        g_pkaWaiter = xTaskGetCurrentTaskHandle();
+        SET_BIT(PKA->CR, PKA_CR_PROCENDIE | PKA_CR_RAMERRIE | PKA_CR_ADDRERRIE | PKA_CR_OPERRIE);
+        LL_PKA_Start(PKA);
+        TickType_t timeout = pdMS_TO_TICKS(PKA_TIMEOUT_MS);
+        TickType_t start = xTaskGetTickCount();
+        TickType_t elapsed = 0U;
+        do
+        {
+            (void)ulTaskNotifyTakeIndexed(PKA_NOTIFY_INDEX, pdTRUE, timeout - elapsed);
+            done = (READ_REG(PKA->SR) & (PKA_SR_PROCENDF | PKA_SR_ERRORS)) != 0U;
+            elapsed = xTaskGetTickCount() - start;
+        } while (!done && (elapsed < timeout));
+    }
+    else
+    {
+        LL_PKA_Start(PKA);
+        uint32_t start = DWT->CYCCNT;
+        do
+        {
+            done = (READ_REG(PKA->SR) & (PKA_SR_PROCENDF | PKA_SR_ERRORS)) != 0U;
+        } while (!done && !Pka_Expired(start));
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CLEAR_BIT(PKA->CR, PKA_CR_PROCENDIE | PKA_CR_RAMERRIE | PKA_CR_ADDRERRIE | PKA_CR_OPERRIE);
+    g_pkaWaiter = NULL;
+    __set_PRIMASK(primask);
+
+    uint32_t sr = READ_REG(PKA->SR);
+    WRITE_REG(PKA->CLRFR, PKA_CLRFR_ALL);
+    if (!done || ((sr & PKA_SR_ERRORS) != 0U) || ((sr & PKA_SR_PROCENDF) == 0U))
+    {
+        g_pkaStatus.errors++;
+        if ((sr & PKA_SR_PROCENDF) == 0U)
+        {
+            LL_PKA_Disable(PKA);
+            g_pkaReady = Pka_Enable();
+        }
+        return PKA_ERR_HW;
+    }
+    return PKA_OK;
+}
+
+/**
+ * @brief Check whether ::PKA_TIMEOUT_MS elapsed since CYCCNT read @p start.
+ */
+static bool Pka_Expired(uint32_t start)
+{
+    return (DWT->CYCCNT - start) > (PKA_TIMEOUT_MS * (SystemCoreClock / 1000U));
+}
+
+/** @} */ // end of Pka group
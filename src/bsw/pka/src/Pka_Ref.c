@@ -0,0 +1,595 @@
+/**
+ * @file Pka_Ref.c
+ * @brief Software reference of the PKA operations.
+ * @ingroup Pka
+ * @{
+ *
+ * Numbers are arrays of 32-bit words, least significant first. Every
+ * modular product is a Montgomery multiplication (CIOS form), with the
+ * operands kept in the Montgomery domain where it saves conversions:
+ *  - modular exponentiation is a left-to-right square and multiply,
+ *  - ECDSA verification computes u1.G + u2.Q in one pass of Jacobian
+ *    doublings and additions over the bits of both scalars (Shamir's
+ *    trick), the inverses of s and of the final Z coming from Fermat's
+ *    little theorem.
+ *
+ * Everything lives on the stack, about 5 KiB at most.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Pka.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Defines -------------------------------------------------------------------*/
+#define PKA_REF_MAX_WORDS (PKA_MAX_MOD_BYTES / 4U)
+#define PKA_REF_ECC_WORDS ((PKA_MAX_ECC_BYTES + 3U) / 4U)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Montgomery arithmetic modulo an odd number.
+ */
+typedef struct
+{
+    uint32_t words;                   /**< Size of the numbers */
+    uint32_t n0;                      /**< -m^-1 mod 2^32 */
+    uint32_t m[PKA_REF_MAX_WORDS];    /**< Modulus */
+    uint32_t r2[PKA_REF_MAX_WORDS];   /**< R^2 mod m, R = 2^(32 x words) */
+} Pka_RefMont_T;
+
+/**
+ * @brief Point in Jacobian coordinates (X/Z^2, Y/Z^3), Montgomery domain, Z = 0 at infinity.
+ */
+typedef struct
+{
+    uint32_t x[PKA_REF_ECC_WORDS];
+    uint32_t y[PKA_REF_ECC_WORDS];
+    uint32_t z[PKA_REF_ECC_WORDS];
+} Pka_RefPoint_T;
+
+/**
+ * @brief Curve in working form.
+ */
+typedef struct
+{
+    Pka_RefMont_T fp;                 /**< Arithmetic modulo p */
+    uint32_t a[PKA_REF_ECC_WORDS];    /**< a, Montgomery domain */
+} Pka_RefCurve_T;
+
+/* Global Variables ----------------------------------------------------------*/
+
+/* Private Function Prototypes -----------------------------------------------*/
+static void Pka_RefLoad(uint32_t *dst, uint32_t words, const uint8_t *src, uint32_t size);
+static void Pka_RefStore(uint8_t *dst, uint32_t size, const uint32_t *src);
+static int32_t Pka_RefCmp(const uint32_t *a, const uint32_t *b, uint32_t words);
+static uint32_t Pka_RefAdd(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t words);
+static uint32_t Pka_RefSub(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t words);
+static bool Pka_RefIsZero(const uint32_t *a, uint32_t words);
+static bool Pka_RefBit(const uint32_t *a, uint32_t bit);
+static void Pka_RefMontSetup(Pka_RefMont_T *ctx, const uint32_t *m, uint32_t words);
+static void Pka_RefMontMul(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b);
+static void Pka_RefMontPow(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *exp,
+                           uint32_t expBits);
+static void Pka_RefModAdd(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b);
+static void Pka_RefModSub(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b);
+static void Pka_RefDouble(const Pka_RefCurve_T *c, Pka_RefPoint_T *r, const Pka_RefPoint_T *p);
+static void Pka_RefAddPoints(const Pka_RefCurve_T *c, Pka_RefPoint_T *r, const Pka_RefPoint_T *p,
+                             const Pka_RefPoint_T *q);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Software reference of ::Pka_EcdsaVerify.
+ */
+Pka_Result_T Pka_RefEcdsaVerify(const Pka_Curve_T *curve, const Pka_Ecdsa_T *in)
+{
+    if ((curve == NULL) || (in == NULL) || (curve->size == 0U) || (curve->size > PKA_MAX_ECC_BYTES) ||
+        (curve->bits > (curve->size * 8U)) || ((curve->n[curve->size - 1U] & 1U) == 0U) ||
+        ((curve->p[curve->size - 1U] & 1U) == 0U))
+    {
+        return PKA_ERR_PARAM;
+    }
+
+    uint32_t words = (curve->size + 3U) / 4U;
+    uint32_t n[PKA_REF_ECC_WORDS];
+    uint32_t r[PKA_REF_ECC_WORDS];
+    uint32_t s[PKA_REF_ECC_WORDS];
+    uint32_t e[PKA_REF_ECC_WORDS];
+    uint32_t t[PKA_REF_ECC_WORDS];
+    Pka_RefLoad(n, words, curve->n, curve->size);
+    Pka_RefLoad(r, words, in->r, curve->size);
+    Pka_RefLoad(s, words, in->s, curve->size);
+    Pka_RefLoad(e, words, in->hash, curve->size);
+
+    if (Pka_RefIsZero(r, words) || Pka_RefIsZero(s, words) || (Pka_RefCmp(r, n, words) >= 0) ||
+        (Pka_RefCmp(s, n, words) >= 0))
+    {
+        return PKA_INVALID;
+    }
+    while (Pka_RefCmp(e, n, words) >= 0)
+    {
+        (void)Pka_RefSub(e, e, n, words);
+    }
+
+    /* w = s^(n-2) in the domain modulo n, then u1 = e.w and u2 = r.w out of it */
+    Pka_RefMont_T nCtx;
+    Pka_RefMont_T *mn = &nCtx;
+    Pka_RefMontSetup(mn, n, words);
+    uint32_t u1[PKA_REF_ECC_WORDS];
+    uint32_t u2[PKA_REF_ECC_WORDS];
+    memset(t, 0, sizeof(t));
+    t[0] = 2U;
+    (void)Pka_RefSub(t, n, t, words);
+    Pka_RefMontMul(mn, s, s, mn->r2);
+    Pka_RefMontPow(mn, s, s, t, curve->bits);
+    Pka_RefMontMul(mn, u1, e, s);
+    Pka_RefMontMul(mn, u2, r, s);
+
+    /* Points into the domain modulo p */
+    Pka_RefCurve_T c;
+    Pka_RefPoint_T g;
+    Pka_RefPoint_T q;
+    Pka_RefPoint_T gq;
+    Pka_RefPoint_T acc;
+    uint32_t p[PKA_REF_ECC_WORDS];
+    Pka_RefLoad(p, words, curve->p, curve->size);
+    Pka_RefMontSetup(&c.fp, p, words);
+
+    Pka_RefLoad(q.x, words, in->qx, curve->size);
+    Pka_RefLoad(q.y, words, in->qy, curve->size);
+    if ((Pka_RefCmp(q.x, p, words) >= 0) || (Pka_RefCmp(q.y, p, words) >= 0))
+    {
+        return PKA_ERR_PARAM;
+    }
+    Pka_RefLoad(g.x, words, curve->gx, curve->size);
+    Pka_RefLoad(g.y, words, curve->gy, curve->size);
+    Pka_RefLoad(c.a, words, curve->a, curve->size);
+    if (curve->a_negative && !Pka_RefIsZero(c.a, words))
+    {
+        (void)Pka_RefSub(c.a, p, c.a, words);
+    }
+
+    memset(t, 0, sizeof(t));
+    t[0] = 1U;
+    Pka_RefMontMul(&c.fp, g.z, t, c.fp.r2);
+    memcpy(q.z, g.z, sizeof(q.z));
+    Pka_RefMontMul(&c.fp, g.x, g.x, c.fp.r2);
+    Pka_RefMontMul(&c.fp, g.y, g.y, c.fp.r2);
+    Pka_RefMontMul(&c.fp, q.x, q.x, c.fp.r2);
+    Pka_RefMontMul(&c.fp, q.y, q.y, c.fp.r2);
+    Pka_RefMontMul(&c.fp, c.a, c.a, c.fp.r2);
+
+    Pka_RefAddPoints(&c, &gq, &g, &q);
+    memset(&acc, 0, sizeof(acc));
+    for (uint32_t bit = curve->bits; bit-- > 0U;)
+    {
+        Pka_RefDouble(&c, &acc, &acc);
+        bool b1 = Pka_RefBit(u1, bit);
+        bool b2 = Pka_RefBit(u2, bit);
+        if (b1 && b2)
+        {
+            Pka_RefAddPoints(&c, &acc, &acc, &gq);
+        }
+        else if (b1)
+        {
+            Pka_RefAddPoints(&c, &acc, &acc, &g);
+        }
+        else if (b2)
+        {
+            Pka_RefAddPoints(&c, &acc, &acc, &q);
+        }
+    }
+    if (Pka_RefIsZero(acc.z, words))
+    {
+        return PKA_INVALID;
+    }
+
+    /* x = X / Z^2, out of the Montgomery domain, reduced modulo n */
+    memset(t, 0, sizeof(t));
+    t[0] = 2U;
+    (void)Pka_RefSub(t, p, t, words);
+    Pka_RefMontPow(&c.fp, acc.z, acc.z, t, curve->bits);
+    Pka_RefMontMul(&c.fp, acc.z, acc.z, acc.z);
+    Pka_RefMontMul(&c.fp, acc.x, acc.x, acc.z);
+    memset(t, 0, sizeof(t));
+    t[0] = 1U;
+    Pka_RefMontMul(&c.fp, acc.x, acc.x, t);
+    while (Pka_RefCmp(acc.x, n, words) >= 0)
+    {
+        (void)Pka_RefSub(acc.x, acc.x, n, words);
+    }
+
+    return (Pka_RefCmp(acc.x, r, words) == 0) ? PKA_OK : PKA_INVALID;
+}
+
+/**
+ * @brief Software reference of ::Pka_ModExp.
+ */
+Pka_Result_T Pka_RefModExp(const uint8_t *base, const uint8_t *exp, uint32_t expSize, const uint8_t *mod,
+                           uint32_t modSize, uint8_t *out)
+{
+    if ((base == NULL) || (exp == NULL) || (mod == NULL) || (out == NULL) || (modSize == 0U) ||
+        (modSize > PKA_MAX_MOD_BYTES) || (expSize == 0U) || (expSize > modSize) || ((mod[modSize - 1U] & 1U) == 0U))
+    {
+        return PKA_ERR_PARAM;
+    }
+
+    uint32_t words = (modSize + 3U) / 4U;
+    Pka_RefMont_T ctx;
+    uint32_t a[PKA_REF_MAX_WORDS];
+    uint32_t e[PKA_REF_MAX_WORDS];
+
+    Pka_RefLoad(a, words, mod, modSize);
+    Pka_RefMontSetup(&ctx, a, words);
+    Pka_RefLoad(a, words, base, modSize);
+    if (Pka_RefCmp(a, ctx.m, words) >= 0)
+    {
+        return PKA_ERR_PARAM;
+    }
+    Pka_RefLoad(e, words, exp, expSize);
+
+    Pka_RefMontMul(&ctx, a, a, ctx.r2);
+    Pka_RefMontPow(&ctx, a, a, e, expSize * 8U);
+    memset(e, 0, words * 4U);
+    e[0] = 1U;
+    Pka_RefMontMul(&ctx, a, a, e);
+    Pka_RefStore(out, modSize, a);
+    return PKA_OK;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Load a big-endian byte string into @p words words, zero-extended.
+ */
+static void Pka_RefLoad(uint32_t *dst, uint32_t words, const uint8_t *src, uint32_t size)
+{
+    memset(dst, 0, words * 4U);
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        uint32_t pos = size - 1U - i;
+        dst[pos / 4U] |= (uint32_t)src[i] << ((pos % 4U) * 8U);
+    }
+}
+
+/**
+ * @brief Store the low @p size bytes of a number as a big-endian byte string.
+ */
+static void Pka_RefStore(uint8_t *dst, uint32_t size, const uint32_t *src)
+{
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        uint32_t pos = size - 1U - i;
+        dst[i] = (uint8_t)(src[pos / 4U] >> ((pos % 4U) * 8U));
+    }
+}
+
+/**
+ * @brief Compare two numbers.
+ *
+ * @return -1, 0 or 1 as @p a is below, equal to or above @p b.
+ */
+static int32_t Pka_RefCmp(const uint32_t *a, const uint32_t *b, uint32_t words)
+{
+    for (uint32_t i = words; i-- > 0U;)
+    {
+        if (a[i] != b[i])
+        {
+            return (a[i] > b[i]) ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief r = a + b, @p r may alias either operand.
+ *
+ * @return Carry out.
+ */
+static uint32_t Pka_RefAdd(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t words)
+{
+    uint64_t carry = 0U;
+    for (uint32_t i = 0U; i < words; i++)
+    {
+        carry += (uint64_t)a[i] + b[i];
+        r[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    return (uint32_t)carry;
+}
+
+/**
+ * @brief r = a - b, @p r may alias either operand.
+ *
+ * @return Borrow out.
+ */
+static uint32_t Pka_RefSub(uint32_t *r, const uint32_t *a, const uint32_t *b, uint32_t words)
+{
+    uint32_t borrow = 0U;
+    for (uint32_t i = 0U; i < words; i++)
+    {
+        uint64_t diff = (uint64_t)a[i] - b[i] - borrow;
+        r[i] = (uint32_t)diff;
+        borrow = (uint32_t)(diff >> 63);
+    }
+    return borrow;
+}
+
+static bool Pka_RefIsZero(const uint32_t *a, uint32_t words)
+{
+    uint32_t acc = 0U;
+    for (uint32_t i = 0U; i < words; i++)
+    {
+        acc |= a[i];
+    }
+    return acc == 0U;
+}
+
+static bool Pka_RefBit(const uint32_t *a, uint32_t bit)
+{
+    return ((a[bit / 32U] >> (bit % 32U)) & 1U) != 0U;
+}
+
+/**
+ * @brief Prepare Montgomery arithmetic modulo the odd number @p m.
+ *
+ * R^2 mod m comes from doubling 1 modulo m 2 x 32 x words times.
+ */
+static void Pka_RefMontSetup(Pka_RefMont_T *ctx, const uint32_t *m, uint32_t words)
+{
+    ctx->words = words;
+    memcpy(ctx->m, m, words * 4U);
+
+    /* Newton iteration, each step doubles the correct low bits of m^-1 */
+    uint32_t inv = 1U;
+    for (uint32_t i = 0U; i < 5U; i++)
+    {
+        inv *= 2U - (m[0] * inv);
+    }
+    ctx->n0 = 0U - inv;
+
+    memset(ctx->r2, 0, words * 4U);
+    ctx->r2[0] = 1U;
+    for (uint32_t i = 0U; i < (words * 64U); i++)
+    {
+        uint32_t carry = Pka_RefAdd(ctx->r2, ctx->r2, ctx->r2, words);
+        if ((carry != 0U) || (Pka_RefCmp(ctx->r2, m, words) >= 0))
+        {
+            (void)Pka_RefSub(ctx->r2, ctx->r2, m, words);
+        }
+    }
+}
+
+/**
+ * @brief r = a.b.R^-1 mod m, operands below m, @p r may alias either operand.
+ */
+static void Pka_RefMontMul(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    uint32_t words = ctx->words;
+    uint32_t t[PKA_REF_MAX_WORDS + 2U];
+
+    memset(t, 0, (words + 2U) * 4U);
+    for (uint32_t i = 0U; i < words; i++)
+    {
+        uint64_t carry = 0U;
+        for (uint32_t j = 0U; j < words; j++)
+        {
+            carry += (uint64_t)t[j] + ((uint64_t)a[j] * b[i]);
+            t[j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[words];
+        t[words] = (uint32_t)carry;
+        t[words + 1U] = (uint32_t)(carry >> 32);
+
+        uint32_t q = t[0] * ctx->n0;
+        carry = (uint64_t)t[0] + ((uint64_t)q * ctx->m[0]);
+        carry >>= 32;
+        for (uint32_t j = 1U; j < words; j++)
+        {
+            carry += (uint64_t)t[j] + ((uint64_t)q * ctx->m[j]);
+            t[j - 1U] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        carry += t[words];
+        t[words - 1U] = (uint32_t)carry;
+        t[words] = t[words + 1U] + (uint32_t)(carry >> 32);
+    }
+
+    if ((t[words] != 0U) || (Pka_RefCmp(t, ctx->m, words) >= 0))
+    {
+        (void)Pka_RefSub(t, t, ctx->m, words);
+    }
+    memcpy(r, t, words * 4U);
+}
+
+/**
+ * @brief r = a^exp in the Montgomery domain, over the low @p expBits bits of @p exp.
+ */
+static void Pka_RefMontPow(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *exp,
+                           uint32_t expBits)
+{
+    uint32_t words = ctx->words;
+    uint32_t base[PKA_REF_MAX_WORDS];
+    uint32_t acc[PKA_REF_MAX_WORDS];
+
+    memcpy(base, a, words * 4U);
+    memset(acc, 0, words * 4U);
+    acc[0] = 1U;
+    Pka_RefMontMul(ctx, acc, acc, ctx->r2);
+
+    for (uint32_t bit = expBits; bit-- > 0U;)
+    {
+        Pka_RefMontMul(ctx, acc, acc, acc);
+        if (Pka_RefBit(exp, bit))
+        {
+            Pka_RefMontMul(ctx, acc, acc, base);
+        }
+    }
+    memcpy(r, acc, words * 4U);
+}
+
+/**
+ * @brief r = a + b mod m, operands below m.
+ */
+static void Pka_RefModAdd(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    uint32_t carry = Pka_RefAdd(r, a, b, ctx->words);
+    if ((carry != 0U) || (Pka_RefCmp(r, ctx->m, ctx->words) >= 0))
+    {
+        (void)Pka_RefSub(r, r, ctx->m, ctx->words);
+    }
+}
+
+/**
+ * @brief r = a - b mod m, operands below m.
+ */
+static void Pka_RefModSub(const Pka_RefMont_T *ctx, uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+    if (Pka_RefSub(r, a, b, ctx->words) != 0U)
+    {
+        (void)Pka_RefAdd(r, r, ctx->m, ctx->words);
+    }
+}
+
+/**
+ * @brief r = 2p, any a (dbl-2007-bl), @p r may alias @p p.
+ */
+static void Pka_RefDouble(const Pka_RefCurve_T *c, Pka_RefPoint_T *r, const Pka_RefPoint_T *p)
+{
+    const Pka_RefMont_T *f = &c->fp;
+    uint32_t xx[PKA_REF_ECC_WORDS];
+    uint32_t yy[PKA_REF_ECC_WORDS];
+    uint32_t yyyy[PKA_REF_ECC_WORDS];
+    uint32_t zz[PKA_REF_ECC_WORDS];
+    uint32_t s[PKA_REF_ECC_WORDS];
+    uint32_t m[PKA_REF_ECC_WORDS];
+    uint32_t t[PKA_REF_ECC_WORDS];
+
+    if (Pka_RefIsZero(p->z, f->words))
+    {
+        *r = *p;
+        return;
+    }
+
+    Pka_RefMontMul(f, xx, p->x, p->x);
+    Pka_RefMontMul(f, yy, p->y, p->y);
+    Pka_RefMontMul(f, yyyy, yy, yy);
+    Pka_RefMontMul(f, zz, p->z, p->z);
+
+    /* S = 2((X + YY)^2 - XX - YYYY) */
+    Pka_RefModAdd(f, s, p->x, yy);
+    Pka_RefMontMul(f, s, s, s);
+    Pka_RefModSub(f, s, s, xx);
+    Pka_RefModSub(f, s, s, yyyy);
+    Pka_RefModAdd(f, s, s, s);
+
+    /* M = 3XX + a.ZZ^2 */
+    Pka_RefMontMul(f, t, zz, zz);
+    Pka_RefMontMul(f, t, t, c->a);
+    Pka_RefModAdd(f, m, xx, xx);
+    Pka_RefModAdd(f, m, m, xx);
+    Pka_RefModAdd(f, m, m, t);
+
+    /* Z3 = (Y + Z)^2 - YY - ZZ, before Y is overwritten */
+    Pka_RefModAdd(f, r->z, p->y, p->z);
+    Pka_RefMontMul(f, r->z, r->z, r->z);
+    Pka_RefModSub(f, r->z, r->z, yy);
+    Pka_RefModSub(f, r->z, r->z, zz);
+
+    /* X3 = M^2 - 2S */
+    Pka_RefMontMul(f, t, m, m);
+    Pka_RefModSub(f, t, t, s);
+    Pka_RefModSub(f, r->x, t, s);
+
+    /* Y3 = M(S - X3) - 8YYYY */
+    Pka_RefModSub(f, s, s, r->x);
+    Pka_RefMontMul(f, s, m, s);
+    Pka_RefModAdd(f, yyyy, yyyy, yyyy);
+    Pka_RefModAdd(f, yyyy, yyyy, yyyy);
+    Pka_RefModAdd(f, yyyy, yyyy, yyyy);
+    Pka_RefModSub(f, r->y, s, yyyy);
+}
+
+/**
+ * @brief r = p + q (add-2007-bl), @p r may alias either operand.
+ *
+ * Equal operands are doubled and opposite ones give the point at infinity.
+ */
+static void Pka_RefAddPoints(const Pka_RefCurve_T *c, Pka_RefPoint_T *r, const Pka_RefPoint_T *p,
+                             const Pka_RefPoint_T *q)
+{
+    const Pka_RefMont_T *f = &c->fp;
+    uint32_t z1z1[PKA_REF_ECC_WORDS];
+    uint32_t z2z2[PKA_REF_ECC_WORDS];
+    uint32_t u1[PKA_REF_ECC_WORDS];
+    uint32_t u2[PKA_REF_ECC_WORDS];
+    uint32_t s1[PKA_REF_ECC_WORDS];
+    uint32_t s2[PKA_REF_ECC_WORDS];
+    uint32_t h[PKA_REF_ECC_WORDS];
+    uint32_t i[PKA_REF_ECC_WORDS];
+    uint32_t j[PKA_REF_ECC_WORDS];
+    uint32_t v[PKA_REF_ECC_WORDS];
+
+    if (Pka_RefIsZero(p->z, f->words))
+    {
+        *r = *q;
+        return;
+    }
+    if (Pka_RefIsZero(q->z, f->words))
+    {
+        *r = *p;
+        return;
+    }
+
+    Pka_RefMontMul(f, z1z1, p->z, p->z);
+    Pka_RefMontMul(f, z2z2, q->z, q->z);
+    Pka_RefMontMul(f, u1, p->x, z2z2);
+    Pka_RefMontMul(f, u2, q->x, z1z1);
+    Pka_RefMontMul(f, s1, p->y, q->z);
+    Pka_RefMontMul(f, s1, s1, z2z2);
+    Pka_RefMontMul(f, s2, q->y, p->z);
+    Pka_RefMontMul(f, s2, s2, z1z1);
+
+    Pka_RefModSub(f, h, u2, u1);
+    Pka_RefModSub(f, s2, s2, s1);
+    if (Pka_RefIsZero(h, f->words))
+    {
+        if (Pka_RefIsZero(s2, f->words))
+        {
+            Pka_RefDouble(c, r, p);
+        }
+        else
+        {
+            memset(r, 0, sizeof(*r));
+        }
+        return;
+    }
+
+    /* I = (2H)^2, J = H.I, rr = 2(S2 - S1), V = U1.I */
+    Pka_RefModAdd(f, i, h, h);
+    Pka_RefMontMul(f, i, i, i);
+    Pka_RefMontMul(f, j, h, i);
+    Pka_RefModAdd(f, s2, s2, s2);
+    Pka_RefMontMul(f, v, u1, i);
+
+    /* Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2).H, before the operands are overwritten */
+    Pka_RefModAdd(f, u2, p->z, q->z);
+    Pka_RefMontMul(f, u2, u2, u2);
+    Pka_RefModSub(f, u2, u2, z1z1);
+    Pka_RefModSub(f, u2, u2, z2z2);
+    Pka_RefMontMul(f, r->z, u2, h);
+
+    /* X3 = rr^2 - J - 2V */
+    Pka_RefMontMul(f, u1, s2, s2);
+    Pka_RefModSub(f, u1, u1, j);
+    Pka_RefModSub(f, u1, u1, v);
+    Pka_RefModSub(f, r->x, u1, v);
+
+    /* Y3 = rr(V - X3) - 2.S1.J */
+    Pka_RefModSub(f, v, v, r->x);
+    Pka_RefMontMul(f, v, s2, v);
+    Pka_RefMontMul(f, s1, s1, j);
+    Pka_RefModAdd(f, s1, s1, s1);
+    Pka_RefModSub(f, r->y, v, s1);
+}
+
+/** @} */ // end of Pka group
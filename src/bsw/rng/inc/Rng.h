@@ -0,0 +1,100 @@
+/**
+ * @file Rng.h
+ * @brief Random numbers from a pool kept filled by the RNG interrupt
+ *
+ * The RNG output is collected by its interrupt into a word pool, so
+ * ::Rng_Get never waits for the RNG: it copies from the pool and returns,
+ * or fails at once when the pool holds too little. The pool is lock-free,
+ * with the interrupt as its single producer and any number of consumers
+ * in tasks and interrupts, which claim words with a compare-and-swap.
+ *
+ * The interrupt stops once the pool is full and is re-armed when
+ * consumers take it below ::RNG_POOL_REFILL_LEVEL. It also recovers from
+ * the RNG errors:
+ *  - seed error: the conditioning is restarted with the CONDRST sequence,
+ *    the RNG output FIFO being discarded by it,
+ *  - clock error: the flag is cleared, the RNG resumes by itself once its
+ *    clock is back in range.
+ *
+ * Words that read as 0, which the RNG returns when it has no valid data,
+ * and words equal to their predecessor, the continuous test of FIPS 140-2,
+ * are discarded and counted.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef RNG_POOL_WORDS
+#define RNG_POOL_WORDS (64U) /**< Pool size in 32-bit words, power of two */
+#endif
+
+#ifndef RNG_POOL_REFILL_LEVEL
+#define RNG_POOL_REFILL_LEVEL (RNG_POOL_WORDS / 2U) /**< Words left when the interrupt is re-armed */
+#endif
+
+#ifndef RNG_RESET_SPIN
+#define RNG_RESET_SPIN (1000U) /**< Status polls allowed for a CONDRST sequence to finish */
+#endif
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Counters of the service.
+ */
+typedef struct
+{
+    uint32_t words_in;        /**< Words added to the pool, wrapping */
+    uint32_t words_out;       /**< Words taken by consumers, wrapping */
+    uint32_t requests;        /**< ::Rng_Get calls served */
+    uint32_t underruns;       /**< ::Rng_Get calls refused, pool too low */
+    uint32_t retries;         /**< Claims lost to a concurrent consumer */
+    uint32_t refills;         /**< Times the interrupt was re-armed */
+    uint32_t seed_errors;     /**< Seed errors seen */
+    uint32_t clock_errors;    /**< Clock errors seen */
+    uint32_t reset_timeouts;  /**< CONDRST sequences that did not finish, retried later */
+    uint32_t discarded;       /**< Zero or repeated words dropped */
+    uint32_t level;           /**< Words in the pool */
+} Rng_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable the RNG, bind its interrupt and start filling the pool.
+ *
+ * @return true on success, false if the interrupt could not be bound.
+ */
+bool Rng_Init(void);
+
+/**
+ * @brief Copy @p size random bytes into @p buf.
+ *
+ * Never blocks, callable from task and interrupt context. Whole words are
+ * taken from the pool, so bytes left over in the last word are dropped.
+ *
+ * @param[out] buf  Destination.
+ * @param[in]  size Number of bytes, at most 4 x ::RNG_POOL_WORDS.
+ *
+ * @retval true  @p buf filled.
+ * @retval false Not enough bytes in the pool, @p buf unchanged, the
+ *               caller may retry later.
+ */
+bool Rng_Get(void *buf, uint32_t size);
+
+/**
+ * @brief Bytes ::Rng_Get could return right now.
+ */
+uint32_t Rng_Available(void);
+
+/**
+ * @brief Copy the service counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void Rng_GetStatus(Rng_Status_T *status);
+
+#endif /* RNG_H */
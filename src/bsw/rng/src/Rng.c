@@ -0,0 +1,296 @@
+/**
+ * @file Rng.c
+ * @brief Implementation of the RNG entropy pool.
+ * @ingroup Rng
+ * @{
+ *
+ * The pool is a ring of words indexed by two free-running counters. The
+ * head is only written by the interrupt. Consumers copy from the tail
+ * first and then claim the words by moving the tail with a
+ * compare-and-swap: the producer never writes the words between the tail
+ * and the head, so a copy is valid if the tail has not moved meanwhile,
+ * and a consumer that lost the race simply copies again.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Rng.h"
+#include <stddef.h>
+#include <string.h>
+#include "IsrMgr.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_rng.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define RNG_POOL_MASK (RNG_POOL_WORDS - 1U)
+
+#if (RNG_POOL_WORDS & RNG_POOL_MASK) != 0U
+#error "RNG_POOL_WORDS must be a power of two"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ----------------------------------------------------------*/
+/** Random words, valid from the tail to the head. */
+static uint32_t g_rngPool[RNG_POOL_WORDS];
+/** Words ever added, written by the interrupt only. */
+static uint32_t g_rngHead = 0U;
+/** Words ever taken, advanced by consumers with a compare-and-swap. */
+static uint32_t g_rngTail = 0U;
+/** Last word read from the RNG, for the continuous test. */
+static uint32_t g_rngLast = 0U;
+/** The data ready interrupt is enabled. */
+static volatile bool g_rngArmed = false;
+/** A seed error recovery did not finish and must be retried. */
+static bool g_rngRecoverPending = false;
+/** Counters reported by ::Rng_GetStatus. */
+static Rng_Status_T g_rngStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** RNG interrupt, bound through the ISR manager. */
+static void Rng_IrqHandler(void *ctx);
+/** Enable the data ready interrupt unless it already is. */
+static void Rng_Arm(void);
+/** Restart the conditioning after a seed error. */
+static bool Rng_Recover(void);
+/** Run the CONDRST sequence and wait for the RNG to leave it. */
+static bool Rng_CondReset(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable the RNG, bind its interrupt and start filling the pool.
+ *
+ * Configuration bits are written with CONDRST set, as the RNG requires.
+ * Clock error detection is on and the automatic reset on seed errors off,
+ * so the driver sees and counts each one.
+ */
+bool Rng_Init(void)
+{
+    LL_AHB3_GRP1_EnableClock(LL_AHB3_GRP1_PERIPH_RNG);
+
+    if (!IsrMgr_Register(RNG_IRQn, Rng_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    MODIFY_REG(RNG->CR, RNG_CR_CED | RNG_CR_ARDIS | RNG_CR_CLKDIV | RNG_CR_NISTC | RNG_CR_CONDRST,
+               LL_RNG_CED_ENABLE | LL_RNG_ARDIS_DISABLE | LL_RNG_CLKDIV_BY_1 | LL_RNG_NIST_COMPLIANT |
+                   RNG_CR_CONDRST);
+    if (!Rng_CondReset())
+    {
+        return false;
+    }
+    LL_RNG_Enable(RNG);
+
+    NVIC_SetPriority(RNG_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                   configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(RNG_IRQn);
+    Rng_Arm();
+    return true;
+}
+
+/**
+ * @brief Copy @p size random bytes into @p buf.
+ */
+bool Rng_Get(void *buf, uint32_t size)
+{
+    uint32_t words = (size + 3U) / 4U;
+
+    if ((buf == NULL) || (words > RNG_POOL_WORDS))
+    {
+        return false;
+    }
+    if (size == 0U)
+    {
+        return true;
+    }
+
+    uint8_t *out = (uint8_t *)buf;
+    uint32_t head;
+    uint32_t tail = __atomic_load_n(&g_rngTail, __ATOMIC_ACQUIRE);
+    for (;;)
+    {
+        head = __atomic_load_n(&g_rngHead, __ATOMIC_ACQUIRE);
+        if ((head - tail) < words)
+        {
+            __atomic_fetch_add(&g_rngStatus.underruns, 1U, __ATOMIC_RELAXED);
+            Rng_Arm();
+            return false;
+        }
+
+        uint32_t index = tail & RNG_POOL_MASK;
+        uint32_t first = (RNG_POOL_WORDS - index) * 4U;
+        first = (first < size) ? first : size;
+        memcpy(out, &g_rngPool[index], first);
+        memcpy(&out[first], &g_rngPool[0], size - first);
+
+        if (__atomic_compare_exchange_n(&g_rngTail, &tail, tail + words, false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+        __atomic_fetch_add(&g_rngStatus.retries, 1U, __ATOMIC_RELAXED);
+    }
+
+    __atomic_fetch_add(&g_rngStatus.requests, 1U, __ATOMIC_RELAXED);
+    if ((head - (tail + words)) <= RNG_POOL_REFILL_LEVEL)
+    {
+        Rng_Arm();
+    }
+    return true;
+}
+
+/**
+ * @brief Bytes ::Rng_Get could return right now.
+ */
+uint32_t Rng_Available(void)
+{
+    uint32_t tail = __atomic_load_n(&g_rngTail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&g_rngHead, __ATOMIC_ACQUIRE);
+    return (head - tail) * 4U;
+}
+
+/**
+ * @brief Copy the service counters into @p status.
+ */
+void Rng_GetStatus(Rng_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_rngStatus;
+    status->words_in = g_rngHead;
+    status->words_out = g_rngTail;
+    status->level = g_rngHead - g_rngTail;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief RNG interrupt.
+ *
+ * Handles the error flags, then moves words from the RNG FIFO into the
+ * pool while both allow. A full pool disarms the interrupt.
+ *
+ * @param[in] ctx Unused.
+ */
+static void Rng_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t sr = READ_REG(RNG->SR);
+
+    if ((sr & RNG_SR_CEIS) != 0U)
+    {
+        LL_RNG_ClearFlag_CEIS(RNG);
+        g_rngStatus.clock_errors++;
+    }
+    if ((sr & RNG_SR_SEIS) != 0U)
+    {
+        g_rngStatus.seed_errors++;
+        if (!Rng_Recover())
+        {
+            return;
+        }
+    }
+
+    uint32_t head = g_rngHead;
+    uint32_t tail = __atomic_load_n(&g_rngTail, __ATOMIC_ACQUIRE);
+    while (((head - tail) < RNG_POOL_WORDS) && (LL_RNG_IsActiveFlag_DRDY(RNG) != 0U) &&
+           (LL_RNG_IsActiveFlag_SECS(RNG) == 0U))
+    {
+        uint32_t word = LL_RNG_ReadRandData32(RNG);
+        if ((word == 0U) || (word == g_rngLast))
+        {
+            g_rngStatus.discarded++;
+        }
+        else
+        {
+            g_rngPool[head & RNG_POOL_MASK] = word;
+            head++;
+        }
+        g_rngLast = (word != 0U) ? word : g_rngLast;
+    }
+    __atomic_store_n(&g_rngHead, head, __ATOMIC_RELEASE);
+
+    if ((head - tail) >= RNG_POOL_WORDS)
+    {
+        LL_RNG_DisableIT(RNG);
+        g_rngArmed = false;
+    }
+}
+
+/**
+ * @brief Enable the data ready interrupt unless it already is.
+ *
+ * A recovery left pending by the interrupt is retried first.
+ */
+static void Rng_Arm(void)
+{
+    if (g_rngArmed)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!g_rngArmed && (!g_rngRecoverPending || Rng_Recover()))
+    {
+        g_rngArmed = true;
+        g_rngStatus.refills++;
+        LL_RNG_EnableIT(RNG);
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Restart the conditioning after a seed error.
+ *
+ * On a timeout the interrupt is disarmed, since SECS would keep the RNG
+ * silent, and the recovery is retried by the next ::Rng_Arm.
+ *
+ * @return true once the RNG left the seed error.
+ */
+static bool Rng_Recover(void)
+{
+    LL_RNG_ClearFlag_SEIS(RNG);
+    LL_RNG_EnableCondReset(RNG);
+
+    if (!Rng_CondReset())
+    {
+        g_rngStatus.reset_timeouts++;
+        g_rngRecoverPending = true;
+        LL_RNG_DisableIT(RNG);
+        g_rngArmed = false;
+        return false;
+    }
+
+    g_rngRecoverPending = false;
+    return true;
+}
+
+/**
+ * @brief Clear CONDRST and wait for the RNG to leave the reset and the seed error.
+ *
+ * @return true if both cleared within ::RNG_RESET_SPIN polls.
+ */
+static bool Rng_CondReset(void)
+{
+    LL_RNG_DisableCondReset(RNG);
+
+    for (uint32_t spin = 0U; spin < RNG_RESET_SPIN; spin++)
+    {
+        if ((LL_RNG_IsEnabledCondReset(RNG) == 0U) && (LL_RNG_IsActiveFlag_SECS(RNG) == 0U))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @} */ // end of Rng group
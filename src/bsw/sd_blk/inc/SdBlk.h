@@ -0,0 +1,204 @@
+/**
+ * @file SdBlk.h
+ * @brief SD card block device on SDMMC1 with IDMA streaming
+ *
+ * ::SdBlk_Mount identifies an SDHC/SDXC card, selects it and switches it
+ * to the 4-bit bus at ::SDBLK_BUS_HZ. Reads and writes of 512-byte blocks
+ * are then queued from any task or interrupt and run in order.
+ *
+ * Every transfer is a multi-block command, CMD18 or CMD25, closed by
+ * CMD12. Queued requests of the same direction on consecutive blocks are
+ * merged into one command, so a stream of writes keeps the card in one
+ * programming sequence. A write may carry a pre-erase hint: the block
+ * count is sent with ACMD23 before CMD25 so the card can erase ahead of
+ * the data; the hint keeps applying to later write runs that continue the
+ * hinted area.
+ *
+ * The data moves through the SDMMC internal DMA in linked-list mode over
+ * two list items used in turn: while the controller transfers one buffer
+ * of at most ::SDBLK_SEGMENT_BYTES, the driver points the other item at
+ * the next one. A run may therefore span the separate buffers of every
+ * request merged into it without copying.
+ */
+
+#ifndef SD_BLK_H
+#define SD_BLK_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef SDBLK_QUEUE_LEN
+#define SDBLK_QUEUE_LEN (16U) /**< Requests waiting behind the running ones */
+#endif
+
+#ifndef SDBLK_MAX_CHAIN
+#define SDBLK_MAX_CHAIN (8U) /**< Requests merged into one multi-block command at most */
+#endif
+
+#ifndef SDBLK_SEGMENT_BYTES
+#define SDBLK_SEGMENT_BYTES (32768U) /**< Largest buffer of one IDMA list item, a multiple of 512 */
+#endif
+
+#ifndef SDBLK_BUS_HZ
+#define SDBLK_BUS_HZ (25000000U) /**< Data transfer clock, default speed */
+#endif
+
+#ifndef SDBLK_MOUNT_TIMEOUT_MS
+#define SDBLK_MOUNT_TIMEOUT_MS (1000U) /**< Time the card may take to leave its power-up busy state */
+#endif
+
+#define SDBLK_INIT_HZ (400000U)          /**< Identification clock */
+#define SDBLK_BLOCK_SIZE (512U)          /**< Bytes per block */
+#define SDBLK_MAX_RUN_BLOCKS (65535U)    /**< Blocks of one multi-block command, DLEN limit */
+#define SDBLK_NOTIFY_INDEX (1U)          /**< Task notification index used by the blocking calls */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Outcome of a request.
+ */
+typedef enum
+{
+    SDBLK_OK = 0,        /**< Request done */
+    SDBLK_ERR_CMD,       /**< Command timeout or response CRC failure */
+    SDBLK_ERR_DATA,      /**< Data CRC failure, timeout, overrun or underrun */
+    SDBLK_ERR_DMA,       /**< IDMA transfer error, a list item was not ready */
+    SDBLK_ERR_CARD,      /**< The card reported an error in its status */
+    SDBLK_ERR_PARAM,     /**< Invalid request, not queued */
+    SDBLK_ERR_NO_CARD,   /**< No card mounted */
+} SdBlk_Result_T;
+
+/**
+ * @brief Transfer direction.
+ */
+typedef enum
+{
+    SDBLK_READ = 0, /**< Card to memory */
+    SDBLK_WRITE,    /**< Memory to card */
+} SdBlk_Op_T;
+
+/**
+ * @brief Request completion callback.
+ *
+ * Runs from interrupt context. The driver no longer references the
+ * buffer once it runs.
+ *
+ * @param[in] ctx    Context given with the request.
+ * @param[in] result Outcome.
+ */
+typedef void (*SdBlk_Callback_T)(void *ctx, SdBlk_Result_T result);
+
+/**
+ * @brief Block request.
+ *
+ * The buffer must be 4-byte aligned and DMA-reachable; it is cleaned or
+ * invalidated by the driver unless it is non-cacheable.
+ */
+typedef struct
+{
+    SdBlk_Op_T op;         /**< Direction */
+    uint32_t lba;          /**< First block */
+    uint32_t blocks;       /**< Blocks to transfer, at most ::SDBLK_MAX_RUN_BLOCKS */
+    void *buf;             /**< Data, blocks x ::SDBLK_BLOCK_SIZE bytes */
+    uint32_t erase_hint;   /**< Writes: blocks about to be written from @ref lba, sent with ACMD23; 0 for none */
+    SdBlk_Callback_T cb;   /**< Completion callback, may be NULL */
+    void *ctx;             /**< Passed unchanged to @ref cb */
+} SdBlk_Request_T;
+
+/**
+ * @brief Mounted card.
+ */
+typedef struct
+{
+    uint32_t blocks;    /**< Capacity in blocks */
+    uint16_t rca;       /**< Relative card address */
+    uint32_t bus_hz;    /**< Data clock actually programmed */
+    uint8_t bus_width;  /**< Data lines in use */
+} SdBlk_Info_T;
+
+/**
+ * @brief Driver counters.
+ */
+typedef struct
+{
+    uint32_t requests_done;   /**< Requests completed */
+    uint32_t requests_failed; /**< Requests ended by an error */
+    uint64_t bytes_read;      /**< Bytes of completed reads */
+    uint64_t bytes_written;   /**< Bytes of completed writes */
+    uint32_t runs;            /**< Multi-block commands issued */
+    uint32_t chained;         /**< Requests merged into the run of an earlier one */
+    uint32_t pre_erases;      /**< ACMD23 pre-erase counts sent */
+    uint32_t segments;        /**< IDMA buffers transferred */
+    uint32_t cmd_errors;      /**< Runs ended by a command error */
+    uint32_t data_errors;     /**< Runs ended by a data error */
+    uint32_t dma_errors;      /**< Runs ended by an IDMA error */
+    uint32_t card_errors;     /**< Runs ended by an error in the card status */
+    uint32_t queue_peak;      /**< Largest number of waiting requests */
+    uint32_t queue_full;      /**< Submissions rejected on a full queue */
+    uint32_t irqs;            /**< SDMMC1 interrupts handled */
+    uint64_t busy_cycles;     /**< CPU cycles from the start to the end of every run */
+    uint32_t latency_avg_us;  /**< Mean time from submission to completion */
+    uint32_t latency_max_us;  /**< Worst time from submission to completion */
+} SdBlk_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Clock SDMMC1, configure its pins and take its interrupt.
+ *
+ * @retval true  Ready for ::SdBlk_Mount.
+ * @retval false The interrupt is taken.
+ */
+bool SdBlk_Init(void);
+
+/**
+ * @brief Identify, select and switch the card to its transfer settings.
+ *
+ * Blocks the calling task; not callable while requests are queued.
+ * Only cards with block addressing (SDHC and SDXC) are accepted.
+ *
+ * @param[out] info Card found, may be NULL.
+ *
+ * @return ::SDBLK_OK, ::SDBLK_ERR_NO_CARD when nothing answers, or the
+ *         error that stopped the identification.
+ */
+SdBlk_Result_T SdBlk_Mount(SdBlk_Info_T *info);
+
+/**
+ * @brief Queue a request.
+ *
+ * Callable from tasks and from interrupts up to
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @param[in] req Request, copied.
+ *
+ * @retval true  Queued; its callback will run.
+ * @retval false Invalid, no card, or the queue is full.
+ */
+bool SdBlk_Submit(const SdBlk_Request_T *req);
+
+/**
+ * @brief Read blocks and block the calling task until done.
+ */
+SdBlk_Result_T SdBlk_Read(uint32_t lba, void *buf, uint32_t blocks);
+
+/**
+ * @brief Write blocks and block the calling task until done.
+ *
+ * @param[in] erase_hint Blocks about to be written from @p lba, 0 for none.
+ */
+SdBlk_Result_T SdBlk_Write(uint32_t lba, const void *buf, uint32_t blocks, uint32_t erase_hint);
+
+/**
+ * @brief Copy the driver counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void SdBlk_GetStatus(SdBlk_Status_T *status);
+
+#endif /* SD_BLK_H */
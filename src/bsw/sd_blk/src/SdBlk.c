@@ -0,0 +1,1026 @@
+/**
+ * @file SdBlk.c
+ * @brief Implementation of the SD card block device.
+ * @ingroup SdBlk
+ * @{
+ *
+ * Identification runs polled from the calling task, one command at a
+ * time. Once mounted, requests run from the SDMMC1 interrupt as a
+ * sequence of commands per run:
+ *  - CMD55 and ACMD23 when the first write of the run has a pre-erase hint
+ *    or continues the hinted area of the previous write run,
+ *  - CMD18 or CMD25 with CMDTRANS, which starts the data path for the
+ *    whole run,
+ *  - CMD12 with CMDSTOP once DATAEND is seen, then the end of the busy
+ *    signal on D0 after a write.
+ *
+ * The IDMA takes its first buffer from the registers and the following
+ * ones from two list items in non-cacheable memory. Buffer k + 1 is loaded
+ * from its item when buffer k ends, so on IDMABTC of buffer k the item of
+ * buffer k + 1 is free again and is filled with buffer k + 3; buffer k + 2
+ * already waits in the other item. Every item is written with ABR set,
+ * which tells the controller the buffer it describes is ready.
+ *
+ * The ST low-level SDMMC layer needs the HAL definitions and polls for
+ * the end of every command, so the driver works on the CMSIS register
+ * definitions alone.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SdBlk.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SDBLK_INSTANCE SDMMC1                     /**< SDMMC instance used */
+#define SDBLK_IRQ SDMMC1_IRQn                     /**< Its interrupt */
+#define SDBLK_PINS_PORT_C GPIOC                   /**< Port of D0-D3 and CK */
+#define SDBLK_PINS_C (LL_GPIO_PIN_8 | LL_GPIO_PIN_9 | LL_GPIO_PIN_10 | LL_GPIO_PIN_11 | LL_GPIO_PIN_12) /**< D0-D3, CK */
+#define SDBLK_PINS_PORT_D GPIOD                   /**< Port of CMD */
+#define SDBLK_PINS_D LL_GPIO_PIN_2                /**< CMD */
+#define SDBLK_PINS_AF LL_GPIO_AF_12               /**< Alternate function of SDMMC1 */
+#define SDBLK_CMD_GO_IDLE (0U)                    /**< GO_IDLE_STATE */
+#define SDBLK_CMD_ALL_SEND_CID (2U)               /**< ALL_SEND_CID, R2 */
+#define SDBLK_CMD_SEND_RCA (3U)                   /**< SEND_RELATIVE_ADDR, R6 */
+#define SDBLK_CMD_APP_BUS_WIDTH (6U)              /**< SET_BUS_WIDTH after CMD55, R1 */
+#define SDBLK_CMD_SELECT (7U)                     /**< SELECT_CARD, R1b */
+#define SDBLK_CMD_SEND_IF_COND (8U)               /**< SEND_IF_COND, R7 */
+#define SDBLK_CMD_SEND_CSD (9U)                   /**< SEND_CSD, R2 */
+#define SDBLK_CMD_STOP (12U)                      /**< STOP_TRANSMISSION, R1b */
+#define SDBLK_CMD_READ_MULTI (18U)                /**< READ_MULTIPLE_BLOCK, R1 */
+#define SDBLK_CMD_APP_ERASE_COUNT (23U)           /**< SET_WR_BLK_ERASE_COUNT after CMD55, R1 */
+#define SDBLK_CMD_WRITE_MULTI (25U)               /**< WRITE_MULTIPLE_BLOCK, R1 */
+#define SDBLK_CMD_APP_OP_COND (41U)               /**< SD_SEND_OP_COND after CMD55, R3 */
+#define SDBLK_CMD_APP (55U)                       /**< APP_CMD, R1 */
+#define SDBLK_IF_COND (0x1AAU)                    /**< CMD8 argument: 2.7-3.6 V and check pattern */
+#define SDBLK_OCR_WINDOW (0x00100000UL)           /**< ACMD41 argument: 3.2-3.3 V */
+#define SDBLK_OCR_HCS (0x40000000UL)              /**< OCR: block-addressed card, host support in ACMD41 */
+#define SDBLK_OCR_READY (0x80000000UL)            /**< OCR: power-up done */
+#define SDBLK_R1_ERRORS (0xFDF98008UL)            /**< R1 card status error bits */
+#define SDBLK_ERASE_COUNT_MAX (0x7FFFFFU)         /**< Largest ACMD23 argument */
+#define SDBLK_ACMD6_4BIT (2U)                     /**< ACMD6 argument selecting the 4-bit bus */
+#define SDBLK_DATA_TIMEOUT_MS (250U)              /**< Longest wait for a block or for programming */
+#define SDBLK_SPIN_LIMIT (1000000U)               /**< Status polls of one identification command */
+#define SDBLK_CSD_V2 (1U)                         /**< CSD_STRUCTURE of high and extended capacity cards */
+#define SDBLK_RESP_NONE (0U)                      /**< WAITRESP: no response */
+#define SDBLK_RESP_SHORT SDMMC_CMD_WAITRESP_0     /**< WAITRESP: 48-bit response */
+#define SDBLK_RESP_LONG SDMMC_CMD_WAITRESP        /**< WAITRESP: 136-bit response */
+#define SDBLK_DBLOCKSIZE_512 (9UL << SDMMC_DCTRL_DBLOCKSIZE_Pos) /**< DCTRL block size of 512 bytes */
+#define SDBLK_CMD_FLAGS (SDMMC_STA_CCRCFAIL | SDMMC_STA_CTIMEOUT | SDMMC_STA_CMDREND) /**< End of a command with response */
+/** Command flags cleared before a command */
+#define SDBLK_CMD_CLEAR (SDBLK_CMD_FLAGS | SDMMC_ICR_CMDSENTC | SDMMC_ICR_BUSYD0ENDC)
+/** Every static flag of STA, same bit positions in ICR */
+#define SDBLK_CLEAR_ALL (0x1FE00FFFUL)
+/** Flags ending the data path of a run in error */
+#define SDBLK_DATA_ERRORS (SDMMC_STA_DCRCFAIL | SDMMC_STA_DTIMEOUT | SDMMC_STA_TXUNDERR | SDMMC_STA_RXOVERR | \
+                           SDMMC_STA_IDMATE)
+/** Interrupts of the data phase; IDMATE has no enable of its own and is checked with the others */
+#define SDBLK_MASK_DATA (SDBLK_CMD_FLAGS | SDMMC_MASK_DCRCFAILIE | SDMMC_MASK_DTIMEOUTIE | SDMMC_MASK_TXUNDERRIE | \
+                         SDMMC_MASK_RXOVERRIE | SDMMC_MASK_DATAENDIE | SDMMC_MASK_IDMABTCIE)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Step of the run on the bus.
+ */
+typedef enum
+{
+    SDBLK_IDLE = 0,  /**< No run */
+    SDBLK_APP,       /**< CMD55 sent before ACMD23 */
+    SDBLK_ERASE,     /**< ACMD23 sent */
+    SDBLK_DATA,      /**< CMD18 or CMD25 sent, data moving */
+    SDBLK_STOP,      /**< CMD12 sent */
+    SDBLK_BUSY,      /**< Waiting for the card to release D0 */
+} SdBlk_State_T;
+
+/**
+ * @brief IDMA linked-list item, loaded by the controller in this order.
+ */
+typedef struct
+{
+    volatile uint32_t IDMALAR;   /**< Link to the next item, ULA/ULS/ABR */
+    volatile uint32_t IDMABASER; /**< Buffer address */
+    volatile uint32_t IDMABSIZE; /**< Buffer size in bytes */
+} SdBlk_Node_T;
+
+/**
+ * @brief Queued request with its submission time.
+ */
+typedef struct
+{
+    SdBlk_Request_T req; /**< Request as submitted */
+    uint32_t submitted;  /**< CYCCNT at submission */
+} SdBlk_Slot_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Requests waiting to run. */
+static SdBlk_Slot_T g_sdBlkQueue[SDBLK_QUEUE_LEN];
+/** Index of the oldest waiting request. */
+static uint32_t g_sdBlkHead = 0U;
+/** Waiting requests. */
+static uint32_t g_sdBlkCount = 0U;
+/** Requests of the run on the bus. */
+static SdBlk_Slot_T g_sdBlkRun[SDBLK_MAX_CHAIN];
+/** Entries of ::g_sdBlkRun in use. */
+static uint32_t g_sdBlkRunCount = 0U;
+/** Blocks of the run. */
+static uint32_t g_sdBlkRunBlocks = 0U;
+/** IDMA buffers of the run. */
+static uint32_t g_sdBlkSegTotal = 0U;
+/** Next buffer to describe in a list item. */
+static uint32_t g_sdBlkSegFill = 0U;
+/** Request of ::g_sdBlkRun the next buffer starts in. */
+static uint32_t g_sdBlkSegReq = 0U;
+/** Byte offset of the next buffer in that request. */
+static uint32_t g_sdBlkSegOffset = 0U;
+/** Pre-erase count sent before the data command of the run, 0 for none. */
+static uint32_t g_sdBlkRunErase = 0U;
+/** First block after the last hinted write run. */
+static uint32_t g_sdBlkEraseLba = 0U;
+/** Blocks of its hint not yet written; a write run starting at ::g_sdBlkEraseLba inherits them. */
+static uint32_t g_sdBlkEraseLeft = 0U;
+/** CYCCNT when the run started. */
+static uint32_t g_sdBlkRunStart = 0U;
+/** Step of the run. */
+static volatile SdBlk_State_T g_sdBlkState = SDBLK_IDLE;
+/** Outcome of the run so far. */
+static SdBlk_Result_T g_sdBlkResult = SDBLK_OK;
+/** IDMA list items used in turn, read by the controller. */
+static SdBlk_Node_T g_sdBlkNodes[2] __attribute__((section("noncacheable_buffer"), aligned(32)));
+/** A card is mounted. */
+static bool g_sdBlkMounted = false;
+/** Card found by the last mount. */
+static SdBlk_Info_T g_sdBlkInfo = {0};
+/** Sum of the request latencies behind @ref SdBlk_Status_T::latency_avg_us. */
+static uint64_t g_sdBlkLatencySum = 0U;
+/** Counters reported by ::SdBlk_GetStatus. */
+static SdBlk_Status_T g_sdBlkStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Configure the data, clock and command lines. */
+static void SdBlk_InitGpio(void);
+/** CLKDIV for a bus rate at most @p hz, and the rate it gives. */
+static uint32_t SdBlk_ClockDiv(uint32_t hz, uint32_t *actual);
+/** Send one command and poll for its end. Task context, interrupt disabled. */
+static SdBlk_Result_T SdBlk_Command(uint32_t index, uint32_t arg, uint32_t wait, bool crc, uint32_t *resp);
+/** Run the identification sequence. */
+static SdBlk_Result_T SdBlk_Identify(void);
+/** A request is acceptable. */
+static bool SdBlk_IsValid(const SdBlk_Request_T *req);
+/** Cache maintenance of the buffer before the transfer. */
+static void SdBlk_CleanBuffer(const SdBlk_Request_T *req);
+/** Queue a request without checking it. */
+static bool SdBlk_Enqueue(const SdBlk_Request_T *req);
+/** Queue a request and wait for it. */
+static SdBlk_Result_T SdBlk_Wait(const SdBlk_Request_T *req);
+/** Start the next run, if any. Interrupts masked or from the SDMMC interrupt. */
+static void SdBlk_StartNext(void);
+/** Issue a command from the interrupt-driven run. */
+static void SdBlk_Issue(uint32_t index, uint32_t arg, uint32_t flags, uint32_t mask);
+/** Arm the IDMA and send CMD18 or CMD25. */
+static void SdBlk_StartData(void);
+/** Take the next IDMA buffer of the run. */
+static void SdBlk_NextSegment(uint32_t *addr, uint32_t *size);
+/** Describe the next buffer in a list item. */
+static void SdBlk_FillNode(uint32_t node);
+/** Send CMD12 after the data or an error. */
+static void SdBlk_Stop(SdBlk_Result_T result);
+/** Complete every request of the run and start the next one. */
+static void SdBlk_Finish(void);
+/** SDMMC1 interrupt, bound through the ISR manager. */
+static void SdBlk_IrqHandler(void *ctx);
+/** Completion callback of the blocking calls. */
+static void SdBlk_WakeWaiter(void *ctx, SdBlk_Result_T result);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Clock SDMMC1 from HCLK, configure the pins and bind its interrupt.
+ *
+ * The card is left unpowered until ::SdBlk_Mount.
+ */
+bool SdBlk_Init(void)
+{
+    SdBlk_InitGpio();
+    LL_AHB5_GRP1_EnableClock(LL_AHB5_GRP1_PERIPH_SDMMC1);
+    LL_RCC_SetSDMMCClockSource(LL_RCC_SDMMC1_CLKSOURCE_HCLK);
+
+    if (!IsrMgr_Register(SDBLK_IRQ, SdBlk_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    WRITE_REG(SDBLK_INSTANCE->MASK, 0U);
+    WRITE_REG(SDBLK_INSTANCE->ICR, SDBLK_CLEAR_ALL);
+    NVIC_SetPriority(SDBLK_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                    configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(SDBLK_IRQ);
+    return true;
+}
+
+/**
+ * @brief Power the card, identify it and switch to the transfer clock and bus.
+ */
+SdBlk_Result_T SdBlk_Mount(SdBlk_Info_T *info)
+{
+    if (g_sdBlkState != SDBLK_IDLE)
+    {
+        return SDBLK_ERR_PARAM;
+    }
+
+    g_sdBlkMounted = false;
+    SdBlk_Result_T result = SdBlk_Identify();
+    if (result == SDBLK_OK)
+    {
+        g_sdBlkMounted = true;
+        if (info != NULL)
+        {
+            *info = g_sdBlkInfo;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Queue a request.
+ *
+ * Cache maintenance runs in the caller.
+ */
+bool SdBlk_Submit(const SdBlk_Request_T *req)
+{
+    if (!SdBlk_IsValid(req))
+    {
+        return false;
+    }
+
+    SdBlk_CleanBuffer(req);
+    return SdBlk_Enqueue(req);
+}
+
+/**
+ * @brief Read blocks and block the calling task until done.
+ */
+SdBlk_Result_T SdBlk_Read(uint32_t lba, void *buf, uint32_t blocks)
+{
+    const SdBlk_Request_T req = {
+        .op = SDBLK_READ,
+        .lba = lba,
+        .blocks = blocks,
+        .buf = buf,
+    };
+
+    return SdBlk_Wait(&req);
+}
+
+/**
+ * @brief Write blocks and block the calling task until done.
+ */
+SdBlk_Result_T SdBlk_Write(uint32_t lba, const void *buf, uint32_t blocks, uint32_t erase_hint)
+{
+    const SdBlk_Request_T req = {
+        .op = SDBLK_WRITE,
+        .lba = lba,
+        .blocks = blocks,
+        .buf = (void *)buf,
+        .erase_hint = erase_hint,
+    };
+
+    return SdBlk_Wait(&req);
+}
+
+/**
+ * @brief Copy the driver counters into @p status.
+ */
+void SdBlk_GetStatus(SdBlk_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_sdBlkStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Configure D0-D3, CK and CMD as alternate function.
+ *
+ * The data and command lines need pull-ups; CK is driven only by the
+ * controller.
+ */
+static void SdBlk_InitGpio(void)
+{
+    LL_GPIO_InitTypeDef gpio_h;
+
+    LL_AHB4_GRP1_EnableClock(LL_AHB4_GRP1_PERIPH_GPIOC | LL_AHB4_GRP1_PERIPH_GPIOD);
+
+    gpio_h.Pin = SDBLK_PINS_C & ~LL_GPIO_PIN_12;
+    gpio_h.Mode = LL_GPIO_MODE_ALTERNATE;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = LL_GPIO_PULL_UP;
+    gpio_h.Alternate = SDBLK_PINS_AF;
+    LL_GPIO_Init(SDBLK_PINS_PORT_C, &gpio_h);
+
+    gpio_h.Pin = SDBLK_PINS_D;
+    LL_GPIO_Init(SDBLK_PINS_PORT_D, &gpio_h);
+
+    gpio_h.Pin = LL_GPIO_PIN_12;
+    gpio_h.Pull = LL_GPIO_PULL_NO;
+    LL_GPIO_Init(SDBLK_PINS_PORT_C, &gpio_h);
+}
+
+/**
+ * @brief CLKDIV for a bus rate at most @p hz.
+ *
+ * The bus runs at the kernel clock divided by 2 x CLKDIV, or at the
+ * kernel clock itself with CLKDIV at 0.
+ *
+ * @param[in]  hz     Highest bus rate allowed.
+ * @param[out] actual Bus rate CLKDIV gives.
+ *
+ * @return CLKDIV field value.
+ */
+static uint32_t SdBlk_ClockDiv(uint32_t hz, uint32_t *actual)
+{
+    uint32_t kernelHz = LL_RCC_GetSDMMCClockFreq(LL_RCC_SDMMC1_CLKSOURCE);
+
+    if (kernelHz <= hz)
+    {
+        *actual = kernelHz;
+        return 0U;
+    }
+
+    uint32_t div = (kernelHz + (2U * hz) - 1U) / (2U * hz);
+    if (div > SDMMC_CLKCR_CLKDIV_Msk)
+    {
+        div = SDMMC_CLKCR_CLKDIV_Msk;
+    }
+    *actual = kernelHz / (2U * div);
+    return div;
+}
+
+/**
+ * @brief Send one command and poll for its end.
+ *
+ * Used only while no run is on the bus, with the interrupt sources
+ * masked. A response without CRC (R3) ends on CCRCFAIL, which is then the
+ * normal end.
+ *
+ * @param[in]  index Command index.
+ * @param[in]  arg   Argument.
+ * @param[in]  wait  ::SDBLK_RESP_NONE, ::SDBLK_RESP_SHORT or ::SDBLK_RESP_LONG.
+ * @param[in]  crc   The response carries a valid CRC.
+ * @param[out] resp  RESP1, may be NULL.
+ */
+static SdBlk_Result_T SdBlk_Command(uint32_t index, uint32_t arg, uint32_t wait, bool crc, uint32_t *resp)
+{
+    uint32_t done = (wait == SDBLK_RESP_NONE) ? (SDMMC_STA_CMDSENT | SDMMC_STA_CTIMEOUT) : SDBLK_CMD_FLAGS;
+    uint32_t spin = SDBLK_SPIN_LIMIT;
+    uint32_t sta = 0U;
+
+    WRITE_REG(SDBLK_INSTANCE->ICR, SDBLK_CMD_CLEAR);
+    WRITE_REG(SDBLK_INSTANCE->ARG, arg);
+    WRITE_REG(SDBLK_INSTANCE->CMD, index | wait | SDMMC_CMD_CPSMEN);
+
+    while (((sta & done) == 0U) && (spin > 0U))
+    {
+        sta = READ_REG(SDBLK_INSTANCE->STA);
+        spin--;
+    }
+    WRITE_REG(SDBLK_INSTANCE->ICR, SDBLK_CMD_CLEAR);
+
+    if (((sta & SDMMC_STA_CTIMEOUT) != 0U) || ((sta & done) == 0U))
+    {
+        return SDBLK_ERR_CMD;
+    }
+    if (((sta & SDMMC_STA_CCRCFAIL) != 0U) && crc)
+    {
+        return SDBLK_ERR_CMD;
+    }
+    if (resp != NULL)
+    {
+        *resp = READ_REG(SDBLK_INSTANCE->RESP1);
+    }
+    return SDBLK_OK;
+}
+
+/**
+ * @brief Run the identification sequence at ::SDBLK_INIT_HZ.
+ *
+ * CMD0, CMD8 to check the voltage, ACMD41 with HCS until the card leaves
+ * its busy state, CMD2 and CMD3 for the address, CMD9 for the capacity,
+ * CMD7 to select it and ACMD6 for the 4-bit bus.
+ */
+static SdBlk_Result_T SdBlk_Identify(void)
+{
+    uint32_t resp = 0U;
+    uint32_t hz = 0U;
+    uint32_t div = SdBlk_ClockDiv(SDBLK_INIT_HZ, &hz);
+
+    WRITE_REG(SDBLK_INSTANCE->MASK, 0U);
+    WRITE_REG(SDBLK_INSTANCE->CLKCR, div);
+    WRITE_REG(SDBLK_INSTANCE->POWER, SDMMC_POWER_PWRCTRL);
+    /* At least 74 clocks before the first command */
+    vTaskDelay(pdMS_TO_TICKS(2U));
+
+    (void)SdBlk_Command(SDBLK_CMD_GO_IDLE, 0U, SDBLK_RESP_NONE, true, NULL);
+    if (SdBlk_Command(SDBLK_CMD_SEND_IF_COND, SDBLK_IF_COND, SDBLK_RESP_SHORT, true, &resp) != SDBLK_OK)
+    {
+        return SDBLK_ERR_NO_CARD;
+    }
+    if ((resp & 0xFFFU) != SDBLK_IF_COND)
+    {
+        return SDBLK_ERR_CARD;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    do
+    {
+        if ((SdBlk_Command(SDBLK_CMD_APP, 0U, SDBLK_RESP_SHORT, true, NULL) != SDBLK_OK) ||
+            (SdBlk_Command(SDBLK_CMD_APP_OP_COND, SDBLK_OCR_WINDOW | SDBLK_OCR_HCS,
+                           SDBLK_RESP_SHORT, false, &resp) != SDBLK_OK))
+        {
+            return SDBLK_ERR_CMD;
+        }
+        if ((resp & SDBLK_OCR_READY) != 0U)
+        {
+            break;
+        }
+        vTaskDelay(1);
+    } while ((xTaskGetTickCount() - start) < pdMS_TO_TICKS(SDBLK_MOUNT_TIMEOUT_MS));
+
+    if ((resp & SDBLK_OCR_READY) == 0U)
+    {
+        return SDBLK_ERR_CARD;
+    }
+    if ((resp & SDBLK_OCR_HCS) == 0U)
+    {
+        /* Byte-addressed standard capacity cards are not supported */
+        return SDBLK_ERR_CARD;
+    }
+
+    if ((SdBlk_Command(SDBLK_CMD_ALL_SEND_CID, 0U, SDBLK_RESP_LONG, true, NULL) != SDBLK_OK) ||
+        (SdBlk_Command(SDBLK_CMD_SEND_RCA, 0U, SDBLK_RESP_SHORT, true, &resp) != SDBLK_OK))
+    {
+        return SDBLK_ERR_CMD;
+    }
+    uint32_t rca = resp & 0xFFFF0000UL;
+
+    if (SdBlk_Command(SDBLK_CMD_SEND_CSD, rca, SDBLK_RESP_LONG, true, &resp) != SDBLK_OK)
+    {
+        return SDBLK_ERR_CMD;
+    }
+    if ((resp >> 30) != SDBLK_CSD_V2)
+    {
+        return SDBLK_ERR_CARD;
+    }
+    /* C_SIZE is CSD bits 69:48, across RESP2 and RESP3 */
+    uint32_t cSize = ((READ_REG(SDBLK_INSTANCE->RESP2) & 0x3FU) << 16) | (READ_REG(SDBLK_INSTANCE->RESP3) >> 16);
+
+    if ((SdBlk_Command(SDBLK_CMD_SELECT, rca, SDBLK_RESP_SHORT, true, &resp) != SDBLK_OK) ||
+        (SdBlk_Command(SDBLK_CMD_APP, rca, SDBLK_RESP_SHORT, true, NULL) != SDBLK_OK) ||
+        (SdBlk_Command(SDBLK_CMD_APP_BUS_WIDTH, SDBLK_ACMD6_4BIT, SDBLK_RESP_SHORT, true, &resp) != SDBLK_OK))
+    {
+        return SDBLK_ERR_CMD;
+    }
+    if ((resp & SDBLK_R1_ERRORS) != 0U)
+    {
+        return SDBLK_ERR_CARD;
+    }
+
+    div = SdBlk_ClockDiv(SDBLK_BUS_HZ, &hz);
+    WRITE_REG(SDBLK_INSTANCE->CLKCR, div | SDMMC_CLKCR_WIDBUS_0);
+    WRITE_REG(SDBLK_INSTANCE->DTIMER, (hz / 1000U) * SDBLK_DATA_TIMEOUT_MS);
+
+    g_sdBlkInfo.blocks = (cSize + 1U) * 1024U;
+    g_sdBlkInfo.rca = (uint16_t)(rca >> 16);
+    g_sdBlkInfo.bus_hz = hz;
+    g_sdBlkInfo.bus_width = 4U;
+    return SDBLK_OK;
+}
+
+/**
+ * @brief A request is acceptable: a mounted card, a word-aligned buffer
+ *        and blocks inside the card.
+ */
+static bool SdBlk_IsValid(const SdBlk_Request_T *req)
+{
+    if ((req == NULL) || (req->buf == NULL) || (((uintptr_t)req->buf & 3U) != 0U) || (req->blocks == 0U) ||
+        (req->blocks > SDBLK_MAX_RUN_BLOCKS) || ((req->op != SDBLK_READ) && (req->op != SDBLK_WRITE)))
+    {
+        return false;
+    }
+    return g_sdBlkMounted && (req->lba < g_sdBlkInfo.blocks) && (req->blocks <= (g_sdBlkInfo.blocks - req->lba));
+}
+
+/**
+ * @brief Clean a write buffer, clean and invalidate a read buffer.
+ *
+ * Invalidating the read buffer as well keeps a dirty line from being
+ * evicted over the received blocks.
+ */
+static void SdBlk_CleanBuffer(const SdBlk_Request_T *req)
+{
+    uint32_t bytes = req->blocks * SDBLK_BLOCK_SIZE;
+
+    if (DmaPool_IsNonCacheable(req->buf, bytes))
+    {
+        return;
+    }
+    if (req->op == SDBLK_WRITE)
+    {
+        SCB_CleanDCache_by_Addr(req->buf, (int32_t)bytes);
+    }
+    else
+    {
+        SCB_CleanInvalidateDCache_by_Addr(req->buf, (int32_t)bytes);
+    }
+}
+
+/**
+ * @brief Queue a request, starting a run if the bus is idle.
+ */
+static bool SdBlk_Enqueue(const SdBlk_Request_T *req)
+{
+    bool queued = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_sdBlkCount < SDBLK_QUEUE_LEN)
+    {
+        SdBlk_Slot_T *slot = &g_sdBlkQueue[(g_sdBlkHead + g_sdBlkCount) % SDBLK_QUEUE_LEN];
+        slot->req = *req;
+        slot->submitted = DWT->CYCCNT;
+        g_sdBlkCount++;
+        if (g_sdBlkCount > g_sdBlkStatus.queue_peak)
+        {
+            g_sdBlkStatus.queue_peak = g_sdBlkCount;
+        }
+        if (g_sdBlkState == SDBLK_IDLE)
+        {
+            SdBlk_StartNext();
+        }
+    }
+    else
+    {
+        g_sdBlkStatus.queue_full++;
+        queued = false;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Queue a request and block until its callback.
+ */
+static SdBlk_Result_T SdBlk_Wait(const SdBlk_Request_T *req)
+{
+    if (!SdBlk_IsValid(req))
+    {
+        return g_sdBlkMounted ? SDBLK_ERR_PARAM : SDBLK_ERR_NO_CARD;
+    }
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+    SdBlk_Request_T copy = *req;
+
+    copy.cb = SdBlk_WakeWaiter;
+    copy.ctx = self;
+    SdBlk_CleanBuffer(&copy);
+
+    xTaskNotifyStateClearIndexed(self, SDBLK_NOTIFY_INDEX);
+    while (!SdBlk_Enqueue(&copy))
+    {
+        vTaskDelay(1);
+    }
+    (void)xTaskNotifyWaitIndexed(SDBLK_NOTIFY_INDEX, 0U, UINT32_MAX, &value, portMAX_DELAY);
+
+    return (SdBlk_Result_T)value;
+}
+
+/**
+ * @brief Start the next run, if any.
+ *
+ * Takes the oldest request and merges the following ones while they
+ * continue it in the same direction, up to ::SDBLK_MAX_CHAIN requests and
+ * ::SDBLK_MAX_RUN_BLOCKS blocks. A pre-erase hint of the first write is
+ * sent before the data command. ACMD23 only covers the next CMD25, so the
+ * part of a hint beyond the run is sent again before the write run that
+ * continues it.
+ */
+static void SdBlk_StartNext(void)
+{
+    if (g_sdBlkCount == 0U)
+    {
+        g_sdBlkState = SDBLK_IDLE;
+        return;
+    }
+
+    g_sdBlkRunCount = 0U;
+    g_sdBlkRunBlocks = 0U;
+    do
+    {
+        const SdBlk_Slot_T *slot = &g_sdBlkQueue[g_sdBlkHead];
+        if (g_sdBlkRunCount != 0U)
+        {
+            const SdBlk_Request_T *first = &g_sdBlkRun[0].req;
+            if ((slot->req.op != first->op) || (slot->req.lba != (first->lba + g_sdBlkRunBlocks)) ||
+                (slot->req.blocks > (SDBLK_MAX_RUN_BLOCKS - g_sdBlkRunBlocks)))
+            {
+                break;
+            }
+            g_sdBlkStatus.chained++;
+        }
+        g_sdBlkRun[g_sdBlkRunCount++] = *slot;
+        g_sdBlkRunBlocks += slot->req.blocks;
+        g_sdBlkHead = (g_sdBlkHead + 1U) % SDBLK_QUEUE_LEN;
+        g_sdBlkCount--;
+    } while ((g_sdBlkCount != 0U) && (g_sdBlkRunCount < SDBLK_MAX_CHAIN));
+
+    g_sdBlkResult = SDBLK_OK;
+    g_sdBlkRunStart = DWT->CYCCNT;
+    g_sdBlkStatus.runs++;
+
+    const SdBlk_Request_T *first = &g_sdBlkRun[0].req;
+    g_sdBlkRunErase = 0U;
+    if (first->op == SDBLK_WRITE)
+    {
+        g_sdBlkRunErase = first->erase_hint;
+        if ((g_sdBlkRunErase == 0U) && (first->lba == g_sdBlkEraseLba))
+        {
+            g_sdBlkRunErase = g_sdBlkEraseLeft;
+        }
+        g_sdBlkEraseLba = first->lba + g_sdBlkRunBlocks;
+        g_sdBlkEraseLeft = (g_sdBlkRunErase > g_sdBlkRunBlocks) ? (g_sdBlkRunErase - g_sdBlkRunBlocks) : 0U;
+    }
+
+    if (g_sdBlkRunErase != 0U)
+    {
+        g_sdBlkState = SDBLK_APP;
+        SdBlk_Issue(SDBLK_CMD_APP, (uint32_t)g_sdBlkInfo.rca << 16, 0U, SDBLK_CMD_FLAGS);
+    }
+    else
+    {
+        SdBlk_StartData();
+    }
+}
+
+/**
+ * @brief Issue a command with a short response from the interrupt-driven run.
+ *
+ * @param[in] index Command index.
+ * @param[in] arg   Argument.
+ * @param[in] flags CMDTRANS or CMDSTOP, or 0.
+ * @param[in] mask  Interrupts enabled until the next step.
+ */
+static void SdBlk_Issue(uint32_t index, uint32_t arg, uint32_t flags, uint32_t mask)
+{
+    WRITE_REG(SDBLK_INSTANCE->ICR, SDBLK_CLEAR_ALL);
+    WRITE_REG(SDBLK_INSTANCE->MASK, mask);
+    WRITE_REG(SDBLK_INSTANCE->ARG, arg);
+    WRITE_REG(SDBLK_INSTANCE->CMD, index | flags | SDBLK_RESP_SHORT | SDMMC_CMD_CPSMEN);
+}
+
+/**
+ * @brief Arm the IDMA over the buffers of the run and send CMD18 or CMD25.
+ *
+ * The first buffer is programmed in the registers, the next two in the
+ * list items; with a single buffer no item is used.
+ */
+static void SdBlk_StartData(void)
+{
+    const SdBlk_Request_T *first = &g_sdBlkRun[0].req;
+    bool read = (first->op == SDBLK_READ);
+    uint32_t addr = 0U;
+    uint32_t size = 0U;
+
+    g_sdBlkSegTotal = 0U;
+    for (uint32_t i = 0U; i < g_sdBlkRunCount; i++)
+    {
+        uint32_t bytes = g_sdBlkRun[i].req.blocks * SDBLK_BLOCK_SIZE;
+        g_sdBlkSegTotal += (bytes + SDBLK_SEGMENT_BYTES - 1U) / SDBLK_SEGMENT_BYTES;
+    }
+    g_sdBlkSegReq = 0U;
+    g_sdBlkSegOffset = 0U;
+    g_sdBlkSegFill = 0U;
+
+    SdBlk_NextSegment(&addr, &size);
+    g_sdBlkSegFill = 1U;
+    WRITE_REG(SDBLK_INSTANCE->IDMABASER, addr);
+    WRITE_REG(SDBLK_INSTANCE->IDMABSIZE, size);
+    WRITE_REG(SDBLK_INSTANCE->IDMABAR, (uint32_t)(uintptr_t)g_sdBlkNodes);
+    /* The second buffer comes from the first list item, at offset 0 */
+    WRITE_REG(SDBLK_INSTANCE->IDMALAR, SDMMC_IDMALAR_ABR | ((g_sdBlkSegTotal > 1U)
+                                                               ? (SDMMC_IDMALAR_ULA | SDMMC_IDMALAR_ULS)
+                                                               : 0U));
+    for (uint32_t node = 0U; (node < 2U) && (g_sdBlkSegFill < g_sdBlkSegTotal); node++)
+    {
+        SdBlk_FillNode(node);
+    }
+    WRITE_REG(SDBLK_INSTANCE->IDMACTRL, SDMMC_IDMA_IDMAEN | ((g_sdBlkSegTotal > 1U) ? SDMMC_IDMA_IDMABMODE : 0U));
+
+    WRITE_REG(SDBLK_INSTANCE->DLEN, g_sdBlkRunBlocks * SDBLK_BLOCK_SIZE);
+    WRITE_REG(SDBLK_INSTANCE->DCTRL, SDBLK_DBLOCKSIZE_512 | (read ? SDMMC_DCTRL_DTDIR : 0U));
+    g_sdBlkState = SDBLK_DATA;
+    SdBlk_Issue(read ? SDBLK_CMD_READ_MULTI : SDBLK_CMD_WRITE_MULTI, first->lba, SDMMC_CMD_CMDTRANS,
+                SDBLK_MASK_DATA);
+}
+
+/**
+ * @brief Take the next IDMA buffer of the run.
+ *
+ * Buffers are at most ::SDBLK_SEGMENT_BYTES and never cross from one
+ * request to the next.
+ */
+static void SdBlk_NextSegment(uint32_t *addr, uint32_t *size)
+{
+    const SdBlk_Request_T *req = &g_sdBlkRun[g_sdBlkSegReq].req;
+    uint32_t left = (req->blocks * SDBLK_BLOCK_SIZE) - g_sdBlkSegOffset;
+
+    *addr = (uint32_t)(uintptr_t)req->buf + g_sdBlkSegOffset;
+    *size = (left < SDBLK_SEGMENT_BYTES) ? left : SDBLK_SEGMENT_BYTES;
+    g_sdBlkSegOffset += *size;
+    if (g_sdBlkSegOffset == (req->blocks * SDBLK_BLOCK_SIZE))
+    {
+        g_sdBlkSegReq++;
+        g_sdBlkSegOffset = 0U;
+    }
+}
+
+/**
+ * @brief Describe buffer ::g_sdBlkSegFill in a list item.
+ *
+ * The item links to the other one unless it holds the last buffer of the
+ * run. ABR is set last, once the item is complete.
+ *
+ * @param[in] node List item, the one the controller loaded last.
+ */
+static void SdBlk_FillNode(uint32_t node)
+{
+    SdBlk_Node_T *item = &g_sdBlkNodes[node];
+    uint32_t addr = 0U;
+    uint32_t size = 0U;
+    uint32_t link = 0U;
+
+    SdBlk_NextSegment(&addr, &size);
+    g_sdBlkSegFill++;
+    if (g_sdBlkSegFill < g_sdBlkSegTotal)
+    {
+        link = SDMMC_IDMALAR_ULA | SDMMC_IDMALAR_ULS | (uint32_t)(sizeof(SdBlk_Node_T) * (node ^ 1U));
+    }
+
+    item->IDMABASER = addr;
+    item->IDMABSIZE = size;
+    item->IDMALAR = link;
+    __DMB();
+    item->IDMALAR = link | SDMMC_IDMALAR_ABR;
+}
+
+/**
+ * @brief Send CMD12 after the data or an error.
+ *
+ * The data path is stopped by CMDSTOP; the card leaves the data state
+ * and, after a write, signals busy on D0 until its programming ends.
+ */
+static void SdBlk_Stop(SdBlk_Result_T result)
+{
+    if (g_sdBlkResult == SDBLK_OK)
+    {
+        g_sdBlkResult = result;
+    }
+    g_sdBlkState = SDBLK_STOP;
+    SdBlk_Issue(SDBLK_CMD_STOP, 0U, SDMMC_CMD_CMDSTOP, SDBLK_CMD_FLAGS | SDMMC_MASK_BUSYD0ENDIE);
+}
+
+/**
+ * @brief Complete every request of the run and start the next one.
+ *
+ * The next run is started before the callbacks, so the bus only waits
+ * for the CPU while the queue is empty.
+ */
+static void SdBlk_Finish(void)
+{
+    SdBlk_Callback_T cbs[SDBLK_MAX_CHAIN];
+    void *ctxs[SDBLK_MAX_CHAIN];
+    uint32_t count = g_sdBlkRunCount;
+    SdBlk_Result_T result = g_sdBlkResult;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+
+    WRITE_REG(SDBLK_INSTANCE->MASK, 0U);
+    WRITE_REG(SDBLK_INSTANCE->IDMACTRL, 0U);
+    WRITE_REG(SDBLK_INSTANCE->ICR, SDBLK_CLEAR_ALL);
+    g_sdBlkStatus.busy_cycles += now - g_sdBlkRunStart;
+
+    switch (result)
+    {
+    case SDBLK_OK:
+        break;
+    case SDBLK_ERR_DATA:
+        g_sdBlkStatus.data_errors++;
+        break;
+    case SDBLK_ERR_DMA:
+        g_sdBlkStatus.dma_errors++;
+        break;
+    case SDBLK_ERR_CARD:
+        g_sdBlkStatus.card_errors++;
+        break;
+    default:
+        g_sdBlkStatus.cmd_errors++;
+        break;
+    }
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        const SdBlk_Request_T *req = &g_sdBlkRun[i].req;
+        uint32_t bytes = req->blocks * SDBLK_BLOCK_SIZE;
+        uint32_t us = (cyclesPerUs != 0U) ? ((now - g_sdBlkRun[i].submitted) / cyclesPerUs) : 0U;
+
+        cbs[i] = req->cb;
+        ctxs[i] = req->ctx;
+        if (result != SDBLK_OK)
+        {
+            g_sdBlkStatus.requests_failed++;
+            continue;
+        }
+        g_sdBlkStatus.requests_done++;
+        if (req->op == SDBLK_READ)
+        {
+            g_sdBlkStatus.bytes_read += bytes;
+            if (!DmaPool_IsNonCacheable(req->buf, bytes))
+            {
+                SCB_InvalidateDCache_by_Addr(req->buf, (int32_t)bytes);
+            }
+        }
+        else
+        {
+            g_sdBlkStatus.bytes_written += bytes;
+        }
+        g_sdBlkLatencySum += us;
+        g_sdBlkStatus.latency_avg_us = (uint32_t)(g_sdBlkLatencySum / g_sdBlkStatus.requests_done);
+        if (us > g_sdBlkStatus.latency_max_us)
+        {
+            g_sdBlkStatus.latency_max_us = us;
+        }
+    }
+
+    g_sdBlkState = SDBLK_IDLE;
+    SdBlk_StartNext();
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        if (cbs[i] != NULL)
+        {
+            cbs[i](ctxs[i], result);
+        }
+    }
+}
+
+/**
+ * @brief SDMMC1 interrupt.
+ *
+ * - APP, ERASE: end of CMD55 and ACMD23, then the data command.
+ * - DATA: IDMABTC refills the free list item, DATAEND or an error sends
+ *   CMD12.
+ * - STOP: end of CMD12, then the end of busy after a write.
+ * - BUSY: BUSYD0END, the run is over.
+ *
+ * @param[in] ctx Unused.
+ */
+static void SdBlk_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t sta = READ_REG(SDBLK_INSTANCE->STA);
+    uint32_t flags = sta & (READ_REG(SDBLK_INSTANCE->MASK) | SDMMC_STA_IDMATE);
+
+    g_sdBlkStatus.irqs++;
+    WRITE_REG(SDBLK_INSTANCE->ICR, flags & SDBLK_CLEAR_ALL);
+
+    switch (g_sdBlkState)
+    {
+    case SDBLK_APP:
+    case SDBLK_ERASE:
+        if ((flags & (SDMMC_STA_CCRCFAIL | SDMMC_STA_CTIMEOUT)) != 0U)
+        {
+            g_sdBlkResult = SDBLK_ERR_CMD;
+            SdBlk_Finish();
+        }
+        else if ((flags & SDMMC_STA_CMDREND) != 0U)
+        {
+            if (g_sdBlkState == SDBLK_APP)
+            {
+                uint32_t count = g_sdBlkRunErase;
+                g_sdBlkState = SDBLK_ERASE;
+                g_sdBlkStatus.pre_erases++;
+                SdBlk_Issue(SDBLK_CMD_APP_ERASE_COUNT, (count < SDBLK_ERASE_COUNT_MAX) ? count : SDBLK_ERASE_COUNT_MAX, 0U,
+                            SDBLK_CMD_FLAGS);
+            }
+            else
+            {
+                SdBlk_StartData();
+            }
+        }
+        break;
+
+    case SDBLK_DATA:
+        if ((flags & SDMMC_STA_IDMABTC) != 0U)
+        {
+            g_sdBlkStatus.segments++;
+            if (g_sdBlkSegFill < g_sdBlkSegTotal)
+            {
+                /* The item the running buffer was loaded from is free again */
+                SdBlk_FillNode((g_sdBlkSegFill - 1U) & 1U);
+            }
+        }
+        if ((flags & (SDMMC_STA_CCRCFAIL | SDMMC_STA_CTIMEOUT)) != 0U)
+        {
+            SdBlk_Stop(SDBLK_ERR_CMD);
+        }
+        else if ((flags & SDMMC_STA_IDMATE) != 0U)
+        {
+            SdBlk_Stop(SDBLK_ERR_DMA);
+        }
+        else if ((flags & SDBLK_DATA_ERRORS) != 0U)
+        {
+            SdBlk_Stop(SDBLK_ERR_DATA);
+        }
+        else if (((flags & SDMMC_STA_CMDREND) != 0U) &&
+                 ((READ_REG(SDBLK_INSTANCE->RESP1) & SDBLK_R1_ERRORS) != 0U))
+        {
+            /* The card refused the command, no data will come */
+            SdBlk_Stop(SDBLK_ERR_CARD);
+        }
+        else if ((flags & SDMMC_STA_DATAEND) != 0U)
+        {
+            SdBlk_Stop(SDBLK_OK);
+        }
+        break;
+
+    case SDBLK_STOP:
+        if ((flags & (SDMMC_STA_CCRCFAIL | SDMMC_STA_CTIMEOUT)) != 0U)
+        {
+            if (g_sdBlkResult == SDBLK_OK)
+            {
+                g_sdBlkResult = SDBLK_ERR_CMD;
+            }
+            SdBlk_Finish();
+        }
+        else if ((flags & SDMMC_STA_CMDREND) != 0U)
+        {
+            if (((sta & SDMMC_STA_BUSYD0) != 0U) && ((flags & SDMMC_STA_BUSYD0END) == 0U))
+            {
+                g_sdBlkState = SDBLK_BUSY;
+                WRITE_REG(SDBLK_INSTANCE->MASK, SDMMC_MASK_BUSYD0ENDIE);
+            }
+            else
+            {
+                SdBlk_Finish();
+            }
+        }
+        break;
+
+    case SDBLK_BUSY:
+        if ((flags & SDMMC_STA_BUSYD0END) != 0U)
+        {
+            SdBlk_Finish();
+        }
+        break;
+
+    default:
+        WRITE_REG(SDBLK_INSTANCE->MASK, 0U);
+        break;
+    }
+}
+
+/**
+ * @brief Completion callback of the blocking calls.
+ *
+ * Runs from an interrupt, so the notification uses the ISR API.
+ *
+ * @param[in] ctx    Handle of the waiting task.
+ * @param[in] result Request outcome.
+ */
+static void SdBlk_WakeWaiter(void *ctx, SdBlk_Result_T result)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, SDBLK_NOTIFY_INDEX, (uint32_t)result, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, SDBLK_NOTIFY_INDEX, (uint32_t)result, eSetValueWithOverwrite);
+    }
+}
+
+/** @} */ // end of SdBlk group
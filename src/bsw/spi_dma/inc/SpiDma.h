@@ -0,0 +1,170 @@
+/**
+ * @file SpiDma.h
+ * @brief Full-duplex SPI master driver with a DMA transaction queue
+ *
+ * SPI1 runs as a master with one GPDMA1 channel per direction. Callers
+ * queue transactions, each naming the device it addresses: chip select
+ * pin, clock mode, bit order and highest clock rate belong to the device,
+ * buffers and size to the transaction. Chip selects are driven by
+ * software, low while a device is addressed.
+ *
+ * A transaction flagged ::SPIDMA_XFER_KEEP_CS leaves its device selected,
+ * so the next one continues the same frame (command then data, register
+ * address then burst). Such sequences already queued when the first one
+ * starts run as one transfer: each transaction is an item of the linked
+ * lists of both channels, so the SPI clock does not stop between them.
+ * Other transactions start from the DMA interrupt of the previous one.
+ *
+ * Completion callbacks run from the DMA interrupt, in queue order, once
+ * the last byte of the transaction has been received. Cache maintenance is
+ * done by the driver, except for buffers in the non-cacheable DMA pool.
+ */
+
+#ifndef SPI_DMA_H
+#define SPI_DMA_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef SPIDMA_QUEUE_LEN
+#define SPIDMA_QUEUE_LEN (16U) /**< Transactions waiting behind the running ones */
+#endif
+
+#ifndef SPIDMA_MAX_CHAIN
+#define SPIDMA_MAX_CHAIN (8U) /**< Transactions run as one transfer */
+#endif
+
+#define SPIDMA_MAX_XFER (0xFFFFU)    /**< Bytes of one transfer, CR2.TSIZE */
+#define SPIDMA_FILL_BYTE (0xFFU)     /**< Sent when a transaction has no TX buffer */
+#define SPIDMA_NOTIFY_INDEX (1U)     /**< Task notification index used by ::SpiDma_TransferWait */
+
+#define SPIDMA_XFER_KEEP_CS (1U << 0) /**< Leave the device selected after the transaction */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Device on the bus.
+ *
+ * Referenced by the transactions, must stay valid while they are queued.
+ */
+typedef struct
+{
+    GPIO_TypeDef *cs_port; /**< Port of the chip select pin */
+    uint32_t cs_pin;       /**< Chip select pin, LL_GPIO_PIN_x */
+    uint8_t mode;          /**< SPI mode 0 to 3: CPOL in bit 1, CPHA in bit 0 */
+    bool lsb_first;        /**< Shift the least significant bit first */
+    uint32_t max_hz;       /**< Highest SCK rate the device accepts */
+} SpiDma_Device_T;
+
+/**
+ * @brief Transaction completion callback.
+ *
+ * Runs from the DMA interrupt. The driver no longer references the
+ * buffers once it runs, and it may queue the next transaction.
+ *
+ * @param[in] ctx     Context given with the transaction.
+ * @param[in] success false if the transaction was dropped on a DMA error or an overrun.
+ */
+typedef void (*SpiDma_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief Transaction.
+ */
+typedef struct
+{
+    const SpiDma_Device_T *dev; /**< Device addressed */
+    const void *tx;             /**< Bytes to send, NULL sends ::SPIDMA_FILL_BYTE */
+    void *rx;                   /**< Bytes received, NULL discards them */
+    uint16_t size;              /**< Bytes each way */
+    uint8_t flags;              /**< SPIDMA_XFER_x */
+    SpiDma_Callback_T cb;       /**< Completion callback, may be NULL */
+    void *ctx;                  /**< Passed unchanged to @ref cb */
+} SpiDma_Xfer_T;
+
+/**
+ * @brief Driver counters.
+ */
+typedef struct
+{
+    uint32_t xfers_done;   /**< Transactions completed */
+    uint32_t xfers_failed; /**< Transactions dropped */
+    uint64_t bytes;        /**< Bytes exchanged by completed transactions */
+    uint32_t runs;         /**< Transfers started on the SPI */
+    uint32_t chained;      /**< Transactions that followed another without stopping the clock */
+    uint32_t queue_peak;   /**< Largest number of waiting transactions */
+    uint32_t queue_full;   /**< Submissions rejected on a full queue */
+    uint32_t errors;       /**< Transfers aborted on a DMA error or an overrun */
+    uint32_t actual_hz;    /**< SCK rate of the last transfer */
+    uint32_t busy_cycles;  /**< CPU cycles the SPI spent in transfers */
+} SpiDma_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Enable SPI1 and its pins and take the two DMA channels.
+ *
+ * @retval true  Driver ready.
+ * @retval false No DMA channel or interrupt available.
+ */
+bool SpiDma_Init(void);
+
+/**
+ * @brief Set up the chip select pin of a device, deselected.
+ *
+ * @param[in] dev Device to prepare.
+ *
+ * @retval true  Pin configured.
+ * @retval false Invalid device.
+ */
+bool SpiDma_InitDevice(const SpiDma_Device_T *dev);
+
+/**
+ * @brief Queue a transaction.
+ *
+ * The transaction is copied, the buffers are used in place until its
+ * callback runs.
+ *
+ * @param[in] xfer Transaction to queue.
+ *
+ * @retval true  Queued or started.
+ * @retval false Invalid transaction or queue full.
+ */
+bool SpiDma_Submit(const SpiDma_Xfer_T *xfer);
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ *
+ * Waits on task notification index ::SPIDMA_NOTIFY_INDEX. The master
+ * always finishes a transfer, so there is no timeout; a full queue is
+ * retried every tick.
+ *
+ * @param[in]  dev   Device addressed.
+ * @param[in]  tx    Bytes to send, NULL sends ::SPIDMA_FILL_BYTE.
+ * @param[out] rx    Bytes received, NULL discards them.
+ * @param[in]  size  Bytes each way.
+ * @param[in]  flags SPIDMA_XFER_x.
+ *
+ * @retval true  Transaction completed.
+ * @retval false Invalid parameters or transaction dropped.
+ */
+bool SpiDma_TransferWait(const SpiDma_Device_T *dev, const void *tx, void *rx, uint16_t size, uint8_t flags);
+
+/**
+ * @brief SCK rate a device runs at.
+ *
+ * @return Fastest rate of the prescaler not above the device maximum, 0
+ *         before ::SpiDma_Init.
+ */
+uint32_t SpiDma_GetDeviceHz(const SpiDma_Device_T *dev);
+
+/**
+ * @brief Copy the driver counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void SpiDma_GetStatus(SpiDma_Status_T *status);
+
+#endif /* SPI_DMA_H */
@@ -0,0 +1,777 @@
+/**
+ * @file SpiDma.c
+ * @brief Implementation of the SPI DMA transaction queue.
+ * @ingroup SpiDma
+ * @{
+ *
+ * Transactions wait in a ring. A run takes the oldest one and the
+ * KEEP_CS sequence behind it, writes one linked-list item per transaction
+ * for each channel and starts the SPI for the total size, so the clock
+ * runs from the first byte of the run to the last one without the CPU.
+ *
+ * The receive channel raises TC at the end of every item and drives the
+ * completions: a transaction has been exchanged once its last byte is in
+ * memory. The number of finished items is read from the channel rather
+ * than counted from interrupts, so a late interrupt covering two items
+ * completes both. The transmit channel only reports errors.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SpiDma.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "DmaAlloc.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_spi.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SPIDMA_INSTANCE SPI1                /**< SPI instance used */
+#define SPIDMA_PINS_PORT GPIOA              /**< Port of SCK, MISO and MOSI */
+#define SPIDMA_PINS (LL_GPIO_PIN_5 | LL_GPIO_PIN_6 | LL_GPIO_PIN_7) /**< SCK, MISO and MOSI */
+#define SPIDMA_PINS_AF LL_GPIO_AF_5         /**< Alternate function of SPI1 */
+#define SPIDMA_LLI_ALIGN (256U)             /**< Keeps an item table inside one 64 KiB linked-list window */
+#define SPIDMA_LLI_UPDATE (LL_DMA_UPDATE_CTR1 | LL_DMA_UPDATE_CTR2 | LL_DMA_UPDATE_CBR1 | \
+                           LL_DMA_UPDATE_CSAR | LL_DMA_UPDATE_CDAR | LL_DMA_UPDATE_CLLR) /**< Registers loaded per item */
+#define SPIDMA_DMA_ERRORS (DMA_CSR_DTEF | DMA_CSR_ULEF | DMA_CSR_USEF) /**< Flags ending a run in error */
+#define SPIDMA_SUSPEND_SPIN_LIMIT (10000U)  /**< Polls of a suspend flag before stopping anyway */
+#define SPIDMA_WAIT_DONE (1U)               /**< Waiter notification value: transaction complete */
+#define SPIDMA_WAIT_FAILED (2U)             /**< Waiter notification value: transaction dropped */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Linked-list item of a linear channel, in register load order.
+ */
+typedef struct
+{
+    uint32_t ctr1;
+    uint32_t ctr2;
+    uint32_t cbr1;
+    uint32_t csar;
+    uint32_t cdar;
+    uint32_t cllr;
+} SpiDma_Lli_T;
+
+#if ((SPIDMA_MAX_CHAIN * 6U * 4U) > SPIDMA_LLI_ALIGN)
+#error "SPIDMA_LLI_ALIGN must cover the linked-list item tables"
+#endif
+
+/* Global Variables ----------------------------------------------------------*/
+/** Transmit items of the run, one per transaction. */
+static SpiDma_Lli_T g_spiDmaTxLli[SPIDMA_MAX_CHAIN]
+    __attribute__((section("noncacheable_buffer"), aligned(SPIDMA_LLI_ALIGN)));
+/** Receive items of the run, one per transaction. */
+static SpiDma_Lli_T g_spiDmaRxLli[SPIDMA_MAX_CHAIN]
+    __attribute__((section("noncacheable_buffer"), aligned(SPIDMA_LLI_ALIGN)));
+/** Source of transactions without a TX buffer. */
+static uint8_t g_spiDmaFill __attribute__((section("noncacheable_buffer")));
+/** Destination of transactions without an RX buffer. */
+static uint8_t g_spiDmaSink __attribute__((section("noncacheable_buffer")));
+/** Transmit channel. */
+static DmaAlloc_Channel_T g_spiDmaTxChannel = {0};
+/** Receive channel. */
+static DmaAlloc_Channel_T g_spiDmaRxChannel = {0};
+/** Transactions waiting to run. */
+static SpiDma_Xfer_T g_spiDmaQueue[SPIDMA_QUEUE_LEN];
+/** Index of the oldest waiting transaction. */
+static uint32_t g_spiDmaHead = 0U;
+/** Waiting transactions. */
+static uint32_t g_spiDmaCount = 0U;
+/** Transactions of the run on the SPI. */
+static SpiDma_Xfer_T g_spiDmaRun[SPIDMA_MAX_CHAIN];
+/** Transactions in ::g_spiDmaRun. */
+static uint32_t g_spiDmaRunCount = 0U;
+/** Transactions of the run already completed. */
+static uint32_t g_spiDmaRunDone = 0U;
+/** A run is on the SPI. */
+static volatile bool g_spiDmaRunning = false;
+/** Device left selected by a KEEP_CS transaction, NULL if none. */
+static const SpiDma_Device_T *g_spiDmaHeld = NULL;
+/** SPI kernel clock. */
+static uint32_t g_spiDmaKernelHz = 0U;
+/** CYCCNT when the current run started. */
+static uint32_t g_spiDmaStartCycles = 0U;
+/** Counters reported by ::SpiDma_GetStatus. */
+static SpiDma_Status_T g_spiDmaStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Configure SCK, MISO and MOSI. */
+static void SpiDma_InitGpio(void);
+/** Take and configure one DMA channel. */
+static bool SpiDma_InitChannel(DmaAlloc_Channel_T *channel, const SpiDma_Lli_T *table, DmaAlloc_Class_T prio,
+                               const char *owner, void (*handler)(void *ctx));
+/** Start the next run, if any. Interrupts masked or from the DMA interrupt. */
+static void SpiDma_StartRun(void);
+/** Stop the SPI and both channels and complete the run. */
+static void SpiDma_FinishRun(bool success);
+/** Complete the transactions the receive channel has finished. */
+static void SpiDma_Complete(uint32_t done);
+/** Transactions of the run finished by the receive channel. */
+static uint32_t SpiDma_ItemsDone(void);
+/** Stop a channel after a failure. */
+static void SpiDma_ResetChannel(const DmaAlloc_Channel_T *channel);
+/** Prescaler bits of CFG1 for a device. */
+static uint32_t SpiDma_Prescaler(uint32_t maxHz, uint32_t *actualHz);
+/** Report a finished transaction to its owner. */
+static void SpiDma_Report(const SpiDma_Xfer_T *xfer, bool success);
+/** Receive channel interrupt, bound through the DMA allocator. */
+static void SpiDma_RxIrqHandler(void *ctx);
+/** Transmit channel interrupt, bound through the DMA allocator. */
+static void SpiDma_TxIrqHandler(void *ctx);
+/** SPI interrupt, bound through the ISR manager. */
+static void SpiDma_SpiIrqHandler(void *ctx);
+/** Completion callback of ::SpiDma_TransferWait. */
+static void SpiDma_WakeWaiter(void *ctx, bool success);
+/** Register block of a channel. */
+static DMA_Channel_TypeDef *SpiDma_Regs(const DmaAlloc_Channel_T *channel);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Enable SPI1 and its pins and take the two DMA channels.
+ *
+ * Receive runs in a higher class than transmit, so the receive FIFO is
+ * drained before the transmit FIFO is refilled and cannot overrun. The
+ * SPI interrupt only reports overruns.
+ */
+bool SpiDma_Init(void)
+{
+    SpiDma_InitGpio();
+    LL_APB2_GRP1_EnableClock(LL_APB2_GRP1_PERIPH_SPI1);
+    LL_RCC_SetSPIClockSource(LL_RCC_SPI1_CLKSOURCE_PCLK2);
+    g_spiDmaKernelHz = LL_RCC_GetSPIClockFreq(LL_RCC_SPI1_CLKSOURCE);
+    g_spiDmaFill = SPIDMA_FILL_BYTE;
+
+    if (!SpiDma_InitChannel(&g_spiDmaRxChannel, g_spiDmaRxLli, DMAALLOC_CLASS_STREAM, "SpiDma rx",
+                            SpiDma_RxIrqHandler) ||
+        !SpiDma_InitChannel(&g_spiDmaTxChannel, g_spiDmaTxLli, DMAALLOC_CLASS_NORMAL, "SpiDma tx",
+                            SpiDma_TxIrqHandler))
+    {
+        return false;
+    }
+    LL_DMA_EnableIT_TC(g_spiDmaRxChannel.instance, g_spiDmaRxChannel.channel);
+
+    if (!IsrMgr_Register(SPI1_IRQn, SpiDma_SpiIrqHandler, NULL))
+    {
+        return false;
+    }
+    WRITE_REG(SPIDMA_INSTANCE->CR1, SPI_CR1_SSI);
+    WRITE_REG(SPIDMA_INSTANCE->IER, SPI_IER_OVRIE);
+    NVIC_SetPriority(SPI1_IRQn, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                    configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(SPI1_IRQn);
+    return true;
+}
+
+/**
+ * @brief Set up the chip select pin of a device, deselected.
+ *
+ * The pin is driven high before it becomes an output, so the device never
+ * sees a select pulse.
+ */
+bool SpiDma_InitDevice(const SpiDma_Device_T *dev)
+{
+    if ((dev == NULL) || (dev->cs_port == NULL) || (dev->mode > 3U))
+    {
+        return false;
+    }
+
+    /* The enable bits of the GPIO ports follow their address order */
+    LL_AHB4_GRP1_EnableClock(1UL << (((uint32_t)(uintptr_t)dev->cs_port - GPIOA_BASE) / 0x400U));
+    LL_GPIO_SetOutputPin(dev->cs_port, dev->cs_pin);
+
+    LL_GPIO_InitTypeDef gpio_h;
+    gpio_h.Pin = dev->cs_pin;
+    gpio_h.Mode = LL_GPIO_MODE_OUTPUT;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_HIGH;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = LL_GPIO_PULL_NO;
+    gpio_h.Alternate = LL_GPIO_AF_0;
+    LL_GPIO_Init(dev->cs_port, &gpio_h);
+    return true;
+}
+
+/**
+ * @brief Queue a transaction.
+ *
+ * Cache maintenance runs in the caller: the TX buffer is cleaned, the RX
+ * buffer cleaned and invalidated so no dirty line can be evicted over the
+ * received bytes.
+ */
+bool SpiDma_Submit(const SpiDma_Xfer_T *xfer)
+{
+    if ((xfer == NULL) || (xfer->dev == NULL) || (xfer->dev->cs_port == NULL) || (xfer->dev->mode > 3U) ||
+        (xfer->size == 0U))
+    {
+        return false;
+    }
+
+    if ((xfer->tx != NULL) && !DmaPool_IsNonCacheable(xfer->tx, xfer->size))
+    {
+        SCB_CleanDCache_by_Addr((void *)xfer->tx, (int32_t)xfer->size);
+    }
+    if ((xfer->rx != NULL) && !DmaPool_IsNonCacheable(xfer->rx, xfer->size))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(xfer->rx, (int32_t)xfer->size);
+    }
+
+    bool queued = true;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_spiDmaCount < SPIDMA_QUEUE_LEN)
+    {
+        g_spiDmaQueue[(g_spiDmaHead + g_spiDmaCount) % SPIDMA_QUEUE_LEN] = *xfer;
+        g_spiDmaCount++;
+        if (!g_spiDmaRunning)
+        {
+            SpiDma_StartRun();
+        }
+        if (g_spiDmaCount > g_spiDmaStatus.queue_peak)
+        {
+            g_spiDmaStatus.queue_peak = g_spiDmaCount;
+        }
+    }
+    else
+    {
+        g_spiDmaStatus.queue_full++;
+        queued = false;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Run a transaction and block the calling task until it completes.
+ */
+bool SpiDma_TransferWait(const SpiDma_Device_T *dev, const void *tx, void *rx, uint16_t size, uint8_t flags)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+    const SpiDma_Xfer_T xfer = {
+        .dev = dev,
+        .tx = tx,
+        .rx = rx,
+        .size = size,
+        .flags = flags,
+        .cb = SpiDma_WakeWaiter,
+        .ctx = self,
+    };
+
+    if ((dev == NULL) || (size == 0U))
+    {
+        return false;
+    }
+
+    xTaskNotifyStateClearIndexed(self, SPIDMA_NOTIFY_INDEX);
+    while (!SpiDma_Submit(&xfer))
+    {
+        vTaskDelay(1);
+    }
+    (void)xTaskNotifyWaitIndexed(SPIDMA_NOTIFY_INDEX, 0U, UINT32_MAX, &value, portMAX_DELAY);
+
+    return value == SPIDMA_WAIT_DONE;
+}
+
+/**
+ * @brief SCK rate a device runs at.
+ */
+uint32_t SpiDma_GetDeviceHz(const SpiDma_Device_T *dev)
+{
+    uint32_t hz = 0U;
+
+    if (dev != NULL)
+    {
+        (void)SpiDma_Prescaler(dev->max_hz, &hz);
+    }
+    return hz;
+}
+
+/**
+ * @brief Copy the driver counters into @p status.
+ */
+void SpiDma_GetStatus(SpiDma_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_spiDmaStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Configure SCK, MISO and MOSI in alternate function mode.
+ */
+static void SpiDma_InitGpio(void)
+{
+    LL_GPIO_InitTypeDef gpio_h;
+
+    LL_AHB4_GRP1_EnableClock(LL_AHB4_GRP1_PERIPH_GPIOA);
+
+    gpio_h.Pin = SPIDMA_PINS;
+    gpio_h.Mode = LL_GPIO_MODE_ALTERNATE;
+    gpio_h.Speed = LL_GPIO_SPEED_FREQ_VERY_HIGH;
+    gpio_h.OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    gpio_h.Pull = LL_GPIO_PULL_NO;
+    gpio_h.Alternate = SPIDMA_PINS_AF;
+    LL_GPIO_Init(SPIDMA_PINS_PORT, &gpio_h);
+}
+
+/**
+ * @brief Take a GPDMA1 channel able to run linked lists and configure it.
+ *
+ * Items are fetched through port 0 and the whole list runs without
+ * stopping between items.
+ */
+static bool SpiDma_InitChannel(DmaAlloc_Channel_T *channel, const SpiDma_Lli_T *table, DmaAlloc_Class_T prio,
+                               const char *owner, void (*handler)(void *ctx))
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = prio,
+        .caps = DMAALLOC_CAP_LINKED_LIST,
+        .burst_bytes = 0U,
+        .owner = owner,
+        .handler = handler,
+        .ctx = NULL,
+    };
+
+    if (!DmaAlloc_Request(&request, channel))
+    {
+        return false;
+    }
+
+    LL_DMA_ConfigControl(channel->instance, channel->channel,
+                         channel->priority | LL_DMA_LINK_ALLOCATED_PORT0 | LL_DMA_LSM_FULL_EXECUTION);
+    LL_DMA_SetLinkedListBaseAddr(channel->instance, channel->channel, (uint32_t)table);
+    LL_DMA_EnableIT_DTE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_ULE(channel->instance, channel->channel);
+    LL_DMA_EnableIT_USE(channel->instance, channel->channel);
+    NVIC_SetPriority(channel->irq, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                       configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(channel->irq);
+    return true;
+}
+
+/**
+ * @brief Start the next run, if any.
+ *
+ * The SPI is configured for the device while disabled, the device is
+ * selected, then the sequence of the reference manual is followed: RX
+ * requests and both channels first, TX requests, SPE and CSTART last.
+ */
+static void SpiDma_StartRun(void)
+{
+    if (g_spiDmaCount == 0U)
+    {
+        g_spiDmaRunning = false;
+        return;
+    }
+
+    uint32_t count = 0U;
+    uint32_t total = 0U;
+    do
+    {
+        const SpiDma_Xfer_T *next = &g_spiDmaQueue[g_spiDmaHead];
+        if ((count != 0U) && (((g_spiDmaRun[count - 1U].flags & SPIDMA_XFER_KEEP_CS) == 0U) ||
+                              (next->dev != g_spiDmaRun[0].dev) || ((total + next->size) > SPIDMA_MAX_XFER)))
+        {
+            break;
+        }
+
+        SpiDma_Xfer_T *xfer = &g_spiDmaRun[count];
+        SpiDma_Lli_T *tx = &g_spiDmaTxLli[count];
+        SpiDma_Lli_T *rx = &g_spiDmaRxLli[count];
+        *xfer = *next;
+        g_spiDmaHead = (g_spiDmaHead + 1U) % SPIDMA_QUEUE_LEN;
+        g_spiDmaCount--;
+
+        tx->ctr1 = ((xfer->tx != NULL) ? LL_DMA_SRC_INCREMENT : 0U) | LL_DMA_SRC_DATAWIDTH_BYTE |
+                   LL_DMA_DEST_DATAWIDTH_BYTE;
+        tx->ctr2 = LL_GPDMA1_REQUEST_SPI1_TX | LL_DMA_DIRECTION_MEMORY_TO_PERIPH | LL_DMA_TCEM_LAST_LLITEM_TRANSFER;
+        tx->cbr1 = xfer->size;
+        tx->csar = (xfer->tx != NULL) ? (uint32_t)xfer->tx : (uint32_t)&g_spiDmaFill;
+        tx->cdar = (uint32_t)&SPIDMA_INSTANCE->TXDR;
+        tx->cllr = 0U;
+
+        rx->ctr1 = ((xfer->rx != NULL) ? LL_DMA_DEST_INCREMENT : 0U) | LL_DMA_SRC_DATAWIDTH_BYTE |
+                   LL_DMA_DEST_DATAWIDTH_BYTE;
+        rx->ctr2 = LL_GPDMA1_REQUEST_SPI1_RX | LL_DMA_DIRECTION_PERIPH_TO_MEMORY | LL_DMA_TCEM_BLK_TRANSFER;
+        rx->cbr1 = xfer->size;
+        rx->csar = (uint32_t)&SPIDMA_INSTANCE->RXDR;
+        rx->cdar = (xfer->rx != NULL) ? (uint32_t)xfer->rx : (uint32_t)&g_spiDmaSink;
+        rx->cllr = 0U;
+
+        if (count != 0U)
+        {
+            g_spiDmaTxLli[count - 1U].cllr = SPIDMA_LLI_UPDATE | ((uint32_t)tx & DMA_CLLR_LA);
+            g_spiDmaRxLli[count - 1U].cllr = SPIDMA_LLI_UPDATE | ((uint32_t)rx & DMA_CLLR_LA);
+        }
+        total += xfer->size;
+        count++;
+    } while ((g_spiDmaCount != 0U) && (count < SPIDMA_MAX_CHAIN));
+
+    const SpiDma_Device_T *dev = g_spiDmaRun[0].dev;
+    uint32_t hz = 0U;
+    uint32_t cfg2 = SPI_CFG2_AFCNTR | LL_SPI_MODE_MASTER | LL_SPI_NSS_SOFT |
+                    (((dev->mode & 2U) != 0U) ? LL_SPI_POLARITY_HIGH : LL_SPI_POLARITY_LOW) |
+                    (((dev->mode & 1U) != 0U) ? LL_SPI_PHASE_2EDGE : LL_SPI_PHASE_1EDGE) |
+                    (dev->lsb_first ? LL_SPI_LSB_FIRST : LL_SPI_MSB_FIRST);
+    uint32_t cfg1 = SpiDma_Prescaler(dev->max_hz, &hz) | LL_SPI_DATAWIDTH_8BIT;
+
+    g_spiDmaRunCount = count;
+    g_spiDmaRunDone = 0U;
+    g_spiDmaRunning = true;
+    g_spiDmaStatus.runs++;
+    g_spiDmaStatus.chained += count - 1U;
+    g_spiDmaStatus.actual_hz = hz;
+
+    if ((g_spiDmaHeld != NULL) && (g_spiDmaHeld != dev))
+    {
+        LL_GPIO_SetOutputPin(g_spiDmaHeld->cs_port, g_spiDmaHeld->cs_pin);
+    }
+    g_spiDmaHeld = NULL;
+
+    /* Clock polarity must settle before the device is selected */
+    WRITE_REG(SPIDMA_INSTANCE->CFG2, cfg2);
+    WRITE_REG(SPIDMA_INSTANCE->CFG1, cfg1 | SPI_CFG1_RXDMAEN);
+    WRITE_REG(SPIDMA_INSTANCE->CR2, total);
+    LL_GPIO_ResetOutputPin(dev->cs_port, dev->cs_pin);
+
+    const DmaAlloc_Channel_T *const channel[2] = {&g_spiDmaRxChannel, &g_spiDmaTxChannel};
+    const SpiDma_Lli_T *const first[2] = {&g_spiDmaRxLli[0], &g_spiDmaTxLli[0]};
+    for (uint32_t i = 0U; i < 2U; i++)
+    {
+        DMA_Channel_TypeDef *regs = SpiDma_Regs(channel[i]);
+        WRITE_REG(regs->CTR1, first[i]->ctr1);
+        WRITE_REG(regs->CTR2, first[i]->ctr2);
+        WRITE_REG(regs->CBR1, first[i]->cbr1);
+        WRITE_REG(regs->CSAR, first[i]->csar);
+        WRITE_REG(regs->CDAR, first[i]->cdar);
+        WRITE_REG(regs->CLLR, first[i]->cllr);
+        DmaAlloc_NoteStart(channel[i], total);
+    }
+    __DMB();
+    LL_DMA_EnableChannel(g_spiDmaRxChannel.instance, g_spiDmaRxChannel.channel);
+    LL_DMA_EnableChannel(g_spiDmaTxChannel.instance, g_spiDmaTxChannel.channel);
+
+    g_spiDmaStartCycles = DWT->CYCCNT;
+    WRITE_REG(SPIDMA_INSTANCE->CFG1, cfg1 | SPI_CFG1_RXDMAEN | SPI_CFG1_TXDMAEN);
+    WRITE_REG(SPIDMA_INSTANCE->CR1, SPI_CR1_SSI | SPI_CR1_SPE);
+    WRITE_REG(SPIDMA_INSTANCE->CR1, SPI_CR1_SSI | SPI_CR1_SPE | SPI_CR1_CSTART);
+}
+
+/**
+ * @brief Stop the SPI and both channels and complete the run.
+ *
+ * The next run is started before the callbacks of this one, so the SPI
+ * waits for the CPU only while the queue is empty.
+ *
+ * @param[in] success false to drop the transactions not yet completed.
+ */
+static void SpiDma_FinishRun(bool success)
+{
+    SpiDma_Xfer_T done[SPIDMA_MAX_CHAIN];
+    uint32_t first = g_spiDmaRunDone;
+    uint32_t count = g_spiDmaRunCount;
+
+    if (success)
+    {
+        DmaAlloc_NoteStop(&g_spiDmaTxChannel);
+    }
+    else
+    {
+        if ((READ_REG(SPIDMA_INSTANCE->CR1) & SPI_CR1_CSTART) != 0U)
+        {
+            uint32_t spin = SPIDMA_SUSPEND_SPIN_LIMIT;
+            SET_BIT(SPIDMA_INSTANCE->CR1, SPI_CR1_CSUSP);
+            while ((LL_SPI_IsActiveFlag_SUSP(SPIDMA_INSTANCE) == 0U) && (spin > 0U))
+            {
+                spin--;
+            }
+        }
+        SpiDma_ResetChannel(&g_spiDmaRxChannel);
+        SpiDma_ResetChannel(&g_spiDmaTxChannel);
+        g_spiDmaStatus.errors++;
+    }
+
+    WRITE_REG(SPIDMA_INSTANCE->IFCR, SPI_IFCR_EOTC | SPI_IFCR_TXTFC | SPI_IFCR_OVRC | SPI_IFCR_SUSPC);
+    WRITE_REG(SPIDMA_INSTANCE->CR1, SPI_CR1_SSI);
+    CLEAR_BIT(SPIDMA_INSTANCE->CFG1, SPI_CFG1_RXDMAEN | SPI_CFG1_TXDMAEN);
+    g_spiDmaStatus.busy_cycles += DWT->CYCCNT - g_spiDmaStartCycles;
+
+    const SpiDma_Xfer_T *last = &g_spiDmaRun[count - 1U];
+    if (success && ((last->flags & SPIDMA_XFER_KEEP_CS) != 0U))
+    {
+        g_spiDmaHeld = last->dev;
+    }
+    else
+    {
+        LL_GPIO_SetOutputPin(last->dev->cs_port, last->dev->cs_pin);
+    }
+
+    for (uint32_t i = first; i < count; i++)
+    {
+        done[i - first] = g_spiDmaRun[i];
+    }
+    g_spiDmaRunning = false;
+    SpiDma_StartRun();
+
+    for (uint32_t i = 0U; i < (count - first); i++)
+    {
+        SpiDma_Report(&done[i], success);
+    }
+}
+
+/**
+ * @brief Complete the transactions of the run up to @p done.
+ *
+ * Used while the run goes on: the run table is not rewritten before the
+ * run ends, so the callbacks read it in place.
+ */
+static void SpiDma_Complete(uint32_t done)
+{
+    while (g_spiDmaRunDone < done)
+    {
+        SpiDma_Report(&g_spiDmaRun[g_spiDmaRunDone], true);
+        g_spiDmaRunDone++;
+    }
+}
+
+/**
+ * @brief Transactions of the run the receive channel has finished.
+ *
+ * While item k runs, CLLR links to item k + 1, or is zero on the last
+ * item; a disabled channel has run every item.
+ */
+static uint32_t SpiDma_ItemsDone(void)
+{
+    if (LL_DMA_IsEnabledChannel(g_spiDmaRxChannel.instance, g_spiDmaRxChannel.channel) == 0U)
+    {
+        return g_spiDmaRunCount;
+    }
+
+    uint32_t la = READ_REG(SpiDma_Regs(&g_spiDmaRxChannel)->CLLR) & DMA_CLLR_LA;
+    if (la == 0U)
+    {
+        return g_spiDmaRunCount - 1U;
+    }
+    return ((la - ((uint32_t)&g_spiDmaRxLli[0] & DMA_CLLR_LA)) / sizeof(SpiDma_Lli_T)) - 1U;
+}
+
+/**
+ * @brief Stop a channel after a failure.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway.
+ */
+static void SpiDma_ResetChannel(const DmaAlloc_Channel_T *channel)
+{
+    if (LL_DMA_IsEnabledChannel(channel->instance, channel->channel) != 0U)
+    {
+        uint32_t spin = SPIDMA_SUSPEND_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(channel->instance, channel->channel);
+        while ((LL_DMA_IsActiveFlag_SUSP(channel->instance, channel->channel) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(channel->instance, channel->channel);
+    DmaAlloc_NoteStop(channel);
+    WRITE_REG(SpiDma_Regs(channel)->CFCR, DMA_CFCR_TCF | DMA_CFCR_HTF | DMA_CFCR_DTEF | DMA_CFCR_ULEF |
+                                              DMA_CFCR_USEF | DMA_CFCR_SUSPF | DMA_CFCR_TOF);
+}
+
+/**
+ * @brief Prescaler bits of CFG1 for the fastest SCK not above @p maxHz.
+ *
+ * The kernel clock is divided by 2 to 256, or used as is through the
+ * bypass. Devices slower than the largest division run at that division.
+ *
+ * @param[in]  maxHz    Highest rate the device accepts.
+ * @param[out] actualHz Resulting SCK rate.
+ */
+static uint32_t SpiDma_Prescaler(uint32_t maxHz, uint32_t *actualHz)
+{
+    if (g_spiDmaKernelHz <= maxHz)
+    {
+        *actualHz = g_spiDmaKernelHz;
+        return LL_SPI_BAUDRATEPRESCALER_BYPASS;
+    }
+
+    uint32_t mbr = 0U;
+    while ((mbr < 7U) && ((g_spiDmaKernelHz >> (mbr + 1U)) > maxHz))
+    {
+        mbr++;
+    }
+    *actualHz = g_spiDmaKernelHz >> (mbr + 1U);
+    return mbr << SPI_CFG1_MBR_Pos;
+}
+
+/**
+ * @brief Report a finished transaction to its owner.
+ *
+ * The received bytes are invalidated again before the callback reads
+ * them, speculative fills may have brought stale lines back.
+ */
+static void SpiDma_Report(const SpiDma_Xfer_T *xfer, bool success)
+{
+    if (success)
+    {
+        if ((xfer->rx != NULL) && !DmaPool_IsNonCacheable(xfer->rx, xfer->size))
+        {
+            SCB_InvalidateDCache_by_Addr(xfer->rx, (int32_t)xfer->size);
+        }
+        g_spiDmaStatus.xfers_done++;
+        g_spiDmaStatus.bytes += xfer->size;
+    }
+    else
+    {
+        g_spiDmaStatus.xfers_failed++;
+    }
+
+    if (xfer->cb != NULL)
+    {
+        xfer->cb(xfer->ctx, success);
+    }
+}
+
+/**
+ * @brief Receive channel interrupt.
+ *
+ * TC marks the end of at least one item: the finished transactions are
+ * completed and, once the channel has stopped, the run. A channel error
+ * drops the run.
+ *
+ * @param[in] ctx Unused.
+ */
+static void SpiDma_RxIrqHandler(void *ctx)
+{
+    (void)ctx;
+    DMA_TypeDef *dma = g_spiDmaRxChannel.instance;
+    uint32_t ch = g_spiDmaRxChannel.channel;
+    uint32_t csr = READ_REG(SpiDma_Regs(&g_spiDmaRxChannel)->CSR);
+
+    if (!g_spiDmaRunning)
+    {
+        WRITE_REG(SpiDma_Regs(&g_spiDmaRxChannel)->CFCR, csr & (DMA_CSR_TCF | DMA_CSR_HTF | SPIDMA_DMA_ERRORS));
+        return;
+    }
+    if ((csr & SPIDMA_DMA_ERRORS) != 0U)
+    {
+        SpiDma_FinishRun(false);
+        return;
+    }
+    if ((csr & DMA_CSR_TCF) == 0U)
+    {
+        return;
+    }
+
+    LL_DMA_ClearFlag_TC(dma, ch);
+    LL_DMA_ClearFlag_HT(dma, ch);
+    uint32_t done = SpiDma_ItemsDone();
+    if (done < g_spiDmaRunCount)
+    {
+        SpiDma_Complete(done);
+    }
+    else
+    {
+        SpiDma_FinishRun(true);
+    }
+}
+
+/**
+ * @brief Transmit channel interrupt, only raised by errors.
+ *
+ * @param[in] ctx Unused.
+ */
+static void SpiDma_TxIrqHandler(void *ctx)
+{
+    (void)ctx;
+    DMA_Channel_TypeDef *regs = SpiDma_Regs(&g_spiDmaTxChannel);
+    uint32_t csr = READ_REG(regs->CSR);
+
+    if ((csr & SPIDMA_DMA_ERRORS) == 0U)
+    {
+        return;
+    }
+    if (g_spiDmaRunning)
+    {
+        SpiDma_FinishRun(false);
+    }
+    else
+    {
+        WRITE_REG(regs->CFCR, csr & SPIDMA_DMA_ERRORS);
+    }
+}
+
+/**
+ * @brief SPI interrupt: a receive overrun drops the run.
+ *
+ * @param[in] ctx Unused.
+ */
+static void SpiDma_SpiIrqHandler(void *ctx)
+{
+    (void)ctx;
+
+    if (LL_SPI_IsActiveFlag_OVR(SPIDMA_INSTANCE) == 0U)
+    {
+        return;
+    }
+    if (g_spiDmaRunning)
+    {
+        SpiDma_FinishRun(false);
+    }
+    else
+    {
+        WRITE_REG(SPIDMA_INSTANCE->IFCR, SPI_IFCR_OVRC);
+    }
+}
+
+/**
+ * @brief Completion callback of ::SpiDma_TransferWait.
+ *
+ * Runs from the DMA interrupt, or from the submitting task when the
+ * transaction fails to start, so the matching notify API is selected.
+ *
+ * @param[in] ctx     Handle of the waiting task.
+ * @param[in] success Transaction outcome.
+ */
+static void SpiDma_WakeWaiter(void *ctx, bool success)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+    uint32_t value = success ? SPIDMA_WAIT_DONE : SPIDMA_WAIT_FAILED;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, SPIDMA_NOTIFY_INDEX, value, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, SPIDMA_NOTIFY_INDEX, value, eSetValueWithOverwrite);
+    }
+}
+
+/**
+ * @brief Register block of a channel.
+ */
+static DMA_Channel_TypeDef *SpiDma_Regs(const DmaAlloc_Channel_T *channel)
+{
+    return (DMA_Channel_TypeDef *)((uint32_t)(uintptr_t)channel->instance + LL_DMA_CH_OFFSET_TAB[channel->channel]);
+}
+
+/** @} */ // end of SpiDma group
@@ -17,18 +17,90 @@
 #include "stm32n6xx_ll_usart.h"
 #include "stm32n6xx_ll_gpio.h"
 #include "stm32n6xx_ll_dma.h"
+#include "FreeRTOS.h"
 
 /* Macros and Defines -------------------------------------------------------*/
+#define UARTDMA_DEFAULT_BAUDRATE (115200U)    /**< Baud rate applied by ::UartDma_Init */
+#define UARTDMA_MAX_BAUD_ERROR_PPM (20000U)   /**< Largest accepted baud rate error (2 %) */
+#define UARTDMA_LATENCY_BINS (16U)            /**< Log2 latency histogram bins, see ::UartDma_Status_T */
+#define UARTDMA_MAX_RETRIES (1U)              /**< Retransmissions of a failed buffer before it is dropped */
+#define UARTDMA_TIMEOUT_MARGIN_MS (5U)        /**< Slack added to the expected transfer duration */
+#define UARTDMA_SUPERVISOR_PERIOD_MS (10U)    /**< Poll period of the transfer supervisor task */
+#define UARTDMA_TASK_STACK_SIZE (256U)        /**< Supervisor task stack in words */
+#define UARTDMA_NOTIFY_INDEX (1U)             /**< Task notification index used by ::UartDma_TransmitWait */
 
 /* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Transfer completion callback.
+ *
+ * Runs from the DMA interrupt when the buffer has been fully consumed, or
+ * from the supervisor task with @p success false when the buffer was
+ * dropped after an unrecoverable error. Either way the driver no longer
+ * references the buffer once the callback runs. The callback may start
+ * the next transfer.
+ *
+ * @param[in] ctx     Context pointer given at submission.
+ * @param[in] success true if every byte was handed to the USART.
+ */
+typedef void (*UartDma_Callback_T)(void *ctx, bool success);
+
 /**
  * @brief Internal UART DMA driver state
  */
 typedef struct
 {
-    uint8_t is_busy; /**< Flag indicating active DMA transfer */
+    uint8_t is_busy;           /**< Flag indicating active DMA transfer */
+    volatile uint8_t tx_active; /**< DMA channel running a transfer */
+    uint8_t tx_retries;        /**< Retransmissions spent on the current buffer */
+    volatile uint32_t tx_error; /**< DMA error flags latched by the ISR, 0 if none */
+    const uint8_t *tx_data;    /**< Buffer of the transfer in flight */
+    UartDma_Callback_T tx_callback; /**< Completion callback of the transfer in flight */
+    void *tx_callback_ctx;     /**< Context passed to @ref tx_callback */
+    uint16_t tx_size;          /**< Size of the transfer in flight */
+    uint32_t tx_start_cycles;  /**< DWT cycle counter when the transfer started */
+    TickType_t tx_start_tick;  /**< Kernel tick when the transfer started */
+    uint32_t baudrate;         /**< Requested baud rate */
+    uint32_t actual_baudrate;  /**< Baud rate produced by the programmed divisor */
+    int32_t baud_error_ppm;    /**< Relative error of the actual baud rate in ppm */
+    uint32_t bytes_sent;       /**< Number of bytes transmitted since init */
+    uint32_t transfers_done;   /**< Number of completed DMA transfers */
+    uint32_t submit_cycles_cached;    /**< CPU cycles of the last submit that needed a cache clean */
+    uint32_t submit_cycles_noncached; /**< CPU cycles of the last submit from non-cacheable memory */
+    uint32_t errors_dte;       /**< Data transfer errors */
+    uint32_t errors_ule;       /**< Link transfer errors */
+    uint32_t errors_use;       /**< User setting errors */
+    uint32_t timeouts;         /**< Transfers that exceeded their expected duration */
+    uint32_t retries;          /**< Buffers retransmitted after a channel reset */
+    uint32_t drops;            /**< Buffers abandoned after ::UARTDMA_MAX_RETRIES */
+    uint32_t latency_hist[UARTDMA_LATENCY_BINS]; /**< Submit-to-complete latency histogram */
 } UartDma_Handler_T;
 
+/**
+ * @brief Snapshot of the UART DMA link configuration and counters.
+ *
+ * Bin 0 of @ref latency_hist counts transfers completed in under 1 us,
+ * bin n (n > 0) those in [2^(n-1), 2^n) us, and the last bin everything
+ * slower.
+ */
+typedef struct
+{
+    uint32_t kernel_clock_hz;  /**< USART kernel clock read from RCC */
+    uint32_t baudrate;         /**< Requested baud rate */
+    uint32_t actual_baudrate;  /**< Baud rate produced by the programmed divisor */
+    int32_t baud_error_ppm;    /**< Relative error of the actual baud rate in ppm */
+    uint32_t bytes_sent;       /**< Number of bytes transmitted since init */
+    uint32_t transfers_done;   /**< Number of completed DMA transfers */
+    uint32_t submit_cycles_cached;    /**< CPU cycles of the last submit that needed a cache clean */
+    uint32_t submit_cycles_noncached; /**< CPU cycles of the last submit from non-cacheable memory */
+    uint32_t errors_dte;       /**< Data transfer errors */
+    uint32_t errors_ule;       /**< Link transfer errors */
+    uint32_t errors_use;       /**< User setting errors */
+    uint32_t timeouts;         /**< Transfers that exceeded their expected duration */
+    uint32_t retries;          /**< Buffers retransmitted after a channel reset */
+    uint32_t drops;            /**< Buffers abandoned after ::UARTDMA_MAX_RETRIES */
+    uint32_t latency_hist[UARTDMA_LATENCY_BINS]; /**< Submit-to-complete latency histogram */
+} UartDma_Status_T;
+
 /* Exported Variables -------------------------------------------------------*/
 
 /* Exported Interfaces ------------------------------------------------------*/
@@ -48,6 +120,8 @@ bool UartDma_Init(void);
  *
  * The function returns immediately after queuing the transfer. If the DMA
  * channel is busy the call fails and the data should be retried later.
+ * Buffers allocated from the DMA pool (see DmaPool.h) skip the data cache
+ * clean that other buffers need before the transfer starts.
  *
  * @param[in] data Pointer to the buffer to transmit.
  * @param[in] size Number of bytes contained in the buffer.
@@ -56,4 +130,60 @@ bool UartDma_Init(void);
  */
 bool UartDma_Transmit(const uint8_t *data, uint16_t size);
 
+/**
+ * @brief Schedule a buffer and get notified when it has been consumed.
+ *
+ * Same non-blocking behaviour as ::UartDma_Transmit. When the call returns
+ * true, @p cb is invoked exactly once, after which the caller may reuse or
+ * free the buffer.
+ *
+ * @param[in] data Pointer to the buffer to transmit.
+ * @param[in] size Number of bytes contained in the buffer.
+ * @param[in] cb   Completion callback, may be NULL.
+ * @param[in] ctx  Context pointer handed to @p cb.
+ *
+ * @return true if the buffer was accepted for transmission.
+ */
+bool UartDma_TransmitAsync(const uint8_t *data, uint16_t size, UartDma_Callback_T cb, void *ctx);
+
+/**
+ * @brief Transmit a buffer and block the calling task until it completes.
+ *
+ * While the channel is busy the task sleeps until the current owner
+ * releases it, then it sleeps on task notification index
+ * ::UARTDMA_NOTIFY_INDEX until its own transfer finishes.
+ * If @p timeout expires the transfer is aborted, so the buffer is never
+ * referenced by the DMA after the call returns. Must be called from a
+ * task.
+ *
+ * @param[in] data    Pointer to the buffer to transmit.
+ * @param[in] size    Number of bytes contained in the buffer.
+ * @param[in] timeout Maximum time to wait in ticks, covering both the wait
+ *                    for the channel and the transfer itself.
+ *
+ * @return true if every byte was transmitted within @p timeout.
+ */
+bool UartDma_TransmitWait(const uint8_t *data, uint16_t size, TickType_t timeout);
+
+/**
+ * @brief Change the UART baud rate at runtime.
+ *
+ * The USART kernel clock is read from RCC and the prescaler and 8x/16x
+ * oversampling combination giving the smallest baud rate error is
+ * programmed. The switch only happens between transfers: if a DMA transfer
+ * is in flight the call fails and should be retried later.
+ *
+ * @param[in] baudrate Requested baud rate in bit/s.
+ *
+ * @return true if the new baud rate was applied.
+ */
+bool UartDma_SetBaudrate(uint32_t baudrate);
+
+/**
+ * @brief Read the current link configuration and transfer counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void UartDma_GetStatus(UartDma_Status_T *status);
+
 #endif /* UART_DMA_H */
@@ -11,6 +11,8 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "UartDma.h"
+#include "DmaPool.h"
+#include "DmaAlloc.h"
 #include "stm32n6xx_ll_usart.h"
 #include "stm32n6xx_ll_dma.h"
 #include "stm32n6xx_ll_gpio.h"
@@ -18,12 +20,34 @@
 #include "stm32n6xx_ll_rcc.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
 #include "cmsis_gcc.h"
 
 /* Defines -------------------------------------------------------------------*/
 #define USED_UART_INSTANCE USART1 /**< Define the UART instance to be used */
+#define UARTDMA_DMA_INSTANCE (g_uartDmaChannel.instance) /**< Controller of the allocated channel */
+#define UARTDMA_DMA_CHANNEL (g_uartDmaChannel.channel)   /**< LL channel number of the allocated channel */
+#define UARTDMA_DMA_IRQ (g_uartDmaChannel.irq)           /**< Interrupt line of the allocated channel */
+#define UARTDMA_DRAIN_SPIN_LIMIT (100000U) /**< Polls of USART TC before a baud switch gives up */
+#define UARTDMA_BRR_MIN (16U)              /**< Smallest USARTDIV accepted by the USART */
+#define UARTDMA_BRR_MAX (0xFFFFU)          /**< Largest USARTDIV accepted by the USART */
+#define UARTDMA_PPM (1000000LL)            /**< Parts per million scale */
+#define UARTDMA_BITS_PER_BYTE (10U)         /**< Start + 8 data + stop bits */
+#define UARTDMA_SUSPEND_SPIN_LIMIT (10000U) /**< Polls of SUSPF before the channel is reset anyway */
+#define UARTDMA_WAIT_DONE (1U)              /**< Waiter notification value: transfer complete */
+#define UARTDMA_WAIT_FAILED (2U)            /**< Waiter notification value: transfer dropped */
 
 /* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Divisor settings selected for a requested baud rate.
+ */
+typedef struct
+{
+    uint32_t prescaler;    /**< LL_USART_PRESCALER_DIVx value */
+    uint32_t oversampling; /**< LL_USART_OVERSAMPLING_8 or LL_USART_OVERSAMPLING_16 */
+    uint32_t actual;       /**< Baud rate produced by the divisor */
+    int32_t error_ppm;     /**< Signed error of the produced baud rate in ppm */
+} UartDma_Divisor_T;
 
 /* Global Variables ----------------------------------------------------------*/
 /**
@@ -31,6 +55,18 @@
  */
 static UartDma_Handler_T g_uartDmaHandler = {0};
 
+/** Handle of the supervisor task, notified by the ISR on errors. */
+static TaskHandle_t g_uartDmaTaskHandle = NULL;
+
+/** TX channel granted by the DMA allocator. */
+static DmaAlloc_Channel_T g_uartDmaChannel = {0};
+
+/** Serialises channel recovery between the supervisor and timed-out waiters. */
+static SemaphoreHandle_t g_uartDmaRecoveryMutex = NULL;
+
+/** Given on every release of the channel lock, wakes ::UartDma_TransmitWait. */
+static SemaphoreHandle_t g_uartDmaLockFree = NULL;
+
 /* Private Function Prototypes -----------------------------------------------*/
 /** Forward declaration of the driver main task. */
 static void UartDma_MainTask(void *pvParameters);
@@ -38,12 +74,38 @@ static void UartDma_MainTask(void *pvParameters);
 static bool UartDma_InitUsart(void);
 /** Configure GPIO pins for the USART peripheral. */
 static bool UartDma_InitGpio(void);
+/** Obtain the TX channel from the DMA allocator. */
+static bool UartDma_AllocDma(void);
 /** Configure DMA channel for USART transmissions. */
 static bool UartDma_InitDma(void);
 /** Handle DMA related error conditions. */
-static bool UartDma_ErrorHandler(void);
+static bool UartDma_ErrorHandler(uint32_t errorFlags);
+/** Program the channel for a buffer and start it, lock must be held. */
+static void UartDma_StartTransfer(const uint8_t *data, uint16_t size);
+/** Check the transfer in flight and recover the channel when needed. */
+static void UartDma_Supervise(void);
+/** Reset and re-initialise the DMA channel. */
+static void UartDma_ResetChannel(void);
+/** Ticks a transfer of @p size bytes may take before it is declared stuck. */
+static TickType_t UartDma_ExpectedTicks(uint16_t size);
+/** Record a completed transfer latency in the histogram. */
+static void UartDma_RecordLatency(uint32_t cycles);
+/** DMA channel interrupt, bound through the DMA allocator. */
+static void UartDma_DmaIrqHandler(void *ctx);
+/** Release the channel and run the completion callback. */
+static void UartDma_FinishTransfer(bool success);
+/** Completion callback used by ::UartDma_TransmitWait. */
+static void UartDma_WakeWaiter(void *ctx, bool success);
+/** Abort the transfer started by the calling waiter, if still running. */
+static void UartDma_AbortWaiter(TaskHandle_t waiter);
 /** Create internal FreeRTOS tasks used by the driver. */
 static void UartDma_TasksInit(void);
+/** Try to take the non-blocking channel lock. */
+static bool UartDma_TryLock(void);
+/** Release the channel lock and wake a task waiting for it. */
+static void UartDma_Unlock(void);
+/** Pick the prescaler and oversampling closest to the requested baud rate. */
+static bool UartDma_SelectDivisor(uint32_t kernelClock, uint32_t baudrate, UartDma_Divisor_T *divisor);
 
 /* Public Functions Implementation ------------------------------------------*/
 /**
@@ -59,9 +121,12 @@ bool UartDma_Init(void)
 {
     UartDma_InitGpio();
     UartDma_InitUsart();
-    UartDma_InitDma();
+    bool dmaOk = UartDma_AllocDma() && UartDma_InitDma();
+    g_uartDmaRecoveryMutex = xSemaphoreCreateMutex();
+    g_uartDmaLockFree = xSemaphoreCreateBinary();
+    bool baudOk = UartDma_SetBaudrate(UARTDMA_DEFAULT_BAUDRATE);
     UartDma_TasksInit();
-    return true;
+    return dmaOk && baudOk && (g_uartDmaRecoveryMutex != NULL) && (g_uartDmaLockFree != NULL);
 }
 
 /**
@@ -79,11 +144,255 @@ bool UartDma_Init(void)
  */
 bool UartDma_Transmit(const uint8_t *data, uint16_t size)
 {
+    return UartDma_TransmitAsync(data, size, NULL, NULL);
+}
+
+/**
+ * @brief Attempt to transmit data and report completion through @p cb.
+ *
+ * @param[in] data Pointer to the data buffer to transmit.
+ * @param[in] size Number of bytes to transmit.
+ * @param[in] cb   Completion callback, may be NULL.
+ * @param[in] ctx  Context pointer handed to @p cb.
+ *
+ * @retval true  Transmission scheduled, @p cb will run exactly once.
+ * @retval false DMA was busy or the parameters were invalid.
+ */
+bool UartDma_TransmitAsync(const uint8_t *data, uint16_t size, UartDma_Callback_T cb, void *ctx)
+{
+    if (data == NULL || size == 0)
+    {
+        return false;
+    }
+
+    if (!UartDma_TryLock())
+    {
+        return false;
+    }
+
+    g_uartDmaHandler.tx_retries = 0U;
+    g_uartDmaHandler.tx_callback = cb;
+    g_uartDmaHandler.tx_callback_ctx = ctx;
+    UartDma_StartTransfer(data, size);
+
+    return true;
+}
+
+/**
+ * @brief Transmit a buffer and sleep until it has been sent.
+ *
+ * While the channel is busy the task sleeps on the lock-free semaphore,
+ * which ::UartDma_Unlock gives each time the lock is released. Once the
+ * transfer is started the task blocks on its notification index ::UARTDMA_NOTIFY_INDEX,
+ * which ::UartDma_WakeWaiter sets from the completion path.
+ *
+ * @param[in] data    Pointer to the data buffer to transmit.
+ * @param[in] size    Number of bytes to transmit.
+ * @param[in] timeout Maximum time to wait in ticks.
+ *
+ * @retval true  Transfer completed.
+ * @retval false Invalid parameters, channel not obtained, transfer dropped
+ *               or aborted on timeout.
+ */
+bool UartDma_TransmitWait(const uint8_t *data, uint16_t size, TickType_t timeout)
+{
+    TimeOut_t timeOut;
+    TickType_t remaining = timeout;
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+
     if (data == NULL || size == 0)
     {
         return false;
     }
 
+    vTaskSetTimeOutState(&timeOut);
+    xTaskNotifyStateClearIndexed(self, UARTDMA_NOTIFY_INDEX);
+
+    while (!UartDma_TransmitAsync(data, size, UartDma_WakeWaiter, self))
+    {
+        if (xTaskCheckForTimeOut(&timeOut, &remaining) != pdFALSE)
+        {
+            return false;
+        }
+        /* A failed exclusive store leaves the lock free with nothing to
+         * give the semaphore, so only sleep while it is really held. */
+        if (g_uartDmaHandler.is_busy != 0U)
+        {
+            (void)xSemaphoreTake(g_uartDmaLockFree, remaining);
+        }
+    }
+
+    if (xTaskCheckForTimeOut(&timeOut, &remaining) != pdFALSE)
+    {
+        remaining = 0;
+    }
+
+    if (xTaskNotifyWaitIndexed(UARTDMA_NOTIFY_INDEX, 0U, UINT32_MAX, &value, remaining) == pdFALSE)
+    {
+        UartDma_AbortWaiter(self);
+        /* Consume the failure notice posted by the abort, or a completion
+         * that raced with the timeout. */
+        (void)xTaskNotifyWaitIndexed(UARTDMA_NOTIFY_INDEX, 0U, UINT32_MAX, &value, 0);
+    }
+
+    return value == UARTDMA_WAIT_DONE;
+}
+
+/**
+ * @brief Reprogram the USART baud rate between two transfers.
+ *
+ * The channel lock is taken so no transfer can start while the divisor is
+ * changed, then the USART FIFO and shift register are allowed to drain
+ * before the peripheral is disabled and reprogrammed.
+ *
+ * @param[in] baudrate Requested baud rate in bit/s.
+ *
+ * @retval true  Baud rate applied.
+ * @retval false No divisor within ::UARTDMA_MAX_BAUD_ERROR_PPM, a transfer
+ *               was in flight or the USART did not drain.
+ */
+bool UartDma_SetBaudrate(uint32_t baudrate)
+{
+    UartDma_Divisor_T divisor = {0};
+    uint32_t kernelClock = LL_RCC_GetUSARTClockFreq(LL_RCC_USART1_CLKSOURCE);
+
+    if (!UartDma_SelectDivisor(kernelClock, baudrate, &divisor))
+    {
+        return false;
+    }
+
+    if (!UartDma_TryLock())
+    {
+        return false;
+    }
+
+    uint32_t spin = UARTDMA_DRAIN_SPIN_LIMIT;
+    while ((LL_USART_IsActiveFlag_TC(USED_UART_INSTANCE) == 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+
+    if (spin == 0U)
+    {
+        UartDma_Unlock();
+        return false;
+    }
+
+    LL_USART_Disable(USED_UART_INSTANCE);
+    LL_USART_SetPrescaler(USED_UART_INSTANCE, divisor.prescaler);
+    LL_USART_SetOverSampling(USED_UART_INSTANCE, divisor.oversampling);
+    LL_USART_SetBaudRate(USED_UART_INSTANCE, kernelClock, divisor.prescaler, divisor.oversampling, baudrate);
+    LL_USART_Enable(USED_UART_INSTANCE);
+
+    g_uartDmaHandler.baudrate = baudrate;
+    g_uartDmaHandler.actual_baudrate = divisor.actual;
+    g_uartDmaHandler.baud_error_ppm = divisor.error_ppm;
+
+    UartDma_Unlock();
+    return true;
+}
+
+/**
+ * @brief Copy the link configuration and counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void UartDma_GetStatus(UartDma_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    status->kernel_clock_hz = LL_RCC_GetUSARTClockFreq(LL_RCC_USART1_CLKSOURCE);
+    status->baudrate = g_uartDmaHandler.baudrate;
+    status->actual_baudrate = g_uartDmaHandler.actual_baudrate;
+    status->baud_error_ppm = g_uartDmaHandler.baud_error_ppm;
+    status->bytes_sent = g_uartDmaHandler.bytes_sent;
+    status->transfers_done = g_uartDmaHandler.transfers_done;
+    status->submit_cycles_cached = g_uartDmaHandler.submit_cycles_cached;
+    status->submit_cycles_noncached = g_uartDmaHandler.submit_cycles_noncached;
+    status->errors_dte = g_uartDmaHandler.errors_dte;
+    status->errors_ule = g_uartDmaHandler.errors_ule;
+    status->errors_use = g_uartDmaHandler.errors_use;
+    status->timeouts = g_uartDmaHandler.timeouts;
+    status->retries = g_uartDmaHandler.retries;
+    status->drops = g_uartDmaHandler.drops;
+    for (uint32_t i = 0U; i < UARTDMA_LATENCY_BINS; i++)
+    {
+        status->latency_hist[i] = g_uartDmaHandler.latency_hist[i];
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+
+/**
+ * @brief Program the DMA channel for a buffer and start the transfer.
+ *
+ * The caller must own the channel lock. The buffer is cleaned from the data
+ * cache unless it lives in non-cacheable memory, and the submit cost is
+ * recorded per path for ::UartDma_GetStatus.
+ *
+ * @param[in] data Buffer to transmit.
+ * @param[in] size Number of bytes to transmit.
+ */
+static void UartDma_StartTransfer(const uint8_t *data, uint16_t size)
+{
+    uint32_t startCycles = DWT->CYCCNT;
+    bool nonCacheable = DmaPool_IsNonCacheable(data, size);
+    if (!nonCacheable)
+    {
+        SCB_CleanDCache_by_Addr((uint32_t *)data, size);
+    }
+
+    /* Word reads when the buffer allows it, the channel unpacks them into
+     * byte writes to TDR. Anything unaligned falls back to byte reads. */
+    if ((((uint32_t)data | size) & 0x3U) == 0U)
+    {
+        LL_DMA_SetSrcDataWidth(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, LL_DMA_SRC_DATAWIDTH_WORD);
+        LL_DMA_SetDataAlignment(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, LL_DMA_DATA_PACK_UNPACK);
+    }
+    else
+    {
+        LL_DMA_SetSrcDataWidth(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, LL_DMA_SRC_DATAWIDTH_BYTE);
+        LL_DMA_SetDataAlignment(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, LL_DMA_DATA_ALIGN_ZEROPADD);
+    }
+
+    g_uartDmaHandler.tx_data = data;
+    g_uartDmaHandler.tx_size = size;
+    g_uartDmaHandler.tx_error = 0U;
+    g_uartDmaHandler.tx_start_tick = xTaskGetTickCount();
+    LL_DMA_ConfigAddresses(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL,
+                           (uint32_t)data, LL_USART_DMA_GetRegAddr(USART1, LL_USART_DMA_REG_DATA_TRANSMIT));
+    LL_DMA_SetBlkDataLength(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, size);
+    LL_USART_EnableDMAReq_TX(USART1);
+
+    g_uartDmaHandler.tx_start_cycles = DWT->CYCCNT;
+    g_uartDmaHandler.tx_active = 1U;
+    DmaAlloc_NoteStart(&g_uartDmaChannel, size);
+    __DMB();
+    LL_DMA_EnableChannel(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+
+    uint32_t submitCycles = DWT->CYCCNT - startCycles;
+    if (nonCacheable)
+    {
+        g_uartDmaHandler.submit_cycles_noncached = submitCycles;
+    }
+    else
+    {
+        g_uartDmaHandler.submit_cycles_cached = submitCycles;
+    }
+}
+
+/**
+ * @brief Take the channel lock without blocking.
+ *
+ * @retval true  Lock acquired, the caller owns the DMA channel.
+ * @retval false Channel busy or the exclusive store was interrupted.
+ */
+static bool UartDma_TryLock(void)
+{
     uint8_t current;
     uint32_t result;
 
@@ -101,25 +410,115 @@ bool UartDma_Transmit(const uint8_t *data, uint16_t size)
         return false;
     }
 
-    SCB_CleanDCache_by_Addr((uint32_t *)data, size);
+    return true;
+}
 
-    LL_DMA_ConfigAddresses(GPDMA1, LL_DMA_CHANNEL_0,
-                           (uint32_t)data, LL_USART_DMA_GetRegAddr(USART1, LL_USART_DMA_REG_DATA_TRANSMIT));
-    LL_DMA_SetBlkDataLength(GPDMA1, LL_DMA_CHANNEL_0, size);
-    LL_USART_EnableDMAReq_TX(USART1);
-    LL_DMA_EnableChannel(GPDMA1, LL_DMA_CHANNEL_0);
+/**
+ * @brief Release the channel lock taken by ::UartDma_TryLock.
+ *
+ * The lock-free semaphore is binary, so a release with nobody waiting is
+ * kept for the next waiter, which then merely retries the lock once. Safe
+ * from interrupt and task context.
+ */
+static void UartDma_Unlock(void)
+{
+    __DMB();
+    g_uartDmaHandler.is_busy = 0;
 
-    return true;
+    if (g_uartDmaLockFree == NULL)
+    {
+        return;
+    }
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        (void)xSemaphoreGiveFromISR(g_uartDmaLockFree, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        (void)xSemaphoreGive(g_uartDmaLockFree);
+    }
 }
 
-/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Search prescaler and oversampling settings for a baud rate.
+ *
+ * Every prescaler is tried with 16x and then 8x oversampling using the same
+ * rounding as ::LL_USART_SetBaudRate. With 8x oversampling BRR[3] must stay
+ * clear, so ::LL_USART_SetBaudRate drops bit 0 of USARTDIV and the error is
+ * computed from that even divisor. The first combination with the lowest
+ * absolute error wins, so 16x oversampling and small prescalers are
+ * preferred when they are equally accurate.
+ *
+ * @param[in]  kernelClock USART kernel clock in Hz.
+ * @param[in]  baudrate    Requested baud rate in bit/s.
+ * @param[out] divisor     Selected settings.
+ *
+ * @retval true  A divisor within ::UARTDMA_MAX_BAUD_ERROR_PPM was found.
+ * @retval false The baud rate cannot be produced from this clock.
+ */
+static bool UartDma_SelectDivisor(uint32_t kernelClock, uint32_t baudrate, UartDma_Divisor_T *divisor)
+{
+    static const uint32_t oversampling[] = {LL_USART_OVERSAMPLING_16, LL_USART_OVERSAMPLING_8};
+    int64_t bestError = INT64_MAX;
+
+    if ((kernelClock == 0U) || (baudrate == 0U))
+    {
+        return false;
+    }
+
+    for (uint32_t os = 0U; os < (sizeof(oversampling) / sizeof(oversampling[0])); os++)
+    {
+        for (uint32_t presc = LL_USART_PRESCALER_DIV1; presc <= LL_USART_PRESCALER_DIV256; presc++)
+        {
+            uint32_t usartdiv;
+            uint32_t programmed;
+            uint32_t clock = kernelClock / USART_PRESCALER_TAB[presc];
+
+            if (oversampling[os] == LL_USART_OVERSAMPLING_8)
+            {
+                usartdiv = __LL_USART_DIV_SAMPLING8(kernelClock, presc, baudrate);
+                programmed = usartdiv & ~1U;
+                clock *= 2U;
+            }
+            else
+            {
+                usartdiv = __LL_USART_DIV_SAMPLING16(kernelClock, presc, baudrate);
+                programmed = usartdiv;
+            }
+
+            if ((usartdiv < UARTDMA_BRR_MIN) || (usartdiv > UARTDMA_BRR_MAX))
+            {
+                continue;
+            }
+
+            uint32_t actual = clock / programmed;
+            int64_t error = (((int64_t)actual - (int64_t)baudrate) * UARTDMA_PPM) / (int64_t)baudrate;
+            int64_t absError = (error < 0) ? -error : error;
+
+            if (absError < bestError)
+            {
+                bestError = absError;
+                divisor->prescaler = presc;
+                divisor->oversampling = oversampling[os];
+                divisor->actual = actual;
+                divisor->error_ppm = (int32_t)error;
+            }
+        }
+    }
+
+    return bestError <= (int64_t)UARTDMA_MAX_BAUD_ERROR_PPM;
+}
 
 /**
  * @brief Configure and enable the USART peripheral used for logging.
  *
- * The USART is initialised in asynchronous transmit-only mode with a fixed
- * baud rate of 115200. DMA requests for transmission are enabled once the
- * peripheral configuration is complete.
+ * The USART is initialised in asynchronous transmit-only mode at
+ * ::UARTDMA_DEFAULT_BAUDRATE; ::UartDma_SetBaudrate later refines the
+ * divisor. The FIFO is enabled so the DMA can refill it in bursts while
+ * previously queued bytes are still being shifted out.
  *
  * @retval true  USART configured successfully.
  * @retval false Configuration failed.
@@ -132,7 +531,7 @@ static bool UartDma_InitUsart(void)
     LL_RCC_SetUSARTClockSource(LL_RCC_USART1_CLKSOURCE_PCLK2);
 
     usart_h.PrescalerValue = LL_USART_PRESCALER_DIV1;
-    usart_h.BaudRate = 115200;
+    usart_h.BaudRate = UARTDMA_DEFAULT_BAUDRATE;
     usart_h.DataWidth = LL_USART_DATAWIDTH_8B;
     usart_h.StopBits = LL_USART_STOPBITS_1;
     usart_h.Parity = LL_USART_PARITY_NONE;
@@ -141,9 +540,9 @@ static bool UartDma_InitUsart(void)
     usart_h.OverSampling = LL_USART_OVERSAMPLING_16;
 
     LL_USART_Init(USART1, &usart_h);
-    LL_USART_SetTXFIFOThreshold(USART1, LL_USART_FIFOTHRESHOLD_1_8);
+    LL_USART_SetTXFIFOThreshold(USART1, LL_USART_FIFOTHRESHOLD_1_2);
     LL_USART_SetRXFIFOThreshold(USART1, LL_USART_FIFOTHRESHOLD_1_8);
-    LL_USART_DisableFIFO(USART1);
+    LL_USART_EnableFIFO(USART1);
     LL_USART_ConfigAsyncMode(USART1);
     LL_USART_Enable(USART1);
 
@@ -174,12 +573,39 @@ static bool UartDma_InitGpio(void)
     return true;
 }
 
+/**
+ * @brief Request the channel used for USART transmissions.
+ *
+ * The USART1 TX request is routed to GPDMA1 only. The stream class gives
+ * the channel the arbitration weight the logger traffic used to have, and
+ * the allocator binds the channel interrupt to ::UartDma_DmaIrqHandler.
+ *
+ * @retval true  Channel granted.
+ * @retval false No free GPDMA1 channel.
+ */
+static bool UartDma_AllocDma(void)
+{
+    const DmaAlloc_Request_T request = {
+        .controller = DMAALLOC_CTRL_GPDMA1,
+        .prio_class = DMAALLOC_CLASS_STREAM,
+        .caps = 0U,
+        .burst_bytes = 0U,
+        .owner = "UartDma",
+        .handler = UartDma_DmaIrqHandler,
+        .ctx = NULL,
+    };
+
+    return DmaAlloc_Request(&request, &g_uartDmaChannel);
+}
+
 /**
  * @brief Configure the DMA channel used for USART transmissions.
  *
  * The DMA is set up for memory-to-peripheral transfers with incrementing
- * source addresses. Interrupts are enabled to release the lock on transfer
- * completion or error.
+ * source addresses. Source reads default to bytes; ::UartDma_Transmit
+ * switches to packed word reads for aligned buffers. Completion and error
+ * interrupts are enabled; the interrupt priority allows the handler to
+ * notify the supervisor task through the FreeRTOS FromISR API.
  *
  * @retval true  Configuration succeeded.
  */
@@ -187,93 +613,359 @@ static bool UartDma_InitDma(void)
 {
     LL_DMA_InitTypeDef dma_h;
 
-    LL_AHB1_GRP1_EnableClock(LL_AHB1_GRP1_PERIPH_GPDMA1);
     LL_DMA_StructInit(&dma_h);
 
     dma_h.Direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
-    dma_h.DataAlignment = LL_DMA_DATA_ALIGN_SIGNEXTPADD;
-    dma_h.SrcDataWidth = LL_DMA_DEST_DATAWIDTH_HALFWORD;
+    dma_h.DataAlignment = LL_DMA_DATA_ALIGN_ZEROPADD;
+    dma_h.SrcDataWidth = LL_DMA_SRC_DATAWIDTH_BYTE;
     dma_h.DestDataWidth = LL_DMA_DEST_DATAWIDTH_BYTE;
     dma_h.SrcIncMode = LL_DMA_SRC_INCREMENT;
     dma_h.DestIncMode = LL_DMA_DEST_FIXED;
-    dma_h.Priority = LL_DMA_LOW_PRIORITY_HIGH_WEIGHT;
+    dma_h.Priority = g_uartDmaChannel.priority;
     dma_h.TriggerMode = LL_DMA_TRIGM_BLK_TRANSFER;
     dma_h.Request = LL_GPDMA1_REQUEST_USART1_TX;
 
-    LL_DMA_Init(GPDMA1, LL_DMA_CHANNEL_0, &dma_h);
+    LL_DMA_Init(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL, &dma_h);
 
-    NVIC_SetPriority(GPDMA1_Channel0_IRQn, 0);
-    NVIC_EnableIRQ(GPDMA1_Channel0_IRQn);
-    LL_DMA_EnableIT_TC(GPDMA1, LL_DMA_CHANNEL_0);
+    NVIC_SetPriority(UARTDMA_DMA_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                          configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_ClearPendingIRQ(UARTDMA_DMA_IRQ);
+    NVIC_EnableIRQ(UARTDMA_DMA_IRQ);
+    LL_DMA_EnableIT_TC(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_EnableIT_DTE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_EnableIT_ULE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_EnableIT_USE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
 
     return true;
 }
 
 /**
- * @brief Handle DMA error conditions.
+ * @brief Handle DMA error conditions from interrupt context.
+ *
+ * The error is counted and latched in the handler, the channel lock stays
+ * held and the supervisor task is woken to reset the channel. Recovery is
+ * deferred because resetting and re-initialising the channel is too long
+ * for the interrupt.
  *
- * This implementation currently performs no recovery other than
- * reporting failure to the caller. It can be extended to reset the
- * DMA hardware or reconfigure the peripheral after an error occurs.
+ * @param[in] errorFlags Mask of DMA_CSR_DTEF, DMA_CSR_ULEF and DMA_CSR_USEF.
+ *
+ * @retval true  A context switch to the supervisor is required.
+ * @retval false No higher priority task was woken.
  */
-static bool UartDma_ErrorHandler(void)
+static bool UartDma_ErrorHandler(uint32_t errorFlags)
 {
-    return false;
+    BaseType_t woken = pdFALSE;
+
+    if ((errorFlags & DMA_CSR_DTEF) != 0U)
+    {
+        g_uartDmaHandler.errors_dte++;
+    }
+    if ((errorFlags & DMA_CSR_ULEF) != 0U)
+    {
+        g_uartDmaHandler.errors_ule++;
+    }
+    if ((errorFlags & DMA_CSR_USEF) != 0U)
+    {
+        g_uartDmaHandler.errors_use++;
+    }
+
+    g_uartDmaHandler.tx_error = errorFlags;
+
+    if (g_uartDmaTaskHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(g_uartDmaTaskHandle, &woken);
+    }
+
+    return woken == pdTRUE;
 }
 
 /**
  * @brief Create internal tasks required by the UART DMA driver.
  *
- * Currently only a placeholder task is created which can be extended
- * to implement additional features such as timeouts or background
- * processing.
+ * The supervisor task runs just above idle priority; it only wakes on its
+ * poll period or when the interrupt reports an error.
  */
 static void UartDma_TasksInit(void)
 {
-    xTaskCreate(UartDma_MainTask, "UartDmaMainTask", 1000, NULL, 1, NULL);
+    xTaskCreate(UartDma_MainTask, "UartDmaMainTask", UARTDMA_TASK_STACK_SIZE, NULL,
+                tskIDLE_PRIORITY + 1, &g_uartDmaTaskHandle);
 }
 
 /**
- * @brief Background task used for future driver extensions.
+ * @brief Transfer supervisor task.
  *
- * Currently the task simply sleeps and can be expanded to monitor
- * transmission timeouts or implement queued transmission support.
+ * Wakes on an error notification from the interrupt or every
+ * ::UARTDMA_SUPERVISOR_PERIOD_MS to look for stuck transfers.
  *
  * @param[in] pvParameters Unused parameter.
  */
 static void UartDma_MainTask(void *pvParameters)
 {
+    (void)pvParameters;
+
     while (1)
     {
-        vTaskDelay(pdMS_TO_TICKS(100));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(UARTDMA_SUPERVISOR_PERIOD_MS));
+        UartDma_Supervise();
+    }
+}
+
+/**
+ * @brief Recover the channel after an error or a stuck transfer.
+ *
+ * The decision is taken with the DMA interrupt masked so a completion
+ * racing with the check cannot release the lock underneath the recovery.
+ * A failed buffer is retransmitted up to ::UARTDMA_MAX_RETRIES times and
+ * then dropped, releasing the lock for the next caller.
+ */
+static void UartDma_Supervise(void)
+{
+    bool recover = false;
+
+    xSemaphoreTake(g_uartDmaRecoveryMutex, portMAX_DELAY);
+
+    taskENTER_CRITICAL();
+    if (g_uartDmaHandler.tx_active != 0U)
+    {
+        if (g_uartDmaHandler.tx_error != 0U)
+        {
+            recover = true;
+        }
+        else if ((xTaskGetTickCount() - g_uartDmaHandler.tx_start_tick) >
+                 UartDma_ExpectedTicks(g_uartDmaHandler.tx_size))
+        {
+            g_uartDmaHandler.timeouts++;
+            recover = true;
+        }
+
+        if (recover)
+        {
+            NVIC_DisableIRQ(UARTDMA_DMA_IRQ);
+            g_uartDmaHandler.tx_active = 0U;
+        }
     }
+    taskEXIT_CRITICAL();
+
+    if (recover)
+    {
+        UartDma_ResetChannel();
+
+        if (g_uartDmaHandler.tx_retries < UARTDMA_MAX_RETRIES)
+        {
+            g_uartDmaHandler.tx_retries++;
+            g_uartDmaHandler.retries++;
+            UartDma_StartTransfer(g_uartDmaHandler.tx_data, g_uartDmaHandler.tx_size);
+        }
+        else
+        {
+            g_uartDmaHandler.drops++;
+            UartDma_FinishTransfer(false);
+        }
+    }
+
+    xSemaphoreGive(g_uartDmaRecoveryMutex);
+}
+
+/**
+ * @brief Abort a transfer whose waiter timed out.
+ *
+ * Holding the recovery mutex guarantees the supervisor is not between a
+ * channel reset and a retransmission, so the transfer is either still
+ * running for @p waiter, in which case it is reset and dropped, or it has
+ * already finished and posted its notification.
+ *
+ * @param[in] waiter Task that started the transfer.
+ */
+static void UartDma_AbortWaiter(TaskHandle_t waiter)
+{
+    bool abort = false;
+
+    xSemaphoreTake(g_uartDmaRecoveryMutex, portMAX_DELAY);
+
+    taskENTER_CRITICAL();
+    if ((g_uartDmaHandler.tx_active != 0U) &&
+        (g_uartDmaHandler.tx_callback == UartDma_WakeWaiter) &&
+        (g_uartDmaHandler.tx_callback_ctx == waiter))
+    {
+        NVIC_DisableIRQ(UARTDMA_DMA_IRQ);
+        g_uartDmaHandler.tx_active = 0U;
+        abort = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (abort)
+    {
+        UartDma_ResetChannel();
+        g_uartDmaHandler.drops++;
+        UartDma_FinishTransfer(false);
+    }
+
+    xSemaphoreGive(g_uartDmaRecoveryMutex);
+}
+
+/**
+ * @brief Release the channel lock and report the outcome to the owner.
+ *
+ * The callback is detached before the lock is released so that a callback
+ * starting the next transfer sees a clean handler.
+ *
+ * @param[in] success Outcome passed to the completion callback.
+ */
+static void UartDma_FinishTransfer(bool success)
+{
+    UartDma_Callback_T cb = g_uartDmaHandler.tx_callback;
+    void *ctx = g_uartDmaHandler.tx_callback_ctx;
+
+    g_uartDmaHandler.tx_callback = NULL;
+    g_uartDmaHandler.tx_callback_ctx = NULL;
+    UartDma_Unlock();
+
+    if (cb != NULL)
+    {
+        cb(ctx, success);
+    }
+}
+
+/**
+ * @brief Wake the task blocked in ::UartDma_TransmitWait.
+ *
+ * Called from the DMA interrupt on completion or from task context when
+ * the transfer is dropped, so the matching notify API is selected.
+ *
+ * @param[in] ctx     Handle of the waiting task.
+ * @param[in] success Transfer outcome.
+ */
+static void UartDma_WakeWaiter(void *ctx, bool success)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+    uint32_t value = success ? UARTDMA_WAIT_DONE : UARTDMA_WAIT_FAILED;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, UARTDMA_NOTIFY_INDEX, value, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, UARTDMA_NOTIFY_INDEX, value, eSetValueWithOverwrite);
+    }
+}
+
+/**
+ * @brief Reset the DMA channel and configure it from scratch.
+ *
+ * A running channel is suspended first as required before setting
+ * CCR.RESET; if it does not acknowledge the suspend the reset is issued
+ * anyway since the channel is already considered broken.
+ */
+static void UartDma_ResetChannel(void)
+{
+    if (LL_DMA_IsEnabledChannel(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) != 0U)
+    {
+        uint32_t spin = UARTDMA_SUSPEND_SPIN_LIMIT;
+        LL_DMA_SuspendChannel(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+        while ((LL_DMA_IsActiveFlag_SUSP(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+    }
+
+    LL_DMA_ResetChannel(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    DmaAlloc_NoteStop(&g_uartDmaChannel);
+    LL_DMA_ClearFlag_TC(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_HT(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_DTE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_ULE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_USE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_SUSP(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+    LL_DMA_ClearFlag_TO(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+
+    UartDma_InitDma();
+}
+
+/**
+ * @brief Compute how long a transfer may take at the current baud rate.
+ *
+ * @param[in] size Transfer length in bytes.
+ *
+ * @return Expected duration plus ::UARTDMA_TIMEOUT_MARGIN_MS, in ticks.
+ */
+static TickType_t UartDma_ExpectedTicks(uint16_t size)
+{
+    uint32_t baudrate = (g_uartDmaHandler.actual_baudrate != 0U) ? g_uartDmaHandler.actual_baudrate
+                                                                 : UARTDMA_DEFAULT_BAUDRATE;
+    uint32_t bits = (uint32_t)size * UARTDMA_BITS_PER_BYTE;
+    uint32_t ms = ((bits * 1000U) + baudrate - 1U) / baudrate;
+
+    return pdMS_TO_TICKS(ms + UARTDMA_TIMEOUT_MARGIN_MS);
+}
+
+/**
+ * @brief Add a transfer latency to the log2 microsecond histogram.
+ *
+ * @param[in] cycles Latency in CPU cycles.
+ */
+static void UartDma_RecordLatency(uint32_t cycles)
+{
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000U;
+    uint32_t us = (cyclesPerUs != 0U) ? (cycles / cyclesPerUs) : 0U;
+    uint32_t bin = (us == 0U) ? 0U : (32U - (uint32_t)__builtin_clz(us));
+
+    if (bin >= UARTDMA_LATENCY_BINS)
+    {
+        bin = UARTDMA_LATENCY_BINS - 1U;
+    }
+    g_uartDmaHandler.latency_hist[bin]++;
 }
 
 /**
  * @brief DMA interrupt handler for UART DMA channel.
  *
- * Clears transfer complete or error flags and releases the DMA lock so
- * that new transmissions may be scheduled. Error conditions are passed
- * to ::UartDma_ErrorHandler for further processing.
+ * On transfer complete the latency is recorded and the DMA lock released so
+ * that new transmissions may be scheduled. Error conditions are latched
+ * and passed to ::UartDma_ErrorHandler, which defers recovery to the
+ * supervisor task.
  *
- * @bug Add it to ISR manager
+ * @param[in] ctx Unused, the driver is a singleton.
  */
-void GPDMA1_Channel0_IRQHandler(void)
+static void UartDma_DmaIrqHandler(void *ctx)
 {
-    if (LL_DMA_IsActiveFlag_TC(GPDMA1, LL_DMA_CHANNEL_0) && LL_DMA_IsEnabledIT_TC(GPDMA1, LL_DMA_CHANNEL_0))
+    (void)ctx;
+
+    if (LL_DMA_IsActiveFlag_TC(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) &&
+        LL_DMA_IsEnabledIT_TC(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL))
     {
-        LL_DMA_ClearFlag_TC(GPDMA1, LL_DMA_CHANNEL_0);
-        g_uartDmaHandler.is_busy = 0;
-        __DMB();
+        LL_DMA_ClearFlag_TC(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+        UartDma_RecordLatency(DWT->CYCCNT - g_uartDmaHandler.tx_start_cycles);
+        g_uartDmaHandler.bytes_sent += g_uartDmaHandler.tx_size;
+        g_uartDmaHandler.transfers_done++;
+        g_uartDmaHandler.tx_active = 0U;
+        UartDma_FinishTransfer(true);
     }
-    else if ((LL_DMA_IsActiveFlag_USE(GPDMA1, LL_DMA_CHANNEL_0) && LL_DMA_IsEnabledIT_USE(GPDMA1, LL_DMA_CHANNEL_0)) ||
-             (LL_DMA_IsActiveFlag_ULE(GPDMA1, LL_DMA_CHANNEL_0) && LL_DMA_IsEnabledIT_ULE(GPDMA1, LL_DMA_CHANNEL_0)) ||
-             (LL_DMA_IsActiveFlag_DTE(GPDMA1, LL_DMA_CHANNEL_0) && LL_DMA_IsEnabledIT_DTE(GPDMA1, LL_DMA_CHANNEL_0)))
+    else
     {
-        LL_DMA_ClearFlag_USE(GPDMA1, LL_DMA_CHANNEL_0);
-        LL_DMA_ClearFlag_ULE(GPDMA1, LL_DMA_CHANNEL_0);
-        LL_DMA_ClearFlag_DTE(GPDMA1, LL_DMA_CHANNEL_0);
-        UartDma_ErrorHandler();
+        uint32_t errorFlags = 0U;
+        if (LL_DMA_IsActiveFlag_DTE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) != 0U)
+        {
+            errorFlags |= DMA_CSR_DTEF;
+        }
+        if (LL_DMA_IsActiveFlag_ULE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) != 0U)
+        {
+            errorFlags |= DMA_CSR_ULEF;
+        }
+        if (LL_DMA_IsActiveFlag_USE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL) != 0U)
+        {
+            errorFlags |= DMA_CSR_USEF;
+        }
+
+        if (errorFlags != 0U)
+        {
+            LL_DMA_ClearFlag_USE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+            LL_DMA_ClearFlag_ULE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+            LL_DMA_ClearFlag_DTE(UARTDMA_DMA_INSTANCE, UARTDMA_DMA_CHANNEL);
+            portYIELD_FROM_ISR(UartDma_ErrorHandler(errorFlags) ? pdTRUE : pdFALSE);
+        }
     }
 }
 
@@ -0,0 +1,201 @@
+/**
+ * @file UsbDev.h
+ * @brief USB high-speed device on OTG1 with a CDC-ACM port and a bulk trace channel
+ *
+ * The device enumerates as a composite of two functions:
+ *  - a CDC-ACM serial port on interfaces 0 and 1, whose bulk IN endpoint
+ *    carries the log output while a host program holds the port open,
+ *  - a vendor-specific interface 2 with one bulk IN endpoint streaming
+ *    trace buffers.
+ *
+ * Data leaves from the caller's buffers: ::UsbDev_Submit queues a buffer
+ * on a channel and the internal DMA of the core moves it into the
+ * endpoint FIFO packet by packet, without a copy. A buffer larger than
+ * one transfer of the core is sent as several transfers of at most
+ * ::USBDEV_MAX_PACKETS packets. The completion callback hands the buffer
+ * back to its owner.
+ *
+ * Endpoint 0 is served from the OTG interrupt: the standard requests of
+ * enumeration and the CDC line coding and control line state requests.
+ * A bus reset, a suspend, a deconfiguration or the host closing the port
+ * ends the requests queued on the channels concerned with a failure.
+ */
+
+#ifndef USB_DEV_H
+#define USB_DEV_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32n6xx.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef USBDEV_QUEUE_LEN
+#define USBDEV_QUEUE_LEN (16U) /**< Requests waiting per channel behind the running one */
+#endif
+
+#ifndef USBDEV_VID
+#define USBDEV_VID (0x0483U) /**< Vendor ID */
+#endif
+
+#ifndef USBDEV_PID
+#define USBDEV_PID (0x5741U) /**< Product ID */
+#endif
+
+#ifndef USBDEV_MANUFACTURER
+#define USBDEV_MANUFACTURER "Stm32N6_Platform" /**< Manufacturer string */
+#endif
+
+#ifndef USBDEV_PRODUCT
+#define USBDEV_PRODUCT "EdgeAI log and trace" /**< Product string */
+#endif
+
+#ifndef USBDEV_SERIAL
+#define USBDEV_SERIAL "0001" /**< Serial number string */
+#endif
+
+#define USBDEV_MAX_PACKETS (1023U) /**< Packets of one transfer, PKTCNT limit */
+#define USBDEV_NOTIFY_INDEX (1U)   /**< Task notification index used by the blocking call */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Outbound channel.
+ */
+typedef enum
+{
+    USBDEV_CDC = 0,   /**< CDC-ACM data, bulk IN endpoint 2 */
+    USBDEV_TRACE,     /**< Vendor trace, bulk IN endpoint 3 */
+    USBDEV_CHANNELS,  /**< Number of channels */
+} UsbDev_Channel_T;
+
+/**
+ * @brief Device state on the bus.
+ */
+typedef enum
+{
+    USBDEV_DETACHED = 0, /**< No bus reset seen yet */
+    USBDEV_DEFAULT,      /**< Reset, address 0 */
+    USBDEV_ADDRESSED,    /**< Address assigned, not configured */
+    USBDEV_CONFIGURED,   /**< Configuration 1 selected, endpoints active */
+    USBDEV_SUSPENDED,    /**< Bus idle for 3 ms or more */
+} UsbDev_State_T;
+
+/**
+ * @brief Request completion callback.
+ *
+ * Runs from interrupt context, or from the caller of ::UsbDev_Submit
+ * when the request fails at once. The driver no longer references the
+ * buffer once it runs.
+ *
+ * @param[in] ctx     Context given with the request.
+ * @param[in] success The host took every byte.
+ */
+typedef void (*UsbDev_Callback_T)(void *ctx, bool success);
+
+/**
+ * @brief Receiver of the data the host writes to the CDC port.
+ *
+ * Runs from interrupt context; the data is only valid during the call.
+ *
+ * @param[in] ctx  Context given to ::UsbDev_SetReceiver.
+ * @param[in] data Received bytes.
+ * @param[in] size Byte count, at most one packet.
+ */
+typedef void (*UsbDev_Receiver_T)(void *ctx, const uint8_t *data, uint32_t size);
+
+/**
+ * @brief Line coding set by the host on the CDC port.
+ */
+typedef struct
+{
+    uint32_t baudrate;  /**< Bit rate the host asked for, informative only */
+    uint8_t stop_bits;  /**< 0: 1, 1: 1.5, 2: 2 stop bits */
+    uint8_t parity;     /**< 0: none, 1: odd, 2: even, 3: mark, 4: space */
+    uint8_t data_bits;  /**< 5, 6, 7, 8 or 16 */
+} UsbDev_LineCoding_T;
+
+/**
+ * @brief Driver counters.
+ */
+typedef struct
+{
+    UsbDev_State_T state;                 /**< Device state */
+    bool high_speed;                      /**< Enumerated at 480 Mbit/s */
+    uint8_t address;                      /**< Address assigned by the host */
+    bool dtr;                             /**< The host holds the CDC port open */
+    UsbDev_LineCoding_T line;             /**< Last line coding set */
+    uint32_t requests_done;               /**< Requests completed */
+    uint32_t requests_failed;             /**< Requests ended by an abort */
+    uint64_t bytes[USBDEV_CHANNELS];      /**< Bytes of completed requests per channel */
+    uint32_t transfers;                   /**< Endpoint transfers programmed */
+    uint32_t zlps;                        /**< Zero-length packets closing a CDC transfer */
+    uint32_t rx_bytes;                    /**< Bytes received on the CDC port */
+    uint32_t setups;                      /**< SETUP packets handled */
+    uint32_t stalls;                      /**< Control requests refused */
+    uint32_t resets;                      /**< Bus resets */
+    uint32_t suspends;                    /**< Suspends */
+    uint32_t queue_peak;                  /**< Largest number of waiting requests on a channel */
+    uint32_t queue_full;                  /**< Submissions rejected on a full queue */
+    uint32_t irqs;                        /**< OTG interrupts handled */
+} UsbDev_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Clock OTG1 and its PHY, set up the core as a device and connect.
+ *
+ * @retval true  The device is on the bus and waits for a reset.
+ * @retval false The interrupt is taken or the core did not come out of reset.
+ */
+bool UsbDev_Init(void);
+
+/**
+ * @brief Queue a buffer on a channel without copying it.
+ *
+ * Callable from tasks and from interrupts up to
+ * configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY. The buffer must be
+ * 4-byte aligned and DMA-reachable, and stay untouched until the
+ * callback; it is cleaned by the driver unless it is non-cacheable.
+ *
+ * @param[in] ch   Channel.
+ * @param[in] buf  Data.
+ * @param[in] size Bytes, at least 1.
+ * @param[in] cb   Completion callback, may be NULL.
+ * @param[in] ctx  Passed unchanged to @p cb.
+ *
+ * @retval true  Queued; its callback will run.
+ * @retval false Invalid, channel not open, or the queue is full; the
+ *               callback does not run.
+ */
+bool UsbDev_Submit(UsbDev_Channel_T ch, const void *buf, uint32_t size, UsbDev_Callback_T cb, void *ctx);
+
+/**
+ * @brief Send a buffer on a channel and block the calling task until done.
+ *
+ * @retval true  The host took every byte.
+ * @retval false Invalid, channel not open, or aborted.
+ */
+bool UsbDev_Transmit(UsbDev_Channel_T ch, const void *buf, uint32_t size);
+
+/**
+ * @brief A channel accepts data.
+ *
+ * The trace channel is open once the device is configured; the CDC
+ * channel also needs the host to hold the port open (DTR set).
+ */
+bool UsbDev_IsOpen(UsbDev_Channel_T ch);
+
+/**
+ * @brief Install the receiver of the CDC port, NULL to drop the data.
+ */
+void UsbDev_SetReceiver(UsbDev_Receiver_T receiver, void *ctx);
+
+/**
+ * @brief Copy the driver counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void UsbDev_GetStatus(UsbDev_Status_T *status);
+
+#endif /* USB_DEV_H */
@@ -0,0 +1,1328 @@
+/**
+ * @file UsbDev.c
+ * @brief Implementation of the USB high-speed device.
+ * @ingroup UsbDev
+ * @{
+ *
+ * The core runs in device mode with its internal DMA: every endpoint
+ * transfer is described by a size, a packet count and a buffer address,
+ * and the core fetches or stores the packets itself. The interrupt only
+ * sees the end of a transfer or a SETUP packet.
+ *
+ * Endpoints:
+ *  - 0: control, 64-byte packets, SETUP packets land in ::g_usbDevSetup,
+ *  - 1 IN: CDC notifications, interrupt, never armed,
+ *  - 2 IN and OUT: CDC data, bulk,
+ *  - 3 IN: trace, bulk.
+ *
+ * Each channel keeps a ring of requests; the oldest one is on its
+ * endpoint. A request is sent as transfers of at most
+ * ::USBDEV_MAX_PACKETS packets, and a CDC request whose size is a
+ * multiple of the packet size is followed by a zero-length packet so the
+ * host sees where it ends.
+ *
+ * The ST low-level USB layer needs the HAL definitions and copies every
+ * packet through the FIFO from the interrupt, so the driver works on the
+ * CMSIS register definitions alone.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "UsbDev.h"
+#include <stddef.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "DmaPool.h"
+#include "IsrMgr.h"
+#include "stm32n6xx_ll_bus.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define USBDEV_CORE USB1_OTG_HS                   /**< OTG instance used */
+#define USBDEV_IRQ USB1_OTG_HS_IRQn               /**< Its interrupt */
+#define USBDEV_BASE ((uintptr_t)USB1_OTG_HS_BASE) /**< Base address of the core */
+#define USBDEV_DEVICE ((USB_OTG_DeviceTypeDef *)(USBDEV_BASE + USB_OTG_DEVICE_BASE)) /**< Device registers */
+/** IN endpoint @p n registers */
+#define USBDEV_INEP(n) ((USB_OTG_INEndpointTypeDef *)(USBDEV_BASE + USB_OTG_IN_ENDPOINT_BASE + ((n) * USB_OTG_EP_REG_SIZE)))
+/** OUT endpoint @p n registers */
+#define USBDEV_OUTEP(n) ((USB_OTG_OUTEndpointTypeDef *)(USBDEV_BASE + USB_OTG_OUT_ENDPOINT_BASE + ((n) * USB_OTG_EP_REG_SIZE)))
+#define USBDEV_PCGCCTL (*(__IO uint32_t *)(USBDEV_BASE + USB_OTG_PCGCCTL_BASE)) /**< Power and clock gating */
+#define USBDEV_PHY_FSEL_24MHZ (2UL << USB_USBPHYC_CR_FSEL_Pos) /**< PHY reference of HSE / 2 */
+#define USBDEV_EP_COUNT (4U)                      /**< Endpoints used in each direction, 0 to 3 */
+#define USBDEV_EP_NOTIFY (1U)                     /**< CDC notification endpoint */
+#define USBDEV_EP_CDC (2U)                        /**< CDC data endpoints */
+#define USBDEV_EP_TRACE (3U)                      /**< Trace endpoint */
+#define USBDEV_EP0_MPS (64U)                      /**< Control packet size */
+#define USBDEV_NOTIFY_MPS (16U)                   /**< Notification packet size */
+#define USBDEV_HS_MPS (512U)                      /**< Bulk packet size at high speed */
+#define USBDEV_FS_MPS (64U)                       /**< Bulk packet size at full speed */
+#define USBDEV_RX_FIFO_WORDS (256U)               /**< Shared receive FIFO */
+#define USBDEV_TX0_FIFO_WORDS (32U)               /**< Endpoint 0 transmit FIFO */
+#define USBDEV_TX1_FIFO_WORDS (16U)               /**< Notification transmit FIFO */
+#define USBDEV_TX2_FIFO_WORDS (256U)              /**< CDC transmit FIFO, two packets */
+#define USBDEV_TX3_FIFO_WORDS (384U)              /**< Trace transmit FIFO, three packets */
+#define USBDEV_TRDT_HS (9U)                       /**< Turnaround time at high speed, PHY clocks */
+#define USBDEV_TRDT_FS (6U)                       /**< Turnaround time at full speed with HCLK above 32 MHz */
+#define USBDEV_SPIN_LIMIT (1000000U)              /**< Polls of a core reset, FIFO flush or endpoint disable */
+#define USBDEV_FIFO_ALL (0x10U)                   /**< GRSTCTL TXFNUM selecting every transmit FIFO */
+#define USBDEV_INT_CLEAR (0xFB7FU)                /**< Every endpoint interrupt flag */
+#define USBDEV_EPTYP_BULK USB_OTG_DIEPCTL_EPTYP_1 /**< EPTYP of a bulk endpoint */
+#define USBDEV_EPTYP_INTR USB_OTG_DIEPCTL_EPTYP   /**< EPTYP of an interrupt endpoint */
+#define USBDEV_EP0_BUF_SIZE (256U)                /**< Control data buffer, largest descriptor */
+#define USBDEV_SETUP_SIZE (8U)                    /**< Bytes of a SETUP packet */
+#define USBDEV_CONFIG_SIZE (91U)                  /**< Bytes of the configuration descriptor set */
+#define USBDEV_IF_CDC_COMM (0U)                   /**< CDC communication interface */
+#define USBDEV_LINE_CODING_SIZE (7U)              /**< Bytes of a CDC line coding */
+/** Interrupts of the core taken by the driver */
+#define USBDEV_GINT_MASK (USB_OTG_GINTMSK_USBRST | USB_OTG_GINTMSK_ENUMDNEM | USB_OTG_GINTMSK_USBSUSPM | \
+                          USB_OTG_GINTMSK_WUIM | USB_OTG_GINTMSK_IEPINT | USB_OTG_GINTMSK_OEPINT | \
+                          USB_OTG_GINTMSK_OTGINT)
+/** OUT endpoint 0 armed for three back-to-back SETUP packets and one data packet */
+#define USBDEV_EP0_OUT_SIZE ((3UL << USB_OTG_DOEPTSIZ_STUPCNT_Pos) | (1UL << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | \
+                             USBDEV_EP0_MPS)
+
+#define USBDEV_REQ_GET_STATUS (0U)                /**< Standard request codes */
+#define USBDEV_REQ_CLEAR_FEATURE (1U)
+#define USBDEV_REQ_SET_FEATURE (3U)
+#define USBDEV_REQ_SET_ADDRESS (5U)
+#define USBDEV_REQ_GET_DESCRIPTOR (6U)
+#define USBDEV_REQ_GET_CONFIGURATION (8U)
+#define USBDEV_REQ_SET_CONFIGURATION (9U)
+#define USBDEV_REQ_GET_INTERFACE (10U)
+#define USBDEV_REQ_SET_INTERFACE (11U)
+#define USBDEV_CDC_SET_LINE_CODING (0x20U)        /**< CDC request codes */
+#define USBDEV_CDC_GET_LINE_CODING (0x21U)
+#define USBDEV_CDC_SET_CONTROL_LINE_STATE (0x22U)
+#define USBDEV_CDC_SEND_BREAK (0x23U)
+#define USBDEV_DESC_DEVICE (1U)                   /**< Descriptor types */
+#define USBDEV_DESC_CONFIG (2U)
+#define USBDEV_DESC_STRING (3U)
+#define USBDEV_DESC_ENDPOINT (5U)
+#define USBDEV_DESC_QUALIFIER (6U)
+#define USBDEV_DESC_OTHER_SPEED (7U)
+#define USBDEV_TYPE_MASK (0x60U)                  /**< bmRequestType type field */
+#define USBDEV_TYPE_STANDARD (0x00U)
+#define USBDEV_TYPE_CLASS (0x20U)
+#define USBDEV_RECIP_MASK (0x1FU)                 /**< bmRequestType recipient field */
+#define USBDEV_RECIP_INTERFACE (1U)
+#define USBDEV_RECIP_ENDPOINT (2U)
+#define USBDEV_FEATURE_HALT (0U)                  /**< ENDPOINT_HALT feature selector */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Stage of the control transfer on endpoint 0.
+ */
+typedef enum
+{
+    USBDEV_EP0_IDLE = 0,   /**< Waiting for a SETUP packet */
+    USBDEV_EP0_DATA_IN,    /**< Sending the data stage */
+    USBDEV_EP0_DATA_OUT,   /**< Receiving the data stage */
+    USBDEV_EP0_STATUS_IN,  /**< Zero-length status packet sent */
+    USBDEV_EP0_STATUS_OUT, /**< Waiting for the status packet of the host */
+} UsbDev_Ep0State_T;
+
+/**
+ * @brief Queued buffer.
+ */
+typedef struct
+{
+    const uint8_t *buf;    /**< Data */
+    uint32_t size;         /**< Bytes */
+    UsbDev_Callback_T cb;  /**< Completion callback, may be NULL */
+    void *ctx;             /**< Passed unchanged to @ref cb */
+} UsbDev_Request_T;
+
+/**
+ * @brief Outbound channel, the oldest request on its endpoint.
+ */
+typedef struct
+{
+    UsbDev_Request_T queue[USBDEV_QUEUE_LEN]; /**< Request ring */
+    uint32_t head;     /**< Index of the oldest request */
+    uint32_t count;    /**< Requests in the ring, the running one included */
+    bool busy;         /**< A transfer of the oldest request is on the endpoint */
+    uint32_t offset;   /**< Bytes of the oldest request already sent */
+    uint32_t chunk;    /**< Bytes of the transfer on the endpoint */
+    bool zlp_sent;     /**< The closing zero-length packet is on the endpoint */
+} UsbDev_Chan_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Device descriptor. */
+static const uint8_t g_usbDevDeviceDesc[18] = {
+    18U, USBDEV_DESC_DEVICE, 0x00U, 0x02U,     /* USB 2.0 */
+    0xEFU, 0x02U, 0x01U,                       /* Miscellaneous, interface association */
+    USBDEV_EP0_MPS,
+    (uint8_t)USBDEV_VID, (uint8_t)(USBDEV_VID >> 8), (uint8_t)USBDEV_PID, (uint8_t)(USBDEV_PID >> 8),
+    0x00U, 0x01U,                              /* Release 1.00 */
+    1U, 2U, 3U,                                /* Manufacturer, product, serial strings */
+    1U,                                        /* One configuration */
+};
+
+/** Device qualifier, the device at its other speed. */
+static const uint8_t g_usbDevQualifierDesc[10] = {
+    10U, USBDEV_DESC_QUALIFIER, 0x00U, 0x02U, 0xEFU, 0x02U, 0x01U, USBDEV_EP0_MPS, 1U, 0U,
+};
+
+/** Configuration descriptor set at high speed; packet sizes are patched for full speed. */
+static const uint8_t g_usbDevConfigDesc[USBDEV_CONFIG_SIZE] = {
+    /* Configuration 1: three interfaces, bus powered, 100 mA */
+    9U, USBDEV_DESC_CONFIG, USBDEV_CONFIG_SIZE, 0U, 3U, 1U, 0U, 0x80U, 50U,
+    /* Interface association: CDC-ACM on interfaces 0 and 1 */
+    8U, 11U, 0U, 2U, 0x02U, 0x02U, 0x01U, 0U,
+    /* Interface 0: CDC communication, abstract control model */
+    9U, 4U, 0U, 0U, 1U, 0x02U, 0x02U, 0x01U, 0U,
+    /* CDC header, release 1.10 */
+    5U, 0x24U, 0x00U, 0x10U, 0x01U,
+    /* CDC call management: none, data on interface 1 */
+    5U, 0x24U, 0x01U, 0x00U, 1U,
+    /* CDC abstract control management: line coding and control line state */
+    4U, 0x24U, 0x02U, 0x02U,
+    /* CDC union: interface 0 controls interface 1 */
+    5U, 0x24U, 0x06U, 0U, 1U,
+    /* Endpoint 1 IN: interrupt, notifications every 16 ms */
+    7U, USBDEV_DESC_ENDPOINT, 0x80U | USBDEV_EP_NOTIFY, 0x03U, USBDEV_NOTIFY_MPS, 0U, 8U,
+    /* Interface 1: CDC data */
+    9U, 4U, 1U, 0U, 2U, 0x0AU, 0x00U, 0x00U, 0U,
+    /* Endpoint 2 OUT: bulk */
+    7U, USBDEV_DESC_ENDPOINT, USBDEV_EP_CDC, 0x02U, (uint8_t)USBDEV_HS_MPS, (uint8_t)(USBDEV_HS_MPS >> 8), 0U,
+    /* Endpoint 2 IN: bulk */
+    7U, USBDEV_DESC_ENDPOINT, 0x80U | USBDEV_EP_CDC, 0x02U, (uint8_t)USBDEV_HS_MPS, (uint8_t)(USBDEV_HS_MPS >> 8), 0U,
+    /* Interface 2: vendor trace */
+    9U, 4U, 2U, 0U, 1U, 0xFFU, 0x00U, 0x00U, 4U,
+    /* Endpoint 3 IN: bulk */
+    7U, USBDEV_DESC_ENDPOINT, 0x80U | USBDEV_EP_TRACE, 0x02U, (uint8_t)USBDEV_HS_MPS, (uint8_t)(USBDEV_HS_MPS >> 8), 0U,
+};
+
+/** Strings 1 to 4 in ASCII, sent as UTF-16. */
+static const char *const g_usbDevStrings[] = {USBDEV_MANUFACTURER, USBDEV_PRODUCT, USBDEV_SERIAL, "Trace"};
+
+/** Up to three back-to-back SETUP packets, written by the core; padded to a cache line. */
+static uint8_t g_usbDevSetup[32U] __attribute__((section("noncacheable_buffer"), aligned(32)));
+/** Control data stage, both directions. */
+static uint8_t g_usbDevEp0Buf[USBDEV_EP0_BUF_SIZE] __attribute__((section("noncacheable_buffer"), aligned(32)));
+/** Packet received on the CDC OUT endpoint. */
+static uint8_t g_usbDevRxBuf[USBDEV_HS_MPS] __attribute__((section("noncacheable_buffer"), aligned(32)));
+/** Stage of the control transfer. */
+static UsbDev_Ep0State_T g_usbDevEp0State = USBDEV_EP0_IDLE;
+/** Bytes of the data stage still to send. */
+static uint32_t g_usbDevEp0Left = 0U;
+/** Bytes of the data stage sent. */
+static uint32_t g_usbDevEp0Sent = 0U;
+/** Bytes of the packet on endpoint 0. */
+static uint32_t g_usbDevEp0Packet = 0U;
+/** The data stage ends with a zero-length packet. */
+static bool g_usbDevEp0Zlp = false;
+/** Request whose OUT data stage is being received. */
+static uint8_t g_usbDevEp0Request = 0U;
+/** Bulk packet size of the enumerated speed. */
+static uint32_t g_usbDevMps = USBDEV_HS_MPS;
+/** Selected configuration, 0 when not configured. */
+static uint8_t g_usbDevConfig = 0U;
+/** State before the suspend. */
+static UsbDev_State_T g_usbDevResumeState = USBDEV_DETACHED;
+/** Outbound channels. */
+static UsbDev_Chan_T g_usbDevChan[USBDEV_CHANNELS];
+/** Receiver of the CDC OUT data. */
+static UsbDev_Receiver_T g_usbDevReceiver = NULL;
+/** Context of ::g_usbDevReceiver. */
+static void *g_usbDevReceiverCtx = NULL;
+/** Counters reported by ::UsbDev_GetStatus. */
+static UsbDev_Status_T g_usbDevStatus = {
+    .line = {.baudrate = 115200U, .stop_bits = 0U, .parity = 0U, .data_bits = 8U},
+};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Reset the core and wait for it. */
+static bool UsbDev_CoreReset(void);
+/** Flush the transmit FIFO @p num, ::USBDEV_FIFO_ALL for all of them. */
+static void UsbDev_FlushTx(uint32_t num);
+/** Set up the core as a device, endpoints idle. */
+static bool UsbDev_CoreInit(void);
+/** Endpoint of a channel. */
+static uint32_t UsbDev_ChannelEp(UsbDev_Channel_T ch);
+/** Program the next transfer of a channel, if any. Interrupts masked or from the OTG interrupt. */
+static void UsbDev_StartNext(UsbDev_Channel_T ch);
+/** End of a transfer on a channel endpoint. */
+static void UsbDev_ChannelDone(UsbDev_Channel_T ch);
+/** Stop a channel and fail its requests. */
+static void UsbDev_Abort(UsbDev_Channel_T ch);
+/** Disable an active IN endpoint and flush its FIFO. */
+static void UsbDev_StopIn(uint32_t ep);
+/** Activate or deactivate the endpoints of configuration 1. */
+static void UsbDev_Configure(uint8_t config);
+/** Arm the CDC OUT endpoint for one packet. */
+static void UsbDev_ArmRx(void);
+/** Arm OUT endpoint 0 for SETUP packets and one data packet into @p buf. */
+static void UsbDev_Ep0ArmOut(uint8_t *buf);
+/** Send the next packet of the data stage. */
+static void UsbDev_Ep0InPacket(void);
+/** Start the data stage of @p size bytes from ::g_usbDevEp0Buf, at most @p length. */
+static void UsbDev_Ep0Send(uint32_t size, uint16_t length);
+/** Send the zero-length status packet. */
+static void UsbDev_Ep0Status(void);
+/** Refuse the control request. */
+static void UsbDev_Ep0Stall(void);
+/** Copy a descriptor into ::g_usbDevEp0Buf, return its size or 0 when unknown. */
+static uint32_t UsbDev_Descriptor(uint8_t type, uint8_t index);
+/** Copy the configuration set for the speed in use or the other one. */
+static uint32_t UsbDev_ConfigDescriptor(uint8_t type, bool highSpeed);
+/** Handle a standard request, false to stall it. */
+static bool UsbDev_Standard(const uint8_t *setup);
+/** Handle a CDC request, false to stall it. */
+static bool UsbDev_Class(const uint8_t *setup);
+/** Handle a SETUP packet. */
+static void UsbDev_Setup(const uint8_t *setup);
+/** Bus reset. */
+static void UsbDev_BusReset(void);
+/** End of the speed enumeration after a reset. */
+static void UsbDev_EnumDone(void);
+/** OUT endpoint interrupts. */
+static void UsbDev_OutEndpoints(void);
+/** IN endpoint interrupts. */
+static void UsbDev_InEndpoints(void);
+/** OTG1 interrupt, bound through the ISR manager. */
+static void UsbDev_IrqHandler(void *ctx);
+/** Completion callback of the blocking call. */
+static void UsbDev_WakeWaiter(void *ctx, bool success);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Clock the core and its PHY from HSE / 2, set up the device and connect.
+ *
+ * VBUS sensing is overridden: the device always sees a valid session
+ * and the host detects it from the pull-up.
+ */
+bool UsbDev_Init(void)
+{
+    LL_RCC_SetOTGPHYClockSource(LL_RCC_OTGPHY1_CLKSOURCE_HSE_DIV_2);
+    LL_RCC_SetOTGPHYCKREFClockSource(LL_RCC_OTGPHY1CKREF_CLKSOURCE_HSE_DIV_2_OSC);
+    LL_AHB5_GRP1_EnableClock(LL_AHB5_GRP1_PERIPH_OTG1 | LL_AHB5_GRP1_PERIPH_OTGPHY1);
+    MODIFY_REG(USB1_HS_PHYC->USBPHYC_CR, USB_USBPHYC_CR_FSEL, USBDEV_PHY_FSEL_24MHZ);
+
+    if (!IsrMgr_Register(USBDEV_IRQ, UsbDev_IrqHandler, NULL))
+    {
+        return false;
+    }
+    if (!UsbDev_CoreInit())
+    {
+        return false;
+    }
+
+    NVIC_SetPriority(USBDEV_IRQ, NVIC_EncodePriority(NVIC_GetPriorityGrouping(),
+                                                     configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_EnableIRQ(USBDEV_IRQ);
+    SET_BIT(USBDEV_CORE->GAHBCFG, USB_OTG_GAHBCFG_GINT);
+
+    /* Soft connect: the pull-up on D+ tells the host a device is there */
+    CLEAR_BIT(USBDEV_DEVICE->DCTL, USB_OTG_DCTL_SDIS);
+    return true;
+}
+
+/**
+ * @brief Queue a buffer, starting its transfer if the endpoint is idle.
+ *
+ * Cache maintenance runs in the caller.
+ */
+bool UsbDev_Submit(UsbDev_Channel_T ch, const void *buf, uint32_t size, UsbDev_Callback_T cb, void *ctx)
+{
+    if ((ch >= USBDEV_CHANNELS) || (buf == NULL) || (size == 0U) || (((uintptr_t)buf & 3U) != 0U))
+    {
+        return false;
+    }
+    if (!DmaPool_IsNonCacheable(buf, size))
+    {
+        SCB_CleanDCache_by_Addr((void *)buf, (int32_t)size);
+    }
+
+    bool queued = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    UsbDev_Chan_T *chan = &g_usbDevChan[ch];
+    if (!UsbDev_IsOpen(ch))
+    {
+        /* Closed, nothing queued */
+    }
+    else if (chan->count < USBDEV_QUEUE_LEN)
+    {
+        UsbDev_Request_T *req = &chan->queue[(chan->head + chan->count) % USBDEV_QUEUE_LEN];
+        req->buf = (const uint8_t *)buf;
+        req->size = size;
+        req->cb = cb;
+        req->ctx = ctx;
+        chan->count++;
+        if (chan->count > g_usbDevStatus.queue_peak)
+        {
+            g_usbDevStatus.queue_peak = chan->count;
+        }
+        if (!chan->busy)
+        {
+            UsbDev_StartNext(ch);
+        }
+        queued = true;
+    }
+    else
+    {
+        g_usbDevStatus.queue_full++;
+    }
+    __set_PRIMASK(primask);
+
+    return queued;
+}
+
+/**
+ * @brief Queue a buffer and block until its callback.
+ */
+bool UsbDev_Transmit(UsbDev_Channel_T ch, const void *buf, uint32_t size)
+{
+    if ((buf == NULL) || (size == 0U) || (((uintptr_t)buf & 3U) != 0U))
+    {
+        return false;
+    }
+
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t value = 0U;
+
+    xTaskNotifyStateClearIndexed(self, USBDEV_NOTIFY_INDEX);
+    while (!UsbDev_Submit(ch, buf, size, UsbDev_WakeWaiter, self))
+    {
+        if (!UsbDev_IsOpen(ch))
+        {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    (void)xTaskNotifyWaitIndexed(USBDEV_NOTIFY_INDEX, 0U, UINT32_MAX, &value, portMAX_DELAY);
+
+    return value != 0U;
+}
+
+/**
+ * @brief The device is configured and, for the CDC channel, the port is open.
+ */
+bool UsbDev_IsOpen(UsbDev_Channel_T ch)
+{
+    if ((ch >= USBDEV_CHANNELS) || (g_usbDevStatus.state != USBDEV_CONFIGURED))
+    {
+        return false;
+    }
+    return (ch != USBDEV_CDC) || g_usbDevStatus.dtr;
+}
+
+/**
+ * @brief Install the receiver of the CDC port.
+ */
+void UsbDev_SetReceiver(UsbDev_Receiver_T receiver, void *ctx)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_usbDevReceiver = receiver;
+    g_usbDevReceiverCtx = ctx;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Copy the driver counters into @p status.
+ */
+void UsbDev_GetStatus(UsbDev_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_usbDevStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Reset the core once its AHB master is idle.
+ */
+static bool UsbDev_CoreReset(void)
+{
+    uint32_t spin = USBDEV_SPIN_LIMIT;
+
+    while (((READ_REG(USBDEV_CORE->GRSTCTL) & USB_OTG_GRSTCTL_AHBIDL) == 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    SET_BIT(USBDEV_CORE->GRSTCTL, USB_OTG_GRSTCTL_CSRST);
+    while (((READ_REG(USBDEV_CORE->GRSTCTL) & USB_OTG_GRSTCTL_CSRST) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    return spin > 0U;
+}
+
+/**
+ * @brief Flush a transmit FIFO and wait for the end of the flush.
+ */
+static void UsbDev_FlushTx(uint32_t num)
+{
+    uint32_t spin = USBDEV_SPIN_LIMIT;
+
+    WRITE_REG(USBDEV_CORE->GRSTCTL, USB_OTG_GRSTCTL_TXFFLSH | (num << USB_OTG_GRSTCTL_TXFNUM_Pos));
+    while (((READ_REG(USBDEV_CORE->GRSTCTL) & USB_OTG_GRSTCTL_TXFFLSH) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+}
+
+/**
+ * @brief Set up the core as a high-speed device with DMA, disconnected.
+ *
+ * The FIFO RAM is split once here: the receive FIFO shared by every OUT
+ * endpoint, then one transmit FIFO per IN endpoint.
+ */
+static bool UsbDev_CoreInit(void)
+{
+    uint32_t spin = USBDEV_SPIN_LIMIT;
+
+    WRITE_REG(USBDEV_CORE->GAHBCFG, 0U);
+    CLEAR_BIT(USBDEV_CORE->GUSBCFG, USB_OTG_GUSBCFG_TSDPS);
+    if (!UsbDev_CoreReset())
+    {
+        return false;
+    }
+    WRITE_REG(USBDEV_CORE->GAHBCFG, USB_OTG_GAHBCFG_HBSTLEN_2 | USB_OTG_GAHBCFG_DMAEN);
+
+    /* Force device mode and wait for the core to leave host mode */
+    MODIFY_REG(USBDEV_CORE->GUSBCFG, USB_OTG_GUSBCFG_TRDT | USB_OTG_GUSBCFG_FHMOD,
+               USB_OTG_GUSBCFG_FDMOD | (USBDEV_TRDT_HS << USB_OTG_GUSBCFG_TRDT_Pos));
+    while (((READ_REG(USBDEV_CORE->GINTSTS) & USB_OTG_GINTSTS_CMOD) != 0U) && (spin > 0U))
+    {
+        spin--;
+    }
+    if (spin == 0U)
+    {
+        return false;
+    }
+
+    SET_BIT(USBDEV_DEVICE->DCTL, USB_OTG_DCTL_SDIS);
+    CLEAR_BIT(USBDEV_CORE->GCCFG, USB_OTG_GCCFG_PULLDOWNEN);
+    SET_BIT(USBDEV_CORE->GCCFG, USB_OTG_GCCFG_VBVALEXTOEN | USB_OTG_GCCFG_VBVALOVAL);
+    WRITE_REG(USBDEV_PCGCCTL, 0U);
+    MODIFY_REG(USBDEV_DEVICE->DCFG, USB_OTG_DCFG_DSPD | USB_OTG_DCFG_DAD, 0U);
+
+    WRITE_REG(USBDEV_CORE->GRXFSIZ, USBDEV_RX_FIFO_WORDS);
+    WRITE_REG(USBDEV_CORE->DIEPTXF0_HNPTXFSIZ, (USBDEV_TX0_FIFO_WORDS << USB_OTG_TX0FD_Pos) | USBDEV_RX_FIFO_WORDS);
+    uint32_t start = USBDEV_RX_FIFO_WORDS + USBDEV_TX0_FIFO_WORDS;
+    WRITE_REG(USBDEV_CORE->DIEPTXF[0], (USBDEV_TX1_FIFO_WORDS << USB_OTG_DIEPTXF_INEPTXFD_Pos) | start);
+    start += USBDEV_TX1_FIFO_WORDS;
+    WRITE_REG(USBDEV_CORE->DIEPTXF[1], (USBDEV_TX2_FIFO_WORDS << USB_OTG_DIEPTXF_INEPTXFD_Pos) | start);
+    start += USBDEV_TX2_FIFO_WORDS;
+    WRITE_REG(USBDEV_CORE->DIEPTXF[2], (USBDEV_TX3_FIFO_WORDS << USB_OTG_DIEPTXF_INEPTXFD_Pos) | start);
+    UsbDev_FlushTx(USBDEV_FIFO_ALL);
+
+    WRITE_REG(USBDEV_DEVICE->DIEPMSK, 0U);
+    WRITE_REG(USBDEV_DEVICE->DOEPMSK, 0U);
+    WRITE_REG(USBDEV_DEVICE->DAINTMSK, 0U);
+    for (uint32_t ep = 0U; ep < USBDEV_EP_COUNT; ep++)
+    {
+        WRITE_REG(USBDEV_INEP(ep)->DIEPCTL, USB_OTG_DIEPCTL_SNAK);
+        WRITE_REG(USBDEV_INEP(ep)->DIEPTSIZ, 0U);
+        WRITE_REG(USBDEV_INEP(ep)->DIEPINT, USBDEV_INT_CLEAR);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPCTL, USB_OTG_DOEPCTL_SNAK);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPTSIZ, 0U);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPINT, USBDEV_INT_CLEAR);
+    }
+
+    WRITE_REG(USBDEV_CORE->GINTMSK, 0U);
+    WRITE_REG(USBDEV_CORE->GINTSTS, 0xBFFFFFFFUL);
+    WRITE_REG(USBDEV_CORE->GINTMSK, USBDEV_GINT_MASK);
+    return true;
+}
+
+/**
+ * @brief IN endpoint of a channel.
+ */
+static uint32_t UsbDev_ChannelEp(UsbDev_Channel_T ch)
+{
+    return (ch == USBDEV_CDC) ? USBDEV_EP_CDC : USBDEV_EP_TRACE;
+}
+
+/**
+ * @brief Program the next transfer of the oldest request of a channel.
+ *
+ * A transfer carries at most ::USBDEV_MAX_PACKETS packets; its last
+ * packet is short unless the request ends on a packet boundary. After
+ * the last byte of a CDC request of a whole number of packets, a
+ * zero-length packet is sent.
+ */
+static void UsbDev_StartNext(UsbDev_Channel_T ch)
+{
+    UsbDev_Chan_T *chan = &g_usbDevChan[ch];
+    uint32_t ep = UsbDev_ChannelEp(ch);
+
+    if (chan->count == 0U)
+    {
+        chan->busy = false;
+        return;
+    }
+
+    const UsbDev_Request_T *req = &chan->queue[chan->head];
+    uint32_t left = req->size - chan->offset;
+    uint32_t chunk = USBDEV_MAX_PACKETS * g_usbDevMps;
+    if (left < chunk)
+    {
+        chunk = left;
+    }
+    uint32_t packets = (chunk == 0U) ? 1U : ((chunk + g_usbDevMps - 1U) / g_usbDevMps);
+
+    chan->busy = true;
+    chan->chunk = chunk;
+    chan->zlp_sent = (chunk == 0U);
+    if (chan->zlp_sent)
+    {
+        g_usbDevStatus.zlps++;
+    }
+    g_usbDevStatus.transfers++;
+
+    WRITE_REG(USBDEV_INEP(ep)->DIEPTSIZ, (packets << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | chunk);
+    WRITE_REG(USBDEV_INEP(ep)->DIEPDMA, (uint32_t)(uintptr_t)(req->buf + chan->offset));
+    SET_BIT(USBDEV_INEP(ep)->DIEPCTL, USB_OTG_DIEPCTL_CNAK | USB_OTG_DIEPCTL_EPENA);
+}
+
+/**
+ * @brief End of a transfer: continue the request or complete it.
+ */
+static void UsbDev_ChannelDone(UsbDev_Channel_T ch)
+{
+    UsbDev_Chan_T *chan = &g_usbDevChan[ch];
+
+    if (!chan->busy || (chan->count == 0U))
+    {
+        return;
+    }
+
+    UsbDev_Request_T req = chan->queue[chan->head];
+    chan->offset += chan->chunk;
+    if ((chan->offset < req.size) ||
+        ((ch == USBDEV_CDC) && !chan->zlp_sent && ((req.size % g_usbDevMps) == 0U)))
+    {
+        UsbDev_StartNext(ch);
+        return;
+    }
+
+    chan->head = (chan->head + 1U) % USBDEV_QUEUE_LEN;
+    chan->count--;
+    chan->offset = 0U;
+    g_usbDevStatus.requests_done++;
+    g_usbDevStatus.bytes[ch] += req.size;
+    UsbDev_StartNext(ch);
+
+    if (req.cb != NULL)
+    {
+        req.cb(req.ctx, true);
+    }
+}
+
+/**
+ * @brief Stop a channel and end its requests with a failure.
+ *
+ * The callbacks run after the ring is emptied, so a callback submitting
+ * again sees a consistent channel.
+ */
+static void UsbDev_Abort(UsbDev_Channel_T ch)
+{
+    UsbDev_Chan_T *chan = &g_usbDevChan[ch];
+    UsbDev_Request_T reqs[USBDEV_QUEUE_LEN];
+    uint32_t count = chan->count;
+
+    if (chan->busy)
+    {
+        UsbDev_StopIn(UsbDev_ChannelEp(ch));
+    }
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        reqs[i] = chan->queue[(chan->head + i) % USBDEV_QUEUE_LEN];
+    }
+    chan->head = 0U;
+    chan->count = 0U;
+    chan->busy = false;
+    chan->offset = 0U;
+    g_usbDevStatus.requests_failed += count;
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        if (reqs[i].cb != NULL)
+        {
+            reqs[i].cb(reqs[i].ctx, false);
+        }
+    }
+}
+
+/**
+ * @brief Disable an IN endpoint with a transfer pending and flush its FIFO.
+ */
+static void UsbDev_StopIn(uint32_t ep)
+{
+    uint32_t spin = USBDEV_SPIN_LIMIT;
+
+    if ((READ_REG(USBDEV_INEP(ep)->DIEPCTL) & USB_OTG_DIEPCTL_EPENA) != 0U)
+    {
+        SET_BIT(USBDEV_INEP(ep)->DIEPCTL, USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS);
+        while (((READ_REG(USBDEV_INEP(ep)->DIEPINT) & USB_OTG_DIEPINT_EPDISD) == 0U) && (spin > 0U))
+        {
+            spin--;
+        }
+        WRITE_REG(USBDEV_INEP(ep)->DIEPINT, USB_OTG_DIEPINT_EPDISD | USB_OTG_DIEPINT_XFRC);
+    }
+    UsbDev_FlushTx(ep);
+}
+
+/**
+ * @brief Select configuration 1 or go back to the addressed state.
+ *
+ * Every endpoint starts with DATA0. The notification endpoint is active
+ * but never armed, so the host only gets NAKs on it.
+ */
+static void UsbDev_Configure(uint8_t config)
+{
+    uint32_t bulk = g_usbDevMps | USBDEV_EPTYP_BULK | USB_OTG_DIEPCTL_SD0PID_SEVNFRM | USB_OTG_DIEPCTL_USBAEP |
+                    USB_OTG_DIEPCTL_SNAK;
+
+    for (uint32_t ch = 0U; ch < (uint32_t)USBDEV_CHANNELS; ch++)
+    {
+        UsbDev_Abort((UsbDev_Channel_T)ch);
+    }
+    g_usbDevConfig = config;
+    g_usbDevStatus.dtr = false;
+
+    if (config == 0U)
+    {
+        for (uint32_t ep = 1U; ep < USBDEV_EP_COUNT; ep++)
+        {
+            WRITE_REG(USBDEV_INEP(ep)->DIEPCTL, USB_OTG_DIEPCTL_SNAK);
+        }
+        if ((READ_REG(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPCTL) & USB_OTG_DOEPCTL_EPENA) != 0U)
+        {
+            SET_BIT(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPCTL, USB_OTG_DOEPCTL_SNAK | USB_OTG_DOEPCTL_EPDIS);
+        }
+        WRITE_REG(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPCTL, USB_OTG_DOEPCTL_SNAK);
+        WRITE_REG(USBDEV_DEVICE->DAINTMSK, (1UL << 0) | (1UL << (USB_OTG_DAINTMSK_OEPM_Pos + 0U)));
+        g_usbDevStatus.state = USBDEV_ADDRESSED;
+        return;
+    }
+
+    WRITE_REG(USBDEV_INEP(USBDEV_EP_NOTIFY)->DIEPCTL,
+              USBDEV_NOTIFY_MPS | USBDEV_EPTYP_INTR | (USBDEV_EP_NOTIFY << USB_OTG_DIEPCTL_TXFNUM_Pos) |
+                  USB_OTG_DIEPCTL_SD0PID_SEVNFRM | USB_OTG_DIEPCTL_USBAEP | USB_OTG_DIEPCTL_SNAK);
+    WRITE_REG(USBDEV_INEP(USBDEV_EP_CDC)->DIEPCTL, bulk | (USBDEV_EP_CDC << USB_OTG_DIEPCTL_TXFNUM_Pos));
+    WRITE_REG(USBDEV_INEP(USBDEV_EP_TRACE)->DIEPCTL, bulk | (USBDEV_EP_TRACE << USB_OTG_DIEPCTL_TXFNUM_Pos));
+    WRITE_REG(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPCTL, bulk);
+    WRITE_REG(USBDEV_DEVICE->DAINTMSK, (1UL << 0) | (1UL << USBDEV_EP_CDC) | (1UL << USBDEV_EP_TRACE) |
+                                           (1UL << (USB_OTG_DAINTMSK_OEPM_Pos + 0U)) |
+                                           (1UL << (USB_OTG_DAINTMSK_OEPM_Pos + USBDEV_EP_CDC)));
+    UsbDev_ArmRx();
+    g_usbDevStatus.state = USBDEV_CONFIGURED;
+}
+
+/**
+ * @brief Arm the CDC OUT endpoint for one packet into ::g_usbDevRxBuf.
+ */
+static void UsbDev_ArmRx(void)
+{
+    WRITE_REG(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPTSIZ, (1UL << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | g_usbDevMps);
+    WRITE_REG(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPDMA, (uint32_t)(uintptr_t)g_usbDevRxBuf);
+    SET_BIT(USBDEV_OUTEP(USBDEV_EP_CDC)->DOEPCTL, USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA);
+}
+
+/**
+ * @brief Arm OUT endpoint 0.
+ *
+ * SETUP packets are always accepted; the core stores them one after
+ * the other from the programmed address, so the last one is the 8 bytes
+ * before DOEPDMA.
+ */
+static void UsbDev_Ep0ArmOut(uint8_t *buf)
+{
+    WRITE_REG(USBDEV_OUTEP(0U)->DOEPTSIZ, USBDEV_EP0_OUT_SIZE);
+    WRITE_REG(USBDEV_OUTEP(0U)->DOEPDMA, (uint32_t)(uintptr_t)buf);
+    SET_BIT(USBDEV_OUTEP(0U)->DOEPCTL, USB_OTG_DOEPCTL_CNAK | USB_OTG_DOEPCTL_EPENA);
+}
+
+/**
+ * @brief Send the next packet of the data stage, a zero-length one when nothing is left.
+ */
+static void UsbDev_Ep0InPacket(void)
+{
+    uint32_t size = (g_usbDevEp0Left < USBDEV_EP0_MPS) ? g_usbDevEp0Left : USBDEV_EP0_MPS;
+
+    g_usbDevEp0Packet = size;
+    WRITE_REG(USBDEV_INEP(0U)->DIEPTSIZ, (1UL << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | size);
+    WRITE_REG(USBDEV_INEP(0U)->DIEPDMA, (uint32_t)(uintptr_t)&g_usbDevEp0Buf[g_usbDevEp0Sent]);
+    SET_BIT(USBDEV_INEP(0U)->DIEPCTL, USB_OTG_DIEPCTL_CNAK | USB_OTG_DIEPCTL_EPENA);
+}
+
+/**
+ * @brief Start the data stage.
+ *
+ * The host asked for @p length bytes; a shorter answer that ends on a
+ * packet boundary is closed with a zero-length packet. OUT endpoint 0
+ * is armed for the status stage.
+ */
+static void UsbDev_Ep0Send(uint32_t size, uint16_t length)
+{
+    g_usbDevEp0Left = (size < length) ? size : length;
+    g_usbDevEp0Sent = 0U;
+    g_usbDevEp0Zlp = (g_usbDevEp0Left < length) && ((g_usbDevEp0Left % USBDEV_EP0_MPS) == 0U);
+    g_usbDevEp0State = USBDEV_EP0_DATA_IN;
+    UsbDev_Ep0InPacket();
+    UsbDev_Ep0ArmOut(g_usbDevSetup);
+}
+
+/**
+ * @brief Send the zero-length status packet of a request without IN data.
+ */
+static void UsbDev_Ep0Status(void)
+{
+    g_usbDevEp0Left = 0U;
+    g_usbDevEp0Sent = 0U;
+    g_usbDevEp0State = USBDEV_EP0_STATUS_IN;
+    UsbDev_Ep0InPacket();
+}
+
+/**
+ * @brief Stall both directions of endpoint 0 until the next SETUP packet.
+ */
+static void UsbDev_Ep0Stall(void)
+{
+    g_usbDevStatus.stalls++;
+    g_usbDevEp0State = USBDEV_EP0_IDLE;
+    SET_BIT(USBDEV_INEP(0U)->DIEPCTL, USB_OTG_DIEPCTL_STALL);
+    SET_BIT(USBDEV_OUTEP(0U)->DOEPCTL, USB_OTG_DOEPCTL_STALL);
+    UsbDev_Ep0ArmOut(g_usbDevSetup);
+}
+
+/**
+ * @brief Copy a descriptor into ::g_usbDevEp0Buf.
+ *
+ * The device qualifier and the other-speed configuration only exist
+ * while running at high speed.
+ *
+ * @return Descriptor size, 0 when the device has no such descriptor.
+ */
+static uint32_t UsbDev_Descriptor(uint8_t type, uint8_t index)
+{
+    switch (type)
+    {
+    case USBDEV_DESC_DEVICE:
+        (void)memcpy(g_usbDevEp0Buf, g_usbDevDeviceDesc, sizeof(g_usbDevDeviceDesc));
+        return sizeof(g_usbDevDeviceDesc);
+
+    case USBDEV_DESC_CONFIG:
+        return (index == 0U) ? UsbDev_ConfigDescriptor(type, g_usbDevStatus.high_speed) : 0U;
+
+    case USBDEV_DESC_OTHER_SPEED:
+        return ((index == 0U) && g_usbDevStatus.high_speed) ? UsbDev_ConfigDescriptor(type, false) : 0U;
+
+    case USBDEV_DESC_QUALIFIER:
+        if (!g_usbDevStatus.high_speed)
+        {
+            return 0U;
+        }
+        (void)memcpy(g_usbDevEp0Buf, g_usbDevQualifierDesc, sizeof(g_usbDevQualifierDesc));
+        return sizeof(g_usbDevQualifierDesc);
+
+    case USBDEV_DESC_STRING:
+        if (index == 0U)
+        {
+            /* Language list: English (United States) */
+            g_usbDevEp0Buf[0] = 4U;
+            g_usbDevEp0Buf[1] = USBDEV_DESC_STRING;
+            g_usbDevEp0Buf[2] = 0x09U;
+            g_usbDevEp0Buf[3] = 0x04U;
+            return 4U;
+        }
+        if (index <= (sizeof(g_usbDevStrings) / sizeof(g_usbDevStrings[0])))
+        {
+            const char *text = g_usbDevStrings[index - 1U];
+            uint32_t size = 2U;
+            while ((*text != '\0') && (size < (USBDEV_EP0_BUF_SIZE - 1U)))
+            {
+                g_usbDevEp0Buf[size++] = (uint8_t)*text++;
+                g_usbDevEp0Buf[size++] = 0U;
+            }
+            g_usbDevEp0Buf[0] = (uint8_t)size;
+            g_usbDevEp0Buf[1] = USBDEV_DESC_STRING;
+            return size;
+        }
+        return 0U;
+
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Copy the configuration set with the packet sizes of a speed.
+ *
+ * @param[in] type      ::USBDEV_DESC_CONFIG or ::USBDEV_DESC_OTHER_SPEED.
+ * @param[in] highSpeed Packet sizes and intervals for high speed.
+ */
+static uint32_t UsbDev_ConfigDescriptor(uint8_t type, bool highSpeed)
+{
+    (void)memcpy(g_usbDevEp0Buf, g_usbDevConfigDesc, USBDEV_CONFIG_SIZE);
+    g_usbDevEp0Buf[1] = type;
+
+    for (uint32_t at = 0U; at < USBDEV_CONFIG_SIZE; at += g_usbDevEp0Buf[at])
+    {
+        uint8_t *desc = &g_usbDevEp0Buf[at];
+        if (desc[1] != USBDEV_DESC_ENDPOINT)
+        {
+            continue;
+        }
+        if (desc[3] == 0x02U)
+        {
+            uint32_t mps = highSpeed ? USBDEV_HS_MPS : USBDEV_FS_MPS;
+            desc[4] = (uint8_t)mps;
+            desc[5] = (uint8_t)(mps >> 8);
+        }
+        else
+        {
+            /* 2^(8-1) microframes at high speed, milliseconds at full speed */
+            desc[6] = highSpeed ? 8U : 16U;
+        }
+    }
+    return USBDEV_CONFIG_SIZE;
+}
+
+/**
+ * @brief Handle a standard request.
+ *
+ * SET_ADDRESS takes effect at once: the core still answers the status
+ * stage on the old address.
+ */
+static bool UsbDev_Standard(const uint8_t *setup)
+{
+    uint8_t recipient = setup[0] & USBDEV_RECIP_MASK;
+    uint16_t value = (uint16_t)(setup[2] | (setup[3] << 8));
+    uint16_t index = (uint16_t)(setup[4] | (setup[5] << 8));
+    uint16_t length = (uint16_t)(setup[6] | (setup[7] << 8));
+    uint32_t ep = index & 0x0FU;
+    bool in = (index & 0x80U) != 0U;
+
+    switch (setup[1])
+    {
+    case USBDEV_REQ_GET_STATUS:
+        g_usbDevEp0Buf[0] = 0U;
+        g_usbDevEp0Buf[1] = 0U;
+        if ((recipient == USBDEV_RECIP_ENDPOINT) && (ep < USBDEV_EP_COUNT))
+        {
+            uint32_t ctl = in ? READ_REG(USBDEV_INEP(ep)->DIEPCTL) : READ_REG(USBDEV_OUTEP(ep)->DOEPCTL);
+            g_usbDevEp0Buf[0] = ((ctl & USB_OTG_DIEPCTL_STALL) != 0U) ? 1U : 0U;
+        }
+        UsbDev_Ep0Send(2U, length);
+        return true;
+
+    case USBDEV_REQ_CLEAR_FEATURE:
+    case USBDEV_REQ_SET_FEATURE:
+        if ((recipient == USBDEV_RECIP_ENDPOINT) && (value == USBDEV_FEATURE_HALT))
+        {
+            if (ep >= USBDEV_EP_COUNT)
+            {
+                return false;
+            }
+            /* Endpoint 0 is never halted, a STALL there only ends the current request */
+            __IO uint32_t *ctl = in ? &USBDEV_INEP(ep)->DIEPCTL : &USBDEV_OUTEP(ep)->DOEPCTL;
+            if ((ep != 0U) && (setup[1] == USBDEV_REQ_SET_FEATURE))
+            {
+                SET_BIT(*ctl, USB_OTG_DIEPCTL_STALL);
+            }
+            else if (ep != 0U)
+            {
+                CLEAR_BIT(*ctl, USB_OTG_DIEPCTL_STALL);
+                SET_BIT(*ctl, USB_OTG_DIEPCTL_SD0PID_SEVNFRM);
+            }
+        }
+        UsbDev_Ep0Status();
+        return true;
+
+    case USBDEV_REQ_SET_ADDRESS:
+        MODIFY_REG(USBDEV_DEVICE->DCFG, USB_OTG_DCFG_DAD, ((uint32_t)value & 0x7FU) << USB_OTG_DCFG_DAD_Pos);
+        g_usbDevStatus.address = (uint8_t)(value & 0x7FU);
+        g_usbDevStatus.state = (g_usbDevStatus.address != 0U) ? USBDEV_ADDRESSED : USBDEV_DEFAULT;
+        UsbDev_Ep0Status();
+        return true;
+
+    case USBDEV_REQ_GET_DESCRIPTOR:
+    {
+        uint32_t size = UsbDev_Descriptor((uint8_t)(value >> 8), (uint8_t)value);
+        if (size == 0U)
+        {
+            return false;
+        }
+        UsbDev_Ep0Send(size, length);
+        return true;
+    }
+
+    case USBDEV_REQ_GET_CONFIGURATION:
+        g_usbDevEp0Buf[0] = g_usbDevConfig;
+        UsbDev_Ep0Send(1U, length);
+        return true;
+
+    case USBDEV_REQ_SET_CONFIGURATION:
+        if ((value > 1U) || (g_usbDevStatus.state < USBDEV_ADDRESSED))
+        {
+            return false;
+        }
+        UsbDev_Configure((uint8_t)value);
+        UsbDev_Ep0Status();
+        return true;
+
+    case USBDEV_REQ_GET_INTERFACE:
+        g_usbDevEp0Buf[0] = 0U;
+        UsbDev_Ep0Send(1U, length);
+        return true;
+
+    case USBDEV_REQ_SET_INTERFACE:
+        if (value != 0U)
+        {
+            return false;
+        }
+        UsbDev_Ep0Status();
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Handle a CDC request to the communication interface.
+ *
+ * Dropping DTR ends the requests queued on the CDC channel: the host
+ * stops reading the endpoint once the port is closed.
+ */
+static bool UsbDev_Class(const uint8_t *setup)
+{
+    uint16_t value = (uint16_t)(setup[2] | (setup[3] << 8));
+    uint16_t length = (uint16_t)(setup[6] | (setup[7] << 8));
+
+    switch (setup[1])
+    {
+    case USBDEV_CDC_SET_LINE_CODING:
+        if (length < USBDEV_LINE_CODING_SIZE)
+        {
+            return false;
+        }
+        g_usbDevEp0Request = setup[1];
+        g_usbDevEp0State = USBDEV_EP0_DATA_OUT;
+        UsbDev_Ep0ArmOut(g_usbDevEp0Buf);
+        return true;
+
+    case USBDEV_CDC_GET_LINE_CODING:
+    {
+        uint32_t baud = g_usbDevStatus.line.baudrate;
+        g_usbDevEp0Buf[0] = (uint8_t)baud;
+        g_usbDevEp0Buf[1] = (uint8_t)(baud >> 8);
+        g_usbDevEp0Buf[2] = (uint8_t)(baud >> 16);
+        g_usbDevEp0Buf[3] = (uint8_t)(baud >> 24);
+        g_usbDevEp0Buf[4] = g_usbDevStatus.line.stop_bits;
+        g_usbDevEp0Buf[5] = g_usbDevStatus.line.parity;
+        g_usbDevEp0Buf[6] = g_usbDevStatus.line.data_bits;
+        UsbDev_Ep0Send(USBDEV_LINE_CODING_SIZE, length);
+        return true;
+    }
+
+    case USBDEV_CDC_SET_CONTROL_LINE_STATE:
+    {
+        bool dtr = (value & 1U) != 0U;
+        if (g_usbDevStatus.dtr && !dtr)
+        {
+            g_usbDevStatus.dtr = false;
+            UsbDev_Abort(USBDEV_CDC);
+        }
+        g_usbDevStatus.dtr = dtr;
+        UsbDev_Ep0Status();
+        return true;
+    }
+
+    case USBDEV_CDC_SEND_BREAK:
+        UsbDev_Ep0Status();
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Dispatch a SETUP packet; a new SETUP ends any control transfer in progress.
+ */
+static void UsbDev_Setup(const uint8_t *setup)
+{
+    bool handled = false;
+    uint16_t index = (uint16_t)(setup[4] | (setup[5] << 8));
+
+    g_usbDevStatus.setups++;
+    g_usbDevEp0State = USBDEV_EP0_IDLE;
+
+    if ((setup[0] & USBDEV_TYPE_MASK) == USBDEV_TYPE_STANDARD)
+    {
+        handled = UsbDev_Standard(setup);
+    }
+    else if (((setup[0] & USBDEV_TYPE_MASK) == USBDEV_TYPE_CLASS) &&
+             ((setup[0] & USBDEV_RECIP_MASK) == USBDEV_RECIP_INTERFACE) && (index == USBDEV_IF_CDC_COMM))
+    {
+        handled = UsbDev_Class(setup);
+    }
+
+    if (!handled)
+    {
+        UsbDev_Ep0Stall();
+    }
+    else if (g_usbDevEp0State == USBDEV_EP0_STATUS_IN)
+    {
+        UsbDev_Ep0ArmOut(g_usbDevSetup);
+    }
+}
+
+/**
+ * @brief Bus reset: back to address 0 with only endpoint 0.
+ */
+static void UsbDev_BusReset(void)
+{
+    CLEAR_BIT(USBDEV_DEVICE->DCTL, USB_OTG_DCTL_RWUSIG);
+    for (uint32_t ch = 0U; ch < (uint32_t)USBDEV_CHANNELS; ch++)
+    {
+        UsbDev_Abort((UsbDev_Channel_T)ch);
+    }
+    UsbDev_FlushTx(USBDEV_FIFO_ALL);
+
+    for (uint32_t ep = 0U; ep < USBDEV_EP_COUNT; ep++)
+    {
+        WRITE_REG(USBDEV_INEP(ep)->DIEPINT, USBDEV_INT_CLEAR);
+        WRITE_REG(USBDEV_INEP(ep)->DIEPCTL, USB_OTG_DIEPCTL_SNAK);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPINT, USBDEV_INT_CLEAR);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPCTL, USB_OTG_DOEPCTL_SNAK);
+    }
+    WRITE_REG(USBDEV_DEVICE->DIEPMSK, USB_OTG_DIEPMSK_XFRCM | USB_OTG_DIEPMSK_TOM | USB_OTG_DIEPMSK_EPDM);
+    WRITE_REG(USBDEV_DEVICE->DOEPMSK, USB_OTG_DOEPMSK_XFRCM | USB_OTG_DOEPMSK_STUPM | USB_OTG_DOEPMSK_EPDM);
+    WRITE_REG(USBDEV_DEVICE->DAINTMSK, (1UL << 0) | (1UL << (USB_OTG_DAINTMSK_OEPM_Pos + 0U)));
+    MODIFY_REG(USBDEV_DEVICE->DCFG, USB_OTG_DCFG_DAD, 0U);
+
+    g_usbDevConfig = 0U;
+    g_usbDevEp0State = USBDEV_EP0_IDLE;
+    g_usbDevStatus.state = USBDEV_DEFAULT;
+    g_usbDevStatus.address = 0U;
+    g_usbDevStatus.dtr = false;
+    g_usbDevStatus.resets++;
+    UsbDev_Ep0ArmOut(g_usbDevSetup);
+}
+
+/**
+ * @brief Speed known: set the packet sizes and the turnaround time.
+ */
+static void UsbDev_EnumDone(void)
+{
+    bool highSpeed = (READ_REG(USBDEV_DEVICE->DSTS) & USB_OTG_DSTS_ENUMSPD) == 0U;
+
+    g_usbDevStatus.high_speed = highSpeed;
+    g_usbDevMps = highSpeed ? USBDEV_HS_MPS : USBDEV_FS_MPS;
+    MODIFY_REG(USBDEV_CORE->GUSBCFG, USB_OTG_GUSBCFG_TRDT,
+               (highSpeed ? USBDEV_TRDT_HS : USBDEV_TRDT_FS) << USB_OTG_GUSBCFG_TRDT_Pos);
+    /* MPSIZ 0 on endpoint 0 is 64 bytes */
+    CLEAR_BIT(USBDEV_INEP(0U)->DIEPCTL, USB_OTG_DIEPCTL_MPSIZ);
+    SET_BIT(USBDEV_DEVICE->DCTL, USB_OTG_DCTL_CGINAK);
+}
+
+/**
+ * @brief OUT endpoints: SETUP packets and received data.
+ */
+static void UsbDev_OutEndpoints(void)
+{
+    uint32_t daint = READ_REG(USBDEV_DEVICE->DAINT) & READ_REG(USBDEV_DEVICE->DAINTMSK);
+
+    for (uint32_t ep = 0U; ep < USBDEV_EP_COUNT; ep++)
+    {
+        if ((daint & (1UL << (USB_OTG_DAINTMSK_OEPM_Pos + ep))) == 0U)
+        {
+            continue;
+        }
+        uint32_t raw = READ_REG(USBDEV_OUTEP(ep)->DOEPINT);
+        uint32_t flags = raw & READ_REG(USBDEV_DEVICE->DOEPMSK);
+        WRITE_REG(USBDEV_OUTEP(ep)->DOEPINT, raw);
+
+        if ((flags & USB_OTG_DOEPINT_XFRC) != 0U)
+        {
+            if (ep == USBDEV_EP_CDC)
+            {
+                uint32_t size = g_usbDevMps - (READ_REG(USBDEV_OUTEP(ep)->DOEPTSIZ) & USB_OTG_DOEPTSIZ_XFRSIZ);
+                g_usbDevStatus.rx_bytes += size;
+                if (g_usbDevReceiver != NULL)
+                {
+                    g_usbDevReceiver(g_usbDevReceiverCtx, g_usbDevRxBuf, size);
+                }
+                UsbDev_ArmRx();
+            }
+            else if (ep == 0U)
+            {
+                if ((g_usbDevEp0State == USBDEV_EP0_DATA_OUT) && (g_usbDevEp0Request == USBDEV_CDC_SET_LINE_CODING))
+                {
+                    g_usbDevStatus.line.baudrate = (uint32_t)g_usbDevEp0Buf[0] | ((uint32_t)g_usbDevEp0Buf[1] << 8) |
+                                                   ((uint32_t)g_usbDevEp0Buf[2] << 16) |
+                                                   ((uint32_t)g_usbDevEp0Buf[3] << 24);
+                    g_usbDevStatus.line.stop_bits = g_usbDevEp0Buf[4];
+                    g_usbDevStatus.line.parity = g_usbDevEp0Buf[5];
+                    g_usbDevStatus.line.data_bits = g_usbDevEp0Buf[6];
+                    UsbDev_Ep0Status();
+                }
+                else
+                {
+                    g_usbDevEp0State = USBDEV_EP0_IDLE;
+                }
+                UsbDev_Ep0ArmOut(g_usbDevSetup);
+            }
+        }
+        if ((ep == 0U) && ((flags & USB_OTG_DOEPINT_STUP) != 0U))
+        {
+            uint32_t next = READ_REG(USBDEV_OUTEP(0U)->DOEPDMA);
+            UsbDev_Setup((const uint8_t *)(uintptr_t)(next - USBDEV_SETUP_SIZE));
+        }
+    }
+}
+
+/**
+ * @brief IN endpoints: end of transfers.
+ */
+static void UsbDev_InEndpoints(void)
+{
+    uint32_t daint = READ_REG(USBDEV_DEVICE->DAINT) & READ_REG(USBDEV_DEVICE->DAINTMSK);
+
+    for (uint32_t ep = 0U; ep < USBDEV_EP_COUNT; ep++)
+    {
+        if ((daint & (1UL << ep)) == 0U)
+        {
+            continue;
+        }
+        uint32_t flags = READ_REG(USBDEV_INEP(ep)->DIEPINT) & READ_REG(USBDEV_DEVICE->DIEPMSK);
+        WRITE_REG(USBDEV_INEP(ep)->DIEPINT, flags);
+        if ((flags & USB_OTG_DIEPINT_XFRC) == 0U)
+        {
+            continue;
+        }
+
+        if (ep == USBDEV_EP_CDC)
+        {
+            UsbDev_ChannelDone(USBDEV_CDC);
+        }
+        else if (ep == USBDEV_EP_TRACE)
+        {
+            UsbDev_ChannelDone(USBDEV_TRACE);
+        }
+        else if ((ep == 0U) && (g_usbDevEp0State == USBDEV_EP0_DATA_IN))
+        {
+            g_usbDevEp0Sent += g_usbDevEp0Packet;
+            g_usbDevEp0Left -= g_usbDevEp0Packet;
+            if ((g_usbDevEp0Left > 0U) || g_usbDevEp0Zlp)
+            {
+                g_usbDevEp0Zlp = g_usbDevEp0Zlp && (g_usbDevEp0Left > 0U);
+                UsbDev_Ep0InPacket();
+            }
+            else
+            {
+                g_usbDevEp0State = USBDEV_EP0_STATUS_OUT;
+            }
+        }
+        else if (ep == 0U)
+        {
+            g_usbDevEp0State = USBDEV_EP0_IDLE;
+        }
+    }
+}
+
+/**
+ * @brief OTG1 interrupt.
+ *
+ * Bus events first, so a reset discards what the endpoint flags of the
+ * same interrupt refer to.
+ *
+ * @param[in] ctx Unused.
+ */
+static void UsbDev_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t flags = READ_REG(USBDEV_CORE->GINTSTS) & READ_REG(USBDEV_CORE->GINTMSK);
+
+    g_usbDevStatus.irqs++;
+
+    if ((flags & USB_OTG_GINTSTS_USBRST) != 0U)
+    {
+        WRITE_REG(USBDEV_CORE->GINTSTS, USB_OTG_GINTSTS_USBRST);
+        UsbDev_BusReset();
+    }
+    if ((flags & USB_OTG_GINTSTS_ENUMDNE) != 0U)
+    {
+        WRITE_REG(USBDEV_CORE->GINTSTS, USB_OTG_GINTSTS_ENUMDNE);
+        UsbDev_EnumDone();
+    }
+    if ((flags & USB_OTG_GINTSTS_USBSUSP) != 0U)
+    {
+        WRITE_REG(USBDEV_CORE->GINTSTS, USB_OTG_GINTSTS_USBSUSP);
+        if ((READ_REG(USBDEV_DEVICE->DSTS) & USB_OTG_DSTS_SUSPSTS) != 0U)
+        {
+            if (g_usbDevStatus.state != USBDEV_SUSPENDED)
+            {
+                g_usbDevResumeState = g_usbDevStatus.state;
+                g_usbDevStatus.suspends++;
+            }
+            g_usbDevStatus.state = USBDEV_SUSPENDED;
+            for (uint32_t ch = 0U; ch < (uint32_t)USBDEV_CHANNELS; ch++)
+            {
+                UsbDev_Abort((UsbDev_Channel_T)ch);
+            }
+        }
+    }
+    if ((flags & USB_OTG_GINTSTS_WKUINT) != 0U)
+    {
+        WRITE_REG(USBDEV_CORE->GINTSTS, USB_OTG_GINTSTS_WKUINT);
+        if (g_usbDevStatus.state == USBDEV_SUSPENDED)
+        {
+            g_usbDevStatus.state = g_usbDevResumeState;
+        }
+    }
+    if ((flags & USB_OTG_GINTSTS_OTGINT) != 0U)
+    {
+        WRITE_REG(USBDEV_CORE->GOTGINT, READ_REG(USBDEV_CORE->GOTGINT));
+    }
+    if ((flags & USB_OTG_GINTSTS_OEPINT) != 0U)
+    {
+        UsbDev_OutEndpoints();
+    }
+    if ((flags & USB_OTG_GINTSTS_IEPINT) != 0U)
+    {
+        UsbDev_InEndpoints();
+    }
+}
+
+/**
+ * @brief Completion callback of the blocking call.
+ *
+ * Runs from an interrupt, or from the submitting task when the request
+ * is aborted there, so the notification picks its API.
+ *
+ * @param[in] ctx     Handle of the waiting task.
+ * @param[in] success Request outcome.
+ */
+static void UsbDev_WakeWaiter(void *ctx, bool success)
+{
+    TaskHandle_t waiter = (TaskHandle_t)ctx;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyIndexedFromISR(waiter, USBDEV_NOTIFY_INDEX, success ? 1U : 0U, eSetValueWithOverwrite, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyIndexed(waiter, USBDEV_NOTIFY_INDEX, success ? 1U : 0U, eSetValueWithOverwrite);
+    }
+}
+
+/** @} */ // end of UsbDev group
@@ -0,0 +1,232 @@
+/**
+ * @file Venc.h
+ * @brief Video encoder pipeline: frame buffers, encode scheduling and bitstream ring
+ *
+ * The service owns a small set of caller-provided frame buffers and one
+ * bitstream ring. Capture takes a free buffer with ::Venc_AcquireFrame,
+ * fills it and hands it back with ::Venc_SubmitFrame; submitted frames are
+ * encoded in order, one at a time, straight into the ring. With two or
+ * more buffers the encode of frame N overlaps the capture of frame N+1.
+ *
+ * Each encoded frame becomes one packet, stored contiguously in the ring,
+ * so a consumer reads it in place with ::Venc_PeekPacket and frees it with
+ * ::Venc_ReleasePacket, oldest first. An encode only starts once the ring
+ * has ::Venc_Config_T::max_packet contiguous bytes free; until then
+ * submitted frames wait and capture runs out of buffers, which it sees as
+ * a NULL from ::Venc_AcquireFrame.
+ *
+ * The encoder itself sits behind ::Venc_Backend_T. The VENC block is
+ * driven through the ST encoder library, which is not part of this tree;
+ * its glue implements the backend, and this component provides none, so
+ * nothing on target calls ::Venc_Init until that glue is added. The host
+ * build exercises buffer management and scheduling with a software
+ * stand-in, SimVenc_Backend() in src/sim.
+ *
+ * Cache maintenance is done by the service: submitted frames are cleaned,
+ * the output area is cleaned and invalidated before an encode and
+ * invalidated again on completion, except for buffers in the non-cacheable
+ * DMA pool.
+ */
+
+#ifndef VENC_H
+#define VENC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef VENC_MAX_FRAMES
+#define VENC_MAX_FRAMES (4U) /**< Frame buffers managed at most */
+#endif
+
+#ifndef VENC_PACKET_QUEUE_LEN
+#define VENC_PACKET_QUEUE_LEN (8U) /**< Packets held in the ring at most */
+#endif
+
+#define VENC_ALIGN (16U)       /**< Width and height granularity, one macroblock */
+#define VENC_MAX_WIDTH (1920U) /**< Widest frame */
+#define VENC_MAX_HEIGHT (1088U) /**< Tallest frame */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Bitstream format.
+ */
+typedef enum
+{
+    VENC_CODEC_H264 = 0, /**< H.264 Annex B, one access unit per packet */
+    VENC_CODEC_JPEG,     /**< Baseline JPEG, one image per packet */
+} Venc_Codec_T;
+
+/**
+ * @brief Input frame layout.
+ */
+typedef enum
+{
+    VENC_FMT_NV12 = 0, /**< 4:2:0, Y plane then interleaved CbCr plane */
+    VENC_FMT_YUYV,     /**< 4:2:2 interleaved Y0 Cb Y1 Cr */
+    VENC_FMT_RGB565,   /**< 16 bpp RGB, converted by the encoder */
+} Venc_Format_T;
+
+/**
+ * @brief Packet notification.
+ *
+ * Runs in the completion context of the backend, interrupt or task, after
+ * the packet became visible to ::Venc_PeekPacket.
+ *
+ * @param[in] ctx Context pointer of the configuration.
+ */
+typedef void (*Venc_PacketCallback_T)(void *ctx);
+
+/**
+ * @brief Pipeline configuration.
+ */
+typedef struct
+{
+    Venc_Codec_T codec;              /**< Bitstream format */
+    Venc_Format_T format;            /**< Input layout */
+    uint32_t width;                  /**< Pixels per line, multiple of ::VENC_ALIGN */
+    uint32_t height;                 /**< Lines, multiple of ::VENC_ALIGN */
+    uint32_t gop;                    /**< Frames between key frames, 1 for all key frames */
+    uint32_t quality;                /**< JPEG quality or H.264 QP, 0 to 100 and 0 to 51 */
+    void *frames[VENC_MAX_FRAMES];   /**< Frame buffers of ::Venc_FrameBytes bytes */
+    uint32_t frame_count;            /**< Frame buffers used, 2 for double buffering */
+    uint8_t *ring;                   /**< Bitstream ring */
+    uint32_t ring_size;              /**< Bytes in the ring */
+    uint32_t max_packet;             /**< Largest packet, room required before an encode */
+    Venc_PacketCallback_T on_packet; /**< Packet notification, may be NULL */
+    void *ctx;                       /**< Passed unchanged to @ref on_packet */
+} Venc_Config_T;
+
+/**
+ * @brief Encoder behind the pipeline.
+ *
+ * The service serialises the calls: ::encode is only called once the
+ * previous one was reported through ::Venc_EncodeDone.
+ */
+typedef struct
+{
+    /** Apply a configuration, false if it is not supported. */
+    bool (*configure)(const Venc_Config_T *config);
+    /**
+     * Start encoding @p frame into @p out. Completion is reported with
+     * ::Venc_EncodeDone; false if the encode could not be started.
+     */
+    bool (*encode)(const void *frame, uint8_t *out, uint32_t capacity, bool keyframe);
+} Venc_Backend_T;
+
+/**
+ * @brief One encoded frame, read in place in the ring.
+ */
+typedef struct
+{
+    const uint8_t *data; /**< First byte of the packet */
+    uint32_t size;       /**< Bytes in the packet */
+    uint32_t sequence;   /**< Frame number, counting submitted frames */
+    uint64_t timestamp;  /**< Capture time given to ::Venc_SubmitFrame */
+    bool keyframe;       /**< Decodable on its own */
+} Venc_Packet_T;
+
+/**
+ * @brief Counters of the pipeline.
+ */
+typedef struct
+{
+    uint32_t frames_acquired; /**< Buffers handed to capture */
+    uint32_t capture_drops;   /**< ::Venc_AcquireFrame calls without a free buffer */
+    uint32_t frames_encoded;  /**< Packets produced */
+    uint32_t keyframes;       /**< Key frames among them */
+    uint32_t encode_errors;   /**< Frames the backend failed to encode */
+    uint32_t ring_stalls;     /**< Encodes delayed for lack of ring space */
+    uint32_t ring_peak;       /**< Most bytes held in the ring */
+    uint64_t bytes;           /**< Bitstream bytes produced */
+    uint64_t latency_cycles;  /**< Sum of submit to packet times */
+    uint32_t latency_max;     /**< Longest submit to packet time in cycles */
+    uint64_t busy_cycles;     /**< CPU cycles the encoder was running */
+} Venc_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Configure the pipeline and its backend.
+ *
+ * Must not be called while frames are being encoded. Packets still in the
+ * ring are discarded.
+ *
+ * @param[in] config  Configuration, copied by the call.
+ * @param[in] backend Encoder.
+ *
+ * @return true on success, false for an invalid configuration.
+ */
+bool Venc_Init(const Venc_Config_T *config, const Venc_Backend_T *backend);
+
+/**
+ * @brief Bytes of one input frame of the given layout.
+ *
+ * @param[in] format Input layout.
+ * @param[in] width  Pixels per line.
+ * @param[in] height Lines.
+ *
+ * @return Frame size, 0 for an unknown layout.
+ */
+uint32_t Venc_FrameBytes(Venc_Format_T format, uint32_t width, uint32_t height);
+
+/**
+ * @brief Take a free frame buffer for capture.
+ *
+ * @return Buffer to fill, NULL if every buffer is waiting or being encoded.
+ */
+void *Venc_AcquireFrame(void);
+
+/**
+ * @brief Queue a filled frame buffer for encoding.
+ *
+ * @param[in] frame     Buffer returned by ::Venc_AcquireFrame.
+ * @param[in] timestamp Capture time, copied to the packet.
+ *
+ * @return true on success, false if @p frame is not an acquired buffer.
+ */
+bool Venc_SubmitFrame(void *frame, uint64_t timestamp);
+
+/**
+ * @brief Return an acquired buffer without encoding it.
+ *
+ * @param[in] frame Buffer returned by ::Venc_AcquireFrame.
+ *
+ * @return true on success, false if @p frame is not an acquired buffer.
+ */
+bool Venc_ReleaseFrame(void *frame);
+
+/**
+ * @brief Look at the oldest packet in the ring.
+ *
+ * @param[out] packet Packet description, valid until ::Venc_ReleasePacket.
+ *
+ * @return true if a packet was available.
+ */
+bool Venc_PeekPacket(Venc_Packet_T *packet);
+
+/**
+ * @brief Free the oldest packet in the ring.
+ */
+void Venc_ReleasePacket(void);
+
+/**
+ * @brief Report the end of the encode started by the backend.
+ *
+ * Called by the backend, from interrupt or task context.
+ *
+ * @param[in] size    Bytes written to the output.
+ * @param[in] success false if the frame could not be encoded.
+ */
+void Venc_EncodeDone(uint32_t size, bool success);
+
+/**
+ * @brief Copy the pipeline counters into @p status.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void Venc_GetStatus(Venc_Status_T *status);
+
+#endif /* VENC_H */
@@ -0,0 +1,551 @@
+/**
+ * @file Venc.c
+ * @brief Implementation of the video encoder pipeline.
+ * @ingroup Venc
+ * @{
+ *
+ * Frame buffers move FREE -> CAPTURE -> READY -> ENCODING -> FREE. The
+ * oldest READY frame is encoded whenever the encoder is idle and the ring
+ * has room for a packet; the check runs on every submission, every
+ * released packet and every completed encode, so the encoder restarts
+ * from whichever context freed the resource it was waiting for.
+ *
+ * Packets are kept in order in a descriptor ring. The newest one ends at
+ * the write offset; when it starts below the oldest one the data has
+ * wrapped and the free space is the gap between them, otherwise it is
+ * the larger usable one of the ring end and the ring start.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "Venc.h"
+#include <stddef.h>
+#include "DmaPool.h"
+#include "stm32n6xx.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define VENC_NONE (0xFFFFFFFFU) /**< No frame being encoded */
+#define VENC_H264_MAX_QP (51U)  /**< Largest H.264 quantisation parameter */
+#define VENC_JPEG_MAX_Q (100U)  /**< Largest JPEG quality */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Ownership of a frame buffer.
+ */
+typedef enum
+{
+    VENC_FRAME_FREE = 0, /**< Available to ::Venc_AcquireFrame */
+    VENC_FRAME_CAPTURE,  /**< Being filled by capture */
+    VENC_FRAME_READY,    /**< Waiting for the encoder */
+    VENC_FRAME_ENCODING, /**< Read by the encoder */
+} Venc_FrameState_T;
+
+/**
+ * @brief Bookkeeping of one frame buffer.
+ */
+typedef struct
+{
+    Venc_FrameState_T state; /**< Owner */
+    uint32_t sequence;       /**< Submission order */
+    uint64_t timestamp;      /**< Capture time */
+    uint32_t submit_cycles;  /**< CYCCNT at submission */
+} Venc_Frame_T;
+
+/**
+ * @brief Packet held in the ring.
+ */
+typedef struct
+{
+    uint32_t offset;    /**< First byte in the ring */
+    uint32_t size;      /**< Bytes */
+    uint32_t sequence;  /**< Frame number */
+    uint64_t timestamp; /**< Capture time */
+    bool keyframe;      /**< Decodable on its own */
+} Venc_PacketDesc_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Active configuration. */
+static Venc_Config_T g_vencConfig;
+/** Active encoder, NULL before ::Venc_Init. */
+static const Venc_Backend_T *g_vencBackend = NULL;
+/** State of each frame buffer. */
+static Venc_Frame_T g_vencFrames[VENC_MAX_FRAMES];
+/** Packets in the ring, oldest at ::g_vencPacketHead. */
+static Venc_PacketDesc_T g_vencPackets[VENC_PACKET_QUEUE_LEN];
+/** Index of the oldest packet. */
+static uint32_t g_vencPacketHead = 0U;
+/** Packets in the ring. */
+static uint32_t g_vencPacketCount = 0U;
+/** Ring offset just past the newest packet. */
+static uint32_t g_vencWriteOffset = 0U;
+/** Frame being encoded, ::VENC_NONE when idle. */
+static uint32_t g_vencEncoding = VENC_NONE;
+/** Ring offset of the encode in flight. */
+static uint32_t g_vencOutOffset = 0U;
+/** Ring bytes given to the encode in flight. */
+static uint32_t g_vencOutCapacity = 0U;
+/** The encode in flight is a key frame. */
+static bool g_vencOutKey = false;
+/** CYCCNT when the encode in flight started. */
+static uint32_t g_vencStartCycles = 0U;
+/** Sequence number of the next submitted frame. */
+static uint32_t g_vencNextSequence = 0U;
+/** Frames encoded since the last key frame. */
+static uint32_t g_vencSinceKey = 0U;
+/** The last start attempt found the ring full. */
+static bool g_vencStalled = false;
+/** Counters reported by ::Venc_GetStatus. */
+static Venc_Status_T g_vencStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Encode the oldest ready frame if the encoder and the ring allow it. */
+static void Venc_TryStart(void);
+/** Find the oldest ready frame, interrupts masked. */
+static uint32_t Venc_OldestReady(void);
+/** Contiguous free ring space for the next packet, interrupts masked. */
+static uint32_t Venc_RingSpace(uint32_t *offset);
+/** Bytes held by packets, interrupts masked. */
+static uint32_t Venc_RingUsed(void);
+/** Index of the acquired buffer @p frame, ::VENC_NONE if it is not one. */
+static uint32_t Venc_FindCaptured(const void *frame);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Configure the pipeline and its backend.
+ */
+bool Venc_Init(const Venc_Config_T *config, const Venc_Backend_T *backend)
+{
+    if ((config == NULL) || (backend == NULL) || (backend->configure == NULL) || (backend->encode == NULL) ||
+        (config->codec > VENC_CODEC_JPEG) || (config->width == 0U) || (config->height == 0U) ||
+        ((config->width % VENC_ALIGN) != 0U) || ((config->height % VENC_ALIGN) != 0U) ||
+        (config->width > VENC_MAX_WIDTH) || (config->height > VENC_MAX_HEIGHT) ||
+        (Venc_FrameBytes(config->format, config->width, config->height) == 0U) || (config->gop == 0U) ||
+        (config->quality > ((config->codec == VENC_CODEC_H264) ? VENC_H264_MAX_QP : VENC_JPEG_MAX_Q)) ||
+        (config->frame_count == 0U) || (config->frame_count > VENC_MAX_FRAMES) || (config->ring == NULL) ||
+        (config->max_packet == 0U) || (config->max_packet > config->ring_size))
+    {
+        return false;
+    }
+    for (uint32_t i = 0U; i < config->frame_count; i++)
+    {
+        if (config->frames[i] == NULL)
+        {
+            return false;
+        }
+    }
+
+    if (!backend->configure(config))
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_vencConfig = *config;
+    g_vencBackend = backend;
+    for (uint32_t i = 0U; i < VENC_MAX_FRAMES; i++)
+    {
+        g_vencFrames[i].state = VENC_FRAME_FREE;
+    }
+    g_vencPacketHead = 0U;
+    g_vencPacketCount = 0U;
+    g_vencWriteOffset = 0U;
+    g_vencEncoding = VENC_NONE;
+    g_vencNextSequence = 0U;
+    g_vencSinceKey = 0U;
+    g_vencStalled = false;
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+/**
+ * @brief Bytes of one input frame of the given layout.
+ */
+uint32_t Venc_FrameBytes(Venc_Format_T format, uint32_t width, uint32_t height)
+{
+    switch (format)
+    {
+    case VENC_FMT_NV12:
+        return (width * height * 3U) / 2U;
+    case VENC_FMT_YUYV:
+    case VENC_FMT_RGB565:
+        return width * height * 2U;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Take a free frame buffer for capture.
+ */
+void *Venc_AcquireFrame(void)
+{
+    void *frame = NULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_vencBackend != NULL)
+    {
+        for (uint32_t i = 0U; i < g_vencConfig.frame_count; i++)
+        {
+            if (g_vencFrames[i].state == VENC_FRAME_FREE)
+            {
+                g_vencFrames[i].state = VENC_FRAME_CAPTURE;
+                frame = g_vencConfig.frames[i];
+                break;
+            }
+        }
+        if (frame != NULL)
+        {
+            g_vencStatus.frames_acquired++;
+        }
+        else
+        {
+            g_vencStatus.capture_drops++;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return frame;
+}
+
+/**
+ * @brief Queue a filled frame buffer for encoding.
+ *
+ * The buffer is cleaned while capture still owns it, so the encoder never
+ * sees a frame with dirty lines.
+ */
+bool Venc_SubmitFrame(void *frame, uint64_t timestamp)
+{
+    uint32_t index = Venc_FindCaptured(frame);
+    if (index == VENC_NONE)
+    {
+        return false;
+    }
+
+    uint32_t bytes = Venc_FrameBytes(g_vencConfig.format, g_vencConfig.width, g_vencConfig.height);
+    if (!DmaPool_IsNonCacheable(frame, bytes))
+    {
+        SCB_CleanDCache_by_Addr(frame, (int32_t)bytes);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_vencFrames[index].sequence = g_vencNextSequence++;
+    g_vencFrames[index].timestamp = timestamp;
+    g_vencFrames[index].submit_cycles = DWT->CYCCNT;
+    g_vencFrames[index].state = VENC_FRAME_READY;
+    __set_PRIMASK(primask);
+
+    Venc_TryStart();
+    return true;
+}
+
+/**
+ * @brief Return an acquired buffer without encoding it.
+ */
+bool Venc_ReleaseFrame(void *frame)
+{
+    uint32_t index = Venc_FindCaptured(frame);
+    if (index == VENC_NONE)
+    {
+        return false;
+    }
+
+    g_vencFrames[index].state = VENC_FRAME_FREE;
+    return true;
+}
+
+/**
+ * @brief Look at the oldest packet in the ring.
+ */
+bool Venc_PeekPacket(Venc_Packet_T *packet)
+{
+    bool available = false;
+
+    if (packet == NULL)
+    {
+        return false;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_vencPacketCount != 0U)
+    {
+        const Venc_PacketDesc_T *desc = &g_vencPackets[g_vencPacketHead];
+        packet->data = &g_vencConfig.ring[desc->offset];
+        packet->size = desc->size;
+        packet->sequence = desc->sequence;
+        packet->timestamp = desc->timestamp;
+        packet->keyframe = desc->keyframe;
+        available = true;
+    }
+    __set_PRIMASK(primask);
+
+    return available;
+}
+
+/**
+ * @brief Free the oldest packet in the ring.
+ *
+ * Restarts the encoder if it was waiting for ring space.
+ */
+void Venc_ReleasePacket(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_vencPacketCount != 0U)
+    {
+        g_vencPacketHead = (g_vencPacketHead + 1U) % VENC_PACKET_QUEUE_LEN;
+        g_vencPacketCount--;
+    }
+    __set_PRIMASK(primask);
+
+    Venc_TryStart();
+}
+
+/**
+ * @brief Report the end of the encode started by the backend.
+ *
+ * The output is invalidated before the packet is published so a consumer
+ * woken by any context reads the encoder data, not stale lines.
+ */
+void Venc_EncodeDone(uint32_t size, bool success)
+{
+    if (g_vencEncoding == VENC_NONE)
+    {
+        return;
+    }
+
+    success = success && (size != 0U) && (size <= g_vencOutCapacity);
+    if (success && !DmaPool_IsNonCacheable(&g_vencConfig.ring[g_vencOutOffset], size))
+    {
+        SCB_InvalidateDCache_by_Addr(&g_vencConfig.ring[g_vencOutOffset], (int32_t)size);
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    Venc_Frame_T *frame = &g_vencFrames[g_vencEncoding];
+    uint32_t now = DWT->CYCCNT;
+    g_vencStatus.busy_cycles += now - g_vencStartCycles;
+
+    if (success)
+    {
+        Venc_PacketDesc_T *desc = &g_vencPackets[(g_vencPacketHead + g_vencPacketCount) % VENC_PACKET_QUEUE_LEN];
+        desc->offset = g_vencOutOffset;
+        desc->size = size;
+        desc->sequence = frame->sequence;
+        desc->timestamp = frame->timestamp;
+        desc->keyframe = g_vencOutKey;
+        g_vencPacketCount++;
+        g_vencWriteOffset = g_vencOutOffset + size;
+        g_vencSinceKey = (g_vencSinceKey + 1U) % g_vencConfig.gop;
+
+        uint32_t latency = now - frame->submit_cycles;
+        g_vencStatus.frames_encoded++;
+        g_vencStatus.keyframes += g_vencOutKey ? 1U : 0U;
+        g_vencStatus.bytes += size;
+        g_vencStatus.latency_cycles += latency;
+        if (latency > g_vencStatus.latency_max)
+        {
+            g_vencStatus.latency_max = latency;
+        }
+        uint32_t used = Venc_RingUsed();
+        if (used > g_vencStatus.ring_peak)
+        {
+            g_vencStatus.ring_peak = used;
+        }
+    }
+    else
+    {
+        /* Later frames may reference the lost one, restart from a key frame */
+        g_vencStatus.encode_errors++;
+        g_vencSinceKey = 0U;
+    }
+
+    frame->state = VENC_FRAME_FREE;
+    g_vencEncoding = VENC_NONE;
+    __set_PRIMASK(primask);
+
+    Venc_TryStart();
+
+    if (success && (g_vencConfig.on_packet != NULL))
+    {
+        g_vencConfig.on_packet(g_vencConfig.ctx);
+    }
+}
+
+/**
+ * @brief Copy the pipeline counters into @p status.
+ */
+void Venc_GetStatus(Venc_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_vencStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Encode the oldest ready frame if the encoder and the ring allow it.
+ *
+ * The encoder is claimed with interrupts masked; cache maintenance and the
+ * backend call run after, since only the claiming context touches the
+ * output area until the encode completes.
+ */
+static void Venc_TryStart(void)
+{
+    uint32_t offset = 0U;
+    uint32_t space = 0U;
+    uint32_t index = VENC_NONE;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((g_vencBackend != NULL) && (g_vencEncoding == VENC_NONE))
+    {
+        index = Venc_OldestReady();
+    }
+    if (index != VENC_NONE)
+    {
+        space = (g_vencPacketCount < VENC_PACKET_QUEUE_LEN) ? Venc_RingSpace(&offset) : 0U;
+        if (space == 0U)
+        {
+            if (!g_vencStalled)
+            {
+                g_vencStatus.ring_stalls++;
+                g_vencStalled = true;
+            }
+            index = VENC_NONE;
+        }
+        else
+        {
+            g_vencStalled = false;
+            g_vencFrames[index].state = VENC_FRAME_ENCODING;
+            g_vencEncoding = index;
+            g_vencOutOffset = offset;
+            g_vencOutCapacity = space;
+            g_vencOutKey = (g_vencSinceKey == 0U);
+            g_vencStartCycles = DWT->CYCCNT;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    if (index == VENC_NONE)
+    {
+        return;
+    }
+
+    uint8_t *out = &g_vencConfig.ring[offset];
+    if (!DmaPool_IsNonCacheable(out, space))
+    {
+        SCB_CleanInvalidateDCache_by_Addr(out, (int32_t)space);
+    }
+
+    if (!g_vencBackend->encode(g_vencConfig.frames[index], out, space, g_vencOutKey))
+    {
+        Venc_EncodeDone(0U, false);
+    }
+}
+
+/**
+ * @brief Find the oldest ready frame.
+ *
+ * @return Frame index, ::VENC_NONE if no frame is ready.
+ */
+static uint32_t Venc_OldestReady(void)
+{
+    uint32_t oldest = VENC_NONE;
+
+    for (uint32_t i = 0U; i < g_vencConfig.frame_count; i++)
+    {
+        if ((g_vencFrames[i].state == VENC_FRAME_READY) &&
+            ((oldest == VENC_NONE) || ((int32_t)(g_vencFrames[i].sequence - g_vencFrames[oldest].sequence) < 0)))
+        {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+/**
+ * @brief Contiguous free ring space for the next packet.
+ *
+ * @param[out] offset Where the packet would start.
+ *
+ * @return Bytes available at @p offset, 0 if fewer than the largest packet.
+ */
+static uint32_t Venc_RingSpace(uint32_t *offset)
+{
+    uint32_t space;
+
+    if (g_vencPacketCount == 0U)
+    {
+        *offset = 0U;
+        space = g_vencConfig.ring_size;
+    }
+    else
+    {
+        uint32_t oldest = g_vencPackets[g_vencPacketHead].offset;
+        uint32_t newest = g_vencPackets[(g_vencPacketHead + g_vencPacketCount - 1U) % VENC_PACKET_QUEUE_LEN].offset;
+
+        if (newest < oldest)
+        {
+            *offset = g_vencWriteOffset;
+            space = oldest - g_vencWriteOffset;
+        }
+        else if ((g_vencConfig.ring_size - g_vencWriteOffset) >= g_vencConfig.max_packet)
+        {
+            *offset = g_vencWriteOffset;
+            space = g_vencConfig.ring_size - g_vencWriteOffset;
+        }
+        else
+        {
+            *offset = 0U;
+            space = oldest;
+        }
+    }
+
+    return (space >= g_vencConfig.max_packet) ? space : 0U;
+}
+
+/**
+ * @brief Bytes held by packets, including the unused end of a wrapped ring.
+ */
+static uint32_t Venc_RingUsed(void)
+{
+    if (g_vencPacketCount == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t oldest = g_vencPackets[g_vencPacketHead].offset;
+    return (g_vencWriteOffset > oldest) ? (g_vencWriteOffset - oldest)
+                                        : ((g_vencConfig.ring_size - oldest) + g_vencWriteOffset);
+}
+
+/**
+ * @brief Index of the acquired buffer @p frame.
+ *
+ * @return Frame index, ::VENC_NONE if @p frame is not in capture.
+ */
+static uint32_t Venc_FindCaptured(const void *frame)
+{
+    for (uint32_t i = 0U; (frame != NULL) && (i < g_vencConfig.frame_count); i++)
+    {
+        if ((g_vencConfig.frames[i] == frame) && (g_vencFrames[i].state == VENC_FRAME_CAPTURE))
+        {
+            return i;
+        }
+    }
+    return VENC_NONE;
+}
+
+/** @} */ // end of Venc group
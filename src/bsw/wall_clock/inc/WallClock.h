@@ -0,0 +1,187 @@
+/**
+ * @file WallClock.h
+ * @brief Monotonic nanosecond clock and UTC time kept by the RTC and disciplined by external sync messages
+ *
+ * ::WallClock_Mono counts nanoseconds since ::WallClock_Init from the core
+ * cycle counter. A read takes no lock and no division: it scales the
+ * cycles elapsed since the last published base with a multiply and a
+ * shift, so it is cheap enough to stamp every log entry, from tasks and
+ * interrupts alike.
+ *
+ * UTC is the monotonic time mapped through an offset and a rate. At
+ * start-up it comes from the RTC calendar and its sub-second counter;
+ * until the first sync it advances at the rate of the RTC crystal, which
+ * the RTC wake-up interrupt measures against the core clock once its
+ * wake-ups span ::WALLCLOCK_RTC_MIN_S. Each call to
+ * ::WallClock_Sync compares the local UTC with a reference time:
+ *  - the first sync, and any later one off by more than
+ *    ::WALLCLOCK_STEP_NS, steps the clock and the RTC calendar to it,
+ *  - smaller offsets are slewed out over the next sync intervals, so UTC
+ *    never runs backwards between steps,
+ *  - the reference points give the frequency of the core clock against
+ *    UTC, which becomes the rate of UTC and, through the smooth
+ *    calibration of the RTC, the rate of the calendar kept across resets.
+ *
+ * UTC is counted in nanoseconds since 1970-01-01 00:00:00, without leap
+ * seconds; the RTC holds years 2000 to 2099.
+ */
+
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef WALLCLOCK_REFRESH_HZ
+#define WALLCLOCK_REFRESH_HZ (8U) /**< RTC wake-ups per second, each republishing the base; divides 2000 and 2048 */
+#endif
+
+#ifndef WALLCLOCK_STEP_NS
+#define WALLCLOCK_STEP_NS (1000000U) /**< Offsets larger than this are stepped instead of slewed */
+#endif
+
+#ifndef WALLCLOCK_SLEW_SYNCS
+#define WALLCLOCK_SLEW_SYNCS (2U) /**< Sync intervals an offset is slewed out over */
+#endif
+
+#ifndef WALLCLOCK_MAX_PPB
+#define WALLCLOCK_MAX_PPB (500000) /**< Limit of the frequency estimate and of the slew rate, each */
+#endif
+
+#ifndef WALLCLOCK_FREQ_WINDOW_S
+#define WALLCLOCK_FREQ_WINDOW_S (600U) /**< Longest span of reference points one frequency estimate covers */
+#endif
+
+#ifndef WALLCLOCK_RTC_WINDOW_S
+#define WALLCLOCK_RTC_WINDOW_S (64U) /**< Span of wake-ups one RTC frequency measurement covers */
+#endif
+
+#ifndef WALLCLOCK_RTC_MIN_S
+#define WALLCLOCK_RTC_MIN_S (8U) /**< Shortest span of a published RTC measurement; 125 ppb per us of jitter */
+#endif
+
+#define WALLCLOCK_NS_PER_S (1000000000ULL) /**< Nanoseconds in a second */
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Broken-down UTC time.
+ */
+typedef struct
+{
+    uint16_t year;   /**< Year, 1970 or later */
+    uint8_t month;   /**< Month, 1 to 12 */
+    uint8_t day;     /**< Day of the month, 1 to 31 */
+    uint8_t hour;    /**< Hour, 0 to 23 */
+    uint8_t minute;  /**< Minute, 0 to 59 */
+    uint8_t second;  /**< Second, 0 to 59 */
+    uint8_t weekday; /**< Day of the week, 1 for Monday to 7 for Sunday, ignored by ::WallClock_FromCalendar */
+    uint32_t ns;     /**< Nanoseconds within the second */
+} WallClock_Calendar_T;
+
+/**
+ * @brief Clock state and counters.
+ */
+typedef struct
+{
+    bool lse;               /**< The RTC runs on the LSE crystal, else on the LSI */
+    bool rtc_valid;         /**< The RTC calendar had been set before ::WallClock_Init */
+    bool synced;            /**< A sync has been taken */
+    uint32_t syncs;         /**< Syncs taken */
+    uint32_t steps;         /**< Syncs that stepped the clock */
+    uint32_t rejected;      /**< Syncs refused */
+    bool rtc_measured;      /**< @ref rtc_ppb covers at least ::WALLCLOCK_RTC_MIN_S */
+    uint32_t refreshes;     /**< RTC wake-ups handled */
+    int32_t rtc_ppb;        /**< RTC clock rate against the core clock, measured over the wake-ups */
+    int32_t freq_ppb;       /**< UTC rate against the core clock, estimated from the syncs */
+    int32_t rate_ppb;       /**< Rate applied to UTC, slew included */
+    int32_t cal_ppb;        /**< Smooth calibration applied to the RTC calendar */
+    int64_t last_offset_ns; /**< Reference minus local UTC at the last sync */
+} WallClock_Status_T;
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Start the RTC, take UTC from its calendar and arm the wake-up refresh.
+ *
+ * A calendar already running from the backup domain is kept; otherwise
+ * the RTC is clocked from the LSE, or the LSI if the crystal does not
+ * start, and starts at 2000-01-01.
+ *
+ * @retval true  The clocks run.
+ * @retval false No RTC clock, or its interrupt could not be bound.
+ */
+bool WallClock_Init(void);
+
+/**
+ * @brief Nanoseconds since ::WallClock_Init, never decreasing.
+ *
+ * Lock-free; callable from tasks and interrupts.
+ */
+uint64_t WallClock_Mono(void);
+
+/**
+ * @brief Current UTC in nanoseconds since 1970-01-01.
+ *
+ * Lock-free; callable from tasks and interrupts. Does not decrease
+ * between steps.
+ */
+uint64_t WallClock_Utc(void);
+
+/**
+ * @brief UTC at a monotonic time, through the current mapping.
+ *
+ * @param[in] mono_ns Monotonic time, past or future.
+ */
+uint64_t WallClock_MonoToUtc(uint64_t mono_ns);
+
+/**
+ * @brief Take a reference time.
+ *
+ * Steps, or slews and updates the frequency estimate, as described in
+ * the file header. Call from one task at a time.
+ *
+ * @param[in] utc_ns  Reference UTC in nanoseconds since 1970-01-01.
+ * @param[in] mono_ns Monotonic time at which the reference held, such as
+ *                    the reception stamp of the message carrying it.
+ *
+ * @retval true  Taken.
+ * @retval false @p mono_ns lies in the future or at the previous sync,
+ *               or @p utc_ns is outside the years the RTC holds.
+ */
+bool WallClock_Sync(uint64_t utc_ns, uint64_t mono_ns);
+
+/**
+ * @brief Read the RTC calendar and sub-second counter as UTC.
+ *
+ * Resolution is one period of the RTC synchronous prescaler. Callable
+ * from tasks only.
+ *
+ * @param[out] utc_ns UTC in nanoseconds since 1970-01-01.
+ * @retval true  Read.
+ * @retval false The RTC has not been started.
+ */
+bool WallClock_ReadRtc(uint64_t *utc_ns);
+
+/**
+ * @brief Break UTC down into a calendar date and time.
+ */
+void WallClock_ToCalendar(uint64_t utc_ns, WallClock_Calendar_T *cal);
+
+/**
+ * @brief UTC of a calendar date and time.
+ *
+ * @return Nanoseconds since 1970-01-01, 0 for a date or time out of range.
+ */
+uint64_t WallClock_FromCalendar(const WallClock_Calendar_T *cal);
+
+/**
+ * @brief Copy the clock state and counters.
+ *
+ * @param[out] status Destination for the snapshot.
+ */
+void WallClock_GetStatus(WallClock_Status_T *status);
+
+#endif /* WALL_CLOCK_H */
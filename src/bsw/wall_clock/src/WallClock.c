@@ -0,0 +1,833 @@
+/**
+ * @file WallClock.c
+ * @brief Implementation of the RTC-backed wall clock.
+ * @ingroup WallClock
+ * @{
+ *
+ * The published base holds the cycle counter at its last refresh, the
+ * monotonic and UTC times at that moment with their sub-nanosecond
+ * remainders, and the UTC rate. A reader copies it, reads the cycle
+ * counter and retries if the generation count moved meanwhile; the two
+ * writers, the RTC wake-up interrupt and ::WallClock_Sync, publish with
+ * interrupts masked, so a reader never waits on a half-written base and
+ * the count only needs to change once per publication.
+ *
+ * Cycles become nanoseconds through a 32-bit multiplier and a shift, and
+ * the remainders carried in the base make a refresh exactly additive: the
+ * clocks read after it continue the ones read before it to the
+ * nanosecond. The wake-up interrupt refreshes the base well within one
+ * counter period, so the cycles since the base always fit in 32 bits.
+ *
+ * The wake-up timer counts the RTC clock divided by 16, ahead of the
+ * smooth calibration, so the wake-ups also measure the raw crystal
+ * against the core clock. The calendar runs at that rate corrected by
+ * the calibration; until the first sync, UTC follows the calendar.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "WallClock.h"
+#include <stddef.h>
+#include "IsrMgr.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_rtc.h"
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_pwr.h"
+#include "stm32n6xx_ll_bus.h"
+#include "FreeRTOS.h"
+#include "cmsis_gcc.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define WALLCLOCK_RTC RTC                   /**< RTC instance */
+#define WALLCLOCK_IRQ RTC_IRQn              /**< Its interrupt, taking the wake-up timer */
+#define WALLCLOCK_PREDIV_A (3U)             /**< Asynchronous prescaler; 3 or more keeps CALP usable */
+#define WALLCLOCK_WAKEUP_DIV (16U)          /**< RTC clock divider of the wake-up timer */
+#define WALLCLOCK_OSC_SPIN_LIMIT (1000000U) /**< Polls of an oscillator ready flag before falling back */
+#define WALLCLOCK_RTC_SPIN_LIMIT (100000U)  /**< Polls of an RTC status flag before giving up on it */
+#define WALLCLOCK_CAL_WINDOW (1UL << 20)    /**< RTC clock cycles of one smooth calibration window */
+#define WALLCLOCK_CAL_PULSES (512)          /**< Cycles CALP adds per calibration window */
+#define WALLCLOCK_RTC_FIRST_S (946684800ULL)  /**< 2000-01-01, start of the RTC calendar, in Unix seconds */
+#define WALLCLOCK_RTC_END_S (4102444800ULL)   /**< 2100-01-01, end of the RTC calendar, in Unix seconds */
+#define WALLCLOCK_DAYS_TO_1970 (719468)     /**< Days from 0000-03-01 to 1970-01-01 */
+#define WALLCLOCK_MAX_YEAR (2500U)          /**< Last year whose nanoseconds fit in 64 bits, rounded down */
+
+#if ((2000U % WALLCLOCK_REFRESH_HZ) != 0U) || ((2048U % WALLCLOCK_REFRESH_HZ) != 0U)
+#error "WALLCLOCK_REFRESH_HZ must divide the wake-up clock of both the LSE and the LSI"
+#endif
+
+#if (WALLCLOCK_RTC_MIN_S == 0U) || (WALLCLOCK_RTC_MIN_S > WALLCLOCK_RTC_WINDOW_S)
+#error "WALLCLOCK_RTC_MIN_S must be within the RTC measurement window"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Published mapping of the cycle counter onto the clocks.
+ */
+typedef struct
+{
+    uint32_t counter; /**< Cycle counter at the refresh */
+    uint32_t frac;    /**< Fraction of a nanosecond of @ref mono, in 2^-shift units */
+    uint64_t mono;    /**< Monotonic time at @ref counter */
+    uint64_t utc;     /**< UTC at @ref mono */
+    uint32_t ufrac;   /**< Fraction of a nanosecond of @ref utc, in 2^-32 units */
+    int64_t rate;     /**< UTC rate against the monotonic clock minus one, in 2^-32 units */
+} WallClock_Base_T;
+
+/**
+ * @brief Frequency estimation from the syncs. Owned by ::WallClock_Sync.
+ */
+typedef struct
+{
+    bool synced;         /**< A sync has been taken; read by the interrupt too */
+    bool windowDone;     /**< The estimate once covered a full window */
+    uint64_t anchorMono; /**< Monotonic time of the first reference point of the window */
+    uint64_t anchorUtc;  /**< Its reference time */
+    uint64_t lastMono;   /**< Monotonic time of the previous sync */
+    int32_t freq;        /**< UTC rate against the core clock, in ppb */
+} WallClock_Servo_T;
+
+/**
+ * @brief RTC clock measurement over the wake-ups. Owned by the interrupt.
+ */
+typedef struct
+{
+    bool started;       /**< @ref startMono holds a wake-up */
+    bool known;         /**< A measurement has been made */
+    bool windowDone;    /**< One covered a full window */
+    uint64_t startMono; /**< Monotonic time of the first wake-up of the window */
+    uint32_t wakeups;   /**< Wake-up periods since it */
+} WallClock_RtcMeas_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Published base. */
+static WallClock_Base_T g_wallClockBase = {0};
+/** Changed by every publication of the base. */
+static uint32_t g_wallClockGeneration = 0U;
+/** Nanoseconds per cycle, in 2^-shift units. */
+static uint32_t g_wallClockMult = 0U;
+/** Shift applied after @ref g_wallClockMult. */
+static uint32_t g_wallClockShift = 0U;
+/** Nominal RTC clock. */
+static uint32_t g_wallClockRtcHz = 0U;
+/** Synchronous prescaler ratio, the sub-second counts per second. */
+static uint32_t g_wallClockSecondTicks = 1U;
+/** Nominal wake-up period. */
+static uint64_t g_wallClockWakeNs = 0U;
+/** Frequency estimation from the syncs. */
+static WallClock_Servo_T g_wallClockServo = {0};
+/** RTC clock measurement. */
+static WallClock_RtcMeas_T g_wallClockRtcMeas = {0};
+/** The clocks run. */
+static bool g_wallClockReady = false;
+/** Counters reported by ::WallClock_GetStatus. */
+static WallClock_Status_T g_wallClockStatus = {0};
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Start an oscillator and the calendar on it. */
+static bool WallClock_StartRtc(void);
+/** Program the wake-up timer and its interrupt flag. */
+static bool WallClock_StartWakeup(void);
+/** Consistent copy of the base and the cycle counter. */
+static inline void WallClock_Read(WallClock_Base_T *base, uint32_t *counter);
+/** Monotonic time at @p counter on @p base. */
+static inline uint64_t WallClock_MonoAt(const WallClock_Base_T *base, uint32_t counter);
+/** @p d times @p rate in 2^-32 units, for any @p d. */
+static int64_t WallClock_Scale(int64_t d, int64_t rate);
+/** ppb as a rate in 2^-32 units. */
+static int64_t WallClock_RateOf(int32_t ppb);
+/** Move the base to @p counter and publish it; interrupts masked by the caller. */
+static void WallClock_Rebase(uint32_t counter, bool step, uint64_t utc, int64_t rate);
+/** Fold one wake-up into the RTC clock measurement. */
+static void WallClock_MeasureRtc(uint64_t mono);
+/** Set the RTC calendar to the current UTC. */
+static void WallClock_SetRtc(void);
+/** Program the smooth calibration that makes the calendar run at the UTC rate. */
+static void WallClock_Calibrate(void);
+/** Enter the RTC initialisation mode. */
+static bool WallClock_EnterInit(void);
+/** Wait for the calendar shadow registers to be refreshed. */
+static bool WallClock_Resync(void);
+/** Poll an RTC flag until it reads @p set. */
+static bool WallClock_WaitFlag(uint32_t (*flag)(const RTC_TypeDef *rtc), bool set);
+/** Days since 1970-01-01 of a date. */
+static int64_t WallClock_DaysFromCivil(int64_t year, uint32_t month, uint32_t day);
+/** Clamp to ±::WALLCLOCK_MAX_PPB. */
+static int32_t WallClock_Limit(int64_t ppb);
+/** RTC wake-up interrupt: refresh the base. */
+static void WallClock_IrqHandler(void *ctx);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start the RTC if needed, publish the first base and take the wake-up interrupt.
+ */
+bool WallClock_Init(void)
+{
+    /* Largest shift whose multiplier still fits in 32 bits */
+    for (g_wallClockShift = 32U; g_wallClockShift > 0U; g_wallClockShift--)
+    {
+        uint64_t mult = (WALLCLOCK_NS_PER_S << g_wallClockShift) / SystemCoreClock;
+        if (mult <= UINT32_MAX)
+        {
+            g_wallClockMult = (uint32_t)mult;
+            break;
+        }
+    }
+
+    LL_PWR_EnableBkUpAccess();
+    LL_APB4_GRP1_EnableClock(LL_APB4_GRP1_PERIPH_RTCAPB);
+    uint32_t source = LL_RCC_GetRTCClockSource();
+    g_wallClockStatus.rtc_valid = (LL_RTC_IsActiveFlag_INITS(WALLCLOCK_RTC) != 0U) &&
+                                  ((source == LL_RCC_RTC_CLKSOURCE_LSE) || (source == LL_RCC_RTC_CLKSOURCE_LSI));
+    if (g_wallClockStatus.rtc_valid)
+    {
+        /* Kept running from the backup domain, with its prescalers and calibration */
+        g_wallClockStatus.lse = (source == LL_RCC_RTC_CLKSOURCE_LSE);
+        g_wallClockRtcHz = g_wallClockStatus.lse ? LSE_VALUE : LSI_VALUE;
+        LL_APB4_GRP1_EnableClock(LL_APB4_GRP1_PERIPH_RTC);
+    }
+    else if (!WallClock_StartRtc())
+    {
+        return false;
+    }
+    g_wallClockSecondTicks = LL_RTC_GetSynchPrescaler(WALLCLOCK_RTC) + 1U;
+    uint32_t calr = READ_REG(WALLCLOCK_RTC->CALR);
+    int64_t excess = (((calr & RTC_CALR_CALP) != 0U) ? WALLCLOCK_CAL_PULSES : 0) - (int64_t)(calr & RTC_CALR_CALM);
+    g_wallClockStatus.cal_ppb =
+        (int32_t)((excess * (int64_t)WALLCLOCK_NS_PER_S) / ((int64_t)WALLCLOCK_CAL_WINDOW - excess));
+
+    if (!WallClock_StartWakeup() ||
+        !IsrMgr_Register(WALLCLOCK_IRQ, WallClock_IrqHandler, NULL))
+    {
+        return false;
+    }
+
+    g_wallClockReady = true;
+    uint64_t utc = 0U;
+    (void)WallClock_ReadRtc(&utc);
+    g_wallClockBase.counter = DWT->CYCCNT;
+    g_wallClockBase.utc = utc;
+    g_wallClockBase.rate = WallClock_RateOf(g_wallClockStatus.cal_ppb);
+    g_wallClockStatus.rate_ppb = g_wallClockStatus.cal_ppb;
+
+    NVIC_SetPriority(WALLCLOCK_IRQ,
+                     NVIC_EncodePriority(NVIC_GetPriorityGrouping(), configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY, 0));
+    NVIC_ClearPendingIRQ(WALLCLOCK_IRQ);
+    NVIC_EnableIRQ(WALLCLOCK_IRQ);
+    return true;
+}
+
+/**
+ * @brief Monotonic time from the published base and the cycle counter.
+ */
+uint64_t WallClock_Mono(void)
+{
+    WallClock_Base_T base;
+    uint32_t counter;
+
+    WallClock_Read(&base, &counter);
+    return WallClock_MonoAt(&base, counter);
+}
+
+/**
+ * @brief UTC from the published base and the cycle counter.
+ *
+ * Less than one refresh period separates the reading from the base, so
+ * the rate product fits in 64 bits without splitting it.
+ */
+uint64_t WallClock_Utc(void)
+{
+    WallClock_Base_T base;
+    uint32_t counter;
+
+    WallClock_Read(&base, &counter);
+    uint64_t d = WallClock_MonoAt(&base, counter) - base.mono;
+    int64_t corr = ((int64_t)d * base.rate) + (int64_t)base.ufrac;
+    return base.utc + d + (uint64_t)(corr >> 32);
+}
+
+/**
+ * @brief UTC at any monotonic time through the published mapping.
+ */
+uint64_t WallClock_MonoToUtc(uint64_t mono_ns)
+{
+    WallClock_Base_T base;
+    uint32_t counter;
+
+    WallClock_Read(&base, &counter);
+    int64_t d = (int64_t)(mono_ns - base.mono);
+    return base.utc + (uint64_t)d + (uint64_t)WallClock_Scale(d, base.rate);
+}
+
+/**
+ * @brief Step or slew to a reference time and update the frequency estimate.
+ *
+ * The frequency comes from the reference points alone, the first of the
+ * window against the latest, so the slews applied meanwhile do not bias
+ * it and its noise falls as the window grows. Once a window is complete,
+ * a new one only replaces the estimate after a quarter of its length.
+ */
+bool WallClock_Sync(uint64_t utc_ns, uint64_t mono_ns)
+{
+    WallClock_Servo_T *s = &g_wallClockServo;
+
+    if (!g_wallClockReady || (mono_ns > WallClock_Mono()) || (s->synced && (mono_ns <= s->lastMono)) ||
+        (utc_ns < (WALLCLOCK_RTC_FIRST_S * WALLCLOCK_NS_PER_S)) || (utc_ns >= (WALLCLOCK_RTC_END_S * WALLCLOCK_NS_PER_S)))
+    {
+        g_wallClockStatus.rejected++;
+        return false;
+    }
+
+    int64_t offset = (int64_t)(utc_ns - WallClock_MonoToUtc(mono_ns));
+    bool step = !s->synced || (offset > (int64_t)WALLCLOCK_STEP_NS) || (offset < -(int64_t)WALLCLOCK_STEP_NS);
+    int32_t rate;
+    if (step)
+    {
+        if (!s->synced)
+        {
+            /* The clock ran at the calendar rate so far, the best guess until a second sync */
+            s->freq = g_wallClockStatus.rate_ppb;
+        }
+        s->anchorMono = mono_ns;
+        s->anchorUtc = utc_ns;
+        rate = s->freq;
+    }
+    else
+    {
+        uint64_t span = mono_ns - s->anchorMono;
+        int64_t estimate = (((int64_t)(utc_ns - s->anchorUtc) - (int64_t)span) * (int64_t)WALLCLOCK_NS_PER_S) /
+                           (int64_t)span;
+        if (!s->windowDone || (span >= ((WALLCLOCK_FREQ_WINDOW_S * WALLCLOCK_NS_PER_S) / 4U)))
+        {
+            s->freq = WallClock_Limit(estimate);
+        }
+        if (span >= (WALLCLOCK_FREQ_WINDOW_S * WALLCLOCK_NS_PER_S))
+        {
+            s->windowDone = true;
+            s->anchorMono = mono_ns;
+            s->anchorUtc = utc_ns;
+        }
+        int64_t slew = (offset * (int64_t)WALLCLOCK_NS_PER_S) /
+                       (int64_t)((mono_ns - s->lastMono) * WALLCLOCK_SLEW_SYNCS);
+        rate = WallClock_Limit((int64_t)s->freq + WallClock_Limit(slew));
+    }
+    s->lastMono = mono_ns;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t counter = DWT->CYCCNT;
+    int64_t rateQ32 = WallClock_RateOf(rate);
+    int64_t since = (int64_t)(WallClock_MonoAt(&g_wallClockBase, counter) - mono_ns);
+    WallClock_Rebase(counter, step, utc_ns + (uint64_t)since + (uint64_t)WallClock_Scale(since, rateQ32), rateQ32);
+    s->synced = true;
+    g_wallClockStatus.synced = true;
+    g_wallClockStatus.syncs++;
+    g_wallClockStatus.steps += step ? 1U : 0U;
+    g_wallClockStatus.freq_ppb = s->freq;
+    g_wallClockStatus.rate_ppb = rate;
+    g_wallClockStatus.last_offset_ns = offset;
+    __set_PRIMASK(primask);
+
+    if (step)
+    {
+        WallClock_SetRtc();
+    }
+    WallClock_Calibrate();
+    return true;
+}
+
+/**
+ * @brief Read the calendar as UTC.
+ *
+ * Reading SSR locks TR and DR until DR is read, so the three belong to
+ * the same instant.
+ */
+bool WallClock_ReadRtc(uint64_t *utc_ns)
+{
+    if (!g_wallClockReady || (utc_ns == NULL))
+    {
+        return false;
+    }
+
+    uint32_t ss = LL_RTC_TIME_GetSubSecond(WALLCLOCK_RTC);
+    uint32_t time = LL_RTC_TIME_Get(WALLCLOCK_RTC);
+    uint32_t date = LL_RTC_DATE_Get(WALLCLOCK_RTC);
+    WallClock_Calendar_T cal = {
+        .year = (uint16_t)(2000U + __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_YEAR(date))),
+        .month = __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_MONTH(date)),
+        .day = __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_DAY(date)),
+        .hour = __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_HOUR(time)),
+        .minute = __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_MINUTE(time)),
+        .second = __LL_RTC_CONVERT_BCD2BIN(__LL_RTC_GET_SECOND(time)),
+    };
+    /* The sub-second counter counts down from the prescaler value */
+    uint32_t elapsed = (ss < g_wallClockSecondTicks) ? ((g_wallClockSecondTicks - 1U) - ss) : 0U;
+    cal.ns = (uint32_t)(((uint64_t)elapsed * WALLCLOCK_NS_PER_S) / g_wallClockSecondTicks);
+    *utc_ns = WallClock_FromCalendar(&cal);
+    return true;
+}
+
+/**
+ * @brief Split UTC into a proleptic Gregorian date and a time of day.
+ */
+void WallClock_ToCalendar(uint64_t utc_ns, WallClock_Calendar_T *cal)
+{
+    if (cal == NULL)
+    {
+        return;
+    }
+
+    uint64_t seconds = utc_ns / WALLCLOCK_NS_PER_S;
+    uint64_t days = seconds / 86400U;
+    uint32_t rest = (uint32_t)(seconds % 86400U);
+    cal->ns = (uint32_t)(utc_ns % WALLCLOCK_NS_PER_S);
+    cal->hour = (uint8_t)(rest / 3600U);
+    cal->minute = (uint8_t)((rest / 60U) % 60U);
+    cal->second = (uint8_t)(rest % 60U);
+    /* 1970-01-01 was a Thursday */
+    cal->weekday = (uint8_t)(((days + 3U) % 7U) + 1U);
+
+    /* Years counted from March, so the leap day ends the year */
+    uint64_t z = days + WALLCLOCK_DAYS_TO_1970;
+    uint64_t era = z / 146097U;
+    uint32_t doe = (uint32_t)(z - (era * 146097U));
+    uint32_t yoe = (doe - (doe / 1460U) + (doe / 36524U) - (doe / 146096U)) / 365U;
+    uint32_t doy = doe - ((365U * yoe) + (yoe / 4U) - (yoe / 100U));
+    uint32_t mp = ((5U * doy) + 2U) / 153U;
+    cal->day = (uint8_t)((doy - (((153U * mp) + 2U) / 5U)) + 1U);
+    cal->month = (uint8_t)((mp < 10U) ? (mp + 3U) : (mp - 9U));
+    cal->year = (uint16_t)((era * 400U) + yoe + ((cal->month <= 2U) ? 1U : 0U));
+}
+
+/**
+ * @brief Combine a date and a time of day into UTC.
+ */
+uint64_t WallClock_FromCalendar(const WallClock_Calendar_T *cal)
+{
+    static const uint8_t monthDays[12] = {31U, 29U, 31U, 30U, 31U, 30U, 31U, 31U, 30U, 31U, 30U, 31U};
+
+    if ((cal == NULL) || (cal->year < 1970U) || (cal->year > WALLCLOCK_MAX_YEAR) || (cal->month < 1U) ||
+        (cal->month > 12U) || (cal->day < 1U) || (cal->day > monthDays[cal->month - 1U]) || (cal->hour > 23U) ||
+        (cal->minute > 59U) || (cal->second > 59U) || (cal->ns >= WALLCLOCK_NS_PER_S))
+    {
+        return 0U;
+    }
+    bool leap = ((cal->year % 4U) == 0U) && (((cal->year % 100U) != 0U) || ((cal->year % 400U) == 0U));
+    if ((cal->month == 2U) && (cal->day == 29U) && !leap)
+    {
+        return 0U;
+    }
+
+    uint64_t days = (uint64_t)WallClock_DaysFromCivil(cal->year, cal->month, cal->day);
+    uint64_t seconds = (days * 86400U) + ((uint32_t)cal->hour * 3600U) + ((uint32_t)cal->minute * 60U) + cal->second;
+    return (seconds * WALLCLOCK_NS_PER_S) + cal->ns;
+}
+
+/**
+ * @brief Copy the clock state and counters into @p status.
+ */
+void WallClock_GetStatus(WallClock_Status_T *status)
+{
+    if (status == NULL)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *status = g_wallClockStatus;
+    __set_PRIMASK(primask);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Start the LSE, or the LSI if the crystal does not start, and the calendar on it.
+ *
+ * The prescalers give a sub-second counter at a quarter of the RTC clock
+ * and a one-second calendar tick.
+ *
+ * @retval true  The calendar runs from 2000-01-01.
+ * @retval false Neither oscillator became ready, or the RTC did not enter
+ *               initialisation mode.
+ */
+static bool WallClock_StartRtc(void)
+{
+    uint32_t source = LL_RCC_RTC_CLKSOURCE_NONE;
+    LL_RCC_LSE_Enable();
+    for (uint32_t spin = 0U; (spin < WALLCLOCK_OSC_SPIN_LIMIT) && (source == LL_RCC_RTC_CLKSOURCE_NONE); spin++)
+    {
+        source = (LL_RCC_LSE_IsReady() != 0U) ? LL_RCC_RTC_CLKSOURCE_LSE : LL_RCC_RTC_CLKSOURCE_NONE;
+    }
+    if (source == LL_RCC_RTC_CLKSOURCE_NONE)
+    {
+        LL_RCC_LSI_Enable();
+        for (uint32_t spin = 0U; (spin < WALLCLOCK_OSC_SPIN_LIMIT) && (source == LL_RCC_RTC_CLKSOURCE_NONE); spin++)
+        {
+            source = (LL_RCC_LSI_IsReady() != 0U) ? LL_RCC_RTC_CLKSOURCE_LSI : LL_RCC_RTC_CLKSOURCE_NONE;
+        }
+    }
+    if (source == LL_RCC_RTC_CLKSOURCE_NONE)
+    {
+        return false;
+    }
+
+    LL_RCC_SetRTCClockSource(source);
+    LL_APB4_GRP1_EnableClock(LL_APB4_GRP1_PERIPH_RTC);
+    g_wallClockStatus.lse = (source == LL_RCC_RTC_CLKSOURCE_LSE);
+    g_wallClockRtcHz = g_wallClockStatus.lse ? LSE_VALUE : LSI_VALUE;
+
+    LL_RTC_DisableWriteProtection(WALLCLOCK_RTC);
+    bool init = WallClock_EnterInit();
+    if (init)
+    {
+        LL_RTC_SetHourFormat(WALLCLOCK_RTC, LL_RTC_HOURFORMAT_24HOUR);
+        LL_RTC_SetSynchPrescaler(WALLCLOCK_RTC, (g_wallClockRtcHz / (WALLCLOCK_PREDIV_A + 1U)) - 1U);
+        LL_RTC_SetAsynchPrescaler(WALLCLOCK_RTC, WALLCLOCK_PREDIV_A);
+        LL_RTC_DisableInitMode(WALLCLOCK_RTC);
+    }
+    LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+    return init;
+}
+
+/**
+ * @brief Run the wake-up timer on the RTC clock divided by 16 at ::WALLCLOCK_REFRESH_HZ.
+ *
+ * Waits first for the shadow registers, which a reset leaves stale.
+ *
+ * @retval true  Running, interrupt enabled.
+ * @retval false The shadow registers did not resynchronise, or the timer
+ *               could not be stopped for reprogramming.
+ */
+static bool WallClock_StartWakeup(void)
+{
+    uint32_t reload = (g_wallClockRtcHz / (WALLCLOCK_WAKEUP_DIV * WALLCLOCK_REFRESH_HZ)) - 1U;
+    g_wallClockWakeNs = (((uint64_t)reload + 1U) * WALLCLOCK_WAKEUP_DIV * WALLCLOCK_NS_PER_S) / g_wallClockRtcHz;
+
+    LL_RTC_DisableWriteProtection(WALLCLOCK_RTC);
+    bool stopped = WallClock_Resync();
+    LL_RTC_WAKEUP_Disable(WALLCLOCK_RTC);
+    stopped = stopped && WallClock_WaitFlag(LL_RTC_IsActiveFlag_WUTW, true);
+    if (stopped)
+    {
+        LL_RTC_WAKEUP_SetClock(WALLCLOCK_RTC, LL_RTC_WAKEUPCLOCK_DIV_16);
+        LL_RTC_WAKEUP_SetAutoReload(WALLCLOCK_RTC, reload);
+        LL_RTC_ClearFlag_WUT(WALLCLOCK_RTC);
+        LL_RTC_EnableIT_WUT(WALLCLOCK_RTC);
+        LL_RTC_WAKEUP_Enable(WALLCLOCK_RTC);
+    }
+    LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+    return stopped;
+}
+
+/**
+ * @brief Copy the base and read the cycle counter, again if a publication came in between.
+ */
+static inline void WallClock_Read(WallClock_Base_T *base, uint32_t *counter)
+{
+    uint32_t generation;
+
+    do
+    {
+        generation = __atomic_load_n(&g_wallClockGeneration, __ATOMIC_ACQUIRE);
+        *base = g_wallClockBase;
+        *counter = DWT->CYCCNT;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&g_wallClockGeneration, __ATOMIC_RELAXED) != generation);
+}
+
+/**
+ * @brief Monotonic time at @p counter, at most one counter period after the base.
+ */
+static inline uint64_t WallClock_MonoAt(const WallClock_Base_T *base, uint32_t counter)
+{
+    uint64_t scaled = ((uint64_t)(counter - base->counter) * g_wallClockMult) + base->frac;
+    return base->mono + (scaled >> g_wallClockShift);
+}
+
+/**
+ * @brief @p d times @p rate, shifted down by 32 bits and rounded towards zero.
+ *
+ * Split at 32 bits so neither product overflows for any @p d and a rate
+ * within ±::WALLCLOCK_MAX_PPB twice over.
+ */
+static int64_t WallClock_Scale(int64_t d, int64_t rate)
+{
+    bool negative = (d < 0) != (rate < 0);
+    uint64_t m = (d < 0) ? (0U - (uint64_t)d) : (uint64_t)d;
+    uint64_t r = (rate < 0) ? (0U - (uint64_t)rate) : (uint64_t)rate;
+    uint64_t scaled = ((m >> 32) * r) + (((m & UINT32_MAX) * r) >> 32);
+    return negative ? -(int64_t)scaled : (int64_t)scaled;
+}
+
+/**
+ * @brief Rate in 2^-32 units from a rate in ppb.
+ */
+static int64_t WallClock_RateOf(int32_t ppb)
+{
+    return ((int64_t)ppb * (INT64_C(1) << 32)) / (int64_t)WALLCLOCK_NS_PER_S;
+}
+
+/**
+ * @brief Advance the base to @p counter and publish it with @p rate.
+ *
+ * UTC either continues the previous mapping up to @p counter, remainder
+ * included, or restarts at @p utc on a step.
+ */
+static void WallClock_Rebase(uint32_t counter, bool step, uint64_t utc, int64_t rate)
+{
+    WallClock_Base_T next = g_wallClockBase;
+    uint64_t scaled = ((uint64_t)(counter - next.counter) * g_wallClockMult) + next.frac;
+    uint64_t d = scaled >> g_wallClockShift;
+
+    next.counter = counter;
+    next.frac = (uint32_t)(scaled & ((1ULL << g_wallClockShift) - 1U));
+    next.mono += d;
+    if (step)
+    {
+        next.utc = utc;
+        next.ufrac = 0U;
+    }
+    else
+    {
+        int64_t corr = ((int64_t)d * next.rate) + (int64_t)next.ufrac;
+        next.utc += d + (uint64_t)(corr >> 32);
+        next.ufrac = (uint32_t)corr;
+    }
+    next.rate = rate;
+
+    g_wallClockBase = next;
+    __atomic_fetch_add(&g_wallClockGeneration, 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Measure the RTC clock from the wake-ups seen since the window started.
+ *
+ * Each end is stamped when the interrupt runs, so its latency jitter
+ * divided by the span is the error of the measurement: nothing is
+ * published before the window covers ::WALLCLOCK_RTC_MIN_S, then every
+ * wake-up refines it until the full window. A period missed by a late
+ * interrupt shows as a rate far outside the crystal tolerance; the window
+ * then restarts.
+ */
+static void WallClock_MeasureRtc(uint64_t mono)
+{
+    WallClock_RtcMeas_T *m = &g_wallClockRtcMeas;
+
+    if (!m->started)
+    {
+        m->started = true;
+        m->startMono = mono;
+        m->wakeups = 0U;
+        return;
+    }
+
+    m->wakeups++;
+    uint64_t elapsed = mono - m->startMono;
+    int64_t ppb = (((int64_t)(m->wakeups * g_wallClockWakeNs) - (int64_t)elapsed) * (int64_t)WALLCLOCK_NS_PER_S) /
+                  (int64_t)elapsed;
+    if ((ppb > WALLCLOCK_MAX_PPB) || (ppb < -WALLCLOCK_MAX_PPB))
+    {
+        m->startMono = mono;
+        m->wakeups = 0U;
+        return;
+    }
+
+    if (m->wakeups < (WALLCLOCK_RTC_MIN_S * WALLCLOCK_REFRESH_HZ))
+    {
+        return;
+    }
+
+    if (!m->windowDone)
+    {
+        g_wallClockStatus.rtc_ppb = (int32_t)ppb;
+        g_wallClockStatus.rtc_measured = true;
+        m->known = true;
+    }
+    if (m->wakeups >= (WALLCLOCK_RTC_WINDOW_S * WALLCLOCK_REFRESH_HZ))
+    {
+        g_wallClockStatus.rtc_ppb = (int32_t)ppb;
+        m->windowDone = true;
+        m->startMono = mono;
+        m->wakeups = 0U;
+    }
+}
+
+/**
+ * @brief Set the calendar to the current UTC.
+ *
+ * The calendar restarts on the whole second when initialisation mode
+ * ends; the fraction of a second elapsed by then is added through a
+ * shift. Accurate to a sub-second count plus the few RTC clock cycles
+ * the RTC takes to apply each write.
+ */
+static void WallClock_SetRtc(void)
+{
+    for (uint32_t attempt = 0U; attempt < 2U; attempt++)
+    {
+        LL_RTC_DisableWriteProtection(WALLCLOCK_RTC);
+        if (!WallClock_EnterInit())
+        {
+            LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+            return;
+        }
+        WallClock_Calendar_T cal;
+        uint64_t second = WallClock_Utc() / WALLCLOCK_NS_PER_S;
+        WallClock_ToCalendar(second * WALLCLOCK_NS_PER_S, &cal);
+        LL_RTC_TIME_Config(WALLCLOCK_RTC, LL_RTC_TIME_FORMAT_AM_OR_24, __LL_RTC_CONVERT_BIN2BCD(cal.hour),
+                           __LL_RTC_CONVERT_BIN2BCD(cal.minute), __LL_RTC_CONVERT_BIN2BCD(cal.second));
+        LL_RTC_DATE_Config(WALLCLOCK_RTC, cal.weekday, __LL_RTC_CONVERT_BIN2BCD(cal.day),
+                           __LL_RTC_CONVERT_BIN2BCD(cal.month), __LL_RTC_CONVERT_BIN2BCD(cal.year - 2000U));
+        LL_RTC_DisableInitMode(WALLCLOCK_RTC);
+        uint64_t lag = WallClock_Utc() - (second * WALLCLOCK_NS_PER_S);
+
+        /* A second boundary passed while the registers were written: start over */
+        if (lag < WALLCLOCK_NS_PER_S)
+        {
+            uint32_t advance = (uint32_t)(((lag * g_wallClockSecondTicks) + (WALLCLOCK_NS_PER_S / 2U)) /
+                                          WALLCLOCK_NS_PER_S);
+            if ((advance != 0U) && WallClock_WaitFlag(LL_RTC_IsActiveFlag_SHP, false))
+            {
+                LL_RTC_TIME_Synchronize(WALLCLOCK_RTC, LL_RTC_SHIFT_SECOND_ADVANCE, g_wallClockSecondTicks - advance);
+            }
+            (void)WallClock_WaitFlag(LL_RTC_IsActiveFlag_SHP, false);
+            (void)WallClock_Resync();
+            LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+            return;
+        }
+        LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+    }
+}
+
+/**
+ * @brief Make the calendar run at the UTC rate through the smooth calibration.
+ *
+ * The calendar rate against UTC is that of the raw RTC clock against the
+ * core clock over that of UTC against the core clock. CALP adds 512
+ * cycles per 2^20 and CALM removes up to 511, so the correction covers
+ * about -487 to +488 ppm in steps of 0.954 ppm. Nothing is written while
+ * the previous value is still being applied, or before the RTC clock
+ * has been measured.
+ */
+static void WallClock_Calibrate(void)
+{
+    if (!g_wallClockRtcMeas.known || (LL_RTC_IsActiveFlag_RECALP(WALLCLOCK_RTC) != 0U))
+    {
+        return;
+    }
+
+    int64_t want = (int64_t)g_wallClockServo.freq - (int64_t)g_wallClockStatus.rtc_ppb;
+    uint32_t calp = (want > 0) ? RTC_CALR_CALP : 0U;
+    /* Cycles to add per window for a rate of 1 + want, rounded to the nearest */
+    int64_t den = (int64_t)WALLCLOCK_NS_PER_S + want;
+    int64_t num = want * (int64_t)WALLCLOCK_CAL_WINDOW;
+    int64_t add = (num + ((want > 0) ? (den / 2) : -(den / 2))) / den;
+    int64_t calm = ((calp != 0U) ? WALLCLOCK_CAL_PULSES : 0) - add;
+    calm = (calm < 0) ? 0 : ((calm > (int64_t)RTC_CALR_CALM) ? (int64_t)RTC_CALR_CALM : calm);
+
+    uint32_t calr = calp | (uint32_t)calm;
+    if (calr == (READ_REG(WALLCLOCK_RTC->CALR) & (RTC_CALR_CALP | RTC_CALR_CALM)))
+    {
+        return;
+    }
+    LL_RTC_DisableWriteProtection(WALLCLOCK_RTC);
+    WRITE_REG(WALLCLOCK_RTC->CALR, calr);
+    LL_RTC_EnableWriteProtection(WALLCLOCK_RTC);
+
+    int64_t excess = ((calp != 0U) ? WALLCLOCK_CAL_PULSES : 0) - calm;
+    int32_t cal = (int32_t)((excess * (int64_t)WALLCLOCK_NS_PER_S) / ((int64_t)WALLCLOCK_CAL_WINDOW - excess));
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_wallClockStatus.cal_ppb = cal;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Set INIT and wait for INITF; write protection disabled by the caller.
+ */
+static bool WallClock_EnterInit(void)
+{
+    LL_RTC_EnableInitMode(WALLCLOCK_RTC);
+    return WallClock_WaitFlag(LL_RTC_IsActiveFlag_INIT, true);
+}
+
+/**
+ * @brief Clear RSF and wait for it; write protection disabled by the caller.
+ */
+static bool WallClock_Resync(void)
+{
+    LL_RTC_ClearFlag_RS(WALLCLOCK_RTC);
+    return WallClock_WaitFlag(LL_RTC_IsActiveFlag_RS, true);
+}
+
+/**
+ * @brief Poll an RTC flag until it reads @p set.
+ *
+ * Bounded by a count rather than the SysTick-based timeouts of the LL
+ * helpers, as the kernel tick does not run yet at start-up.
+ *
+ * @retval true  It did.
+ * @retval false Not within ::WALLCLOCK_RTC_SPIN_LIMIT polls.
+ */
+static bool WallClock_WaitFlag(uint32_t (*flag)(const RTC_TypeDef *rtc), bool set)
+{
+    for (uint32_t spin = 0U; spin < WALLCLOCK_RTC_SPIN_LIMIT; spin++)
+    {
+        if ((flag(WALLCLOCK_RTC) != 0U) == set)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Days from 1970-01-01 to a proleptic Gregorian date, years counted from March.
+ */
+static int64_t WallClock_DaysFromCivil(int64_t year, uint32_t month, uint32_t day)
+{
+    year -= (month <= 2U) ? 1 : 0;
+    int64_t era = year / 400;
+    uint32_t yoe = (uint32_t)(year - (era * 400));
+    uint32_t doy = (((153U * ((month > 2U) ? (month - 3U) : (month + 9U))) + 2U) / 5U) + day - 1U;
+    uint32_t doe = (yoe * 365U) + (yoe / 4U) - (yoe / 100U) + doy;
+    return (era * 146097) + (int64_t)doe - WALLCLOCK_DAYS_TO_1970;
+}
+
+/**
+ * @brief Clamp a rate to ±::WALLCLOCK_MAX_PPB.
+ */
+static int32_t WallClock_Limit(int64_t ppb)
+{
+    return (int32_t)((ppb > WALLCLOCK_MAX_PPB) ? WALLCLOCK_MAX_PPB
+                                               : ((ppb < -WALLCLOCK_MAX_PPB) ? -WALLCLOCK_MAX_PPB : ppb));
+}
+
+/**
+ * @brief RTC wake-up: measure the RTC clock and republish the base.
+ *
+ * Before the first sync the UTC rate follows the calendar: the measured
+ * RTC clock corrected by the calibration in place.
+ */
+static void WallClock_IrqHandler(void *ctx)
+{
+    (void)ctx;
+    uint32_t counter = DWT->CYCCNT;
+    if (LL_RTC_IsActiveFlag_WUT(WALLCLOCK_RTC) == 0U)
+    {
+        return;
+    }
+    LL_RTC_ClearFlag_WUT(WALLCLOCK_RTC);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    WallClock_MeasureRtc(WallClock_MonoAt(&g_wallClockBase, counter));
+    int64_t rate = g_wallClockBase.rate;
+    if (!g_wallClockServo.synced && g_wallClockRtcMeas.known)
+    {
+        g_wallClockStatus.rate_ppb = WallClock_Limit((int64_t)g_wallClockStatus.rtc_ppb + g_wallClockStatus.cal_ppb);
+        rate = WallClock_RateOf(g_wallClockStatus.rate_ppb);
+    }
+    WallClock_Rebase(counter, false, 0U, rate);
+    g_wallClockStatus.refreshes++;
+    __set_PRIMASK(primask);
+}
+
+/** @} */ // end of WallClock group
@@ -51,6 +51,7 @@
 #if defined(__ICCARM__) || defined(__ARMCC_VERSION) || defined(__GNUC__)
 #include <stdint.h>
 extern uint32_t SystemCoreClock;
+extern void LpTick_SuppressTicksAndSleep(uint32_t expectedIdleTime);
 #endif
 #ifndef CMSIS_device_header
 #define CMSIS_device_header "stm32n6xx.h"
@@ -68,6 +69,9 @@ extern uint32_t SystemCoreClock;
 #define configSUPPORT_DYNAMIC_ALLOCATION 1
 #define configUSE_IDLE_HOOK 0
 #define configUSE_TICK_HOOK 0
+/* The tick comes from LPTIM1 and is suppressed at idle by the LpTick module,
+   see portSUPPRESS_TICKS_AND_SLEEP below. */
+#define configUSE_TICKLESS_IDLE 2
 #define configCPU_CLOCK_HZ (SystemCoreClock)
 #define configTICK_RATE_HZ ((TickType_t)1000)
 #define configMAX_PRIORITIES (56)
@@ -84,6 +88,9 @@ extern uint32_t SystemCoreClock;
 #define configENABLE_BACKWARD_COMPATIBILITY 0
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #define configUSE_TASK_NOTIFICATIONS 1
+/* Index 0 is the default task notification, index 1 is used by drivers to
+   signal completion to a task blocked in a *_Wait() call. */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
 #define configHEAP_CLEAR_MEMORY_ON_FREE 0
 #define configUSE_MINI_LIST_ITEM 1
 #define configUSE_SB_COMPLETED_CALLBACK 0
@@ -168,6 +175,7 @@ header file. */
 /* USER CODE END 1 */
 
 #define SysTick_Handler xPortSysTickHandler
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime) LpTick_SuppressTicksAndSleep(xExpectedIdleTime)
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
@@ -28,7 +28,6 @@
     {                                                                                 \
         .high_prio_mask = 0,                                                          \
         .high_prio_registry = {0},                                                    \
-        .regular_log_pool = {0},                                                      \
         .regular_log_queue = {0},                                                     \
         .log_head = 0,                                                                \
         .log_tail = 0,                                                                \
@@ -80,7 +79,6 @@ typedef struct Logger_Context_Tag
 {
     volatile uint32_t high_prio_mask;                                 /**< Bitmask for high-priority logs */
     Logger_Entry_T *high_prio_registry[LOGGER_HIGH_PRIO_LOGS_NUMBER]; /**< Registry for high-priority log entries */
-    Logger_Entry_T regular_log_pool[LOGGER_LOG_QUEUE_SIZE];           /**< Pool for normal-priority log entries */
     Logger_Entry_T *regular_log_queue[LOGGER_LOG_QUEUE_SIZE];         /**< Queue for normal-priority log entries */
     volatile uint8_t log_head;                                        /**< Head index of the normal log queue */
     volatile uint8_t log_tail;                                        /**< Tail index of the normal log queue */
@@ -90,7 +88,11 @@ typedef struct Logger_Context_Tag
 } Logger_Context_T;
 
 /**
- * @brief Allocates a log entry from the static pool
+ * @brief Allocates a log entry from the non-cacheable DMA buffer pool
+ *
+ * The entry goes back to the pool once it has been transmitted or
+ * dropped, so the UART DMA reads it without any cache maintenance.
+ *
  * @return Pointer to Logger_Entry_T if available, NULL otherwise
  */
 Logger_Entry_T *logger_alloc_entry(Logger_Context_T *ctx);
@@ -112,9 +114,10 @@ void logger_trigger_highprio(Logger_Context_T *ctx, uint8_t idx, uint32_t timest
  * @brief Logger transmission scheduler (called by logger task)
  *
  * Attempts to transmit the next pending log entry. If the underlying
- * UartDma_Transmit() call fails, the entry remains queued/registered and
- * the logger task is notified to retry. Retries continue until the
- * transmission succeeds.
+ * UART DMA call fails, the entry remains queued/registered and the logger
+ * task is notified to retry. Retries continue until the transmission
+ * succeeds. Regular entries are returned to the pool only when the driver
+ * reports the buffer as consumed.
  */
 void logger_tx_scheduler(Logger_Context_T *ctx);
 
@@ -4,8 +4,16 @@
  *
  * This source file contains the core logic of the logger component. Log
  * entries are formatted with a timestamp and transmitted using the UART
- * DMA driver. Both high-priority and normal entries share the same code
- * path so the implementation remains compact.
+ * DMA driver, or straight from the entry over the USB CDC port while a
+ * host holds it open. Both high-priority and normal entries share the
+ * same code path so the implementation remains compact. Every entry sent
+ * is also staged for the persistent log store, which never blocks.
+ *
+ * Normal entries are blocks of the non-cacheable DMA buffer pool, so the
+ * UART DMA driver skips the data cache clean when it submits them. They
+ * return to the pool when the driver reports the transfer done.
+ * High-priority entries are sent the same way and stay in use until that
+ * report, so a new trigger cannot rewrite one the DMA is still reading.
  */
 
 /* Includes -----------------------------------------------------------------*/
@@ -14,11 +22,15 @@
 #include <string.h>
 #include "logger.h"
 #include "UartDma.h"
+#include "LogStore.h"
+#include "UsbDev.h"
+#include "DmaPool.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "cmsis_gcc.h"
 
 /* Defines ------------------------------------------------------------------*/
+_Static_assert(sizeof(Logger_Entry_T) <= DMAPOOL_BLOCK_SIZE, "Logger_Entry_T must fit in a DMA pool block");
 
 /* Local Types and Typedefs -------------------------------------------------*/
 
@@ -35,38 +47,29 @@ static inline void enqueue_normal_log(Logger_Context_T *ctx, Logger_Entry_T *ent
 static inline Logger_Entry_T *peek_normal_log(Logger_Context_T *ctx);
 /** Format a log entry by prepending a timestamp. */
 static bool format_log_entry(Logger_Entry_T *entry);
+/** Return a regular log entry to the DMA pool once the UART has consumed it. */
+static void logger_tx_complete(void *arg, bool success);
+/** Release a high-priority log entry once the UART or USB has consumed it. */
+static void logger_highprio_complete(void *arg, bool success);
 
 /* Public Functions Implementation ------------------------------------------*/
 
 /*** Logger API ***/
 /**
- * @brief Allocates a log entry from the static pool.
+ * @brief Allocates a log entry from the DMA buffer pool.
  * @return Pointer to a Logger_Entry_T if available, NULL if pool is full.
  */
 Logger_Entry_T *logger_alloc_entry(Logger_Context_T *ctx)
 {
-    for (uint8_t i = 0; i < LOGGER_LOG_QUEUE_SIZE; i++)
+    (void)ctx;
+    Logger_Entry_T *entry = (Logger_Entry_T *)DmaPool_Alloc();
+    if (entry)
     {
-        bool expected = false;
-        /*
-         * Use an atomic compare-and-exchange to safely claim the entry.
-         * Without this, concurrent callers could observe the entry as
-         * available and allocate it multiple times, leading to lost logs.
-         */
-        if (__atomic_compare_exchange_n(&ctx->regular_log_pool[i].in_use,
-                                        &expected,
-                                        true,
-                                        false,
-                                        __ATOMIC_ACQUIRE,
-                                        __ATOMIC_RELAXED))
-        {
-
-            ctx->regular_log_pool[i].is_formatted = false;
-            memset(ctx->regular_log_pool[i].prefix, 0, LOGGER_PREFIX_SIZE);
-            return &(ctx->regular_log_pool[i]);
-        }
+        entry->in_use = true;
+        entry->is_formatted = false;
+        memset(entry->prefix, 0, LOGGER_PREFIX_SIZE);
     }
-    return NULL;
+    return entry;
 }
 
 /**
@@ -83,6 +86,11 @@ void logger_commit_entry(Logger_Context_T *ctx, Logger_Entry_T *entry)
 
 /**
  * @brief Triggers a high-priority preallocated log entry from ISR.
+ *
+ * The entry is claimed atomically; a trigger that finds it still pending
+ * or being transmitted is dropped and its timestamp pushed to the debug
+ * buffer, as a full regular queue does.
+ *
  * @param idx Index of the registered high-priority log.
  * @param timestamp Timestamp to assign to the log entry.
  */
@@ -94,9 +102,13 @@ void logger_trigger_highprio(Logger_Context_T *ctx, uint8_t idx, uint32_t timest
     if (!entry)
         return;
 
+    if (__atomic_exchange_n(&entry->in_use, true, __ATOMIC_ACQUIRE))
+    {
+        logger_debug_push(ctx, timestamp); // Previous trigger not sent yet
+        return;
+    }
     memset(entry->prefix, 0, LOGGER_PREFIX_SIZE); /* Clear prefix */
     entry->timestamp = timestamp;
-    entry->in_use = true;
     entry->is_formatted = false;
     __atomic_or_fetch(&(ctx->high_prio_mask), (1u << idx), __ATOMIC_RELAXED);
     xTaskNotifyGive(ctx->logger_task_handle);
@@ -118,9 +130,21 @@ void logger_tx_scheduler(Logger_Context_T *ctx)
         if (entry && entry->in_use)
         {
             bool isSent = false;
-            if (format_log_entry(entry))
+            bool isReady = entry->is_formatted;
+            if (!isReady && format_log_entry(entry))
             {
-                isSent = UartDma_Transmit((uint8_t *)&entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE);
+                /* Staged once, on the first formatting, before the DMA may release the entry */
+                (void)LogStore_Append(&entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE);
+                isReady = true;
+            }
+            if (isReady)
+            {
+                isSent = UsbDev_IsOpen(USBDEV_CDC)
+                             ? UsbDev_Submit(USBDEV_CDC, &entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE,
+                                             logger_highprio_complete, entry)
+                             : UartDma_TransmitAsync((uint8_t *)&entry->prefix[0],
+                                                     entry->length + LOGGER_PREFIX_SIZE, logger_highprio_complete,
+                                                     entry);
             }
             else
             {
@@ -129,8 +153,7 @@ void logger_tx_scheduler(Logger_Context_T *ctx)
 
             if (isSent)
             {
-                entry->in_use = false;
-                entry->is_formatted = false;
+                /* The entry stays in use until logger_highprio_complete() runs */
                 __atomic_and_fetch(&(ctx->high_prio_mask), ~(1u << idx), __ATOMIC_RELAXED);
             }
             else
@@ -150,17 +173,29 @@ void logger_tx_scheduler(Logger_Context_T *ctx)
     if (entry)
     {
         bool isSent = false;
-        bool isReady = entry->is_formatted ? true : format_log_entry(entry);
-        if (isReady)
+        bool isReady = entry->is_formatted;
+        if (!isReady && format_log_entry(entry))
         {
-            isSent = UartDma_Transmit((uint8_t *)&entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE);
+            /* Staged once, on the first formatting, before the DMA may release the entry */
+            (void)LogStore_Append(&entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE);
+            isReady = true;
+        }
+        if (isReady && UsbDev_IsOpen(USBDEV_CDC))
+        {
+            isSent = UsbDev_Submit(USBDEV_CDC, &entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE,
+                                   logger_tx_complete, entry);
+        }
+        else if (isReady)
+        {
+            isSent = UartDma_TransmitAsync((uint8_t *)&entry->prefix[0], entry->length + LOGGER_PREFIX_SIZE,
+                                           logger_tx_complete, entry);
         }
 
         if (isSent)
         {
+            /* The entry stays allocated until logger_tx_complete() runs so
+             * it cannot be reused while a DMA is still reading it. */
             dequeue_normal_log(ctx);
-            entry->in_use = false;
-            entry->is_formatted = false;
         }
         else
         {
@@ -208,6 +243,43 @@ void logger_debug_push(Logger_Context_T *ctx, uint32_t value)
 }
 
 /* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief UART DMA and USB completion callback for regular log entries.
+ *
+ * Runs from the DMA or OTG interrupt (or the driver supervisor when the
+ * transfer was dropped) and releases the entry back to the DMA pool.
+ *
+ * @param arg     Pointer to the transmitted Logger_Entry_T.
+ * @param success Unused, the entry is released either way.
+ */
+static void logger_tx_complete(void *arg, bool success)
+{
+    Logger_Entry_T *entry = (Logger_Entry_T *)arg;
+    (void)success;
+
+    entry->in_use = false;
+    entry->is_formatted = false;
+    DmaPool_Free(entry);
+}
+
+/**
+ * @brief UART DMA and USB completion callback for high-priority log entries.
+ *
+ * Runs in the same contexts as ::logger_tx_complete and frees the entry
+ * for the next ::logger_trigger_highprio.
+ *
+ * @param arg     Pointer to the transmitted Logger_Entry_T.
+ * @param success Unused, the entry is released either way.
+ */
+static void logger_highprio_complete(void *arg, bool success)
+{
+    Logger_Entry_T *entry = (Logger_Entry_T *)arg;
+    (void)success;
+
+    entry->is_formatted = false;
+    __atomic_store_n(&entry->in_use, false, __ATOMIC_RELEASE);
+}
+
 /**
  * @brief Place a log entry into the regular log queue.
  */
@@ -224,6 +296,7 @@ static inline void enqueue_normal_log(Logger_Context_T *ctx, Logger_Entry_T *ent
         logger_debug_push(ctx, entry->timestamp); // Log queue full
         entry->in_use = false;                    // Drop log if queue full
         entry->is_formatted = false;
+        DmaPool_Free(entry);
     }
 }
 
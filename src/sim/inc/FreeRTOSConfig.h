@@ -0,0 +1,38 @@
+/**
+ * @file FreeRTOSConfig.h
+ * @brief Host overrides on top of the firmware FreeRTOS configuration.
+ *
+ * Keeps every application setting from `cfg/inc/FreeRTOSConfig.h` and only
+ * changes what the host port needs:
+ *  - the idle hook drives simulated time forward while all tasks block,
+ *  - failed assertions stop the process instead of spinning,
+ *  - the heap grows to absorb 64-bit pointers in kernel objects,
+ *  - tasks can be looked up by name so benches can pause the demo task.
+ */
+
+#ifndef SIM_FREERTOS_CONFIG_H
+#define SIM_FREERTOS_CONFIG_H
+
+/* Includes -----------------------------------------------------------------*/
+#include_next <FreeRTOSConfig.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+extern void vSimPortAssertFailed(const char *file, int line);
+
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK 1
+
+#undef configASSERT
+#define configASSERT(x)                              \
+    if ((x) == 0)                                    \
+    {                                                \
+        vSimPortAssertFailed(__FILE__, __LINE__);    \
+    }
+
+#undef INCLUDE_xTaskGetHandle
+#define INCLUDE_xTaskGetHandle 1
+
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE ((size_t)(2U * 8192U))
+
+#endif /* SIM_FREERTOS_CONFIG_H */
@@ -0,0 +1,410 @@
+/**
+ * @file SimHw.h
+ * @brief Register-level model of the STM32N6 peripherals used by the drivers.
+ *
+ * The peripheral and system control space windows are mapped at their
+ * silicon addresses so the device header instance macros (`USART1`,
+ * `GPDMA1`, `SCB`, `NVIC`, `DWT`, ...) and the LL inline functions work
+ * unchanged on the host. Behaviour is provided by per-peripheral model
+ * structs that watch those windows:
+ *  - USART1: baud rate from BRR/PRESC/OVER8 and the RCC kernel clock,
+ *    frame format from CR1/CR2, TX FIFO, TXE/TC/TEACK flags, DMA requests,
+ *  - GPDMA1/HPDMA1: 16 channels each, peripheral-paced and software
+ *    triggered block transfers, linked-list items loaded from memory,
+ *    HT/TC/DTE/ULE/USE/SUSP flags, suspend/reset,
+ *  - DMA2D: memory-to-memory with and without pixel-format conversion,
+ *    blending and register-to-memory fills on direct colour modes,
+ *  - CRC: programmable polynomial of 7, 8, 16 or 32 bits, input and
+ *    output reversal, fed by CPU stores of any width or DMA word beats,
+ *  - RNG: four-word output FIFO refilled at a fixed rate, DRDY and error
+ *    interrupts, seed and clock errors injected on request and cleared
+ *    through the CONDRST sequence,
+ *  - PKA: RAM initialisation on enable, ECDSA verification and modular
+ *    exponentiation computed by the software reference after a modelled
+ *    duration, end of operation and error interrupts,
+ *  - SPI1: master with MOSI looped back to MISO, frame time from the
+ *    kernel clock and MBR/BPASS, TX/RX FIFOs served by DMA, TSIZE count
+ *    with TXTF/EOT, overrun when RX is not drained, CSUSP suspend; while
+ *    PA4 is driven low a 4 KiB-sector NOR flash answers instead, with
+ *    JEDEC ID, READ/FAST_READ, WREN/WRDI, page program and sector erase
+ *    busy for their duration, contents in a host file and a power loss
+ *    that cuts a chosen program or erase half way,
+ *  - I2C1: master with bit time from TIMINGR and the kernel clock,
+ *    START/repeated START, NBYTES with RELOAD/AUTOEND, TC/TCR/STOPF/NACKF,
+ *    DMA requests, SCL stretched while a data register waits; two targets
+ *    on the bus, a sensor at 0x48 whose registers 0-3 change on every
+ *    read and a 256-byte register file at 0x50, both with an auto
+ *    incremented register pointer set by the first written byte,
+ *  - I3C1: SDR controller with push-pull and open-drain bit times from
+ *    TIMINGR0, one-word control FIFO, 8-byte RX FIFO, DMA requests,
+ *    private messages, broadcast and direct CCCs, ENTDAA with ID
+ *    arbitration, FCF/ERRF with NACK and overrun errors; three targets, an
+ *    IMU raising in-band interrupts with a payload every 2 ms, a pressure
+ *    sensor raising them without payload every 5 ms and ending reads
+ *    after 3 bytes, and a plain register file,
+ *  - TIM2, TIM3 and TIM5: up-counters with PSC/ARR from the timer kernel
+ *    clock, live CNT, UG and CC1G, UIF and the channel 1 compare flag
+ *    CC1IF, a word-wide DMA request on update while UDE is set; TIM2
+ *    drives TRGO on update,
+ *  - ADC1: enable, calibration and ADSTART/ADSTP, regular sequence
+ *    started by software or by TIM2 TRGO, sampling time per channel from
+ *    the kernel clock, oversampling with OVSS shift, EOC/EOS/OVR and DMA
+ *    requests; input n is a sine of (n + 1) x 100 Hz around mid-scale with
+ *    noise on every conversion,
+ *  - LPTIM1: counter from the RCC kernel clock and PRESC wrapping after
+ *    ARR, live CNT, CC1IF and ARRM matches, DIEROK, ARROK and CMP1OK
+ *    confirming register writes, ICR clears,
+ *  - SDMMC1: commands timed on the bus clock with R1/R2/R3/R6/R7
+ *    responses and CTIMEOUT when the card does not answer, multi-block
+ *    transfers through the IDMA in single-buffer or linked-list mode with
+ *    IDMABTC, IDMATE, DATAEND and DABORT, busy on D0 after CMD12; the card
+ *    is an SDHC card whose blocks live in a host file, with access,
+ *    programming and pre-erased programming times,
+ *  - USB1 OTG HS: device mode with the internal DMA, W1C interrupt
+ *    registers, core reset and FIFO flushes completing at once, endpoint
+ *    disable; a host on the cable debounces the pull-up, resets the bus
+ *    at high speed (full speed when DCFG asks for it), enumerates the
+ *    device, opens and closes its CDC port on request and reads its bulk
+ *    IN endpoints, one packet per transaction timed on the bus,
+ *  - GPIO: BSRR and BRR applied to ODR from the CPU or DMA word beats,
+ *    mirrored into IDR, inputs held at levels scheduled from outside,
+ *    level changes of chosen pins recorded with their time,
+ *  - EXTI: lines 0 to 15 routed to a port through EXTICR, rising and
+ *    falling edges of IDR latched in W1C pending registers, EXTIn
+ *    interrupts through IMR1,
+ *  - RTC: calendar and sub-second counter on the clock RTCSEL selects,
+ *    running off its nominal frequency by a configured error, INIT
+ *    freezing and restarting it, TR and DR latched by an SSR read, SHIFTR
+ *    and the smooth calibration of CALR applied at once, wake-up timer
+ *    raising WUTF with its interrupt,
+ *  - RCC: oscillators enabled through CSR and disabled through CCR,
+ *    ready at once,
+ *  - data cache: write-back lines between the CPU and the DMA masters
+ *    (GPDMA1/HPDMA1, DMA2D, SDMMC1 IDMA, USB1 DMA), cleaned and
+ *    invalidated by address, with the MPU regions deciding what is
+ *    cacheable, see SimHw_DCache.c,
+ *  - NVIC, SysTick, PendSV and the DWT cycle counter.
+ *
+ * Time is virtual. It moves forward when the CPU is charged for register
+ * accesses, memcpy/memset calls, data cache maintenance by address and kernel critical sections, and jumps to the next hardware
+ * event when every task is blocked. Interrupts are taken at
+ * synchronisation points: barriers, interrupt unmasking and idle.
+ */
+
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#define SIMHW_PERIPH_BASE  (0x40000000UL) /**< Start of the NS + S peripheral windows */
+#define SIMHW_PERIPH_SIZE  (0x20000000UL) /**< Size of the mapped peripheral space */
+#define SIMHW_SCS_BASE     (0xE0000000UL) /**< Start of the private peripheral bus */
+#define SIMHW_SCS_SIZE     (0x00100000UL) /**< Size of the mapped private peripheral bus */
+
+#define SIMHW_IRQ_COUNT    (256U) /**< External interrupt lines covered by the NVIC model */
+#define SIMHW_NO_EVENT     (UINT64_MAX) /**< Returned when no hardware event is scheduled */
+
+#ifndef SIMHW_DEFAULT_REG_ACCESS_NS
+#define SIMHW_DEFAULT_REG_ACCESS_NS (10U) /**< CPU time charged per modelled register access */
+#endif
+
+#ifndef SIMHW_DEFAULT_M2M_BYTES_PER_US
+#define SIMHW_DEFAULT_M2M_BYTES_PER_US (400U) /**< Memory-to-memory DMA bandwidth */
+#endif
+
+#ifndef SIMHW_DEFAULT_DMA2D_PIXELS_PER_US
+#define SIMHW_DEFAULT_DMA2D_PIXELS_PER_US (200U) /**< DMA2D output rate */
+#endif
+
+#ifndef SIMHW_DEFAULT_CPU_COPY_BYTES_PER_US
+#define SIMHW_DEFAULT_CPU_COPY_BYTES_PER_US (1600U) /**< memcpy/memset throughput of the CPU */
+#endif
+
+#ifndef SIMHW_DEFAULT_DCACHE_LINE_NS
+#define SIMHW_DEFAULT_DCACHE_LINE_NS (20U) /**< CPU time of a data cache clean or invalidate per 32-byte line */
+#endif
+
+#ifndef SIMHW_DEFAULT_RNG_WORD_NS
+#define SIMHW_DEFAULT_RNG_WORD_NS (1000U) /**< Time the RNG takes per 32-bit word */
+#endif
+
+#ifndef SIMHW_DEFAULT_PKA_WORD_MUL_NS
+#define SIMHW_DEFAULT_PKA_WORD_MUL_NS (10U) /**< PKA time per 32x32-bit product of a modular multiplication */
+#endif
+
+#ifndef SIMHW_DEFAULT_SD_BLOCKS
+#define SIMHW_DEFAULT_SD_BLOCKS (65536U) /**< Capacity of the simulated SD card, 32 MiB */
+#endif
+
+#ifndef SIMHW_DEFAULT_NOR_BYTES
+#define SIMHW_DEFAULT_NOR_BYTES (1024U * 1024U) /**< Capacity of the simulated NOR flash */
+#endif
+
+/* Typedefs -----------------------------------------------------------------*/
+/**
+ * @brief Model configuration and fault injection.
+ */
+typedef struct
+{
+    uint32_t reg_access_ns;    /**< CPU time charged per modelled register access */
+    uint32_t m2m_bytes_per_us; /**< Software-triggered DMA bandwidth */
+    uint32_t cpu_copy_bytes_per_us; /**< memcpy/memset throughput charged to the CPU */
+    uint32_t dma2d_pixels_per_us; /**< DMA2D output rate */
+    uint32_t dcache_line_ns;   /**< CPU time of a data cache clean or invalidate per 32-byte line */
+    uint32_t rng_word_ns;      /**< Time the RNG takes per 32-bit word */
+    uint32_t pka_word_mul_ns;  /**< PKA time per 32x32-bit product of a modular multiplication */
+    uint32_t dte_every;        /**< Raise DTE on every Nth DMA channel start, 0 = never */
+    uint32_t rng_fault_every;  /**< Replace every Nth RNG word by a seed or clock error, 0 = never */
+    uint64_t stall_start_ns;   /**< USART transmitter stalls from this time ... */
+    uint64_t stall_end_ns;     /**< ... until this time (equal values disable the stall) */
+    FILE *tx_sink;             /**< Receives every byte shifted out of USART1, may be NULL */
+    FILE *sd_image;            /**< Contents of the SD card, opened for update; NULL for a temporary file */
+    uint32_t sd_blocks;        /**< SD card capacity in 512-byte blocks, a multiple of 1024 */
+    FILE *nor_image;           /**< Contents of the NOR flash, opened for update; NULL to keep them in memory */
+    uint32_t nor_bytes;        /**< NOR flash capacity, a power of two from 64 KiB to 16 MiB */
+    uint32_t nor_power_loss_at; /**< Cut the NOR supply during its Nth program or erase, 0 = never */
+    int32_t rtc_ppb;           /**< Error of the RTC clock against its nominal frequency */
+} SimHw_Config_T;
+
+/**
+ * @brief Counters kept by the model.
+ */
+typedef struct
+{
+    uint64_t now_ns;             /**< Current virtual time */
+    uint64_t usart_tx_bytes;     /**< Bytes shifted out of USART1 */
+    uint64_t usart_busy_ns;      /**< Time the USART1 transmitter was shifting */
+    uint64_t dma_starts;         /**< DMA channel starts accepted */
+    uint64_t dma_bytes;          /**< Bytes moved by all DMA channels */
+    uint64_t dma_errors;         /**< DTE/USE raised, injected or detected */
+    uint64_t dma2d_pixels;       /**< Pixels written by the DMA2D */
+    uint64_t dcache_lines;       /**< Data cache lines followed by the cache model */
+    uint64_t dcache_writebacks;  /**< Dirty lines written back by a clean */
+    uint64_t dcache_dirty_reads; /**< DMA reads of a line holding CPU writes not yet cleaned */
+    uint64_t dcache_dirty_drops; /**< Invalidates that dropped CPU writes not yet cleaned */
+    uint64_t crc_bytes;          /**< Bytes fed to the CRC unit */
+    uint64_t rng_words;          /**< Words produced by the RNG */
+    uint64_t rng_faults;         /**< RNG seed and clock errors injected */
+    uint64_t pka_ops;            /**< PKA operations completed */
+    uint64_t spi_bytes;          /**< Frames exchanged by SPI1 */
+    uint64_t spi_busy_ns;        /**< Time SPI1 was shifting */
+    uint64_t i2c_bytes;          /**< Address and data bytes on the I2C1 bus */
+    uint64_t i2c_busy_ns;        /**< Time the I2C1 bus was busy */
+    uint64_t i3c_bytes;          /**< Address, command, data and ID bytes on the I3C1 bus */
+    uint64_t i3c_busy_ns;        /**< Time the I3C1 bus was busy */
+    uint64_t i3c_ibis;           /**< In-band interrupts acknowledged by I3C1 */
+    uint64_t tim_updates;        /**< TIM2, TIM3 and TIM5 update events */
+    uint64_t tim_compares;       /**< TIM2, TIM3 and TIM5 channel 1 matches */
+    uint64_t tim_dma_requests;   /**< Update DMA requests raised by the timers */
+    uint64_t adc_conversions;    /**< ADC1 conversions, each oversampled one counted */
+    uint64_t adc_overruns;       /**< ADC1 results lost to an overrun */
+    uint64_t adc_trig_missed;    /**< ADC1 triggers ignored during a sequence */
+    uint64_t lptim_compares;     /**< LPTIM1 channel 1 matches */
+    uint64_t sd_commands;        /**< Commands sent by SDMMC1 */
+    uint64_t sd_bytes;           /**< Data bytes moved between SDMMC1 and the card */
+    uint64_t sd_busy_ns;         /**< Time the card spent transferring and programming data */
+    uint64_t nor_programs;       /**< NOR flash page programs */
+    uint64_t nor_erases;         /**< NOR flash sector erases */
+    uint64_t nor_busy_ns;        /**< Time the NOR flash spent programming and erasing */
+    uint64_t nor_power_losses;   /**< NOR flash operations cut by an injected power loss */
+    uint64_t usb_setups;         /**< SETUP packets sent by the USB host */
+    uint64_t usb_packets;        /**< USB data packets moved, zero-length ones included */
+    uint64_t usb_bytes;          /**< USB data bytes moved */
+    uint64_t usb_busy_ns;        /**< Time the USB bus carried transactions */
+    uint64_t gpio_edges;         /**< Level changes of the probed GPIO pins */
+    uint64_t exti_edges;         /**< Edges latched by EXTI lines 0 to 15 */
+    uint64_t rtc_wakeups;        /**< RTC wake-up timer reloads */
+    uint64_t irqs_taken;         /**< External interrupts dispatched */
+    uint64_t exceptions_taken;   /**< SysTick and PendSV exceptions dispatched */
+    uint64_t idle_ns;            /**< Time spent with every task blocked */
+} SimHw_Stats_T;
+
+/**
+ * @brief What the simulated USB host learned from the device.
+ */
+typedef struct
+{
+    bool attached;            /**< Cable plugged in */
+    bool configured;          /**< SET_CONFIGURATION accepted */
+    bool high_speed;          /**< The bus reset ended at high speed */
+    bool open;                /**< CDC port held open, DTR set */
+    uint8_t address;          /**< Address assigned */
+    uint16_t vid;             /**< idVendor */
+    uint16_t pid;             /**< idProduct */
+    char product[64];         /**< Product string, ASCII */
+    uint8_t cdc_in_ep;        /**< Bulk IN endpoint of the CDC data interface */
+    uint8_t cdc_out_ep;       /**< Bulk OUT endpoint of the CDC data interface */
+    uint8_t trace_in_ep;      /**< Bulk IN endpoint of the vendor interface */
+    uint16_t bulk_mps;        /**< Bulk packet size */
+    uint16_t config_bytes;    /**< wTotalLength of the configuration */
+    uint32_t control_done;    /**< Control transfers completed */
+    uint32_t control_stalled; /**< Control transfers refused or failed */
+    uint32_t protocol_errors; /**< Transactions the device got wrong */
+    uint64_t enumerated_ns;   /**< From the attach to SET_CONFIGURATION done */
+} SimHw_UsbHost_T;
+
+/**
+ * @brief Level change of the probed GPIO pins.
+ */
+typedef struct
+{
+    uint64_t ns;     /**< Virtual time of the change */
+    uint16_t levels; /**< Levels of the probed pins after it */
+} SimHw_GpioEdge_T;
+
+/** Callback run once the stop time has been reached. Must not return. */
+typedef void (*SimHw_StopHook_T)(void);
+
+/* Exported Variables -------------------------------------------------------*/
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Map the register windows and reset every model to its reset state.
+ *
+ * @param[in] config Model configuration, NULL for defaults.
+ * @retval true  Windows mapped.
+ * @retval false A window could not be mapped at its fixed address.
+ */
+bool SimHw_Init(const SimHw_Config_T *config);
+
+/**
+ * @brief Stop the simulation once virtual time reaches @p stopNs.
+ *
+ * @param[in] stopNs Stop time in ns.
+ * @param[in] hook   Called when the stop time is reached.
+ */
+void SimHw_SetStopTime(uint64_t stopNs, SimHw_StopHook_T hook);
+
+/**
+ * @brief Declare host memory outside the executable image as DMA-reachable.
+ *
+ * Accesses by a DMA channel to any other address raise a data transfer error.
+ */
+void SimHw_RegisterMemory(const void *base, size_t size);
+
+/** @brief Apply pending register writes and take any pending interrupt. */
+void SimHw_Sync(void);
+
+/** @brief Advance virtual time by @p ns of CPU work, without taking interrupts. */
+void SimHw_Charge(uint64_t ns);
+
+/**
+ * @brief Data cache clean and/or invalidate by address.
+ *
+ * Stands in for the CMSIS `SCB_*DCache_by_Addr` functions, see
+ * core_cm55.h. @p op is a mask of ::SIMHW_DCACHE_CLEAN and
+ * ::SIMHW_DCACHE_INVALIDATE applied to the cacheable lines of the range in
+ * the cache model. The CPU is charged one ::SimHw_Config_T::dcache_line_ns
+ * per line touched, followed by the barrier the CMSIS functions end with.
+ */
+void SimHw_DCacheByAddr(volatile void *addr, int32_t dsize, uint32_t op);
+
+/** @brief Charge @p ns of CPU work, then synchronise. */
+void SimHw_Advance(uint64_t ns);
+
+/** @brief Sleep until the next hardware event and take its interrupt. */
+void SimHw_Idle(void);
+
+/** @brief Leave every active exception, used when a task starts running. */
+void SimHw_EnterThreadMode(void);
+
+/** @brief Current virtual time in ns. */
+uint64_t SimHw_GetTimeNs(void);
+
+/** @brief Copy the model counters. */
+void SimHw_GetStats(SimHw_Stats_T *stats);
+
+/** @brief Configured USART1 line rate in bit/s, 0 when disabled. */
+uint32_t SimHw_GetUsartBaudrate(void);
+
+/**
+ * @brief Cut the NOR flash supply during a later program or erase.
+ *
+ * @param[in] afterOps   The supply fails during the Nth program or erase
+ *                       from now on, 0 disarms.
+ * @param[in] erasesOnly Count erases only.
+ */
+void SimHw_NorCutPower(uint32_t afterOps, bool erasesOnly);
+
+/** @brief Power the NOR flash up again after a cut. */
+void SimHw_NorPowerCycle(void);
+
+/** @brief Plug or unplug the cable between OTG1 and the simulated host. */
+void SimHw_UsbAttach(bool attached);
+
+/** @brief Have the host open or close the CDC port once the device is configured. */
+void SimHw_UsbOpen(bool open);
+
+/** @brief Copy what the host learned about the device. */
+void SimHw_UsbGetHost(SimHw_UsbHost_T *host);
+
+/**
+ * @brief Bytes the host read from a bulk IN endpoint.
+ *
+ * @param[in]  ep   Endpoint address or number.
+ * @param[out] hash FNV-1a 64 of those bytes, may be NULL.
+ * @return Byte count since the simulation started.
+ */
+uint64_t SimHw_UsbReceived(uint8_t ep, uint64_t *hash);
+
+/**
+ * @brief Copy the last bytes the host read from a bulk IN endpoint, oldest first.
+ *
+ * @return Bytes copied, at most 16 KiB.
+ */
+uint32_t SimHw_UsbRead(uint8_t ep, void *buf, uint32_t size);
+
+/**
+ * @brief Record the level changes of some pins of a port, whoever writes them.
+ *
+ * @param[in] port GPIO_TypeDef of the port watched, NULL to stop.
+ * @param[in] pins Pins watched, bit n for pin n.
+ */
+void SimHw_GpioProbe(const volatile void *port, uint16_t pins);
+
+/**
+ * @brief Hold a pin at a level from a given time on, as a signal from outside would.
+ *
+ * From then on IDR shows that level whatever ODR holds, and its edges
+ * reach the EXTI.
+ *
+ * @param[in] port  GPIO_TypeDef of the port.
+ * @param[in] pin   Pin number.
+ * @param[in] level Level.
+ * @param[in] atNs  Virtual time of the change, now if already past.
+ *
+ * @retval true  Scheduled.
+ * @retval false Invalid port or pin, or 1024 changes already wait.
+ */
+bool SimHw_GpioDrive(const volatile void *port, uint8_t pin, bool level, uint64_t atNs);
+
+/**
+ * @brief Copy the level changes recorded since ::SimHw_GpioProbe, oldest first.
+ *
+ * @param[out] edges Destination, may be NULL to count only.
+ * @param[in]  max   Entries available at @p edges.
+ * @param[out] lost  Changes not recorded for lack of room, may be NULL.
+ * @return Entries copied, at most 8192.
+ */
+uint32_t SimHw_GpioEdges(SimHw_GpioEdge_T *edges, uint32_t max, uint32_t *lost);
+
+/* Core state, used by the host intrinsics in cmsis_gcc.h. */
+uint32_t SimHw_GetIpsr(void);
+uint32_t SimHw_GetPriMask(void);
+void SimHw_SetPriMask(uint32_t priMask);
+uint32_t SimHw_GetBasePri(void);
+void SimHw_SetBasePri(uint32_t basePri);
+uint32_t SimHw_LoadExclusive(volatile void *addr, uint32_t size);
+uint32_t SimHw_StoreExclusive(volatile void *addr, uint32_t size, uint32_t value);
+void SimHw_ClearExclusive(void);
+
+/* Register access hooks, used by the access macros in stm32n6xx.h. */
+void SimHw_WriteReg(volatile void *reg, size_t width, uint32_t value);
+uint32_t SimHw_ReadReg(const volatile void *reg, size_t width);
+
+#endif /* SIM_HW_H */
@@ -0,0 +1,179 @@
+/**
+ * @file SimHw_Model.h
+ * @brief Interface between the core of the register-level model and the peripheral models.
+ *
+ * Private to the simulation sources. SimHw.c owns the register windows,
+ * virtual time, the NVIC and the synchronisation points, and calls into every
+ * model through the hooks below: reset, the time of its next event, the
+ * events due by then, picking up plain stores to its registers and driving
+ * its interrupt lines. The models in turn use the core services declared here
+ * and the few entry points other models need, such as DMA requests and the
+ * chip select of the NOR flash.
+ */
+
+#ifndef SIM_HW_MODEL_H
+#define SIM_HW_MODEL_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw.h"
+#include <stm32n6xx.h> /* Found on the include path, so the host wrapper can chain to the device header */
+
+/* Macros and Defines -------------------------------------------------------*/
+
+/* Typedefs -----------------------------------------------------------------*/
+
+/* Exported Variables -------------------------------------------------------*/
+/* Core state read by the models. */
+extern SimHw_Config_T g_simHwConfig;
+extern SimHw_Stats_T g_simHwStats;
+extern bool g_simHwReady;
+extern bool g_simHwInModel;
+
+/* Exported Interfaces ------------------------------------------------------*/
+/* Core services used by the models. */
+void SimHw_SetPending(uint32_t exc);
+bool SimHw_IsReachable(uintptr_t addr, size_t size);
+
+/* D-cache model, seen by every DMA master. */
+void SimHw_DCacheReset(void);
+void SimHw_DCacheReconcile(void);
+void SimHw_DCacheDmaRead(uintptr_t addr, void *dst, size_t size);
+void SimHw_DCacheDmaWrite(uintptr_t addr, const void *src, size_t size);
+
+/* USART1 model. */
+void SimHw_UsartReconcile(void);
+void SimHw_UsartReset(void);
+uint64_t SimHw_UsartNextEventNs(void);
+void SimHw_UsartEvents(uint64_t now);
+void SimHw_UsartLines(void);
+bool SimHw_UsartDmaWrite(uintptr_t addr, uint8_t data);
+
+/* GPDMA1 and HPDMA1 model. */
+bool SimHw_DmaRequest(uint32_t request);
+void SimHw_DmaReset(void);
+uint64_t SimHw_DmaNextEventNs(void);
+void SimHw_DmaEvents(uint64_t now);
+void SimHw_DmaReconcileAll(void);
+bool SimHw_DmaReconcileAt(uintptr_t addr);
+void SimHw_DmaLines(void);
+
+/* DMA2D model. */
+void SimHw_Dma2dReconcile(void);
+void SimHw_Dma2dReset(void);
+uint64_t SimHw_Dma2dNextEventNs(void);
+void SimHw_Dma2dEvents(uint64_t now);
+void SimHw_Dma2dLines(void);
+
+/* CRC model. */
+bool SimHw_CrcWrite(uintptr_t addr, size_t width, uint32_t value);
+void SimHw_CrcReset(void);
+bool SimHw_CrcDmaWrite(uintptr_t addr, uint8_t data);
+
+/* RNG model. */
+void SimHw_RngReconcile(void);
+bool SimHw_RngRead(uintptr_t addr, uint32_t *value);
+void SimHw_RngReset(void);
+uint64_t SimHw_RngNextEventNs(void);
+void SimHw_RngEvents(uint64_t now);
+void SimHw_RngLines(void);
+
+/* PKA model. */
+void SimHw_PkaReconcile(void);
+void SimHw_PkaReset(void);
+uint64_t SimHw_PkaNextEventNs(void);
+void SimHw_PkaEvents(uint64_t now);
+void SimHw_PkaLines(void);
+
+/* SPI1 model. */
+void SimHw_SpiReconcile(void);
+void SimHw_SpiReset(void);
+uint64_t SimHw_SpiNextEventNs(void);
+void SimHw_SpiEvents(uint64_t now);
+void SimHw_SpiLines(void);
+bool SimHw_SpiDmaWrite(uintptr_t addr, uint8_t data);
+
+/* NOR flash model. */
+void SimHw_NorSelect(bool selected);
+uint8_t SimHw_NorExchange(uint8_t mosi);
+void SimHw_NorReset(void);
+bool SimHw_NorIsSelected(void);
+
+/* I2C1 model. */
+void SimHw_I2cReconcile(void);
+void SimHw_I2cReset(void);
+uint64_t SimHw_I2cNextEventNs(void);
+void SimHw_I2cEvents(uint64_t now);
+void SimHw_I2cLines(void);
+bool SimHw_I2cDmaWrite(uintptr_t addr, uint8_t data);
+
+/* I3C1 model. */
+void SimHw_I3cReconcile(void);
+bool SimHw_I3cWrite(uintptr_t addr, uint32_t value);
+bool SimHw_I3cRead(uintptr_t addr, uint32_t *value);
+void SimHw_I3cReset(void);
+uint64_t SimHw_I3cNextEventNs(void);
+void SimHw_I3cEvents(uint64_t now);
+void SimHw_I3cLines(void);
+bool SimHw_I3cDmaWrite(uintptr_t addr, uint8_t data);
+
+/* TIM2, TIM3 and TIM5 model. */
+bool SimHw_TimRead(uintptr_t addr, uint32_t *value);
+void SimHw_TimReset(void);
+uint64_t SimHw_TimNextEventNs(void);
+void SimHw_TimEvents(uint64_t now);
+void SimHw_TimReconcileAll(void);
+bool SimHw_TimReconcileAt(uintptr_t addr);
+void SimHw_TimLines(void);
+
+/* ADC1 model. */
+void SimHw_AdcReconcile(void);
+bool SimHw_AdcWrite(uintptr_t addr, uint32_t value);
+bool SimHw_AdcRead(uintptr_t addr, uint32_t *value);
+void SimHw_AdcTrigger(uint32_t extsel);
+void SimHw_AdcReset(void);
+uint64_t SimHw_AdcNextEventNs(void);
+void SimHw_AdcEvents(uint64_t now);
+void SimHw_AdcLines(void);
+
+/* LPTIM1 model. */
+void SimHw_LptimReconcile(void);
+bool SimHw_LptimRead(uintptr_t addr, uint32_t *value);
+void SimHw_LptimReset(void);
+uint64_t SimHw_LptimNextEventNs(void);
+void SimHw_LptimEvents(uint64_t now);
+void SimHw_LptimLines(void);
+
+/* SDMMC1 model. */
+void SimHw_SdmmcReconcile(void);
+bool SimHw_SdmmcWrite(uintptr_t addr, uint32_t value);
+void SimHw_SdmmcReset(void);
+uint64_t SimHw_SdmmcNextEventNs(void);
+void SimHw_SdmmcEvents(uint64_t now);
+void SimHw_SdmmcLines(void);
+
+/* USB1 OTG HS model. */
+bool SimHw_UsbWrite(uintptr_t addr, uint32_t value);
+void SimHw_UsbReset(void);
+uint64_t SimHw_UsbNextEventNs(void);
+void SimHw_UsbEvents(uint64_t now);
+void SimHw_UsbLines(void);
+
+/* GPIO and EXTI model. */
+bool SimHw_GpioWrite(uintptr_t addr, uint32_t value);
+void SimHw_GpioReconcile(GPIO_TypeDef *port);
+bool SimHw_ExtiWrite(uintptr_t addr, uint32_t value);
+void SimHw_GpioReset(void);
+uint64_t SimHw_GpioNextEventNs(void);
+void SimHw_GpioEvents(uint64_t now);
+bool SimHw_GpioDmaWrite(uintptr_t addr, uint8_t data);
+void SimHw_ExtiLines(void);
+
+/* RTC model. */
+bool SimHw_RtcWrite(uintptr_t addr, uint32_t value);
+bool SimHw_RtcRead(uintptr_t addr, uint32_t *value);
+void SimHw_RtcReset(void);
+uint64_t SimHw_RtcNextEventNs(void);
+void SimHw_RtcEvents(uint64_t now);
+void SimHw_RtcLines(void);
+
+#endif /* SIM_HW_MODEL_H */
@@ -0,0 +1,53 @@
+/**
+ * @file SimMain_Bench.h
+ * @brief Benches run by the control task of the host simulation.
+ *
+ * Private to the simulation sources. SimMain.c parses the options and runs
+ * the bench of every option given; each bench lives in SimMain_<Bench>.c,
+ * prints its checks and records a failed one through ::SimMain_Fail so the
+ * process exits with 1.
+ */
+
+#ifndef SIM_MAIN_BENCH_H
+#define SIM_MAIN_BENCH_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#define SIMMAIN_NS_PER_MS           (1000000ULL)
+#define SIMMAIN_CLOCK_RTC_PPB       (35000)       /**< --clock-bench RTC clock error */
+
+/* Typedefs -----------------------------------------------------------------*/
+
+/* Exported Variables -------------------------------------------------------*/
+extern uint32_t g_simMainVencChecksum; /**< Running checksum of the --venc-fps packets */
+
+/* Exported Interfaces ------------------------------------------------------*/
+/* Shared by the benches. */
+const char *SimMain_Fail(const char *verdict);
+double SimMain_WallTime(void);
+
+/* Bench entry points, called by the control task for the options given. */
+void SimMain_DmaPoolBench(void);
+void SimMain_DmaMemBench(void);
+void SimMain_Dma2dCheck(void);
+void SimMain_CrcBench(void);
+void SimMain_RngBench(void);
+void SimMain_AuthBench(void);
+void SimMain_VencBench(uint32_t fps);
+void SimMain_SpiBench(void);
+void SimMain_I2cBench(void);
+void SimMain_I3cBench(void);
+void SimMain_AdcBench(void);
+void SimMain_HrTimerBench(void);
+void SimMain_TicklessBench(void);
+void SimMain_SdBench(void);
+void SimMain_LogStoreBench(void);
+void SimMain_UsbBench(void);
+void SimMain_WaveBench(void);
+void SimMain_ExtiBench(void);
+void SimMain_ClockBench(void);
+
+#endif /* SIM_MAIN_BENCH_H */
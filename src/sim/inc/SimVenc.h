@@ -0,0 +1,40 @@
+/**
+ * @file SimVenc.h
+ * @brief Software stand-in for the VENC, used by the host build.
+ *
+ * The firmware has no VENC backend: the block is driven through ST's
+ * encoder library, which is not part of this tree, and its glue is what
+ * implements ::Venc_Backend_T on target. The simulation gives the pipeline
+ * this stand-in instead, so buffer management and encode scheduling run
+ * against completions at the rate of the hardware.
+ */
+
+#ifndef SIM_VENC_H
+#define SIM_VENC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include "Venc.h"
+
+/* Macros and Defines -------------------------------------------------------*/
+#ifndef SIMVENC_PIXELS_PER_MS
+#define SIMVENC_PIXELS_PER_MS (60000U) /**< Encode rate modelled by the stand-in, about 1080p30 */
+#endif
+
+#ifndef SIMVENC_TASK_STACK_SIZE
+#define SIMVENC_TASK_STACK_SIZE (256U) /**< Stand-in encoder task stack in words */
+#endif
+
+/* Exported Interfaces ------------------------------------------------------*/
+/**
+ * @brief Software stand-in for the VENC.
+ *
+ * Emits packets with the framing of the configured codec around a
+ * run-length code of the quantised luma, so packet sizes follow the image
+ * content, and completes after the time the VENC would take at
+ * ::SIMVENC_PIXELS_PER_MS. The packets are not decodable video.
+ *
+ * @return Backend to give to ::Venc_Init.
+ */
+const Venc_Backend_T *SimVenc_Backend(void);
+
+#endif /* SIM_VENC_H */
@@ -0,0 +1,17 @@
+/**
+ * @file cmsis_compiler.h
+ * @brief Host wrapper around the CMSIS compiler abstraction.
+ *
+ * The ARM `cmsis_compiler.h` includes `cmsis_gcc.h` from its own directory,
+ * which would bypass the host intrinsics. Pulling in the simulation
+ * `cmsis_gcc.h` first sets its include guard so the ARM copy is skipped.
+ */
+
+#ifndef SIM_CMSIS_COMPILER_H
+#define SIM_CMSIS_COMPILER_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cmsis_gcc.h>
+#include_next <cmsis_compiler.h>
+
+#endif /* SIM_CMSIS_COMPILER_H */
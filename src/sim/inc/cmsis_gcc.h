@@ -0,0 +1,175 @@
+/**
+ * @file cmsis_gcc.h
+ * @brief Host replacement for the CMSIS GCC intrinsics.
+ *
+ * Shadows `libs/CMSIS/Include/cmsis_gcc.h` in the simulation build. The
+ * ARM header is still included for its attribute and helper macros, but
+ * every intrinsic the firmware executes is renamed out of the way first
+ * and re-implemented on top of the register model:
+ *  - barriers are synchronisation points where pending register writes
+ *    are applied and pending interrupts may be taken,
+ *  - PRIMASK/BASEPRI/IPSR are the simulated core state,
+ *  - LDREX/STREX use a single exclusive monitor cleared on exception entry.
+ */
+
+#ifndef SIM_CMSIS_GCC_H
+#define SIM_CMSIS_GCC_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+/* Move the ARM implementations to unused names. */
+#define __ISB            __cmsis_arm_ISB
+#define __DSB            __cmsis_arm_DSB
+#define __DMB            __cmsis_arm_DMB
+#define __REV            __cmsis_arm_REV
+#define __REV16          __cmsis_arm_REV16
+#define __REVSH          __cmsis_arm_REVSH
+#define __ROR            __cmsis_arm_ROR
+#define __RBIT           __cmsis_arm_RBIT
+#define __CLZ            __cmsis_arm_CLZ
+#define __enable_irq     __cmsis_arm_enable_irq
+#define __disable_irq    __cmsis_arm_disable_irq
+#define __get_CONTROL    __cmsis_arm_get_CONTROL
+#define __set_CONTROL    __cmsis_arm_set_CONTROL
+#define __get_IPSR       __cmsis_arm_get_IPSR
+#define __get_APSR       __cmsis_arm_get_APSR
+#define __get_xPSR       __cmsis_arm_get_xPSR
+#define __get_PSP        __cmsis_arm_get_PSP
+#define __set_PSP        __cmsis_arm_set_PSP
+#define __get_MSP        __cmsis_arm_get_MSP
+#define __set_MSP        __cmsis_arm_set_MSP
+#define __get_PRIMASK    __cmsis_arm_get_PRIMASK
+#define __set_PRIMASK    __cmsis_arm_set_PRIMASK
+#define __get_FPSCR      __cmsis_arm_get_FPSCR
+#define __set_FPSCR      __cmsis_arm_set_FPSCR
+#define __cmsis_start    __cmsis_arm_start
+
+#include_next <cmsis_gcc.h>
+
+#undef __ISB
+#undef __DSB
+#undef __DMB
+#undef __REV
+#undef __REV16
+#undef __REVSH
+#undef __ROR
+#undef __RBIT
+#undef __CLZ
+#undef __enable_irq
+#undef __disable_irq
+#undef __get_CONTROL
+#undef __set_CONTROL
+#undef __get_IPSR
+#undef __get_APSR
+#undef __get_xPSR
+#undef __get_PSP
+#undef __set_PSP
+#undef __get_MSP
+#undef __set_MSP
+#undef __get_PRIMASK
+#undef __set_PRIMASK
+#undef __get_FPSCR
+#undef __set_FPSCR
+#undef __cmsis_start
+#undef __NOP
+#undef __WFI
+#undef __WFE
+#undef __SEV
+#undef __BKPT
+#undef __COMPILER_BARRIER
+
+/* Core state kept by the register model, see SimHw.c. */
+extern void SimHw_Sync(void);
+extern void SimHw_Idle(void);
+extern uint32_t SimHw_GetIpsr(void);
+extern uint32_t SimHw_GetPriMask(void);
+extern void SimHw_SetPriMask(uint32_t priMask);
+extern uint32_t SimHw_GetBasePri(void);
+extern void SimHw_SetBasePri(uint32_t basePri);
+extern uint32_t SimHw_LoadExclusive(volatile void *addr, uint32_t size);
+extern uint32_t SimHw_StoreExclusive(volatile void *addr, uint32_t size, uint32_t value);
+extern void SimHw_ClearExclusive(void);
+
+#define __COMPILER_BARRIER() SimHw_Sync()
+#define __NOP()              __ASM volatile("nop")
+#define __WFI()              SimHw_Idle()
+#define __WFE()              SimHw_Idle()
+#define __SEV()              ((void)0)
+#define __BKPT(value)        __builtin_trap()
+
+/* Exported Interfaces ------------------------------------------------------*/
+__STATIC_FORCEINLINE void __ISB(void) { SimHw_Sync(); }
+__STATIC_FORCEINLINE void __DSB(void) { SimHw_Sync(); }
+__STATIC_FORCEINLINE void __DMB(void) { SimHw_Sync(); }
+
+__STATIC_FORCEINLINE uint32_t __REV(uint32_t value) { return __builtin_bswap32(value); }
+__STATIC_FORCEINLINE uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);
+}
+__STATIC_FORCEINLINE int16_t __REVSH(int16_t value) { return (int16_t)__builtin_bswap16((uint16_t)value); }
+__STATIC_FORCEINLINE uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+    op2 %= 32U;
+    return (op2 == 0U) ? op1 : ((op1 >> op2) | (op1 << (32U - op2)));
+}
+__STATIC_FORCEINLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0U;
+    for (uint32_t i = 0U; i < 32U; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+    return result;
+}
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_FORCEINLINE uint8_t __LDREXB(volatile uint8_t *addr) { return (uint8_t)SimHw_LoadExclusive(addr, 1U); }
+__STATIC_FORCEINLINE uint16_t __LDREXH(volatile uint16_t *addr) { return (uint16_t)SimHw_LoadExclusive(addr, 2U); }
+__STATIC_FORCEINLINE uint32_t __LDREXW(volatile uint32_t *addr) { return SimHw_LoadExclusive(addr, 4U); }
+__STATIC_FORCEINLINE uint32_t __STREXB(uint8_t value, volatile uint8_t *addr)
+{
+    return SimHw_StoreExclusive(addr, 1U, value);
+}
+__STATIC_FORCEINLINE uint32_t __STREXH(uint16_t value, volatile uint16_t *addr)
+{
+    return SimHw_StoreExclusive(addr, 2U, value);
+}
+__STATIC_FORCEINLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    return SimHw_StoreExclusive(addr, 4U, value);
+}
+__STATIC_FORCEINLINE void __CLREX(void) { SimHw_ClearExclusive(); }
+
+__STATIC_FORCEINLINE void __enable_irq(void) { SimHw_SetPriMask(0U); }
+__STATIC_FORCEINLINE void __disable_irq(void) { SimHw_SetPriMask(1U); }
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void) { return SimHw_GetPriMask(); }
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask) { SimHw_SetPriMask(priMask); }
+__STATIC_FORCEINLINE uint32_t __get_BASEPRI(void) { return SimHw_GetBasePri(); }
+__STATIC_FORCEINLINE void __set_BASEPRI(uint32_t basePri) { SimHw_SetBasePri(basePri); }
+__STATIC_FORCEINLINE void __set_BASEPRI_MAX(uint32_t basePri)
+{
+    uint32_t current = SimHw_GetBasePri();
+    if ((basePri != 0U) && ((current == 0U) || (basePri < current)))
+    {
+        SimHw_SetBasePri(basePri);
+    }
+}
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void) { return SimHw_GetIpsr(); }
+__STATIC_FORCEINLINE uint32_t __get_xPSR(void) { return SimHw_GetIpsr(); }
+__STATIC_FORCEINLINE uint32_t __get_APSR(void) { return 0U; }
+__STATIC_FORCEINLINE uint32_t __get_CONTROL(void) { return 0U; }
+__STATIC_FORCEINLINE void __set_CONTROL(uint32_t control) { (void)control; }
+__STATIC_FORCEINLINE uint32_t __get_PSP(void) { return 0U; }
+__STATIC_FORCEINLINE void __set_PSP(uint32_t topOfProcStack) { (void)topOfProcStack; }
+__STATIC_FORCEINLINE uint32_t __get_MSP(void) { return 0U; }
+__STATIC_FORCEINLINE void __set_MSP(uint32_t topOfMainStack) { (void)topOfMainStack; }
+__STATIC_FORCEINLINE uint32_t __get_FPSCR(void) { return 0U; }
+__STATIC_FORCEINLINE void __set_FPSCR(uint32_t fpscr) { (void)fpscr; }
+
+#endif /* SIM_CMSIS_GCC_H */
@@ -0,0 +1,38 @@
+/**
+ * @file core_cm55.h
+ * @brief Host wrapper around the Cortex-M55 core peripheral header.
+ *
+ * Makes sure the host intrinsics from the simulation `cmsis_gcc.h` are
+ * seen before the core header pulls in its own compiler abstraction. The
+ * core peripherals themselves (SCB, NVIC, SysTick, DWT, MPU) stay at
+ * their architectural addresses, which the register model maps.
+ *
+ * Data cache maintenance by address is routed to the model, which applies
+ * it to its write-back lines and charges drivers for it per line, the cost
+ * that buffers from the non-cacheable DMA pool avoid. Set/way maintenance
+ * of the whole cache is left to the CMSIS functions and not modelled.
+ */
+
+#ifndef SIM_CORE_CM55_H
+#define SIM_CORE_CM55_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cmsis_gcc.h>
+#include_next <core_cm55.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#undef SCB_CleanDCache_by_Addr
+#undef SCB_InvalidateDCache_by_Addr
+#undef SCB_CleanInvalidateDCache_by_Addr
+#define SIMHW_DCACHE_CLEAN      (1U) /**< Write dirty lines back to memory */
+#define SIMHW_DCACHE_INVALIDATE (2U) /**< Drop lines, the CPU reads memory again */
+#define SCB_CleanDCache_by_Addr(addr, dsize)      SimHw_DCacheByAddr((addr), (dsize), SIMHW_DCACHE_CLEAN)
+#define SCB_InvalidateDCache_by_Addr(addr, dsize) SimHw_DCacheByAddr((addr), (dsize), SIMHW_DCACHE_INVALIDATE)
+#define SCB_CleanInvalidateDCache_by_Addr(addr, dsize) \
+    SimHw_DCacheByAddr((addr), (dsize), SIMHW_DCACHE_CLEAN | SIMHW_DCACHE_INVALIDATE)
+
+/* Exported Interfaces ------------------------------------------------------*/
+/** @brief Defined in SimHw_DCache.c, see SimHw.h. */
+void SimHw_DCacheByAddr(volatile void *addr, int32_t dsize, uint32_t op);
+
+#endif /* SIM_CORE_CM55_H */
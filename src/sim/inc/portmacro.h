@@ -0,0 +1,84 @@
+/**
+ * @file portmacro.h
+ * @brief FreeRTOS port definitions for the host simulation.
+ *
+ * Replaces the Cortex-M55 `portmacro.h` so the unmodified kernel sources
+ * build on a 64-bit host. Tasks run as user-space contexts on a single host
+ * thread; yields pend the simulated PendSV exception exactly like the ARM
+ * port, and the critical section nesting masks interrupts through the
+ * simulated BASEPRI. See SimPort.c.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+#define portARCH_NAME     "Host-Sim"
+#define portCHAR          char
+#define portFLOAT         float
+#define portDOUBLE        double
+#define portLONG          long
+#define portSHORT         short
+#define portSTACK_TYPE    uint32_t
+#define portBASE_TYPE     long
+#define portPOINTER_SIZE_TYPE uintptr_t
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#if (configUSE_16_BIT_TICKS == 1)
+typedef uint16_t TickType_t;
+#define portMAX_DELAY (TickType_t)0xffff
+#else
+typedef uint32_t TickType_t;
+#define portMAX_DELAY (TickType_t)0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC 1
+#endif
+
+#define portSTACK_GROWTH      (-1)
+#define portTICK_PERIOD_MS    ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT    8
+#define portNOP()
+#define portINLINE            __inline
+#define portFORCE_INLINE      inline __attribute__((always_inline))
+#define portDONT_DISCARD      __attribute__((used))
+#define portMEMORY_BARRIER()  __asm volatile("" ::: "memory")
+
+/* Exported Interfaces ------------------------------------------------------*/
+extern BaseType_t xPortIsInsideInterrupt(void);
+extern void vPortYield(void);
+extern void vPortEnterCritical(void);
+extern void vPortExitCritical(void);
+extern uint32_t ulSetInterruptMask(void);
+extern void vClearInterruptMask(uint32_t ulMask);
+extern void vPortCleanUpTCB(void *tcb);
+extern void SimPort_SetCriticalCost(uint32_t ns);
+
+#define portYIELD()                              vPortYield()
+#define portEND_SWITCHING_ISR(xSwitchRequired) \
+    do                                         \
+    {                                          \
+        if ((xSwitchRequired) != pdFALSE)      \
+        {                                      \
+            vPortYield();                      \
+        }                                      \
+    } while (0)
+#define portYIELD_FROM_ISR(x)                    portEND_SWITCHING_ISR(x)
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()        ulSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)     vClearInterruptMask(x)
+#define portDISABLE_INTERRUPTS()                 ulSetInterruptMask()
+#define portENABLE_INTERRUPTS()                  vClearInterruptMask(0)
+#define portENTER_CRITICAL()                     vPortEnterCritical()
+#define portEXIT_CRITICAL()                      vPortExitCritical()
+
+#define portCLEAN_UP_TCB(pxTCB)                  vPortCleanUpTCB(pxTCB)
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters) void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)       void vFunction(void *pvParameters)
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,43 @@
+/**
+ * @file stm32n6xx.h
+ * @brief Host wrapper around the STM32N6xx device header.
+ *
+ * Includes the real device header and re-routes the register access macros
+ * used by the LL drivers through the register model. Writes land in the
+ * memory window mapped at the peripheral's silicon address and the owning
+ * model reacts straight away, which keeps write-1-to-clear registers and
+ * back-to-back data register writes exact. Direct `->REG =` stores in
+ * driver code are still seen, but only at the next synchronisation point.
+ */
+
+#ifndef SIM_STM32N6XX_H
+#define SIM_STM32N6XX_H
+
+/* Includes -----------------------------------------------------------------*/
+#include <cmsis_gcc.h>
+#include_next <stm32n6xx.h>
+
+#include <stddef.h>
+
+/* Macros and Defines -------------------------------------------------------*/
+extern void SimHw_WriteReg(volatile void *reg, size_t width, uint32_t value);
+extern uint32_t SimHw_ReadReg(const volatile void *reg, size_t width);
+
+#undef SET_BIT
+#undef CLEAR_BIT
+#undef READ_BIT
+#undef CLEAR_REG
+#undef WRITE_REG
+#undef READ_REG
+#undef MODIFY_REG
+
+#define READ_REG(REG)       SimHw_ReadReg(&(REG), sizeof(REG))
+#define WRITE_REG(REG, VAL) SimHw_WriteReg(&(REG), sizeof(REG), (uint32_t)(VAL))
+#define SET_BIT(REG, BIT)   WRITE_REG((REG), READ_REG(REG) | (uint32_t)(BIT))
+#define CLEAR_BIT(REG, BIT) WRITE_REG((REG), READ_REG(REG) & ~(uint32_t)(BIT))
+#define READ_BIT(REG, BIT)  (READ_REG(REG) & (uint32_t)(BIT))
+#define CLEAR_REG(REG)      WRITE_REG((REG), 0U)
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) \
+    WRITE_REG((REG), (READ_REG(REG) & ~(uint32_t)(CLEARMASK)) | (uint32_t)(SETMASK))
+
+#endif /* SIM_STM32N6XX_H */
@@ -0,0 +1,1130 @@
+/**
+ * @file SimHw.c
+ * @brief Core of the register-level model: register windows, virtual time, NVIC, SysTick, the DWT cycle counter and the RCC oscillators.
+ * @ingroup SimHw
+ * @{
+ *
+ * The peripheral models live in SimHw_<Peripheral>.c and are driven through
+ * the hooks of SimHw_Model.h. Every model keeps its state in a struct and
+ * publishes it into the mapped register window, so firmware reads see the
+ * same flags as on silicon.
+ * Register writes reach a model in two ways:
+ *  - through the LL access macros, which call ::SimHw_WriteReg and let the
+ *    owning model react immediately,
+ *  - through plain stores, which the model picks up at the next
+ *    synchronisation point by comparing the window against its shadow.
+ *    Only the core peripherals, USART1 and DMA channels already accessed
+ *    through the macros are watched, which keeps synchronisation cheap.
+ *
+ * Write-only semantics are rebuilt on top of plain memory: W1C registers
+ * (CFCR, ICR, NVIC ICER/ICPR) are reset to zero once applied and the USART
+ * data register holds a value no 9-bit write can produce while empty.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_EXC_COUNT        (16U + SIMHW_IRQ_COUNT) /**< Exception numbers modelled */
+#define SIMHW_EXC_WORDS        ((SIMHW_EXC_COUNT + 31U) / 32U)
+#define SIMHW_NVIC_WORDS       (SIMHW_IRQ_COUNT / 32U)
+#define SIMHW_THREAD_PRIO      (0x100U) /**< Execution priority of thread mode */
+#define SIMHW_PRIO_MASK        ((0xFFU << (8U - __NVIC_PRIO_BITS)) & 0xFFU)
+#define SIMHW_EXC_PENDSV       (14U)
+#define SIMHW_EXC_SYSTICK      (15U)
+/** RCC oscillators whose CSR enable raises the ready flag at the same position of SR */
+#define SIMHW_RCC_OSC          (RCC_SR_LSIRDY | RCC_SR_LSERDY | RCC_SR_MSIRDY | RCC_SR_HSIRDY | RCC_SR_HSERDY)
+#define SIMHW_MEMORY_REGIONS   (32U)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the SysTick timer.
+ */
+typedef struct
+{
+    bool enabled;      /**< CTRL.ENABLE seen */
+    uint32_t load;     /**< Reload value the period was computed from */
+    uint64_t periodNs; /**< Wrap period */
+    uint64_t nextNs;   /**< Next wrap */
+} SimHw_SysTick_T;
+
+/**
+ * @brief Host memory range reachable by the DMA model.
+ */
+typedef struct
+{
+    uintptr_t base;
+    size_t size;
+} SimHw_Region_T;
+
+/* Global Variables ---------------------------------------------------------*/
+extern char __executable_start[]; /**< Start of the image, provided by the host linker */
+extern char _end[];               /**< End of the image, provided by the host linker */
+extern void *__real_memcpy(void *dst, const void *src, size_t size); /**< libc memcpy behind the wrap */
+extern void *__real_memset(void *dst, int value, size_t size);       /**< libc memset behind the wrap */
+void *__wrap_memcpy(void *dst, const void *src, size_t size);
+void *__wrap_memset(void *dst, int value, size_t size);
+
+/* Handlers the model can raise, resolved weakly so unused ones may be absent. */
+#define SIMHW_HANDLERS(X)                                                           \
+    X(SVCall_IRQn, SVC_Handler)                                                     \
+    X(PendSV_IRQn, PendSV_Handler)                                                  \
+    X(SysTick_IRQn, SysTick_Handler)                                                \
+    X(HPDMA1_Channel0_IRQn, HPDMA1_Channel0_IRQHandler)                             \
+    X(HPDMA1_Channel1_IRQn, HPDMA1_Channel1_IRQHandler)                             \
+    X(HPDMA1_Channel2_IRQn, HPDMA1_Channel2_IRQHandler)                             \
+    X(HPDMA1_Channel3_IRQn, HPDMA1_Channel3_IRQHandler)                             \
+    X(HPDMA1_Channel4_IRQn, HPDMA1_Channel4_IRQHandler)                             \
+    X(HPDMA1_Channel5_IRQn, HPDMA1_Channel5_IRQHandler)                             \
+    X(HPDMA1_Channel6_IRQn, HPDMA1_Channel6_IRQHandler)                             \
+    X(HPDMA1_Channel7_IRQn, HPDMA1_Channel7_IRQHandler)                             \
+    X(HPDMA1_Channel8_IRQn, HPDMA1_Channel8_IRQHandler)                             \
+    X(HPDMA1_Channel9_IRQn, HPDMA1_Channel9_IRQHandler)                             \
+    X(HPDMA1_Channel10_IRQn, HPDMA1_Channel10_IRQHandler)                           \
+    X(HPDMA1_Channel11_IRQn, HPDMA1_Channel11_IRQHandler)                           \
+    X(HPDMA1_Channel12_IRQn, HPDMA1_Channel12_IRQHandler)                           \
+    X(HPDMA1_Channel13_IRQn, HPDMA1_Channel13_IRQHandler)                           \
+    X(HPDMA1_Channel14_IRQn, HPDMA1_Channel14_IRQHandler)                           \
+    X(HPDMA1_Channel15_IRQn, HPDMA1_Channel15_IRQHandler)                           \
+    X(GPDMA1_Channel0_IRQn, GPDMA1_Channel0_IRQHandler)                             \
+    X(GPDMA1_Channel1_IRQn, GPDMA1_Channel1_IRQHandler)                             \
+    X(GPDMA1_Channel2_IRQn, GPDMA1_Channel2_IRQHandler)                             \
+    X(GPDMA1_Channel3_IRQn, GPDMA1_Channel3_IRQHandler)                             \
+    X(GPDMA1_Channel4_IRQn, GPDMA1_Channel4_IRQHandler)                             \
+    X(GPDMA1_Channel5_IRQn, GPDMA1_Channel5_IRQHandler)                             \
+    X(GPDMA1_Channel6_IRQn, GPDMA1_Channel6_IRQHandler)                             \
+    X(GPDMA1_Channel7_IRQn, GPDMA1_Channel7_IRQHandler)                             \
+    X(GPDMA1_Channel8_IRQn, GPDMA1_Channel8_IRQHandler)                             \
+    X(GPDMA1_Channel9_IRQn, GPDMA1_Channel9_IRQHandler)                             \
+    X(GPDMA1_Channel10_IRQn, GPDMA1_Channel10_IRQHandler)                           \
+    X(GPDMA1_Channel11_IRQn, GPDMA1_Channel11_IRQHandler)                           \
+    X(GPDMA1_Channel12_IRQn, GPDMA1_Channel12_IRQHandler)                           \
+    X(GPDMA1_Channel13_IRQn, GPDMA1_Channel13_IRQHandler)                           \
+    X(GPDMA1_Channel14_IRQn, GPDMA1_Channel14_IRQHandler)                           \
+    X(GPDMA1_Channel15_IRQn, GPDMA1_Channel15_IRQHandler)                           \
+    X(USART1_IRQn, USART1_IRQHandler)
+
+#define SIMHW_DECLARE_HANDLER(irq, name) extern void name(void) __attribute__((weak));
+SIMHW_HANDLERS(SIMHW_DECLARE_HANDLER)
+
+#define SIMHW_VECTOR_ENTRY(irq, name) g_pfnVectors[16 + (int32_t)(irq)] = (uint32_t)(uintptr_t)name;
+/** Startup vector table, the host counterpart of the one in startup_stm32n657x0hxq.s. */
+uint32_t g_pfnVectors[SIMHW_EXC_COUNT];
+
+SimHw_Config_T g_simHwConfig;
+SimHw_Stats_T g_simHwStats;
+bool g_simHwReady = false;          /**< Windows mapped and models reset */
+static bool g_simHwStopped = false; /**< Stop time reached, no more events */
+bool g_simHwInModel = false;        /**< Model code is running, hooks pass through */
+static bool g_simHwInCharge = false;
+static uint64_t g_simHwPendingNs = 0U;
+static uint64_t g_simHwStopNs = SIMHW_NO_EVENT;
+static SimHw_StopHook_T g_simHwStopHook = NULL;
+
+/* Core state */
+static uint32_t g_simHwPriMask = 0U;
+static uint32_t g_simHwBasePri = 0U;
+static uint32_t g_simHwIpsr = 0U;
+static uint32_t g_simHwExecPrio = SIMHW_THREAD_PRIO;
+static uint32_t g_simHwPending[SIMHW_EXC_WORDS];
+static uint32_t g_simHwActive[SIMHW_EXC_WORDS];
+static uint32_t g_simHwNvicEnabled[SIMHW_NVIC_WORDS];
+static uint32_t g_simHwIserShadow[SIMHW_NVIC_WORDS];
+static uint32_t g_simHwIsprShadow[SIMHW_NVIC_WORDS];
+static volatile void *g_simHwExclusive = NULL;
+static uint64_t g_simHwCycleBase = 0U;
+static uint32_t g_simHwCycleLast = 0U;
+
+static SimHw_SysTick_T g_simHwSysTick;
+static SimHw_Region_T g_simHwRegions[SIMHW_MEMORY_REGIONS];
+static uint32_t g_simHwRegionCount = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_Reset(void);
+static void SimHw_RunUntil(uint64_t target);
+static void SimHw_SetTime(uint64_t now);
+static uint64_t SimHw_NextEventNs(void);
+static void SimHw_ProcessEvents(void);
+static void SimHw_ReconcileAll(void);
+static void SimHw_CoreReconcile(void);
+static void SimHw_UpdateLines(void);
+static void SimHw_Dispatch(void);
+static bool SimHw_SelectException(uint32_t *exc);
+static void SimHw_TakeException(uint32_t exc);
+static uint32_t SimHw_GetPriority(uint32_t exc);
+static void (*SimHw_GetHandler(uint32_t exc))(void);
+static bool SimHw_IsBitSet(const uint32_t *bitmap, uint32_t bit);
+static void SimHw_UpdateCycleCounter(void);
+static void SimHw_OwnerReconcile(uintptr_t addr);
+static void SimHw_ChargeCopy(size_t size);
+static void SimHw_RccReconcile(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Map the register windows and reset the models.
+ *
+ * The windows are private anonymous mappings, so every register starts at
+ * zero before the models publish their reset values.
+ */
+bool SimHw_Init(const SimHw_Config_T *config)
+{
+    void *periph = mmap((void *)SIMHW_PERIPH_BASE, SIMHW_PERIPH_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0);
+    if (periph != (void *)SIMHW_PERIPH_BASE)
+    {
+        return false;
+    }
+
+    void *scs = mmap((void *)SIMHW_SCS_BASE, SIMHW_SCS_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0);
+    if (scs != (void *)SIMHW_SCS_BASE)
+    {
+        munmap(periph, SIMHW_PERIPH_SIZE);
+        return false;
+    }
+
+    memset(&g_simHwConfig, 0, sizeof(g_simHwConfig));
+    if (config != NULL)
+    {
+        g_simHwConfig = *config;
+    }
+    if (g_simHwConfig.m2m_bytes_per_us == 0U)
+    {
+        g_simHwConfig.m2m_bytes_per_us = SIMHW_DEFAULT_M2M_BYTES_PER_US;
+    }
+    if (g_simHwConfig.cpu_copy_bytes_per_us == 0U)
+    {
+        g_simHwConfig.cpu_copy_bytes_per_us = SIMHW_DEFAULT_CPU_COPY_BYTES_PER_US;
+    }
+    if (g_simHwConfig.dcache_line_ns == 0U)
+    {
+        g_simHwConfig.dcache_line_ns = SIMHW_DEFAULT_DCACHE_LINE_NS;
+    }
+    if (g_simHwConfig.dma2d_pixels_per_us == 0U)
+    {
+        g_simHwConfig.dma2d_pixels_per_us = SIMHW_DEFAULT_DMA2D_PIXELS_PER_US;
+    }
+    if (g_simHwConfig.rng_word_ns == 0U)
+    {
+        g_simHwConfig.rng_word_ns = SIMHW_DEFAULT_RNG_WORD_NS;
+    }
+    if (g_simHwConfig.pka_word_mul_ns == 0U)
+    {
+        g_simHwConfig.pka_word_mul_ns = SIMHW_DEFAULT_PKA_WORD_MUL_NS;
+    }
+    if ((g_simHwConfig.sd_blocks < 1024U) || ((g_simHwConfig.sd_blocks % 1024U) != 0U))
+    {
+        g_simHwConfig.sd_blocks = SIMHW_DEFAULT_SD_BLOCKS;
+    }
+    uint32_t norBytes = g_simHwConfig.nor_bytes;
+    if ((norBytes < (64U * 1024U)) || (norBytes > (16U * 1024U * 1024U)) || ((norBytes & (norBytes - 1U)) != 0U))
+    {
+        g_simHwConfig.nor_bytes = SIMHW_DEFAULT_NOR_BYTES;
+    }
+
+    SimHw_Reset();
+    g_simHwReady = true;
+    return true;
+}
+
+/**
+ * @brief Arm the stop time.
+ */
+void SimHw_SetStopTime(uint64_t stopNs, SimHw_StopHook_T hook)
+{
+    g_simHwStopNs = stopNs;
+    g_simHwStopHook = hook;
+}
+
+/**
+ * @brief Add a host memory range to the DMA-reachable set.
+ */
+void SimHw_RegisterMemory(const void *base, size_t size)
+{
+    if (g_simHwRegionCount < SIMHW_MEMORY_REGIONS)
+    {
+        g_simHwRegions[g_simHwRegionCount].base = (uintptr_t)base;
+        g_simHwRegions[g_simHwRegionCount].size = size;
+        g_simHwRegionCount++;
+    }
+}
+
+/**
+ * @brief Synchronisation point.
+ *
+ * Folds plain register stores into the models, refreshes the interrupt
+ * lines and takes every pending exception the current masking allows.
+ */
+void SimHw_Sync(void)
+{
+    if (!g_simHwReady || g_simHwInModel || g_simHwStopped)
+    {
+        return;
+    }
+
+    SimHw_ReconcileAll();
+    SimHw_Dispatch();
+}
+
+/**
+ * @brief Charge CPU time.
+ *
+ * Hardware events falling inside the charged interval are processed in
+ * order, but their interrupts are only taken at the next synchronisation
+ * point. Charges made while events are being processed are folded into the
+ * outer call.
+ */
+void SimHw_Charge(uint64_t ns)
+{
+    if (!g_simHwReady || g_simHwStopped)
+    {
+        return;
+    }
+
+    g_simHwPendingNs += ns;
+    if (g_simHwInCharge)
+    {
+        return;
+    }
+
+    g_simHwInCharge = true;
+    while (g_simHwPendingNs != 0U)
+    {
+        uint64_t target = g_simHwStats.now_ns + g_simHwPendingNs;
+        g_simHwPendingNs = 0U;
+        SimHw_RunUntil(target);
+    }
+    g_simHwInCharge = false;
+}
+
+/**
+ * @brief memcpy of the firmware, charged at the CPU copy throughput.
+ *
+ * Bound with `-Wl,--wrap=memcpy`, so copies made by the models themselves
+ * are excluded by the in-model guard.
+ */
+void *__wrap_memcpy(void *dst, const void *src, size_t size)
+{
+    SimHw_ChargeCopy(size);
+    return __real_memcpy(dst, src, size);
+}
+
+/**
+ * @brief memset of the firmware, charged at the CPU copy throughput.
+ */
+void *__wrap_memset(void *dst, int value, size_t size)
+{
+    SimHw_ChargeCopy(size);
+    return __real_memset(dst, value, size);
+}
+
+/**
+ * @brief Charge CPU time and synchronise.
+ */
+void SimHw_Advance(uint64_t ns)
+{
+    SimHw_Charge(ns);
+    SimHw_Sync();
+}
+
+/**
+ * @brief Wait for interrupt.
+ *
+ * Jumps to the next scheduled hardware event and takes the interrupts it
+ * raises. With nothing scheduled time moves to the stop time.
+ */
+void SimHw_Idle(void)
+{
+    SimHw_Sync();
+    if (!g_simHwReady || g_simHwStopped)
+    {
+        return;
+    }
+
+    uint64_t next = SimHw_NextEventNs();
+    if (next == SIMHW_NO_EVENT)
+    {
+        next = g_simHwStopNs;
+    }
+    if (next == SIMHW_NO_EVENT)
+    {
+        fprintf(stderr, "SimHw: idle with no pending event and no stop time\n");
+        abort();
+    }
+
+    if (next > g_simHwStats.now_ns)
+    {
+        g_simHwStats.idle_ns += next - g_simHwStats.now_ns;
+        SimHw_Charge(next - g_simHwStats.now_ns);
+    }
+    SimHw_Sync();
+}
+
+/**
+ * @brief Return to thread mode with no active exception.
+ */
+void SimHw_EnterThreadMode(void)
+{
+    g_simHwIpsr = 0U;
+    g_simHwExecPrio = SIMHW_THREAD_PRIO;
+    g_simHwBasePri = 0U;
+    g_simHwPriMask = 0U;
+    memset(g_simHwActive, 0, sizeof(g_simHwActive));
+}
+
+/**
+ * @brief Current virtual time.
+ */
+uint64_t SimHw_GetTimeNs(void)
+{
+    return g_simHwStats.now_ns;
+}
+
+/**
+ * @brief Copy the counters.
+ */
+void SimHw_GetStats(SimHw_Stats_T *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = g_simHwStats;
+    }
+}
+
+/** @brief Current exception number, 0 in thread mode. */
+uint32_t SimHw_GetIpsr(void)
+{
+    return g_simHwIpsr;
+}
+
+/** @brief Current PRIMASK. */
+uint32_t SimHw_GetPriMask(void)
+{
+    return g_simHwPriMask;
+}
+
+/**
+ * @brief Set PRIMASK, clearing it is a synchronisation point.
+ */
+void SimHw_SetPriMask(uint32_t priMask)
+{
+    g_simHwPriMask = priMask & 1U;
+    if (g_simHwPriMask == 0U)
+    {
+        SimHw_Sync();
+    }
+}
+
+/** @brief Current BASEPRI. */
+uint32_t SimHw_GetBasePri(void)
+{
+    return g_simHwBasePri;
+}
+
+/**
+ * @brief Set BASEPRI, lowering it is a synchronisation point.
+ */
+void SimHw_SetBasePri(uint32_t basePri)
+{
+    uint32_t previous = g_simHwBasePri;
+    g_simHwBasePri = basePri & SIMHW_PRIO_MASK;
+    if ((g_simHwBasePri == 0U) || ((previous != 0U) && (g_simHwBasePri > previous)))
+    {
+        SimHw_Sync();
+    }
+}
+
+/**
+ * @brief LDREX: read and mark @p addr for exclusive access.
+ */
+uint32_t SimHw_LoadExclusive(volatile void *addr, uint32_t size)
+{
+    g_simHwExclusive = addr;
+    switch (size)
+    {
+    case 1U:
+        return *(volatile uint8_t *)addr;
+    case 2U:
+        return *(volatile uint16_t *)addr;
+    default:
+        return *(volatile uint32_t *)addr;
+    }
+}
+
+/**
+ * @brief STREX: store if the monitor still holds @p addr.
+ *
+ * @retval 0 Store performed.
+ * @retval 1 Monitor lost, nothing written.
+ */
+uint32_t SimHw_StoreExclusive(volatile void *addr, uint32_t size, uint32_t value)
+{
+    if (g_simHwExclusive != addr)
+    {
+        return 1U;
+    }
+
+    g_simHwExclusive = NULL;
+    switch (size)
+    {
+    case 1U:
+        *(volatile uint8_t *)addr = (uint8_t)value;
+        break;
+    case 2U:
+        *(volatile uint16_t *)addr = (uint16_t)value;
+        break;
+    default:
+        *(volatile uint32_t *)addr = value;
+        break;
+    }
+    SimHw_OwnerReconcile((uintptr_t)addr);
+    return 0U;
+}
+
+/** @brief CLREX. */
+void SimHw_ClearExclusive(void)
+{
+    g_simHwExclusive = NULL;
+}
+
+/**
+ * @brief Register write through the LL access macros.
+ */
+void SimHw_WriteReg(volatile void *reg, size_t width, uint32_t value)
+{
+    if (g_simHwReady && !g_simHwInModel &&
+        (SimHw_CrcWrite((uintptr_t)reg, width, value) || SimHw_I3cWrite((uintptr_t)reg, value) ||
+         SimHw_AdcWrite((uintptr_t)reg, value) || SimHw_SdmmcWrite((uintptr_t)reg, value) ||
+         SimHw_UsbWrite((uintptr_t)reg, value) || SimHw_GpioWrite((uintptr_t)reg, value) ||
+         SimHw_ExtiWrite((uintptr_t)reg, value) || SimHw_RtcWrite((uintptr_t)reg, value)))
+    {
+        SimHw_Charge(g_simHwConfig.reg_access_ns);
+        return;
+    }
+
+    switch (width)
+    {
+    case 1U:
+        *(volatile uint8_t *)reg = (uint8_t)value;
+        break;
+    case 2U:
+        *(volatile uint16_t *)reg = (uint16_t)value;
+        break;
+    default:
+        *(volatile uint32_t *)reg = value;
+        break;
+    }
+
+    if (!g_simHwInModel)
+    {
+        SimHw_OwnerReconcile((uintptr_t)reg);
+        SimHw_Charge(g_simHwConfig.reg_access_ns);
+    }
+}
+
+/**
+ * @brief Register read through the LL access macros.
+ *
+ * Charging the access lets polling loops observe time passing.
+ */
+uint32_t SimHw_ReadReg(const volatile void *reg, size_t width)
+{
+    uint32_t value;
+    if (g_simHwReady && !g_simHwInModel &&
+        (SimHw_RngRead((uintptr_t)reg, &value) || SimHw_I3cRead((uintptr_t)reg, &value) ||
+         SimHw_AdcRead((uintptr_t)reg, &value) || SimHw_TimRead((uintptr_t)reg, &value) ||
+         SimHw_LptimRead((uintptr_t)reg, &value) || SimHw_RtcRead((uintptr_t)reg, &value)))
+    {
+        SimHw_Charge(g_simHwConfig.reg_access_ns);
+        return value;
+    }
+
+    if (!g_simHwInModel)
+    {
+        SimHw_OwnerReconcile((uintptr_t)reg);
+        SimHw_Charge(g_simHwConfig.reg_access_ns);
+    }
+
+    switch (width)
+    {
+    case 1U:
+        return *(const volatile uint8_t *)reg;
+    case 2U:
+        return *(const volatile uint16_t *)reg;
+    default:
+        return *(const volatile uint32_t *)reg;
+    }
+}
+
+/**
+ * @brief Latch @p exc as pending unless it is currently active.
+ */
+void SimHw_SetPending(uint32_t exc)
+{
+    if ((exc < SIMHW_EXC_COUNT) && !SimHw_IsBitSet(g_simHwActive, exc))
+    {
+        g_simHwPending[exc / 32U] |= (1UL << (exc % 32U));
+    }
+}
+
+/**
+ * @brief A DMA master may access [addr, addr + size).
+ */
+bool SimHw_IsReachable(uintptr_t addr, size_t size)
+{
+    uintptr_t end = addr + size;
+
+    if ((addr >= SIMHW_PERIPH_BASE) && (end <= (SIMHW_PERIPH_BASE + SIMHW_PERIPH_SIZE)))
+    {
+        return true;
+    }
+    if ((addr >= (uintptr_t)__executable_start) && (end <= (uintptr_t)_end))
+    {
+        return true;
+    }
+    for (uint32_t i = 0U; i < g_simHwRegionCount; i++)
+    {
+        if ((addr >= g_simHwRegions[i].base) && (end <= (g_simHwRegions[i].base + g_simHwRegions[i].size)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Put every model and its registers in the reset state.
+ */
+static void SimHw_Reset(void)
+{
+    memset(&g_simHwStats, 0, sizeof(g_simHwStats));
+    memset(g_simHwPending, 0, sizeof(g_simHwPending));
+    memset(g_simHwActive, 0, sizeof(g_simHwActive));
+    memset(g_simHwNvicEnabled, 0, sizeof(g_simHwNvicEnabled));
+    memset(g_simHwIserShadow, 0, sizeof(g_simHwIserShadow));
+    memset(g_simHwIsprShadow, 0, sizeof(g_simHwIsprShadow));
+    memset(&g_simHwSysTick, 0, sizeof(g_simHwSysTick));
+    g_simHwSysTick.nextNs = SIMHW_NO_EVENT;
+
+    /* Done by SystemInit() on target, before the firmware runs */
+    memset(g_pfnVectors, 0, sizeof(g_pfnVectors));
+    SIMHW_HANDLERS(SIMHW_VECTOR_ENTRY)
+    SCB->VTOR = (uint32_t)(uintptr_t)g_pfnVectors;
+
+    SimHw_DCacheReset();
+    SimHw_DmaReset();
+    SimHw_Dma2dReset();
+    SimHw_CrcReset();
+    SimHw_RngReset();
+    SimHw_PkaReset();
+    SimHw_SpiReset();
+    SimHw_I2cReset();
+    SimHw_I3cReset();
+    SimHw_TimReset();
+    SimHw_AdcReset();
+    SimHw_LptimReset();
+    SimHw_SdmmcReset();
+    SimHw_NorReset();
+    SimHw_UsbReset();
+    SimHw_GpioReset();
+    SimHw_RtcReset();
+    SimHw_UsartReset();
+}
+
+/**
+ * @brief Process every hardware event up to @p target, then set the clock to it.
+ */
+static void SimHw_RunUntil(uint64_t target)
+{
+    for (;;)
+    {
+        uint64_t next = SimHw_NextEventNs();
+        if (next > target)
+        {
+            break;
+        }
+        SimHw_SetTime(next);
+        SimHw_ProcessEvents();
+    }
+    SimHw_SetTime(target);
+}
+
+/**
+ * @brief Move the clock, refresh CYCCNT and stop when the end is reached.
+ */
+static void SimHw_SetTime(uint64_t now)
+{
+    if (now > g_simHwStats.now_ns)
+    {
+        g_simHwStats.now_ns = now;
+    }
+    SimHw_UpdateCycleCounter();
+
+    if (g_simHwStats.now_ns >= g_simHwStopNs)
+    {
+        SimHw_StopHook_T hook = g_simHwStopHook;
+        g_simHwStopped = true;
+        g_simHwStopNs = SIMHW_NO_EVENT;
+        if (hook != NULL)
+        {
+            hook();
+        }
+    }
+}
+
+/**
+ * @brief Earliest pending hardware event.
+ */
+static uint64_t SimHw_NextEventNs(void)
+{
+    const uint64_t due[] = {
+        g_simHwSysTick.nextNs,     SimHw_UsartNextEventNs(), SimHw_DmaNextEventNs(),   SimHw_Dma2dNextEventNs(),
+        SimHw_RngNextEventNs(),    SimHw_PkaNextEventNs(),   SimHw_SpiNextEventNs(),   SimHw_I2cNextEventNs(),
+        SimHw_I3cNextEventNs(),    SimHw_AdcNextEventNs(),   SimHw_TimNextEventNs(),   SimHw_LptimNextEventNs(),
+        SimHw_SdmmcNextEventNs(),  SimHw_UsbNextEventNs(),   SimHw_GpioNextEventNs(),  SimHw_RtcNextEventNs(),
+    };
+    uint64_t next = SIMHW_NO_EVENT;
+
+    for (uint32_t i = 0U; i < (sizeof(due) / sizeof(due[0])); i++)
+    {
+        if (due[i] < next)
+        {
+            next = due[i];
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Handle every event due at the current time.
+ */
+static void SimHw_ProcessEvents(void)
+{
+    uint64_t now = g_simHwStats.now_ns;
+    g_simHwInModel = true;
+
+    if (g_simHwSysTick.nextNs <= now)
+    {
+        g_simHwSysTick.nextNs += g_simHwSysTick.periodNs;
+        SysTick->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+        if ((SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) != 0U)
+        {
+            SimHw_SetPending(SIMHW_EXC_SYSTICK);
+        }
+    }
+
+    SimHw_UsartEvents(now);
+    SimHw_DmaEvents(now);
+    SimHw_Dma2dEvents(now);
+    SimHw_RngEvents(now);
+    SimHw_PkaEvents(now);
+    SimHw_SpiEvents(now);
+    SimHw_I2cEvents(now);
+    SimHw_I3cEvents(now);
+    /* Conversions first: a trigger landing on the end of a sequence starts the next one */
+    SimHw_AdcEvents(now);
+    SimHw_TimEvents(now);
+    SimHw_LptimEvents(now);
+    SimHw_SdmmcEvents(now);
+    SimHw_UsbEvents(now);
+    SimHw_GpioEvents(now);
+    SimHw_RtcEvents(now);
+
+    g_simHwInModel = false;
+}
+
+/**
+ * @brief Fold plain register stores of every model.
+ */
+static void SimHw_ReconcileAll(void)
+{
+    g_simHwInModel = true;
+    SimHw_CoreReconcile();
+    SimHw_DCacheReconcile();
+    SimHw_DmaReconcileAll();
+    SimHw_UsartReconcile();
+    SimHw_Dma2dReconcile();
+    SimHw_RngReconcile();
+    SimHw_PkaReconcile();
+    SimHw_SpiReconcile();
+    SimHw_I2cReconcile();
+    SimHw_I3cReconcile();
+    SimHw_TimReconcileAll();
+    SimHw_AdcReconcile();
+    SimHw_LptimReconcile();
+    SimHw_SdmmcReconcile();
+    g_simHwInModel = false;
+
+    SimHw_UpdateLines();
+}
+
+/**
+ * @brief Fold NVIC, SCB, SysTick and DWT stores.
+ */
+static void SimHw_CoreReconcile(void)
+{
+    for (uint32_t w = 0U; w < SIMHW_NVIC_WORDS; w++)
+    {
+        uint32_t iser = NVIC->ISER[w];
+        if (iser != g_simHwIserShadow[w])
+        {
+            g_simHwNvicEnabled[w] |= iser;
+        }
+        uint32_t icer = NVIC->ICER[w];
+        if (icer != 0U)
+        {
+            g_simHwNvicEnabled[w] &= ~icer;
+            NVIC->ICER[w] = 0U;
+        }
+        NVIC->ISER[w] = g_simHwIserShadow[w] = g_simHwNvicEnabled[w];
+
+        /* NVIC word w covers exceptions 16 + 32w .. 47 + 32w */
+        uint32_t active = (g_simHwActive[w] >> 16U) | (g_simHwActive[w + 1U] << 16U);
+        uint32_t pending = (g_simHwPending[w] >> 16U) | (g_simHwPending[w + 1U] << 16U);
+        uint32_t ispr = NVIC->ISPR[w];
+        if (ispr != g_simHwIsprShadow[w])
+        {
+            pending |= ispr & ~active;
+        }
+        uint32_t icpr = NVIC->ICPR[w];
+        if (icpr != 0U)
+        {
+            pending &= ~icpr;
+            NVIC->ICPR[w] = 0U;
+        }
+        g_simHwPending[w] = (g_simHwPending[w] & 0x0000FFFFUL) | (pending << 16U);
+        g_simHwPending[w + 1U] = (g_simHwPending[w + 1U] & 0xFFFF0000UL) | (pending >> 16U);
+
+        NVIC->ISPR[w] = g_simHwIsprShadow[w] = pending;
+        NVIC->IABR[w] = active;
+    }
+
+    uint32_t icsr = SCB->ICSR;
+    if ((icsr & SCB_ICSR_PENDSVSET_Msk) != 0U)
+    {
+        SimHw_SetPending(SIMHW_EXC_PENDSV);
+    }
+    if ((icsr & SCB_ICSR_PENDSVCLR_Msk) != 0U)
+    {
+        g_simHwPending[0] &= ~(1UL << SIMHW_EXC_PENDSV);
+    }
+    if ((icsr & SCB_ICSR_PENDSTSET_Msk) != 0U)
+    {
+        SimHw_SetPending(SIMHW_EXC_SYSTICK);
+    }
+    if ((icsr & SCB_ICSR_PENDSTCLR_Msk) != 0U)
+    {
+        g_simHwPending[0] &= ~(1UL << SIMHW_EXC_SYSTICK);
+    }
+    SCB->ICSR = g_simHwIpsr & SCB_ICSR_VECTACTIVE_Msk;
+
+    bool enabled = (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) != 0U;
+    uint32_t load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+    if (enabled && (SystemCoreClock != 0U) &&
+        (!g_simHwSysTick.enabled || (load != g_simHwSysTick.load)))
+    {
+        g_simHwSysTick.load = load;
+        g_simHwSysTick.periodNs = (((uint64_t)load + 1U) * 1000000000ULL) / SystemCoreClock;
+        if (g_simHwSysTick.periodNs == 0U)
+        {
+            g_simHwSysTick.periodNs = 1U;
+        }
+        g_simHwSysTick.nextNs = g_simHwStats.now_ns + g_simHwSysTick.periodNs;
+    }
+    else if (!enabled)
+    {
+        g_simHwSysTick.nextNs = SIMHW_NO_EVENT;
+    }
+    g_simHwSysTick.enabled = enabled;
+
+    SimHw_UpdateCycleCounter();
+}
+
+/**
+ * @brief Latch the level of every modelled interrupt line into the NVIC.
+ *
+ * An active line is not latched again until its handler returns, as on a
+ * level-sensitive NVIC input.
+ */
+static void SimHw_UpdateLines(void)
+{
+    SimHw_DmaLines();
+    SimHw_UsartLines();
+    SimHw_Dma2dLines();
+    SimHw_RngLines();
+    SimHw_PkaLines();
+    SimHw_SpiLines();
+    SimHw_I2cLines();
+    SimHw_I3cLines();
+    SimHw_TimLines();
+    SimHw_AdcLines();
+    SimHw_LptimLines();
+    SimHw_SdmmcLines();
+    SimHw_UsbLines();
+    SimHw_ExtiLines();
+    SimHw_RtcLines();
+}
+
+/**
+ * @brief Take pending exceptions in priority order while masking allows.
+ */
+static void SimHw_Dispatch(void)
+{
+    uint32_t exc;
+    while (!g_simHwStopped && SimHw_SelectException(&exc))
+    {
+        SimHw_TakeException(exc);
+        SimHw_ReconcileAll();
+    }
+}
+
+/**
+ * @brief Pick the highest priority pending exception that may preempt.
+ */
+static bool SimHw_SelectException(uint32_t *exc)
+{
+    if (g_simHwPriMask != 0U)
+    {
+        return false;
+    }
+
+    uint32_t limit = g_simHwExecPrio;
+    if ((g_simHwBasePri != 0U) && (g_simHwBasePri < limit))
+    {
+        limit = g_simHwBasePri;
+    }
+
+    bool found = false;
+    uint32_t best = limit;
+    for (uint32_t w = 0U; w < SIMHW_EXC_WORDS; w++)
+    {
+        uint32_t word = g_simHwPending[w];
+        while (word != 0U)
+        {
+            uint32_t b = (uint32_t)__builtin_ctz(word);
+            uint32_t e = (w * 32U) + b;
+            word &= word - 1U;
+
+            if ((e >= 16U) && !SimHw_IsBitSet(g_simHwNvicEnabled, e - 16U))
+            {
+                continue;
+            }
+            uint32_t prio = SimHw_GetPriority(e);
+            if (prio < best)
+            {
+                best = prio;
+                *exc = e;
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Run the handler of @p exc as an exception.
+ *
+ * Entry clears the exclusive monitor and raises the execution priority,
+ * return restores the preempted context. A handler may switch tasks (the
+ * PendSV handler does); the frame of the switched-out task keeps its saved
+ * context until that task is resumed.
+ */
+static void SimHw_TakeException(uint32_t exc)
+{
+    uint32_t savedIpsr = g_simHwIpsr;
+    uint32_t savedPrio = g_simHwExecPrio;
+    void (*handler)(void) = SimHw_GetHandler(exc);
+
+    if (handler == NULL)
+    {
+        fprintf(stderr, "SimHw: no handler for exception %u (IRQ %d)\n", exc, (int)exc - 16);
+        abort();
+    }
+
+    g_simHwPending[exc / 32U] &= ~(1UL << (exc % 32U));
+    g_simHwActive[exc / 32U] |= (1UL << (exc % 32U));
+    g_simHwIpsr = exc;
+    g_simHwExecPrio = SimHw_GetPriority(exc);
+    g_simHwExclusive = NULL;
+    if (exc >= 16U)
+    {
+        g_simHwStats.irqs_taken++;
+    }
+    else
+    {
+        g_simHwStats.exceptions_taken++;
+    }
+
+    handler();
+
+    g_simHwActive[exc / 32U] &= ~(1UL << (exc % 32U));
+    g_simHwIpsr = savedIpsr;
+    g_simHwExecPrio = savedPrio;
+    g_simHwExclusive = NULL;
+}
+
+/**
+ * @brief Programmed priority of @p exc, upper bits only.
+ */
+static uint32_t SimHw_GetPriority(uint32_t exc)
+{
+    if (exc >= 16U)
+    {
+        return NVIC->IPR[exc - 16U] & SIMHW_PRIO_MASK;
+    }
+    if (exc >= 4U)
+    {
+        return SCB->SHPR[exc - 4U] & SIMHW_PRIO_MASK;
+    }
+    return 0U;
+}
+
+/**
+ * @brief Handler of @p exc from the vector table at VTOR.
+ */
+static void (*SimHw_GetHandler(uint32_t exc))(void)
+{
+    const uint32_t *table = (const uint32_t *)(uintptr_t)SCB->VTOR;
+    return (void (*)(void))(uintptr_t)table[exc];
+}
+
+/** @brief Test bit @p bit of @p bitmap. */
+static bool SimHw_IsBitSet(const uint32_t *bitmap, uint32_t bit)
+{
+    return (bitmap[bit / 32U] & (1UL << (bit % 32U))) != 0U;
+}
+
+/**
+ * @brief Derive DWT->CYCCNT from virtual time and SystemCoreClock.
+ *
+ * A value written by firmware since the last update rebases the counter.
+ */
+static void SimHw_UpdateCycleCounter(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U)
+    {
+        return;
+    }
+
+    uint64_t seconds = g_simHwStats.now_ns / 1000000000U;
+    uint64_t fraction = g_simHwStats.now_ns % 1000000000U;
+    uint64_t cycles = (seconds * SystemCoreClock) + ((fraction * SystemCoreClock) / 1000000000U);
+    uint32_t current = DWT->CYCCNT;
+    if (current != g_simHwCycleLast)
+    {
+        g_simHwCycleBase = cycles - current;
+    }
+    g_simHwCycleLast = (uint32_t)(cycles - g_simHwCycleBase);
+    DWT->CYCCNT = g_simHwCycleLast;
+}
+
+/**
+ * @brief Let the model owning @p addr react to an access.
+ */
+static void SimHw_OwnerReconcile(uintptr_t addr)
+{
+    if (!g_simHwReady)
+    {
+        return;
+    }
+
+    g_simHwInModel = true;
+    uintptr_t usart = (uintptr_t)USART1;
+    uintptr_t dma2d = (uintptr_t)DMA2D;
+    uintptr_t rng = (uintptr_t)RNG;
+    uintptr_t pka = (uintptr_t)PKA;
+    uintptr_t spi = (uintptr_t)SPI1;
+    uintptr_t i2c = (uintptr_t)I2C1;
+    uintptr_t i3c = (uintptr_t)I3C1;
+    uintptr_t adc = (uintptr_t)ADC1;
+    uintptr_t lptim = (uintptr_t)LPTIM1;
+    uintptr_t sdmmc = (uintptr_t)SDMMC1;
+    uintptr_t gpio = (uintptr_t)GPIOA;
+    if ((addr >= usart) && (addr < (usart + sizeof(USART_TypeDef))))
+    {
+        SimHw_UsartReconcile();
+    }
+    else if ((addr >= dma2d) && (addr < (dma2d + sizeof(DMA2D_TypeDef))))
+    {
+        SimHw_Dma2dReconcile();
+    }
+    else if ((addr >= rng) && (addr < (rng + sizeof(RNG_TypeDef))))
+    {
+        SimHw_RngReconcile();
+    }
+    else if ((addr >= pka) && (addr < (pka + sizeof(PKA_TypeDef))))
+    {
+        SimHw_PkaReconcile();
+    }
+    else if ((addr >= spi) && (addr < (spi + sizeof(SPI_TypeDef))))
+    {
+        SimHw_SpiReconcile();
+    }
+    else if ((addr >= i2c) && (addr < (i2c + sizeof(I2C_TypeDef))))
+    {
+        SimHw_I2cReconcile();
+    }
+    else if ((addr >= i3c) && (addr < (i3c + sizeof(I3C_TypeDef))))
+    {
+        SimHw_I3cReconcile();
+    }
+    else if ((addr >= adc) && (addr < (adc + sizeof(ADC_TypeDef))))
+    {
+        SimHw_AdcReconcile();
+    }
+    else if ((addr >= lptim) && (addr < (lptim + sizeof(LPTIM_TypeDef))))
+    {
+        SimHw_LptimReconcile();
+    }
+    else if ((addr >= sdmmc) && (addr < (sdmmc + sizeof(SDMMC_TypeDef))))
+    {
+        SimHw_SdmmcReconcile();
+    }
+    else if ((addr >= gpio) && (addr < ((uintptr_t)GPIOQ + sizeof(GPIO_TypeDef))))
+    {
+        SimHw_GpioReconcile((GPIO_TypeDef *)(addr & ~(uintptr_t)0x3FFU));
+    }
+    else if ((addr == (uintptr_t)&RCC->CSR) || (addr == (uintptr_t)&RCC->CCR))
+    {
+        SimHw_RccReconcile();
+    }
+    else if (!SimHw_TimReconcileAt(addr))
+    {
+        (void)SimHw_DmaReconcileAt(addr);
+    }
+    g_simHwInModel = false;
+}
+
+/**
+ * @brief Charge the CPU for a firmware memcpy or memset of @p size bytes.
+ */
+static void SimHw_ChargeCopy(size_t size)
+{
+    if (g_simHwReady && !g_simHwInModel && (size != 0U))
+    {
+        SimHw_Charge(((uint64_t)size * 1000U) / g_simHwConfig.cpu_copy_bytes_per_us);
+    }
+}
+
+/**
+ * @brief Apply RCC oscillator enables and disables.
+ *
+ * Oscillators start at once: a CSR set raises the ON bit in CR and the
+ * ready flag in SR, a CCR clear drops both. Both registers read as zero.
+ */
+static void SimHw_RccReconcile(void)
+{
+    uint32_t on = RCC->CSR;
+    uint32_t off = RCC->CCR;
+
+    RCC->CR = (RCC->CR | on) & ~off;
+    RCC->SR = (RCC->SR | (on & SIMHW_RCC_OSC)) & ~(off & SIMHW_RCC_OSC);
+    RCC->CSR = 0U;
+    RCC->CCR = 0U;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,362 @@
+/**
+ * @file SimHw_Adc.c
+ * @brief Register-level model of ADC1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Enable, calibration and ADSTART/ADSTP, regular sequence started by software
+ * or by TIM2 TRGO, sampling time per channel from the kernel clock,
+ * oversampling with the OVSS shift, EOC/EOS/OVR and DMA requests. Input n is
+ * a sine of (n + 1) x 100 Hz around mid-scale with noise on every conversion.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <math.h>
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_ADC_CONV_HALF_CYCLES (25U) /**< 12-bit conversion after sampling, in ADC clock half cycles */
+#define SIMHW_ADC_BASE_HZ      (100U)    /**< Frequency of input 0; input n runs at (n + 1) times it */
+#define SIMHW_ADC_AMPLITUDE    (1500U)   /**< Peak deviation of the inputs from mid-scale, in LSB */
+#define SIMHW_ADC_NOISE_LSB    (8U)      /**< Peak uniform noise added to every conversion */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of ADC1 and its regular group.
+ */
+typedef struct
+{
+    ADC_TypeDef *regs; /**< Register block in the mapped window */
+    bool enabled;      /**< ADEN applied */
+    bool started;      /**< ADSTART applied, the regular group is armed */
+    uint32_t flags;    /**< ISR content */
+    uint32_t rank;     /**< Rank being converted */
+    uint64_t doneNs;   /**< End of the conversion of @ref rank */
+    uint64_t noise;    /**< Noise generator state */
+    uint32_t clockKey; /**< CCIPR1 the cached kernel clock was read from */
+    uint32_t clockHz;  /**< Cached kernel clock */
+} SimHw_Adc_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Adc_T g_simHwAdc;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_AdcBegin(void);
+static void SimHw_AdcConvDone(void);
+static uint32_t SimHw_AdcChannel(uint32_t rank);
+static uint64_t SimHw_AdcConvNs(uint32_t channel);
+static uint32_t SimHw_AdcRatio(void);
+static uint32_t SimHw_AdcSample(uint32_t channel);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply ADC1 control register stores.
+ *
+ * Calibration completes at once and enabling raises ADRDY. ADSTART arms
+ * the regular group: a software trigger starts the sequence immediately,
+ * an external one waits for its edge. ADSTP aborts the conversion in
+ * progress.
+ */
+void SimHw_AdcReconcile(void)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+    ADC_TypeDef *r = a->regs;
+    uint32_t cr = r->CR;
+
+    if (((cr & ADC_CR_ADDIS) != 0U) && a->enabled)
+    {
+        a->enabled = false;
+        a->started = false;
+        a->doneNs = SIMHW_NO_EVENT;
+        a->flags &= ~ADC_ISR_ADRDY;
+    }
+    else if (((cr & ADC_CR_ADEN) != 0U) && !a->enabled && ((cr & ADC_CR_DEEPPWD) == 0U))
+    {
+        a->enabled = true;
+        a->flags |= ADC_ISR_ADRDY;
+    }
+
+    if (((cr & ADC_CR_ADSTP) != 0U) && a->started)
+    {
+        a->started = false;
+        a->doneNs = SIMHW_NO_EVENT;
+    }
+    else if (((cr & ADC_CR_ADSTART) != 0U) && a->enabled && !a->started)
+    {
+        a->started = true;
+        if ((r->CFGR1 & ADC_CFGR1_EXTEN) == 0U)
+        {
+            SimHw_AdcBegin();
+        }
+    }
+
+    r->CR = (cr & ~(ADC_CR_ADEN | ADC_CR_ADDIS | ADC_CR_ADSTART | ADC_CR_ADSTP | ADC_CR_ADCAL)) |
+            (a->enabled ? ADC_CR_ADEN : 0U) | (a->started ? ADC_CR_ADSTART : 0U);
+    r->ISR = a->flags;
+}
+
+/**
+ * @brief Apply a CPU store to ADC1 ISR, whose flags are cleared by writing 1.
+ *
+ * @retval true  The store was handled by the model.
+ * @retval false Not ISR, store as memory.
+ */
+bool SimHw_AdcWrite(uintptr_t addr, uint32_t value)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+
+    if (addr != (uintptr_t)&a->regs->ISR)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    a->flags &= ~value;
+    a->regs->ISR = a->flags;
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Apply a CPU load from ADC1 DR, which clears EOC.
+ *
+ * @retval true  The load was handled by the model.
+ * @retval false Not DR, read memory.
+ */
+bool SimHw_AdcRead(uintptr_t addr, uint32_t *value)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+
+    if (addr != (uintptr_t)&a->regs->DR)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    *value = a->regs->DR;
+    a->flags &= ~ADC_ISR_EOC;
+    a->regs->ISR = a->flags;
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief External trigger edge: start the regular sequence if armed for @p extsel and idle.
+ *
+ * A trigger arriving while a sequence converts is ignored, as on silicon.
+ */
+void SimHw_AdcTrigger(uint32_t extsel)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+    uint32_t cfgr1 = a->regs->CFGR1;
+
+    if (a->started && (a->doneNs == SIMHW_NO_EVENT) && ((cfgr1 & ADC_CFGR1_EXTEN) != 0U) &&
+        ((cfgr1 & ADC_CFGR1_EXTSEL) == extsel))
+    {
+        SimHw_AdcBegin();
+    }
+    else if (a->started && (a->doneNs != SIMHW_NO_EVENT))
+    {
+        g_simHwStats.adc_trig_missed++;
+    }
+}
+
+/**
+ * @brief Put ADC1 in the reset state, in deep power-down.
+ */
+void SimHw_AdcReset(void)
+{
+    memset(&g_simHwAdc, 0, sizeof(g_simHwAdc));
+    g_simHwAdc.regs = ADC1;
+    g_simHwAdc.regs->CR = ADC_CR_DEEPPWD;
+    g_simHwAdc.doneNs = SIMHW_NO_EVENT;
+    g_simHwAdc.noise = 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief End of the running conversion.
+ */
+uint64_t SimHw_AdcNextEventNs(void)
+{
+    return g_simHwAdc.doneNs;
+}
+
+/**
+ * @brief Complete the conversion ending at @p now.
+ */
+void SimHw_AdcEvents(uint64_t now)
+{
+    if (g_simHwAdc.doneNs <= now)
+    {
+        SimHw_AdcConvDone();
+    }
+}
+
+/**
+ * @brief Raise the ADC1 interrupt while an enabled flag is set.
+ */
+void SimHw_AdcLines(void)
+{
+    if ((g_simHwAdc.flags & g_simHwAdc.regs->IER) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)ADC1_2_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Start converting the first rank of the regular sequence.
+ */
+static void SimHw_AdcBegin(void)
+{
+    g_simHwAdc.rank = 0U;
+    g_simHwAdc.doneNs = g_simHwStats.now_ns + SimHw_AdcConvNs(SimHw_AdcChannel(0U));
+}
+
+/**
+ * @brief End of a conversion: store the result, request the DMA and move to the next rank.
+ *
+ * A result completing while EOC is still set is an overrun; OVRMOD
+ * decides whether DR keeps the old sample or takes the new one. In DMA
+ * mode the channel reads DR at once and clears EOC, unless it is not
+ * ready to take the request.
+ */
+static void SimHw_AdcConvDone(void)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+    ADC_TypeDef *r = a->regs;
+    uint32_t cfgr1 = r->CFGR1;
+    uint32_t length = ((r->SQR1 & ADC_SQR1_L) >> ADC_SQR1_L_Pos) + 1U;
+    uint32_t value = SimHw_AdcSample(SimHw_AdcChannel(a->rank));
+
+    if ((a->flags & ADC_ISR_EOC) != 0U)
+    {
+        a->flags |= ADC_ISR_OVR;
+        g_simHwStats.adc_overruns++;
+        if ((cfgr1 & ADC_CFGR1_OVRMOD) != 0U)
+        {
+            r->DR = value;
+        }
+    }
+    else
+    {
+        r->DR = value;
+        a->flags |= ADC_ISR_EOC;
+    }
+
+    a->rank++;
+    if (a->rank >= length)
+    {
+        a->flags |= ADC_ISR_EOS;
+    }
+
+    if (((cfgr1 & ADC_CFGR1_DMNGT) != 0U) && ((a->flags & ADC_ISR_OVR) == 0U) &&
+        SimHw_DmaRequest(LL_GPDMA1_REQUEST_ADC1) && SimHw_DmaRequest(LL_GPDMA1_REQUEST_ADC1))
+    {
+        a->flags &= ~ADC_ISR_EOC;
+    }
+
+    a->doneNs = SIMHW_NO_EVENT;
+    if (a->rank < length)
+    {
+        a->doneNs = g_simHwStats.now_ns + SimHw_AdcConvNs(SimHw_AdcChannel(a->rank));
+    }
+    else if ((cfgr1 & ADC_CFGR1_EXTEN) == 0U)
+    {
+        a->started = false;
+        r->CR &= ~ADC_CR_ADSTART;
+    }
+    r->ISR = a->flags;
+}
+
+/**
+ * @brief Input converted by regular rank @p rank.
+ */
+static uint32_t SimHw_AdcChannel(uint32_t rank)
+{
+    const volatile uint32_t *sqr = &g_simHwAdc.regs->SQR1;
+    uint32_t slot = rank + 1U; /* SQR1 starts with L */
+
+    return (sqr[slot / 5U] >> (6U * (slot % 5U))) & 0x1FU;
+}
+
+/**
+ * @brief Sampling plus conversion time of @p channel, times the oversampling ratio.
+ *
+ * The kernel clock is HCLK, or the source selected in RCC, divided by
+ * ADCPRE; it is cached for the CCIPR1 content it was read from.
+ */
+static uint64_t SimHw_AdcConvNs(uint32_t channel)
+{
+    static const uint16_t smpHalfCycles[8] = {3U, 5U, 13U, 23U, 47U, 93U, 493U, 2999U};
+    SimHw_Adc_T *a = &g_simHwAdc;
+    ADC_TypeDef *r = a->regs;
+
+    if ((RCC->CCIPR1 != a->clockKey) || (a->clockHz == 0U))
+    {
+        a->clockKey = RCC->CCIPR1;
+        bool inModel = g_simHwInModel;
+        g_simHwInModel = true;
+        uint32_t hz = LL_RCC_GetADCClockFreq(LL_RCC_ADC_CLKSOURCE) / (LL_RCC_GetADCPrescaler() + 1U);
+        g_simHwInModel = inModel;
+        a->clockHz = (hz != 0U) ? hz : 1U;
+    }
+
+    const volatile uint32_t *smpr = (channel < 10U) ? &r->SMPR1 : &r->SMPR2;
+    uint32_t smp = (*smpr >> (3U * (channel % 10U))) & 0x7U;
+    uint64_t halfCycles = (uint64_t)(smpHalfCycles[smp] + SIMHW_ADC_CONV_HALF_CYCLES) * SimHw_AdcRatio();
+    uint64_t ns = ((halfCycles * 1000000000ULL) + (2ULL * a->clockHz) - 1U) / (2ULL * a->clockHz);
+    return (ns != 0U) ? ns : 1U;
+}
+
+/**
+ * @brief Conversions accumulated per result, 1 without oversampling.
+ */
+static uint32_t SimHw_AdcRatio(void)
+{
+    uint32_t cfgr2 = g_simHwAdc.regs->CFGR2;
+
+    if ((cfgr2 & ADC_CFGR2_ROVSE) == 0U)
+    {
+        return 1U;
+    }
+    return ((cfgr2 & ADC_CFGR2_OVSR) >> ADC_CFGR2_OVSR_Pos) + 1U;
+}
+
+/**
+ * @brief Result of one regular conversion of @p channel at the current time.
+ *
+ * Input n is a sine of (n + 1) x ::SIMHW_ADC_BASE_HZ swinging
+ * ::SIMHW_ADC_AMPLITUDE around mid-scale, plus uniform noise of
+ * ::SIMHW_ADC_NOISE_LSB on every 12-bit conversion. Oversampling sums the
+ * conversions and shifts right by OVSS.
+ */
+static uint32_t SimHw_AdcSample(uint32_t channel)
+{
+    SimHw_Adc_T *a = &g_simHwAdc;
+    uint32_t ratio = SimHw_AdcRatio();
+    double phase = (double)g_simHwStats.now_ns * 1e-9 * (double)SIMHW_ADC_BASE_HZ * (double)(channel + 1U);
+    double level = 2048.0 + ((double)SIMHW_ADC_AMPLITUDE * sin(2.0 * M_PI * phase));
+    uint64_t sum = 0U;
+
+    for (uint32_t i = 0U; i < ratio; i++)
+    {
+        a->noise = (a->noise * 6364136223846793005ULL) + 1442695040888963407ULL;
+        int32_t noise = (int32_t)((a->noise >> 33) % ((2U * SIMHW_ADC_NOISE_LSB) + 1U)) - (int32_t)SIMHW_ADC_NOISE_LSB;
+        int32_t code = (int32_t)level + noise;
+        code = (code < 0) ? 0 : ((code > 4095) ? 4095 : code);
+        sum += (uint32_t)code;
+    }
+    g_simHwStats.adc_conversions += ratio;
+
+    if (ratio > 1U)
+    {
+        sum >>= (g_simHwAdc.regs->CFGR2 & ADC_CFGR2_OVSS) >> ADC_CFGR2_OVSS_Pos;
+    }
+    return (uint32_t)sum;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,208 @@
+/**
+ * @file SimHw_Crc.c
+ * @brief Register-level model of the CRC unit.
+ * @ingroup SimHw
+ * @{
+ *
+ * Programmable polynomial of 7, 8, 16 or 32 bits with input and output
+ * reversal, fed by CPU stores of any width or by DMA word beats.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the CRC unit.
+ */
+typedef struct
+{
+    CRC_TypeDef *regs;     /**< Register block in the mapped window */
+    uint32_t crc;          /**< Calculation before output reversal */
+    uint8_t pending[4];    /**< Bytes of a DMA word write received so far */
+} SimHw_Crc_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Crc_T g_simHwCrc;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_CrcFeed(uint32_t data, uint32_t bytes);
+static void SimHw_CrcPublish(void);
+static uint32_t SimHw_Reflect(uint32_t value, uint32_t bits);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply a CPU store to the CRC unit.
+ *
+ * Data register stores are fed to the calculation with their access
+ * width; a CR store with RESET loads INIT into the calculation.
+ *
+ * @retval true  The store was handled by the model.
+ * @retval false Not a CRC data or control register, store as memory.
+ */
+bool SimHw_CrcWrite(uintptr_t addr, size_t width, uint32_t value)
+{
+    CRC_TypeDef *r = g_simHwCrc.regs;
+
+    if (addr == (uintptr_t)&r->DR)
+    {
+        SimHw_CrcFeed(value, (uint32_t)width);
+        return true;
+    }
+    if ((addr != (uintptr_t)&r->CR) || (width != 4U))
+    {
+        return false;
+    }
+
+    r->CR = value & ~CRC_CR_RESET;
+    if ((value & CRC_CR_RESET) != 0U)
+    {
+        g_simHwCrc.crc = r->INIT;
+    }
+    SimHw_CrcPublish();
+    return true;
+}
+
+/**
+ * @brief Put the CRC unit in the reset state, CRC-32 with all-ones seed.
+ */
+void SimHw_CrcReset(void)
+{
+    memset(&g_simHwCrc, 0, sizeof(g_simHwCrc));
+    g_simHwCrc.regs = CRC;
+    g_simHwCrc.regs->INIT = 0xFFFFFFFFU;
+    g_simHwCrc.regs->POL = 0x04C11DB7U;
+    g_simHwCrc.crc = 0xFFFFFFFFU;
+    SimHw_CrcPublish();
+}
+
+/**
+ * @brief Take a DMA write to DR, fed as one word once its last byte arrives.
+ *
+ * @retval true  @p addr lies in DR.
+ * @retval false Not the CRC data register.
+ */
+bool SimHw_CrcDmaWrite(uintptr_t addr, uint8_t data)
+{
+    uintptr_t crcDr = (uintptr_t)&g_simHwCrc.regs->DR;
+
+    if ((addr < crcDr) || (addr >= (crcDr + 4U)))
+    {
+        return false;
+    }
+    g_simHwCrc.pending[addr - crcDr] = data;
+    if ((addr - crcDr) == 3U)
+    {
+        uint32_t word = (uint32_t)g_simHwCrc.pending[0] | ((uint32_t)g_simHwCrc.pending[1] << 8) |
+                        ((uint32_t)g_simHwCrc.pending[2] << 16) | ((uint32_t)g_simHwCrc.pending[3] << 24);
+        SimHw_CrcFeed(word, 4U);
+    }
+    return true;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Feed one data register write of @p bytes bytes to the calculation.
+ *
+ * The input reversal selected by REV_IN and RTYPE_IN is applied over the
+ * access width, then the bits enter MSB first.
+ */
+static void SimHw_CrcFeed(uint32_t data, uint32_t bytes)
+{
+    CRC_TypeDef *r = g_simHwCrc.regs;
+    uint32_t cr = r->CR;
+    uint32_t bits = bytes * 8U;
+    static const uint32_t polySize[4] = {32U, 16U, 8U, 7U};
+    uint32_t size = polySize[(cr & CRC_CR_POLYSIZE) >> CRC_CR_POLYSIZE_Pos];
+    data &= (bits == 32U) ? 0xFFFFFFFFU : ((1UL << bits) - 1U);
+
+    uint32_t in = data;
+    bool byteType = (cr & CRC_CR_RTYPE_IN) != 0U;
+    switch ((cr & CRC_CR_REV_IN) >> CRC_CR_REV_IN_Pos)
+    {
+    case 1U: /* bit reversal by byte, or half-word swap by word */
+        if (byteType)
+        {
+            in = (bits == 32U) ? ((data >> 16) | (data << 16)) : data;
+        }
+        else
+        {
+            in = 0U;
+            for (uint32_t b = 0U; b < bits; b += 8U)
+            {
+                in |= SimHw_Reflect((data >> b) & 0xFFU, 8U) << b;
+            }
+        }
+        break;
+    case 2U: /* bit reversal by half-word, or byte swap by word */
+        if (byteType)
+        {
+            in = 0U;
+            for (uint32_t b = 0U; b < bits; b += 8U)
+            {
+                in |= ((data >> b) & 0xFFU) << (bits - 8U - b);
+            }
+        }
+        else
+        {
+            in = 0U;
+            for (uint32_t b = 0U; b < bits; b += 16U)
+            {
+                uint32_t span = ((bits - b) < 16U) ? (bits - b) : 16U;
+                in |= SimHw_Reflect((data >> b) & ((1UL << span) - 1U), span) << b;
+            }
+        }
+        break;
+    case 3U: /* bit reversal by word */
+        in = SimHw_Reflect(data, bits);
+        break;
+    default:
+        break;
+    }
+
+    uint32_t mask = (size == 32U) ? 0xFFFFFFFFU : ((1UL << size) - 1U);
+    uint32_t poly = r->POL & mask;
+    uint32_t crc = g_simHwCrc.crc & mask;
+    for (uint32_t i = bits; i > 0U; i--)
+    {
+        uint32_t top = (crc >> (size - 1U)) & 1U;
+        crc = (crc << 1) & mask;
+        if ((top ^ ((in >> (i - 1U)) & 1U)) != 0U)
+        {
+            crc ^= poly;
+        }
+    }
+    g_simHwCrc.crc = crc;
+    g_simHwStats.crc_bytes += bytes;
+    SimHw_CrcPublish();
+}
+
+/**
+ * @brief Publish the calculation in DR, bit reversed if REV_OUT asks so.
+ */
+static void SimHw_CrcPublish(void)
+{
+    CRC_TypeDef *r = g_simHwCrc.regs;
+    static const uint32_t polySize[4] = {32U, 16U, 8U, 7U};
+    uint32_t size = polySize[(r->CR & CRC_CR_POLYSIZE) >> CRC_CR_POLYSIZE_Pos];
+
+    r->DR = ((r->CR & CRC_CR_REV_OUT) != 0U) ? SimHw_Reflect(g_simHwCrc.crc, size) : g_simHwCrc.crc;
+}
+
+/**
+ * @brief Reverse the low @p bits bits of @p value.
+ */
+static uint32_t SimHw_Reflect(uint32_t value, uint32_t bits)
+{
+    uint32_t out = 0U;
+    for (uint32_t i = 0U; i < bits; i++)
+    {
+        out = (out << 1) | ((value >> i) & 1U);
+    }
+    return out;
+}
+
+/** @} */ // end of SimHw group
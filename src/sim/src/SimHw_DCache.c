@@ -0,0 +1,356 @@
+/**
+ * @file SimHw_DCache.c
+ * @brief Model of the Cortex-M55 data cache as the DMA masters see it.
+ * @ingroup SimHw
+ * @{
+ *
+ * The CPU reads and writes host memory directly, so host memory is what the
+ * CPU sees through the cache. Behind it the model keeps, for every 32-byte
+ * line it follows, what memory holds and what the CPU saw when the line was
+ * last coherent. A line whose host copy moved away from that snapshot is
+ * dirty. On cacheable memory:
+ *  - a DMA read returns memory, so bytes the CPU wrote without a clean stay
+ *    invisible to the DMA,
+ *  - a DMA write updates memory only, so the CPU keeps its stale copy until
+ *    it invalidates the line,
+ *  - a clean writes a dirty line back whole, an invalidate replaces the CPU
+ *    copy by memory and drops dirty bytes, as on silicon.
+ *
+ * Lines are followed from the first DMA access or maintenance operation that
+ * touches them, and are taken as coherent before that. Once followed they
+ * stay in the cache: there are no evictions, the worst case for missing
+ * maintenance. Memory is cacheable while SCB CCR.DC is set, outside the
+ * peripheral space and outside enabled MPU regions whose MAIR attribute is
+ * device or inner non-cacheable. MPU regions are latched at synchronisation
+ * points, so each must be followed by a barrier before the next RNR write,
+ * as ARM_MPU_Enable() does. Set/way maintenance is not modelled.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_DCACHE_LINE      (32U)   /**< Cortex-M55 data cache line size */
+#define SIMHW_DCACHE_MIN_SLOTS (4096U) /**< Initial size of the line table, a power of two */
+#define SIMHW_MPU_REGIONS      (16U)   /**< MPU regions latched, a power of two */
+#define SIMHW_MPU_GRANULE      (32U)   /**< MPU base and limit granularity */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Cache line followed by the model.
+ */
+typedef struct
+{
+    uintptr_t addr;                      /**< Line address, 0 for a free slot */
+    uint8_t memory[SIMHW_DCACHE_LINE];   /**< Contents of memory, as DMA masters see them */
+    uint8_t coherent[SIMHW_DCACHE_LINE]; /**< CPU copy when the line was last coherent */
+} SimHw_DCacheLine_T;
+
+/**
+ * @brief One MPU region as last programmed.
+ */
+typedef struct
+{
+    uint32_t rbar; /**< Base address and access attributes */
+    uint32_t rlar; /**< Limit address, attribute index and enable */
+} SimHw_MpuRegion_T;
+
+/**
+ * @brief State of the data cache and of the MPU regions it depends on.
+ */
+typedef struct
+{
+    SimHw_DCacheLine_T *slots;                   /**< Open addressing table of the followed lines */
+    size_t slotCount;                            /**< Slots allocated, a power of two */
+    SimHw_DCacheLine_T *last;                    /**< Line found last, checked before the table */
+    SimHw_MpuRegion_T region[SIMHW_MPU_REGIONS]; /**< Regions latched from RNR/RBAR/RLAR */
+    uint32_t rbarShadow;                         /**< RBAR as last published */
+    uint32_t rlarShadow;                         /**< RLAR as last published */
+} SimHw_DCache_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_DCache_T g_simHwDCache;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static bool SimHw_DCacheCacheable(uintptr_t addr);
+static SimHw_DCacheLine_T *SimHw_DCacheFind(uintptr_t addr);
+static size_t SimHw_DCacheSlot(uintptr_t addr, size_t mask);
+static void SimHw_DCacheGrow(void);
+static void SimHw_DCacheClean(SimHw_DCacheLine_T *line);
+static void SimHw_DCacheInvalidate(SimHw_DCacheLine_T *line);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Data cache maintenance by address, applied to the lines and charged per line.
+ */
+void SimHw_DCacheByAddr(volatile void *addr, int32_t dsize, uint32_t op)
+{
+    if (dsize > 0)
+    {
+        uintptr_t first = (uintptr_t)addr & ~(uintptr_t)(SIMHW_DCACHE_LINE - 1U);
+        uintptr_t end = (uintptr_t)addr + (uint32_t)dsize;
+        bool inModel = g_simHwInModel;
+
+        g_simHwInModel = true;
+        for (uintptr_t at = first; at < end; at += SIMHW_DCACHE_LINE)
+        {
+            if (!g_simHwReady || !SimHw_DCacheCacheable(at))
+            {
+                continue;
+            }
+            SimHw_DCacheLine_T *line = SimHw_DCacheFind(at);
+            if ((op & SIMHW_DCACHE_CLEAN) != 0U)
+            {
+                SimHw_DCacheClean(line);
+            }
+            if ((op & SIMHW_DCACHE_INVALIDATE) != 0U)
+            {
+                SimHw_DCacheInvalidate(line);
+            }
+        }
+        g_simHwInModel = inModel;
+        SimHw_Charge((uint64_t)((end - first + SIMHW_DCACHE_LINE - 1U) / SIMHW_DCACHE_LINE) *
+                     g_simHwConfig.dcache_line_ns);
+    }
+    SimHw_Sync();
+}
+
+/**
+ * @brief Forget every line and MPU region.
+ */
+void SimHw_DCacheReset(void)
+{
+    free(g_simHwDCache.slots);
+    memset(&g_simHwDCache, 0, sizeof(g_simHwDCache));
+}
+
+/**
+ * @brief Latch the MPU region RBAR/RLAR were written for and show the one RNR selects.
+ */
+void SimHw_DCacheReconcile(void)
+{
+    SimHw_DCache_T *c = &g_simHwDCache;
+    SimHw_MpuRegion_T *region = &c->region[MPU->RNR & (SIMHW_MPU_REGIONS - 1U)];
+
+    if ((MPU->RBAR != c->rbarShadow) || (MPU->RLAR != c->rlarShadow))
+    {
+        region->rbar = MPU->RBAR;
+        region->rlar = MPU->RLAR;
+    }
+    MPU->RBAR = c->rbarShadow = region->rbar;
+    MPU->RLAR = c->rlarShadow = region->rlar;
+}
+
+/**
+ * @brief A DMA master reads [addr, addr + size) through the memory system.
+ */
+void SimHw_DCacheDmaRead(uintptr_t addr, void *dst, size_t size)
+{
+    uint8_t *out = (uint8_t *)dst;
+
+    while (size != 0U)
+    {
+        size_t offset = addr & (SIMHW_DCACHE_LINE - 1U);
+        size_t n = SIMHW_DCACHE_LINE - offset;
+        n = (n < size) ? n : size;
+
+        if (!SimHw_DCacheCacheable(addr))
+        {
+            memcpy(out, (const void *)addr, n);
+        }
+        else
+        {
+            SimHw_DCacheLine_T *line = SimHw_DCacheFind(addr);
+            if (memcmp((const void *)line->addr, line->coherent, SIMHW_DCACHE_LINE) != 0)
+            {
+                g_simHwStats.dcache_dirty_reads++;
+            }
+            memcpy(out, &line->memory[offset], n);
+        }
+        addr += n;
+        out += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief A DMA master writes [addr, addr + size) through the memory system.
+ */
+void SimHw_DCacheDmaWrite(uintptr_t addr, const void *src, size_t size)
+{
+    const uint8_t *in = (const uint8_t *)src;
+
+    while (size != 0U)
+    {
+        size_t offset = addr & (SIMHW_DCACHE_LINE - 1U);
+        size_t n = SIMHW_DCACHE_LINE - offset;
+        n = (n < size) ? n : size;
+
+        if (!SimHw_DCacheCacheable(addr))
+        {
+            memcpy((void *)addr, in, n);
+        }
+        else
+        {
+            memcpy(&SimHw_DCacheFind(addr)->memory[offset], in, n);
+        }
+        addr += n;
+        in += n;
+        size -= n;
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief The data cache holds @p addr: cache enabled, normal cacheable memory.
+ *
+ * Addresses without an enabled MPU region fall in the default memory map,
+ * which makes every RAM cacheable.
+ */
+static bool SimHw_DCacheCacheable(uintptr_t addr)
+{
+    if (((SCB->CCR & SCB_CCR_DC_Msk) == 0U) ||
+        ((addr >= SIMHW_PERIPH_BASE) && (addr < (SIMHW_PERIPH_BASE + SIMHW_PERIPH_SIZE))))
+    {
+        return false;
+    }
+    if (((MPU->CTRL & MPU_CTRL_ENABLE_Msk) == 0U) || (addr > UINT32_MAX))
+    {
+        return true;
+    }
+
+    for (uint32_t i = 0U; i < SIMHW_MPU_REGIONS; i++)
+    {
+        const SimHw_MpuRegion_T *region = &g_simHwDCache.region[i];
+        uint32_t base = region->rbar & MPU_RBAR_BASE_Msk;
+        uint32_t limit = (region->rlar & MPU_RLAR_LIMIT_Msk) | (SIMHW_MPU_GRANULE - 1U);
+
+        if (((region->rlar & MPU_RLAR_EN_Msk) != 0U) && (addr >= base) && (addr <= limit))
+        {
+            uint32_t index = (region->rlar & MPU_RLAR_AttrIndx_Msk) >> MPU_RLAR_AttrIndx_Pos;
+            uint32_t mair = (index < 4U) ? MPU->MAIR0 : MPU->MAIR1;
+            uint32_t attr = (mair >> (8U * (index % 4U))) & 0xFFU;
+
+            /* Device memory has a zero outer nibble, 0b0100 is inner non-cacheable */
+            return ((attr & 0xF0U) != 0U) && ((attr & 0x0FU) != 0x04U);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Line holding @p addr, followed from now on if it was not yet.
+ *
+ * A line starts coherent: memory and the CPU copy both hold what host
+ * memory holds.
+ */
+static SimHw_DCacheLine_T *SimHw_DCacheFind(uintptr_t addr)
+{
+    SimHw_DCache_T *c = &g_simHwDCache;
+    uintptr_t lineAddr = addr & ~(uintptr_t)(SIMHW_DCACHE_LINE - 1U);
+
+    if ((c->last != NULL) && (c->last->addr == lineAddr))
+    {
+        return c->last;
+    }
+    if (c->slots == NULL)
+    {
+        SimHw_DCacheGrow();
+    }
+
+    SimHw_DCacheLine_T *line = &c->slots[SimHw_DCacheSlot(lineAddr, c->slotCount - 1U)];
+    if (line->addr == 0U)
+    {
+        /* Keep the table at most half full */
+        if ((2U * (g_simHwStats.dcache_lines + 1U)) > c->slotCount)
+        {
+            SimHw_DCacheGrow();
+            line = &c->slots[SimHw_DCacheSlot(lineAddr, c->slotCount - 1U)];
+        }
+        line->addr = lineAddr;
+        memcpy(line->memory, (const void *)lineAddr, SIMHW_DCACHE_LINE);
+        memcpy(line->coherent, (const void *)lineAddr, SIMHW_DCACHE_LINE);
+        g_simHwStats.dcache_lines++;
+    }
+    c->last = line;
+    return line;
+}
+
+/**
+ * @brief Slot holding @p addr, or the free slot where it belongs.
+ */
+static size_t SimHw_DCacheSlot(uintptr_t addr, size_t mask)
+{
+    size_t slot = (size_t)(((uint64_t)addr * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+
+    while ((g_simHwDCache.slots[slot].addr != 0U) && (g_simHwDCache.slots[slot].addr != addr))
+    {
+        slot = (slot + 1U) & mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Double the line table, or allocate it.
+ */
+static void SimHw_DCacheGrow(void)
+{
+    SimHw_DCache_T *c = &g_simHwDCache;
+    SimHw_DCacheLine_T *old = c->slots;
+    size_t oldCount = c->slotCount;
+
+    c->slotCount = (oldCount == 0U) ? SIMHW_DCACHE_MIN_SLOTS : (2U * oldCount);
+    c->slots = calloc(c->slotCount, sizeof(SimHw_DCacheLine_T));
+    c->last = NULL;
+    if (c->slots == NULL)
+    {
+        fprintf(stderr, "SimHw: out of memory for the data cache model\n");
+        abort();
+    }
+    for (size_t i = 0U; i < oldCount; i++)
+    {
+        if (old[i].addr != 0U)
+        {
+            c->slots[SimHw_DCacheSlot(old[i].addr, c->slotCount - 1U)] = old[i];
+        }
+    }
+    free(old);
+}
+
+/**
+ * @brief Write a dirty line back to memory.
+ */
+static void SimHw_DCacheClean(SimHw_DCacheLine_T *line)
+{
+    const void *cpu = (const void *)line->addr;
+
+    if (memcmp(cpu, line->coherent, SIMHW_DCACHE_LINE) != 0)
+    {
+        memcpy(line->memory, cpu, SIMHW_DCACHE_LINE);
+        memcpy(line->coherent, cpu, SIMHW_DCACHE_LINE);
+        g_simHwStats.dcache_writebacks++;
+    }
+}
+
+/**
+ * @brief Drop the CPU copy of a line, the next CPU read sees memory.
+ */
+static void SimHw_DCacheInvalidate(SimHw_DCacheLine_T *line)
+{
+    void *cpu = (void *)line->addr;
+
+    if (memcmp(cpu, line->coherent, SIMHW_DCACHE_LINE) != 0)
+    {
+        g_simHwStats.dcache_dirty_drops++;
+    }
+    /* Only store when needed, read-only lines are never rewritten */
+    if (memcmp(cpu, line->memory, SIMHW_DCACHE_LINE) != 0)
+    {
+        memcpy(cpu, line->memory, SIMHW_DCACHE_LINE);
+    }
+    memcpy(line->coherent, line->memory, SIMHW_DCACHE_LINE);
+}
+
+/** @} */ // end of SimHw group
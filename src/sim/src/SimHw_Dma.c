@@ -0,0 +1,512 @@
+/**
+ * @file SimHw_Dma.c
+ * @brief Register-level model of GPDMA1 and HPDMA1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Sixteen channels per controller with peripheral-paced and software
+ * triggered block transfers, linked-list items loaded from memory, the HT,
+ * TC, DTE, ULE, USE and SUSP flags, suspend and channel reset. Destination
+ * beats into peripheral registers go through the owning model, so a DMA store
+ * behaves like a CPU store.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_DMA_CONTROLLERS  (2U)
+#define SIMHW_DMA_CHANNELS     (16U)
+#define SIMHW_DMA_CH_OFFSET(n) (0x50UL + (0x80UL * (n)))
+#define SIMHW_DMA_WINDOW       (0x1000UL)
+
+/** CSR flags that raise the channel interrupt, same bit positions as the CCR enables. */
+#define SIMHW_DMA_IT_FLAGS     (DMA_CSR_TCF | DMA_CSR_HTF | DMA_CSR_DTEF | DMA_CSR_ULEF | \
+                                DMA_CSR_USEF | DMA_CSR_SUSPF | DMA_CSR_TOF)
+
+#define SIMHW_DMA_M2M_SETUP_NS (100U) /**< Fixed cost of a software triggered block */
+#define SIMHW_DMA_FIRST_2D     (12U)  /**< First channel with 2D addressing */
+
+#if (DMA_CCR_TCIE != DMA_CSR_TCF) || (DMA_CCR_DTEIE != DMA_CSR_DTEF) || (DMA_CCR_SUSPIE != DMA_CSR_SUSPF)
+#error "GPDMA CCR interrupt enables no longer line up with the CSR flags"
+#endif
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of one DMA channel.
+ */
+typedef struct
+{
+    DMA_Channel_TypeDef *regs; /**< Register block in the mapped window */
+    IRQn_Type irq;             /**< Channel interrupt line */
+    bool touched;              /**< Accessed by firmware, watched at synchronisation points */
+    uint32_t flags;            /**< CSR event flags owned by the model */
+    bool active;               /**< A block transfer is in progress */
+    bool suspended;            /**< Transfer halted by CCR.SUSP */
+    bool halfDone;             /**< HTF already raised for the current block */
+    bool blockEvents;          /**< HTF/TCF raised for this block, false inside a list with TCEM at its end */
+    bool is2D;                 /**< Items also carry CTR3 and CBR2 (channels 12 to 15) */
+    bool swreq;                /**< Software triggered (memory-to-memory) */
+    uint32_t request;          /**< Hardware request line, CTR2.REQSEL */
+    uintptr_t src;             /**< Source address latched at start */
+    uintptr_t dst;             /**< Destination address latched at start */
+    uint32_t srcWidth;         /**< Source data width in bytes */
+    uint32_t dstWidth;         /**< Destination data width in bytes */
+    bool srcInc;               /**< Source address increments */
+    bool dstInc;               /**< Destination address increments */
+    uint32_t total;            /**< Block size in bytes */
+    uint32_t done;             /**< Bytes moved so far */
+    uint64_t m2mDoneNs;        /**< Completion time of a software triggered block */
+    uint64_t m2mLeftNs;        /**< Remaining duration while suspended */
+} SimHw_DmaChannel_T;
+
+/**
+ * @brief State of one DMA controller.
+ */
+typedef struct
+{
+    uintptr_t base;                                  /**< Controller register base */
+    SimHw_DmaChannel_T channel[SIMHW_DMA_CHANNELS];  /**< Channel models */
+} SimHw_Dma_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Dma_T g_simHwDma[SIMHW_DMA_CONTROLLERS];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static SimHw_DmaChannel_T *SimHw_DmaFind(uintptr_t addr);
+static void SimHw_DmaReconcile(SimHw_DmaChannel_T *ch);
+static void SimHw_DmaStart(SimHw_DmaChannel_T *ch);
+static void SimHw_DmaMove(SimHw_DmaChannel_T *ch, uint32_t count);
+static void SimHw_DmaBlockDone(SimHw_DmaChannel_T *ch);
+static bool SimHw_DmaLoadItem(SimHw_DmaChannel_T *ch);
+static void SimHw_DmaPublish(SimHw_DmaChannel_T *ch);
+static void SimHw_PeriphWriteByte(uintptr_t addr, uint8_t data);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Serve one single-byte request from a peripheral.
+ *
+ * @retval true  A channel on @p request moved a byte.
+ * @retval false No running channel serves the request.
+ */
+bool SimHw_DmaRequest(uint32_t request)
+{
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            SimHw_DmaChannel_T *ch = &g_simHwDma[c].channel[n];
+            if (ch->active && !ch->suspended && !ch->swreq && (ch->request == request))
+            {
+                SimHw_DmaMove(ch, 1U);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Put every channel of both controllers in the reset state.
+ */
+void SimHw_DmaReset(void)
+{
+    static const uintptr_t dmaBase[SIMHW_DMA_CONTROLLERS] = {(uintptr_t)HPDMA1, (uintptr_t)GPDMA1};
+    static const IRQn_Type dmaIrq[SIMHW_DMA_CONTROLLERS] = {HPDMA1_Channel0_IRQn, GPDMA1_Channel0_IRQn};
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        g_simHwDma[c].base = dmaBase[c];
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            SimHw_DmaChannel_T *ch = &g_simHwDma[c].channel[n];
+            memset(ch, 0, sizeof(*ch));
+            ch->regs = (DMA_Channel_TypeDef *)(dmaBase[c] + SIMHW_DMA_CH_OFFSET(n));
+            ch->irq = (IRQn_Type)((int32_t)dmaIrq[c] + (int32_t)n);
+            ch->is2D = (n >= SIMHW_DMA_FIRST_2D);
+            ch->m2mDoneNs = SIMHW_NO_EVENT;
+            SimHw_DmaPublish(ch);
+        }
+    }
+}
+
+/**
+ * @brief Earliest end of a software triggered block.
+ */
+uint64_t SimHw_DmaNextEventNs(void)
+{
+    uint64_t next = SIMHW_NO_EVENT;
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            if (g_simHwDma[c].channel[n].m2mDoneNs < next)
+            {
+                next = g_simHwDma[c].channel[n].m2mDoneNs;
+            }
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Move the software triggered blocks ending at @p now.
+ */
+void SimHw_DmaEvents(uint64_t now)
+{
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            SimHw_DmaChannel_T *ch = &g_simHwDma[c].channel[n];
+            if (ch->m2mDoneNs <= now)
+            {
+                ch->m2mDoneNs = SIMHW_NO_EVENT;
+                SimHw_DmaMove(ch, ch->total - ch->done);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Fold plain register stores of every channel accessed so far.
+ */
+void SimHw_DmaReconcileAll(void)
+{
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            SimHw_DmaChannel_T *ch = &g_simHwDma[c].channel[n];
+            if (ch->touched)
+            {
+                SimHw_DmaReconcile(ch);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Watch the channel owning @p addr from now on and fold its stores.
+ *
+ * @retval true  @p addr lies in a channel register block.
+ * @retval false No DMA channel at @p addr.
+ */
+bool SimHw_DmaReconcileAt(uintptr_t addr)
+{
+    SimHw_DmaChannel_T *ch = SimHw_DmaFind(addr);
+    if (ch == NULL)
+    {
+        return false;
+    }
+    ch->touched = true;
+    SimHw_DmaReconcile(ch);
+    return true;
+}
+
+/**
+ * @brief Raise the interrupt of every channel with an enabled flag set.
+ */
+void SimHw_DmaLines(void)
+{
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        for (uint32_t n = 0U; n < SIMHW_DMA_CHANNELS; n++)
+        {
+            SimHw_DmaChannel_T *ch = &g_simHwDma[c].channel[n];
+            if (ch->touched && ((ch->flags & ch->regs->CCR & SIMHW_DMA_IT_FLAGS) != 0U))
+            {
+                SimHw_SetPending(16U + (uint32_t)ch->irq);
+            }
+        }
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Channel whose register block contains @p addr.
+ */
+static SimHw_DmaChannel_T *SimHw_DmaFind(uintptr_t addr)
+{
+    for (uint32_t c = 0U; c < SIMHW_DMA_CONTROLLERS; c++)
+    {
+        uintptr_t base = g_simHwDma[c].base;
+        if ((addr >= (base + SIMHW_DMA_CH_OFFSET(0U))) && (addr < (base + SIMHW_DMA_WINDOW)))
+        {
+            uint32_t n = (uint32_t)((addr - base - SIMHW_DMA_CH_OFFSET(0U)) / 0x80U);
+            return (n < SIMHW_DMA_CHANNELS) ? &g_simHwDma[c].channel[n] : NULL;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Apply channel register stores: flag clears, reset, suspend, enable.
+ */
+static void SimHw_DmaReconcile(SimHw_DmaChannel_T *ch)
+{
+    DMA_Channel_TypeDef *r = ch->regs;
+
+    uint32_t cfcr = r->CFCR;
+    if (cfcr != 0U)
+    {
+        ch->flags &= ~(cfcr & SIMHW_DMA_IT_FLAGS);
+        r->CFCR = 0U;
+    }
+
+    uint32_t ccr = r->CCR;
+    if ((ccr & DMA_CCR_RESET) != 0U)
+    {
+        ch->active = false;
+        ch->suspended = false;
+        ch->m2mDoneNs = SIMHW_NO_EVENT;
+        ccr &= ~(DMA_CCR_RESET | DMA_CCR_EN | DMA_CCR_SUSP);
+        r->CCR = ccr;
+    }
+
+    if (ch->active)
+    {
+        if (((ccr & DMA_CCR_SUSP) != 0U) && !ch->suspended)
+        {
+            ch->suspended = true;
+            ch->flags |= DMA_CSR_SUSPF;
+            if (ch->m2mDoneNs != SIMHW_NO_EVENT)
+            {
+                ch->m2mLeftNs = ch->m2mDoneNs - g_simHwStats.now_ns;
+                ch->m2mDoneNs = SIMHW_NO_EVENT;
+            }
+        }
+        else if (((ccr & DMA_CCR_SUSP) == 0U) && ch->suspended)
+        {
+            ch->suspended = false;
+            if (ch->swreq)
+            {
+                ch->m2mDoneNs = g_simHwStats.now_ns + ch->m2mLeftNs;
+            }
+        }
+    }
+    else if ((ccr & DMA_CCR_EN) != 0U)
+    {
+        SimHw_DmaStart(ch);
+    }
+
+    SimHw_DmaPublish(ch);
+}
+
+/**
+ * @brief Latch the channel configuration and start a block transfer.
+ *
+ * Misconfigured blocks raise USE, unreachable addresses and injected
+ * faults raise DTE. Either error disables the channel like the hardware.
+ */
+static void SimHw_DmaStart(SimHw_DmaChannel_T *ch)
+{
+    DMA_Channel_TypeDef *r = ch->regs;
+    uint32_t ctr1 = r->CTR1;
+    uint32_t ctr2 = r->CTR2;
+
+    ch->srcWidth = 1UL << ((ctr1 & DMA_CTR1_SDW_LOG2) >> DMA_CTR1_SDW_LOG2_Pos);
+    ch->dstWidth = 1UL << ((ctr1 & DMA_CTR1_DDW_LOG2) >> DMA_CTR1_DDW_LOG2_Pos);
+    ch->srcInc = (ctr1 & DMA_CTR1_SINC) != 0U;
+    ch->dstInc = (ctr1 & DMA_CTR1_DINC) != 0U;
+    ch->swreq = (ctr2 & DMA_CTR2_SWREQ) != 0U;
+    ch->request = ctr2 & DMA_CTR2_REQSEL;
+    ch->src = (uintptr_t)r->CSAR;
+    ch->dst = (uintptr_t)r->CDAR;
+    ch->total = r->CBR1 & DMA_CBR1_BNDT;
+    ch->done = 0U;
+    ch->halfDone = false;
+    ch->suspended = false;
+    ch->blockEvents = ((r->CLLR & DMA_CLLR_LA) == 0U) || ((ctr2 & DMA_CTR2_TCEM) != DMA_CTR2_TCEM);
+    g_simHwStats.dma_starts++;
+
+    uint32_t error = 0U;
+    if ((ch->total == 0U) || ((ch->total % ch->srcWidth) != 0U) || ((ch->total % ch->dstWidth) != 0U))
+    {
+        error = DMA_CSR_USEF;
+    }
+    else if ((g_simHwConfig.dte_every != 0U) && ((g_simHwStats.dma_starts % g_simHwConfig.dte_every) == 0U))
+    {
+        error = DMA_CSR_DTEF;
+    }
+    else if (!SimHw_IsReachable(ch->src, ch->srcInc ? ch->total : ch->srcWidth) ||
+             !SimHw_IsReachable(ch->dst, ch->dstInc ? ch->total : ch->dstWidth))
+    {
+        error = DMA_CSR_DTEF;
+    }
+
+    if (error != 0U)
+    {
+        ch->flags |= error;
+        r->CCR &= ~DMA_CCR_EN;
+        g_simHwStats.dma_errors++;
+        return;
+    }
+
+    ch->active = true;
+    ch->m2mDoneNs = SIMHW_NO_EVENT;
+    if (ch->swreq)
+    {
+        ch->m2mDoneNs = g_simHwStats.now_ns + SIMHW_DMA_M2M_SETUP_NS +
+                        (((uint64_t)ch->total * 1000U) / g_simHwConfig.m2m_bytes_per_us);
+    }
+}
+
+/**
+ * @brief Move @p count bytes of the current block.
+ *
+ * Data is handled as a byte stream: a fixed source repeats one source
+ * beat, a fixed destination receives every destination beat at the same
+ * address. Peripheral destinations are delivered to their model, memory
+ * is accessed through the data cache model.
+ */
+static void SimHw_DmaMove(SimHw_DmaChannel_T *ch, uint32_t count)
+{
+    for (uint32_t k = 0U; k < count; k++)
+    {
+        uint32_t idx = ch->done + k;
+        uintptr_t srcAddr = ch->src + (ch->srcInc ? idx : (idx % ch->srcWidth));
+        uintptr_t dstAddr = ch->dst + (ch->dstInc ? idx : (idx % ch->dstWidth));
+        uint8_t data;
+
+        if ((srcAddr >= SIMHW_PERIPH_BASE) && (srcAddr < (SIMHW_PERIPH_BASE + SIMHW_PERIPH_SIZE)))
+        {
+            data = *(const volatile uint8_t *)srcAddr;
+        }
+        else
+        {
+            SimHw_DCacheDmaRead(srcAddr, &data, 1U);
+        }
+        if ((dstAddr >= SIMHW_PERIPH_BASE) && (dstAddr < (SIMHW_PERIPH_BASE + SIMHW_PERIPH_SIZE)))
+        {
+            SimHw_PeriphWriteByte(dstAddr, data);
+        }
+        else
+        {
+            SimHw_DCacheDmaWrite(dstAddr, &data, 1U);
+        }
+    }
+    ch->done += count;
+    g_simHwStats.dma_bytes += count;
+
+    /* Live remaining length and addresses, as read back on silicon */
+    DMA_Channel_TypeDef *r = ch->regs;
+    r->CBR1 = (r->CBR1 & ~DMA_CBR1_BNDT) | ((ch->total - ch->done) & DMA_CBR1_BNDT);
+    r->CSAR = (uint32_t)(ch->src + (ch->srcInc ? ch->done : 0U));
+    r->CDAR = (uint32_t)(ch->dst + (ch->dstInc ? ch->done : 0U));
+
+    if (!ch->halfDone && (ch->done >= (ch->total / 2U)))
+    {
+        ch->halfDone = true;
+        ch->flags |= ch->blockEvents ? DMA_CSR_HTF : 0U;
+    }
+    if (ch->done >= ch->total)
+    {
+        SimHw_DmaBlockDone(ch);
+    }
+    SimHw_DmaPublish(ch);
+}
+
+/**
+ * @brief End of a block: raise TC and continue with the next list item.
+ *
+ * The channel stays enabled while CLLR links to another item. An item the
+ * channel cannot read raises ULE and disables the channel.
+ */
+static void SimHw_DmaBlockDone(SimHw_DmaChannel_T *ch)
+{
+    DMA_Channel_TypeDef *r = ch->regs;
+
+    ch->active = false;
+    ch->m2mDoneNs = SIMHW_NO_EVENT;
+    ch->flags |= ch->blockEvents ? DMA_CSR_TCF : 0U;
+
+    if ((r->CLLR & DMA_CLLR_LA) == 0U)
+    {
+        r->CCR &= ~DMA_CCR_EN;
+    }
+    else if (SimHw_DmaLoadItem(ch))
+    {
+        SimHw_DmaStart(ch);
+    }
+    else
+    {
+        ch->flags |= DMA_CSR_ULEF;
+        r->CCR &= ~DMA_CCR_EN;
+        g_simHwStats.dma_errors++;
+    }
+}
+
+/**
+ * @brief Load the registers flagged in CLLR from the next list item.
+ *
+ * Words are read in register order, CTR3 and CBR2 only on 2D channels. A
+ * CLLR that is not reloaded ends the list after this item.
+ *
+ * @retval true  Item loaded.
+ * @retval false Item outside DMA-reachable memory.
+ */
+static bool SimHw_DmaLoadItem(SimHw_DmaChannel_T *ch)
+{
+    DMA_Channel_TypeDef *r = ch->regs;
+    uint32_t cllr = r->CLLR;
+    volatile uint32_t *const reg[] = {&r->CTR1, &r->CTR2, &r->CBR1, &r->CSAR,
+                                      &r->CDAR, &r->CTR3, &r->CBR2, &r->CLLR};
+    static const uint32_t update[] = {DMA_CLLR_UT1, DMA_CLLR_UT2, DMA_CLLR_UB1, DMA_CLLR_USA,
+                                      DMA_CLLR_UDA, DMA_CLLR_UT3, DMA_CLLR_UB2, DMA_CLLR_ULL};
+    uint32_t mask = cllr & (DMA_CLLR_UT1 | DMA_CLLR_UT2 | DMA_CLLR_UB1 | DMA_CLLR_USA |
+                            DMA_CLLR_UDA | DMA_CLLR_UT3 | DMA_CLLR_UB2 | DMA_CLLR_ULL);
+    if (!ch->is2D)
+    {
+        mask &= ~(DMA_CLLR_UT3 | DMA_CLLR_UB2);
+    }
+
+    uintptr_t addr = (uintptr_t)((r->CLBAR & DMA_CLBAR_LBA) | (cllr & DMA_CLLR_LA));
+    size_t size = (size_t)__builtin_popcount(mask) * sizeof(uint32_t);
+    if (!SimHw_IsReachable(addr, size))
+    {
+        return false;
+    }
+
+    uint32_t words[sizeof(update) / sizeof(update[0])];
+    const uint32_t *item = words;
+    SimHw_DCacheDmaRead(addr, words, size);
+    if ((mask & DMA_CLLR_ULL) == 0U)
+    {
+        r->CLLR = 0U;
+    }
+    for (uint32_t i = 0U; i < (sizeof(update) / sizeof(update[0])); i++)
+    {
+        if ((mask & update[i]) != 0U)
+        {
+            *reg[i] = *item++;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Publish CSR, IDLEF is set unless a block is moving.
+ */
+static void SimHw_DmaPublish(SimHw_DmaChannel_T *ch)
+{
+    bool idle = !ch->active || ch->suspended;
+    ch->regs->CSR = ch->flags | (idle ? DMA_CSR_IDLEF : 0U);
+}
+
+/**
+ * @brief Deliver a DMA write to a peripheral register.
+ *
+ * The bytes of a word beat into the CRC data register or a GPIO port
+ * register are collected and applied as one 32-bit write.
+ */
+static void SimHw_PeriphWriteByte(uintptr_t addr, uint8_t data)
+{
+    if (!SimHw_UsartDmaWrite(addr, data) && !SimHw_SpiDmaWrite(addr, data) && !SimHw_I2cDmaWrite(addr, data) &&
+        !SimHw_I3cDmaWrite(addr, data) && !SimHw_CrcDmaWrite(addr, data) && !SimHw_GpioDmaWrite(addr, data))
+    {
+        *(volatile uint8_t *)addr = data;
+    }
+}
+
+/** @} */ // end of SimHw group
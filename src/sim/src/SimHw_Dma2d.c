@@ -0,0 +1,392 @@
+/**
+ * @file SimHw_Dma2d.c
+ * @brief Register-level model of DMA2D.
+ * @ingroup SimHw
+ * @{
+ *
+ * Memory-to-memory transfers with and without pixel-format conversion,
+ * blending and register-to-memory fills on the direct colour modes,
+ * completing after the time the accelerator would take.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_DMA2D_SETUP_NS   (200U) /**< Fixed cost of a DMA2D transfer */
+#define SIMHW_DMA2D_IT_SHIFT   (8U)   /**< CR interrupt enables sit 8 bits above the ISR flags */
+
+#define SIMHW_DMA2D_IT_FLAGS   (DMA2D_ISR_TEIF | DMA2D_ISR_TCIF | DMA2D_ISR_TWIF | DMA2D_ISR_CAEIF | \
+                                DMA2D_ISR_CTCIF | DMA2D_ISR_CEIF)
+
+#define SIMHW_DMA2D_ROW_MAX    ((DMA2D_NLR_PL >> DMA2D_NLR_PL_Pos) * 4U) /**< Largest line, in bytes */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the DMA2D.
+ */
+typedef struct
+{
+    DMA2D_TypeDef *regs; /**< Register block in the mapped window */
+    uint32_t flags;      /**< ISR flags owned by the model */
+    bool active;         /**< A transfer is in progress */
+    uint64_t doneNs;     /**< Completion time of the transfer */
+} SimHw_Dma2d_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Dma2d_T g_simHwDma2d;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_Dma2dStart(void);
+static void SimHw_Dma2dRun(void);
+static uint32_t SimHw_Dma2dLoad(uint32_t pfccr, const uint8_t *pixel);
+static void SimHw_Dma2dStore(uint32_t opfccr, uint8_t *pixel, uint32_t argb);
+static uint32_t SimHw_Dma2dBytesPerPixel(uint32_t cm);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply DMA2D register stores: flag clears, abort and start.
+ */
+void SimHw_Dma2dReconcile(void)
+{
+    SimHw_Dma2d_T *d = &g_simHwDma2d;
+    DMA2D_TypeDef *r = d->regs;
+
+    uint32_t ifcr = r->IFCR;
+    if (ifcr != 0U)
+    {
+        d->flags &= ~(ifcr & SIMHW_DMA2D_IT_FLAGS);
+        r->IFCR = 0U;
+    }
+
+    uint32_t cr = r->CR;
+    if ((cr & DMA2D_CR_ABORT) != 0U)
+    {
+        d->active = false;
+        d->doneNs = SIMHW_NO_EVENT;
+        r->CR = cr & ~(DMA2D_CR_ABORT | DMA2D_CR_START);
+    }
+    else if (((cr & DMA2D_CR_START) != 0U) && !d->active)
+    {
+        SimHw_Dma2dStart();
+    }
+
+    r->ISR = d->flags;
+}
+
+/**
+ * @brief Put DMA2D in the reset state.
+ */
+void SimHw_Dma2dReset(void)
+{
+    memset(&g_simHwDma2d, 0, sizeof(g_simHwDma2d));
+    g_simHwDma2d.regs = DMA2D;
+    g_simHwDma2d.doneNs = SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief End of the running transfer.
+ */
+uint64_t SimHw_Dma2dNextEventNs(void)
+{
+    return g_simHwDma2d.doneNs;
+}
+
+/**
+ * @brief Complete the transfer ending at @p now.
+ */
+void SimHw_Dma2dEvents(uint64_t now)
+{
+    if (g_simHwDma2d.doneNs <= now)
+    {
+        SimHw_Dma2dRun();
+    }
+}
+
+/**
+ * @brief Raise the DMA2D interrupt while an enabled flag is set.
+ */
+void SimHw_Dma2dLines(void)
+{
+    uint32_t dma2dIt = g_simHwDma2d.regs->CR >> SIMHW_DMA2D_IT_SHIFT;
+    if ((g_simHwDma2d.flags & dma2dIt & SIMHW_DMA2D_IT_FLAGS) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)DMA2D_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Check the DMA2D configuration and schedule the transfer.
+ *
+ * Modes, colour modes and misaligned 16/32-bit areas the model does not
+ * run raise CE, areas outside DMA-reachable memory raise TE. Blending
+ * with a fixed colour, CLUT formats and YCbCr are not modelled.
+ */
+static void SimHw_Dma2dStart(void)
+{
+    SimHw_Dma2d_T *d = &g_simHwDma2d;
+    DMA2D_TypeDef *r = d->regs;
+    uint32_t mode = (r->CR & DMA2D_CR_MODE) >> DMA2D_CR_MODE_Pos;
+    bool lomBytes = (r->CR & DMA2D_CR_LOM) != 0U;
+    uint32_t pl = (r->NLR & DMA2D_NLR_PL) >> DMA2D_NLR_PL_Pos;
+    uint32_t nl = (r->NLR & DMA2D_NLR_NL) >> DMA2D_NLR_NL_Pos;
+    uint32_t outCm = (mode == 0U) ? (r->FGPFCCR & DMA2D_FGPFCCR_CM) : (r->OPFCCR & DMA2D_OPFCCR_CM);
+    uint32_t error = 0U;
+
+    const struct
+    {
+        uint32_t addr;
+        uint32_t offset;
+        uint32_t cm;
+        bool used;
+    } area[] = {
+        {r->FGMAR, r->FGOR & DMA2D_FGOR_LO, r->FGPFCCR & DMA2D_FGPFCCR_CM, mode != 3U},
+        {r->BGMAR, r->BGOR & DMA2D_BGOR_LO, r->BGPFCCR & DMA2D_BGPFCCR_CM, mode == 2U},
+        {r->OMAR, r->OOR & DMA2D_OOR_LO, outCm, true},
+    };
+
+    if ((mode > 3U) || (pl == 0U) || (nl == 0U))
+    {
+        error = DMA2D_ISR_CEIF;
+    }
+    for (uint32_t i = 0U; (i < (sizeof(area) / sizeof(area[0]))) && (error == 0U); i++)
+    {
+        uint32_t bpp = SimHw_Dma2dBytesPerPixel(area[i].cm);
+        if (!area[i].used)
+        {
+            continue;
+        }
+        if ((bpp == 0U) || ((bpp != 3U) && ((area[i].addr % bpp) != 0U)))
+        {
+            error = DMA2D_ISR_CEIF;
+            break;
+        }
+        size_t stride = lomBytes ? (((size_t)pl * bpp) + area[i].offset) : ((size_t)(pl + area[i].offset) * bpp);
+        if (!SimHw_IsReachable(area[i].addr, (stride * (nl - 1U)) + ((size_t)pl * bpp)))
+        {
+            error = DMA2D_ISR_TEIF;
+        }
+    }
+
+    if (error != 0U)
+    {
+        d->flags |= error;
+        r->CR &= ~DMA2D_CR_START;
+        return;
+    }
+
+    d->active = true;
+    d->doneNs = g_simHwStats.now_ns + SIMHW_DMA2D_SETUP_NS +
+                (((uint64_t)pl * nl * 1000U) / g_simHwConfig.dma2d_pixels_per_us);
+}
+
+/**
+ * @brief Run the scheduled DMA2D transfer and raise TC.
+ *
+ * Lines are read and written through the data cache model, as the DMA2D
+ * master sees memory.
+ */
+static void SimHw_Dma2dRun(void)
+{
+    SimHw_Dma2d_T *d = &g_simHwDma2d;
+    DMA2D_TypeDef *r = d->regs;
+    uint32_t mode = (r->CR & DMA2D_CR_MODE) >> DMA2D_CR_MODE_Pos;
+    bool lomBytes = (r->CR & DMA2D_CR_LOM) != 0U;
+    uint32_t pl = (r->NLR & DMA2D_NLR_PL) >> DMA2D_NLR_PL_Pos;
+    uint32_t nl = (r->NLR & DMA2D_NLR_NL) >> DMA2D_NLR_NL_Pos;
+    uint32_t fgBpp = SimHw_Dma2dBytesPerPixel(r->FGPFCCR & DMA2D_FGPFCCR_CM);
+    uint32_t bgBpp = SimHw_Dma2dBytesPerPixel(r->BGPFCCR & DMA2D_BGPFCCR_CM);
+    uint32_t outBpp = (mode == 0U) ? fgBpp : SimHw_Dma2dBytesPerPixel(r->OPFCCR & DMA2D_OPFCCR_CM);
+    size_t fgStride = lomBytes ? (((size_t)pl * fgBpp) + (r->FGOR & DMA2D_FGOR_LO))
+                               : ((size_t)(pl + (r->FGOR & DMA2D_FGOR_LO)) * fgBpp);
+    size_t bgStride = lomBytes ? (((size_t)pl * bgBpp) + (r->BGOR & DMA2D_BGOR_LO))
+                               : ((size_t)(pl + (r->BGOR & DMA2D_BGOR_LO)) * bgBpp);
+    size_t outStride = lomBytes ? (((size_t)pl * outBpp) + (r->OOR & DMA2D_OOR_LO))
+                                : ((size_t)(pl + (r->OOR & DMA2D_OOR_LO)) * outBpp);
+
+    static uint8_t fg[SIMHW_DMA2D_ROW_MAX];
+    static uint8_t bg[SIMHW_DMA2D_ROW_MAX];
+    static uint8_t out[SIMHW_DMA2D_ROW_MAX];
+
+    for (uint32_t y = 0U; y < nl; y++)
+    {
+        if (mode != 3U)
+        {
+            SimHw_DCacheDmaRead((uintptr_t)r->FGMAR + (y * fgStride), fg, (size_t)pl * fgBpp);
+        }
+        if (mode == 2U)
+        {
+            SimHw_DCacheDmaRead((uintptr_t)r->BGMAR + (y * bgStride), bg, (size_t)pl * bgBpp);
+        }
+
+        for (uint32_t x = 0U; x < pl; x++)
+        {
+            if (mode == 0U)
+            {
+                for (uint32_t k = 0U; k < outBpp; k++)
+                {
+                    out[(x * outBpp) + k] = fg[(x * fgBpp) + k];
+                }
+                continue;
+            }
+            if (mode == 3U)
+            {
+                for (uint32_t k = 0U; k < outBpp; k++)
+                {
+                    out[(x * outBpp) + k] = (uint8_t)(r->OCOLR >> (8U * k));
+                }
+                continue;
+            }
+
+            uint32_t f = SimHw_Dma2dLoad(r->FGPFCCR, fg + (x * fgBpp));
+            if (mode == 2U)
+            {
+                uint32_t b = SimHw_Dma2dLoad(r->BGPFCCR, bg + (x * bgBpp));
+                uint32_t af = f >> 24;
+                uint32_t ab = b >> 24;
+                uint32_t am = (af * ab) / 255U;
+                uint32_t ao = af + ab - am;
+                uint32_t blended = 0U;
+                for (uint32_t shift = 0U; (shift < 24U) && (ao != 0U); shift += 8U)
+                {
+                    uint32_t cf = (f >> shift) & 0xFFU;
+                    uint32_t cb = (b >> shift) & 0xFFU;
+                    blended |= (((cf * af) + (cb * ab) - (cb * am)) / ao) << shift;
+                }
+                f = (ao != 0U) ? (blended | (ao << 24)) : 0U;
+            }
+            SimHw_Dma2dStore(r->OPFCCR, out + (x * outBpp), f);
+        }
+        SimHw_DCacheDmaWrite((uintptr_t)r->OMAR + (y * outStride), out, (size_t)pl * outBpp);
+    }
+
+    d->active = false;
+    d->doneNs = SIMHW_NO_EVENT;
+    d->flags |= DMA2D_ISR_TCIF;
+    r->CR &= ~DMA2D_CR_START;
+    r->ISR = d->flags;
+    g_simHwStats.dma2d_pixels += (uint64_t)pl * nl;
+}
+
+/**
+ * @brief Read one input pixel as ARGB8888 through its PFC settings.
+ *
+ * Channels are widened by bit replication, then red and blue swapped and
+ * the alpha mode applied.
+ */
+static uint32_t SimHw_Dma2dLoad(uint32_t pfccr, const uint8_t *pixel)
+{
+    uint32_t v = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8);
+    uint32_t a = 0xFFU;
+    uint32_t c[3]; /* blue, green, red */
+
+    switch (pfccr & DMA2D_FGPFCCR_CM)
+    {
+    case 0U: /* ARGB8888 */
+        a = pixel[3];
+        c[0] = pixel[0];
+        c[1] = pixel[1];
+        c[2] = pixel[2];
+        break;
+    case 1U: /* RGB888 */
+        c[0] = pixel[0];
+        c[1] = pixel[1];
+        c[2] = pixel[2];
+        break;
+    case 2U: /* RGB565 */
+        c[0] = ((v & 0x1FU) << 3) | ((v & 0x1FU) >> 2);
+        c[1] = (((v >> 5) & 0x3FU) << 2) | (((v >> 5) & 0x3FU) >> 4);
+        c[2] = ((v >> 11) << 3) | ((v >> 11) >> 2);
+        break;
+    case 3U: /* ARGB1555 */
+        a = ((v & 0x8000U) != 0U) ? 0xFFU : 0U;
+        c[0] = ((v & 0x1FU) << 3) | ((v & 0x1FU) >> 2);
+        c[1] = (((v >> 5) & 0x1FU) << 3) | (((v >> 5) & 0x1FU) >> 2);
+        c[2] = (((v >> 10) & 0x1FU) << 3) | (((v >> 10) & 0x1FU) >> 2);
+        break;
+    default: /* ARGB4444 */
+        a = ((v >> 12) & 0xFU) * 0x11U;
+        c[0] = (v & 0xFU) * 0x11U;
+        c[1] = ((v >> 4) & 0xFU) * 0x11U;
+        c[2] = ((v >> 8) & 0xFU) * 0x11U;
+        break;
+    }
+
+    if ((pfccr & DMA2D_FGPFCCR_RBS) != 0U)
+    {
+        uint32_t t = c[0];
+        c[0] = c[2];
+        c[2] = t;
+    }
+
+    uint32_t alpha = (pfccr & DMA2D_FGPFCCR_ALPHA) >> DMA2D_FGPFCCR_ALPHA_Pos;
+    switch ((pfccr & DMA2D_FGPFCCR_AM) >> DMA2D_FGPFCCR_AM_Pos)
+    {
+    case 1U:
+        a = alpha;
+        break;
+    case 2U:
+        a = (a * alpha) / 255U;
+        break;
+    default:
+        break;
+    }
+
+    return (a << 24) | (c[2] << 16) | (c[1] << 8) | c[0];
+}
+
+/**
+ * @brief Write one ARGB8888 pixel in the output colour mode.
+ */
+static void SimHw_Dma2dStore(uint32_t opfccr, uint8_t *pixel, uint32_t argb)
+{
+    uint32_t a = argb >> 24;
+    uint32_t r = (argb >> 16) & 0xFFU;
+    uint32_t g = (argb >> 8) & 0xFFU;
+    uint32_t b = argb & 0xFFU;
+    uint32_t v;
+
+    if ((opfccr & DMA2D_OPFCCR_RBS) != 0U)
+    {
+        uint32_t t = r;
+        r = b;
+        b = t;
+    }
+
+    switch (opfccr & DMA2D_OPFCCR_CM)
+    {
+    case 0U:
+        v = (a << 24) | (r << 16) | (g << 8) | b;
+        pixel[2] = (uint8_t)(v >> 16);
+        pixel[3] = (uint8_t)(v >> 24);
+        break;
+    case 1U:
+        v = (r << 16) | (g << 8) | b;
+        pixel[2] = (uint8_t)(v >> 16);
+        break;
+    case 2U:
+        v = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        break;
+    case 3U:
+        v = ((a >> 7) << 15) | ((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3);
+        break;
+    default:
+        v = ((a >> 4) << 12) | ((r >> 4) << 8) | ((g >> 4) << 4) | (b >> 4);
+        break;
+    }
+    pixel[0] = (uint8_t)v;
+    pixel[1] = (uint8_t)(v >> 8);
+}
+
+/**
+ * @brief Bytes per pixel of a direct colour mode, 0 for the others.
+ */
+static uint32_t SimHw_Dma2dBytesPerPixel(uint32_t cm)
+{
+    static const uint32_t bpp[] = {4U, 3U, 2U, 2U, 2U};
+    return (cm < (sizeof(bpp) / sizeof(bpp[0]))) ? bpp[cm] : 0U;
+}
+
+/** @} */ // end of SimHw group
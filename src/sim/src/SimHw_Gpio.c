@@ -0,0 +1,353 @@
+/**
+ * @file SimHw_Gpio.c
+ * @brief Register-level model of the GPIO ports and EXTI lines 0 to 15.
+ * @ingroup SimHw
+ * @{
+ *
+ * BSRR and BRR applied to ODR from the CPU or DMA word beats and mirrored
+ * into IDR, inputs held at levels scheduled from outside and level changes of
+ * chosen pins recorded with their time. EXTI routes each line to a port
+ * through EXTICR, latches rising and falling edges in W1C pending registers
+ * and raises EXTIn through IMR1.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_NOR_CS_PORT      GPIOA      /**< Port of the NOR flash chip select */
+#define SIMHW_NOR_CS_PIN       (4U)       /**< NOR flash chip select, PA4 */
+#define SIMHW_GPIO_EDGES       (8192U)    /**< Level changes kept by the GPIO probe */
+#define SIMHW_GPIO_PORTS       (((GPIOQ_BASE - GPIOA_BASE) / 0x400U) + 1U) /**< Port slots from GPIOA to GPIOQ */
+#define SIMHW_GPIO_DRIVES      (1024U)    /**< Input level changes waiting for their time */
+#define SIMHW_EXTI_LINES       (16U)      /**< GPIO lines of the EXTI, one per pin number */
+#define SIMHW_EXTI_NO_PORT     (0xFFU)    /**< EXTICR code of a port slot the EXTI cannot route */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Input level change scheduled from outside.
+ */
+typedef struct
+{
+    uint64_t ns;   /**< Virtual time of the change */
+    uint8_t port;  /**< Port slot, 0 for GPIOA */
+    uint8_t pin;   /**< Pin number */
+    bool level;    /**< Level driven from then on */
+} SimHw_GpioDrive_T;
+
+/**
+ * @brief GPIO ports: DMA word assembly, inputs driven from outside and the level probe.
+ */
+typedef struct
+{
+    uint8_t pending[4];     /**< Bytes of the word beat a DMA is writing to a port register */
+    uint16_t drivenPins[SIMHW_GPIO_PORTS];   /**< Pins held from outside per port, IDR follows them instead of ODR */
+    uint16_t drivenLevels[SIMHW_GPIO_PORTS]; /**< Levels they are held at */
+    uint32_t driveCount;    /**< Entries in @ref drives */
+    SimHw_GpioDrive_T drives[SIMHW_GPIO_DRIVES]; /**< Changes to come, earliest first */
+    GPIO_TypeDef *probePort; /**< Port watched, NULL when off */
+    uint16_t probePins;     /**< Pins watched */
+    uint16_t probeLevels;   /**< Last level recorded */
+    uint32_t edgeCount;     /**< Entries in @ref edges */
+    uint32_t edgesLost;     /**< Changes that found @ref edges full */
+    SimHw_GpioEdge_T edges[SIMHW_GPIO_EDGES]; /**< Level changes of the watched pins */
+} SimHw_Gpio_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Gpio_T g_simHwGpio;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_GpioApply(const SimHw_GpioDrive_T *drive);
+static void SimHw_ExtiEdges(uint32_t slot, uint16_t changed, uint16_t levels);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Start recording the level changes of @p pins on @p port, dropping earlier records.
+ */
+void SimHw_GpioProbe(const volatile void *port, uint16_t pins)
+{
+    SimHw_Gpio_T *g = &g_simHwGpio;
+
+    g->probePort = (GPIO_TypeDef *)(uintptr_t)port;
+    g->probePins = pins;
+    g->probeLevels = (port != NULL) ? (uint16_t)(g->probePort->ODR & pins) : 0U;
+    g->edgeCount = 0U;
+    g->edgesLost = 0U;
+}
+
+/**
+ * @brief Hold an input at a level from a given time on.
+ *
+ * Changes at the same time apply in the order they were scheduled.
+ */
+bool SimHw_GpioDrive(const volatile void *port, uint8_t pin, bool level, uint64_t atNs)
+{
+    SimHw_Gpio_T *g = &g_simHwGpio;
+    uintptr_t addr = (uintptr_t)port;
+
+    if ((addr < GPIOA_BASE) || (addr > GPIOQ_BASE) || (((addr - GPIOA_BASE) % 0x400U) != 0U) || (pin >= 16U) ||
+        (g->driveCount == SIMHW_GPIO_DRIVES))
+    {
+        return false;
+    }
+
+    SimHw_GpioDrive_T drive = {atNs, (uint8_t)((addr - GPIOA_BASE) / 0x400U), pin, level};
+    if (atNs <= g_simHwStats.now_ns)
+    {
+        g_simHwInModel = true;
+        SimHw_GpioApply(&drive);
+        g_simHwInModel = false;
+        return true;
+    }
+
+    uint32_t at = g->driveCount;
+    while ((at != 0U) && (g->drives[at - 1U].ns > atNs))
+    {
+        g->drives[at] = g->drives[at - 1U];
+        at--;
+    }
+    g->drives[at] = drive;
+    g->driveCount++;
+    return true;
+}
+
+/**
+ * @brief Copy the level changes recorded since ::SimHw_GpioProbe, oldest first.
+ */
+uint32_t SimHw_GpioEdges(SimHw_GpioEdge_T *edges, uint32_t max, uint32_t *lost)
+{
+    uint32_t count = (g_simHwGpio.edgeCount < max) ? g_simHwGpio.edgeCount : max;
+
+    for (uint32_t i = 0U; (edges != NULL) && (i < count); i++)
+    {
+        edges[i] = g_simHwGpio.edges[i];
+    }
+    if (lost != NULL)
+    {
+        *lost = g_simHwGpio.edgesLost;
+    }
+    return count;
+}
+
+/**
+ * @brief Apply a BSRR or BRR store to ODR.
+ *
+ * @retval true  @p addr is a set/reset register of a GPIO port.
+ * @retval false Any other register, written as plain memory.
+ */
+bool SimHw_GpioWrite(uintptr_t addr, uint32_t value)
+{
+    if ((addr < (uintptr_t)GPIOA) || (addr >= ((uintptr_t)GPIOQ + sizeof(GPIO_TypeDef))))
+    {
+        return false;
+    }
+
+    GPIO_TypeDef *port = (GPIO_TypeDef *)(addr & ~(uintptr_t)0x3FFU);
+    if (addr == (uintptr_t)&port->BSRR)
+    {
+        port->ODR = (port->ODR & ~(value >> 16)) | (value & 0xFFFFU);
+    }
+    else if (addr == (uintptr_t)&port->BRR)
+    {
+        port->ODR &= ~(value & 0xFFFFU);
+    }
+    else
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    SimHw_GpioReconcile(port);
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Rebuild IDR, record level changes of the probed pins and follow the NOR flash chip select.
+ *
+ * IDR mirrors ODR except on the pins held from outside; its changes reach
+ * the EXTI. The chip select counts as low only while its pin is a
+ * push-pull output.
+ */
+void SimHw_GpioReconcile(GPIO_TypeDef *port)
+{
+    SimHw_Gpio_T *g = &g_simHwGpio;
+    uint32_t slot = ((uint32_t)(uintptr_t)port - GPIOA_BASE) / 0x400U;
+
+    uint16_t before = (uint16_t)port->IDR;
+    uint16_t levels = (uint16_t)((port->ODR & ~g->drivenPins[slot]) | g->drivenLevels[slot]);
+    port->IDR = levels;
+    if (levels != before)
+    {
+        SimHw_ExtiEdges(slot, (uint16_t)(levels ^ before), levels);
+    }
+
+    uint16_t probed = (uint16_t)(port->ODR & g->probePins);
+    if ((port == g->probePort) && (probed != g->probeLevels))
+    {
+        g->probeLevels = probed;
+        g_simHwStats.gpio_edges++;
+        if (g->edgeCount < SIMHW_GPIO_EDGES)
+        {
+            g->edges[g->edgeCount].ns = g_simHwStats.now_ns;
+            g->edges[g->edgeCount].levels = probed;
+            g->edgeCount++;
+        }
+        else
+        {
+            g->edgesLost++;
+        }
+    }
+
+    if (port == SIMHW_NOR_CS_PORT)
+    {
+        bool output = ((port->MODER >> (2U * SIMHW_NOR_CS_PIN)) & 3U) == 1U;
+        bool low = (port->ODR & (1UL << SIMHW_NOR_CS_PIN)) == 0U;
+        SimHw_NorSelect(output && low);
+    }
+}
+
+/**
+ * @brief Apply the write-one-to-clear pending registers of the EXTI.
+ *
+ * @retval true  @p addr is RPRx or FPRx.
+ * @retval false Any other register, written as plain memory.
+ */
+bool SimHw_ExtiWrite(uintptr_t addr, uint32_t value)
+{
+    volatile uint32_t *const w1c[] = {&EXTI->RPR1, &EXTI->FPR1, &EXTI->RPR2, &EXTI->FPR2, &EXTI->RPR3, &EXTI->FPR3};
+
+    for (uint32_t i = 0U; i < (sizeof(w1c) / sizeof(w1c[0])); i++)
+    {
+        if (addr == (uintptr_t)w1c[i])
+        {
+            *w1c[i] &= ~value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Release every driven input and stop the probe.
+ */
+void SimHw_GpioReset(void)
+{
+    memset(&g_simHwGpio, 0, sizeof(g_simHwGpio));
+}
+
+/**
+ * @brief Time of the earliest scheduled input change.
+ */
+uint64_t SimHw_GpioNextEventNs(void)
+{
+    return (g_simHwGpio.driveCount != 0U) ? g_simHwGpio.drives[0].ns : SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief Apply the input changes due at @p now, earliest first.
+ */
+void SimHw_GpioEvents(uint64_t now)
+{
+    while ((g_simHwGpio.driveCount != 0U) && (g_simHwGpio.drives[0].ns <= now))
+    {
+        SimHw_GpioDrive_T drive = g_simHwGpio.drives[0];
+        g_simHwGpio.driveCount--;
+        memmove(&g_simHwGpio.drives[0], &g_simHwGpio.drives[1], g_simHwGpio.driveCount * sizeof(drive));
+        SimHw_GpioApply(&drive);
+    }
+}
+
+/**
+ * @brief Take a DMA write to a port register, applied once the word is complete.
+ *
+ * @retval true  @p addr lies in a GPIO port.
+ * @retval false Not a GPIO register.
+ */
+bool SimHw_GpioDmaWrite(uintptr_t addr, uint8_t data)
+{
+    if ((addr < (uintptr_t)GPIOA) || (addr >= ((uintptr_t)GPIOQ + sizeof(GPIO_TypeDef))))
+    {
+        return false;
+    }
+    g_simHwGpio.pending[addr & 3U] = data;
+    if ((addr & 3U) == 3U)
+    {
+        uintptr_t reg = addr & ~(uintptr_t)3U;
+        uint32_t word = (uint32_t)g_simHwGpio.pending[0] | ((uint32_t)g_simHwGpio.pending[1] << 8) |
+                        ((uint32_t)g_simHwGpio.pending[2] << 16) | ((uint32_t)g_simHwGpio.pending[3] << 24);
+        if (!SimHw_GpioWrite(reg, word))
+        {
+            *(volatile uint32_t *)reg = word;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Raise the interrupt of every EXTI GPIO line pending while unmasked.
+ */
+void SimHw_ExtiLines(void)
+{
+    uint32_t extiPending = (EXTI->RPR1 | EXTI->FPR1) & EXTI->IMR1;
+    for (uint32_t line = 0U; (line < SIMHW_EXTI_LINES) && ((extiPending >> line) != 0U); line++)
+    {
+        if ((extiPending & (1UL << line)) != 0U)
+        {
+            SimHw_SetPending(16U + (uint32_t)EXTI0_IRQn + line);
+        }
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Hold a pin at its scheduled level and let IDR and the EXTI follow.
+ */
+static void SimHw_GpioApply(const SimHw_GpioDrive_T *drive)
+{
+    SimHw_Gpio_T *g = &g_simHwGpio;
+    uint16_t bit = (uint16_t)(1U << drive->pin);
+
+    g->drivenPins[drive->port] |= bit;
+    if (drive->level)
+    {
+        g->drivenLevels[drive->port] |= bit;
+    }
+    else
+    {
+        g->drivenLevels[drive->port] &= (uint16_t)~bit;
+    }
+    SimHw_GpioReconcile((GPIO_TypeDef *)(GPIOA_BASE + (0x400U * drive->port)));
+}
+
+/**
+ * @brief Latch the edges of input changes on the lines routed to their port.
+ *
+ * EXTICR codes follow the port order with a gap between GPIOH and GPION.
+ */
+static void SimHw_ExtiEdges(uint32_t slot, uint16_t changed, uint16_t levels)
+{
+    uint32_t code = (slot <= 7U) ? slot : (((slot >= 13U) && (slot <= 16U)) ? (slot - 5U) : SIMHW_EXTI_NO_PORT);
+
+    for (uint32_t line = 0U; (code != SIMHW_EXTI_NO_PORT) && (line < SIMHW_EXTI_LINES); line++)
+    {
+        uint32_t bit = 1UL << line;
+        if (((changed & bit) == 0U) || (((EXTI->EXTICR[line / 4U] >> (8U * (line % 4U))) & 0xFFU) != code))
+        {
+            continue;
+        }
+        if (((levels & bit) != 0U) && ((EXTI->RTSR1 & bit) != 0U))
+        {
+            EXTI->RPR1 |= bit;
+            g_simHwStats.exti_edges++;
+        }
+        else if (((levels & bit) == 0U) && ((EXTI->FTSR1 & bit) != 0U))
+        {
+            EXTI->FPR1 |= bit;
+            g_simHwStats.exti_edges++;
+        }
+    }
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,477 @@
+/**
+ * @file SimHw_I2c.c
+ * @brief Register-level model of I2C1 and the targets on its bus.
+ * @ingroup SimHw
+ * @{
+ *
+ * Master with the bit time from TIMINGR and the kernel clock, START and
+ * repeated START, NBYTES with RELOAD and AUTOEND, TC/TCR/STOPF/NACKF, DMA
+ * requests and SCL stretched while a data register waits. A sensor at 0x48
+ * and a 256-byte register file at 0x50 answer on the bus.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_I2C_TARGETS      (2U)      /**< Targets on the I2C1 bus */
+
+/** ISR flags owned by the model and cleared through ICR, at the same bit positions. */
+#define SIMHW_I2C_FLAGS        (I2C_ISR_NACKF | I2C_ISR_STOPF | I2C_ISR_TC | I2C_ISR_TCR | I2C_ISR_BERR | \
+                                I2C_ISR_ARLO | I2C_ISR_OVR | I2C_ISR_TIMEOUT)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Bus phase of the I2C1 master.
+ */
+typedef enum
+{
+    SIMHW_I2C_IDLE = 0, /**< No transfer, STOP sent */
+    SIMHW_I2C_ADDR,     /**< START and address byte on the bus */
+    SIMHW_I2C_DATA,     /**< Data byte on the bus */
+    SIMHW_I2C_STALL,    /**< SCL stretched, waiting for TXDR or for RXDR to be read */
+    SIMHW_I2C_WAIT,     /**< SCL stretched on TC or TCR, waiting for software */
+    SIMHW_I2C_STOP,     /**< STOP condition on the bus */
+} SimHw_I2cPhase_T;
+
+/**
+ * @brief Target on the I2C1 bus: a register file with an auto-incremented pointer.
+ */
+typedef struct
+{
+    uint8_t addr;      /**< 7-bit address */
+    bool sensor;       /**< Registers 0-3 hold a new sample on every read */
+    uint8_t mem[256];  /**< Registers */
+    uint8_t ptr;       /**< Register pointer */
+    bool gotPtr;       /**< The pointer byte of the current write was received */
+    uint16_t samples;  /**< Reads of a sensor */
+} SimHw_I2cTarget_T;
+
+/**
+ * @brief State of the I2C1 master and its bus.
+ */
+typedef struct
+{
+    I2C_TypeDef *regs;          /**< Register block in the mapped window */
+    SimHw_I2cPhase_T phase;     /**< Bus phase */
+    uint64_t doneNs;            /**< End of the address, data or STOP phase */
+    uint32_t flags;             /**< ISR flags owned by the model */
+    SimHw_I2cTarget_T *target;  /**< Addressed target, NULL if it did not acknowledge */
+    bool read;                  /**< Transfer direction latched at START */
+    uint32_t remaining;         /**< Bytes left in the NBYTES count */
+    bool reload;                /**< RELOAD latched with NBYTES */
+    bool autoend;               /**< AUTOEND latched with NBYTES */
+    uint8_t txData;             /**< TXDR content */
+    bool txFull;                /**< TXDR holds a byte */
+    uint8_t rxData;             /**< RXDR content */
+    bool rxFull;                /**< RXDR holds a byte */
+    uint8_t shiftByte;          /**< Data byte on the bus */
+    uint32_t timingKey;         /**< TIMINGR the cached bit time was computed from */
+    uint64_t bitNs;             /**< Cached SCL period */
+} SimHw_I2c_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_I2c_T g_simHwI2c;
+static SimHw_I2cTarget_T g_simHwI2cTargets[SIMHW_I2C_TARGETS];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_I2cNext(void);
+static void SimHw_I2cEvent(void);
+static void SimHw_I2cEndCount(void);
+static void SimHw_I2cServeRx(void);
+static void SimHw_I2cSchedule(SimHw_I2cPhase_T phase, uint32_t bits);
+static void SimHw_I2cPublish(void);
+static uint64_t SimHw_I2cBitNs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply I2C1 register stores and move the bus on.
+ *
+ * START is taken when the bus is idle or stretched on TC, and cleared
+ * once the address is on the bus. STOP is taken on TC. While TCR is set
+ * NBYTES reads back as zero, so the count written by software is seen
+ * even when it repeats the previous one. Clearing PE resets the
+ * peripheral.
+ */
+void SimHw_I2cReconcile(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+    I2C_TypeDef *r = m->regs;
+
+    uint32_t icr = r->ICR;
+    if (icr != 0U)
+    {
+        m->flags &= ~(icr & SIMHW_I2C_FLAGS);
+        r->ICR = 0U;
+    }
+
+    if ((r->CR1 & I2C_CR1_PE) == 0U)
+    {
+        m->phase = SIMHW_I2C_IDLE;
+        m->doneNs = SIMHW_NO_EVENT;
+        m->flags = 0U;
+        m->txFull = false;
+        m->rxFull = false;
+        r->CR2 &= ~(I2C_CR2_START | I2C_CR2_STOP);
+        SimHw_I2cPublish();
+        return;
+    }
+
+    uint32_t cr2 = r->CR2;
+    bool onTc = (m->phase == SIMHW_I2C_WAIT) && ((m->flags & I2C_ISR_TC) != 0U);
+    if (((cr2 & I2C_CR2_START) != 0U) && ((m->phase == SIMHW_I2C_IDLE) || onTc))
+    {
+        uint8_t addr = (uint8_t)((cr2 & I2C_CR2_SADD) >> 1U);
+        r->CR2 = cr2 & ~I2C_CR2_START;
+        m->flags &= ~I2C_ISR_TC;
+        m->read = (cr2 & I2C_CR2_RD_WRN) != 0U;
+        m->remaining = (cr2 & I2C_CR2_NBYTES) >> I2C_CR2_NBYTES_Pos;
+        m->reload = (cr2 & I2C_CR2_RELOAD) != 0U;
+        m->autoend = (cr2 & I2C_CR2_AUTOEND) != 0U;
+        m->target = NULL;
+        for (uint32_t i = 0U; i < SIMHW_I2C_TARGETS; i++)
+        {
+            if (g_simHwI2cTargets[i].addr == addr)
+            {
+                m->target = &g_simHwI2cTargets[i];
+            }
+        }
+        /* START, address, R/W and acknowledge */
+        SimHw_I2cSchedule(SIMHW_I2C_ADDR, 10U);
+    }
+    else if (((cr2 & I2C_CR2_STOP) != 0U) && onTc)
+    {
+        r->CR2 = cr2 & ~I2C_CR2_STOP;
+        m->flags &= ~I2C_ISR_TC;
+        SimHw_I2cSchedule(SIMHW_I2C_STOP, 1U);
+    }
+    else if ((m->phase == SIMHW_I2C_WAIT) && ((m->flags & I2C_ISR_TCR) != 0U) && ((cr2 & I2C_CR2_NBYTES) != 0U))
+    {
+        m->flags &= ~I2C_ISR_TCR;
+        m->remaining = (cr2 & I2C_CR2_NBYTES) >> I2C_CR2_NBYTES_Pos;
+        m->reload = (cr2 & I2C_CR2_RELOAD) != 0U;
+        m->autoend = (cr2 & I2C_CR2_AUTOEND) != 0U;
+        m->phase = SIMHW_I2C_DATA;
+        SimHw_I2cNext();
+    }
+    else if (m->phase == SIMHW_I2C_STALL)
+    {
+        SimHw_I2cNext();
+    }
+    else if (m->rxFull)
+    {
+        SimHw_I2cServeRx();
+    }
+    SimHw_I2cPublish();
+}
+
+/**
+ * @brief Put I2C1 and its targets in the reset state.
+ */
+void SimHw_I2cReset(void)
+{
+    memset(&g_simHwI2c, 0, sizeof(g_simHwI2c));
+    memset(g_simHwI2cTargets, 0, sizeof(g_simHwI2cTargets));
+    g_simHwI2c.regs = I2C1;
+    g_simHwI2c.doneNs = SIMHW_NO_EVENT;
+    g_simHwI2cTargets[0].addr = 0x48U;
+    g_simHwI2cTargets[0].sensor = true;
+    g_simHwI2cTargets[1].addr = 0x50U;
+    SimHw_I2cPublish();
+}
+
+/**
+ * @brief End of the bus phase in progress.
+ */
+uint64_t SimHw_I2cNextEventNs(void)
+{
+    return g_simHwI2c.doneNs;
+}
+
+/**
+ * @brief End the phase due at @p now, or resume a stretched clock.
+ */
+void SimHw_I2cEvents(uint64_t now)
+{
+    if (g_simHwI2c.doneNs <= now)
+    {
+        SimHw_I2cEvent();
+    }
+    else if (g_simHwI2c.phase == SIMHW_I2C_STALL)
+    {
+        SimHw_I2cNext();
+        SimHw_I2cPublish();
+    }
+}
+
+/**
+ * @brief Raise the I2C1 event and error interrupts while enabled flags are set.
+ */
+void SimHw_I2cLines(void)
+{
+    I2C_TypeDef *i2c = g_simHwI2c.regs;
+    uint32_t i2cIsr = i2c->ISR;
+    uint32_t i2cCr1 = i2c->CR1;
+    if ((((i2cIsr & I2C_ISR_TXIS) != 0U) && ((i2cCr1 & I2C_CR1_TXIE) != 0U)) ||
+        (((i2cIsr & I2C_ISR_RXNE) != 0U) && ((i2cCr1 & I2C_CR1_RXIE) != 0U)) ||
+        (((i2cIsr & I2C_ISR_NACKF) != 0U) && ((i2cCr1 & I2C_CR1_NACKIE) != 0U)) ||
+        (((i2cIsr & I2C_ISR_STOPF) != 0U) && ((i2cCr1 & I2C_CR1_STOPIE) != 0U)) ||
+        (((i2cIsr & (I2C_ISR_TC | I2C_ISR_TCR)) != 0U) && ((i2cCr1 & I2C_CR1_TCIE) != 0U)))
+    {
+        SimHw_SetPending(16U + (uint32_t)I2C1_EV_IRQn);
+    }
+    if (((i2cIsr & (I2C_ISR_BERR | I2C_ISR_ARLO | I2C_ISR_OVR | I2C_ISR_TIMEOUT)) != 0U) &&
+        ((i2cCr1 & I2C_CR1_ERRIE) != 0U))
+    {
+        SimHw_SetPending(16U + (uint32_t)I2C1_ER_IRQn);
+    }
+}
+
+/**
+ * @brief Take a DMA write to TXDR.
+ *
+ * @retval true  @p addr is TXDR.
+ * @retval false Not the I2C1 data register.
+ */
+bool SimHw_I2cDmaWrite(uintptr_t addr, uint8_t data)
+{
+    if (addr != (uintptr_t)&g_simHwI2c.regs->TXDR)
+    {
+        return false;
+    }
+    g_simHwI2c.txData = data;
+    g_simHwI2c.txFull = true;
+    return true;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Start the next data byte, or end the NBYTES count.
+ *
+ * A write needs TXDR, requested from DMA when enabled; a read needs RXDR
+ * free. Otherwise SCL is stretched until software or DMA catches up.
+ */
+static void SimHw_I2cNext(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+
+    if (m->remaining == 0U)
+    {
+        SimHw_I2cEndCount();
+        return;
+    }
+
+    if (!m->read)
+    {
+        if (!m->txFull && ((m->regs->CR1 & I2C_CR1_TXDMAEN) != 0U))
+        {
+            (void)SimHw_DmaRequest(LL_GPDMA1_REQUEST_I2C1_TX);
+        }
+        if (m->txFull)
+        {
+            m->shiftByte = m->txData;
+            m->txFull = false;
+            SimHw_I2cSchedule(SIMHW_I2C_DATA, 9U);
+            return;
+        }
+    }
+    else
+    {
+        SimHw_I2cServeRx();
+        if (!m->rxFull)
+        {
+            SimHw_I2cSchedule(SIMHW_I2C_DATA, 9U);
+            return;
+        }
+    }
+    m->phase = SIMHW_I2C_STALL;
+    m->doneNs = SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief End of the address, data or STOP phase.
+ */
+static void SimHw_I2cEvent(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+    SimHw_I2cTarget_T *t = m->target;
+
+    m->doneNs = SIMHW_NO_EVENT;
+    switch (m->phase)
+    {
+    case SIMHW_I2C_ADDR:
+        g_simHwStats.i2c_bytes++;
+        if (t == NULL)
+        {
+            /* The master sends STOP itself after a NACK */
+            m->flags |= I2C_ISR_NACKF;
+            SimHw_I2cSchedule(SIMHW_I2C_STOP, 1U);
+            break;
+        }
+        if (!m->read)
+        {
+            t->gotPtr = false;
+        }
+        else if (t->sensor)
+        {
+            t->samples++;
+            uint16_t value = (uint16_t)(t->samples * 37U);
+            t->mem[0] = (uint8_t)(t->samples >> 8);
+            t->mem[1] = (uint8_t)t->samples;
+            t->mem[2] = (uint8_t)(value >> 8);
+            t->mem[3] = (uint8_t)value;
+        }
+        m->phase = SIMHW_I2C_DATA;
+        SimHw_I2cNext();
+        break;
+
+    case SIMHW_I2C_DATA:
+        g_simHwStats.i2c_bytes++;
+        if (!m->read)
+        {
+            if (!t->gotPtr)
+            {
+                t->ptr = m->shiftByte;
+                t->gotPtr = true;
+            }
+            else
+            {
+                t->mem[t->ptr++] = m->shiftByte;
+            }
+        }
+        else
+        {
+            m->rxData = t->mem[t->ptr++];
+            m->rxFull = true;
+            SimHw_I2cServeRx();
+        }
+        m->remaining--;
+        SimHw_I2cNext();
+        break;
+
+    case SIMHW_I2C_STOP:
+        m->flags |= I2C_ISR_STOPF;
+        m->phase = SIMHW_I2C_IDLE;
+        m->txFull = false;
+        break;
+
+    default:
+        break;
+    }
+    SimHw_I2cPublish();
+}
+
+/**
+ * @brief NBYTES reached: TCR with RELOAD, STOP with AUTOEND, TC otherwise.
+ */
+static void SimHw_I2cEndCount(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+
+    if (m->reload)
+    {
+        m->flags |= I2C_ISR_TCR;
+        m->regs->CR2 &= ~I2C_CR2_NBYTES;
+        m->phase = SIMHW_I2C_WAIT;
+    }
+    else if (m->autoend)
+    {
+        SimHw_I2cSchedule(SIMHW_I2C_STOP, 1U);
+    }
+    else
+    {
+        m->flags |= I2C_ISR_TC;
+        m->phase = SIMHW_I2C_WAIT;
+    }
+}
+
+/**
+ * @brief Hand a received byte to the receive DMA channel.
+ */
+static void SimHw_I2cServeRx(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+    I2C_TypeDef *r = m->regs;
+
+    if (m->rxFull && ((r->CR1 & I2C_CR1_RXDMAEN) != 0U))
+    {
+        *(volatile uint8_t *)&r->RXDR = m->rxData;
+        if (SimHw_DmaRequest(LL_GPDMA1_REQUEST_I2C1_RX))
+        {
+            m->rxFull = false;
+        }
+    }
+}
+
+/**
+ * @brief Put @p bits SCL periods of @p phase on the bus.
+ */
+static void SimHw_I2cSchedule(SimHw_I2cPhase_T phase, uint32_t bits)
+{
+    uint64_t ns = bits * SimHw_I2cBitNs();
+
+    g_simHwI2c.phase = phase;
+    g_simHwI2c.doneNs = g_simHwStats.now_ns + ns;
+    g_simHwStats.i2c_busy_ns += ns;
+}
+
+/**
+ * @brief Publish ISR.
+ */
+static void SimHw_I2cPublish(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+    uint32_t isr = m->flags;
+
+    if (!m->txFull)
+    {
+        isr |= I2C_ISR_TXE;
+        if ((m->phase == SIMHW_I2C_STALL) && !m->read)
+        {
+            isr |= I2C_ISR_TXIS;
+        }
+    }
+    if (m->rxFull)
+    {
+        isr |= I2C_ISR_RXNE;
+    }
+    if (m->phase != SIMHW_I2C_IDLE)
+    {
+        isr |= I2C_ISR_BUSY;
+    }
+    m->regs->ISR = isr;
+}
+
+/**
+ * @brief SCL period from TIMINGR and the kernel clock.
+ *
+ * The SCL edge synchronisation delays are left out, as in the driver
+ * timing calculation. The result is cached until TIMINGR changes.
+ */
+static uint64_t SimHw_I2cBitNs(void)
+{
+    SimHw_I2c_T *m = &g_simHwI2c;
+    uint32_t timingr = m->regs->TIMINGR;
+
+    if ((timingr == m->timingKey) && (m->bitNs != 0U))
+    {
+        return m->bitNs;
+    }
+    m->timingKey = timingr;
+
+    bool inModel = g_simHwInModel;
+    g_simHwInModel = true;
+    uint32_t kernelClock = LL_RCC_GetI2CClockFreq(LL_RCC_I2C1_CLKSOURCE);
+    g_simHwInModel = inModel;
+
+    uint64_t presc = ((timingr & I2C_TIMINGR_PRESC) >> I2C_TIMINGR_PRESC_Pos) + 1U;
+    uint64_t ticks = ((timingr & I2C_TIMINGR_SCLL) >> I2C_TIMINGR_SCLL_Pos) +
+                     ((timingr & I2C_TIMINGR_SCLH) >> I2C_TIMINGR_SCLH_Pos) + 2U;
+    m->bitNs = (kernelClock != 0U) ? (((presc * ticks * 1000000000ULL) + (kernelClock / 2U)) / kernelClock) : 10000U;
+    return m->bitNs;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,977 @@
+/**
+ * @file SimHw_I3c.c
+ * @brief Register-level model of I3C1 and the targets on its bus.
+ * @ingroup SimHw
+ * @{
+ *
+ * SDR controller with push-pull and open-drain bit times from TIMINGR0,
+ * one-word control FIFO, 8-byte RX FIFO, DMA requests, private messages,
+ * broadcast and direct CCCs, ENTDAA with ID arbitration and FCF/ERRF with
+ * NACK and overrun errors. An IMU, a pressure sensor and a plain register
+ * file answer on the bus, the first two raising in-band interrupts.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+#include "stm32n6xx_ll_i3c.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_I3C_TARGETS      (3U)      /**< Targets on the I3C1 bus */
+#define SIMHW_I3C_RX_FIFO      (8U)      /**< Bytes held by the I3C1 receive FIFO */
+#define SIMHW_I3C_ID_BYTES     (8U)      /**< PID, BCR and DCR sent during ENTDAA */
+#define SIMHW_I3C_IBI_PAYLOAD  (2U)      /**< In-band interrupt payload: mandatory data byte and a counter */
+#define SIMHW_I3C_NO_CCC       (0xFFU)   /**< CCC latched for a private message */
+#define SIMHW_I3C_BCR_IBI      (1U << 1) /**< BCR: the target raises in-band interrupts */
+#define SIMHW_I3C_BCR_PAYLOAD  (1U << 2) /**< BCR: its interrupts carry a payload */
+#define SIMHW_I3C_CCC_ENEC     (0x00U)
+#define SIMHW_I3C_CCC_DISEC    (0x01U)
+#define SIMHW_I3C_CCC_RSTDAA   (0x06U)
+#define SIMHW_I3C_CCC_ENTDAA   (0x07U)
+#define SIMHW_I3C_CCC_ENEC_D   (0x80U)
+#define SIMHW_I3C_CCC_DISEC_D  (0x81U)
+#define SIMHW_I3C_CCC_GETPID   (0x8DU)
+#define SIMHW_I3C_CCC_GETBCR   (0x8EU)
+#define SIMHW_I3C_CCC_GETDCR   (0x8FU)
+#define SIMHW_I3C_CCC_GETSTATUS (0x90U)
+/** EVR flags owned by the model and cleared through CEVR, at the same bit positions. */
+#define SIMHW_I3C_FLAGS        (I3C_EVR_FCF | I3C_EVR_ERRF | I3C_EVR_IBIF)
+#define SIMHW_I3C_FLUSH        (I3C_CFGR_TXFLUSH | I3C_CFGR_RXFLUSH | I3C_CFGR_SFLUSH | I3C_CFGR_CFLUSH)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Bus phase of the I3C1 controller.
+ */
+typedef enum
+{
+    SIMHW_I3C_IDLE = 0, /**< Bus free */
+    SIMHW_I3C_HEADER,   /**< START, 7E/W and acknowledge in open drain */
+    SIMHW_I3C_CCC,      /**< Command code */
+    SIMHW_I3C_ADDR,     /**< Repeated START, target address and acknowledge */
+    SIMHW_I3C_DATA,     /**< Data byte and its parity or T-bit */
+    SIMHW_I3C_STALL,    /**< Waiting for TDR, a free RX FIFO entry or the next control word */
+    SIMHW_I3C_DAA_ID,   /**< Repeated START, 7E/R and the ID of the winning target */
+    SIMHW_I3C_DAA_WAIT, /**< ID in the RX FIFO, waiting for the dynamic address in TDR */
+    SIMHW_I3C_DAA_ADDR, /**< Dynamic address sent to the target */
+    SIMHW_I3C_STOP,     /**< STOP condition */
+    SIMHW_I3C_IBI,      /**< In-band interrupt: target address, payload and STOP */
+} SimHw_I3cPhase_T;
+
+/**
+ * @brief Target on the I3C1 bus: a register file with an auto-incremented pointer.
+ */
+typedef struct
+{
+    uint64_t pid;         /**< 48-bit provisioned ID */
+    uint8_t bcr;          /**< Bus characteristics register */
+    uint8_t dcr;          /**< Device characteristics register */
+    uint8_t da;           /**< Dynamic address, 0 before assignment */
+    bool intEnabled;      /**< In-band interrupts enabled by ENEC */
+    bool sensor;          /**< Registers 0-3 hold a new sample on every read */
+    uint16_t readLimit;   /**< Bytes after which the target ends a private read, 0 for none */
+    uint64_t ibiPeriodNs; /**< Interval between in-band interrupts, 0 for none */
+    uint64_t ibiDueNs;    /**< Next in-band interrupt */
+    uint8_t ibiSeq;       /**< Payload counter of the in-band interrupts */
+    uint8_t mem[256];     /**< Registers */
+    uint8_t ptr;          /**< Register pointer */
+    bool gotPtr;          /**< The pointer byte of the current write was received */
+    uint16_t samples;     /**< Reads of a sensor */
+} SimHw_I3cTarget_T;
+
+/**
+ * @brief State of the I3C1 controller and its bus.
+ */
+typedef struct
+{
+    I3C_TypeDef *regs;                 /**< Register block in the mapped window */
+    SimHw_I3cPhase_T phase;            /**< Bus phase */
+    uint64_t doneNs;                   /**< End of the current phase */
+    uint32_t flags;                    /**< EVR flags owned by the model */
+    uint32_t ser;                      /**< SER content */
+    uint32_t cword;                    /**< Control word waiting in the control FIFO */
+    bool cFull;                        /**< The control FIFO holds a word */
+    uint32_t msg;                      /**< Control word of the message on the bus */
+    uint32_t msgId;                    /**< Message index in the frame */
+    uint32_t remaining;                /**< Data bytes left in the message */
+    uint32_t xdcnt;                    /**< Data bytes of the message so far */
+    uint8_t ccc;                       /**< CCC of the frame, ::SIMHW_I3C_NO_CCC for private */
+    bool read;                         /**< Direction of the message */
+    bool failed;                       /**< An error ends the frame, no FCF */
+    SimHw_I3cTarget_T *target;         /**< Addressed target, or the one in DAA or IBI */
+    uint8_t ibiLen;                    /**< Payload bytes of the in-band interrupt on the bus */
+    bool ibiAck;                       /**< The in-band interrupt on the bus is acknowledged */
+    uint8_t txData;                    /**< TDR content */
+    bool txFull;                       /**< TDR holds a byte */
+    uint8_t rxFifo[SIMHW_I3C_RX_FIFO]; /**< Receive FIFO, oldest first */
+    uint32_t rxCount;                  /**< Bytes in @ref rxFifo */
+    uint8_t shiftByte;                 /**< Data byte on the bus */
+    uint32_t timingKey;                /**< TIMINGR0 the cached bit times were computed from */
+    uint64_t ppNs;                     /**< Cached push-pull SCL period */
+    uint64_t odNs;                     /**< Cached open-drain SCL period */
+} SimHw_I3c_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_I3c_T g_simHwI3c;
+static SimHw_I3cTarget_T g_simHwI3cTargets[SIMHW_I3C_TARGETS];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_I3cAdvance(void);
+static void SimHw_I3cMessage(void);
+static void SimHw_I3cNext(void);
+static void SimHw_I3cEndMessage(void);
+static void SimHw_I3cEvent(void);
+static void SimHw_I3cDaaNext(void);
+static void SimHw_I3cFail(uint32_t ser);
+static void SimHw_I3cTargetWrite(uint8_t data);
+static uint8_t SimHw_I3cTargetRead(void);
+static bool SimHw_I3cReadEnds(void);
+static SimHw_I3cTarget_T *SimHw_I3cIbiSource(uint64_t *dueNs);
+static void SimHw_I3cIbiStart(SimHw_I3cTarget_T *t);
+static void SimHw_I3cServeRx(void);
+static void SimHw_I3cSchedule(SimHw_I3cPhase_T phase, uint32_t ppBits, uint32_t odBits);
+static void SimHw_I3cPublish(void);
+static void SimHw_I3cBitNs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply I3C1 register stores and move the bus on.
+ *
+ * CEVR clears the flags written as one, CERRF also clears SER. The FIFO
+ * flush bits act once and read back as zero. Clearing EN resets the
+ * peripheral; the targets keep their dynamic addresses.
+ */
+void SimHw_I3cReconcile(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    I3C_TypeDef *r = m->regs;
+
+    uint32_t cevr = r->CEVR;
+    if (cevr != 0U)
+    {
+        m->flags &= ~(cevr & SIMHW_I3C_FLAGS);
+        if ((cevr & I3C_CEVR_CERRF) != 0U)
+        {
+            m->ser = 0U;
+        }
+        r->CEVR = 0U;
+    }
+
+    uint32_t cfgr = r->CFGR;
+    if ((cfgr & I3C_CFGR_EN) == 0U)
+    {
+        m->phase = SIMHW_I3C_IDLE;
+        m->doneNs = SIMHW_NO_EVENT;
+        m->flags = 0U;
+        m->ser = 0U;
+        m->cFull = false;
+        m->txFull = false;
+        m->rxCount = 0U;
+        SimHw_I3cPublish();
+        return;
+    }
+
+    if ((cfgr & SIMHW_I3C_FLUSH) != 0U)
+    {
+        if ((cfgr & I3C_CFGR_TXFLUSH) != 0U)
+        {
+            m->txFull = false;
+        }
+        if ((cfgr & I3C_CFGR_RXFLUSH) != 0U)
+        {
+            m->rxCount = 0U;
+        }
+        if ((cfgr & I3C_CFGR_CFLUSH) != 0U)
+        {
+            m->cFull = false;
+        }
+        r->CFGR = cfgr & ~SIMHW_I3C_FLUSH;
+    }
+
+    SimHw_I3cAdvance();
+    SimHw_I3cPublish();
+}
+
+/**
+ * @brief Apply a CPU store to the I3C1 control or transmit data register.
+ *
+ * A control word enters the one-entry control FIFO and may start a frame
+ * at once; a word written while the FIFO is full is an overrun.
+ *
+ * @retval true  The store was handled by the model.
+ * @retval false Not CR or TDR, store as memory.
+ */
+bool SimHw_I3cWrite(uintptr_t addr, uint32_t value)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    I3C_TypeDef *r = m->regs;
+
+    if ((addr != (uintptr_t)&r->CR) && (addr != (uintptr_t)&r->TDR))
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    if (addr == (uintptr_t)&r->CR)
+    {
+        r->CR = value;
+        if (m->cFull)
+        {
+            m->ser |= I3C_SER_COVR;
+            m->flags |= I3C_EVR_ERRF;
+        }
+        else
+        {
+            m->cword = value;
+            m->cFull = true;
+        }
+    }
+    else
+    {
+        m->txData = (uint8_t)value;
+        m->txFull = true;
+    }
+    SimHw_I3cAdvance();
+    SimHw_I3cPublish();
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Apply a CPU load from the I3C1 receive data register.
+ *
+ * @retval true  @p value holds the oldest RX FIFO byte, 0 when empty.
+ * @retval false Not RDR, load as memory.
+ */
+bool SimHw_I3cRead(uintptr_t addr, uint32_t *value)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+
+    if (addr != (uintptr_t)&m->regs->RDR)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    *value = 0U;
+    if (m->rxCount != 0U)
+    {
+        *value = m->rxFifo[0];
+        m->rxCount--;
+        memmove(&m->rxFifo[0], &m->rxFifo[1], m->rxCount);
+    }
+    SimHw_I3cAdvance();
+    SimHw_I3cPublish();
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put I3C1 and its targets in the reset state.
+ */
+void SimHw_I3cReset(void)
+{
+    memset(&g_simHwI3c, 0, sizeof(g_simHwI3c));
+    memset(g_simHwI3cTargets, 0, sizeof(g_simHwI3cTargets));
+    g_simHwI3c.regs = I3C1;
+    g_simHwI3c.doneNs = SIMHW_NO_EVENT;
+    g_simHwI3cTargets[0].pid = 0x04A100001001ULL;
+    g_simHwI3cTargets[0].bcr = SIMHW_I3C_BCR_IBI | SIMHW_I3C_BCR_PAYLOAD;
+    g_simHwI3cTargets[0].dcr = 0x44U;
+    g_simHwI3cTargets[0].sensor = true;
+    g_simHwI3cTargets[0].ibiPeriodNs = 2000000U;
+    g_simHwI3cTargets[1].pid = 0x04A100002002ULL;
+    g_simHwI3cTargets[1].bcr = SIMHW_I3C_BCR_IBI;
+    g_simHwI3cTargets[1].dcr = 0x63U;
+    g_simHwI3cTargets[1].readLimit = 3U;
+    g_simHwI3cTargets[1].ibiPeriodNs = 5000000U;
+    g_simHwI3cTargets[2].pid = 0x04A100003003ULL;
+    SimHw_I3cPublish();
+}
+
+/**
+ * @brief End of the bus phase in progress or the next in-band interrupt.
+ */
+uint64_t SimHw_I3cNextEventNs(void)
+{
+    uint64_t next = g_simHwI3c.doneNs;
+    uint64_t ibiNs;
+    if ((SimHw_I3cIbiSource(&ibiNs) != NULL) && (ibiNs < next))
+    {
+        next = ibiNs;
+    }
+    return next;
+}
+
+/**
+ * @brief End the phase due at @p now, or start the next message on an idle bus.
+ */
+void SimHw_I3cEvents(uint64_t now)
+{
+    if (g_simHwI3c.doneNs <= now)
+    {
+        SimHw_I3cEvent();
+    }
+    else if ((g_simHwI3c.phase == SIMHW_I3C_STALL) || (g_simHwI3c.phase == SIMHW_I3C_IDLE))
+    {
+        SimHw_I3cAdvance();
+        SimHw_I3cPublish();
+    }
+}
+
+/**
+ * @brief Raise the I3C1 event and error interrupts while enabled flags are set.
+ */
+void SimHw_I3cLines(void)
+{
+    /* The I3C interrupt enables sit at the bit positions of their flags */
+    uint32_t i3cEvents = g_simHwI3c.regs->EVR & g_simHwI3c.regs->IER;
+    if ((i3cEvents & ~I3C_EVR_ERRF) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)I3C1_EV_IRQn);
+    }
+    if ((i3cEvents & I3C_EVR_ERRF) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)I3C1_ER_IRQn);
+    }
+}
+
+/**
+ * @brief Take a DMA write to TDR.
+ *
+ * @retval true  @p addr is TDR.
+ * @retval false Not the I3C1 data register.
+ */
+bool SimHw_I3cDmaWrite(uintptr_t addr, uint8_t data)
+{
+    if (addr != (uintptr_t)&g_simHwI3c.regs->TDR)
+    {
+        return false;
+    }
+    g_simHwI3c.txData = data;
+    g_simHwI3c.txFull = true;
+    return true;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Move the bus on when it waits on software, DMA or time.
+ *
+ * An idle bus starts the frame of a waiting control word, otherwise lets
+ * a target with a due in-band interrupt take it.
+ */
+static void SimHw_I3cAdvance(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+
+    if ((m->regs->CFGR & I3C_CFGR_EN) == 0U)
+    {
+        return;
+    }
+
+    SimHw_I3cServeRx();
+    switch (m->phase)
+    {
+    case SIMHW_I3C_IDLE:
+        if (m->cFull)
+        {
+            m->msg = m->cword;
+            m->cFull = false;
+            m->msgId = 0U;
+            m->failed = false;
+            SimHw_I3cSchedule(SIMHW_I3C_HEADER, 0U, 10U);
+        }
+        else
+        {
+            SimHw_I3cTarget_T *t = SimHw_I3cIbiSource(NULL);
+            if (t != NULL)
+            {
+                SimHw_I3cIbiStart(t);
+            }
+        }
+        break;
+
+    case SIMHW_I3C_STALL:
+        SimHw_I3cNext();
+        break;
+
+    case SIMHW_I3C_DAA_WAIT:
+        if (m->txFull)
+        {
+            m->shiftByte = m->txData;
+            m->txFull = false;
+            SimHw_I3cSchedule(SIMHW_I3C_DAA_ADDR, 0U, 9U);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Start the message described by the latched control word.
+ */
+static void SimHw_I3cMessage(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    uint32_t mtype = m->msg & I3C_CR_MTYPE;
+
+    m->xdcnt = 0U;
+    m->target = NULL;
+    if (mtype == LL_I3C_CONTROLLER_MTYPE_CCC)
+    {
+        m->ccc = (uint8_t)((m->msg & I3C_CR_CCC) >> I3C_CR_CCC_Pos);
+        m->read = false;
+        SimHw_I3cSchedule(SIMHW_I3C_CCC, 9U, 0U);
+    }
+    else if ((mtype == LL_I3C_CONTROLLER_MTYPE_PRIVATE) || (mtype == LL_I3C_CONTROLLER_MTYPE_DIRECT))
+    {
+        if (mtype == LL_I3C_CONTROLLER_MTYPE_PRIVATE)
+        {
+            m->ccc = SIMHW_I3C_NO_CCC;
+        }
+        m->read = (m->msg & I3C_CR_RNW) != 0U;
+        SimHw_I3cSchedule(SIMHW_I3C_ADDR, 10U, 0U);
+    }
+    else
+    {
+        /* Legacy I2C, release and header-only messages are not modelled */
+        SimHw_I3cFail(I3C_SER_CODERR_0);
+    }
+}
+
+/**
+ * @brief Start the next data byte, or end the message.
+ *
+ * A write needs TDR, requested from DMA when enabled; a read needs room
+ * in the RX FIFO. Otherwise SCL is held until software or DMA catches up.
+ */
+static void SimHw_I3cNext(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+
+    if ((m->remaining == 0U) || (m->read && SimHw_I3cReadEnds()))
+    {
+        SimHw_I3cEndMessage();
+        return;
+    }
+
+    if (!m->read)
+    {
+        if (!m->txFull && ((m->regs->CFGR & I3C_CFGR_TXDMAEN) != 0U))
+        {
+            (void)SimHw_DmaRequest(LL_GPDMA1_REQUEST_I3C1_TX);
+        }
+        if (m->txFull)
+        {
+            m->shiftByte = m->txData;
+            m->txFull = false;
+            SimHw_I3cSchedule(SIMHW_I3C_DATA, 9U, 0U);
+            return;
+        }
+    }
+    else
+    {
+        SimHw_I3cServeRx();
+        if (m->rxCount < SIMHW_I3C_RX_FIFO)
+        {
+            SimHw_I3cSchedule(SIMHW_I3C_DATA, 9U, 0U);
+            return;
+        }
+    }
+    m->phase = SIMHW_I3C_STALL;
+    m->doneNs = SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief STOP after the last message, else take the next control word.
+ *
+ * A frame whose next word is not in the control FIFO by then ends with an
+ * overrun error.
+ */
+static void SimHw_I3cEndMessage(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+
+    if ((m->msg & I3C_CR_MEND) != 0U)
+    {
+        SimHw_I3cSchedule(SIMHW_I3C_STOP, 1U, 0U);
+    }
+    else if (!m->cFull)
+    {
+        SimHw_I3cFail(I3C_SER_COVR);
+    }
+    else
+    {
+        m->msg = m->cword;
+        m->cFull = false;
+        m->msgId++;
+        SimHw_I3cMessage();
+    }
+}
+
+/**
+ * @brief End of the current bus phase.
+ */
+static void SimHw_I3cEvent(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    SimHw_I3cTarget_T *t = m->target;
+
+    m->doneNs = SIMHW_NO_EVENT;
+    switch (m->phase)
+    {
+    case SIMHW_I3C_HEADER:
+        g_simHwStats.i3c_bytes++;
+        SimHw_I3cMessage();
+        break;
+
+    case SIMHW_I3C_CCC:
+        g_simHwStats.i3c_bytes++;
+        if (m->ccc == SIMHW_I3C_CCC_ENTDAA)
+        {
+            SimHw_I3cDaaNext();
+            break;
+        }
+        if (m->ccc == SIMHW_I3C_CCC_RSTDAA)
+        {
+            for (uint32_t i = 0U; i < SIMHW_I3C_TARGETS; i++)
+            {
+                g_simHwI3cTargets[i].da = 0U;
+            }
+        }
+        m->remaining = m->msg & I3C_CR_DCNT;
+        m->phase = SIMHW_I3C_DATA;
+        SimHw_I3cNext();
+        break;
+
+    case SIMHW_I3C_ADDR:
+        g_simHwStats.i3c_bytes++;
+        uint8_t addr = (uint8_t)((m->msg & I3C_CR_ADD) >> I3C_CR_ADD_Pos);
+        for (uint32_t i = 0U; i < SIMHW_I3C_TARGETS; i++)
+        {
+            if ((g_simHwI3cTargets[i].da != 0U) && (g_simHwI3cTargets[i].da == addr))
+            {
+                t = &g_simHwI3cTargets[i];
+            }
+        }
+        if (t == NULL)
+        {
+            SimHw_I3cFail(I3C_SER_ANACK);
+            break;
+        }
+        m->target = t;
+        if ((m->ccc == SIMHW_I3C_NO_CCC) && !m->read)
+        {
+            t->gotPtr = false;
+        }
+        else if ((m->ccc == SIMHW_I3C_NO_CCC) && t->sensor)
+        {
+            t->samples++;
+            uint16_t value = (uint16_t)(t->samples * 53U);
+            t->mem[0] = (uint8_t)(t->samples >> 8);
+            t->mem[1] = (uint8_t)t->samples;
+            t->mem[2] = (uint8_t)(value >> 8);
+            t->mem[3] = (uint8_t)value;
+        }
+        m->remaining = m->msg & I3C_CR_DCNT;
+        m->phase = SIMHW_I3C_DATA;
+        SimHw_I3cNext();
+        break;
+
+    case SIMHW_I3C_DATA:
+        g_simHwStats.i3c_bytes++;
+        if (!m->read)
+        {
+            SimHw_I3cTargetWrite(m->shiftByte);
+        }
+        else
+        {
+            m->rxFifo[m->rxCount++] = SimHw_I3cTargetRead();
+            SimHw_I3cServeRx();
+        }
+        m->xdcnt++;
+        m->remaining--;
+        SimHw_I3cNext();
+        break;
+
+    case SIMHW_I3C_DAA_ID:
+        g_simHwStats.i3c_bytes += SIMHW_I3C_ID_BYTES;
+        for (uint32_t i = 0U; i < 6U; i++)
+        {
+            m->rxFifo[i] = (uint8_t)(t->pid >> (8U * (5U - i)));
+        }
+        m->rxFifo[6] = t->bcr;
+        m->rxFifo[7] = t->dcr;
+        m->rxCount = SIMHW_I3C_ID_BYTES;
+        m->phase = SIMHW_I3C_DAA_WAIT;
+        break;
+
+    case SIMHW_I3C_DAA_ADDR:
+        g_simHwStats.i3c_bytes++;
+        t->da = m->shiftByte & 0x7FU;
+        SimHw_I3cDaaNext();
+        break;
+
+    case SIMHW_I3C_STOP:
+        m->phase = SIMHW_I3C_IDLE;
+        if (!m->failed)
+        {
+            m->flags |= I3C_EVR_FCF;
+        }
+        SimHw_I3cAdvance();
+        break;
+
+    case SIMHW_I3C_IBI:
+        g_simHwStats.i3c_bytes += 1U + m->ibiLen;
+        if (m->ibiAck)
+        {
+            uint32_t payload = 0x01U | ((uint32_t)t->ibiSeq << 8);
+            m->regs->RMR = ((uint32_t)t->da << I3C_RMR_RADD_Pos) | m->ibiLen;
+            m->regs->IBIDR = payload & ((m->ibiLen == 0U) ? 0U : (0xFFFFFFFFUL >> (8U * (4U - m->ibiLen))));
+            m->flags |= I3C_EVR_IBIF;
+            g_simHwStats.i3c_ibis++;
+        }
+        t->ibiSeq++;
+        m->phase = SIMHW_I3C_IDLE;
+        SimHw_I3cAdvance();
+        break;
+
+    default:
+        break;
+    }
+    SimHw_I3cPublish();
+}
+
+/**
+ * @brief Next round of ENTDAA.
+ *
+ * The targets without a dynamic address send their ID in open drain, the
+ * lowest one wins the arbitration. Once none answers 7E/R the frame ends.
+ */
+static void SimHw_I3cDaaNext(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    SimHw_I3cTarget_T *winner = NULL;
+    uint64_t best = UINT64_MAX;
+
+    for (uint32_t i = 0U; i < SIMHW_I3C_TARGETS; i++)
+    {
+        SimHw_I3cTarget_T *t = &g_simHwI3cTargets[i];
+        uint64_t id = (t->pid << 16) | ((uint64_t)t->bcr << 8) | t->dcr;
+        if ((t->da == 0U) && (id < best))
+        {
+            best = id;
+            winner = t;
+        }
+    }
+
+    m->target = winner;
+    if (winner == NULL)
+    {
+        /* Repeated START, 7E/R not acknowledged, then STOP */
+        SimHw_I3cSchedule(SIMHW_I3C_STOP, 1U, 10U);
+        return;
+    }
+    SimHw_I3cSchedule(SIMHW_I3C_DAA_ID, 0U, 10U + (8U * SIMHW_I3C_ID_BYTES));
+}
+
+/**
+ * @brief End the frame on an error: set SER and ERRF, then STOP.
+ */
+static void SimHw_I3cFail(uint32_t ser)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+
+    m->ser |= ser;
+    m->flags |= I3C_EVR_ERRF;
+    m->failed = true;
+    SimHw_I3cSchedule(SIMHW_I3C_STOP, 1U, 0U);
+}
+
+/**
+ * @brief Byte written to the addressed target, or to every target by a broadcast CCC.
+ */
+static void SimHw_I3cTargetWrite(uint8_t data)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    SimHw_I3cTarget_T *t = m->target;
+    uint64_t due = g_simHwStats.now_ns;
+
+    switch (m->ccc)
+    {
+    case SIMHW_I3C_NO_CCC:
+        if (!t->gotPtr)
+        {
+            t->ptr = data;
+            t->gotPtr = true;
+        }
+        else
+        {
+            t->mem[t->ptr++] = data;
+        }
+        break;
+
+    case SIMHW_I3C_CCC_ENEC:
+    case SIMHW_I3C_CCC_DISEC:
+        for (uint32_t i = 0U; i < SIMHW_I3C_TARGETS; i++)
+        {
+            SimHw_I3cTarget_T *b = &g_simHwI3cTargets[i];
+            if ((data & 0x01U) != 0U)
+            {
+                b->intEnabled = (m->ccc == SIMHW_I3C_CCC_ENEC);
+                b->ibiDueNs = due + b->ibiPeriodNs;
+            }
+        }
+        break;
+
+    case SIMHW_I3C_CCC_ENEC_D:
+    case SIMHW_I3C_CCC_DISEC_D:
+        if ((data & 0x01U) != 0U)
+        {
+            t->intEnabled = (m->ccc == SIMHW_I3C_CCC_ENEC_D);
+            t->ibiDueNs = due + t->ibiPeriodNs;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Byte read from the addressed target: a register, or the answer to a direct GET CCC.
+ */
+static uint8_t SimHw_I3cTargetRead(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    SimHw_I3cTarget_T *t = m->target;
+
+    switch (m->ccc)
+    {
+    case SIMHW_I3C_NO_CCC:
+        return t->mem[t->ptr++];
+    case SIMHW_I3C_CCC_GETPID:
+        return (uint8_t)(t->pid >> (8U * (5U - m->xdcnt)));
+    case SIMHW_I3C_CCC_GETBCR:
+        return t->bcr;
+    case SIMHW_I3C_CCC_GETDCR:
+        return t->dcr;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief The target ends the read here through the T-bit of its last byte.
+ */
+static bool SimHw_I3cReadEnds(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    uint32_t length;
+
+    switch (m->ccc)
+    {
+    case SIMHW_I3C_NO_CCC:
+        length = (m->target->readLimit != 0U) ? m->target->readLimit : UINT32_MAX;
+        break;
+    case SIMHW_I3C_CCC_GETPID:
+        length = 6U;
+        break;
+    case SIMHW_I3C_CCC_GETBCR:
+    case SIMHW_I3C_CCC_GETDCR:
+        length = 1U;
+        break;
+    case SIMHW_I3C_CCC_GETSTATUS:
+        length = 2U;
+        break;
+    default:
+        length = 0U;
+        break;
+    }
+    return m->xdcnt >= length;
+}
+
+/**
+ * @brief Target whose in-band interrupt is due first, if the bus can take one.
+ *
+ * The bus must be idle with no control word waiting and IBIF clear; an
+ * interrupt that cannot be taken stays pending in its target.
+ *
+ * @param[out] dueNs When the interrupt is due, may be NULL.
+ *
+ * @return The target, NULL if none is enabled.
+ */
+static SimHw_I3cTarget_T *SimHw_I3cIbiSource(uint64_t *dueNs)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    SimHw_I3cTarget_T *source = NULL;
+    uint64_t first = SIMHW_NO_EVENT;
+
+    if ((m->phase != SIMHW_I3C_IDLE) || m->cFull || ((m->flags & I3C_EVR_IBIF) != 0U) ||
+        ((m->regs->CFGR & I3C_CFGR_EN) == 0U))
+    {
+        return NULL;
+    }
+
+    for (uint32_t i = 0U; i < SIMHW_I3C_TARGETS; i++)
+    {
+        SimHw_I3cTarget_T *t = &g_simHwI3cTargets[i];
+        if ((t->da != 0U) && t->intEnabled && (t->ibiPeriodNs != 0U) && (t->ibiDueNs < first))
+        {
+            first = t->ibiDueNs;
+            source = t;
+        }
+    }
+
+    if (dueNs != NULL)
+    {
+        *dueNs = first;
+        return source;
+    }
+    return (first <= g_simHwStats.now_ns) ? source : NULL;
+}
+
+/**
+ * @brief Put the in-band interrupt of @p t on the bus.
+ *
+ * The controller acknowledges it when a DEVRx register holds the target
+ * address with IBIACK, and reads the payload when IBIDEN is also set, up
+ * to MAXRLR.IBIP bytes.
+ */
+static void SimHw_I3cIbiStart(SimHw_I3cTarget_T *t)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    I3C_TypeDef *r = m->regs;
+
+    m->target = t;
+    m->ibiAck = false;
+    m->ibiLen = 0U;
+    for (uint32_t i = 0U; i < 4U; i++)
+    {
+        uint32_t devr = r->DEVRX[i];
+        if ((((devr & I3C_DEVRX_DA) >> I3C_DEVRX_DA_Pos) == t->da) && ((devr & I3C_DEVRX_IBIACK) != 0U))
+        {
+            uint32_t max = (r->MAXRLR & I3C_MAXRLR_IBIP) >> I3C_MAXRLR_IBIP_Pos;
+            m->ibiAck = true;
+            if (((devr & I3C_DEVRX_IBIDEN) != 0U) && ((t->bcr & SIMHW_I3C_BCR_PAYLOAD) != 0U))
+            {
+                m->ibiLen = (uint8_t)((max < SIMHW_I3C_IBI_PAYLOAD) ? max : SIMHW_I3C_IBI_PAYLOAD);
+            }
+        }
+    }
+
+    t->ibiDueNs += t->ibiPeriodNs;
+    if (t->ibiDueNs <= g_simHwStats.now_ns)
+    {
+        t->ibiDueNs = g_simHwStats.now_ns + t->ibiPeriodNs;
+    }
+    /* START, address/R and acknowledge in open drain, payload bytes, STOP */
+    SimHw_I3cSchedule(SIMHW_I3C_IBI, (9U * m->ibiLen) + 1U, 10U);
+}
+
+/**
+ * @brief Hand received bytes to the receive DMA channel.
+ */
+static void SimHw_I3cServeRx(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    I3C_TypeDef *r = m->regs;
+
+    while ((m->rxCount != 0U) && ((r->CFGR & I3C_CFGR_RXDMAEN) != 0U))
+    {
+        *(volatile uint8_t *)&r->RDR = m->rxFifo[0];
+        if (!SimHw_DmaRequest(LL_GPDMA1_REQUEST_I3C1_RX))
+        {
+            break;
+        }
+        m->rxCount--;
+        memmove(&m->rxFifo[0], &m->rxFifo[1], m->rxCount);
+    }
+}
+
+/**
+ * @brief Put @p ppBits push-pull and @p odBits open-drain SCL periods of @p phase on the bus.
+ */
+static void SimHw_I3cSchedule(SimHw_I3cPhase_T phase, uint32_t ppBits, uint32_t odBits)
+{
+    SimHw_I3cBitNs();
+    uint64_t ns = (ppBits * g_simHwI3c.ppNs) + (odBits * g_simHwI3c.odNs);
+
+    g_simHwI3c.phase = phase;
+    g_simHwI3c.doneNs = g_simHwStats.now_ns + ns;
+    g_simHwStats.i3c_busy_ns += ns;
+}
+
+/**
+ * @brief Publish EVR, SR, SER and the head of the RX FIFO in RDR.
+ *
+ * TXFNF is raised while a write waits for TDR and while ENTDAA waits for
+ * the address of a target.
+ */
+static void SimHw_I3cPublish(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    I3C_TypeDef *r = m->regs;
+    uint32_t evr = m->flags;
+
+    if (!m->cFull)
+    {
+        evr |= I3C_EVR_CFEF | I3C_EVR_CFNFF;
+    }
+    if (!m->txFull)
+    {
+        evr |= I3C_EVR_TXFEF;
+        if ((m->phase == SIMHW_I3C_DAA_WAIT) || ((m->phase == SIMHW_I3C_STALL) && !m->read))
+        {
+            evr |= I3C_EVR_TXFNFF;
+        }
+    }
+    if (m->rxCount != 0U)
+    {
+        evr |= I3C_EVR_RXFNEF;
+    }
+    r->EVR = evr;
+    r->SER = m->ser;
+    r->SR = m->xdcnt | (m->msgId << I3C_SR_MID_Pos) | (m->read ? I3C_SR_DIR : 0U);
+    r->RDR = (m->rxCount != 0U) ? m->rxFifo[0] : 0U;
+}
+
+/**
+ * @brief Push-pull and open-drain SCL periods from TIMINGR0 and the kernel clock.
+ *
+ * Both share the SCLH_I3C high time. The result is cached until TIMINGR0
+ * changes.
+ */
+static void SimHw_I3cBitNs(void)
+{
+    SimHw_I3c_T *m = &g_simHwI3c;
+    uint32_t timingr = m->regs->TIMINGR0;
+
+    if ((timingr == m->timingKey) && (m->ppNs != 0U))
+    {
+        return;
+    }
+    m->timingKey = timingr;
+
+    bool inModel = g_simHwInModel;
+    g_simHwInModel = true;
+    uint32_t kernelClock = LL_RCC_GetI3CClockFreq(LL_RCC_I3C1_CLKSOURCE);
+    g_simHwInModel = inModel;
+
+    uint64_t high = ((timingr & I3C_TIMINGR0_SCLH_I3C) >> I3C_TIMINGR0_SCLH_I3C_Pos) + 1U;
+    uint64_t lowPp = ((timingr & I3C_TIMINGR0_SCLL_PP) >> I3C_TIMINGR0_SCLL_PP_Pos) + 1U;
+    uint64_t lowOd = ((timingr & I3C_TIMINGR0_SCLL_OD) >> I3C_TIMINGR0_SCLL_OD_Pos) + 1U;
+    if (kernelClock == 0U)
+    {
+        m->ppNs = 80U;
+        m->odNs = 1000U;
+        return;
+    }
+    m->ppNs = (((lowPp + high) * 1000000000ULL) + (kernelClock / 2U)) / kernelClock;
+    m->odNs = (((lowOd + high) * 1000000000ULL) + (kernelClock / 2U)) / kernelClock;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,273 @@
+/**
+ * @file SimHw_Lptim.c
+ * @brief Register-level model of LPTIM1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Counter from the RCC kernel clock and PRESC wrapping after ARR, live CNT,
+ * CC1IF and ARRM matches, DIEROK, ARROK and CMP1OK confirming register
+ * writes, and ICR clears.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_LPTIM_LAP        (0x10000U) /**< Counter values of the 16-bit LPTIM1 */
+/** LPTIM1 ISR flags with a DIER enable at the same position */
+#define SIMHW_LPTIM_IT_FLAGS   (LPTIM_ISR_CC1IF | LPTIM_ISR_ARRM | LPTIM_ISR_CMP1OK | LPTIM_ISR_ARROK)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of LPTIM1.
+ *
+ * Counted like the general-purpose timers, from the kernel clock cycle
+ * it last held a known value at.
+ */
+typedef struct
+{
+    LPTIM_TypeDef *regs;  /**< Register block in the mapped window */
+    bool running;         /**< ENABLE and CNTSTRT seen */
+    uint32_t flags;       /**< ISR content */
+    uint32_t div;         /**< Prescaler ratio in use */
+    uint32_t arr;         /**< Auto-reload in use */
+    uint32_t ccr;         /**< Compare in use */
+    uint32_t dier;        /**< Interrupt enables last applied */
+    uint32_t clockHz;     /**< Kernel clock latched when the counter started */
+    uint64_t originCycle; /**< Kernel clock cycle the counter held @ref originCnt at */
+    uint32_t originCnt;   /**< Count at @ref originCycle */
+    uint64_t compareNs;   /**< Next channel 1 match */
+    uint64_t arrNs;       /**< Next auto-reload match */
+} SimHw_Lptim_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Lptim_T g_simHwLptim;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_LptimEvent(void);
+static void SimHw_LptimRebase(void);
+static void SimHw_LptimSchedule(void);
+static uint32_t SimHw_LptimCount(void);
+static uint64_t SimHw_LptimCycleNs(uint64_t cycle);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply LPTIM1 register stores.
+ *
+ * ICR clears flags by writing 1. Writes to DIER, ARR and CCR1 are
+ * confirmed at once by DIEROK, ARROK and CMP1OK. Disabling the timer
+ * resets the counter; it runs once enabled with CNTSTRT set.
+ */
+void SimHw_LptimReconcile(void)
+{
+    SimHw_Lptim_T *l = &g_simHwLptim;
+    LPTIM_TypeDef *r = l->regs;
+
+    SimHw_LptimRebase();
+    uint32_t icr = r->ICR;
+    if (icr != 0U)
+    {
+        l->flags &= ~icr;
+        r->ICR = 0U;
+    }
+    if (r->DIER != l->dier)
+    {
+        l->dier = r->DIER;
+        l->flags |= LPTIM_ISR_DIEROK;
+    }
+    if ((r->ARR & LPTIM_ARR_ARR) != l->arr)
+    {
+        l->arr = r->ARR & LPTIM_ARR_ARR;
+        l->flags |= LPTIM_ISR_ARROK;
+    }
+    if ((r->CCR1 & LPTIM_CCR1_CCR1) != l->ccr)
+    {
+        l->ccr = r->CCR1 & LPTIM_CCR1_CCR1;
+        l->flags |= LPTIM_ISR_CMP1OK;
+    }
+
+    uint32_t cr = r->CR;
+    if ((cr & LPTIM_CR_ENABLE) == 0U)
+    {
+        l->running = false;
+        l->originCnt = 0U;
+    }
+    else if (((cr & LPTIM_CR_CNTSTRT) != 0U) && !l->running)
+    {
+        bool inModel = g_simHwInModel;
+        g_simHwInModel = true;
+        uint32_t clockHz = LL_RCC_GetLPTIMClockFreq(LL_RCC_LPTIM1_CLKSOURCE);
+        g_simHwInModel = inModel;
+        l->clockHz = (clockHz != 0U) ? clockHz : 1U;
+        l->div = 1UL << ((r->CFGR & LPTIM_CFGR_PRESC) >> LPTIM_CFGR_PRESC_Pos);
+        l->originCycle = (uint64_t)(((unsigned __int128)g_simHwStats.now_ns * l->clockHz) / 1000000000U);
+        l->running = true;
+    }
+    SimHw_LptimSchedule();
+    r->CNT = SimHw_LptimCount();
+    r->ISR = l->flags;
+}
+
+/**
+ * @brief Apply a CPU load from LPTIM1 CNT, which returns the live count.
+ *
+ * @retval true  The load was handled by the model.
+ * @retval false Not CNT, read memory.
+ */
+bool SimHw_LptimRead(uintptr_t addr, uint32_t *value)
+{
+    if (addr != (uintptr_t)&g_simHwLptim.regs->CNT)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    *value = SimHw_LptimCount();
+    g_simHwLptim.regs->CNT = *value;
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put LPTIM1 in the reset state.
+ */
+void SimHw_LptimReset(void)
+{
+    memset(&g_simHwLptim, 0, sizeof(g_simHwLptim));
+    g_simHwLptim.regs = LPTIM1;
+    g_simHwLptim.div = 1U;
+    g_simHwLptim.clockHz = 1U;
+    g_simHwLptim.compareNs = SIMHW_NO_EVENT;
+    g_simHwLptim.arrNs = SIMHW_NO_EVENT;
+    g_simHwLptim.regs->ARR = 1U;
+    g_simHwLptim.arr = 1U;
+}
+
+/**
+ * @brief Next compare or autoreload match.
+ */
+uint64_t SimHw_LptimNextEventNs(void)
+{
+    return (g_simHwLptim.compareNs < g_simHwLptim.arrNs) ? g_simHwLptim.compareNs : g_simHwLptim.arrNs;
+}
+
+/**
+ * @brief Handle the matches due at @p now.
+ */
+void SimHw_LptimEvents(uint64_t now)
+{
+    if ((g_simHwLptim.compareNs <= now) || (g_simHwLptim.arrNs <= now))
+    {
+        SimHw_LptimEvent();
+    }
+}
+
+/**
+ * @brief Raise the LPTIM1 interrupt while an enabled flag is set.
+ */
+void SimHw_LptimLines(void)
+{
+    if ((g_simHwLptim.flags & g_simHwLptim.dier & SIMHW_LPTIM_IT_FLAGS) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)LPTIM1_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Channel 1 or auto-reload match due: raise CC1IF or ARRM.
+ */
+static void SimHw_LptimEvent(void)
+{
+    SimHw_Lptim_T *l = &g_simHwLptim;
+    uint64_t now = g_simHwStats.now_ns;
+
+    SimHw_LptimRebase();
+    if (l->compareNs <= now)
+    {
+        g_simHwStats.lptim_compares++;
+        l->flags |= LPTIM_ISR_CC1IF;
+    }
+    if (l->arrNs <= now)
+    {
+        l->flags |= LPTIM_ISR_ARRM;
+    }
+    SimHw_LptimSchedule();
+    l->regs->CNT = SimHw_LptimCount();
+    l->regs->ISR = l->flags;
+}
+
+/**
+ * @brief Move the counter origin to the last prescaled tick before now.
+ */
+static void SimHw_LptimRebase(void)
+{
+    SimHw_Lptim_T *l = &g_simHwLptim;
+
+    if (!l->running)
+    {
+        return;
+    }
+
+    uint64_t cycle = (uint64_t)(((unsigned __int128)g_simHwStats.now_ns * l->clockHz) / 1000000000U);
+    uint64_t ticks = (cycle - l->originCycle) / l->div;
+    l->originCycle += ticks * l->div;
+    l->originCnt = (uint32_t)(((uint64_t)l->originCnt + ticks) % ((uint64_t)l->arr + 1U));
+}
+
+/**
+ * @brief Compute the next channel 1 and auto-reload matches from the counter origin.
+ *
+ * The counter wraps after ARR; a compare above ARR never matches.
+ */
+static void SimHw_LptimSchedule(void)
+{
+    SimHw_Lptim_T *l = &g_simHwLptim;
+
+    l->compareNs = SIMHW_NO_EVENT;
+    l->arrNs = SIMHW_NO_EVENT;
+    if (!l->running)
+    {
+        return;
+    }
+
+    uint64_t lap = (uint64_t)l->arr + 1U;
+    uint64_t cnt = (l->originCnt < lap) ? l->originCnt : 0U;
+    uint64_t toArr = ((l->arr + lap - cnt - 1U) % lap) + 1U;
+    l->arrNs = SimHw_LptimCycleNs(l->originCycle + (toArr * l->div));
+    if (l->ccr < lap)
+    {
+        uint64_t ticks = ((l->ccr + lap - cnt - 1U) % lap) + 1U;
+        l->compareNs = SimHw_LptimCycleNs(l->originCycle + (ticks * l->div));
+    }
+}
+
+/**
+ * @brief Count of LPTIM1 at the current time.
+ */
+static uint32_t SimHw_LptimCount(void)
+{
+    SimHw_Lptim_T *l = &g_simHwLptim;
+
+    if (!l->running)
+    {
+        return l->originCnt;
+    }
+
+    uint64_t cycle = (uint64_t)(((unsigned __int128)g_simHwStats.now_ns * l->clockHz) / 1000000000U);
+    uint64_t ticks = (cycle - l->originCycle) / l->div;
+    return (uint32_t)(((uint64_t)l->originCnt + ticks) % ((uint64_t)l->arr + 1U));
+}
+
+/**
+ * @brief Time at which LPTIM1 kernel clock cycle @p cycle starts, rounded up.
+ */
+static uint64_t SimHw_LptimCycleNs(uint64_t cycle)
+{
+    uint64_t hz = g_simHwLptim.clockHz;
+    return (uint64_t)((((unsigned __int128)cycle * 1000000000U) + hz - 1U) / hz);
+}
+
+/** @} */ // end of SimHw group
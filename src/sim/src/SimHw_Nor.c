@@ -0,0 +1,380 @@
+/**
+ * @file SimHw_Nor.c
+ * @brief Model of the NOR flash on SPI1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Selected while PA4 is driven low. Answers JEDEC ID, READ and FAST_READ,
+ * WREN and WRDI, page program and 4 KiB sector erase, busy for their
+ * duration. The contents live in a host file and a power loss can cut a
+ * chosen program or erase half way.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_NOR_PAGE         (256U)     /**< Program unit of the NOR flash */
+#define SIMHW_NOR_SECTOR       (4096U)    /**< Erase unit of the NOR flash */
+#define SIMHW_NOR_PROG_NS      (20000U)   /**< Fixed part of a page program */
+#define SIMHW_NOR_PROG_BYTE_NS (1500U)    /**< Page program time per byte */
+#define SIMHW_NOR_ERASE_NS     (25000000U) /**< Sector erase time */
+#define SIMHW_NOR_MFR_ID       (0xEFU)    /**< JEDEC manufacturer byte */
+#define SIMHW_NOR_TYPE_ID      (0x40U)    /**< JEDEC memory type byte */
+#define SIMHW_NOR_CMD_WRSR     (0x01U)
+#define SIMHW_NOR_CMD_PP       (0x02U)
+#define SIMHW_NOR_CMD_READ     (0x03U)
+#define SIMHW_NOR_CMD_WRDI     (0x04U)
+#define SIMHW_NOR_CMD_RDSR     (0x05U)
+#define SIMHW_NOR_CMD_WREN     (0x06U)
+#define SIMHW_NOR_CMD_FAST_READ (0x0BU)
+#define SIMHW_NOR_CMD_SE       (0x20U)
+#define SIMHW_NOR_CMD_JEDEC_ID (0x9FU)
+#define SIMHW_NOR_SR_WIP       (0x01U)    /**< Status: program or erase in progress */
+#define SIMHW_NOR_SR_WEL       (0x02U)    /**< Status: write enable latch */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the SPI NOR flash on SPI1, selected by PA4 low.
+ *
+ * The array is held in memory and written through to the image file at
+ * the end of every program and erase. Commands are decoded byte by byte
+ * while selected; programs and erases start when the chip select rises
+ * and keep WIP set for their duration, during which only RDSR answers.
+ */
+typedef struct
+{
+    bool selected;            /**< Chip select low */
+    bool powered;             /**< Supply present, cleared by an injected power loss */
+    bool wel;                 /**< Write enable latch */
+    uint64_t busyUntilNs;     /**< End of the running program or erase */
+    uint8_t cmd;              /**< Command of the current selection, 0 when ignored */
+    uint32_t count;           /**< Bytes exchanged in the current selection */
+    uint32_t addr;            /**< Address of the current command */
+    uint8_t prog[SIMHW_NOR_PAGE]; /**< Data of a page program, at its page offsets */
+    uint32_t progBytes;       /**< Data bytes received by a page program */
+    uint8_t *data;            /**< Array contents, loaded on first access */
+    FILE *image;              /**< Backing file, NULL to keep the array in memory only */
+    uint32_t bytes;           /**< Capacity */
+    uint32_t lossAt;          /**< Program or erase the supply fails during, 0 for none */
+    bool lossErasesOnly;      /**< @ref lossAt counts erases only */
+    uint32_t ops;             /**< Operations counted towards @ref lossAt */
+    uint32_t seed;            /**< State of the damage pattern of a cut operation */
+} SimHw_Nor_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Nor_T g_simHwNor;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_NorComplete(void);
+static bool SimHw_NorCut(bool erase);
+static bool SimHw_NorLoad(void);
+static void SimHw_NorStore(uint32_t addr, uint32_t size);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Arm a power loss of the NOR flash.
+ */
+void SimHw_NorCutPower(uint32_t afterOps, bool erasesOnly)
+{
+    g_simHwNor.lossAt = afterOps;
+    g_simHwNor.lossErasesOnly = erasesOnly;
+    g_simHwNor.ops = 0U;
+}
+
+/**
+ * @brief Restore the NOR flash supply after a power loss.
+ *
+ * The flash comes back idle, deselected by its own reset, with its write
+ * enable latch cleared.
+ */
+void SimHw_NorPowerCycle(void)
+{
+    g_simHwNor.powered = true;
+    g_simHwNor.wel = false;
+    g_simHwNor.busyUntilNs = 0U;
+    g_simHwNor.cmd = 0U;
+    g_simHwNor.count = 0U;
+}
+
+/**
+ * @brief Follow the NOR flash chip select.
+ *
+ * A falling edge starts a command, a rising edge ends it and starts the
+ * program or erase it carried.
+ */
+void SimHw_NorSelect(bool selected)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+
+    if (selected == n->selected)
+    {
+        return;
+    }
+    n->selected = selected;
+
+    if (selected)
+    {
+        n->cmd = 0U;
+        n->count = 0U;
+        n->addr = 0U;
+        n->progBytes = 0U;
+    }
+    else if (n->powered && (n->count != 0U))
+    {
+        SimHw_NorComplete();
+    }
+}
+
+/**
+ * @brief Exchange one byte with the selected flash.
+ *
+ * @param[in] mosi Byte sent by SPI1.
+ *
+ * @return Byte driven on MISO, 0xFF where the flash does not drive it.
+ */
+uint8_t SimHw_NorExchange(uint8_t mosi)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+    uint32_t index = n->count++;
+    bool busy = g_simHwStats.now_ns < n->busyUntilNs;
+
+    if (!n->powered)
+    {
+        return 0xFFU;
+    }
+    if (index == 0U)
+    {
+        /* Only the status is readable while busy */
+        n->cmd = (busy && (mosi != SIMHW_NOR_CMD_RDSR)) ? 0U : mosi;
+        if ((n->cmd == SIMHW_NOR_CMD_PP) && (n->progBytes == 0U))
+        {
+            memset(n->prog, 0xFF, sizeof(n->prog));
+        }
+        return 0xFFU;
+    }
+
+    switch (n->cmd)
+    {
+    case SIMHW_NOR_CMD_RDSR:
+        return (busy ? SIMHW_NOR_SR_WIP : 0U) | (n->wel ? SIMHW_NOR_SR_WEL : 0U);
+    case SIMHW_NOR_CMD_JEDEC_ID:
+    {
+        uint32_t log2 = 0U;
+        while ((1UL << log2) < n->bytes)
+        {
+            log2++;
+        }
+        const uint8_t id[3] = {SIMHW_NOR_MFR_ID, SIMHW_NOR_TYPE_ID, (uint8_t)log2};
+        return (index <= 3U) ? id[index - 1U] : 0xFFU;
+    }
+    case SIMHW_NOR_CMD_READ:
+    case SIMHW_NOR_CMD_FAST_READ:
+    case SIMHW_NOR_CMD_PP:
+    case SIMHW_NOR_CMD_SE:
+        if (index <= 3U)
+        {
+            n->addr = ((n->addr << 8) | mosi) & (n->bytes - 1U);
+            return 0xFFU;
+        }
+        break;
+    default:
+        return 0xFFU;
+    }
+
+    uint32_t data = index - 4U;
+    if (n->cmd == SIMHW_NOR_CMD_FAST_READ)
+    {
+        if (data == 0U)
+        {
+            return 0xFFU; /* Dummy byte */
+        }
+        data--;
+    }
+    if ((n->cmd == SIMHW_NOR_CMD_READ) || (n->cmd == SIMHW_NOR_CMD_FAST_READ))
+    {
+        return SimHw_NorLoad() ? n->data[(n->addr + data) & (n->bytes - 1U)] : 0xFFU;
+    }
+    if (n->cmd == SIMHW_NOR_CMD_PP)
+    {
+        /* Bytes past the end of the page wrap to its start */
+        n->prog[(n->addr + data) % SIMHW_NOR_PAGE] = mosi;
+        n->progBytes = (n->progBytes < SIMHW_NOR_PAGE) ? (n->progBytes + 1U) : SIMHW_NOR_PAGE;
+    }
+    return 0xFFU;
+}
+
+/**
+ * @brief Power the NOR flash up with the configured image and power loss.
+ */
+void SimHw_NorReset(void)
+{
+    memset(&g_simHwNor, 0, sizeof(g_simHwNor));
+    g_simHwNor.powered = true;
+    g_simHwNor.image = g_simHwConfig.nor_image;
+    g_simHwNor.bytes = g_simHwConfig.nor_bytes;
+    g_simHwNor.lossAt = g_simHwConfig.nor_power_loss_at;
+    g_simHwNor.seed = 0x2545F491U;
+}
+
+/**
+ * @brief The NOR flash chip select is asserted, it drives MISO.
+ */
+bool SimHw_NorIsSelected(void)
+{
+    return g_simHwNor.selected;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Execute the command ended by the chip select rising.
+ *
+ * A page program clears the bits that are 0 in its data, as NOR cells
+ * can only be programmed from 1 to 0; a sector erase sets every bit.
+ * Both need the write enable latch, which they clear.
+ */
+static void SimHw_NorComplete(void)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+    uint64_t now = g_simHwStats.now_ns;
+
+    switch (n->cmd)
+    {
+    case SIMHW_NOR_CMD_WREN:
+        n->wel = (n->count == 1U);
+        break;
+    case SIMHW_NOR_CMD_WRDI:
+        n->wel = false;
+        break;
+    case SIMHW_NOR_CMD_PP:
+        if (n->wel && (n->count > 4U) && SimHw_NorLoad())
+        {
+            uint32_t page = n->addr & ~(SIMHW_NOR_PAGE - 1U);
+            uint32_t first = n->addr % SIMHW_NOR_PAGE;
+            uint32_t bytes = n->progBytes;
+            if (SimHw_NorCut(false))
+            {
+                /* Only the first half of the bytes make it, the last of them partly */
+                bytes /= 2U;
+                n->prog[(first + bytes) % SIMHW_NOR_PAGE] |= (uint8_t)n->seed;
+                bytes++;
+            }
+            for (uint32_t i = 0U; i < bytes; i++)
+            {
+                uint32_t at = page + ((first + i) % SIMHW_NOR_PAGE);
+                n->data[at] &= n->prog[(first + i) % SIMHW_NOR_PAGE];
+            }
+            SimHw_NorStore(page, SIMHW_NOR_PAGE);
+            uint64_t ns = SIMHW_NOR_PROG_NS + ((uint64_t)n->progBytes * SIMHW_NOR_PROG_BYTE_NS);
+            n->busyUntilNs = n->powered ? (now + ns) : 0U;
+            g_simHwStats.nor_programs++;
+            g_simHwStats.nor_busy_ns += ns;
+        }
+        n->wel = false;
+        break;
+    case SIMHW_NOR_CMD_SE:
+        if (n->wel && (n->count == 4U) && SimHw_NorLoad())
+        {
+            uint32_t sector = n->addr & ~(SIMHW_NOR_SECTOR - 1U);
+            if (SimHw_NorCut(true))
+            {
+                /* Cells part way to the erased state */
+                for (uint32_t i = 0U; i < SIMHW_NOR_SECTOR; i++)
+                {
+                    n->seed ^= n->seed << 13;
+                    n->seed ^= n->seed >> 17;
+                    n->seed ^= n->seed << 5;
+                    n->data[sector + i] |= (uint8_t)n->seed;
+                }
+            }
+            else
+            {
+                memset(&n->data[sector], 0xFF, SIMHW_NOR_SECTOR);
+            }
+            SimHw_NorStore(sector, SIMHW_NOR_SECTOR);
+            n->busyUntilNs = n->powered ? (now + SIMHW_NOR_ERASE_NS) : 0U;
+            g_simHwStats.nor_erases++;
+            g_simHwStats.nor_busy_ns += SIMHW_NOR_ERASE_NS;
+        }
+        n->wel = false;
+        break;
+    case SIMHW_NOR_CMD_WRSR:
+        n->wel = false;
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Count a program or erase towards the armed power loss.
+ *
+ * @param[in] erase The operation is an erase.
+ *
+ * @retval true The supply fails during this operation; the flash stops
+ *              answering until ::SimHw_NorPowerCycle.
+ */
+static bool SimHw_NorCut(bool erase)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+
+    if ((n->lossAt == 0U) || (!erase && n->lossErasesOnly))
+    {
+        return false;
+    }
+    n->ops++;
+    if (n->ops < n->lossAt)
+    {
+        return false;
+    }
+
+    n->lossAt = 0U;
+    n->powered = false;
+    n->wel = false;
+    g_simHwStats.nor_power_losses++;
+    return true;
+}
+
+/**
+ * @brief Load the array from the image file on first access.
+ *
+ * Bytes beyond the end of the file read as erased.
+ */
+static bool SimHw_NorLoad(void)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+
+    if (n->data != NULL)
+    {
+        return true;
+    }
+    n->data = malloc(n->bytes);
+    if (n->data == NULL)
+    {
+        return false;
+    }
+    memset(n->data, 0xFF, n->bytes);
+    if ((n->image != NULL) && (fseek(n->image, 0L, SEEK_SET) == 0))
+    {
+        (void)fread(n->data, 1U, n->bytes, n->image);
+    }
+    return true;
+}
+
+/**
+ * @brief Write a changed range of the array through to the image file.
+ */
+static void SimHw_NorStore(uint32_t addr, uint32_t size)
+{
+    SimHw_Nor_T *n = &g_simHwNor;
+
+    if ((n->image != NULL) && (fseek(n->image, (long)addr, SEEK_SET) == 0))
+    {
+        (void)fwrite(&n->data[addr], 1U, size, n->image);
+        (void)fflush(n->image);
+    }
+}
+
+/** @} */ // end of SimHw group
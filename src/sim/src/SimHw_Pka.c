@@ -0,0 +1,301 @@
+/**
+ * @file SimHw_Pka.c
+ * @brief Register-level model of the PKA.
+ * @ingroup SimHw
+ * @{
+ *
+ * RAM initialisation on enable, ECDSA verification and modular exponentiation
+ * computed by the software reference after a modelled duration, end of
+ * operation and error interrupts.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_pka.h"
+#include "Pka.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_PKA_INIT_NS      (2000U)   /**< PKA RAM initialisation after EN */
+#define SIMHW_PKA_RESULT_OK    (0xD60DU) /**< Result word of a successful PKA operation */
+#define SIMHW_PKA_RESULT_FAIL  (0xA3B7U) /**< Result word of a failed one */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the PKA.
+ */
+typedef struct
+{
+    PKA_TypeDef *regs;  /**< Register block in the mapped window */
+    bool enabled;       /**< EN seen set */
+    bool ready;         /**< RAM initialisation done, INITOK */
+    bool busy;          /**< Operation running */
+    uint32_t flags;     /**< SR end and error flags */
+    uint64_t doneNs;    /**< End of the initialisation or of the operation */
+} SimHw_Pka_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Pka_T g_simHwPka;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static uint64_t SimHw_PkaDurationNs(uint32_t mode);
+static void SimHw_PkaDone(void);
+static void SimHw_PkaLoad(uint32_t index, uint8_t *dst, uint32_t size);
+static void SimHw_PkaPublish(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply PKA register stores.
+ *
+ * Setting EN starts the RAM initialisation, clearing it aborts any
+ * operation. START is taken when the PKA is idle and initialised and
+ * cleared at once; the operation runs when it ends, on the RAM content
+ * of that time. CLRFR is write-one-to-clear and reads as zero.
+ */
+void SimHw_PkaReconcile(void)
+{
+    SimHw_Pka_T *g = &g_simHwPka;
+    PKA_TypeDef *r = g->regs;
+
+    if (r->CLRFR != 0U)
+    {
+        g->flags &= ~(r->CLRFR & (PKA_SR_PROCENDF | PKA_SR_RAMERRF | PKA_SR_ADDRERRF | PKA_SR_OPERRF));
+        r->CLRFR = 0U;
+    }
+
+    bool enabled = (r->CR & PKA_CR_EN) != 0U;
+    if (enabled && !g->enabled)
+    {
+        g->doneNs = g_simHwStats.now_ns + SIMHW_PKA_INIT_NS;
+    }
+    else if (!enabled && g->enabled)
+    {
+        g->ready = false;
+        g->busy = false;
+        g->flags = 0U;
+        g->doneNs = SIMHW_NO_EVENT;
+    }
+    g->enabled = enabled;
+
+    if ((r->CR & PKA_CR_START) != 0U)
+    {
+        r->CR &= ~PKA_CR_START;
+        if (g->ready && !g->busy)
+        {
+            uint64_t ns = SimHw_PkaDurationNs((r->CR & PKA_CR_MODE) >> PKA_CR_MODE_Pos);
+            if (ns == 0U)
+            {
+                g->flags |= PKA_SR_OPERRF;
+            }
+            else
+            {
+                g->busy = true;
+                g->doneNs = g_simHwStats.now_ns + ns;
+            }
+        }
+    }
+
+    SimHw_PkaPublish();
+}
+
+/**
+ * @brief Put the PKA in the reset state.
+ */
+void SimHw_PkaReset(void)
+{
+    memset(&g_simHwPka, 0, sizeof(g_simHwPka));
+    g_simHwPka.regs = PKA;
+    g_simHwPka.doneNs = SIMHW_NO_EVENT;
+    SimHw_PkaPublish();
+}
+
+/**
+ * @brief End of the RAM initialisation or of the running operation.
+ */
+uint64_t SimHw_PkaNextEventNs(void)
+{
+    return g_simHwPka.doneNs;
+}
+
+/**
+ * @brief Complete the step ending at @p now.
+ */
+void SimHw_PkaEvents(uint64_t now)
+{
+    if (g_simHwPka.doneNs <= now)
+    {
+        SimHw_PkaDone();
+    }
+}
+
+/**
+ * @brief Raise the PKA interrupt while an enabled flag is set.
+ */
+void SimHw_PkaLines(void)
+{
+    /* The PKA interrupt enables sit at the bit positions of their flags */
+    PKA_TypeDef *pka = g_simHwPka.regs;
+    if ((pka->SR & pka->CR & (PKA_SR_PROCENDF | PKA_SR_RAMERRF | PKA_SR_ADDRERRF | PKA_SR_OPERRF)) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)PKA_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Duration of an operation on the operands in the PKA RAM.
+ *
+ * Counts the modular multiplications of the operation, each costing
+ * pka_word_mul_ns per product of 32-bit words of the operands:
+ *  - ECDSA verification, 20 per bit of the order, which covers the
+ *    doublings and additions of a joint scalar multiplication and the
+ *    two inversions,
+ *  - modular exponentiation, one squaring per exponent bit and one
+ *    multiplication per set bit.
+ *
+ * @return Time in ns, 0 for a mode the model does not implement.
+ */
+static uint64_t SimHw_PkaDurationNs(uint32_t mode)
+{
+    const volatile uint32_t *ram = g_simHwPka.regs->RAM;
+    uint64_t muls;
+    uint64_t words;
+
+    if (mode == LL_PKA_MODE_ECDSA_VERIFICATION)
+    {
+        uint32_t bits = ram[PKA_ECDSA_VERIF_IN_ORDER_NB_BITS];
+        words = (bits + 31U) / 32U;
+        muls = 20ULL * bits;
+    }
+    else if (mode == LL_PKA_MODE_MODULAR_EXP)
+    {
+        uint32_t expBits = ram[PKA_MODULAR_EXP_IN_EXP_NB_BITS];
+        words = (ram[PKA_MODULAR_EXP_IN_OP_NB_BITS] + 31U) / 32U;
+        muls = expBits;
+        for (uint32_t w = 0U; w < ((expBits + 31U) / 32U); w++)
+        {
+            muls += (uint64_t)__builtin_popcount(ram[PKA_MODULAR_EXP_IN_EXPONENT + w]);
+        }
+    }
+    else
+    {
+        return 0U;
+    }
+
+    uint64_t ns = muls * words * words * g_simHwConfig.pka_word_mul_ns;
+    return (ns != 0U) ? ns : 1U;
+}
+
+/**
+ * @brief End the RAM initialisation or the running operation.
+ *
+ * Operations are computed by the software reference of the PKA service,
+ * so the model checks the operand layout the driver writes, not the
+ * arithmetic. Sizes the PKA RAM cannot hold raise OPERRF.
+ */
+static void SimHw_PkaDone(void)
+{
+    SimHw_Pka_T *g = &g_simHwPka;
+    volatile uint32_t *ram = g->regs->RAM;
+    g->doneNs = SIMHW_NO_EVENT;
+
+    if (!g->ready)
+    {
+        g->ready = true;
+        SimHw_PkaPublish();
+        return;
+    }
+
+    static uint8_t op[7][PKA_MAX_MOD_BYTES];
+    uint32_t mode = (g->regs->CR & PKA_CR_MODE) >> PKA_CR_MODE_Pos;
+    g->busy = false;
+    g->flags |= PKA_SR_PROCENDF;
+    g_simHwStats.pka_ops++;
+
+    if (mode == LL_PKA_MODE_ECDSA_VERIFICATION)
+    {
+        uint32_t bits = ram[PKA_ECDSA_VERIF_IN_MOD_NB_BITS];
+        uint32_t size = (bits + 7U) / 8U;
+        if ((bits == 0U) || (size > PKA_MAX_ECC_BYTES) || (ram[PKA_ECDSA_VERIF_IN_ORDER_NB_BITS] != bits))
+        {
+            g->flags |= PKA_SR_OPERRF;
+            SimHw_PkaPublish();
+            return;
+        }
+
+        static const uint32_t index[7] = {
+            PKA_ECDSA_VERIF_IN_MOD_GF,           PKA_ECDSA_VERIF_IN_A_COEFF,          PKA_ECDSA_VERIF_IN_INITIAL_POINT_X,
+            PKA_ECDSA_VERIF_IN_INITIAL_POINT_Y,  PKA_ECDSA_VERIF_IN_ORDER_N,          PKA_ECDSA_VERIF_IN_PUBLIC_KEY_POINT_X,
+            PKA_ECDSA_VERIF_IN_PUBLIC_KEY_POINT_Y};
+        for (uint32_t i = 0U; i < 7U; i++)
+        {
+            SimHw_PkaLoad(index[i], op[i], size);
+        }
+        uint8_t r[PKA_MAX_ECC_BYTES];
+        uint8_t s[PKA_MAX_ECC_BYTES];
+        uint8_t e[PKA_MAX_ECC_BYTES];
+        SimHw_PkaLoad(PKA_ECDSA_VERIF_IN_SIGNATURE_R, r, size);
+        SimHw_PkaLoad(PKA_ECDSA_VERIF_IN_SIGNATURE_S, s, size);
+        SimHw_PkaLoad(PKA_ECDSA_VERIF_IN_HASH_E, e, size);
+
+        Pka_Curve_T curve = {size, bits, op[0], op[1], ram[PKA_ECDSA_VERIF_IN_A_COEFF_SIGN] != 0U,
+                             op[2], op[3], op[4]};
+        Pka_Ecdsa_T in = {op[5], op[6], r, s, e};
+        ram[PKA_ECDSA_VERIF_OUT_RESULT] =
+            (Pka_RefEcdsaVerify(&curve, &in) == PKA_OK) ? SIMHW_PKA_RESULT_OK : SIMHW_PKA_RESULT_FAIL;
+    }
+    else
+    {
+        uint32_t expSize = (ram[PKA_MODULAR_EXP_IN_EXP_NB_BITS] + 7U) / 8U;
+        uint32_t modSize = (ram[PKA_MODULAR_EXP_IN_OP_NB_BITS] + 7U) / 8U;
+        if ((modSize == 0U) || (modSize > PKA_MAX_MOD_BYTES) || (expSize == 0U) || (expSize > modSize))
+        {
+            g->flags |= PKA_SR_OPERRF;
+            SimHw_PkaPublish();
+            return;
+        }
+
+        SimHw_PkaLoad(PKA_MODULAR_EXP_IN_EXPONENT_BASE, op[0], modSize);
+        SimHw_PkaLoad(PKA_MODULAR_EXP_IN_EXPONENT, op[1], expSize);
+        SimHw_PkaLoad(PKA_MODULAR_EXP_IN_MODULUS, op[2], modSize);
+        bool ok = Pka_RefModExp(op[0], op[1], expSize, op[2], modSize, op[3]) == PKA_OK;
+        for (uint32_t w = 0U; ok && (w < ((modSize + 3U) / 4U)); w++)
+        {
+            uint32_t word = 0U;
+            for (uint32_t b = 0U; b < 4U; b++)
+            {
+                uint32_t pos = (w * 4U) + b;
+                word |= (pos < modSize) ? ((uint32_t)op[3][modSize - 1U - pos] << (b * 8U)) : 0U;
+            }
+            ram[PKA_MODULAR_EXP_OUT_RESULT + w] = word;
+        }
+        ram[PKA_MODULAR_EXP_OUT_ERROR] = ok ? SIMHW_PKA_RESULT_OK : SIMHW_PKA_RESULT_FAIL;
+    }
+
+    SimHw_PkaPublish();
+}
+
+/**
+ * @brief Read a little-endian word operand at RAM word @p index as @p size big-endian bytes.
+ */
+static void SimHw_PkaLoad(uint32_t index, uint8_t *dst, uint32_t size)
+{
+    const volatile uint32_t *ram = g_simHwPka.regs->RAM;
+
+    for (uint32_t pos = 0U; pos < size; pos++)
+    {
+        dst[size - 1U - pos] = (uint8_t)(ram[index + (pos / 4U)] >> ((pos % 4U) * 8U));
+    }
+}
+
+/**
+ * @brief Publish SR.
+ */
+static void SimHw_PkaPublish(void)
+{
+    SimHw_Pka_T *g = &g_simHwPka;
+
+    g->regs->SR = g->flags | (g->ready ? PKA_SR_INITOK : 0U) | (g->busy ? PKA_SR_BUSY : 0U);
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,238 @@
+/**
+ * @file SimHw_Rng.c
+ * @brief Register-level model of the RNG.
+ * @ingroup SimHw
+ * @{
+ *
+ * Four-word output FIFO refilled at a fixed rate, DRDY and error interrupts,
+ * seed and clock errors injected on request and cleared through the CONDRST
+ * sequence.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_RNG_FIFO_DEPTH   (4U)     /**< Words held by the RNG output FIFO */
+#define SIMHW_RNG_CLOCK_ERR_NS (20000U) /**< Length of an injected RNG clock error */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the RNG.
+ */
+typedef struct
+{
+    RNG_TypeDef *regs;                  /**< Register block in the mapped window */
+    uint32_t fifo[SIMHW_RNG_FIFO_DEPTH]; /**< Output FIFO, oldest first */
+    uint32_t fifoCount;                 /**< Words in the FIFO */
+    uint32_t flags;                     /**< SR error bits owned by the model */
+    bool condReset;                     /**< CONDRST seen set, generation held */
+    uint64_t nextNs;                    /**< Next word, or end of a clock error */
+    uint64_t state;                     /**< Generator state */
+    uint64_t words;                     /**< Words generated, counting injected faults */
+} SimHw_Rng_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Rng_T g_simHwRng;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_RngSchedule(void);
+static void SimHw_RngGenerate(void);
+static void SimHw_RngPublish(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply RNG register stores.
+ *
+ * Error flags are cleared by writing 0 to them. Setting CONDRST flushes
+ * the FIFO and holds generation; clearing it restarts the conditioning,
+ * which ends a seed error.
+ */
+void SimHw_RngReconcile(void)
+{
+    SimHw_Rng_T *g = &g_simHwRng;
+    RNG_TypeDef *r = g->regs;
+
+    g->flags &= r->SR | ~(RNG_SR_CEIS | RNG_SR_SEIS);
+
+    bool condReset = (r->CR & RNG_CR_CONDRST) != 0U;
+    if (condReset && !g->condReset)
+    {
+        g->fifoCount = 0U;
+        g->nextNs = SIMHW_NO_EVENT;
+    }
+    else if (!condReset && g->condReset)
+    {
+        g->flags &= ~RNG_SR_SECS;
+    }
+    g->condReset = condReset;
+
+    SimHw_RngSchedule();
+    SimHw_RngPublish();
+}
+
+/**
+ * @brief Apply a CPU load from the RNG data register.
+ *
+ * @retval true  @p value holds the oldest FIFO word, 0 when empty.
+ * @retval false Not the data register, load as memory.
+ */
+bool SimHw_RngRead(uintptr_t addr, uint32_t *value)
+{
+    SimHw_Rng_T *g = &g_simHwRng;
+
+    if (addr != (uintptr_t)&g->regs->DR)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    *value = 0U;
+    if (g->fifoCount != 0U)
+    {
+        *value = g->fifo[0];
+        g->fifoCount--;
+        for (uint32_t i = 0U; i < g->fifoCount; i++)
+        {
+            g->fifo[i] = g->fifo[i + 1U];
+        }
+    }
+    SimHw_RngSchedule();
+    SimHw_RngPublish();
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put the RNG in the reset state, held in conditioning reset.
+ */
+void SimHw_RngReset(void)
+{
+    memset(&g_simHwRng, 0, sizeof(g_simHwRng));
+    g_simHwRng.regs = RNG;
+    g_simHwRng.regs->CR = RNG_CR_CONDRST;
+    g_simHwRng.condReset = true;
+    g_simHwRng.nextNs = SIMHW_NO_EVENT;
+    g_simHwRng.state = 0x9E3779B97F4A7C15ULL;
+    SimHw_RngPublish();
+}
+
+/**
+ * @brief Time the next word enters the output FIFO.
+ */
+uint64_t SimHw_RngNextEventNs(void)
+{
+    return g_simHwRng.nextNs;
+}
+
+/**
+ * @brief Generate the word due at @p now.
+ */
+void SimHw_RngEvents(uint64_t now)
+{
+    if (g_simHwRng.nextNs <= now)
+    {
+        SimHw_RngGenerate();
+    }
+}
+
+/**
+ * @brief Raise the RNG interrupt on data ready or an error while IE is set.
+ */
+void SimHw_RngLines(void)
+{
+    RNG_TypeDef *rng = g_simHwRng.regs;
+    if (((rng->CR & RNG_CR_IE) != 0U) && ((rng->SR & (RNG_SR_DRDY | RNG_SR_CEIS | RNG_SR_SEIS)) != 0U))
+    {
+        SimHw_SetPending(16U + (uint32_t)RNG_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Schedule the next word while the RNG runs and the FIFO has room.
+ *
+ * A pending clock error end is kept, it is the next event of the RNG.
+ */
+static void SimHw_RngSchedule(void)
+{
+    SimHw_Rng_T *g = &g_simHwRng;
+    bool running = ((g->regs->CR & RNG_CR_RNGEN) != 0U) && !g->condReset &&
+                   ((g->flags & (RNG_SR_SECS | RNG_SR_CECS)) == 0U);
+
+    if ((g->flags & RNG_SR_CECS) != 0U)
+    {
+        return;
+    }
+    if (!running || (g->fifoCount >= SIMHW_RNG_FIFO_DEPTH))
+    {
+        g->nextNs = SIMHW_NO_EVENT;
+    }
+    else if (g->nextNs == SIMHW_NO_EVENT)
+    {
+        g->nextNs = g_simHwStats.now_ns + g_simHwConfig.rng_word_ns;
+    }
+}
+
+/**
+ * @brief Produce the next word, or end a clock error.
+ *
+ * Every rng_fault_every-th word is replaced by a fault, alternately a seed
+ * error, which flushes the FIFO and lasts until the CONDRST sequence, and
+ * a clock error of ::SIMHW_RNG_CLOCK_ERR_NS when CED leaves detection on.
+ */
+static void SimHw_RngGenerate(void)
+{
+    SimHw_Rng_T *g = &g_simHwRng;
+    g->nextNs = SIMHW_NO_EVENT;
+
+    if ((g->flags & RNG_SR_CECS) != 0U)
+    {
+        g->flags &= ~RNG_SR_CECS;
+    }
+    else
+    {
+        g->words++;
+        uint32_t every = g_simHwConfig.rng_fault_every;
+        if ((every != 0U) && ((g->words % every) == 0U))
+        {
+            g_simHwStats.rng_faults++;
+            if ((((g->words / every) & 1U) != 0U) || ((g->regs->CR & RNG_CR_CED) != 0U))
+            {
+                g->flags |= RNG_SR_SECS | RNG_SR_SEIS;
+                g->fifoCount = 0U;
+            }
+            else
+            {
+                g->flags |= RNG_SR_CECS | RNG_SR_CEIS;
+                g->nextNs = g_simHwStats.now_ns + SIMHW_RNG_CLOCK_ERR_NS;
+            }
+        }
+        else
+        {
+            /* splitmix64 */
+            uint64_t z = (g->state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            g->fifo[g->fifoCount++] = (uint32_t)(z ^ (z >> 31));
+            g_simHwStats.rng_words++;
+        }
+    }
+
+    SimHw_RngSchedule();
+    SimHw_RngPublish();
+}
+
+/**
+ * @brief Publish SR and the head of the FIFO in DR.
+ */
+static void SimHw_RngPublish(void)
+{
+    SimHw_Rng_T *g = &g_simHwRng;
+
+    g->regs->SR = g->flags | ((g->fifoCount != 0U) ? RNG_SR_DRDY : 0U);
+    g->regs->DR = (g->fifoCount != 0U) ? g->fifo[0] : 0U;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,405 @@
+/**
+ * @file SimHw_Rtc.c
+ * @brief Register-level model of the RTC.
+ * @ingroup SimHw
+ * @{
+ *
+ * Calendar and sub-second counter on the clock RTCSEL selects, running off
+ * its nominal frequency by a configured error, INIT freezing and restarting
+ * it, TR and DR latched by an SSR read, SHIFTR and CALR applied at once and
+ * the wake-up timer raising WUTF with its interrupt.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_RTC_CAL_WINDOW   (1UL << 20) /**< RTC clock cycles of one smooth calibration window */
+#define SIMHW_RTC_DR_RESET     (0x00002101UL) /**< DR after a backup domain reset: Monday 2000-01-01 */
+#define SIMHW_RTC_PRER_RESET   (0x007F00FFUL) /**< PRER after a backup domain reset */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the RTC.
+ *
+ * The calendar is a count of sub-second ticks since 2000-01-01, advanced
+ * from the RTC clock cycle it last held a known value at. The smooth
+ * calibration stretches or shrinks the cycles the calendar sees, the
+ * wake-up timer counts them raw. The RTC clock runs off its nominal
+ * frequency by the configured error.
+ */
+typedef struct
+{
+    RTC_TypeDef *regs;    /**< Register block in the mapped window */
+    bool running;         /**< The calendar counts: INIT left with a clock selected */
+    bool locked;          /**< TR and DR hold the values latched by an SSR read until DR is read */
+    uint32_t hz;          /**< Nominal RTC clock latched from RTCSEL */
+    uint32_t prediv;      /**< RTC clock cycles per sub-second tick, PREDIV_A + 1 */
+    uint32_t secondTicks; /**< Sub-second ticks per second, PREDIV_S + 1 */
+    uint32_t calr;        /**< Calibration in use */
+    uint64_t originCycle; /**< RTC clock cycle the calendar held @ref originTicks at */
+    uint64_t originTicks; /**< Ticks since 2000-01-01 at @ref originCycle */
+    uint64_t originRem;   /**< Fraction of a tick at @ref originCycle, in calibration units */
+    uint64_t wakePeriod;  /**< RTC clock cycles per wake-up */
+    uint64_t wakeCycle;   /**< RTC clock cycle of the next wake-up */
+    uint64_t wakeNs;      /**< Time of the next wake-up */
+} SimHw_Rtc_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Rtc_T g_simHwRtc;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_RtcEvent(void);
+static void SimHw_RtcRebase(void);
+static void SimHw_RtcPublish(volatile uint32_t *ssr);
+static uint32_t SimHw_RtcClockHz(void);
+static uint64_t SimHw_RtcCycle(void);
+static uint64_t SimHw_RtcCycleNs(uint64_t cycle);
+static uint64_t SimHw_RtcWindow(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply the RTC registers whose writes act rather than store.
+ *
+ * Entering INIT freezes the calendar into TR and DR; leaving it restarts
+ * the calendar from them on the clock RTCSEL selects, with the sub-second
+ * counter at PREDIV_S. Setting WUTE starts the wake-up timer from WUTR,
+ * clearing it stops the timer. SCR clears SR flags, SHIFTR adds a second
+ * and delays the calendar by SUBFS ticks at once, CALR changes the
+ * calibration from now on. Write protection is not modelled.
+ *
+ * @retval true  @p addr is ICSR, CR, SCR, SHIFTR or CALR.
+ * @retval false Any other register, written as plain memory.
+ */
+bool SimHw_RtcWrite(uintptr_t addr, uint32_t value)
+{
+    SimHw_Rtc_T *c = &g_simHwRtc;
+    RTC_TypeDef *r = c->regs;
+
+    g_simHwInModel = true;
+    if (addr == (uintptr_t)&r->ICSR)
+    {
+        bool init = (value & RTC_ICSR_INIT) != 0U;
+        bool wasInit = (r->ICSR & RTC_ICSR_INIT) != 0U;
+        if (init && !wasInit && c->running)
+        {
+            SimHw_RtcPublish(NULL);
+            c->running = false;
+            c->locked = false;
+        }
+        else if (!init && wasInit)
+        {
+            uint32_t tr = r->TR;
+            uint32_t dr = r->DR;
+            uint32_t year = 2000U + (((dr & RTC_DR_YT) >> RTC_DR_YT_Pos) * 10U) + ((dr & RTC_DR_YU) >> RTC_DR_YU_Pos);
+            uint32_t month = (((dr & RTC_DR_MT) != 0U) ? 10U : 0U) + ((dr & RTC_DR_MU) >> RTC_DR_MU_Pos);
+            uint32_t day = (((dr & RTC_DR_DT) >> RTC_DR_DT_Pos) * 10U) + ((dr & RTC_DR_DU) >> RTC_DR_DU_Pos);
+            uint64_t days = 0U;
+            for (uint32_t y = 2000U; y < year; y++)
+            {
+                days += ((y % 4U) == 0U) ? 366U : 365U;
+            }
+            for (uint32_t m = 1U; (m < month) && (m <= 12U); m++)
+            {
+                days += (m == 2U) ? (((year % 4U) == 0U) ? 29U : 28U) : (30U + ((m + (m / 8U)) % 2U));
+            }
+            days += (day > 0U) ? (day - 1U) : 0U;
+            uint64_t seconds = (days * 86400U) +
+                               (((((tr & RTC_TR_HT) >> RTC_TR_HT_Pos) * 10U) + ((tr & RTC_TR_HU) >> RTC_TR_HU_Pos)) * 3600U) +
+                               (((((tr & RTC_TR_MNT) >> RTC_TR_MNT_Pos) * 10U) + ((tr & RTC_TR_MNU) >> RTC_TR_MNU_Pos)) * 60U) +
+                               (((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10U) + ((tr & RTC_TR_SU) >> RTC_TR_SU_Pos);
+
+            c->hz = SimHw_RtcClockHz();
+            c->prediv = ((r->PRER & RTC_PRER_PREDIV_A) >> RTC_PRER_PREDIV_A_Pos) + 1U;
+            c->secondTicks = (r->PRER & RTC_PRER_PREDIV_S) + 1U;
+            c->calr = r->CALR;
+            c->originCycle = SimHw_RtcCycle();
+            c->originTicks = seconds * c->secondTicks;
+            c->originRem = 0U;
+            c->running = c->hz != 0U;
+            r->SSR = c->secondTicks - 1U;
+        }
+        r->ICSR = value & RTC_ICSR_INIT;
+    }
+    else if (addr == (uintptr_t)&r->CR)
+    {
+        uint32_t rising = value & ~r->CR;
+        r->CR = value;
+        if ((value & RTC_CR_WUTE) == 0U)
+        {
+            c->wakeNs = SIMHW_NO_EVENT;
+        }
+        else if ((rising & RTC_CR_WUTE) != 0U)
+        {
+            if (!c->running)
+            {
+                c->hz = SimHw_RtcClockHz();
+            }
+            /* WUCKSEL 0 to 3 divide the RTC clock by 16 to 2; 4 to 7 count seconds, taken as nominal */
+            uint32_t wucksel = value & RTC_CR_WUCKSEL;
+            uint64_t count = (uint64_t)(r->WUTR & RTC_WUTR_WUT) + 1U + ((wucksel >= 6U) ? 0x10000U : 0U);
+            c->wakePeriod = count * ((wucksel < 4U) ? (16U >> wucksel) : c->hz);
+            c->wakeCycle = SimHw_RtcCycle() + c->wakePeriod;
+            c->wakeNs = (c->hz != 0U) ? SimHw_RtcCycleNs(c->wakeCycle) : SIMHW_NO_EVENT;
+        }
+    }
+    else if (addr == (uintptr_t)&r->SCR)
+    {
+        r->SR &= ~value;
+    }
+    else if (addr == (uintptr_t)&r->SHIFTR)
+    {
+        if (c->running)
+        {
+            SimHw_RtcRebase();
+            c->originTicks += ((value & RTC_SHIFTR_ADD1S) != 0U) ? c->secondTicks : 0U;
+            c->originTicks -= value & RTC_SHIFTR_SUBFS;
+        }
+    }
+    else if (addr == (uintptr_t)&r->CALR)
+    {
+        uint64_t window = SimHw_RtcWindow();
+        SimHw_RtcRebase();
+        c->calr = value;
+        r->CALR = value;
+        c->originRem = (c->originRem * SimHw_RtcWindow()) / window;
+    }
+    else
+    {
+        g_simHwInModel = false;
+        return false;
+    }
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Apply a CPU load from the RTC calendar or status registers.
+ *
+ * SSR latches the calendar into TR and DR, which then hold until DR is
+ * read. ICSR reports INITF with INIT, RSF always, INITS once the year is
+ * set, and neither a pending shift nor a pending recalibration: both
+ * apply at once.
+ *
+ * @retval true  The load was handled by the model.
+ * @retval false Any other register, read memory.
+ */
+bool SimHw_RtcRead(uintptr_t addr, uint32_t *value)
+{
+    SimHw_Rtc_T *c = &g_simHwRtc;
+    RTC_TypeDef *r = c->regs;
+
+    if (addr == (uintptr_t)&r->ICSR)
+    {
+        uint32_t icsr = r->ICSR | RTC_ICSR_RSF | RTC_ICSR_WUTWF;
+        icsr |= ((icsr & RTC_ICSR_INIT) != 0U) ? RTC_ICSR_INITF : 0U;
+        icsr |= ((r->DR & (RTC_DR_YT | RTC_DR_YU)) != 0U) ? RTC_ICSR_INITS : 0U;
+        *value = icsr;
+        return true;
+    }
+    if ((addr != (uintptr_t)&r->SSR) && (addr != (uintptr_t)&r->TR) && (addr != (uintptr_t)&r->DR))
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    if (addr == (uintptr_t)&r->SSR)
+    {
+        SimHw_RtcPublish(&r->SSR);
+        c->locked = c->running;
+    }
+    else if (!c->locked)
+    {
+        SimHw_RtcPublish(NULL);
+    }
+    else if (addr == (uintptr_t)&r->DR)
+    {
+        c->locked = false;
+    }
+    *value = *(volatile uint32_t *)addr;
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put the RTC in the backup domain reset state.
+ */
+void SimHw_RtcReset(void)
+{
+    memset(&g_simHwRtc, 0, sizeof(g_simHwRtc));
+    g_simHwRtc.regs = RTC;
+    g_simHwRtc.regs->DR = SIMHW_RTC_DR_RESET;
+    g_simHwRtc.regs->PRER = SIMHW_RTC_PRER_RESET;
+    g_simHwRtc.prediv = 1U;
+    g_simHwRtc.secondTicks = 1U;
+    g_simHwRtc.wakeNs = SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief Next wake-up.
+ */
+uint64_t SimHw_RtcNextEventNs(void)
+{
+    return g_simHwRtc.wakeNs;
+}
+
+/**
+ * @brief Raise the wake-up due at @p now.
+ */
+void SimHw_RtcEvents(uint64_t now)
+{
+    if (g_simHwRtc.wakeNs <= now)
+    {
+        SimHw_RtcEvent();
+    }
+}
+
+/**
+ * @brief Raise the RTC interrupt while WUTF is set and enabled.
+ */
+void SimHw_RtcLines(void)
+{
+    if (((g_simHwRtc.regs->SR & RTC_SR_WUTF) != 0U) && ((g_simHwRtc.regs->CR & RTC_CR_WUTIE) != 0U))
+    {
+        SimHw_SetPending(16U + (uint32_t)RTC_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Wake-up timer reload due: raise WUTF.
+ */
+static void SimHw_RtcEvent(void)
+{
+    SimHw_Rtc_T *c = &g_simHwRtc;
+
+    c->regs->SR |= RTC_SR_WUTF;
+    g_simHwStats.rtc_wakeups++;
+    c->wakeCycle += c->wakePeriod;
+    c->wakeNs = SimHw_RtcCycleNs(c->wakeCycle);
+}
+
+/**
+ * @brief Move the calendar origin to the current RTC clock cycle.
+ */
+static void SimHw_RtcRebase(void)
+{
+    SimHw_Rtc_T *c = &g_simHwRtc;
+
+    if (!c->running)
+    {
+        return;
+    }
+
+    uint64_t cycle = SimHw_RtcCycle();
+    uint64_t window = SimHw_RtcWindow();
+    uint64_t units = c->originRem + ((cycle - c->originCycle) * SIMHW_RTC_CAL_WINDOW);
+    c->originTicks += units / window;
+    c->originRem = units % window;
+    c->originCycle = cycle;
+}
+
+/**
+ * @brief Write the current calendar into TR and DR, and the sub-second count into @p ssr.
+ *
+ * Leaves the registers as they are while the calendar is stopped.
+ */
+static void SimHw_RtcPublish(volatile uint32_t *ssr)
+{
+    SimHw_Rtc_T *c = &g_simHwRtc;
+    RTC_TypeDef *r = c->regs;
+
+    if (!c->running)
+    {
+        return;
+    }
+
+    SimHw_RtcRebase();
+    uint64_t seconds = c->originTicks / c->secondTicks;
+    uint64_t days = seconds / 86400U;
+    uint32_t rest = (uint32_t)(seconds % 86400U);
+    /* 2000-01-01 was a Saturday, WDU counts from Monday = 1 */
+    uint32_t weekday = (uint32_t)(((days + 5U) % 7U) + 1U);
+    uint32_t year = 2000U;
+    while (days >= (((year % 4U) == 0U) ? 366U : 365U))
+    {
+        days -= ((year % 4U) == 0U) ? 366U : 365U;
+        year++;
+    }
+    uint32_t month = 1U;
+    for (;;)
+    {
+        uint32_t len = (month == 2U) ? (((year % 4U) == 0U) ? 29U : 28U) : (30U + ((month + (month / 8U)) % 2U));
+        if (days < len)
+        {
+            break;
+        }
+        days -= len;
+        month++;
+    }
+    uint32_t day = (uint32_t)days + 1U;
+    uint32_t hour = rest / 3600U;
+    uint32_t minute = (rest / 60U) % 60U;
+    uint32_t second = rest % 60U;
+    year = (year - 2000U) % 100U;
+
+    r->TR = ((((hour / 10U) << 4U) | (hour % 10U)) << RTC_TR_HU_Pos) |
+            ((((minute / 10U) << 4U) | (minute % 10U)) << RTC_TR_MNU_Pos) |
+            ((((second / 10U) << 4U) | (second % 10U)) << RTC_TR_SU_Pos);
+    r->DR = ((((year / 10U) << 4U) | (year % 10U)) << RTC_DR_YU_Pos) | (weekday << RTC_DR_WDU_Pos) |
+            ((((month / 10U) << 4U) | (month % 10U)) << RTC_DR_MU_Pos) |
+            ((((day / 10U) << 4U) | (day % 10U)) << RTC_DR_DU_Pos);
+    if (ssr != NULL)
+    {
+        *ssr = (c->secondTicks - 1U) - (uint32_t)(c->originTicks % c->secondTicks);
+    }
+}
+
+/**
+ * @brief Nominal RTC clock selected by RTCSEL, 0 when none runs.
+ */
+static uint32_t SimHw_RtcClockHz(void)
+{
+    uint32_t rtcsel = RCC->CCIPR7 & RCC_CCIPR7_RTCSEL;
+
+    if (rtcsel == LL_RCC_RTC_CLKSOURCE_LSE)
+    {
+        return LSE_VALUE;
+    }
+    return (rtcsel == LL_RCC_RTC_CLKSOURCE_LSI) ? LSI_VALUE : 0U;
+}
+
+/**
+ * @brief RTC clock cycles since time zero, the clock error included.
+ */
+static uint64_t SimHw_RtcCycle(void)
+{
+    unsigned __int128 rate = (unsigned __int128)g_simHwRtc.hz * (uint64_t)(1000000000LL + g_simHwConfig.rtc_ppb);
+    return (uint64_t)(((unsigned __int128)g_simHwStats.now_ns * rate) / 1000000000000000000ULL);
+}
+
+/**
+ * @brief Time at which RTC clock cycle @p cycle starts, rounded up.
+ */
+static uint64_t SimHw_RtcCycleNs(uint64_t cycle)
+{
+    unsigned __int128 rate = (unsigned __int128)g_simHwRtc.hz * (uint64_t)(1000000000LL + g_simHwConfig.rtc_ppb);
+    return (uint64_t)((((unsigned __int128)cycle * 1000000000000000000ULL) + rate - 1U) / rate);
+}
+
+/**
+ * @brief Calibration units per sub-second tick.
+ *
+ * Each RTC clock cycle brings 2^20 units; CALP and CALM make a tick take
+ * 2^20 + CALM - 512 x CALP of them per prescaler cycle.
+ */
+static uint64_t SimHw_RtcWindow(void)
+{
+    const SimHw_Rtc_T *c = &g_simHwRtc;
+    uint64_t cycle = SIMHW_RTC_CAL_WINDOW + (c->calr & RTC_CALR_CALM) - (((c->calr & RTC_CALR_CALP) != 0U) ? 512U : 0U);
+    return cycle * c->prediv;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,760 @@
+/**
+ * @file SimHw_Sdmmc.c
+ * @brief Register-level model of SDMMC1 and its SD card.
+ * @ingroup SimHw
+ * @{
+ *
+ * Commands timed on the bus clock with R1/R2/R3/R6/R7 responses and CTIMEOUT
+ * when the card does not answer, multi-block transfers through the IDMA in
+ * single-buffer or linked-list mode with IDMABTC, IDMATE, DATAEND and DABORT,
+ * and busy on D0 after CMD12. The card is an SDHC card whose blocks live in a
+ * host file.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_SD_RCA           (0x5A3CU)  /**< Relative address the card publishes */
+#define SIMHW_SD_POWER_UP_NS   (1000000U) /**< Busy time of ACMD41 after power-up or CMD0 */
+#define SIMHW_SD_NCR_CLOCKS    (8U)       /**< Clocks between the end of a command and its response */
+#define SIMHW_SD_TIMEOUT_CLOCKS (64U)     /**< Clocks the controller waits for a response */
+#define SIMHW_SD_BLOCK_CLOCKS  (18U)      /**< Start, CRC and end bits around every data block */
+#define SIMHW_SD_READ_NS       (100000U)  /**< Access time before the first block of a read */
+#define SIMHW_SD_PROG_NS       (30000U)   /**< Programming time of a written block */
+#define SIMHW_SD_PROG_ERASED_NS (15000U)  /**< Programming time of a block pre-erased through ACMD23 */
+#define SIMHW_SD_STOP_BUSY_NS  (50000U)   /**< Busy on D0 after CMD12 ends a write */
+#define SIMHW_SD_OCR           (0x00FF8000UL) /**< OCR voltage window, 2.7-3.6 V */
+#define SIMHW_SD_OCR_READY     (0x80000000UL) /**< OCR: power-up done */
+#define SIMHW_SD_OCR_CCS       (0x40000000UL) /**< OCR: block-addressed card */
+#define SIMHW_SD_R1_READY      (0x00000100UL) /**< R1 READY_FOR_DATA */
+#define SIMHW_SD_R1_APP        (0x00000020UL) /**< R1 APP_CMD */
+#define SIMHW_SD_R1_ILLEGAL    (0x00400000UL) /**< R1 ILLEGAL_COMMAND */
+#define SIMHW_SD_R1_RANGE      (0x80000000UL) /**< R1 OUT_OF_RANGE */
+/** STA flags owned by the model, cleared through ICR at the same position. */
+#define SIMHW_SD_FLAGS         (0x1FE00FFFUL)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Card state, as reported in CURRENT_STATE of R1.
+ */
+typedef enum
+{
+    SIMHW_SD_IDLE = 0U, /**< After power-up or CMD0 */
+    SIMHW_SD_READY,     /**< ACMD41 done */
+    SIMHW_SD_IDENT,     /**< CID sent */
+    SIMHW_SD_STBY,      /**< Address published, not selected */
+    SIMHW_SD_TRAN,      /**< Selected, no transfer */
+    SIMHW_SD_DATA,      /**< Sending blocks */
+    SIMHW_SD_RCV,       /**< Receiving blocks */
+    SIMHW_SD_PRG,       /**< Programming after CMD12 */
+} SimHw_SdState_T;
+
+/**
+ * @brief State of SDMMC1 and of the SDHC card on its bus.
+ *
+ * The card contents live in a host file, read and written at the end of
+ * every IDMA buffer.
+ */
+typedef struct
+{
+    SDMMC_TypeDef *regs;   /**< Register block in the mapped window */
+    bool powered;          /**< PWRCTRL applied */
+    uint32_t flags;        /**< STA static flags */
+    uint32_t clockKey[2];  /**< CLKCR and CCIPR8 the cached bus clock was computed from */
+    uint32_t busHz;        /**< Cached bus clock */
+    uint32_t width;        /**< Data lines selected by WIDBUS */
+    uint32_t cmd;          /**< CMD register of the command on the line */
+    bool answered;         /**< The card answers the command on the line */
+    bool noCrc;            /**< Its response carries no CRC (R3) */
+    uint32_t resp[4];      /**< Its response */
+    uint64_t cmdDoneNs;    /**< End of the command and its response */
+    SimHw_SdState_T state; /**< Card state */
+    bool app;              /**< CMD55 seen, the next command is an application command */
+    uint64_t readyNs;      /**< ACMD41 reports the card ready from this time */
+    uint32_t eraseCount;   /**< Blocks of the last ACMD23, for the next write */
+    uint32_t eraseEnd;     /**< End of the pre-erased blocks of the running write */
+    bool dataActive;       /**< The data path moves a buffer */
+    bool read;             /**< Direction of the data path */
+    uint32_t lba;          /**< Block at the start of the current buffer */
+    uint32_t left;         /**< Bytes of DLEN not yet transferred */
+    uint32_t bufSize;      /**< Bytes of the current buffer */
+    uint64_t dataDoneNs;   /**< End of the current buffer */
+    uint64_t busyDoneNs;   /**< End of busy on D0 */
+    FILE *image;           /**< Card contents */
+    uint32_t blocks;       /**< Card capacity */
+} SimHw_Sdmmc_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Sdmmc_T g_simHwSdmmc;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_SdmmcCommand(uint32_t cmd);
+static bool SimHw_SdmmcRespond(uint32_t index, uint32_t arg, bool app);
+static void SimHw_SdmmcCmdDone(void);
+static void SimHw_SdmmcDataStart(void);
+static void SimHw_SdmmcBuffer(bool first);
+static void SimHw_SdmmcBufferDone(void);
+static void SimHw_SdmmcDmaError(void);
+static void SimHw_SdmmcDataStop(void);
+static void SimHw_SdmmcEvent(void);
+static void SimHw_SdmmcAccess(bool read, uint32_t lba, uintptr_t addr, uint32_t size);
+static void SimHw_SdmmcClock(void);
+static uint64_t SimHw_SdmmcClocksNs(uint64_t clocks);
+static void SimHw_SdmmcPublish(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply SDMMC1 register stores.
+ *
+ * ICR clears flags by writing 1. Switching the power on or off resets the
+ * card to its idle state. The bus clock follows CLKDIV, WIDBUS and the
+ * kernel clock selected in the RCC.
+ */
+void SimHw_SdmmcReconcile(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    SDMMC_TypeDef *r = s->regs;
+
+    uint32_t icr = r->ICR;
+    if (icr != 0U)
+    {
+        s->flags &= ~(icr & SIMHW_SD_FLAGS);
+        r->ICR = 0U;
+    }
+
+    bool powered = ((r->POWER & SDMMC_POWER_PWRCTRL) == SDMMC_POWER_PWRCTRL);
+    if (powered != s->powered)
+    {
+        s->powered = powered;
+        s->state = SIMHW_SD_IDLE;
+        s->app = false;
+        s->readyNs = g_simHwStats.now_ns + SIMHW_SD_POWER_UP_NS;
+        s->cmdDoneNs = SIMHW_NO_EVENT;
+        s->busyDoneNs = SIMHW_NO_EVENT;
+        SimHw_SdmmcDataStop();
+    }
+    SimHw_SdmmcClock();
+    SimHw_SdmmcPublish();
+}
+
+/**
+ * @brief Apply a CPU store to SDMMC1 CMD, which sends the command when CPSMEN is set.
+ *
+ * @retval true  The store was handled by the model.
+ * @retval false Not CMD, store as memory.
+ */
+bool SimHw_SdmmcWrite(uintptr_t addr, uint32_t value)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+
+    if (addr != (uintptr_t)&s->regs->CMD)
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    s->regs->CMD = value;
+    if ((value & SDMMC_CMD_CPSMEN) != 0U)
+    {
+        SimHw_SdmmcCommand(value);
+    }
+    SimHw_SdmmcPublish();
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put SDMMC1 in the reset state and power the card off.
+ */
+void SimHw_SdmmcReset(void)
+{
+    memset(&g_simHwSdmmc, 0, sizeof(g_simHwSdmmc));
+    g_simHwSdmmc.regs = SDMMC1;
+    g_simHwSdmmc.busHz = 1U;
+    g_simHwSdmmc.width = 1U;
+    g_simHwSdmmc.cmdDoneNs = SIMHW_NO_EVENT;
+    g_simHwSdmmc.dataDoneNs = SIMHW_NO_EVENT;
+    g_simHwSdmmc.busyDoneNs = SIMHW_NO_EVENT;
+    g_simHwSdmmc.image = g_simHwConfig.sd_image;
+    g_simHwSdmmc.blocks = g_simHwConfig.sd_blocks;
+}
+
+/**
+ * @brief Earliest end of the command, data or busy phase.
+ */
+uint64_t SimHw_SdmmcNextEventNs(void)
+{
+    uint64_t next = g_simHwSdmmc.cmdDoneNs;
+    if (g_simHwSdmmc.dataDoneNs < next)
+    {
+        next = g_simHwSdmmc.dataDoneNs;
+    }
+    if (g_simHwSdmmc.busyDoneNs < next)
+    {
+        next = g_simHwSdmmc.busyDoneNs;
+    }
+    return next;
+}
+
+/**
+ * @brief End the phases due at @p now.
+ */
+void SimHw_SdmmcEvents(uint64_t now)
+{
+    if ((g_simHwSdmmc.cmdDoneNs <= now) || (g_simHwSdmmc.dataDoneNs <= now) || (g_simHwSdmmc.busyDoneNs <= now))
+    {
+        SimHw_SdmmcEvent();
+    }
+}
+
+/**
+ * @brief Raise the SDMMC1 interrupt while an unmasked flag is set.
+ */
+void SimHw_SdmmcLines(void)
+{
+    if ((g_simHwSdmmc.flags & g_simHwSdmmc.regs->MASK) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)SDMMC1_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Put a command on the line.
+ *
+ * CMDSTOP stops the data path at once, as the controller does when it
+ * sends CMD12, and DABORT reports data cut short. The card decides its
+ * answer now; the response flags rise once it has been clocked in, or
+ * CTIMEOUT once the controller gave up waiting for it.
+ */
+static void SimHw_SdmmcCommand(uint32_t cmd)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint32_t wait = cmd & SDMMC_CMD_WAITRESP;
+    uint64_t clocks = 48U;
+    bool app = s->app;
+
+    g_simHwStats.sd_commands++;
+    if (((cmd & SDMMC_CMD_CMDSTOP) != 0U) && s->dataActive)
+    {
+        s->flags |= SDMMC_STA_DABORT;
+        SimHw_SdmmcDataStop();
+    }
+
+    s->cmd = cmd;
+    s->app = false;
+    s->noCrc = false;
+    memset(s->resp, 0, sizeof(s->resp));
+    s->answered = s->powered && SimHw_SdmmcRespond(cmd & SDMMC_CMD_CMDINDEX, s->regs->ARG, app);
+    if (wait != 0U)
+    {
+        clocks += SIMHW_SD_NCR_CLOCKS;
+        if (!s->answered)
+        {
+            clocks += SIMHW_SD_TIMEOUT_CLOCKS;
+        }
+        else
+        {
+            clocks += (wait == SDMMC_CMD_WAITRESP) ? 136U : 48U;
+        }
+    }
+    s->cmdDoneNs = g_simHwStats.now_ns + SimHw_SdmmcClocksNs(clocks);
+}
+
+/**
+ * @brief Card side of a command: change state and build the response.
+ *
+ * The card holds a single SDHC partition of @ref SimHw_Sdmmc_T::blocks
+ * blocks and answers the identification, selection and multi-block
+ * commands. A command not allowed in the current state is ignored, as on
+ * a real card.
+ *
+ * @param[in] index Command index.
+ * @param[in] arg   Argument.
+ * @param[in] app   CMD55 preceded it.
+ *
+ * @retval true  The card answers.
+ * @retval false No response.
+ */
+static bool SimHw_SdmmcRespond(uint32_t index, uint32_t arg, bool app)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint32_t r1 = ((uint32_t)s->state << 9) | SIMHW_SD_R1_READY | (app ? SIMHW_SD_R1_APP : 0U);
+    bool addressed = ((arg >> 16) == SIMHW_SD_RCA);
+    uint32_t cSize = (s->blocks / 1024U) - 1U;
+
+    if (app)
+    {
+        switch (index)
+        {
+        case 6U:
+            /* SET_BUS_WIDTH: the width itself is taken from WIDBUS */
+            s->resp[0] = r1;
+            return (s->state == SIMHW_SD_TRAN);
+        case 23U:
+            /* SET_WR_BLK_ERASE_COUNT, valid for the next write */
+            s->eraseCount = arg & 0x7FFFFFU;
+            s->resp[0] = r1;
+            return (s->state == SIMHW_SD_TRAN);
+        case 41U:
+            /* SD_SEND_OP_COND: R3 carries the OCR and no CRC */
+            if (s->state != SIMHW_SD_IDLE)
+            {
+                return false;
+            }
+            s->noCrc = true;
+            s->resp[0] = SIMHW_SD_OCR;
+            if ((g_simHwStats.now_ns >= s->readyNs) && ((arg & SIMHW_SD_OCR) != 0U))
+            {
+                s->resp[0] |= SIMHW_SD_OCR_READY | SIMHW_SD_OCR_CCS;
+                s->state = SIMHW_SD_READY;
+            }
+            return true;
+        default:
+            break;
+        }
+    }
+
+    switch (index)
+    {
+    case 0U:
+        s->state = SIMHW_SD_IDLE;
+        s->readyNs = g_simHwStats.now_ns + SIMHW_SD_POWER_UP_NS;
+        return false;
+    case 2U:
+        if (s->state != SIMHW_SD_READY)
+        {
+            return false;
+        }
+        s->state = SIMHW_SD_IDENT;
+        s->resp[0] = 0x53534D53UL; /* "SMS" manufacturer and OEM */
+        s->resp[1] = 0x494D5344UL; /* "IMSD" product name */
+        s->resp[2] = 0x10000001UL;
+        s->resp[3] = 0x00019A01UL;
+        return true;
+    case 3U:
+        if ((s->state != SIMHW_SD_IDENT) && (s->state != SIMHW_SD_STBY))
+        {
+            return false;
+        }
+        s->state = SIMHW_SD_STBY;
+        s->resp[0] = (SIMHW_SD_RCA << 16) | (r1 & 0x1FFFU);
+        return true;
+    case 7U:
+        if (!addressed)
+        {
+            /* Deselected cards do not answer */
+            if (s->state == SIMHW_SD_TRAN)
+            {
+                s->state = SIMHW_SD_STBY;
+            }
+            return false;
+        }
+        if ((s->state != SIMHW_SD_STBY) && (s->state != SIMHW_SD_TRAN))
+        {
+            return false;
+        }
+        s->state = SIMHW_SD_TRAN;
+        s->resp[0] = r1;
+        return true;
+    case 8U:
+        if (s->state != SIMHW_SD_IDLE)
+        {
+            return false;
+        }
+        s->resp[0] = arg & 0xFFFU;
+        return true;
+    case 9U:
+        if ((s->state != SIMHW_SD_STBY) || !addressed)
+        {
+            return false;
+        }
+        /* CSD version 2.0: C_SIZE in CSD bits 69:48, capacity (C_SIZE + 1) x 512 KiB */
+        s->resp[0] = 0x400E0032UL;
+        s->resp[1] = 0x5B590000UL | ((cSize >> 16) & 0x3FU);
+        s->resp[2] = ((cSize & 0xFFFFU) << 16) | 0x7F80U;
+        s->resp[3] = 0x0A400000UL;
+        return true;
+    case 12U:
+        if (s->state == SIMHW_SD_DATA)
+        {
+            s->state = SIMHW_SD_TRAN;
+        }
+        else if (s->state == SIMHW_SD_RCV)
+        {
+            s->state = SIMHW_SD_PRG;
+        }
+        else
+        {
+            return false;
+        }
+        s->resp[0] = r1;
+        return true;
+    case 18U:
+    case 25U:
+        if (s->state != SIMHW_SD_TRAN)
+        {
+            return false;
+        }
+        s->resp[0] = r1;
+        if (arg >= s->blocks)
+        {
+            s->resp[0] |= SIMHW_SD_R1_RANGE;
+            return true;
+        }
+        s->state = (index == 18U) ? SIMHW_SD_DATA : SIMHW_SD_RCV;
+        s->lba = arg;
+        return true;
+    case 55U:
+        if ((s->state != SIMHW_SD_IDLE) && !addressed)
+        {
+            return false;
+        }
+        s->app = true;
+        s->resp[0] = r1 | SIMHW_SD_R1_APP;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief End of a command and its response.
+ *
+ * CMDTRANS starts the data path once the card accepted the data command.
+ * After CMD12 ends a write the card holds D0 low while it programs.
+ */
+static void SimHw_SdmmcCmdDone(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    SDMMC_TypeDef *r = s->regs;
+    volatile uint32_t *resp = (volatile uint32_t *)&r->RESP1;
+
+    s->cmdDoneNs = SIMHW_NO_EVENT;
+    if ((s->cmd & SDMMC_CMD_WAITRESP) == 0U)
+    {
+        s->flags |= SDMMC_STA_CMDSENT;
+        return;
+    }
+    if (!s->answered)
+    {
+        s->flags |= SDMMC_STA_CTIMEOUT;
+        return;
+    }
+
+    for (uint32_t i = 0U; i < 4U; i++)
+    {
+        resp[i] = s->resp[i];
+    }
+    *(volatile uint32_t *)&r->RESPCMD = s->cmd & SDMMC_CMD_CMDINDEX;
+    s->flags |= s->noCrc ? SDMMC_STA_CCRCFAIL : SDMMC_STA_CMDREND;
+
+    if (((s->cmd & SDMMC_CMD_CMDTRANS) != 0U) && ((s->state == SIMHW_SD_DATA) || (s->state == SIMHW_SD_RCV)))
+    {
+        SimHw_SdmmcDataStart();
+    }
+    if (s->state == SIMHW_SD_PRG)
+    {
+        s->busyDoneNs = g_simHwStats.now_ns + SIMHW_SD_STOP_BUSY_NS;
+        g_simHwStats.sd_busy_ns += SIMHW_SD_STOP_BUSY_NS;
+    }
+}
+
+/**
+ * @brief Start the data path over DLEN bytes.
+ *
+ * Only transfers through the IDMA are modelled: without IDMAEN, or with a
+ * first list buffer not acknowledged by ABR, the data path fails at once.
+ * The blocks of a write inside the count of the last ACMD23 program
+ * faster.
+ */
+static void SimHw_SdmmcDataStart(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    SDMMC_TypeDef *r = s->regs;
+    uint32_t idma = r->IDMACTRL;
+
+    s->read = ((r->DCTRL & SDMMC_DCTRL_DTDIR) != 0U);
+    s->left = r->DLEN & SDMMC_DLEN_DATALENGTH;
+    s->eraseEnd = s->read ? s->lba : (s->lba + s->eraseCount);
+    s->eraseCount = 0U;
+    if (((idma & SDMMC_IDMA_IDMAEN) == 0U) || (s->left == 0U))
+    {
+        s->flags |= SDMMC_STA_DTIMEOUT;
+        return;
+    }
+    if (((idma & SDMMC_IDMA_IDMABMODE) != 0U) && ((r->IDMALAR & SDMMC_IDMALAR_ABR) == 0U))
+    {
+        SimHw_SdmmcDmaError();
+        return;
+    }
+
+    s->dataActive = true;
+    SimHw_SdmmcBuffer(true);
+}
+
+/**
+ * @brief Schedule the end of the current IDMA buffer.
+ *
+ * Every block takes its data bits on the bus width in use plus start,
+ * CRC and end bits. A read waits for the card access time before its
+ * first block; a write waits for every block to be programmed.
+ *
+ * @param[in] first First buffer of the transfer.
+ */
+static void SimHw_SdmmcBuffer(bool first)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    SDMMC_TypeDef *r = s->regs;
+    uint32_t size = s->left;
+
+    if ((r->IDMACTRL & SDMMC_IDMA_IDMABMODE) != 0U)
+    {
+        size = r->IDMABSIZE & SDMMC_IDMABSIZE_IDMABNDT;
+        size = (size < s->left) ? size : s->left;
+    }
+    if (size == 0U)
+    {
+        SimHw_SdmmcDmaError();
+        return;
+    }
+
+    uint32_t blocks = (size + 511U) / 512U;
+    uint64_t ns = blocks * SimHw_SdmmcClocksNs(((512U * 8U) / s->width) + SIMHW_SD_BLOCK_CLOCKS);
+    if (s->read)
+    {
+        ns += first ? SIMHW_SD_READ_NS : 0U;
+    }
+    else
+    {
+        uint32_t erased = (s->eraseEnd > s->lba) ? (s->eraseEnd - s->lba) : 0U;
+        erased = (erased < blocks) ? erased : blocks;
+        ns += ((uint64_t)erased * SIMHW_SD_PROG_ERASED_NS) + ((uint64_t)(blocks - erased) * SIMHW_SD_PROG_NS);
+    }
+    s->bufSize = size;
+    s->dataDoneNs = g_simHwStats.now_ns + ns;
+    g_simHwStats.sd_busy_ns += ns;
+}
+
+/**
+ * @brief End of an IDMA buffer: move its data and load the next buffer.
+ *
+ * In linked-list mode the next buffer comes from the item at IDMABAR plus
+ * the offset in IDMALAR, which must carry ABR. DATAEND rises once DLEN
+ * bytes have moved.
+ */
+static void SimHw_SdmmcBufferDone(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    SDMMC_TypeDef *r = s->regs;
+    uintptr_t addr = r->IDMABASER;
+    bool list = ((r->IDMACTRL & SDMMC_IDMA_IDMABMODE) != 0U);
+
+    s->dataDoneNs = SIMHW_NO_EVENT;
+    if (!SimHw_IsReachable(addr, s->bufSize))
+    {
+        SimHw_SdmmcDmaError();
+        return;
+    }
+
+    SimHw_SdmmcAccess(s->read, s->lba, addr, s->bufSize);
+    g_simHwStats.sd_bytes += s->bufSize;
+    s->lba += s->bufSize / 512U;
+    s->left -= s->bufSize;
+    if (list)
+    {
+        s->flags |= SDMMC_STA_IDMABTC;
+    }
+    if (s->left == 0U)
+    {
+        s->flags |= SDMMC_STA_DATAEND;
+        SimHw_SdmmcDataStop();
+        return;
+    }
+
+    uint32_t lar = r->IDMALAR;
+    uintptr_t item = (uintptr_t)r->IDMABAR + (lar & SDMMC_IDMALAR_IDMALA);
+    if (!list || ((lar & SDMMC_IDMALAR_ULA) == 0U) || !SimHw_IsReachable(item, 3U * sizeof(uint32_t)))
+    {
+        SimHw_SdmmcDmaError();
+        return;
+    }
+    uint32_t words[3];
+    SimHw_DCacheDmaRead(item, words, sizeof(words));
+    uint32_t next = words[0];
+    if ((next & SDMMC_IDMALAR_ABR) == 0U)
+    {
+        SimHw_SdmmcDmaError();
+        return;
+    }
+    r->IDMABASER = words[1];
+    if ((lar & SDMMC_IDMALAR_ULS) != 0U)
+    {
+        r->IDMABSIZE = words[2];
+    }
+    r->IDMALAR = next;
+    SimHw_SdmmcBuffer(false);
+}
+
+/**
+ * @brief IDMA transfer error: the data path stops and reports a timeout with IDMATE.
+ */
+static void SimHw_SdmmcDmaError(void)
+{
+    g_simHwSdmmc.flags |= SDMMC_STA_IDMATE | SDMMC_STA_DTIMEOUT;
+    SimHw_SdmmcDataStop();
+}
+
+/**
+ * @brief Stop the data path.
+ */
+static void SimHw_SdmmcDataStop(void)
+{
+    g_simHwSdmmc.dataActive = false;
+    g_simHwSdmmc.dataDoneNs = SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief Command, buffer or busy end due.
+ */
+static void SimHw_SdmmcEvent(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint64_t now = g_simHwStats.now_ns;
+
+    if (s->cmdDoneNs <= now)
+    {
+        SimHw_SdmmcCmdDone();
+    }
+    if (s->dataDoneNs <= now)
+    {
+        SimHw_SdmmcBufferDone();
+    }
+    if (s->busyDoneNs <= now)
+    {
+        s->busyDoneNs = SIMHW_NO_EVENT;
+        s->state = SIMHW_SD_TRAN;
+        s->flags |= SDMMC_STA_BUSYD0END;
+    }
+    SimHw_SdmmcPublish();
+}
+
+/**
+ * @brief Move one buffer between memory and the card image.
+ *
+ * Memory is accessed block by block through the data cache model. Blocks
+ * never written read as zero. Without an image the card is backed by a
+ * temporary file, created on first use.
+ */
+static void SimHw_SdmmcAccess(bool read, uint32_t lba, uintptr_t addr, uint32_t size)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint8_t block[512];
+    bool seek = false;
+
+    if (s->image == NULL)
+    {
+        s->image = tmpfile();
+    }
+    if (s->image != NULL)
+    {
+        seek = (fseek(s->image, (long)lba * 512L, SEEK_SET) == 0);
+    }
+    for (uint32_t at = 0U; at < size; at += sizeof(block))
+    {
+        size_t n = ((size - at) < sizeof(block)) ? (size - at) : sizeof(block);
+        if (read)
+        {
+            size_t done = seek ? fread(block, 1U, n, s->image) : 0U;
+            memset(block + done, 0, n - done);
+            SimHw_DCacheDmaWrite(addr + at, block, n);
+        }
+        else
+        {
+            SimHw_DCacheDmaRead(addr + at, block, n);
+            if (seek)
+            {
+                (void)fwrite(block, 1U, n, s->image);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Recompute the bus clock and width when CLKCR or the kernel clock selection changed.
+ *
+ * The bus runs at the kernel clock divided by 2 x CLKDIV, or at the
+ * kernel clock with CLKDIV at 0.
+ */
+static void SimHw_SdmmcClock(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint32_t clkcr = s->regs->CLKCR;
+    uint32_t ccipr = RCC->CCIPR8;
+
+    if ((clkcr == s->clockKey[0]) && (ccipr == s->clockKey[1]) && (s->busHz > 1U))
+    {
+        return;
+    }
+    s->clockKey[0] = clkcr;
+    s->clockKey[1] = ccipr;
+
+    bool inModel = g_simHwInModel;
+    g_simHwInModel = true;
+    uint32_t kernelHz = LL_RCC_GetSDMMCClockFreq(LL_RCC_SDMMC1_CLKSOURCE);
+    g_simHwInModel = inModel;
+    uint32_t div = clkcr & SDMMC_CLKCR_CLKDIV;
+    uint32_t hz = (div == 0U) ? kernelHz : (kernelHz / (2U * div));
+    s->busHz = (hz != 0U) ? hz : 1U;
+
+    switch ((clkcr & SDMMC_CLKCR_WIDBUS) >> SDMMC_CLKCR_WIDBUS_Pos)
+    {
+    case 1U:
+        s->width = 4U;
+        break;
+    case 2U:
+        s->width = 8U;
+        break;
+    default:
+        s->width = 1U;
+        break;
+    }
+}
+
+/**
+ * @brief Time of @p clocks bus clock cycles, rounded up.
+ */
+static uint64_t SimHw_SdmmcClocksNs(uint64_t clocks)
+{
+    uint64_t hz = g_simHwSdmmc.busHz;
+    return (uint64_t)((((unsigned __int128)clocks * 1000000000U) + hz - 1U) / hz);
+}
+
+/**
+ * @brief Publish STA and DCOUNT.
+ */
+static void SimHw_SdmmcPublish(void)
+{
+    SimHw_Sdmmc_T *s = &g_simHwSdmmc;
+    uint32_t sta = s->flags;
+
+    if (s->dataActive)
+    {
+        sta |= SDMMC_STA_DPSMACT;
+    }
+    if (s->cmdDoneNs != SIMHW_NO_EVENT)
+    {
+        sta |= SDMMC_STA_CPSMACT;
+    }
+    if (s->busyDoneNs != SIMHW_NO_EVENT)
+    {
+        sta |= SDMMC_STA_BUSYD0;
+    }
+    *(volatile uint32_t *)&s->regs->STA = sta;
+    *(volatile uint32_t *)&s->regs->DCOUNT = s->left;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,331 @@
+/**
+ * @file SimHw_Spi.c
+ * @brief Register-level model of SPI1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Master with MOSI looped back to MISO, frame time from the kernel clock and
+ * MBR/BPASS, TX and RX FIFOs served by DMA, TSIZE count with TXTF and EOT,
+ * overrun when RX is not drained and CSUSP suspend. While the NOR flash is
+ * selected its answers replace the loopback.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_SPI_FIFO_DEPTH   (16U)     /**< Bytes held by each SPI1 FIFO */
+/** SR flags owned by the model and cleared through IFCR. */
+#define SIMHW_SPI_FLAGS        (SPI_SR_EOT | SPI_SR_TXTF | SPI_SR_OVR | SPI_SR_SUSP)
+#define SIMHW_SPI_IT_FLAGS     (0x3FFU)  /**< SR flags with an IER enable at the same position */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of SPI1 as a master, MOSI looped back to MISO.
+ */
+typedef struct
+{
+    SPI_TypeDef *regs;                    /**< Register block in the mapped window */
+    bool enabled;                         /**< SPE seen set */
+    uint8_t txFifo[SIMHW_SPI_FIFO_DEPTH]; /**< Bytes waiting to be shifted out */
+    uint32_t txHead;                      /**< Index of the oldest TX entry */
+    uint32_t txCount;                     /**< Bytes in the TX FIFO */
+    uint8_t rxFifo[SIMHW_SPI_FIFO_DEPTH]; /**< Bytes received, oldest first */
+    uint32_t rxHead;                      /**< Index of the oldest RX entry */
+    uint32_t rxCount;                     /**< Bytes in the RX FIFO */
+    bool shifting;                        /**< A frame is on the line */
+    uint8_t shiftByte;                    /**< Frame being exchanged */
+    uint64_t shiftStartNs;                /**< Start of the frame on the line */
+    uint64_t shiftDoneNs;                 /**< End of the frame on the line */
+    uint32_t size;                        /**< TSIZE latched when SPE was set, 0 for endless */
+    uint32_t pushed;                      /**< Frames written to the TX FIFO since SPE */
+    uint32_t done;                        /**< Frames exchanged since SPE */
+    uint32_t flags;                       /**< SR flags owned by the model */
+    uint32_t cfgKey;                      /**< CFG1 the cached frame time was computed from */
+    uint64_t frameNs;                     /**< Cached frame duration */
+} SimHw_Spi_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Spi_T g_simHwSpi;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_SpiPush(uint8_t data);
+static void SimHw_SpiKick(void);
+static void SimHw_SpiShiftDone(void);
+static void SimHw_SpiPublish(void);
+static uint64_t SimHw_SpiFrameNs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply SPI1 register stores and refresh the transfer.
+ *
+ * Setting SPE latches TSIZE and restarts the frame counts, clearing it
+ * flushes both FIFOs and drops CSTART. CSUSP stops the transfer once the
+ * frame on the line is complete, as SUSP reports.
+ */
+void SimHw_SpiReconcile(void)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+    SPI_TypeDef *r = s->regs;
+
+    uint32_t ifcr = r->IFCR;
+    if (ifcr != 0U)
+    {
+        s->flags &= ~(ifcr & SIMHW_SPI_FLAGS);
+        r->IFCR = 0U;
+    }
+
+    bool enabled = (r->CR1 & SPI_CR1_SPE) != 0U;
+    if (enabled && !s->enabled)
+    {
+        s->size = r->CR2 & SPI_CR2_TSIZE;
+        s->pushed = 0U;
+        s->done = 0U;
+    }
+    else if (!enabled)
+    {
+        s->txCount = 0U;
+        s->rxCount = 0U;
+        s->shifting = false;
+        r->CR1 &= ~(SPI_CR1_CSTART | SPI_CR1_CSUSP);
+    }
+    s->enabled = enabled;
+
+    if ((r->CR1 & SPI_CR1_CSUSP) != 0U)
+    {
+        r->CR1 &= ~(SPI_CR1_CSUSP | SPI_CR1_CSTART);
+        if (!s->shifting)
+        {
+            s->flags |= SPI_SR_SUSP;
+        }
+    }
+
+    SimHw_SpiKick();
+}
+
+/**
+ * @brief Put SPI1 in the reset state.
+ */
+void SimHw_SpiReset(void)
+{
+    memset(&g_simHwSpi, 0, sizeof(g_simHwSpi));
+    g_simHwSpi.regs = SPI1;
+    g_simHwSpi.regs->CFG1 = 0x00070007UL;
+    SimHw_SpiPublish();
+}
+
+/**
+ * @brief End of the frame being shifted.
+ */
+uint64_t SimHw_SpiNextEventNs(void)
+{
+    return g_simHwSpi.shifting ? g_simHwSpi.shiftDoneNs : SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief End the frame due at @p now or start the next one.
+ */
+void SimHw_SpiEvents(uint64_t now)
+{
+    if (g_simHwSpi.shifting && (g_simHwSpi.shiftDoneNs <= now))
+    {
+        SimHw_SpiShiftDone();
+    }
+    else if (!g_simHwSpi.shifting)
+    {
+        SimHw_SpiKick();
+    }
+}
+
+/**
+ * @brief Raise the SPI1 interrupt while an enabled flag is set.
+ */
+void SimHw_SpiLines(void)
+{
+    /* The SPI interrupt enables sit at the bit positions of their flags */
+    SPI_TypeDef *spi = g_simHwSpi.regs;
+    if ((spi->SR & spi->IER & SIMHW_SPI_IT_FLAGS) != 0U)
+    {
+        SimHw_SetPending(16U + (uint32_t)SPI1_IRQn);
+    }
+}
+
+/**
+ * @brief Take a DMA write to TXDR.
+ *
+ * @retval true  @p addr is TXDR.
+ * @retval false Not the SPI1 data register.
+ */
+bool SimHw_SpiDmaWrite(uintptr_t addr, uint8_t data)
+{
+    if (addr != (uintptr_t)&g_simHwSpi.regs->TXDR)
+    {
+        return false;
+    }
+    SimHw_SpiPush(data);
+    return true;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Queue one byte for transmission, dropped when the FIFO is full.
+ */
+static void SimHw_SpiPush(uint8_t data)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+
+    if (s->txCount < SIMHW_SPI_FIFO_DEPTH)
+    {
+        s->txFifo[(s->txHead + s->txCount) % SIMHW_SPI_FIFO_DEPTH] = data;
+        s->txCount++;
+        s->pushed++;
+        if (s->pushed == s->size)
+        {
+            s->flags |= SPI_SR_TXTF;
+        }
+    }
+}
+
+/**
+ * @brief Serve the DMA requests of both FIFOs and start the next frame.
+ *
+ * RX is served first: each received byte is presented in RXDR for one
+ * request of the receive channel. TX requests stop once TSIZE bytes were
+ * written, as TXTF masks them on silicon.
+ */
+static void SimHw_SpiKick(void)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+    SPI_TypeDef *r = s->regs;
+
+    if (s->enabled)
+    {
+        uint32_t cfg1 = r->CFG1;
+        while (((cfg1 & SPI_CFG1_RXDMAEN) != 0U) && (s->rxCount != 0U))
+        {
+            *(volatile uint8_t *)&r->RXDR = s->rxFifo[s->rxHead];
+            if (!SimHw_DmaRequest(LL_GPDMA1_REQUEST_SPI1_RX))
+            {
+                break;
+            }
+            s->rxHead = (s->rxHead + 1U) % SIMHW_SPI_FIFO_DEPTH;
+            s->rxCount--;
+        }
+
+        while (((cfg1 & SPI_CFG1_TXDMAEN) != 0U) && (s->txCount < SIMHW_SPI_FIFO_DEPTH) &&
+               ((s->size == 0U) || (s->pushed < s->size)) && SimHw_DmaRequest(LL_GPDMA1_REQUEST_SPI1_TX))
+        {
+        }
+
+        if (!s->shifting && (s->txCount != 0U) && ((r->CR1 & SPI_CR1_CSTART) != 0U))
+        {
+            s->shiftByte = s->txFifo[s->txHead];
+            s->txHead = (s->txHead + 1U) % SIMHW_SPI_FIFO_DEPTH;
+            s->txCount--;
+            s->shifting = true;
+            s->shiftStartNs = g_simHwStats.now_ns;
+            s->shiftDoneNs = g_simHwStats.now_ns + SimHw_SpiFrameNs();
+        }
+    }
+    SimHw_SpiPublish();
+}
+
+/**
+ * @brief A frame was exchanged: the byte received comes from the NOR flash
+ *        while it is selected, else it is the byte sent.
+ */
+static void SimHw_SpiShiftDone(void)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+    SPI_TypeDef *r = s->regs;
+
+    s->shifting = false;
+    s->done++;
+    g_simHwStats.spi_bytes++;
+    g_simHwStats.spi_busy_ns += s->shiftDoneNs - s->shiftStartNs;
+
+    uint8_t miso = SimHw_NorIsSelected() ? SimHw_NorExchange(s->shiftByte) : s->shiftByte;
+    if (s->rxCount < SIMHW_SPI_FIFO_DEPTH)
+    {
+        s->rxFifo[(s->rxHead + s->rxCount) % SIMHW_SPI_FIFO_DEPTH] = miso;
+        s->rxCount++;
+    }
+    else
+    {
+        s->flags |= SPI_SR_OVR;
+    }
+
+    if (s->done == s->size)
+    {
+        s->flags |= SPI_SR_EOT;
+        r->CR1 &= ~SPI_CR1_CSTART;
+    }
+    else if ((r->CR1 & SPI_CR1_CSTART) == 0U)
+    {
+        /* Suspended by CSUSP during the frame */
+        s->flags |= SPI_SR_SUSP;
+    }
+    SimHw_SpiKick();
+}
+
+/**
+ * @brief Publish SR.
+ */
+static void SimHw_SpiPublish(void)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+    uint32_t sr = s->flags;
+
+    if (s->txCount < SIMHW_SPI_FIFO_DEPTH)
+    {
+        sr |= SPI_SR_TXP;
+    }
+    if (s->rxCount != 0U)
+    {
+        sr |= SPI_SR_RXP;
+    }
+    if ((sr & (SPI_SR_TXP | SPI_SR_RXP)) == (SPI_SR_TXP | SPI_SR_RXP))
+    {
+        sr |= SPI_SR_DXP;
+    }
+    if (!s->shifting && (s->txCount == 0U))
+    {
+        sr |= SPI_SR_TXC;
+    }
+    s->regs->SR = sr;
+}
+
+/**
+ * @brief Duration of one frame for the current configuration.
+ *
+ * The kernel clock comes from the RCC model through the LL driver and is
+ * divided by MBR unless BPASS is set. The result is cached until CFG1
+ * changes.
+ */
+static uint64_t SimHw_SpiFrameNs(void)
+{
+    SimHw_Spi_T *s = &g_simHwSpi;
+    uint32_t cfg1 = s->regs->CFG1;
+
+    if ((cfg1 == s->cfgKey) && (s->frameNs != 0U))
+    {
+        return s->frameNs;
+    }
+    s->cfgKey = cfg1;
+
+    bool inModel = g_simHwInModel;
+    g_simHwInModel = true;
+    uint32_t kernelClock = LL_RCC_GetSPIClockFreq(LL_RCC_SPI1_CLKSOURCE);
+    g_simHwInModel = inModel;
+
+    uint32_t div = ((cfg1 & SPI_CFG1_BPASS) != 0U) ? 1U : (2UL << ((cfg1 & SPI_CFG1_MBR) >> SPI_CFG1_MBR_Pos));
+    uint64_t bits = ((cfg1 & SPI_CFG1_DSIZE) >> SPI_CFG1_DSIZE_Pos) + 1U;
+    s->frameNs = (kernelClock != 0U) ? (((bits * div * 1000000000ULL) + (kernelClock / 2U)) / kernelClock)
+                                     : 1000000U;
+    return s->frameNs;
+}
+
+/** @} */ // end of SimHw group
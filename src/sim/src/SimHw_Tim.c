@@ -0,0 +1,395 @@
+/**
+ * @file SimHw_Tim.c
+ * @brief Register-level model of TIM2, TIM3 and TIM5.
+ * @ingroup SimHw
+ * @{
+ *
+ * Up-counters with PSC and ARR on the timer kernel clock, live CNT, UG and
+ * CC1G, UIF and CC1IF, and a word-wide DMA request on update while UDE is
+ * set. TIM2 drives TRGO on update for ADC1.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+
+/* Defines ------------------------------------------------------------------*/
+/** EXTSEL of TIM2 TRGO on the regular group. */
+#define SIMHW_ADC_EXTSEL_TIM2_TRGO (ADC_CFGR1_EXTSEL_2 | ADC_CFGR1_EXTSEL_1 | ADC_CFGR1_EXTSEL_0)
+#define SIMHW_TIMERS           (3U)      /**< TIM2, TIM5 and TIM3 */
+#define SIMHW_TIM_NO_TRGO      (0xFFFFFFFFUL) /**< Timer whose TRGO reaches no modelled peripheral */
+/** SR flags owned by the model, with a DIER enable at the same position. */
+#define SIMHW_TIM_FLAGS        (TIM_SR_UIF | TIM_SR_CC1IF)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of one general-purpose timer.
+ *
+ * The count is derived from the kernel clock cycle it last held a known
+ * value at, so it is exact however rarely it is looked at.
+ */
+typedef struct
+{
+    TIM_TypeDef *regs;    /**< Register block in the mapped window */
+    IRQn_Type irq;        /**< Global interrupt */
+    uint32_t trgo;        /**< ADC EXTSEL its TRGO drives, ::SIMHW_TIM_NO_TRGO for none */
+    uint32_t dmaReq;      /**< GPDMA1 request raised on update while DIER.UDE is set */
+    bool running;         /**< CR1.CEN seen */
+    uint32_t flags;       /**< SR flags owned by the model */
+    uint32_t psc;         /**< Prescaler in use */
+    uint32_t arr;         /**< Auto-reload in use */
+    uint32_t clockHz;     /**< Kernel clock latched when the counter started */
+    uint64_t originCycle; /**< Kernel clock cycle the counter held @ref originCnt at */
+    uint32_t originCnt;   /**< Count at @ref originCycle */
+    uint32_t shownCnt;    /**< Count last published in CNT, a different value there was written */
+    uint64_t updateNs;    /**< Next overflow */
+    uint64_t compareNs;   /**< Next channel 1 match */
+} SimHw_Tim_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Tim_T g_simHwTim[SIMHW_TIMERS];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static SimHw_Tim_T *SimHw_TimFind(uintptr_t addr);
+static void SimHw_TimReconcile(SimHw_Tim_T *t);
+static void SimHw_TimEvent(SimHw_Tim_T *t);
+static void SimHw_TimRebase(SimHw_Tim_T *t);
+static void SimHw_TimSchedule(SimHw_Tim_T *t);
+static void SimHw_TimPublish(SimHw_Tim_T *t);
+static uint64_t SimHw_TimCycle(const SimHw_Tim_T *t, uint64_t ns);
+static uint64_t SimHw_TimCycleNs(const SimHw_Tim_T *t, uint64_t cycle);
+static void SimHw_TimTrgo(const SimHw_Tim_T *t);
+static void SimHw_TimDma(const SimHw_Tim_T *t);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Apply a CPU load from a timer CNT, which returns the live count.
+ *
+ * @retval true  The load was handled by the model.
+ * @retval false Not a CNT register, read memory.
+ */
+bool SimHw_TimRead(uintptr_t addr, uint32_t *value)
+{
+    SimHw_Tim_T *t = SimHw_TimFind(addr);
+
+    if ((t == NULL) || (addr != (uintptr_t)&t->regs->CNT))
+    {
+        return false;
+    }
+
+    g_simHwInModel = true;
+    SimHw_TimPublish(t);
+    *value = t->shownCnt;
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put TIM2, TIM5 and TIM3 in the reset state.
+ */
+void SimHw_TimReset(void)
+{
+    memset(g_simHwTim, 0, sizeof(g_simHwTim));
+    g_simHwTim[0].regs = TIM2;
+    g_simHwTim[0].irq = TIM2_IRQn;
+    g_simHwTim[0].trgo = SIMHW_ADC_EXTSEL_TIM2_TRGO;
+    g_simHwTim[1].regs = TIM5;
+    g_simHwTim[1].irq = TIM5_IRQn;
+    g_simHwTim[1].trgo = SIMHW_TIM_NO_TRGO;
+    g_simHwTim[2].regs = TIM3;
+    g_simHwTim[2].irq = TIM3_IRQn;
+    g_simHwTim[2].trgo = SIMHW_TIM_NO_TRGO;
+    g_simHwTim[0].dmaReq = LL_GPDMA1_REQUEST_TIM2_UP;
+    g_simHwTim[1].dmaReq = LL_GPDMA1_REQUEST_TIM5_UP;
+    g_simHwTim[2].dmaReq = LL_GPDMA1_REQUEST_TIM3_UP;
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        g_simHwTim[i].regs->ARR = 0xFFFFFFFFUL;
+        g_simHwTim[i].arr = 0xFFFFFFFFUL;
+        g_simHwTim[i].clockHz = 1U;
+        g_simHwTim[i].updateNs = SIMHW_NO_EVENT;
+        g_simHwTim[i].compareNs = SIMHW_NO_EVENT;
+    }
+}
+
+/**
+ * @brief Earliest update or compare match of the timers.
+ */
+uint64_t SimHw_TimNextEventNs(void)
+{
+    uint64_t next = SIMHW_NO_EVENT;
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        if (g_simHwTim[i].updateNs < next)
+        {
+            next = g_simHwTim[i].updateNs;
+        }
+        if (g_simHwTim[i].compareNs < next)
+        {
+            next = g_simHwTim[i].compareNs;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Handle the updates and compare matches due at @p now.
+ */
+void SimHw_TimEvents(uint64_t now)
+{
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        if ((g_simHwTim[i].updateNs <= now) || (g_simHwTim[i].compareNs <= now))
+        {
+            SimHw_TimEvent(&g_simHwTim[i]);
+        }
+    }
+}
+
+/**
+ * @brief Fold plain register stores of every timer.
+ */
+void SimHw_TimReconcileAll(void)
+{
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        SimHw_TimReconcile(&g_simHwTim[i]);
+    }
+}
+
+/**
+ * @brief Fold the stores of the timer owning @p addr, if any.
+ *
+ * @retval true  @p addr lies in TIM2, TIM3 or TIM5.
+ * @retval false No modelled timer at @p addr.
+ */
+bool SimHw_TimReconcileAt(uintptr_t addr)
+{
+    SimHw_Tim_T *tim = SimHw_TimFind(addr);
+    if (tim == NULL)
+    {
+        return false;
+    }
+    SimHw_TimReconcile(tim);
+    return true;
+}
+
+/**
+ * @brief Raise the interrupt of every timer with an enabled flag set.
+ */
+void SimHw_TimLines(void)
+{
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        if ((g_simHwTim[i].flags & g_simHwTim[i].regs->DIER & SIMHW_TIM_FLAGS) != 0U)
+        {
+            SimHw_SetPending(16U + (uint32_t)g_simHwTim[i].irq);
+        }
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Find the modelled timer whose register block contains @p addr.
+ */
+static SimHw_Tim_T *SimHw_TimFind(uintptr_t addr)
+{
+    for (uint32_t i = 0U; i < SIMHW_TIMERS; i++)
+    {
+        uintptr_t base = (uintptr_t)g_simHwTim[i].regs;
+        if ((addr >= base) && (addr < (base + sizeof(TIM_TypeDef))))
+        {
+            return &g_simHwTim[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Apply timer register stores: flag clears, counter writes, event generation and enable.
+ *
+ * SR flags are cleared by writing 0. PSC and ARR take effect at once
+ * rather than at the next update, which is what every driver relies on
+ * after an update generation anyway.
+ */
+static void SimHw_TimReconcile(SimHw_Tim_T *t)
+{
+    TIM_TypeDef *r = t->regs;
+
+    t->flags &= r->SR | ~SIMHW_TIM_FLAGS;
+    SimHw_TimRebase(t);
+    if (r->CNT != t->shownCnt)
+    {
+        t->originCnt = r->CNT;
+    }
+
+    uint32_t egr = r->EGR;
+    r->EGR = 0U;
+    if ((egr & TIM_EGR_UG) != 0U)
+    {
+        t->originCnt = 0U;
+        if ((r->CR1 & TIM_CR1_URS) == 0U)
+        {
+            t->flags |= TIM_SR_UIF;
+        }
+        SimHw_TimTrgo(t);
+        SimHw_TimDma(t);
+    }
+    if ((egr & TIM_EGR_CC1G) != 0U)
+    {
+        t->flags |= TIM_SR_CC1IF;
+    }
+
+    bool running = (r->CR1 & TIM_CR1_CEN) != 0U;
+    if (running && !t->running)
+    {
+        bool inModel = g_simHwInModel;
+        g_simHwInModel = true;
+        uint32_t clockHz = LL_RCC_GetSystemClockFreq() / (1UL << LL_RCC_GetTIMPrescaler());
+        g_simHwInModel = inModel;
+        t->clockHz = (clockHz != 0U) ? clockHz : 1U;
+        t->originCycle = SimHw_TimCycle(t, g_simHwStats.now_ns);
+    }
+    t->running = running;
+    t->psc = r->PSC & TIM_PSC_PSC;
+    t->arr = r->ARR;
+    SimHw_TimSchedule(t);
+    SimHw_TimPublish(t);
+}
+
+/**
+ * @brief Counter overflow or channel 1 match due: raise UIF or CC1IF, drive TRGO and request DMA on update.
+ */
+static void SimHw_TimEvent(SimHw_Tim_T *t)
+{
+    uint64_t now = g_simHwStats.now_ns;
+
+    SimHw_TimRebase(t);
+    if (t->updateNs <= now)
+    {
+        g_simHwStats.tim_updates++;
+        t->flags |= TIM_SR_UIF;
+        SimHw_TimTrgo(t);
+        SimHw_TimDma(t);
+    }
+    if (t->compareNs <= now)
+    {
+        g_simHwStats.tim_compares++;
+        t->flags |= TIM_SR_CC1IF;
+    }
+    SimHw_TimSchedule(t);
+    SimHw_TimPublish(t);
+}
+
+/**
+ * @brief Move the counter origin to the last prescaled tick before now.
+ *
+ * Origins always sit on a tick boundary counted in kernel clock cycles,
+ * so event times never accumulate rounding.
+ */
+static void SimHw_TimRebase(SimHw_Tim_T *t)
+{
+    if (!t->running)
+    {
+        return;
+    }
+
+    uint64_t div = (uint64_t)t->psc + 1U;
+    uint64_t ticks = (SimHw_TimCycle(t, g_simHwStats.now_ns) - t->originCycle) / div;
+    t->originCycle += ticks * div;
+    t->originCnt = (uint32_t)(((uint64_t)t->originCnt + ticks) % ((uint64_t)t->arr + 1U));
+}
+
+/**
+ * @brief Compute the next overflow and channel 1 match from the counter origin.
+ *
+ * The counter reaches a value one tick after it is loaded, so a compare
+ * equal to the current count matches a full lap later.
+ */
+static void SimHw_TimSchedule(SimHw_Tim_T *t)
+{
+    t->updateNs = SIMHW_NO_EVENT;
+    t->compareNs = SIMHW_NO_EVENT;
+    if (!t->running)
+    {
+        return;
+    }
+
+    uint64_t div = (uint64_t)t->psc + 1U;
+    uint64_t lap = (uint64_t)t->arr + 1U;
+    uint64_t cnt = (t->originCnt < lap) ? t->originCnt : 0U;
+    t->updateNs = SimHw_TimCycleNs(t, t->originCycle + ((lap - cnt) * div));
+
+    uint64_t ccr = t->regs->CCR1;
+    if (ccr < lap)
+    {
+        uint64_t ticks = ((ccr + lap - cnt - 1U) % lap) + 1U;
+        t->compareNs = SimHw_TimCycleNs(t, t->originCycle + (ticks * div));
+    }
+}
+
+/**
+ * @brief Publish SR and the current count.
+ */
+static void SimHw_TimPublish(SimHw_Tim_T *t)
+{
+    uint32_t cnt = t->originCnt;
+
+    if (t->running)
+    {
+        uint64_t ticks = (SimHw_TimCycle(t, g_simHwStats.now_ns) - t->originCycle) / ((uint64_t)t->psc + 1U);
+        cnt = (uint32_t)(((uint64_t)t->originCnt + ticks) % ((uint64_t)t->arr + 1U));
+    }
+    t->shownCnt = cnt;
+    t->regs->CNT = cnt;
+    t->regs->SR = t->flags;
+}
+
+/**
+ * @brief Kernel clock cycles elapsed at @p ns, rounded down.
+ */
+static uint64_t SimHw_TimCycle(const SimHw_Tim_T *t, uint64_t ns)
+{
+    return (uint64_t)(((unsigned __int128)ns * t->clockHz) / 1000000000U);
+}
+
+/**
+ * @brief Time at which kernel clock cycle @p cycle starts, rounded up.
+ */
+static uint64_t SimHw_TimCycleNs(const SimHw_Tim_T *t, uint64_t cycle)
+{
+    return (uint64_t)((((unsigned __int128)cycle * 1000000000U) + t->clockHz - 1U) / t->clockHz);
+}
+
+/**
+ * @brief Update event on TRGO when CR2.MMS selects it.
+ */
+static void SimHw_TimTrgo(const SimHw_Tim_T *t)
+{
+    if ((t->trgo != SIMHW_TIM_NO_TRGO) && ((t->regs->CR2 & TIM_CR2_MMS) == TIM_CR2_MMS_1))
+    {
+        SimHw_AdcTrigger(t->trgo);
+    }
+}
+
+/**
+ * @brief Update DMA request when DIER.UDE is set, served as one word beat.
+ *
+ * Word is the width every timer-paced stream of the firmware uses.
+ */
+static void SimHw_TimDma(const SimHw_Tim_T *t)
+{
+    if ((t->regs->DIER & TIM_DIER_UDE) == 0U)
+    {
+        return;
+    }
+
+    g_simHwStats.tim_dma_requests++;
+    for (uint32_t i = 0U; (i < sizeof(uint32_t)) && SimHw_DmaRequest(t->dmaReq); i++)
+    {
+    }
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,353 @@
+/**
+ * @file SimHw_Usart.c
+ * @brief Register-level model of USART1.
+ * @ingroup SimHw
+ * @{
+ *
+ * Baud rate from BRR, PRESC and OVER8 on the RCC kernel clock, frame format
+ * from CR1 and CR2, a TX FIFO drained one frame time at a time, the TXE, TC
+ * and TEACK flags and the DMA request. Frames leave on the host standard
+ * output.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+#include "stm32n6xx_ll_rcc.h"
+#include "stm32n6xx_ll_dma.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_USART_FIFO_DEPTH (8U)
+#define SIMHW_USART_TDR_EMPTY  (0xFFFFFFFFUL) /**< TDR content while no write is pending */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief State of the USART1 transmitter.
+ */
+typedef struct
+{
+    USART_TypeDef *regs;                    /**< Register block in the mapped window */
+    uint8_t fifo[SIMHW_USART_FIFO_DEPTH];   /**< TX FIFO, or TDR when the FIFO is off */
+    uint32_t fifoHead;                      /**< Index of the oldest FIFO entry */
+    uint32_t fifoCount;                     /**< Bytes waiting in the FIFO */
+    bool shifting;                          /**< A frame is on the line */
+    uint8_t shiftByte;                      /**< Frame being shifted out */
+    uint64_t shiftStartNs;                  /**< Start of the frame on the line */
+    uint64_t shiftDoneNs;                   /**< End of the frame on the line */
+    bool tc;                                /**< Transmission complete flag */
+    uint32_t cfgKey[4];                     /**< Registers the cached frame time depends on */
+    uint32_t baudrate;                      /**< Cached line rate */
+    uint64_t frameNs;                       /**< Cached frame duration */
+} SimHw_Usart_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Usart_T g_simHwUsart;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_UsartPush(uint8_t data);
+static void SimHw_UsartKick(void);
+static void SimHw_UsartShiftDone(void);
+static void SimHw_UsartPublish(void);
+static bool SimHw_UsartIsOn(void);
+static bool SimHw_UsartIsStalled(void);
+static uint64_t SimHw_UsartFrameNs(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Line rate of USART1 from its current configuration.
+ */
+uint32_t SimHw_GetUsartBaudrate(void)
+{
+    (void)SimHw_UsartFrameNs();
+    return g_simHwUsart.baudrate;
+}
+
+/**
+ * @brief Apply USART register stores and refresh the transmitter.
+ */
+void SimHw_UsartReconcile(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+    USART_TypeDef *r = u->regs;
+
+    uint32_t icr = r->ICR;
+    if (icr != 0U)
+    {
+        if ((icr & USART_ICR_TCCF) != 0U)
+        {
+            u->tc = false;
+        }
+        r->ICR = 0U;
+    }
+
+    uint32_t tdr = r->TDR;
+    if (tdr != SIMHW_USART_TDR_EMPTY)
+    {
+        r->TDR = SIMHW_USART_TDR_EMPTY;
+        SimHw_UsartPush((uint8_t)tdr);
+    }
+
+    if ((r->CR1 & USART_CR1_UE) == 0U)
+    {
+        /* Disabling the USART flushes the transmitter */
+        u->fifoCount = 0U;
+        u->shifting = false;
+        u->tc = true;
+    }
+
+    SimHw_UsartKick();
+}
+
+/**
+ * @brief Put USART1 and its transmitter in the reset state.
+ */
+void SimHw_UsartReset(void)
+{
+    memset(&g_simHwUsart, 0, sizeof(g_simHwUsart));
+    g_simHwUsart.regs = USART1;
+    g_simHwUsart.tc = true;
+    g_simHwUsart.regs->TDR = SIMHW_USART_TDR_EMPTY;
+    SimHw_UsartPublish();
+}
+
+/**
+ * @brief End of the frame being shifted, or of a stall holding queued data.
+ */
+uint64_t SimHw_UsartNextEventNs(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+
+    if (u->shifting)
+    {
+        return u->shiftDoneNs;
+    }
+    if ((u->fifoCount != 0U) && SimHw_UsartIsStalled())
+    {
+        return g_simHwConfig.stall_end_ns;
+    }
+    return SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief End the frame due at @p now or start the next one.
+ */
+void SimHw_UsartEvents(uint64_t now)
+{
+    if (g_simHwUsart.shifting && (g_simHwUsart.shiftDoneNs <= now))
+    {
+        SimHw_UsartShiftDone();
+    }
+    else if (!g_simHwUsart.shifting)
+    {
+        SimHw_UsartKick();
+    }
+}
+
+/**
+ * @brief Raise the USART1 interrupt while an enabled flag is set.
+ */
+void SimHw_UsartLines(void)
+{
+    USART_TypeDef *r = g_simHwUsart.regs;
+    uint32_t isr = r->ISR;
+    uint32_t cr1 = r->CR1;
+    if ((((isr & USART_ISR_TC) != 0U) && ((cr1 & USART_CR1_TCIE) != 0U)) ||
+        (((isr & USART_ISR_TXE_TXFNF) != 0U) && ((cr1 & USART_CR1_TXEIE_TXFNFIE) != 0U)) ||
+        (((isr & USART_ISR_TXFE) != 0U) && ((cr1 & USART_CR1_TXFEIE) != 0U)))
+    {
+        SimHw_SetPending(16U + (uint32_t)USART1_IRQn);
+    }
+}
+
+/**
+ * @brief Take a DMA write to TDR.
+ *
+ * @retval true  @p addr is TDR.
+ * @retval false Not a USART1 data register.
+ */
+bool SimHw_UsartDmaWrite(uintptr_t addr, uint8_t data)
+{
+    if (addr != (uintptr_t)&g_simHwUsart.regs->TDR)
+    {
+        return false;
+    }
+    SimHw_UsartPush(data);
+    return true;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Queue one byte for transmission, dropped when the FIFO is full.
+ */
+static void SimHw_UsartPush(uint8_t data)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+    uint32_t depth = ((u->regs->CR1 & USART_CR1_FIFOEN) != 0U) ? SIMHW_USART_FIFO_DEPTH : 1U;
+
+    if (u->fifoCount < depth)
+    {
+        u->fifo[(u->fifoHead + u->fifoCount) % SIMHW_USART_FIFO_DEPTH] = data;
+        u->fifoCount++;
+    }
+    u->tc = false;
+}
+
+/**
+ * @brief Refill the FIFO through DMA and start the next frame.
+ */
+static void SimHw_UsartKick(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+    USART_TypeDef *r = u->regs;
+
+    if (SimHw_UsartIsOn())
+    {
+        uint32_t depth = ((r->CR1 & USART_CR1_FIFOEN) != 0U) ? SIMHW_USART_FIFO_DEPTH : 1U;
+        for (uint32_t pass = 0U; pass < 2U; pass++)
+        {
+            while (((r->CR3 & USART_CR3_DMAT) != 0U) && (u->fifoCount < depth) &&
+                   SimHw_DmaRequest(LL_GPDMA1_REQUEST_USART1_TX))
+            {
+            }
+
+            if (!u->shifting && (u->fifoCount != 0U) && !SimHw_UsartIsStalled())
+            {
+                u->shiftByte = u->fifo[u->fifoHead];
+                u->fifoHead = (u->fifoHead + 1U) % SIMHW_USART_FIFO_DEPTH;
+                u->fifoCount--;
+                u->shifting = true;
+                uint64_t frameNs = SimHw_UsartFrameNs();
+                u->shiftDoneNs = g_simHwStats.now_ns + frameNs;
+                u->shiftStartNs = g_simHwStats.now_ns;
+            }
+        }
+    }
+
+    if (!u->shifting && (u->fifoCount == 0U) && ((r->CR1 & USART_CR1_UE) != 0U))
+    {
+        /* Keep TC cleared by software until the next frame completes */
+    }
+    SimHw_UsartPublish();
+}
+
+/**
+ * @brief A frame left the shift register.
+ */
+static void SimHw_UsartShiftDone(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+
+    u->shifting = false;
+    g_simHwStats.usart_tx_bytes++;
+    g_simHwStats.usart_busy_ns += u->shiftDoneNs - u->shiftStartNs;
+    if (g_simHwConfig.tx_sink != NULL)
+    {
+        fputc(u->shiftByte, g_simHwConfig.tx_sink);
+    }
+
+    SimHw_UsartKick();
+    if (!u->shifting && (u->fifoCount == 0U))
+    {
+        u->tc = true;
+    }
+    SimHw_UsartPublish();
+}
+
+/**
+ * @brief Publish the USART status flags.
+ */
+static void SimHw_UsartPublish(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+    USART_TypeDef *r = u->regs;
+    uint32_t depth = ((r->CR1 & USART_CR1_FIFOEN) != 0U) ? SIMHW_USART_FIFO_DEPTH : 1U;
+    uint32_t isr = 0U;
+
+    if (u->fifoCount < depth)
+    {
+        isr |= USART_ISR_TXE_TXFNF;
+    }
+    if (u->fifoCount == 0U)
+    {
+        isr |= USART_ISR_TXFE;
+    }
+    if (u->tc)
+    {
+        isr |= USART_ISR_TC;
+    }
+    if (SimHw_UsartIsOn())
+    {
+        isr |= USART_ISR_TEACK;
+    }
+    r->ISR = isr;
+}
+
+/** @brief USART and its transmitter are enabled. */
+static bool SimHw_UsartIsOn(void)
+{
+    uint32_t cr1 = g_simHwUsart.regs->CR1;
+    return ((cr1 & USART_CR1_UE) != 0U) && ((cr1 & USART_CR1_TE) != 0U);
+}
+
+/** @brief Current time falls in the injected transmitter stall. */
+static bool SimHw_UsartIsStalled(void)
+{
+    uint64_t now = g_simHwStats.now_ns;
+    return (now >= g_simHwConfig.stall_start_ns) && (now < g_simHwConfig.stall_end_ns);
+}
+
+/**
+ * @brief Duration of one frame for the current configuration.
+ *
+ * The kernel clock comes from the RCC model through the LL driver, then
+ * goes through PRESC and BRR exactly as the baud rate generator does. The
+ * result is cached until one of the registers it depends on changes.
+ */
+static uint64_t SimHw_UsartFrameNs(void)
+{
+    SimHw_Usart_T *u = &g_simHwUsart;
+    USART_TypeDef *r = u->regs;
+    uint32_t key[4] = {r->BRR, r->PRESC, r->CR1 & (USART_CR1_OVER8 | USART_CR1_M0 | USART_CR1_M1),
+                       r->CR2 & USART_CR2_STOP};
+
+    if ((memcmp(key, u->cfgKey, sizeof(key)) == 0) && (u->frameNs != 0U))
+    {
+        return u->frameNs;
+    }
+    memcpy(u->cfgKey, key, sizeof(key));
+
+    static const uint32_t prescaler[] = {1U, 2U, 4U, 6U, 8U, 10U, 12U, 16U, 32U, 64U, 128U, 256U};
+    bool inModel = g_simHwInModel;
+    g_simHwInModel = true;
+    uint32_t kernelClock = LL_RCC_GetUSARTClockFreq(LL_RCC_USART1_CLKSOURCE);
+    g_simHwInModel = inModel;
+
+    uint32_t presc = r->PRESC & USART_PRESC_PRESCALER;
+    uint64_t fck = kernelClock / prescaler[(presc < 12U) ? presc : 11U];
+    uint32_t brr = r->BRR & USART_BRR_BRR;
+    uint64_t baud = 0U;
+    if (brr >= 16U)
+    {
+        if ((r->CR1 & USART_CR1_OVER8) != 0U)
+        {
+            uint32_t usartdiv = (brr & 0xFFF0U) | ((brr & 0x7U) << 1U);
+            baud = (2U * fck + (usartdiv / 2U)) / usartdiv;
+        }
+        else
+        {
+            baud = (fck + (brr / 2U)) / brr;
+        }
+    }
+    u->baudrate = (uint32_t)baud;
+
+    /* Start bit + data bits (parity included by M) + stop bits, in half bits */
+    uint32_t m = r->CR1 & (USART_CR1_M0 | USART_CR1_M1);
+    uint32_t dataBits = (m == USART_CR1_M0) ? 9U : ((m == USART_CR1_M1) ? 7U : 8U);
+    static const uint32_t stopHalfBits[] = {2U, 1U, 4U, 3U};
+    uint32_t halfBits = (2U * (1U + dataBits)) + stopHalfBits[(r->CR2 & USART_CR2_STOP) >> USART_CR2_STOP_Pos];
+
+    u->frameNs = (baud != 0U) ? ((halfBits * 1000000000ULL) + baud) / (2U * baud) : 1000000U;
+    return u->frameNs;
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,1156 @@
+/**
+ * @file SimHw_Usb.c
+ * @brief Register-level model of USB1 OTG HS and the host on its cable.
+ * @ingroup SimHw
+ * @{
+ *
+ * Device mode with the internal DMA, W1C interrupt registers, core reset and
+ * FIFO flushes completing at once and endpoint disable. The host debounces
+ * the pull-up, resets the bus, enumerates the device, opens and closes its
+ * CDC port on request and reads its bulk IN endpoints, one packet per
+ * transaction timed on the bus.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimHw_Model.h"
+#include <string.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMHW_USB_DEVICE       ((USB_OTG_DeviceTypeDef *)((uintptr_t)USB1_OTG_HS + USB_OTG_DEVICE_BASE))
+#define SIMHW_USB_IN(n)        ((USB_OTG_INEndpointTypeDef *)((uintptr_t)USB1_OTG_HS + USB_OTG_IN_ENDPOINT_BASE + ((n) * USB_OTG_EP_REG_SIZE)))
+#define SIMHW_USB_OUT(n)       ((USB_OTG_OUTEndpointTypeDef *)((uintptr_t)USB1_OTG_HS + USB_OTG_OUT_ENDPOINT_BASE + ((n) * USB_OTG_EP_REG_SIZE)))
+#define SIMHW_USB_REG_BYTES    (USB_OTG_PCGCCTL_BASE + 4U) /**< Core registers up to PCGCCTL */
+#define SIMHW_USB_EPS          (4U)       /**< Endpoints modelled in each direction */
+#define SIMHW_USB_EP0_MPS      (64U)      /**< Control packet size */
+#define SIMHW_USB_DEBOUNCE_NS  (10000000U) /**< Host debounce after the pull-up appears */
+#define SIMHW_USB_RESET_NS     (10000000U) /**< Bus reset driven by the host */
+#define SIMHW_USB_RECOVERY_NS  (1000000U) /**< Host wait after the reset before the first request */
+#define SIMHW_USB_SET_ADDRESS_NS (2000000U) /**< Recovery time after SET_ADDRESS */
+#define SIMHW_USB_SUSPEND_NS   (3000000U) /**< Idle bus time before the device suspends */
+#define SIMHW_USB_CTRL_NS      (20000U)   /**< Host scheduling time of a control transaction */
+#define SIMHW_USB_POLL_NS      (1000U)    /**< Host retry after the device touched its registers */
+#define SIMHW_USB_ADDRESS      (7U)       /**< Address the host assigns */
+#define SIMHW_USB_CTRL_BYTES   (512U)     /**< Largest control data stage */
+#define SIMHW_USB_CAPTURE      (16384U)   /**< Last bytes kept per IN endpoint */
+#define SIMHW_USB_LINE_BAUD    (921600U)  /**< Line coding the host sets when opening the port */
+#define SIMHW_USB_OPEN_TEXT    "AT\r\n"  /**< What the host writes to the port once open */
+#define SIMHW_USB_FNV_BASIS    (0xCBF29CE484222325ULL) /**< FNV-1a 64 offset basis */
+#define SIMHW_USB_FNV_PRIME    (0x00000100000001B3ULL) /**< FNV-1a 64 prime */
+#define SIMHW_USB_GET_DESCRIPTOR (6U)
+#define SIMHW_USB_SET_ADDRESS  (5U)
+#define SIMHW_USB_SET_CONFIGURATION (9U)
+#define SIMHW_USB_SET_LINE_CODING (0x20U)
+#define SIMHW_USB_SET_CONTROL_LINE_STATE (0x22U)
+#define SIMHW_USB_STEP_IDLE    (9U)       /**< Host script: enumerated, waiting for the port to open or close */
+#define SIMHW_USB_STEP_LINE_CODING (10U)  /**< Host script: SET_LINE_CODING */
+#define SIMHW_USB_STEP_OPEN    (11U)      /**< Host script: SET_CONTROL_LINE_STATE with DTR and RTS */
+#define SIMHW_USB_STEP_CLOSE   (12U)      /**< Host script: SET_CONTROL_LINE_STATE cleared */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Cable state seen from the host.
+ */
+typedef enum
+{
+    SIMHW_USB_DETACHED = 0U, /**< Cable out */
+    SIMHW_USB_ATTACHING,     /**< Cable in, debouncing the pull-up or waiting for it */
+    SIMHW_USB_RESET,         /**< Bus reset driven */
+    SIMHW_USB_RUNNING,       /**< Reset done, transactions flow */
+} SimHw_UsbPhase_T;
+
+/**
+ * @brief Stage of the control transfer run by the host.
+ */
+typedef enum
+{
+    SIMHW_USB_CTRL_IDLE = 0U,  /**< No transfer */
+    SIMHW_USB_CTRL_SETUP,      /**< SETUP packet to send */
+    SIMHW_USB_CTRL_DATA_IN,    /**< Reading the data stage */
+    SIMHW_USB_CTRL_DATA_OUT,   /**< Writing the data stage */
+    SIMHW_USB_CTRL_STATUS_IN,  /**< Zero-length IN status */
+    SIMHW_USB_CTRL_STATUS_OUT, /**< Zero-length OUT status */
+} SimHw_UsbStage_T;
+
+/**
+ * @brief State of the OTG1 core in device mode and of the host on its bus.
+ *
+ * Only the internal DMA mode of the core is modelled: packets move
+ * between memory and the bus at DIEPDMA and DOEPDMA, one transaction per
+ * event, timed at the speed the bus reset ended with. The host runs a
+ * fixed script: it enumerates the device, then opens and closes the CDC
+ * port on request, and reads every bulk IN endpoint it found in the
+ * configuration descriptor.
+ */
+typedef struct
+{
+    uint32_t flags;                /**< GINTSTS bus event flags */
+    bool connected;                /**< DCTL SDIS clear, the pull-up is on */
+    bool suspended;                /**< DSTS SUSPSTS */
+    uint32_t enumSpeed;            /**< DSTS ENUMSPD of the last reset */
+    SimHw_UsbPhase_T phase;        /**< Cable and bus state */
+    uint64_t eventNs;              /**< Next host action */
+    uint64_t holdNs;               /**< No control transfer before this time */
+    uint64_t attachNs;             /**< Time the cable was plugged in */
+    uint32_t step;                 /**< Next request of the host script */
+    bool openReq;                  /**< Opening the CDC port was asked for */
+    bool closeReq;                 /**< Closing the CDC port was asked for */
+    SimHw_UsbStage_T stage;        /**< Stage of the control transfer */
+    uint8_t setup[8];              /**< Its SETUP packet */
+    uint8_t ctrl[SIMHW_USB_CTRL_BYTES]; /**< Its data stage */
+    uint32_t ctrlLen;              /**< Bytes of the data stage moved */
+    uint8_t iProduct;              /**< Product string index from the device descriptor */
+    uint8_t cdcInterface;          /**< CDC communication interface number */
+    uint8_t outData[SIMHW_USB_EP0_MPS]; /**< Bytes the host writes to the CDC port */
+    uint32_t outLen;               /**< Bytes in @ref outData */
+    uint32_t outSent;              /**< Bytes of @ref outData delivered */
+    uint32_t rr;                   /**< Bulk IN endpoint served next */
+    SimHw_UsbHost_T host;          /**< What the host learned */
+    uint64_t inBytes[SIMHW_USB_EPS]; /**< Bytes read per IN endpoint */
+    uint64_t inHash[SIMHW_USB_EPS];  /**< FNV-1a 64 of those bytes */
+    uint8_t capture[SIMHW_USB_EPS][SIMHW_USB_CAPTURE]; /**< Last bytes read per IN endpoint */
+    uint32_t captureHead[SIMHW_USB_EPS]; /**< Next write position in @ref capture */
+} SimHw_Usb_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimHw_Usb_T g_simHwUsb;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimHw_UsbEpControl(volatile uint32_t *ctl, uint32_t value);
+static void SimHw_UsbCoreReset(void);
+static void SimHw_UsbConnect(bool connected);
+static void SimHw_UsbHostReset(void);
+static void SimHw_UsbKick(void);
+static void SimHw_UsbEvent(void);
+static void SimHw_UsbScript(void);
+static uint64_t SimHw_UsbControl(void);
+static void SimHw_UsbControlEnd(bool ok);
+static void SimHw_UsbParseConfig(void);
+static uint64_t SimHw_UsbBulkOut(void);
+static uint64_t SimHw_UsbBulkIn(void);
+static uint32_t SimHw_UsbInPacket(uint32_t ep, uint8_t *dst, uint32_t space);
+static bool SimHw_UsbOutPacket(uint32_t ep, const uint8_t *data, uint32_t n);
+static uint64_t SimHw_UsbPacketNs(uint32_t bytes);
+static void SimHw_UsbPublish(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Plug or unplug the cable between OTG1 and the host.
+ *
+ * Once plugged in, the host resets the bus as soon as the device has its
+ * pull-up on and enumerates it. Unplugging leaves the bus idle, so the
+ * device sees a suspend 3 ms later.
+ */
+void SimHw_UsbAttach(bool attached)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint64_t now = g_simHwStats.now_ns;
+
+    if (attached == (u->phase != SIMHW_USB_DETACHED))
+    {
+        return;
+    }
+    SimHw_UsbHostReset();
+    u->host.attached = attached;
+    u->openReq = false;
+    u->closeReq = false;
+    if (attached)
+    {
+        u->phase = SIMHW_USB_ATTACHING;
+        u->attachNs = now;
+        u->eventNs = u->connected ? (now + SIMHW_USB_DEBOUNCE_NS) : SIMHW_NO_EVENT;
+    }
+    else
+    {
+        u->phase = SIMHW_USB_DETACHED;
+        u->eventNs = now + SIMHW_USB_SUSPEND_NS;
+    }
+}
+
+/**
+ * @brief Have the host open or close the CDC port of the configured device.
+ */
+void SimHw_UsbOpen(bool open)
+{
+    g_simHwUsb.openReq = open;
+    g_simHwUsb.closeReq = !open;
+    SimHw_UsbKick();
+}
+
+/**
+ * @brief Copy what the host learned about the device.
+ */
+void SimHw_UsbGetHost(SimHw_UsbHost_T *host)
+{
+    if (host != NULL)
+    {
+        *host = g_simHwUsb.host;
+    }
+}
+
+/**
+ * @brief Bytes the host read from an IN endpoint and their hash.
+ */
+uint64_t SimHw_UsbReceived(uint8_t ep, uint64_t *hash)
+{
+    uint32_t num = ep & 0x0FU;
+
+    if (num >= SIMHW_USB_EPS)
+    {
+        return 0U;
+    }
+    if (hash != NULL)
+    {
+        *hash = g_simHwUsb.inHash[num];
+    }
+    return g_simHwUsb.inBytes[num];
+}
+
+/**
+ * @brief Copy the last bytes the host read from an IN endpoint, oldest first.
+ */
+uint32_t SimHw_UsbRead(uint8_t ep, void *buf, uint32_t size)
+{
+    uint32_t num = ep & 0x0FU;
+
+    if ((num >= SIMHW_USB_EPS) || (buf == NULL))
+    {
+        return 0U;
+    }
+
+    uint64_t kept = g_simHwUsb.inBytes[num];
+    uint32_t count = (kept < SIMHW_USB_CAPTURE) ? (uint32_t)kept : SIMHW_USB_CAPTURE;
+    count = (count < size) ? count : size;
+    uint32_t at = (g_simHwUsb.captureHead[num] + SIMHW_USB_CAPTURE - count) % SIMHW_USB_CAPTURE;
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        ((uint8_t *)buf)[i] = g_simHwUsb.capture[num][(at + i) % SIMHW_USB_CAPTURE];
+    }
+    return count;
+}
+
+/**
+ * @brief Apply a CPU store to the OTG1 core.
+ *
+ * Interrupt registers are W1C, the reset and flush bits of GRSTCTL
+ * complete at once, the NAK and DATA PID bits of the endpoint control
+ * registers are write-only and EPDIS disables an enabled endpoint with
+ * EPDISD. Clearing or setting DCTL SDIS connects or disconnects the
+ * pull-up. Any store may have armed an endpoint, so an idle host polls
+ * again shortly after.
+ *
+ * @retval true  The store was handled by the model.
+ * @retval false Outside the core.
+ */
+bool SimHw_UsbWrite(uintptr_t addr, uint32_t value)
+{
+    uintptr_t base = (uintptr_t)USB1_OTG_HS;
+
+    if ((addr < base) || (addr >= (base + SIMHW_USB_REG_BYTES)))
+    {
+        return false;
+    }
+
+    uint32_t off = (uint32_t)(addr - base);
+    volatile uint32_t *reg = (volatile uint32_t *)addr;
+    uint32_t inEnd = USB_OTG_IN_ENDPOINT_BASE + (SIMHW_USB_EPS * USB_OTG_EP_REG_SIZE);
+    uint32_t outEnd = USB_OTG_OUT_ENDPOINT_BASE + (SIMHW_USB_EPS * USB_OTG_EP_REG_SIZE);
+
+    g_simHwInModel = true;
+    if ((off == offsetof(USB_OTG_GlobalTypeDef, GOTGINT)) || (off == offsetof(USB_OTG_GlobalTypeDef, GINTSTS)))
+    {
+        *reg &= ~value;
+        if (off == offsetof(USB_OTG_GlobalTypeDef, GINTSTS))
+        {
+            g_simHwUsb.flags &= ~value;
+        }
+    }
+    else if (off == offsetof(USB_OTG_GlobalTypeDef, GRSTCTL))
+    {
+        if ((value & USB_OTG_GRSTCTL_CSRST) != 0U)
+        {
+            SimHw_UsbCoreReset();
+        }
+        else
+        {
+            *reg = (value & ~(USB_OTG_GRSTCTL_TXFFLSH | USB_OTG_GRSTCTL_RXFFLSH)) | USB_OTG_GRSTCTL_AHBIDL;
+        }
+    }
+    else if (off == (USB_OTG_DEVICE_BASE + offsetof(USB_OTG_DeviceTypeDef, DCTL)))
+    {
+        *reg = value & ~(USB_OTG_DCTL_SGINAK | USB_OTG_DCTL_CGINAK | USB_OTG_DCTL_SGONAK | USB_OTG_DCTL_CGONAK |
+                         USB_OTG_DCTL_POPRGDNE);
+        SimHw_UsbConnect((value & USB_OTG_DCTL_SDIS) == 0U);
+    }
+    else if (off == (USB_OTG_DEVICE_BASE + offsetof(USB_OTG_DeviceTypeDef, DAINT)))
+    {
+        /* Read-only, rebuilt from the endpoint flags */
+    }
+    else if (((off >= USB_OTG_IN_ENDPOINT_BASE) && (off < inEnd)) ||
+             ((off >= USB_OTG_OUT_ENDPOINT_BASE) && (off < outEnd)))
+    {
+        uint32_t field = off % USB_OTG_EP_REG_SIZE;
+        if (field == offsetof(USB_OTG_INEndpointTypeDef, DIEPCTL))
+        {
+            SimHw_UsbEpControl(reg, value);
+        }
+        else if (field == offsetof(USB_OTG_INEndpointTypeDef, DIEPINT))
+        {
+            *reg &= ~value;
+        }
+        else
+        {
+            *reg = value;
+        }
+    }
+    else
+    {
+        *reg = value;
+    }
+    SimHw_UsbPublish();
+    SimHw_UsbKick();
+    g_simHwInModel = false;
+    return true;
+}
+
+/**
+ * @brief Put the OTG core in the reset state with no cable attached.
+ */
+void SimHw_UsbReset(void)
+{
+    memset(&g_simHwUsb, 0, sizeof(g_simHwUsb));
+    g_simHwUsb.eventNs = SIMHW_NO_EVENT;
+    for (uint32_t ep = 0U; ep < SIMHW_USB_EPS; ep++)
+    {
+        g_simHwUsb.inHash[ep] = SIMHW_USB_FNV_BASIS;
+    }
+    SimHw_UsbCoreReset();
+}
+
+/**
+ * @brief Next host action.
+ */
+uint64_t SimHw_UsbNextEventNs(void)
+{
+    return g_simHwUsb.eventNs;
+}
+
+/**
+ * @brief Run the host action due at @p now.
+ */
+void SimHw_UsbEvents(uint64_t now)
+{
+    if (g_simHwUsb.eventNs <= now)
+    {
+        SimHw_UsbEvent();
+    }
+}
+
+/**
+ * @brief Raise the OTG interrupt while GINT is set and an unmasked event is pending.
+ */
+void SimHw_UsbLines(void)
+{
+    if (((USB1_OTG_HS->GAHBCFG & USB_OTG_GAHBCFG_GINT) != 0U) &&
+        ((USB1_OTG_HS->GINTSTS & USB1_OTG_HS->GINTMSK) != 0U))
+    {
+        SimHw_SetPending(16U + (uint32_t)USB1_OTG_HS_IRQn);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Store to DIEPCTL or DOEPCTL, which share their bit positions.
+ */
+static void SimHw_UsbEpControl(volatile uint32_t *ctl, uint32_t value)
+{
+    /* DIEPINT and DOEPINT sit at the same offset after their control register */
+    volatile uint32_t *intr = ctl + (offsetof(USB_OTG_INEndpointTypeDef, DIEPINT) / sizeof(uint32_t));
+    uint32_t stored = value & ~(USB_OTG_DIEPCTL_CNAK | USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_SD0PID_SEVNFRM |
+                                USB_OTG_DIEPCTL_SODDFRM);
+
+    if ((stored & USB_OTG_DIEPCTL_EPDIS) != 0U)
+    {
+        if ((*ctl & USB_OTG_DIEPCTL_EPENA) != 0U)
+        {
+            *intr |= USB_OTG_DIEPINT_EPDISD;
+        }
+        stored &= ~(USB_OTG_DIEPCTL_EPDIS | USB_OTG_DIEPCTL_EPENA);
+    }
+    *ctl = stored;
+}
+
+/**
+ * @brief Soft reset of the core: registers back to their reset values, pull-up off.
+ */
+static void SimHw_UsbCoreReset(void)
+{
+    uintptr_t base = (uintptr_t)USB1_OTG_HS;
+
+    memset((void *)(base + USB_OTG_DEVICE_BASE), 0,
+           (USB_OTG_OUT_ENDPOINT_BASE + (SIMHW_USB_EPS * USB_OTG_EP_REG_SIZE)) - USB_OTG_DEVICE_BASE);
+    USB1_OTG_HS->GOTGINT = 0U;
+    USB1_OTG_HS->GAHBCFG = 0U;
+    USB1_OTG_HS->GINTMSK = 0U;
+    USB1_OTG_HS->GRSTCTL = USB_OTG_GRSTCTL_AHBIDL;
+    SIMHW_USB_DEVICE->DCTL = USB_OTG_DCTL_SDIS;
+    g_simHwUsb.flags = 0U;
+    SimHw_UsbConnect(false);
+}
+
+/**
+ * @brief Pull-up switched by DCTL SDIS.
+ *
+ * With the cable in, the host sees the device after its debounce time
+ * and resets the bus; losing the pull-up ends the session.
+ */
+static void SimHw_UsbConnect(bool connected)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+
+    if (connected == u->connected)
+    {
+        return;
+    }
+    u->connected = connected;
+    if (u->phase == SIMHW_USB_DETACHED)
+    {
+        return;
+    }
+    SimHw_UsbHostReset();
+    u->phase = SIMHW_USB_ATTACHING;
+    u->eventNs = connected ? (g_simHwStats.now_ns + SIMHW_USB_DEBOUNCE_NS) : SIMHW_NO_EVENT;
+}
+
+/**
+ * @brief Forget the device: address, configuration and any transfer in progress.
+ */
+static void SimHw_UsbHostReset(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+
+    u->step = 0U;
+    u->stage = SIMHW_USB_CTRL_IDLE;
+    u->holdNs = 0U;
+    u->outLen = 0U;
+    u->outSent = 0U;
+    u->host.configured = false;
+    u->host.open = false;
+    u->host.address = 0U;
+    u->host.cdc_in_ep = 0U;
+    u->host.cdc_out_ep = 0U;
+    u->host.trace_in_ep = 0U;
+}
+
+/**
+ * @brief Let the host retry soon after the device may have armed an endpoint.
+ */
+static void SimHw_UsbKick(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+
+    if ((u->phase == SIMHW_USB_RUNNING) && (u->eventNs == SIMHW_NO_EVENT))
+    {
+        uint64_t at = g_simHwStats.now_ns + SIMHW_USB_POLL_NS;
+        u->eventNs = (at > u->holdNs) ? at : u->holdNs;
+    }
+}
+
+/**
+ * @brief Next host action: end of debounce or reset, or the next transaction.
+ *
+ * Once detached, the idle bus suspends the device after 3 ms.
+ */
+static void SimHw_UsbEvent(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint64_t now = g_simHwStats.now_ns;
+
+    u->eventNs = SIMHW_NO_EVENT;
+    switch (u->phase)
+    {
+    case SIMHW_USB_DETACHED:
+        if (u->connected)
+        {
+            u->suspended = true;
+            u->flags |= USB_OTG_GINTSTS_USBSUSP;
+        }
+        break;
+
+    case SIMHW_USB_ATTACHING:
+        u->phase = SIMHW_USB_RESET;
+        u->suspended = false;
+        u->flags |= USB_OTG_GINTSTS_USBRST;
+        u->eventNs = now + SIMHW_USB_RESET_NS;
+        break;
+
+    case SIMHW_USB_RESET:
+        /* DSPD 0 asks for high speed, anything else ends at full speed */
+        u->enumSpeed = ((SIMHW_USB_DEVICE->DCFG & USB_OTG_DCFG_DSPD) == 0U) ? 0U : 3U;
+        u->host.high_speed = (u->enumSpeed == 0U);
+        u->flags |= USB_OTG_GINTSTS_ENUMDNE;
+        u->phase = SIMHW_USB_RUNNING;
+        u->eventNs = now + SIMHW_USB_RECOVERY_NS;
+        break;
+
+    case SIMHW_USB_RUNNING:
+    {
+        uint64_t ns = 0U;
+        if (now >= u->holdNs)
+        {
+            if (u->stage == SIMHW_USB_CTRL_IDLE)
+            {
+                SimHw_UsbScript();
+            }
+            if (u->stage != SIMHW_USB_CTRL_IDLE)
+            {
+                ns = SimHw_UsbControl();
+            }
+        }
+        if (ns == 0U)
+        {
+            ns = SimHw_UsbBulkOut();
+        }
+        if (ns == 0U)
+        {
+            ns = SimHw_UsbBulkIn();
+        }
+        if (ns != 0U)
+        {
+            u->eventNs = now + ns;
+            g_simHwStats.usb_busy_ns += ns;
+        }
+        else if (now < u->holdNs)
+        {
+            /* Waiting for the device to recover, not for an endpoint */
+            u->eventNs = u->holdNs;
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+    SimHw_UsbPublish();
+}
+
+/**
+ * @brief Load the next request of the host: enumeration, then opening and closing the CDC port.
+ */
+static void SimHw_UsbScript(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint8_t type = 0x80U;
+    uint8_t request = SIMHW_USB_GET_DESCRIPTOR;
+    uint16_t value = 0U;
+    uint16_t index = 0U;
+    uint16_t length = 0U;
+
+    if (u->step == SIMHW_USB_STEP_IDLE)
+    {
+        if (u->openReq)
+        {
+            u->step = SIMHW_USB_STEP_LINE_CODING;
+        }
+        else if (u->closeReq)
+        {
+            u->step = SIMHW_USB_STEP_CLOSE;
+        }
+    }
+
+    switch (u->step)
+    {
+    case 0U:
+        value = 0x0100U;
+        length = 64U;
+        break;
+    case 1U:
+        type = 0x00U;
+        request = SIMHW_USB_SET_ADDRESS;
+        value = SIMHW_USB_ADDRESS;
+        break;
+    case 2U:
+        value = 0x0100U;
+        length = 18U;
+        break;
+    case 3U:
+        value = 0x0600U;
+        length = 10U;
+        break;
+    case 4U:
+        value = 0x0200U;
+        length = 9U;
+        break;
+    case 5U:
+        value = 0x0200U;
+        length = u->host.config_bytes;
+        break;
+    case 6U:
+        value = 0x0300U;
+        length = 255U;
+        break;
+    case 7U:
+        value = (uint16_t)(0x0300U | u->iProduct);
+        index = 0x0409U;
+        length = 255U;
+        break;
+    case 8U:
+        type = 0x00U;
+        request = SIMHW_USB_SET_CONFIGURATION;
+        value = 1U;
+        break;
+    case SIMHW_USB_STEP_LINE_CODING:
+        type = 0x21U;
+        request = SIMHW_USB_SET_LINE_CODING;
+        index = u->cdcInterface;
+        length = 7U;
+        u->ctrl[0] = (uint8_t)SIMHW_USB_LINE_BAUD;
+        u->ctrl[1] = (uint8_t)(SIMHW_USB_LINE_BAUD >> 8);
+        u->ctrl[2] = (uint8_t)(SIMHW_USB_LINE_BAUD >> 16);
+        u->ctrl[3] = (uint8_t)(SIMHW_USB_LINE_BAUD >> 24);
+        u->ctrl[4] = 0U;
+        u->ctrl[5] = 0U;
+        u->ctrl[6] = 8U;
+        break;
+    case SIMHW_USB_STEP_OPEN:
+    case SIMHW_USB_STEP_CLOSE:
+        type = 0x21U;
+        request = SIMHW_USB_SET_CONTROL_LINE_STATE;
+        value = (u->step == SIMHW_USB_STEP_OPEN) ? 3U : 0U;
+        index = u->cdcInterface;
+        break;
+    default:
+        return;
+    }
+
+    u->setup[0] = type;
+    u->setup[1] = request;
+    u->setup[2] = (uint8_t)value;
+    u->setup[3] = (uint8_t)(value >> 8);
+    u->setup[4] = (uint8_t)index;
+    u->setup[5] = (uint8_t)(index >> 8);
+    u->setup[6] = (uint8_t)length;
+    u->setup[7] = (uint8_t)(length >> 8);
+    u->ctrlLen = 0U;
+    u->stage = SIMHW_USB_CTRL_SETUP;
+}
+
+/**
+ * @brief One transaction of the control transfer in progress.
+ *
+ * The SETUP packet goes to the address the host assigned and is stored
+ * at DOEPDMA of endpoint 0; the data and status stages wait for the
+ * device to enable the endpoint concerned, a STALL ends the transfer.
+ *
+ * @return Bus time of the transaction, 0 when the device is not ready.
+ */
+static uint64_t SimHw_UsbControl(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    USB_OTG_INEndpointTypeDef *in = SIMHW_USB_IN(0U);
+    USB_OTG_OUTEndpointTypeDef *out = SIMHW_USB_OUT(0U);
+    uint32_t length = (uint32_t)u->setup[6] | ((uint32_t)u->setup[7] << 8);
+    uint32_t n = 0U;
+
+    switch (u->stage)
+    {
+    case SIMHW_USB_CTRL_SETUP:
+    {
+        uint32_t dad = (SIMHW_USB_DEVICE->DCFG & USB_OTG_DCFG_DAD) >> USB_OTG_DCFG_DAD_Pos;
+        uint32_t dma = out->DOEPDMA;
+        if ((out->DOEPCTL & USB_OTG_DOEPCTL_EPENA) == 0U)
+        {
+            return 0U;
+        }
+        if ((dad != u->host.address) || !SimHw_IsReachable((uintptr_t)dma, sizeof(u->setup)))
+        {
+            u->host.protocol_errors++;
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        SimHw_DCacheDmaWrite((uintptr_t)dma, u->setup, sizeof(u->setup));
+        uint32_t tsiz = out->DOEPTSIZ;
+        uint32_t count = (tsiz & USB_OTG_DOEPTSIZ_STUPCNT) >> USB_OTG_DOEPTSIZ_STUPCNT_Pos;
+        count = (count > 0U) ? (count - 1U) : 0U;
+        out->DOEPTSIZ = (tsiz & ~USB_OTG_DOEPTSIZ_STUPCNT) | (count << USB_OTG_DOEPTSIZ_STUPCNT_Pos);
+        out->DOEPDMA = dma + (uint32_t)sizeof(u->setup);
+        out->DOEPCTL &= ~(USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_STALL);
+        in->DIEPCTL &= ~USB_OTG_DIEPCTL_STALL;
+        out->DOEPINT |= USB_OTG_DOEPINT_STUP;
+        g_simHwStats.usb_setups++;
+        if (length == 0U)
+        {
+            u->stage = SIMHW_USB_CTRL_STATUS_IN;
+        }
+        else
+        {
+            u->stage = ((u->setup[0] & 0x80U) != 0U) ? SIMHW_USB_CTRL_DATA_IN : SIMHW_USB_CTRL_DATA_OUT;
+        }
+        return SIMHW_USB_CTRL_NS + SimHw_UsbPacketNs(sizeof(u->setup));
+    }
+
+    case SIMHW_USB_CTRL_DATA_IN:
+        if ((in->DIEPCTL & USB_OTG_DIEPCTL_STALL) != 0U)
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        if ((in->DIEPCTL & USB_OTG_DIEPCTL_EPENA) == 0U)
+        {
+            return 0U;
+        }
+        n = SimHw_UsbInPacket(0U, &u->ctrl[u->ctrlLen], SIMHW_USB_CTRL_BYTES - u->ctrlLen);
+        if (n > SIMHW_USB_EP0_MPS)
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        u->ctrlLen += n;
+        if ((n < SIMHW_USB_EP0_MPS) || (u->ctrlLen >= length))
+        {
+            u->stage = SIMHW_USB_CTRL_STATUS_OUT;
+        }
+        return SIMHW_USB_CTRL_NS + SimHw_UsbPacketNs(n);
+
+    case SIMHW_USB_CTRL_DATA_OUT:
+        if ((out->DOEPCTL & USB_OTG_DOEPCTL_STALL) != 0U)
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        if ((out->DOEPCTL & USB_OTG_DOEPCTL_EPENA) == 0U)
+        {
+            return 0U;
+        }
+        n = length - u->ctrlLen;
+        n = (n < SIMHW_USB_EP0_MPS) ? n : SIMHW_USB_EP0_MPS;
+        if (!SimHw_UsbOutPacket(0U, &u->ctrl[u->ctrlLen], n))
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        u->ctrlLen += n;
+        if (u->ctrlLen >= length)
+        {
+            u->stage = SIMHW_USB_CTRL_STATUS_IN;
+        }
+        return SIMHW_USB_CTRL_NS + SimHw_UsbPacketNs(n);
+
+    case SIMHW_USB_CTRL_STATUS_IN:
+        if ((in->DIEPCTL & USB_OTG_DIEPCTL_STALL) != 0U)
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        if ((in->DIEPCTL & USB_OTG_DIEPCTL_EPENA) == 0U)
+        {
+            return 0U;
+        }
+        n = SimHw_UsbInPacket(0U, NULL, 0U);
+        if (n != 0U)
+        {
+            u->host.protocol_errors++;
+        }
+        SimHw_UsbControlEnd(n == 0U);
+        return SIMHW_USB_CTRL_NS + SimHw_UsbPacketNs(0U);
+
+    case SIMHW_USB_CTRL_STATUS_OUT:
+        if ((out->DOEPCTL & USB_OTG_DOEPCTL_STALL) != 0U)
+        {
+            SimHw_UsbControlEnd(false);
+            return SIMHW_USB_CTRL_NS;
+        }
+        if ((out->DOEPCTL & USB_OTG_DOEPCTL_EPENA) == 0U)
+        {
+            return 0U;
+        }
+        SimHw_UsbControlEnd(SimHw_UsbOutPacket(0U, NULL, 0U));
+        return SIMHW_USB_CTRL_NS + SimHw_UsbPacketNs(0U);
+
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief End of a control transfer: record what the host learned and move the script on.
+ *
+ * A refused request does not stop enumeration; the device qualifier is
+ * refused anyway by a device that only runs at full speed.
+ */
+static void SimHw_UsbControlEnd(bool ok)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint32_t step = u->step;
+
+    u->stage = SIMHW_USB_CTRL_IDLE;
+    if (ok)
+    {
+        u->host.control_done++;
+    }
+    else
+    {
+        u->host.control_stalled++;
+    }
+
+    switch (step)
+    {
+    case 0U:
+    case 2U:
+        if (ok && (u->ctrlLen >= 18U))
+        {
+            u->host.vid = (uint16_t)(u->ctrl[8] | (u->ctrl[9] << 8));
+            u->host.pid = (uint16_t)(u->ctrl[10] | (u->ctrl[11] << 8));
+            u->iProduct = u->ctrl[15];
+        }
+        break;
+    case 1U:
+        if (ok)
+        {
+            u->host.address = SIMHW_USB_ADDRESS;
+            u->holdNs = g_simHwStats.now_ns + SIMHW_USB_SET_ADDRESS_NS;
+        }
+        break;
+    case 4U:
+        if (ok && (u->ctrlLen >= 4U))
+        {
+            u->host.config_bytes = (uint16_t)(u->ctrl[2] | (u->ctrl[3] << 8));
+            if (u->host.config_bytes > SIMHW_USB_CTRL_BYTES)
+            {
+                u->host.config_bytes = SIMHW_USB_CTRL_BYTES;
+            }
+        }
+        break;
+    case 5U:
+        if (ok)
+        {
+            SimHw_UsbParseConfig();
+        }
+        break;
+    case 7U:
+    {
+        uint32_t j = 0U;
+        for (uint32_t i = 2U; ok && ((i + 1U) < u->ctrlLen) && (j < (sizeof(u->host.product) - 1U)); i += 2U)
+        {
+            u->host.product[j++] = (char)u->ctrl[i];
+        }
+        u->host.product[j] = '\0';
+        break;
+    }
+    case 8U:
+        if (ok)
+        {
+            u->host.configured = true;
+            u->host.enumerated_ns = g_simHwStats.now_ns - u->attachNs;
+        }
+        break;
+    case SIMHW_USB_STEP_OPEN:
+        u->openReq = false;
+        if (ok)
+        {
+            u->host.open = true;
+            memcpy(u->outData, SIMHW_USB_OPEN_TEXT, sizeof(SIMHW_USB_OPEN_TEXT) - 1U);
+            u->outLen = sizeof(SIMHW_USB_OPEN_TEXT) - 1U;
+            u->outSent = 0U;
+        }
+        break;
+    case SIMHW_USB_STEP_CLOSE:
+        u->closeReq = false;
+        u->host.open = false;
+        u->outLen = 0U;
+        break;
+    default:
+        break;
+    }
+
+    if ((step == 8U) || (step == SIMHW_USB_STEP_OPEN) || (step == SIMHW_USB_STEP_CLOSE))
+    {
+        u->step = SIMHW_USB_STEP_IDLE;
+    }
+    else if ((step == SIMHW_USB_STEP_LINE_CODING) && !ok)
+    {
+        u->openReq = false;
+        u->step = SIMHW_USB_STEP_IDLE;
+    }
+    else if ((step == 6U) && (u->iProduct == 0U))
+    {
+        u->step = 8U;
+    }
+    else
+    {
+        u->step = step + 1U;
+    }
+}
+
+/**
+ * @brief Find the CDC and vendor bulk endpoints in the configuration descriptor set.
+ */
+static void SimHw_UsbParseConfig(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint8_t ifClass = 0U;
+
+    for (uint32_t at = 0U; ((at + 6U) <= u->ctrlLen) && (u->ctrl[at] >= 2U); at += u->ctrl[at])
+    {
+        const uint8_t *d = &u->ctrl[at];
+        if (d[1] == 4U)
+        {
+            ifClass = d[5];
+            if (ifClass == 0x02U)
+            {
+                u->cdcInterface = d[2];
+            }
+        }
+        else if ((d[1] == 5U) && ((d[3] & 0x03U) == 0x02U))
+        {
+            if (ifClass == 0x0AU)
+            {
+                if ((d[2] & 0x80U) != 0U)
+                {
+                    u->host.cdc_in_ep = d[2];
+                }
+                else
+                {
+                    u->host.cdc_out_ep = d[2];
+                }
+                u->host.bulk_mps = (uint16_t)(d[4] | (d[5] << 8));
+            }
+            else if ((ifClass == 0xFFU) && ((d[2] & 0x80U) != 0U))
+            {
+                u->host.trace_in_ep = d[2];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Host writes on the CDC data endpoint, once after the port is opened.
+ *
+ * @return Bus time of the packet, 0 when nothing is sent.
+ */
+static uint64_t SimHw_UsbBulkOut(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint32_t ep = u->host.cdc_out_ep & 0x0FU;
+
+    if (!u->host.open || (u->outSent >= u->outLen) || (ep == 0U) || (ep >= SIMHW_USB_EPS))
+    {
+        return 0U;
+    }
+
+    uint32_t ctl = SIMHW_USB_OUT(ep)->DOEPCTL;
+    uint32_t n = u->outLen - u->outSent;
+    uint32_t mps = ctl & USB_OTG_DOEPCTL_MPSIZ;
+    if (((ctl & (USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_USBAEP)) !=
+         (USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_USBAEP)) ||
+        ((ctl & USB_OTG_DOEPCTL_STALL) != 0U))
+    {
+        return 0U;
+    }
+    n = (n < mps) ? n : mps;
+    if (!SimHw_UsbOutPacket(ep, &u->outData[u->outSent], n))
+    {
+        u->outSent = u->outLen;
+        return SimHw_UsbPacketNs(0U);
+    }
+    u->outSent += n;
+    return SimHw_UsbPacketNs(n);
+}
+
+/**
+ * @brief Host reads on the bulk IN endpoints, in turn.
+ *
+ * The CDC data endpoint is only read while the port is open, the trace
+ * endpoint as soon as the device is configured.
+ *
+ * @return Bus time of the packet, 0 when no endpoint has data.
+ */
+static uint64_t SimHw_UsbBulkIn(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    uint8_t eps[2] = {u->host.open ? u->host.cdc_in_ep : 0U, u->host.trace_in_ep};
+
+    if (!u->host.configured)
+    {
+        return 0U;
+    }
+    for (uint32_t k = 0U; k < 2U; k++)
+    {
+        uint32_t slot = (u->rr + k) % 2U;
+        uint32_t ep = eps[slot] & 0x0FU;
+        if ((ep == 0U) || (ep >= SIMHW_USB_EPS))
+        {
+            continue;
+        }
+        uint32_t ctl = SIMHW_USB_IN(ep)->DIEPCTL;
+        if (((ctl & (USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_USBAEP)) !=
+             (USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_USBAEP)) ||
+            ((ctl & USB_OTG_DIEPCTL_STALL) != 0U))
+        {
+            continue;
+        }
+        u->rr = slot + 1U;
+        uint32_t n = SimHw_UsbInPacket(ep, NULL, 0U);
+        return SimHw_UsbPacketNs((n == UINT32_MAX) ? 0U : n);
+    }
+    return 0U;
+}
+
+/**
+ * @brief The host takes one packet from an enabled IN endpoint.
+ *
+ * The internal DMA reads it at DIEPDMA; XFRSIZ, PKTCNT and DIEPDMA move
+ * on and XFRC rises with the last packet. Bulk data is counted, hashed
+ * and kept in the capture ring of its endpoint.
+ *
+ * @param[in] ep    Endpoint number.
+ * @param[out] dst  Copy of the packet for a control transfer, may be NULL.
+ * @param[in] space Bytes available at @p dst.
+ *
+ * @return Packet size, UINT32_MAX when the DMA could not read it.
+ */
+static uint32_t SimHw_UsbInPacket(uint32_t ep, uint8_t *dst, uint32_t space)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    USB_OTG_INEndpointTypeDef *r = SIMHW_USB_IN(ep);
+    uint32_t mps = (ep == 0U) ? SIMHW_USB_EP0_MPS : (r->DIEPCTL & USB_OTG_DIEPCTL_MPSIZ);
+    uint32_t tsiz = r->DIEPTSIZ;
+    uint32_t size = tsiz & USB_OTG_DIEPTSIZ_XFRSIZ;
+    uint32_t packets = (tsiz & USB_OTG_DIEPTSIZ_PKTCNT) >> USB_OTG_DIEPTSIZ_PKTCNT_Pos;
+    uint32_t dma = r->DIEPDMA;
+    uint32_t n = (size < mps) ? size : mps;
+
+    if ((n > 0U) && !SimHw_IsReachable((uintptr_t)dma, n))
+    {
+        r->DIEPCTL &= ~USB_OTG_DIEPCTL_EPENA;
+        r->DIEPINT |= USB_OTG_DIEPINT_AHBERR;
+        u->host.protocol_errors++;
+        return UINT32_MAX;
+    }
+
+    uint8_t data[USB_OTG_DIEPCTL_MPSIZ];
+    SimHw_DCacheDmaRead((uintptr_t)dma, data, n);
+    if ((dst != NULL) && (n <= space))
+    {
+        memcpy(dst, data, n);
+    }
+    if (ep != 0U)
+    {
+        for (uint32_t i = 0U; i < n; i++)
+        {
+            u->inHash[ep] = (u->inHash[ep] ^ data[i]) * SIMHW_USB_FNV_PRIME;
+            u->capture[ep][u->captureHead[ep]] = data[i];
+            u->captureHead[ep] = (u->captureHead[ep] + 1U) % SIMHW_USB_CAPTURE;
+        }
+        u->inBytes[ep] += n;
+    }
+
+    size -= n;
+    packets = (packets > 0U) ? (packets - 1U) : 0U;
+    r->DIEPTSIZ = (tsiz & ~(USB_OTG_DIEPTSIZ_XFRSIZ | USB_OTG_DIEPTSIZ_PKTCNT)) |
+                  (packets << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | size;
+    r->DIEPDMA = dma + n;
+    if (packets == 0U)
+    {
+        r->DIEPCTL &= ~USB_OTG_DIEPCTL_EPENA;
+        r->DIEPINT |= USB_OTG_DIEPINT_XFRC;
+    }
+    g_simHwStats.usb_packets++;
+    g_simHwStats.usb_bytes += n;
+    return n;
+}
+
+/**
+ * @brief The host sends one packet to an enabled OUT endpoint.
+ *
+ * The internal DMA writes it at DOEPDMA; XFRC rises once PKTCNT runs
+ * out or on a short packet.
+ *
+ * @retval true  Delivered.
+ * @retval false DOEPDMA is not reachable.
+ */
+static bool SimHw_UsbOutPacket(uint32_t ep, const uint8_t *data, uint32_t n)
+{
+    USB_OTG_OUTEndpointTypeDef *r = SIMHW_USB_OUT(ep);
+    uint32_t mps = (ep == 0U) ? SIMHW_USB_EP0_MPS : (r->DOEPCTL & USB_OTG_DOEPCTL_MPSIZ);
+    uint32_t tsiz = r->DOEPTSIZ;
+    uint32_t size = tsiz & USB_OTG_DOEPTSIZ_XFRSIZ;
+    uint32_t packets = (tsiz & USB_OTG_DOEPTSIZ_PKTCNT) >> USB_OTG_DOEPTSIZ_PKTCNT_Pos;
+    uint32_t dma = r->DOEPDMA;
+
+    if ((n > 0U) && !SimHw_IsReachable((uintptr_t)dma, n))
+    {
+        r->DOEPCTL &= ~USB_OTG_DOEPCTL_EPENA;
+        r->DOEPINT |= USB_OTG_DOEPINT_AHBERR;
+        g_simHwUsb.host.protocol_errors++;
+        return false;
+    }
+    SimHw_DCacheDmaWrite((uintptr_t)dma, data, n);
+
+    size = (size > n) ? (size - n) : 0U;
+    packets = (packets > 0U) ? (packets - 1U) : 0U;
+    r->DOEPTSIZ = (tsiz & ~(USB_OTG_DOEPTSIZ_XFRSIZ | USB_OTG_DOEPTSIZ_PKTCNT)) |
+                  (packets << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | size;
+    r->DOEPDMA = dma + n;
+    if ((packets == 0U) || (n < mps))
+    {
+        r->DOEPCTL &= ~USB_OTG_DOEPCTL_EPENA;
+        r->DOEPINT |= USB_OTG_DOEPINT_XFRC;
+    }
+    g_simHwStats.usb_packets++;
+    g_simHwStats.usb_bytes += n;
+    return true;
+}
+
+/**
+ * @brief Bus time of a packet with its token, handshake and gaps.
+ */
+static uint64_t SimHw_UsbPacketNs(uint32_t bytes)
+{
+    if (g_simHwUsb.enumSpeed == 0U)
+    {
+        return (((uint64_t)bytes + 64U) * 50U) / 3U;
+    }
+    return (((uint64_t)bytes + 15U) * 2000U) / 3U;
+}
+
+/**
+ * @brief Publish DAINT, GINTSTS and DSTS.
+ */
+static void SimHw_UsbPublish(void)
+{
+    SimHw_Usb_T *u = &g_simHwUsb;
+    USB_OTG_DeviceTypeDef *d = SIMHW_USB_DEVICE;
+    uint32_t daint = 0U;
+
+    for (uint32_t ep = 0U; ep < SIMHW_USB_EPS; ep++)
+    {
+        if ((SIMHW_USB_IN(ep)->DIEPINT & d->DIEPMSK) != 0U)
+        {
+            daint |= 1UL << ep;
+        }
+        if ((SIMHW_USB_OUT(ep)->DOEPINT & d->DOEPMSK) != 0U)
+        {
+            daint |= 1UL << (USB_OTG_DAINT_OEPINT_Pos + ep);
+        }
+    }
+    d->DAINT = daint;
+
+    uint32_t sts = u->flags;
+    uint32_t masked = daint & d->DAINTMSK;
+    if ((masked & USB_OTG_DAINT_IEPINT) != 0U)
+    {
+        sts |= USB_OTG_GINTSTS_IEPINT;
+    }
+    if ((masked & USB_OTG_DAINT_OEPINT) != 0U)
+    {
+        sts |= USB_OTG_GINTSTS_OEPINT;
+    }
+    if (USB1_OTG_HS->GOTGINT != 0U)
+    {
+        sts |= USB_OTG_GINTSTS_OTGINT;
+    }
+    USB1_OTG_HS->GINTSTS = sts;
+    d->DSTS = (u->enumSpeed << USB_OTG_DSTS_ENUMSPD_Pos) | (u->suspended ? USB_OTG_DSTS_SUSPSTS : 0U);
+}
+
+/** @} */ // end of SimHw group
@@ -0,0 +1,721 @@
+/**
+ * @file SimMain.c
+ * @brief Host entry point running the unmodified firmware on the register model.
+ * @ingroup SimMain
+ * @{
+ *
+ * Boots the firmware through DevM_Startup() exactly as the reset handler
+ * does, lets it run for a fixed amount of virtual time and prints the
+ * driver diagnostics next to the model counters. Options:
+ *  - `--duration-ms N`  virtual run time (default 1000),
+ *  - `--baud N`         USART1 rate applied through UartDma_SetBaudrate(),
+ *  - `--dte-every N`    fail every Nth DMA channel start with a DTE,
+ *  - `--stall-at MS --stall-for MS` hold the USART transmitter,
+ *  - `--cost-ns N`      CPU time charged per modelled register access,
+ *  - `--dmapool-bench 1` time UartDma submits from cached memory and from the non-cacheable DMA pool,
+ *  - `--dmamem-bench 1` run the DmaMem CPU/DMA crossover calibration,
+ *  - `--dma2d-check 1`  compare DMA2D jobs with the CPU reference,
+ *  - `--venc-fps N`     feed the encoder pipeline N synthetic frames per second,
+ *  - `--crc-bench 1`    check the CRC paths against each other and time them,
+ *  - `--rng-bench 1`    time pool reads, refill latency and a sustained draw,
+ *  - `--rng-fault-every N` replace every Nth RNG word by a seed or clock error,
+ *  - `--auth-bench 1`   authenticate signed images on the PKA and in software,
+ *  - `--pka-mul-ns N`   PKA time per 32x32-bit product, scales the modelled PKA durations,
+ *  - `--spi-bench 1`    check SPI1 transactions through the loopback and time chained ones,
+ *  - `--i2c-bench 1`    check I2C1 transactions on the simulated targets and run a sensor batch,
+ *  - `--i3c-bench 1`    assign I3C1 dynamic addresses, check transfers and take in-band interrupts,
+ *  - `--adc-bench 1`    acquire timer-paced ADC1 blocks, check their sequence and signal frequencies,
+ *  - `--hrtimer-bench 1` fire bursts of microsecond timers, stop some, run a periodic one and report lateness,
+ *  - `--tickless-bench 1` run a vTaskDelayUntil() loop with and without tickless idle, compare wake-ups and accuracy,
+ *  - `--sd-image FILE`  back the simulated SD card with FILE, created if missing (default: a temporary file),
+ *  - `--sd-bench 1`     mount the SD card, stream chained writes and reads, check the data and time blocking requests,
+ *  - `--nor-image FILE` back the simulated NOR flash with FILE, created if missing (default: memory only),
+ *  - `--nor-bytes N`    NOR flash capacity, a power of two from 64 KiB to 16 MiB (default 1 MiB, 64 KiB with --logstore-bench),
+ *  - `--nor-power-loss-at N` cut the NOR flash supply during its Nth program or erase,
+ *  - `--logstore-bench 1` fill the log store past a wrap, read it back, remount and recover from cut programs and erases,
+ *  - `--usb-bench 1`    attach a USB host, enumerate, move the log to the CDC port and stream the trace channel,
+ *  - `--wave-bench 1`   check compiled GPIO waveforms word by word, play them once and in a loop, check every edge,
+ *  - `--exti-bench 1`   drive pulses, a burst and bouncing contacts into EXTI lines, check the reported edges and times,
+ *  - `--clock-bench 1`  sync the wall clock to a drifting reference, check tracking, holdover, steps and RTC calibration,
+ *  - `--out FILE|-`     write the UART line output to a file or stdout.
+ *
+ * Every check the benches make is printed with its verdict; the process
+ * exits with 1 when any of them failed, or when the run ended before the
+ * benches did, so the benches double as tests. Each bench lives in
+ * SimMain_<Bench>.c next to the model it exercises in SimHw_<Peripheral>.c.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "SysM.h"
+#include "UartDma.h"
+#include "IsrMgr.h"
+#include "DmaAlloc.h"
+#include "DmaMem.h"
+#include "Dma2d.h"
+#include "Venc.h"
+#include "Crc.h"
+#include "Rng.h"
+#include "Pka.h"
+#include "SpiDma.h"
+#include "I2cDma.h"
+#include "I3cCtrl.h"
+#include "AdcAcq.h"
+#include "HrTimer.h"
+#include "LpTick.h"
+#include "SdBlk.h"
+#include "LogStore.h"
+#include "UsbDev.h"
+#include "GpioWave.h"
+#include "ExtiEvt.h"
+#include "WallClock.h"
+#include "stm32n6xx.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_DEFAULT_DURATION_MS (1000U) /**< Virtual run time without --duration-ms */
+#define SIMMAIN_LS_NOR_BYTES        (64U * 1024U) /**< --logstore-bench flash size unless --nor-bytes is given */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Command line options.
+ */
+typedef struct
+{
+    uint32_t durationMs;  /**< Virtual run time */
+    uint32_t baudrate;    /**< Line rate to apply, 0 keeps the driver default */
+    const char *outPath;  /**< UART output destination, NULL to discard */
+    bool dmaPoolBench;    /**< Time UartDma submits with and without cache maintenance */
+    bool dmaMemBench;     /**< Run ::DmaMem_Calibrate from the control task */
+    bool dma2dCheck;      /**< Run the DMA2D jobs against the CPU reference */
+    uint32_t vencFps;     /**< Synthetic capture rate, 0 leaves the encoder unused */
+    bool crcBench;        /**< Check and time the CRC paths */
+    bool rngBench;        /**< Time the RNG pool */
+    bool authBench;       /**< Authenticate signed images on the PKA and in software */
+    bool spiBench;        /**< Check and time SPI1 transactions */
+    bool i2cBench;        /**< Check I2C1 transactions and run a batch */
+    bool i3cBench;        /**< Check I3C1 addressing, transfers and in-band interrupts */
+    bool adcBench;        /**< Acquire ADC1 blocks and check them */
+    bool hrTimerBench;    /**< Fire microsecond timers and report their lateness */
+    bool ticklessBench;   /**< Compare a periodic task with and without tickless idle */
+    bool sdBench;         /**< Stream and check SD card blocks */
+    bool logStoreBench;   /**< Fill, read back and power-cut the log store */
+    bool usbBench;        /**< Enumerate on the simulated host and stream over USB */
+    bool waveBench;       /**< Compile and play GPIO waveforms */
+    bool extiBench;       /**< Drive EXTI lines and check the reported edges */
+    bool clockBench;      /**< Discipline the wall clock to a drifting reference */
+} SimMain_Options_T;
+
+/* Global Variables ---------------------------------------------------------*/
+/** Firmware entry, called by the reset handler on target. */
+extern void DevM_Startup(void);
+static SimMain_Options_T g_simMainOptions = {.durationMs = SIMMAIN_DEFAULT_DURATION_MS};
+/** A bench check failed, see ::SimMain_Fail. */
+static bool g_simMainFailed = false;
+/** The control task ran every requested bench to its end. */
+static bool g_simMainBenchesDone = false;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static bool SimMain_ParseArgs(int argc, char **argv, SimHw_Config_T *config);
+static void SimMain_ControlTask(void *pvParameters);
+static void SimMain_Stop(void);
+static void SimMain_Report(double wallSeconds);
+
+/* Public Functions Implementation ------------------------------------------*/
+int main(int argc, char **argv)
+{
+    SimHw_Config_T config = {
+        .reg_access_ns = SIMHW_DEFAULT_REG_ACCESS_NS,
+        .m2m_bytes_per_us = SIMHW_DEFAULT_M2M_BYTES_PER_US,
+    };
+
+    if (!SimMain_ParseArgs(argc, argv, &config))
+    {
+        fprintf(stderr,
+                "usage: %s [--duration-ms N] [--baud N] [--dte-every N] [--stall-at MS --stall-for MS]\n"
+                "          [--cost-ns N] [--dmapool-bench 1] [--dmamem-bench 1] [--dma2d-check 1]\n"
+                "          [--venc-fps N] [--crc-bench 1] [--rng-bench 1] [--rng-fault-every N]\n"
+                "          [--auth-bench 1] [--pka-mul-ns N] [--spi-bench 1]\n"
+                "          [--i2c-bench 1] [--i3c-bench 1] [--adc-bench 1]\n"
+                "          [--hrtimer-bench 1] [--tickless-bench 1] [--sd-image FILE] [--sd-bench 1]\n"
+                "          [--nor-image FILE] [--nor-bytes N] [--nor-power-loss-at N] [--logstore-bench 1]\n"
+                "          [--usb-bench 1] [--wave-bench 1] [--exti-bench 1] [--clock-bench 1]\n"
+                "          [--out FILE|-]\n",
+                argv[0]);
+        return 2;
+    }
+    if (g_simMainOptions.clockBench)
+    {
+        config.rtc_ppb = SIMMAIN_CLOCK_RTC_PPB;
+    }
+    if (g_simMainOptions.logStoreBench && (config.nor_bytes == 0U))
+    {
+        /* Small enough for the bench to wrap the ring */
+        config.nor_bytes = SIMMAIN_LS_NOR_BYTES;
+    }
+
+    if (g_simMainOptions.outPath != NULL)
+    {
+        config.tx_sink = (strcmp(g_simMainOptions.outPath, "-") == 0) ? stdout : fopen(g_simMainOptions.outPath, "wb");
+        if (config.tx_sink == NULL)
+        {
+            perror(g_simMainOptions.outPath);
+            return 1;
+        }
+    }
+
+    if (!SimHw_Init(&config))
+    {
+        fprintf(stderr, "SimHw: cannot map the register windows at their fixed addresses\n");
+        return 1;
+    }
+    SimHw_SetStopTime((uint64_t)g_simMainOptions.durationMs * SIMMAIN_NS_PER_MS, SimMain_Stop);
+
+    /* Runs first once the scheduler starts, before any firmware task */
+    xTaskCreate(SimMain_ControlTask, "SimCtrl", configMINIMAL_STACK_SIZE, NULL, configMAX_PRIORITIES - 1, NULL);
+
+    double wallStart = SimMain_WallTime();
+    DevM_Startup();
+    double wallSeconds = SimMain_WallTime() - wallStart;
+
+    if ((config.tx_sink != NULL) && (config.tx_sink != stdout))
+    {
+        fclose(config.tx_sink);
+    }
+    if (config.sd_image != NULL)
+    {
+        fclose(config.sd_image);
+    }
+    if (config.nor_image != NULL)
+    {
+        fclose(config.nor_image);
+    }
+    fflush(stdout);
+    SimMain_Report(wallSeconds);
+    if (!g_simMainBenchesDone)
+    {
+        fprintf(stderr, "benches           : cut by --duration-ms %u, %s\n", g_simMainOptions.durationMs,
+                SimMain_Fail("ERROR"));
+    }
+    return g_simMainFailed ? 1 : 0;
+}
+
+/**
+ * @brief Record a failed check and return the verdict printed for it.
+ *
+ * Used as the failing branch of a verdict, so the flag is only set when
+ * the check actually failed.
+ */
+const char *SimMain_Fail(const char *verdict)
+{
+    g_simMainFailed = true;
+    return verdict;
+}
+
+/**
+ * @brief Host monotonic time in seconds.
+ */
+double SimMain_WallTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Parse the command line into the options and model configuration.
+ *
+ * @retval true  Arguments valid.
+ * @retval false Unknown option or missing value.
+ */
+static bool SimMain_ParseArgs(int argc, char **argv, SimHw_Config_T *config)
+{
+    uint64_t stallAtMs = 0U;
+    uint64_t stallForMs = 0U;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *opt = argv[i];
+        if ((i + 1) >= argc)
+        {
+            return false;
+        }
+        const char *value = argv[++i];
+        unsigned long long number = strtoull(value, NULL, 0);
+
+        if (strcmp(opt, "--duration-ms") == 0)
+        {
+            g_simMainOptions.durationMs = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--baud") == 0)
+        {
+            g_simMainOptions.baudrate = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--dte-every") == 0)
+        {
+            config->dte_every = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--stall-at") == 0)
+        {
+            stallAtMs = number;
+        }
+        else if (strcmp(opt, "--stall-for") == 0)
+        {
+            stallForMs = number;
+        }
+        else if (strcmp(opt, "--cost-ns") == 0)
+        {
+            config->reg_access_ns = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--dmapool-bench") == 0)
+        {
+            g_simMainOptions.dmaPoolBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--dmamem-bench") == 0)
+        {
+            g_simMainOptions.dmaMemBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--dma2d-check") == 0)
+        {
+            g_simMainOptions.dma2dCheck = (number != 0U);
+        }
+        else if (strcmp(opt, "--venc-fps") == 0)
+        {
+            g_simMainOptions.vencFps = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--crc-bench") == 0)
+        {
+            g_simMainOptions.crcBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--rng-bench") == 0)
+        {
+            g_simMainOptions.rngBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--rng-fault-every") == 0)
+        {
+            config->rng_fault_every = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--auth-bench") == 0)
+        {
+            g_simMainOptions.authBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--pka-mul-ns") == 0)
+        {
+            config->pka_word_mul_ns = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--spi-bench") == 0)
+        {
+            g_simMainOptions.spiBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--i2c-bench") == 0)
+        {
+            g_simMainOptions.i2cBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--i3c-bench") == 0)
+        {
+            g_simMainOptions.i3cBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--adc-bench") == 0)
+        {
+            g_simMainOptions.adcBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--hrtimer-bench") == 0)
+        {
+            g_simMainOptions.hrTimerBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--tickless-bench") == 0)
+        {
+            g_simMainOptions.ticklessBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--sd-image") == 0)
+        {
+            config->sd_image = fopen(value, "r+b");
+            if (config->sd_image == NULL)
+            {
+                config->sd_image = fopen(value, "w+b");
+            }
+            if (config->sd_image == NULL)
+            {
+                perror(value);
+                return false;
+            }
+        }
+        else if (strcmp(opt, "--sd-bench") == 0)
+        {
+            g_simMainOptions.sdBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--nor-image") == 0)
+        {
+            config->nor_image = fopen(value, "r+b");
+            if (config->nor_image == NULL)
+            {
+                config->nor_image = fopen(value, "w+b");
+            }
+            if (config->nor_image == NULL)
+            {
+                perror(value);
+                return false;
+            }
+        }
+        else if (strcmp(opt, "--nor-bytes") == 0)
+        {
+            config->nor_bytes = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--nor-power-loss-at") == 0)
+        {
+            config->nor_power_loss_at = (uint32_t)number;
+        }
+        else if (strcmp(opt, "--logstore-bench") == 0)
+        {
+            g_simMainOptions.logStoreBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--usb-bench") == 0)
+        {
+            g_simMainOptions.usbBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--wave-bench") == 0)
+        {
+            g_simMainOptions.waveBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--exti-bench") == 0)
+        {
+            g_simMainOptions.extiBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--clock-bench") == 0)
+        {
+            g_simMainOptions.clockBench = (number != 0U);
+        }
+        else if (strcmp(opt, "--out") == 0)
+        {
+            g_simMainOptions.outPath = value;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    config->stall_start_ns = stallAtMs * SIMMAIN_NS_PER_MS;
+    config->stall_end_ns = (stallAtMs + stallForMs) * SIMMAIN_NS_PER_MS;
+    return g_simMainOptions.durationMs != 0U;
+}
+
+/**
+ * @brief Apply run-time settings from inside the scheduler, then exit.
+ */
+static void SimMain_ControlTask(void *pvParameters)
+{
+    (void)pvParameters;
+
+    if ((g_simMainOptions.baudrate != 0U) && !UartDma_SetBaudrate(g_simMainOptions.baudrate))
+    {
+        fprintf(stderr, "UartDma_SetBaudrate(%u) %s\n", g_simMainOptions.baudrate, SimMain_Fail("rejected"));
+    }
+    if (g_simMainOptions.dmaPoolBench)
+    {
+        SimMain_DmaPoolBench();
+    }
+    if (g_simMainOptions.dmaMemBench)
+    {
+        SimMain_DmaMemBench();
+    }
+    if (g_simMainOptions.dma2dCheck)
+    {
+        SimMain_Dma2dCheck();
+    }
+    if (g_simMainOptions.crcBench)
+    {
+        SimMain_CrcBench();
+    }
+    if (g_simMainOptions.rngBench)
+    {
+        SimMain_RngBench();
+    }
+    if (g_simMainOptions.authBench)
+    {
+        SimMain_AuthBench();
+    }
+    if (g_simMainOptions.spiBench)
+    {
+        SimMain_SpiBench();
+    }
+    if (g_simMainOptions.i2cBench)
+    {
+        SimMain_I2cBench();
+    }
+    if (g_simMainOptions.i3cBench)
+    {
+        SimMain_I3cBench();
+    }
+    if (g_simMainOptions.adcBench)
+    {
+        SimMain_AdcBench();
+    }
+    if (g_simMainOptions.hrTimerBench)
+    {
+        SimMain_HrTimerBench();
+    }
+    if (g_simMainOptions.ticklessBench)
+    {
+        SimMain_TicklessBench();
+    }
+    if (g_simMainOptions.sdBench)
+    {
+        SimMain_SdBench();
+    }
+    if (g_simMainOptions.logStoreBench)
+    {
+        SimMain_LogStoreBench();
+    }
+    if (g_simMainOptions.usbBench)
+    {
+        SimMain_UsbBench();
+    }
+    if (g_simMainOptions.waveBench)
+    {
+        SimMain_WaveBench();
+    }
+    if (g_simMainOptions.extiBench)
+    {
+        SimMain_ExtiBench();
+    }
+    if (g_simMainOptions.clockBench)
+    {
+        SimMain_ClockBench();
+    }
+    /* The encoder bench streams until the run ends */
+    g_simMainBenchesDone = true;
+    if (g_simMainOptions.vencFps != 0U)
+    {
+        SimMain_VencBench(g_simMainOptions.vencFps);
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Stop hook: leave the scheduler and return to main().
+ */
+static void SimMain_Stop(void)
+{
+    vTaskEndScheduler();
+}
+
+/**
+ * @brief Print driver diagnostics and model counters.
+ */
+static void SimMain_Report(double wallSeconds)
+{
+    SysM_Diagnostics_T diag;
+    SimHw_Stats_T stats;
+
+    SysM_GetDiagnostics(&diag);
+    SimHw_GetStats(&stats);
+
+    double seconds = (double)stats.now_ns / 1e9;
+    uint32_t baud = SimHw_GetUsartBaudrate();
+
+    fprintf(stderr, "\n--- simulation report ---\n");
+    fprintf(stderr, "virtual time      : %.3f ms (host %.3f s, %.1fx real time)\n", seconds * 1e3, wallSeconds,
+            (wallSeconds > 0.0) ? (seconds / wallSeconds) : 0.0);
+    fprintf(stderr, "usart1            : %u baud (driver %u requested, %u actual, %d ppm)\n", baud,
+            diag.uart.baudrate, diag.uart.actual_baudrate, diag.uart.baud_error_ppm);
+    fprintf(stderr, "line bytes        : %llu (%.0f B/s, line busy %.1f %%)\n",
+            (unsigned long long)stats.usart_tx_bytes, (seconds > 0.0) ? ((double)stats.usart_tx_bytes / seconds) : 0.0,
+            (stats.now_ns != 0U) ? (100.0 * (double)stats.usart_busy_ns / (double)stats.now_ns) : 0.0);
+    fprintf(stderr, "cpu load          : %.1f %%\n",
+            (stats.now_ns != 0U) ? (100.0 * (1.0 - ((double)stats.idle_ns / (double)stats.now_ns))) : 0.0);
+    fprintf(stderr, "dma               : %llu starts, %llu bytes, %llu errors\n", (unsigned long long)stats.dma_starts,
+            (unsigned long long)stats.dma_bytes, (unsigned long long)stats.dma_errors);
+    fprintf(stderr, "dcache            : %llu lines, %llu write-backs, %llu dirty dma reads, %llu dirty drops\n",
+            (unsigned long long)stats.dcache_lines, (unsigned long long)stats.dcache_writebacks,
+            (unsigned long long)stats.dcache_dirty_reads, (unsigned long long)stats.dcache_dirty_drops);
+    fprintf(stderr, "exceptions        : %llu irqs, %llu systick/pendsv\n", (unsigned long long)stats.irqs_taken,
+            (unsigned long long)stats.exceptions_taken);
+    fprintf(stderr, "driver transfers  : %u done, %u bytes\n", diag.uart.transfers_done, diag.uart.bytes_sent);
+    fprintf(stderr, "driver errors     : dte %u, ule %u, use %u, timeouts %u, retries %u, drops %u\n",
+            diag.uart.errors_dte, diag.uart.errors_ule, diag.uart.errors_use, diag.uart.timeouts, diag.uart.retries,
+            diag.uart.drops);
+    fprintf(stderr, "submit cycles     : cached %u, non-cacheable %u\n", diag.uart.submit_cycles_cached,
+            diag.uart.submit_cycles_noncached);
+    DmaMem_Status_T mem;
+    DmaMem_GetStatus(&mem);
+    fprintf(stderr, "dmamem            : threshold %u, dma %u req %llu bytes %u items, cpu %u req %llu bytes, "
+                    "busy %u, errors %u\n",
+            mem.threshold, mem.dma_requests, (unsigned long long)mem.dma_bytes, mem.items, mem.cpu_requests,
+            (unsigned long long)mem.cpu_bytes, mem.busy, mem.errors);
+    Dma2d_Status_T d2d;
+    Dma2d_GetStatus(&d2d);
+    fprintf(stderr, "dma2d             : %u jobs, %llu pixels (model %llu), %u failed, queue peak %u, full %u\n",
+            d2d.jobs_done, (unsigned long long)d2d.pixels, (unsigned long long)stats.dma2d_pixels, d2d.jobs_failed,
+            d2d.queue_peak, d2d.queue_full);
+    Venc_Status_T venc;
+    Venc_GetStatus(&venc);
+    fprintf(stderr, "venc              : %u acquired, %u drops, %u encoded (%u key), %u errors, %u stalls, "
+                    "%llu bytes, ring peak %u\n",
+            venc.frames_acquired, venc.capture_drops, venc.frames_encoded, venc.keyframes, venc.encode_errors,
+            venc.ring_stalls, (unsigned long long)venc.bytes, venc.ring_peak);
+    if (venc.frames_encoded != 0U)
+    {
+        fprintf(stderr, "venc latency      : avg %.2f ms, max %.2f ms, encoder busy %.1f %%, checksum %08x\n",
+                1e3 * (double)venc.latency_cycles / venc.frames_encoded / (double)SystemCoreClock,
+                1e3 * (double)venc.latency_max / (double)SystemCoreClock,
+                (seconds > 0.0) ? (100.0 * (double)venc.busy_cycles / ((double)SystemCoreClock * seconds)) : 0.0,
+                g_simMainVencChecksum);
+    }
+    Crc_Status_T crc;
+    Crc_GetStatus(&crc);
+    fprintf(stderr, "crc               : unit %llu bytes, dma %llu bytes (model %llu), software %llu bytes, "
+                    "busy %u, tables %u, errors %u\n",
+            (unsigned long long)crc.hw_bytes, (unsigned long long)crc.dma_bytes, (unsigned long long)stats.crc_bytes,
+            (unsigned long long)crc.sw_bytes, crc.hw_busy, crc.table_builds, crc.dma_errors);
+    Rng_Status_T rng;
+    Rng_GetStatus(&rng);
+    fprintf(stderr, "rng               : level %u, %u words in (model %llu), %u out, %u requests, %u underruns, "
+                    "%u retries, %u refills\n",
+            rng.level, rng.words_in, (unsigned long long)stats.rng_words, rng.words_out, rng.requests,
+            rng.underruns, rng.retries, rng.refills);
+    fprintf(stderr, "rng errors        : seed %u, clock %u (injected %llu), reset timeouts %u, discarded %u\n",
+            rng.seed_errors, rng.clock_errors, (unsigned long long)stats.rng_faults, rng.reset_timeouts,
+            rng.discarded);
+    Pka_Status_T pka;
+    Pka_GetStatus(&pka);
+    fprintf(stderr, "pka               : %u ecdsa, %u modexp (model %llu), busy %u, errors %u, last %u cycles\n",
+            pka.ecdsa, pka.modexp, (unsigned long long)stats.pka_ops, pka.busy, pka.errors, pka.last_cycles);
+    SpiDma_Status_T spi;
+    SpiDma_GetStatus(&spi);
+    fprintf(stderr, "spi               : %u done, %u failed, %llu bytes (model %llu), %u runs, %u chained, "
+                    "queue peak %u, full %u, errors %u, line busy %.1f %%\n",
+            spi.xfers_done, spi.xfers_failed, (unsigned long long)spi.bytes, (unsigned long long)stats.spi_bytes,
+            spi.runs, spi.chained, spi.queue_peak, spi.queue_full, spi.errors,
+            (stats.now_ns != 0U) ? (100.0 * (double)stats.spi_busy_ns / (double)stats.now_ns) : 0.0);
+    I2cDma_Status_T i2c;
+    I2cDma_GetStatus(&i2c);
+    fprintf(stderr, "i2c               : %u done, %u nacks, %u bus errors, %u dma errors, %llu bytes (model %llu), "
+                    "%u batches, queue peak %u, full %u, bus busy %.1f %%\n",
+            i2c.xfers_done, i2c.nacks, i2c.bus_errors, i2c.dma_errors, (unsigned long long)i2c.bytes,
+            (unsigned long long)stats.i2c_bytes, i2c.batches, i2c.queue_peak, i2c.queue_full,
+            (stats.now_ns != 0U) ? (100.0 * (double)stats.i2c_busy_ns / (double)stats.now_ns) : 0.0);
+    I3cCtrl_Status_T i3c;
+    I3cCtrl_GetStatus(&i3c);
+    fprintf(stderr, "i3c               : %u done, %u nacks, %u bus errors, %u dma errors, %llu bytes (model %llu), "
+                    "%u short reads, %u targets, %u ibis + %u unclaimed (model %llu), queue peak %u, full %u, "
+                    "bus busy %.1f %%\n",
+            i3c.xfers_done, i3c.nacks, i3c.bus_errors, i3c.dma_errors, (unsigned long long)i3c.bytes,
+            (unsigned long long)stats.i3c_bytes, i3c.short_reads, i3c.targets, i3c.ibis, i3c.ibis_unclaimed,
+            (unsigned long long)stats.i3c_ibis, i3c.queue_peak, i3c.queue_full,
+            (stats.now_ns != 0U) ? (100.0 * (double)stats.i3c_busy_ns / (double)stats.now_ns) : 0.0);
+    AdcAcq_Status_T adc;
+    AdcAcq_GetStatus(&adc);
+    fprintf(stderr, "adc               : %u blocks, %u taken, %u dropped, %u overwritten, %u overruns, "
+                    "%u dma errors, %u irqs, %llu conversions (model), %llu overruns (model), %llu missed triggers\n",
+            adc.blocks, adc.taken, adc.dropped, adc.overwritten, adc.overruns, adc.dma_errors, adc.irqs,
+            (unsigned long long)stats.adc_conversions, (unsigned long long)stats.adc_overruns,
+            (unsigned long long)stats.adc_trig_missed);
+    HrTimer_Status_T hr;
+    HrTimer_GetStatus(&hr);
+    fprintf(stderr, "hrtimer           : %u started, %u fired, %u stopped, %u missed periods, %u full, peak %u, "
+                    "%u irqs, %llu compares (model), late avg %u / max %u ns, hist",
+            hr.started, hr.fired, hr.stopped, hr.missed_periods, hr.full, hr.pending_peak, hr.irqs,
+            (unsigned long long)stats.tim_compares, hr.late_avg_ns, hr.late_max_ns);
+    for (uint32_t i = 0U; i < HRTIMER_LATE_BINS; i++)
+    {
+        fprintf(stderr, " %u", hr.late_hist[i]);
+    }
+    fprintf(stderr, "\n");
+    LpTick_Status_T tick;
+    LpTick_GetStatus(&tick);
+    fprintf(stderr, "lptick            : %u Hz %s, tickless %s, %u irqs, %u ticks + %u stepped, %u sleeps, "
+                    "%u aborted, longest %u ticks (limit %u), %u compare timeouts, %llu compares (model)\n",
+            tick.clock_hz, tick.lse ? "lse" : "lsi", tick.tickless ? "on" : "off", tick.tick_irqs, tick.ticks,
+            tick.ticks_stepped, tick.sleeps, tick.sleep_aborts, tick.sleep_max_ticks, tick.max_idle_ticks,
+            tick.cmp_timeouts, (unsigned long long)stats.lptim_compares);
+    SdBlk_Status_T sd;
+    SdBlk_GetStatus(&sd);
+    fprintf(stderr, "sd                : %u done, %u failed, %llu read, %llu written (model %llu), %u runs, "
+                    "%u chained, %u pre-erases, %u segments, errors cmd %u data %u dma %u card %u, queue peak %u, "
+                    "full %u, %u irqs, %llu commands (model), latency avg %u / max %u us, card busy %.1f %%\n",
+            sd.requests_done, sd.requests_failed, (unsigned long long)sd.bytes_read,
+            (unsigned long long)sd.bytes_written, (unsigned long long)stats.sd_bytes, sd.runs, sd.chained,
+            sd.pre_erases, sd.segments, sd.cmd_errors, sd.data_errors, sd.dma_errors, sd.card_errors,
+            sd.queue_peak, sd.queue_full, sd.irqs, (unsigned long long)stats.sd_commands, sd.latency_avg_us,
+            sd.latency_max_us, (stats.now_ns != 0U) ? (100.0 * (double)stats.sd_busy_ns / (double)stats.now_ns) : 0.0);
+    LogStore_Status_T ls;
+    LogStore_GetStatus(&ls);
+    fprintf(stderr, "logstore          : %s, id 0x%06x, %u/%u sectors, seq %u, %u appended, %u dropped, stage peak %u, "
+                    "%u records, %llu bytes, %u pages (model %llu), %u erases (model %llu), %u reclaimed, wear %u..%u, "
+                    "%u torn, %u crc errors, %u flash errors, %u power losses (model), mount %u us\n",
+            ls.mounted ? "mounted" : "offline", ls.jedec_id, ls.sectors_used, ls.sectors, ls.head_seq, ls.appended,
+            ls.dropped, ls.stage_peak, ls.records, (unsigned long long)ls.bytes, ls.pages,
+            (unsigned long long)stats.nor_programs, ls.erases, (unsigned long long)stats.nor_erases, ls.reclaimed,
+            ls.erase_min, ls.erase_max, ls.torn, ls.crc_errors, ls.flash_errors,
+            (unsigned)stats.nor_power_losses, ls.mount_us);
+    static const char *const usbStates[] = {"detached", "default", "addressed", "configured", "suspended"};
+    UsbDev_Status_T usb;
+    UsbDev_GetStatus(&usb);
+    fprintf(stderr, "usb               : %s, %s speed, address %u, %u done, %u failed, cdc %llu B, trace %llu B, "
+                    "%u transfers, %u zlps, %u B received, %u setups (model %llu), %u stalls, %u resets, %u suspends, "
+                    "queue peak %u, full %u, %u irqs, %llu packets (model), bus busy %.1f %%\n",
+            usbStates[usb.state], usb.high_speed ? "high" : "full", usb.address, usb.requests_done,
+            usb.requests_failed, (unsigned long long)usb.bytes[USBDEV_CDC], (unsigned long long)usb.bytes[USBDEV_TRACE],
+            usb.transfers, usb.zlps, usb.rx_bytes, usb.setups, (unsigned long long)stats.usb_setups, usb.stalls,
+            usb.resets, usb.suspends, usb.queue_peak, usb.queue_full, usb.irqs, (unsigned long long)stats.usb_packets,
+            (stats.now_ns != 0U) ? (100.0 * (double)stats.usb_busy_ns / (double)stats.now_ns) : 0.0);
+    GpioWave_Status_T wave;
+    GpioWave_GetStatus(&wave);
+    fprintf(stderr, "wave              : %s, %u Hz, %u started, %u completed, %u stopped, %u laps, %u dma errors, "
+                    "%u irqs, %llu timer dma requests (model), %llu edges (model)\n",
+            wave.running ? (wave.circular ? "looping" : "playing") : "idle", wave.actual_hz, wave.starts,
+            wave.completed, wave.stopped, wave.laps, wave.dma_errors, wave.irqs,
+            (unsigned long long)stats.tim_dma_requests, (unsigned long long)stats.gpio_edges);
+    ExtiEvt_Status_T exti;
+    ExtiEvt_GetStatus(&exti);
+    fprintf(stderr, "exti              : %u lines, %u edges, %u dispatched, %u settled, %u bounces, %u overflows, "
+                    "%u wake-ups, ring peak %u, %u irqs, %llu edges latched (model)\n",
+            exti.lines, exti.events, exti.dispatched, exti.settled, exti.bounces, exti.overflows, exti.wakeups,
+            exti.ring_peak, exti.irqs, (unsigned long long)stats.exti_edges);
+    WallClock_Status_T clock;
+    WallClock_GetStatus(&clock);
+    fprintf(stderr, "clock             : %s, rtc %s, %s, %u syncs, %u steps, %u rejected, %u refreshes, rtc %+d ppb, "
+                    "freq %+d ppb, rate %+d ppb, cal %+d ppb, last offset %lld ns, %llu wake-ups (model)\n",
+            clock.lse ? "lse" : "lsi", clock.rtc_valid ? "kept" : "started", clock.synced ? "synced" : "free running",
+            clock.syncs, clock.steps, clock.rejected, clock.refreshes, clock.rtc_ppb, clock.freq_ppb, clock.rate_ppb,
+            clock.cal_ppb, (long long)clock.last_offset_ns, (unsigned long long)stats.rtc_wakeups);
+    fprintf(stderr, "latency histogram :");
+    for (uint32_t i = 0U; i < UARTDMA_LATENCY_BINS; i++)
+    {
+        fprintf(stderr, " %u", diag.uart.latency_hist[i]);
+    }
+    fprintf(stderr, "\n");
+
+    for (uint32_t irq = 0U; irq < ISRMGR_IRQ_COUNT; irq++)
+    {
+        IsrMgr_Stats_T isr;
+        if (IsrMgr_GetStats((IRQn_Type)irq, &isr) && (isr.count != 0U))
+        {
+            fprintf(stderr, "irq %-3u           : %u calls, avg %llu / max %u cycles, %.2f %% cpu\n", irq, isr.count,
+                    (unsigned long long)(isr.total_cycles / isr.count), isr.max_cycles,
+                    (seconds > 0.0) ? (100.0 * (double)isr.total_cycles / ((double)SystemCoreClock * seconds)) : 0.0);
+        }
+    }
+
+    for (uint32_t id = 0U; id < DMAALLOC_CHANNEL_COUNT; id++)
+    {
+        DmaAlloc_Stats_T dma;
+        if (DmaAlloc_GetStats(id, &dma) && (dma.owner != NULL))
+        {
+            fprintf(stderr, "%s ch%-2u       : %s, %u runs, %llu bytes, busy %.1f %%\n",
+                    (id < DMAALLOC_CHANNELS_PER_CTRL) ? "gpdma1" : "hpdma1", id % DMAALLOC_CHANNELS_PER_CTRL,
+                    dma.owner, dma.transfers, (unsigned long long)dma.bytes,
+                    (seconds > 0.0) ? (100.0 * (double)dma.busy_cycles / ((double)SystemCoreClock * seconds)) : 0.0);
+        }
+    }
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,142 @@
+/**
+ * @file SimMain_Adc.c
+ * @brief ADC bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --adc-bench: timer-paced ADC1 blocks, their sequence and signal
+ * frequencies. Every check is printed with its verdict and failures go
+ * through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "AdcAcq.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_adc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_ADC_CHANNELS        (3U)          /**< --adc-bench inputs per frame */
+#define SIMMAIN_ADC_RATE_HZ         (10000U)      /**< --adc-bench frame rate */
+#define SIMMAIN_ADC_FRAMES          (160U)        /**< --adc-bench frames per block, whole cache lines */
+#define SIMMAIN_ADC_RUN_MS          (200U)        /**< --adc-bench streaming run time */
+#define SIMMAIN_ADC_HOLD_MS         (40U)         /**< --adc-bench time one block is held */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint16_t g_simMainAdcBuffer[2U * SIMMAIN_ADC_FRAMES * SIMMAIN_ADC_CHANNELS] __attribute__((aligned(32)));
+
+/* Private Function Prototypes ----------------------------------------------*/
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Stream ADC1 blocks, check their order and the input frequencies, then hold one too long.
+ *
+ * Input n of the model is a sine of (n + 1) x 100 Hz; its frequency is
+ * recovered from the rising mid-scale crossings of the samples.
+ */
+void SimMain_AdcBench(void)
+{
+    static const uint8_t channels[SIMMAIN_ADC_CHANNELS] = {0U, 1U, 3U};
+    AdcAcq_Config_T config = {
+        .channel_count = SIMMAIN_ADC_CHANNELS,
+        .rate_hz = SIMMAIN_ADC_RATE_HZ,
+        .oversampling = 16U,
+        .sampling_time = LL_ADC_SAMPLINGTIME_11CYCLES_5,
+        .buffer = g_simMainAdcBuffer,
+        .frames_per_block = SIMMAIN_ADC_FRAMES,
+        .task = xTaskGetCurrentTaskHandle(),
+        .notify_bits = 0x1U,
+    };
+    memcpy(config.channels, channels, sizeof(channels));
+
+    if (!AdcAcq_Start(&config))
+    {
+        fprintf(stderr, "adc stream        : %s start rejected\n", SimMain_Fail("ERROR"));
+        return;
+    }
+    AdcAcq_Status_T status;
+    AdcAcq_GetStatus(&status);
+    uint32_t mid = 1UL << (status.sample_bits - 1U);
+
+    /* Stream, releasing every block right after looking at it */
+    uint32_t crossings[SIMMAIN_ADC_CHANNELS] = {0U};
+    uint32_t firstCross[SIMMAIN_ADC_CHANNELS] = {0U};
+    uint32_t lastCross[SIMMAIN_ADC_CHANNELS] = {0U};
+    uint16_t last[SIMMAIN_ADC_CHANNELS] = {0U};
+    uint32_t frames = 0U;
+    uint32_t gaps = 0U;
+    uint32_t damaged = 0U;
+    uint32_t nextSeq = 0U;
+    uint32_t cycleStart = DWT->CYCCNT;
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(SIMMAIN_ADC_RUN_MS);
+    while ((int32_t)(end - xTaskGetTickCount()) > 0)
+    {
+        AdcAcq_Block_T block;
+        if (!AdcAcq_Take(&block, pdMS_TO_TICKS(50U)))
+        {
+            break;
+        }
+        gaps += ((block.seq != nextSeq) || block.restarted) ? 1U : 0U;
+        nextSeq = block.seq + 1U;
+        for (uint32_t f = 0U; f < block.frames; f++)
+        {
+            for (uint32_t c = 0U; c < SIMMAIN_ADC_CHANNELS; c++)
+            {
+                uint16_t sample = block.samples[(f * SIMMAIN_ADC_CHANNELS) + c];
+                if ((frames != 0U) && (last[c] < mid) && (sample >= mid))
+                {
+                    firstCross[c] = (crossings[c] == 0U) ? frames : firstCross[c];
+                    lastCross[c] = frames;
+                    crossings[c]++;
+                }
+                last[c] = sample;
+            }
+            frames++;
+        }
+        damaged += AdcAcq_Release(&block) ? 0U : 1U;
+    }
+    double seconds = (double)(DWT->CYCCNT - cycleStart) / (double)SystemCoreClock;
+    double streamed = (double)frames / (double)SIMMAIN_ADC_RATE_HZ;
+    fprintf(stderr, "adc stream        : %u ch at %u Hz (adc %u Hz, %u bits), %u blocks %u frames in %.1f ms, "
+                    "%u gaps, %u damaged, %s\n",
+            SIMMAIN_ADC_CHANNELS, status.actual_hz, status.adc_hz, status.sample_bits, nextSeq, frames,
+            seconds * 1e3, gaps, damaged,
+            ((gaps == 0U) && (damaged == 0U) && (frames != 0U) && ((seconds - streamed) < 0.04)) ? "ok" : SimMain_Fail("ERROR"));
+    fprintf(stderr, "adc frequency     :");
+    for (uint32_t c = 0U; c < SIMMAIN_ADC_CHANNELS; c++)
+    {
+        uint32_t span = lastCross[c] - firstCross[c];
+        double hz = (span != 0U) ? ((double)(crossings[c] - 1U) * (double)SIMMAIN_ADC_RATE_HZ / (double)span) : 0.0;
+        fprintf(stderr, " in%u %.1f Hz (model %u)", channels[c], hz, (channels[c] + 1U) * 100U);
+    }
+    fprintf(stderr, "\n");
+
+    /* Hold one block past the DMA coming back to it */
+    AdcAcq_Status_T before;
+    AdcAcq_GetStatus(&before);
+    AdcAcq_Block_T held;
+    bool taken = AdcAcq_Take(&held, pdMS_TO_TICKS(50U));
+    vTaskDelay(pdMS_TO_TICKS(SIMMAIN_ADC_HOLD_MS));
+    bool intact = taken && AdcAcq_Release(&held);
+    AdcAcq_Block_T next;
+    taken = taken && AdcAcq_Take(&next, pdMS_TO_TICKS(50U));
+    if (taken)
+    {
+        (void)AdcAcq_Release(&next);
+    }
+    AdcAcq_Stop();
+    AdcAcq_GetStatus(&status);
+    xTaskNotifyStateClearIndexed(NULL, ADCACQ_NOTIFY_INDEX);
+    fprintf(stderr, "adc hold          : %u ms, %s, %u dropped, next seq %u after %u, %s\n", SIMMAIN_ADC_HOLD_MS,
+            intact ? "intact" : "overwritten", status.dropped - before.dropped, taken ? next.seq : 0U, held.seq,
+            (!intact && taken && (status.overwritten > before.overwritten)) ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/** @} */ // end of SimMain group
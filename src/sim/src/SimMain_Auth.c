@@ -0,0 +1,193 @@
+/**
+ * @file SimMain_Auth.c
+ * @brief Image authentication bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --auth-bench: signed images authenticated on the PKA and in software. Every
+ * check is printed with its verdict and failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Pka.h"
+#include "ImgAuth.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_AUTH_HEADER         (0x400U)      /**< --auth-bench header and signature area */
+#define SIMMAIN_AUTH_PAYLOAD        (128U * 1024U) /**< --auth-bench payload */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainAuthImage[SIMMAIN_AUTH_HEADER + SIMMAIN_AUTH_PAYLOAD] __attribute__((aligned(32)));
+/* --auth-bench test keys and the signatures of its images, made offline */
+static const uint8_t g_simMainAuthEcdsaX[32] = {
+    0x55, 0x7F, 0x1C, 0x54, 0x15, 0xBD, 0x00, 0xEB, 0x57, 0xA4, 0x6E, 0xD7, 0x71, 0x35, 0x11, 0x7E,
+    0xB8, 0xBC, 0x60, 0xD9, 0x78, 0x4C, 0x65, 0x26, 0x66, 0x62, 0xE6, 0xDE, 0x59, 0x1C, 0x68, 0x76
+};
+
+static const uint8_t g_simMainAuthEcdsaY[32] = {
+    0xE8, 0x39, 0xB2, 0x15, 0x75, 0x8F, 0xBB, 0x2B, 0xCD, 0x4A, 0xEF, 0x9E, 0x56, 0x05, 0xAA, 0xD5,
+    0xFD, 0x9F, 0xF0, 0xB2, 0x27, 0xDB, 0x84, 0x01, 0x24, 0x6E, 0x2A, 0xFF, 0x74, 0x98, 0xCA, 0xD1
+};
+
+static const uint8_t g_simMainAuthEcdsaSig[64] = {
+    0x63, 0x21, 0x6B, 0xE1, 0x40, 0xAC, 0x3E, 0x46, 0xBC, 0x05, 0x89, 0x48, 0x7E, 0xBC, 0xA0, 0x50,
+    0x77, 0x60, 0x67, 0xE6, 0x27, 0xD7, 0xB1, 0x73, 0x99, 0x20, 0x13, 0xD1, 0xD1, 0xB7, 0x84, 0xC7,
+    0xB6, 0x55, 0x00, 0xA9, 0x07, 0x11, 0xEF, 0x2E, 0x4C, 0xB4, 0x5B, 0x55, 0xC4, 0x7B, 0xF7, 0x33,
+    0x68, 0x44, 0xE7, 0xF2, 0x1C, 0x8B, 0x6B, 0x90, 0x1D, 0x0A, 0xF3, 0xF0, 0x5A, 0xB6, 0x0C, 0x9F
+};
+
+static const uint8_t g_simMainAuthRsaN[256] = {
+    0xC7, 0x12, 0x7F, 0x6E, 0x70, 0x14, 0x72, 0xDD, 0x58, 0xE1, 0xB7, 0x48, 0x71, 0x31, 0x86, 0xC2,
+    0x23, 0x63, 0x5B, 0x77, 0x55, 0x0D, 0xEE, 0xCF, 0x8D, 0x0D, 0xA8, 0x83, 0x39, 0xE7, 0x85, 0xB3,
+    0x5E, 0x25, 0xD5, 0x0C, 0x38, 0xBB, 0xBF, 0xBE, 0x00, 0xC6, 0x09, 0x36, 0x1F, 0x84, 0x7C, 0xB7,
+    0x5D, 0xFA, 0x75, 0x77, 0x13, 0x5A, 0x2E, 0xB6, 0x87, 0x47, 0x3D, 0x56, 0x89, 0x7B, 0x82, 0x93,
+    0x58, 0xEF, 0x2B, 0x30, 0x66, 0xE7, 0x9F, 0x3A, 0x74, 0xAD, 0xBE, 0x19, 0x0D, 0x03, 0xDF, 0xC0,
+    0xCC, 0xD4, 0xA1, 0x1F, 0x84, 0x1B, 0x95, 0x86, 0x08, 0xF5, 0x35, 0xB5, 0x56, 0xF3, 0x4B, 0x65,
+    0xAD, 0xD4, 0x83, 0x40, 0x1A, 0x4C, 0x14, 0x08, 0xFB, 0x1C, 0xD7, 0xFB, 0x25, 0x38, 0xB4, 0x2C,
+    0xC0, 0x11, 0xAC, 0x8A, 0x9D, 0xB0, 0x6E, 0x50, 0x43, 0x66, 0x55, 0x8A, 0x2E, 0xDD, 0x25, 0x81,
+    0x63, 0x6D, 0x20, 0x95, 0x62, 0x04, 0x14, 0x6A, 0xEF, 0x92, 0x61, 0xBD, 0xEE, 0x01, 0x05, 0x5D,
+    0x38, 0x9C, 0x81, 0xC2, 0xB6, 0xF7, 0xDD, 0xE6, 0x1E, 0x52, 0x28, 0x7F, 0x4E, 0xD1, 0xEC, 0x52,
+    0xC7, 0x50, 0xF4, 0xDF, 0xD2, 0x6C, 0x12, 0x6E, 0x31, 0xDF, 0xF5, 0xEC, 0xA9, 0xA0, 0xC5, 0xD2,
+    0xA9, 0x12, 0xC0, 0x88, 0xD2, 0x11, 0xD1, 0xFB, 0xE9, 0x1D, 0x1B, 0x4E, 0x8E, 0xB7, 0x67, 0x15,
+    0xFC, 0x34, 0xCA, 0xA4, 0x72, 0x7D, 0x9D, 0x48, 0x1C, 0x82, 0x22, 0x9A, 0x66, 0x65, 0x00, 0x4B,
+    0xF8, 0xC7, 0x3E, 0xE7, 0xB8, 0x23, 0x84, 0x58, 0x85, 0xC9, 0x05, 0x3D, 0x7D, 0x30, 0x7D, 0xAA,
+    0x95, 0xFF, 0x02, 0x8C, 0x01, 0x89, 0x3C, 0xBF, 0xB1, 0xC9, 0x9A, 0x49, 0xC1, 0x67, 0x23, 0x81,
+    0x1B, 0xB1, 0x14, 0xFA, 0xA6, 0xB8, 0xEF, 0xD2, 0xC4, 0x6D, 0x73, 0x48, 0x5E, 0x6F, 0xFA, 0x73
+};
+
+static const uint8_t g_simMainAuthRsaSig[256] = {
+    0x0F, 0xEB, 0x13, 0x30, 0x38, 0x7F, 0x38, 0x16, 0xF5, 0x66, 0xF5, 0x0C, 0xB4, 0xC3, 0x63, 0x8E,
+    0xFA, 0x0B, 0xE7, 0x6D, 0x5C, 0xA6, 0xB0, 0xCF, 0xC7, 0x8C, 0xA5, 0x2C, 0x34, 0xA1, 0xB3, 0x74,
+    0x3D, 0xFD, 0x0F, 0x4B, 0x98, 0x63, 0xCC, 0x8F, 0xF7, 0xE9, 0xF6, 0x8C, 0x3A, 0x97, 0x19, 0xEF,
+    0x50, 0x1C, 0x6D, 0xDE, 0xD8, 0x09, 0xC4, 0xD1, 0x98, 0x42, 0xC2, 0x4B, 0x11, 0x16, 0x77, 0x59,
+    0x73, 0x2D, 0x10, 0x38, 0x25, 0xE8, 0x06, 0xDE, 0x81, 0x8D, 0x31, 0x0D, 0x40, 0x25, 0xF2, 0x6B,
+    0x89, 0x3E, 0x59, 0x31, 0xB0, 0x5E, 0x17, 0x1A, 0x43, 0xD4, 0x7A, 0xF2, 0xD8, 0xA1, 0xD1, 0x17,
+    0x9D, 0x22, 0xD9, 0x62, 0x38, 0xD6, 0xC0, 0xEE, 0xB7, 0x03, 0x89, 0x06, 0x68, 0x82, 0x9F, 0x64,
+    0x18, 0x6F, 0x5F, 0x5B, 0xC0, 0x08, 0xB7, 0xC5, 0x41, 0x18, 0x00, 0xBA, 0x6B, 0x58, 0x6F, 0x94,
+    0x88, 0x6E, 0xB6, 0xB3, 0x6C, 0x28, 0x3E, 0x14, 0x6D, 0xFA, 0x45, 0x23, 0xF5, 0x11, 0x90, 0x59,
+    0x0F, 0xB4, 0x25, 0x44, 0xB9, 0xD1, 0x7A, 0xF9, 0xE4, 0xAF, 0xA0, 0x5E, 0x59, 0xC3, 0x69, 0xA9,
+    0x07, 0x47, 0xBF, 0xEF, 0xAC, 0x39, 0x77, 0xB4, 0x85, 0x09, 0xA1, 0x88, 0xA3, 0x04, 0x1F, 0xFF,
+    0xFA, 0x4D, 0x96, 0xAC, 0xC9, 0x96, 0x9A, 0xFE, 0x6F, 0x1D, 0x60, 0xAF, 0xDA, 0x7A, 0x06, 0x09,
+    0x50, 0x47, 0x1F, 0xD8, 0x8D, 0xC6, 0x65, 0x12, 0xEC, 0xBE, 0x7C, 0x58, 0xF2, 0x18, 0xDB, 0x47,
+    0xA2, 0x75, 0xD0, 0x35, 0xF2, 0x58, 0x2B, 0x5F, 0xD9, 0x20, 0xF6, 0x9C, 0x9A, 0x2D, 0x17, 0x86,
+    0x4E, 0x97, 0x5D, 0x1C, 0x1B, 0x9E, 0xE4, 0xFF, 0xC2, 0x63, 0xE9, 0x67, 0xFD, 0xFF, 0x47, 0x6C,
+    0x71, 0x0D, 0x48, 0x89, 0x38, 0x91, 0x78, 0x20, 0xFF, 0xB2, 0xB9, 0x88, 0x6F, 0x0F, 0x7C, 0x8F
+};
+
+/* Private Function Prototypes ----------------------------------------------*/
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Authenticate ECDSA P-256 and RSA-2048 signed images on the PKA and in software.
+ *
+ * The images carry a 128 KiB payload and were signed offline with test
+ * keys. Each one is also checked with a corrupted signature and with a
+ * corrupted payload, which must be rejected. Before each PKA check a
+ * notification is left pending on both notification indices, as other
+ * drivers would give them, and must not end the operation early. PKA
+ * times are virtual, the software signature and SHA-256 times are host
+ * times.
+ */
+void SimMain_AuthBench(void)
+{
+    static const uint8_t exponent[] = {0x01U, 0x00U, 0x01U};
+    static const ImgAuth_Key_T keys[] = {
+        {IMGAUTH_SIG_ECDSA_P256, 1U, g_simMainAuthEcdsaX, g_simMainAuthEcdsaY, NULL, 0U, NULL, 0U},
+        {IMGAUTH_SIG_RSA_PKCS1, 1U, NULL, NULL, g_simMainAuthRsaN, sizeof(g_simMainAuthRsaN), exponent,
+         sizeof(exponent)},
+    };
+    static const struct
+    {
+        const char *name;
+        ImgAuth_SigType_T type;
+        const uint8_t *sig;
+        uint16_t size;
+    } scheme[] = {
+        {"ecdsa-p256", IMGAUTH_SIG_ECDSA_P256, g_simMainAuthEcdsaSig, sizeof(g_simMainAuthEcdsaSig)},
+        {"rsa-2048", IMGAUTH_SIG_RSA_PKCS1, g_simMainAuthRsaSig, sizeof(g_simMainAuthRsaSig)},
+    };
+    static const char *const results[] = {"ok", "format", "key", "signature", "hash", "engine"};
+    uint8_t *payload = &g_simMainAuthImage[SIMMAIN_AUTH_HEADER];
+    uint32_t seed = 0x13579BDFU;
+
+    for (uint32_t i = 0U; i < SIMMAIN_AUTH_PAYLOAD; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        payload[i] = (uint8_t)(seed >> 24);
+    }
+
+    /* Signing side: the header carries the payload digest */
+    ImgAuth_Header_T hdr = {
+        .magic = IMGAUTH_MAGIC,
+        .header_version = IMGAUTH_HEADER_VERSION,
+        .header_size = SIMMAIN_AUTH_HEADER,
+        .image_size = SIMMAIN_AUTH_PAYLOAD,
+        .load_addr = 0x34180400U,
+        .entry = 0x34180401U,
+        .image_version = 0x00010002U,
+        .sig_type = (uint8_t)scheme[0].type,
+        .key_id = 1U,
+        .sig_size = scheme[0].size,
+    };
+    ImgAuth_Sha256_T sha;
+    double wallStart = SimMain_WallTime();
+    ImgAuth_Sha256Init(&sha);
+    ImgAuth_Sha256Update(&sha, payload, SIMMAIN_AUTH_PAYLOAD);
+    ImgAuth_Sha256Final(&sha, hdr.hash);
+    double shaMs = 1e3 * (SimMain_WallTime() - wallStart);
+
+    fprintf(stderr, "auth bench        : scheme      engine    result  tampered  signature ms  sha-256 ms  total ms\n");
+    for (uint32_t i = 0U; i < (sizeof(scheme) / sizeof(scheme[0])); i++)
+    {
+        hdr.sig_type = (uint8_t)scheme[i].type;
+        hdr.sig_size = scheme[i].size;
+        memset(g_simMainAuthImage, 0, SIMMAIN_AUTH_HEADER);
+        memcpy(g_simMainAuthImage, &hdr, sizeof(hdr));
+        memcpy(&g_simMainAuthImage[sizeof(hdr)], scheme[i].sig, scheme[i].size);
+
+        for (uint32_t e = 0U; e < 2U; e++)
+        {
+            ImgAuth_Engine_T engine = (e == 0U) ? IMGAUTH_ENGINE_PKA : IMGAUTH_ENGINE_SW;
+            ImgAuth_Report_T rep;
+
+            if (engine == IMGAUTH_ENGINE_PKA)
+            {
+                (void)xTaskNotifyGiveIndexed(xTaskGetCurrentTaskHandle(), 0U);
+                (void)xTaskNotifyGiveIndexed(xTaskGetCurrentTaskHandle(), PKA_NOTIFY_INDEX);
+            }
+            wallStart = SimMain_WallTime();
+            ImgAuth_Result_T res = ImgAuth_Verify(g_simMainAuthImage, sizeof(g_simMainAuthImage), keys, 2U, engine, &rep);
+            double wallMs = 1e3 * (SimMain_WallTime() - wallStart);
+            (void)ulTaskNotifyTakeIndexed(0U, pdTRUE, 0U);
+
+            g_simMainAuthImage[sizeof(hdr) + 5U] ^= 0x01U;
+            bool badSig = ImgAuth_Verify(g_simMainAuthImage, sizeof(g_simMainAuthImage), keys, 2U, engine, NULL) ==
+                          IMGAUTH_ERR_SIGNATURE;
+            g_simMainAuthImage[sizeof(hdr) + 5U] ^= 0x01U;
+            payload[SIMMAIN_AUTH_PAYLOAD / 2U] ^= 0x80U;
+            bool badHash = ImgAuth_Verify(g_simMainAuthImage, sizeof(g_simMainAuthImage), keys, 2U, engine, NULL) ==
+                           IMGAUTH_ERR_HASH;
+            payload[SIMMAIN_AUTH_PAYLOAD / 2U] ^= 0x80U;
+
+            /* The software signature check is the host time left once the payload digest is taken out */
+            double sigMs = (engine == IMGAUTH_ENGINE_PKA) ? (1e3 * (double)rep.signature_cycles / (double)SystemCoreClock)
+                                                          : ((wallMs > shaMs) ? (wallMs - shaMs) : 0.0);
+            fprintf(stderr, "                    %-10s  %-8s  %-6s  %-8s  %7.2f%s  %10.2f  %8.2f\n", scheme[i].name,
+                    (engine == IMGAUTH_ENGINE_PKA) ? "pka" : "software",
+                    (res == IMGAUTH_OK) ? results[res] : SimMain_Fail(results[res]),
+                    (badSig && badHash) ? "rejected" : SimMain_Fail("ACCEPTED"), sigMs,
+                    (engine == IMGAUTH_ENGINE_PKA) ? "     " : " host", shaMs, sigMs + shaMs);
+        }
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/** @} */ // end of SimMain group
@@ -0,0 +1,295 @@
+/**
+ * @file SimMain_Clock.c
+ * @brief WallClock bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --clock-bench: wall clock disciplined to a drifting reference, holdover,
+ * steps and RTC calibration. Every check is printed with its verdict and
+ * failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "WallClock.h"
+#include "stm32n6xx.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_CLOCK_EPOCH_S       (1792324800ULL) /**< --clock-bench reference at time zero, 2026-10-18 12:00:00 */
+#define SIMMAIN_CLOCK_RTC_EPOCH_S   (946684800ULL)  /**< 2000-01-01, where a fresh RTC calendar starts */
+#define SIMMAIN_CLOCK_RTC_END_S     (4102444800ULL) /**< 2100-01-01, past the RTC calendar */
+#define SIMMAIN_CLOCK_LAST_S        (16756761599ULL) /**< 2500-12-31 23:59:59, end of the calendar round trips */
+#define SIMMAIN_CLOCK_REF_PPB       (-50000)      /**< --clock-bench reference rate against virtual time */
+#define SIMMAIN_CLOCK_JITTER_NS     (100)         /**< --clock-bench largest error of a sync */
+#define SIMMAIN_CLOCK_FREE_MS       (50U)         /**< --clock-bench free running measurement */
+#define SIMMAIN_CLOCK_SYNC_MS       (25U)         /**< --clock-bench sync interval */
+#define SIMMAIN_CLOCK_SYNCS         (16U)         /**< --clock-bench syncs of the tracking phase */
+#define SIMMAIN_CLOCK_SETTLE_SYNCS  (4U)          /**< --clock-bench syncs before the error is checked */
+#define SIMMAIN_CLOCK_HOLD_MS       (100U)        /**< --clock-bench holdover without syncs */
+#define SIMMAIN_CLOCK_JUMP_NS       (5000000U)    /**< --clock-bench reference jump, stepped */
+#define SIMMAIN_CLOCK_JUMP_SYNCS    (4U)          /**< --clock-bench syncs after the jump */
+#define SIMMAIN_CLOCK_MAX_ERROR_NS  (1000)        /**< --clock-bench worst accepted UTC error once synced */
+#define SIMMAIN_CLOCK_RTC_MAX_ERROR_NS (366211)   /**< --clock-bench worst accepted RTC error, 3 sub-second ticks */
+#define SIMMAIN_CLOCK_ROUND_TRIPS   (10000U)      /**< --clock-bench calendar conversions checked both ways */
+#define SIMMAIN_CLOCK_READS         (1000U)       /**< --clock-bench reads timed */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief --clock-bench UTC samples of one phase.
+ */
+typedef struct
+{
+    bool synced;     /**< Every sync was taken */
+    bool backwards;  /**< UTC decreased between two samples */
+    uint32_t samples; /**< Samples whose error was checked */
+    int64_t worstNs; /**< Largest error against the reference */
+    int64_t sumNs;   /**< Sum of the errors */
+} SimMain_ClockStats_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static uint32_t g_simMainClockSeed = 0x0DDB1A5EU;
+static uint64_t g_simMainClockJumpNs = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static uint64_t SimMain_ClockReference(uint64_t jumpNs);
+static bool SimMain_ClockSync(uint64_t jumpNs);
+static void SimMain_ClockSample(SimMain_ClockStats_T *stats, uint32_t ms, bool check);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Discipline the wall clock to a reference drifting against the core clock and check it.
+ *
+ * The reference runs ::SIMMAIN_CLOCK_REF_PPB off virtual time, the RTC
+ * clock ::SIMMAIN_CLOCK_RTC_PPB off its nominal frequency; each sync
+ * carries reference time with a pseudo-random error of up to
+ * ::SIMMAIN_CLOCK_JITTER_NS. Free running, UTC must follow the RTC; once
+ * synced it must follow the reference within ::SIMMAIN_CLOCK_MAX_ERROR_NS,
+ * never run backwards, hold over without syncs and step on a jump, and
+ * the RTC calendar must be set and calibrated to the reference rate.
+ */
+void SimMain_ClockBench(void)
+{
+    WallClock_Status_T status;
+
+    /* Free running: wait for the first RTC measurement, then UTC runs at the RTC rate */
+    WallClock_GetStatus(&status);
+    while (!status.rtc_measured)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10U));
+        WallClock_GetStatus(&status);
+    }
+    uint64_t v0 = SimHw_GetTimeNs();
+    uint64_t m0 = WallClock_Mono();
+    uint64_t u0 = WallClock_Utc();
+    vTaskDelay(pdMS_TO_TICKS(SIMMAIN_CLOCK_FREE_MS));
+    uint64_t v1 = SimHw_GetTimeNs();
+    uint64_t m1 = WallClock_Mono();
+    uint64_t u1 = WallClock_Utc();
+    WallClock_GetStatus(&status);
+    int64_t monoSkew = (int64_t)(m1 - m0) - (int64_t)(v1 - v0);
+    double freePpb = ((double)(u1 - u0) - (double)(m1 - m0)) * 1e9 / (double)(m1 - m0);
+    double rtcPpb = (double)SIMMAIN_CLOCK_RTC_PPB;
+    bool freeOk = status.rtc_measured && !status.synced && !status.rtc_valid &&
+                  (u0 >= (SIMMAIN_CLOCK_RTC_EPOCH_S * WALLCLOCK_NS_PER_S)) && (monoSkew > -100) && (monoSkew < 100) &&
+                  (fabs((double)status.rtc_ppb - rtcPpb) < 200.0) && (fabs(freePpb - rtcPpb) < 200.0);
+    fprintf(stderr, "clock free run   : rtc measured %+d ppb, utc rate %+.0f ppb (rtc %+d ppb), mono skew %lld ns, %s\n",
+            status.rtc_ppb, freePpb, SIMMAIN_CLOCK_RTC_PPB, (long long)monoSkew, freeOk ? "ok" : SimMain_Fail("ERROR"));
+    bool ok = freeOk;
+
+    /* Invalid syncs are refused */
+    bool rejected = !WallClock_Sync(SIMMAIN_CLOCK_EPOCH_S * WALLCLOCK_NS_PER_S, WallClock_Mono() + SIMMAIN_NS_PER_MS) &&
+                    !WallClock_Sync((SIMMAIN_CLOCK_RTC_EPOCH_S * WALLCLOCK_NS_PER_S) - 1U, WallClock_Mono()) &&
+                    !WallClock_Sync(SIMMAIN_CLOCK_RTC_END_S * WALLCLOCK_NS_PER_S, WallClock_Mono());
+
+    /* First sync steps UTC and the RTC calendar */
+    bool stepOk = SimMain_ClockSync(0);
+    uint64_t rtc = 0U;
+    bool rtcRead = WallClock_ReadRtc(&rtc);
+    int64_t rtcError = (int64_t)(rtc - WallClock_Utc());
+    WallClock_Calendar_T cal;
+    WallClock_ToCalendar(rtc, &cal);
+    WallClock_GetStatus(&status);
+    stepOk = stepOk && rtcRead && (status.steps == 1U) && (cal.year == 2026U) && (cal.month == 10U) &&
+             (cal.day == 18U) && (llabs(rtcError) < SIMMAIN_CLOCK_RTC_MAX_ERROR_NS);
+    fprintf(stderr, "clock first sync : offset %lld ns stepped, rtc %04u-%02u-%02u %02u:%02u:%02u off by %lld ns, %s\n",
+            (long long)status.last_offset_ns, cal.year, cal.month, cal.day, cal.hour, cal.minute, cal.second,
+            (long long)rtcError, stepOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && stepOk;
+
+    /* Syncs slew out the offsets and the frequency settles; UTC is sampled in between */
+    SimMain_ClockStats_T track = {.synced = true};
+    for (uint32_t k = 0U; k < SIMMAIN_CLOCK_SYNCS; k++)
+    {
+        SimMain_ClockSample(&track, SIMMAIN_CLOCK_SYNC_MS, k >= SIMMAIN_CLOCK_SETTLE_SYNCS);
+        track.synced = track.synced && SimMain_ClockSync(0);
+    }
+    WallClock_GetStatus(&status);
+    double refPpb = (double)SIMMAIN_CLOCK_REF_PPB;
+    bool trackOk = track.synced && !track.backwards && (track.worstNs < SIMMAIN_CLOCK_MAX_ERROR_NS) &&
+                   (status.steps == 1U) && (fabs((double)status.freq_ppb - refPpb) < 1000.0);
+    fprintf(stderr, "clock tracking   : %u syncs, freq %+d ppb (reference %+d ppb), %u samples, error avg %lld / max "
+                    "%lld ns, %s\n",
+            SIMMAIN_CLOCK_SYNCS, status.freq_ppb, SIMMAIN_CLOCK_REF_PPB, track.samples,
+            (long long)((track.samples != 0U) ? (track.sumNs / (int64_t)track.samples) : 0),
+            (long long)track.worstNs, trackOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && trackOk;
+
+    /* Holdover without syncs */
+    SimMain_ClockStats_T hold = {.synced = true};
+    SimMain_ClockSample(&hold, SIMMAIN_CLOCK_HOLD_MS, true);
+    bool holdOk = !hold.backwards && (hold.worstNs < SIMMAIN_CLOCK_MAX_ERROR_NS);
+    fprintf(stderr, "clock holdover   : %u ms, %u samples, error max %lld ns, %s\n", SIMMAIN_CLOCK_HOLD_MS,
+            hold.samples, (long long)hold.worstNs, holdOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && holdOk;
+
+    /* A jump of the reference is stepped, then tracked again */
+    SimMain_ClockStats_T jump = {.synced = true};
+    jump.synced = SimMain_ClockSync(SIMMAIN_CLOCK_JUMP_NS);
+    WallClock_GetStatus(&status);
+    int64_t jumpOffset = status.last_offset_ns;
+    for (uint32_t k = 0U; k < SIMMAIN_CLOCK_JUMP_SYNCS; k++)
+    {
+        SimMain_ClockSample(&jump, SIMMAIN_CLOCK_SYNC_MS, true);
+        jump.synced = jump.synced && SimMain_ClockSync(SIMMAIN_CLOCK_JUMP_NS);
+    }
+    WallClock_GetStatus(&status);
+    bool jumpOk = jump.synced && !jump.backwards && (status.steps == 2U) &&
+                  (llabs(jumpOffset - (int64_t)SIMMAIN_CLOCK_JUMP_NS) < SIMMAIN_CLOCK_MAX_ERROR_NS) &&
+                  (jump.worstNs < SIMMAIN_CLOCK_MAX_ERROR_NS);
+    fprintf(stderr, "clock jump       : offset %lld ns stepped, %u steps, error max %lld ns after, %s\n",
+            (long long)jumpOffset, status.steps, (long long)jump.worstNs, jumpOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && jumpOk;
+
+    /* The calendar runs at the reference rate through the smooth calibration */
+    uint32_t calr = RTC->CALR;
+    double wantPpb = refPpb - (double)status.rtc_ppb;
+    double wantCalm = -wantPpb * 1048576.0 / (1e9 + wantPpb);
+    rtcRead = WallClock_ReadRtc(&rtc);
+    rtcError = (int64_t)(rtc - WallClock_Utc());
+    bool calOk = rtcRead && ((calr & RTC_CALR_CALP) == 0U) && (fabs((double)(calr & RTC_CALR_CALM) - wantCalm) <= 2.0) &&
+                 (llabs(rtcError) < SIMMAIN_CLOCK_RTC_MAX_ERROR_NS);
+    fprintf(stderr, "clock calibration: CALM %u CALP %u (expected CALM %.1f), %+d ppb, rtc off by %lld ns, %s\n",
+            (unsigned)(calr & RTC_CALR_CALM), ((calr & RTC_CALR_CALP) != 0U) ? 1U : 0U, wantCalm, status.cal_ppb,
+            (long long)rtcError, calOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && calOk;
+
+    /* Calendar conversions */
+    static const struct
+    {
+        WallClock_Calendar_T cal;
+        uint64_t seconds;
+    } dates[] = {
+        {{1970U, 1U, 1U, 0U, 0U, 0U, 4U, 0U}, 0U},
+        {{2000U, 2U, 29U, 12U, 34U, 56U, 2U, 789000000U}, 951827696U},
+        {{2024U, 12U, 31U, 23U, 59U, 59U, 2U, 0U}, 1735689599U},
+        {{2099U, 12U, 31U, 0U, 0U, 0U, 4U, 0U}, 4102358400ULL},
+    };
+    static const WallClock_Calendar_T invalid[] = {
+        {2023U, 2U, 29U, 0U, 0U, 0U, 0U, 0U},
+        {2024U, 13U, 1U, 0U, 0U, 0U, 0U, 0U},
+        {2024U, 4U, 31U, 0U, 0U, 0U, 0U, 0U},
+        {1969U, 12U, 31U, 23U, 59U, 59U, 0U, 0U},
+        {2024U, 1U, 1U, 24U, 0U, 0U, 0U, 0U},
+    };
+    uint32_t calErrors = 0U;
+    for (uint32_t i = 0U; i < (sizeof(dates) / sizeof(dates[0])); i++)
+    {
+        uint64_t ns = (dates[i].seconds * WALLCLOCK_NS_PER_S) + dates[i].cal.ns;
+        WallClock_ToCalendar(ns, &cal);
+        calErrors += (WallClock_FromCalendar(&dates[i].cal) != ns) ? 1U : 0U;
+        calErrors += (memcmp(&cal, &dates[i].cal, sizeof(cal)) != 0) ? 1U : 0U;
+    }
+    for (uint32_t i = 0U; i < (sizeof(invalid) / sizeof(invalid[0])); i++)
+    {
+        calErrors += (WallClock_FromCalendar(&invalid[i]) != 0U) ? 1U : 0U;
+    }
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (uint32_t i = 0U; i < SIMMAIN_CLOCK_ROUND_TRIPS; i++)
+    {
+        seed = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+        uint64_t ns = seed % (SIMMAIN_CLOCK_LAST_S * WALLCLOCK_NS_PER_S);
+        WallClock_ToCalendar(ns, &cal);
+        calErrors += (WallClock_FromCalendar(&cal) != ns) ? 1U : 0U;
+    }
+    fprintf(stderr, "clock calendar   : %u known dates, %u invalid, %u round trips, %u errors, %s\n",
+            (unsigned)(sizeof(dates) / sizeof(dates[0])), (unsigned)(sizeof(invalid) / sizeof(invalid[0])),
+            SIMMAIN_CLOCK_ROUND_TRIPS, calErrors, (calErrors == 0U) ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && (calErrors == 0U);
+
+    /* Read cost, on the host: the model charges no time for the cycle counter */
+    uint64_t last = WallClock_Utc();
+    bool ordered = true;
+    double wallStart = SimMain_WallTime();
+    for (uint32_t i = 0U; i < SIMMAIN_CLOCK_READS; i++)
+    {
+        uint64_t utc = WallClock_Utc();
+        ordered = ordered && (utc >= last);
+        last = utc;
+    }
+    double hostNs = (SimMain_WallTime() - wallStart) * 1e9 / (double)SIMMAIN_CLOCK_READS;
+    fprintf(stderr, "clock read cost  : %.1f ns host per WallClock_Utc, %u reads %s\n", hostNs, SIMMAIN_CLOCK_READS,
+            ordered ? "in order, ok" : SimMain_Fail("ERROR out of order"));
+    ok = ok && ordered;
+
+    WallClock_GetStatus(&status);
+    ok = ok && rejected && (status.rejected == 3U);
+    fprintf(stderr, "clock bench      : %s, %s\n", rejected ? "invalid syncs rejected" : SimMain_Fail("ERROR accepted an invalid sync"),
+            ok ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Reference UTC at the current virtual time, jumped by @p jumpNs.
+ */
+static uint64_t SimMain_ClockReference(uint64_t jumpNs)
+{
+    uint64_t v = SimHw_GetTimeNs();
+    return (SIMMAIN_CLOCK_EPOCH_S * WALLCLOCK_NS_PER_S) + jumpNs + v +
+           (uint64_t)(((int64_t)v * SIMMAIN_CLOCK_REF_PPB) / (int64_t)WALLCLOCK_NS_PER_S);
+}
+
+/**
+ * @brief Take a sync carrying the reference time with a pseudo-random error.
+ */
+static bool SimMain_ClockSync(uint64_t jumpNs)
+{
+    g_simMainClockSeed = (g_simMainClockSeed * 1664525U) + 1013904223U;
+    int64_t jitter = (int64_t)(g_simMainClockSeed % ((2U * SIMMAIN_CLOCK_JITTER_NS) + 1U)) - SIMMAIN_CLOCK_JITTER_NS;
+    uint64_t mono = WallClock_Mono();
+    g_simMainClockJumpNs = jumpNs;
+    return WallClock_Sync(SimMain_ClockReference(jumpNs) + (uint64_t)jitter, mono);
+}
+
+/**
+ * @brief Read UTC every tick for @p ms, checking it never runs backwards and, if @p check, its error.
+ */
+static void SimMain_ClockSample(SimMain_ClockStats_T *stats, uint32_t ms, bool check)
+{
+    uint64_t end = SimHw_GetTimeNs() + (ms * SIMMAIN_NS_PER_MS);
+    uint64_t last = WallClock_Utc();
+
+    while (SimHw_GetTimeNs() < end)
+    {
+        vTaskDelay(1U);
+        uint64_t utc = WallClock_Utc();
+        int64_t error = (int64_t)(utc - SimMain_ClockReference(g_simMainClockJumpNs));
+        stats->backwards = stats->backwards || (utc < last);
+        last = utc;
+        if (check)
+        {
+            error = (error < 0) ? -error : error;
+            stats->worstNs = (error > stats->worstNs) ? error : stats->worstNs;
+            stats->sumNs += error;
+            stats->samples++;
+        }
+    }
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,160 @@
+/**
+ * @file SimMain_Crc.c
+ * @brief CRC bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --crc-bench: the CRC paths checked against each other and timed. Every
+ * check is printed with its verdict and failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "Crc.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_CRC_BYTES           (64U * 1024U) /**< Largest --crc-bench buffer */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainCrcData[SIMMAIN_CRC_BYTES + 8U] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainCrcDone = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static uint32_t SimMain_CrcDma(const Crc_Model_T *model, const uint8_t *data, uint32_t size, uint32_t *cycles);
+static void SimMain_CrcDone(void *ctx, bool success);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Check the CRC paths against the catalogue values and each other, then time them.
+ *
+ * The check string goes through the CRC unit and the software path; a
+ * 4099-byte buffer starting off a word boundary goes through all three
+ * paths, so the head and tail handling of the word feeds is covered. The
+ * unit and DMA rates are in virtual time, the software rate in host time.
+ */
+void SimMain_CrcBench(void)
+{
+    static const struct
+    {
+        const char *name;
+        Crc_Model_T model;
+        uint32_t check;
+    } check[] = {
+        {"crc-32", CRC_MODEL_CRC32, 0xCBF43926U},
+        {"crc-32c", CRC_MODEL_CRC32C, 0xE3069283U},
+        {"crc-16/ccitt-false", CRC_MODEL_CRC16_CCITT, 0x29B1U},
+        {"crc-16/arc", {16U, 0x8005U, 0x0000U, true, true, 0x0000U}, 0xBB3DU},
+        {"crc-12/umts", {12U, 0x80FU, 0x000U, false, true, 0x000U}, 0xDAFU},
+        {"crc-8/smbus", CRC_MODEL_CRC8, 0xF4U},
+        {"crc-7/mmc", {7U, 0x09U, 0x00U, false, false, 0x00U}, 0x75U},
+        {"crc-5/usb", {5U, 0x05U, 0x1FU, true, true, 0x1FU}, 0x19U},
+    };
+    static const uint32_t sizes[] = {64U, 256U, 1024U, 4096U, 16384U, SIMMAIN_CRC_BYTES};
+    static const char digits[] = "123456789";
+    uint32_t seed = 0x2468ACE1U;
+
+    for (uint32_t i = 0U; i < sizeof(g_simMainCrcData); i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainCrcData[i] = (uint8_t)(seed >> 24);
+    }
+
+    fprintf(stderr, "crc check         : model                 check      unit  software   4099 B three paths\n");
+    for (uint32_t i = 0U; i < (sizeof(check) / sizeof(check[0])); i++)
+    {
+        const Crc_Model_T *model = &check[i].model;
+        Crc_Ctx_T ctx;
+
+        uint32_t unit = Crc_Compute(model, digits, 9U);
+        Crc_Begin(&ctx, model);
+        Crc_UpdateSw(&ctx, digits, 9U);
+        uint32_t sw = Crc_Final(&ctx);
+
+        const uint8_t *data = &g_simMainCrcData[1];
+        Crc_Begin(&ctx, model);
+        Crc_UpdateSw(&ctx, data, 4099U);
+        uint32_t swLong = Crc_Final(&ctx);
+        bool same = (Crc_Compute(model, data, 4099U) == swLong) && (SimMain_CrcDma(model, data, 4099U, NULL) == swLong);
+
+        /* Streamed in uneven pieces alternating the paths */
+        Crc_Begin(&ctx, model);
+        Crc_Update(&ctx, data, 3U);
+        Crc_UpdateSw(&ctx, &data[3], 1000U);
+        Crc_Update(&ctx, &data[1003], 1500U);
+        Crc_UpdateSw(&ctx, &data[2503], 1596U);
+        same = same && (Crc_Final(&ctx) == swLong);
+
+        fprintf(stderr, "                    %-20s %8x  %8x  %8x   %s%s\n", check[i].name, check[i].check, unit, sw,
+                ((unit == check[i].check) && (sw == check[i].check) && same) ? "match" : SimMain_Fail("MISMATCH"),
+                Crc_IsHwCapable(model) ? "" : " (software only)");
+    }
+
+    const Crc_Model_T crc32 = CRC_MODEL_CRC32;
+    fprintf(stderr, "crc bench         :   size  unit MB/s  dma MB/s  dma cpu cyc  sw MB/s (host)  result\n");
+    for (uint32_t i = 0U; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        uint32_t size = sizes[i];
+        Crc_Ctx_T ctx;
+
+        uint32_t start = DWT->CYCCNT;
+        uint32_t unit = Crc_Compute(&crc32, g_simMainCrcData, size);
+        uint32_t unitCycles = DWT->CYCCNT - start;
+
+        uint32_t dmaCpu = 0U;
+        start = DWT->CYCCNT;
+        uint32_t dma = SimMain_CrcDma(&crc32, g_simMainCrcData, size, &dmaCpu);
+        uint32_t dmaCycles = DWT->CYCCNT - start;
+
+        double wallStart = SimMain_WallTime();
+        Crc_Begin(&ctx, &crc32);
+        Crc_UpdateSw(&ctx, g_simMainCrcData, size);
+        uint32_t sw = Crc_Final(&ctx);
+        double wallSeconds = SimMain_WallTime() - wallStart;
+
+        fprintf(stderr, "                    %6u  %9.1f  %8.1f  %11u  %14.1f  %s\n", size,
+                (unitCycles != 0U) ? ((double)size * (double)SystemCoreClock / (double)unitCycles / 1e6) : 0.0,
+                (dmaCycles != 0U) ? ((double)size * (double)SystemCoreClock / (double)dmaCycles / 1e6) : 0.0, dmaCpu,
+                (wallSeconds > 0.0) ? ((double)size / wallSeconds / 1e6) : 0.0,
+                ((unit == sw) && (dma == sw)) ? "match" : SimMain_Fail("MISMATCH"));
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief One-shot calculation through ::Crc_UpdateAsync, waiting for the callback.
+ *
+ * @param[out] cycles CPU cycles spent in the submission, may be NULL.
+ */
+static uint32_t SimMain_CrcDma(const Crc_Model_T *model, const uint8_t *data, uint32_t size, uint32_t *cycles)
+{
+    Crc_Ctx_T ctx;
+
+    Crc_Begin(&ctx, model);
+    g_simMainCrcDone = 0U;
+    uint32_t start = DWT->CYCCNT;
+    bool ok = Crc_UpdateAsync(&ctx, data, size, SimMain_CrcDone, NULL);
+    if (cycles != NULL)
+    {
+        *cycles = DWT->CYCCNT - start;
+    }
+    while (ok && (g_simMainCrcDone == 0U))
+    {
+        __WFI();
+    }
+    return (ok && (g_simMainCrcDone == 1U)) ? Crc_Final(&ctx) : 0U;
+}
+
+/**
+ * @brief Completion callback of the --crc-bench DMA updates.
+ */
+static void SimMain_CrcDone(void *ctx, bool success)
+{
+    (void)ctx;
+    g_simMainCrcDone = success ? 1U : 2U;
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,210 @@
+/**
+ * @file SimMain_Dma.c
+ * @brief DMA bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --dmapool-bench, --dmamem-bench and --dma2d-check: DMA pool submits, the
+ * DmaMem crossover and DMA2D jobs against the CPU reference. Every check is
+ * printed with its verdict and failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "UartDma.h"
+#include "DmaPool.h"
+#include "DmaMem.h"
+#include "Dma2d.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_POOL_TIMEOUT_MS     (100U) /**< --dmapool-bench limit of one transfer */
+#define SIMMAIN_IMG_W               (128U) /**< Pitch of the --dma2d-check images */
+#define SIMMAIN_IMG_H               (96U)  /**< Lines of the --dma2d-check images */
+#define SIMMAIN_IMG_BYTES           (SIMMAIN_IMG_W * SIMMAIN_IMG_H * 4U)
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainImgFg[SIMMAIN_IMG_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainImgBg[SIMMAIN_IMG_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainPoolCached[DMAPOOL_BLOCK_SIZE] __attribute__((aligned(DMAPOOL_CACHE_LINE_SIZE)));
+static uint8_t g_simMainImgDma[SIMMAIN_IMG_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainImgRef[SIMMAIN_IMG_BYTES] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainDma2dDone = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_Dma2dDone(void *ctx, bool success);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Send the same bytes from cached memory and from a DMA pool block.
+ *
+ * UartDma cleans a cached buffer from the data cache before the DMA reads
+ * it and skips the clean for pool blocks, so the difference between the two
+ * submit costs is the cache maintenance the pool saves per transfer. The
+ * control task runs above the logger, so the status read right after a
+ * transfer still holds the submit of that transfer.
+ */
+void SimMain_DmaPoolBench(void)
+{
+    static const uint16_t sizes[] = {32U, 96U, 160U, DMAPOOL_BLOCK_SIZE};
+    static const char text[] = "dmapool bench ";
+    uint8_t *block = (uint8_t *)DmaPool_Alloc();
+
+    if (block == NULL)
+    {
+        fprintf(stderr, "dmapool bench     : pool empty, %s\n", SimMain_Fail("ERROR"));
+        return;
+    }
+
+    for (uint32_t i = 0U; i < DMAPOOL_BLOCK_SIZE; i++)
+    {
+        g_simMainPoolCached[i] = (uint8_t)text[i % (sizeof(text) - 1U)];
+    }
+    g_simMainPoolCached[DMAPOOL_BLOCK_SIZE - 1U] = '\n';
+    bool placed = DmaPool_IsNonCacheable(block, DMAPOOL_BLOCK_SIZE) &&
+                  !DmaPool_IsNonCacheable(g_simMainPoolCached, DMAPOOL_BLOCK_SIZE);
+
+    fprintf(stderr, "dmapool bench     : bytes  cached cycles  pool cycles  saved\n");
+    for (uint32_t i = 0U; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        uint16_t size = sizes[i];
+        UartDma_Status_T status;
+
+        g_simMainPoolCached[size - 1U] = '\n';
+        memcpy(block, g_simMainPoolCached, size);
+
+        bool ok = UartDma_TransmitWait(g_simMainPoolCached, size, pdMS_TO_TICKS(SIMMAIN_POOL_TIMEOUT_MS));
+        UartDma_GetStatus(&status);
+        uint32_t cached = status.submit_cycles_cached;
+
+        ok = UartDma_TransmitWait(block, size, pdMS_TO_TICKS(SIMMAIN_POOL_TIMEOUT_MS)) && ok;
+        UartDma_GetStatus(&status);
+        uint32_t pool = status.submit_cycles_noncached;
+
+        g_simMainPoolCached[size - 1U] = (uint8_t)text[(size - 1U) % (sizeof(text) - 1U)];
+        ok = ok && placed && (pool < cached);
+        fprintf(stderr, "                    %5u  %13u  %11u  %5u  %s\n", size, cached, pool,
+                (pool < cached) ? (cached - pool) : 0U, ok ? "ok" : SimMain_Fail("ERROR"));
+    }
+
+    DmaPool_Free(block);
+}
+
+/**
+ * @brief Calibrate the DmaMem crossover and print the measured costs.
+ */
+void SimMain_DmaMemBench(void)
+{
+    static DmaMem_Bench_T bench;
+
+    if (!DmaMem_Calibrate(&bench))
+    {
+        fprintf(stderr, "DmaMem_Calibrate %s\n", SimMain_Fail("failed"));
+        return;
+    }
+
+    fprintf(stderr, "dmamem bench      :   size   cpu cyc   dma cyc   dma latency\n");
+    for (uint32_t i = 0U; i < DMAMEM_BENCH_POINTS; i++)
+    {
+        fprintf(stderr, "                    %6u  %8u  %8u  %8u\n", bench.point[i].size, bench.point[i].cpu_cycles,
+                bench.point[i].dma_cycles, bench.point[i].dma_latency);
+    }
+    fprintf(stderr, "dmamem threshold  : %u bytes\n", bench.threshold);
+}
+
+/**
+ * @brief Run crops, conversions, blends and fills on the DMA2D and the CPU.
+ *
+ * Each job writes into a 128x96 image prefilled with a marker, so pixels
+ * outside the target area are checked too. The DMA2D rate is in virtual
+ * time, the reference rate in host time.
+ */
+void SimMain_Dma2dCheck(void)
+{
+    static const struct
+    {
+        const char *name;
+        Dma2d_Job_T job;
+    } check[] = {
+        {"copy crop rgb565",
+         {.op = DMA2D_OP_COPY, .width = 100U, .height = 80U,
+          .fg = {&g_simMainImgFg[((7U * SIMMAIN_IMG_W) + 9U) * 2U], SIMMAIN_IMG_W, DMA2D_FMT_RGB565},
+          .out = {&g_simMainImgDma[0], SIMMAIN_IMG_W, DMA2D_FMT_RGB565}}},
+        {"rgb565 > bgr888 pad",
+         {.op = DMA2D_OP_CONVERT, .width = 96U, .height = 72U,
+          .fg = {g_simMainImgFg, 112U, DMA2D_FMT_RGB565},
+          .out = {&g_simMainImgDma[((12U * SIMMAIN_IMG_W) + 16U) * 3U], SIMMAIN_IMG_W, DMA2D_FMT_RGB888, true}}},
+        {"argb1555 > argb8888",
+         {.op = DMA2D_OP_CONVERT, .width = 64U, .height = 64U,
+          .fg = {g_simMainImgFg, SIMMAIN_IMG_W, DMA2D_FMT_ARGB1555, DMA2D_ALPHA_MULTIPLY, 0x80U},
+          .out = {g_simMainImgDma, SIMMAIN_IMG_W, DMA2D_FMT_ARGB8888}}},
+        {"blend 4444 over 888",
+         {.op = DMA2D_OP_BLEND, .width = 120U, .height = 90U,
+          .fg = {g_simMainImgFg, SIMMAIN_IMG_W, DMA2D_FMT_ARGB4444, DMA2D_ALPHA_MULTIPLY, 200U},
+          .bg = {g_simMainImgBg, SIMMAIN_IMG_W, DMA2D_FMT_RGB888, DMA2D_ALPHA_REPLACE, 0xC0U, true},
+          .out = {g_simMainImgDma, SIMMAIN_IMG_W, DMA2D_FMT_ARGB8888}}},
+        {"fill rgb565",
+         {.op = DMA2D_OP_FILL, .width = 50U, .height = 40U,
+          .out = {&g_simMainImgDma[((20U * SIMMAIN_IMG_W) + 30U) * 2U], SIMMAIN_IMG_W, DMA2D_FMT_RGB565},
+          .color = 0xFF3366CCU}},
+        {"fill bgr888",
+         {.op = DMA2D_OP_FILL, .width = 128U, .height = 96U,
+          .out = {g_simMainImgDma, SIMMAIN_IMG_W, DMA2D_FMT_RGB888, true}, .color = 0x80123456U}},
+    };
+    uint32_t seed = 0x12345678U;
+
+    for (uint32_t i = 0U; i < SIMMAIN_IMG_BYTES; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainImgFg[i] = (uint8_t)(seed >> 24);
+        g_simMainImgBg[i] = (uint8_t)(seed >> 16);
+    }
+
+    fprintf(stderr, "dma2d check       : job                    pixels  dma2d Mpix/s  ref Mpix/s (host)  result\n");
+    for (uint32_t i = 0U; i < (sizeof(check) / sizeof(check[0])); i++)
+    {
+        Dma2d_Job_T job = check[i].job;
+        job.cb = SimMain_Dma2dDone;
+        memset(g_simMainImgDma, 0x5A, SIMMAIN_IMG_BYTES);
+        memset(g_simMainImgRef, 0x5A, SIMMAIN_IMG_BYTES);
+
+        g_simMainDma2dDone = 0U;
+        uint32_t start = DWT->CYCCNT;
+        bool ok = Dma2d_Submit(&job);
+        while (ok && (g_simMainDma2dDone == 0U))
+        {
+            __WFI();
+        }
+        uint32_t cycles = DWT->CYCCNT - start;
+        ok = ok && (g_simMainDma2dDone == 1U);
+
+        /* Same job with the output moved to the reference image */
+        job.out.addr = g_simMainImgRef + ((uint8_t *)check[i].job.out.addr - g_simMainImgDma);
+        double wallStart = SimMain_WallTime();
+        ok = Dma2d_RunReference(&job) && ok;
+        double wallSeconds = SimMain_WallTime() - wallStart;
+
+        double pixels = (double)job.width * (double)job.height;
+        fprintf(stderr, "                    %-20s %7.0f  %12.1f  %17.1f  %s\n", check[i].name, pixels,
+                (cycles != 0U) ? (pixels * (double)SystemCoreClock / (double)cycles / 1e6) : 0.0,
+                (wallSeconds > 0.0) ? (pixels / wallSeconds / 1e6) : 0.0,
+                !ok ? SimMain_Fail("failed") : ((memcmp(g_simMainImgDma, g_simMainImgRef, SIMMAIN_IMG_BYTES) == 0) ? "match" : SimMain_Fail("MISMATCH")));
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Completion callback of the --dma2d-check jobs.
+ */
+static void SimMain_Dma2dDone(void *ctx, bool success)
+{
+    (void)ctx;
+    g_simMainDma2dDone = success ? 1U : 2U;
+}
+
+/** @} */ // end of SimMain group
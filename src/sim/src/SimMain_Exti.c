@@ -0,0 +1,266 @@
+/**
+ * @file SimMain_Exti.c
+ * @brief EXTI bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --exti-bench: pulses, a burst and bouncing contacts on EXTI lines against
+ * the reported edges. Every check is printed with its verdict and failures go
+ * through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ExtiEvt.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_EXTI_PORT           GPIOF         /**< --exti-bench port */
+#define SIMMAIN_EXTI_BUTTON_PIN     (3U)          /**< --exti-bench line taking both edges behind a debounce window */
+#define SIMMAIN_EXTI_PULSE_PIN      (5U)          /**< --exti-bench line taking rising edges only */
+#define SIMMAIN_EXTI_BURST_PIN      (7U)          /**< --exti-bench line taking both edges, no debounce */
+#define SIMMAIN_EXTI_DEBOUNCE_US    (2000U)       /**< --exti-bench debounce window of the button */
+#define SIMMAIN_EXTI_PULSES         (100U)        /**< --exti-bench pulses on the rising-edge line */
+#define SIMMAIN_EXTI_BURST          (32U)         /**< --exti-bench edges of the burst */
+#define SIMMAIN_EXTI_EVENTS         (256U)        /**< --exti-bench edges expected or reported per phase */
+#define SIMMAIN_EXTI_WRAP_MS        (10U)         /**< --exti-bench cycle counter wrap, after the start */
+#define SIMMAIN_EXTI_MAX_ERROR_NS   (5000U)       /**< --exti-bench worst accepted edge to stamp delay */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief --exti-bench edge expected from the service.
+ */
+typedef struct
+{
+    uint64_t ns;  /**< Virtual time of the edge */
+    uint8_t line; /**< Line */
+    bool rising;  /**< Low to high */
+    bool settled; /**< Reported at the end of a debounce window */
+} SimMain_ExtiExpect_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static SimMain_ExtiExpect_T g_simMainExtiExpect[SIMMAIN_EXTI_EVENTS];
+static uint32_t g_simMainExtiExpected = 0U;
+static ExtiEvt_Event_T g_simMainExtiSeen[SIMMAIN_EXTI_EVENTS];
+static volatile uint32_t g_simMainExtiCount = 0U;
+static uint64_t g_simMainExtiBase = 0U;
+static uint64_t g_simMainExtiBaseNs = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_ExtiDrive(uint8_t pin, bool level, uint64_t ns, bool reported);
+static bool SimMain_ExtiCheck(const char *name, uint64_t endNs);
+static void SimMain_ExtiRecord(void *ctx, const ExtiEvt_Event_T *event);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Drive EXTI lines from outside and check every edge the service reports.
+ *
+ * The cycle counter is first moved close to its wrap so the edges of the
+ * pulse phase straddle it. Then, on one port:
+ *  - pulses on a rising-edge line, each reported once at its rising edge,
+ *  - a burst on a line without debounce while the scheduler is held, as
+ *    by a busy CPU: every edge is stamped by its handler and one wake-up
+ *    delivers them all,
+ *  - a bouncing button on a debounced line taking both edges: a press
+ *    and a release whose bounces are dropped, a glitch whose level is
+ *    reported again at the end of the window, and a clean press.
+ * Reported times must trail the driven edges by no more than the
+ * interrupt entry.
+ */
+void SimMain_ExtiBench(void)
+{
+    const ExtiEvt_Config_T lines[] = {
+        {SIMMAIN_EXTI_PORT, SIMMAIN_EXTI_BUTTON_PIN, EXTIEVT_BOTH, LL_GPIO_PULL_DOWN, SIMMAIN_EXTI_DEBOUNCE_US,
+         SimMain_ExtiRecord, NULL},
+        {SIMMAIN_EXTI_PORT, SIMMAIN_EXTI_PULSE_PIN, EXTIEVT_RISING, LL_GPIO_PULL_NO, 0U, SimMain_ExtiRecord, NULL},
+        {SIMMAIN_EXTI_PORT, SIMMAIN_EXTI_BURST_PIN, EXTIEVT_BOTH, LL_GPIO_PULL_NO, 0U, SimMain_ExtiRecord, NULL},
+    };
+    const ExtiEvt_Config_T taken = {GPIOG, SIMMAIN_EXTI_PULSE_PIN, EXTIEVT_RISING, LL_GPIO_PULL_NO, 0U,
+                                    SimMain_ExtiRecord, NULL};
+    const ExtiEvt_Config_T badPin = {SIMMAIN_EXTI_PORT, 16U, EXTIEVT_RISING, LL_GPIO_PULL_NO, 0U,
+                                     SimMain_ExtiRecord, NULL};
+    ExtiEvt_Status_T before;
+    ExtiEvt_Status_T after;
+
+    uint64_t now = SimHw_GetTimeNs();
+    bool registered = true;
+    for (uint32_t i = 0U; i < (sizeof(lines) / sizeof(lines[0])); i++)
+    {
+        (void)SimHw_GpioDrive(SIMMAIN_EXTI_PORT, lines[i].pin, false, now);
+        registered = registered && ExtiEvt_Register(&lines[i]);
+    }
+    bool rejected = !ExtiEvt_Register(&taken) && !ExtiEvt_Register(&badPin) && !ExtiEvt_Register(NULL);
+
+    /* Start the cycle counter close to its wrap; the time base absorbs the jump */
+    DWT->CYCCNT = 0U - (uint32_t)(((uint64_t)SystemCoreClock * SIMMAIN_EXTI_WRAP_MS) / 1000U);
+    uint64_t now64 = ExtiEvt_Now();
+    uint32_t counter = DWT->CYCCNT;
+    g_simMainExtiBaseNs = SimHw_GetTimeNs();
+    g_simMainExtiBase = now64 + (uint32_t)(counter - (uint32_t)now64);
+
+    /* Pulses, one rising edge reported each, across the counter wrap */
+    uint64_t t0 = SimHw_GetTimeNs() + SIMMAIN_NS_PER_MS;
+    for (uint32_t k = 0U; k < SIMMAIN_EXTI_PULSES; k++)
+    {
+        uint64_t rise = t0 + (k * 200000ULL);
+        SimMain_ExtiDrive(SIMMAIN_EXTI_PULSE_PIN, true, rise, true);
+        SimMain_ExtiDrive(SIMMAIN_EXTI_PULSE_PIN, false, rise + 50000U, false);
+    }
+    ExtiEvt_GetStatus(&before);
+    bool ok = SimMain_ExtiCheck("exti pulses      ", t0 + (SIMMAIN_EXTI_PULSES * 200000ULL) + SIMMAIN_NS_PER_MS);
+    ExtiEvt_GetStatus(&after);
+    bool wrapped = (DWT->CYCCNT < counter);
+    ok = ok && wrapped;
+    fprintf(stderr, "exti wrap        : %u wake-ups for %u edges, cycle counter wrap %s\n",
+            after.wakeups - before.wakeups, after.events - before.events, wrapped ? "crossed" : SimMain_Fail("ERROR not crossed"));
+
+    /* Burst while the scheduler is held: one wake-up for all of it */
+    t0 = SimHw_GetTimeNs() + 100000U;
+    for (uint32_t k = 0U; k < SIMMAIN_EXTI_BURST; k++)
+    {
+        SimMain_ExtiDrive(SIMMAIN_EXTI_BURST_PIN, (k % 2U) == 0U, t0 + (k * 2000ULL), true);
+    }
+    ExtiEvt_GetStatus(&before);
+    vTaskSuspendAll();
+    while (SimHw_GetTimeNs() < (t0 + (SIMMAIN_EXTI_BURST * 2000ULL) + 10000U))
+    {
+        SimHw_Advance(100U);
+    }
+    (void)xTaskResumeAll();
+    bool burstOk = SimMain_ExtiCheck("exti burst       ", SimHw_GetTimeNs() + SIMMAIN_NS_PER_MS);
+    ExtiEvt_GetStatus(&after);
+    uint32_t burstWakeups = after.wakeups - before.wakeups;
+    burstOk = burstOk && (burstWakeups == 1U) && (after.ring_peak >= SIMMAIN_EXTI_BURST);
+    fprintf(stderr, "exti coalescing  : %u wake-ups for %u edges, ring peak %u, %s\n", burstWakeups,
+            after.events - before.events, after.ring_peak, burstOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && burstOk;
+
+    /* Button: bouncing press and release, a glitch, then a clean press */
+    static const uint32_t pressUs[] = {0U, 40U, 90U, 170U, 300U};
+    static const uint32_t releaseUs[] = {0U, 60U, 150U};
+    t0 = SimHw_GetTimeNs() + SIMMAIN_NS_PER_MS;
+    for (uint32_t k = 0U; k < (sizeof(pressUs) / sizeof(pressUs[0])); k++)
+    {
+        SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, (k % 2U) == 0U, t0 + (pressUs[k] * 1000ULL), k == 0U);
+    }
+    uint64_t t1 = t0 + (10U * SIMMAIN_NS_PER_MS);
+    for (uint32_t k = 0U; k < (sizeof(releaseUs) / sizeof(releaseUs[0])); k++)
+    {
+        SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, (k % 2U) != 0U, t1 + (releaseUs[k] * 1000ULL), k == 0U);
+    }
+    uint64_t t2 = t0 + (20U * SIMMAIN_NS_PER_MS);
+    SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, true, t2, true);
+    SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, false, t2 + 80000U, false);
+    g_simMainExtiExpect[g_simMainExtiExpected++] = (SimMain_ExtiExpect_T){t2 + 80000U, SIMMAIN_EXTI_BUTTON_PIN,
+                                                                          false, true};
+    uint64_t t3 = t0 + (30U * SIMMAIN_NS_PER_MS);
+    SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, true, t3, true);
+    SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, false, t3 + (10U * SIMMAIN_NS_PER_MS), true);
+    ExtiEvt_GetStatus(&before);
+    bool buttonOk = SimMain_ExtiCheck("exti button      ", t3 + (15U * SIMMAIN_NS_PER_MS));
+    ExtiEvt_GetStatus(&after);
+    uint32_t bounces = after.bounces - before.bounces;
+    uint32_t settled = after.settled - before.settled;
+    buttonOk = buttonOk && (bounces == 7U) && (settled == 1U);
+    fprintf(stderr, "exti debounce    : %u bounces dropped, %u settled level, %s\n", bounces, settled,
+            buttonOk ? "ok" : SimMain_Fail("ERROR"));
+    ok = ok && buttonOk;
+
+    /* Freed lines report nothing */
+    for (uint32_t i = 0U; i < (sizeof(lines) / sizeof(lines[0])); i++)
+    {
+        ExtiEvt_Unregister(lines[i].pin);
+    }
+    t0 = SimHw_GetTimeNs() + 100000U;
+    SimMain_ExtiDrive(SIMMAIN_EXTI_PULSE_PIN, true, t0, false);
+    SimMain_ExtiDrive(SIMMAIN_EXTI_BUTTON_PIN, true, t0, false);
+    bool quiet = SimMain_ExtiCheck("exti unregistered", t0 + SIMMAIN_NS_PER_MS);
+
+    ExtiEvt_GetStatus(&after);
+    ok = ok && registered && rejected && quiet && (after.overflows == 0U) && (after.lines == 0U);
+    fprintf(stderr, "exti bench       : %s, %s, %s\n", registered ? "3 lines registered" : SimMain_Fail("ERROR registration"),
+            rejected ? "invalid and taken lines rejected" : SimMain_Fail("ERROR accepted an invalid line"), ok ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Schedule a level on a --exti-bench pin, and the edge the service should report for it.
+ */
+static void SimMain_ExtiDrive(uint8_t pin, bool level, uint64_t ns, bool reported)
+{
+    (void)SimHw_GpioDrive(SIMMAIN_EXTI_PORT, pin, level, ns);
+    if (reported && (g_simMainExtiExpected < SIMMAIN_EXTI_EVENTS))
+    {
+        g_simMainExtiExpect[g_simMainExtiExpected++] = (SimMain_ExtiExpect_T){ns, pin, level, false};
+    }
+}
+
+/**
+ * @brief Wait until @p endNs, then compare the reported edges with the expected ones and start a new phase.
+ *
+ * The stamp of an edge is its handler entry: it must follow the driven
+ * edge by less than ::SIMMAIN_EXTI_MAX_ERROR_NS. A settled level carries
+ * the time of the edge that set it, which went through the handler too.
+ *
+ * @retval true  Every edge was reported once, in order, on time.
+ * @retval false An edge was missing, extra, of the wrong kind or late.
+ */
+static bool SimMain_ExtiCheck(const char *name, uint64_t endNs)
+{
+    uint64_t now = SimHw_GetTimeNs();
+    if (endNs > now)
+    {
+        vTaskDelay(pdMS_TO_TICKS((uint32_t)(((endNs - now) + SIMMAIN_NS_PER_MS - 1U) / SIMMAIN_NS_PER_MS)));
+    }
+
+    uint32_t count = g_simMainExtiCount;
+    uint32_t matched = 0U;
+    double worstNs = 0.0;
+    double sumNs = 0.0;
+    bool early = false;
+    for (; (matched < count) && (matched < g_simMainExtiExpected); matched++)
+    {
+        const SimMain_ExtiExpect_T *want = &g_simMainExtiExpect[matched];
+        const ExtiEvt_Event_T *seen = &g_simMainExtiSeen[matched];
+        if ((seen->line != want->line) || (seen->rising != want->rising) || (seen->settled != want->settled))
+        {
+            break;
+        }
+        double expected = (double)g_simMainExtiBase +
+                          ((double)(want->ns - g_simMainExtiBaseNs) * (double)SystemCoreClock / 1e9);
+        double errorNs = ((double)seen->cycles - expected) * 1e9 / (double)SystemCoreClock;
+        /* Both ends are whole cycles rounded down from virtual time */
+        early = early || (errorNs < (-2e9 / (double)SystemCoreClock));
+        worstNs = (errorNs > worstNs) ? errorNs : worstNs;
+        sumNs += errorNs;
+    }
+    bool ok = (matched == count) && (count == g_simMainExtiExpected) && !early &&
+              (worstNs <= (double)SIMMAIN_EXTI_MAX_ERROR_NS);
+    fprintf(stderr, "%s: %u edges reported of %u expected, %u matched, stamp delay avg %.0f ns, worst %.0f ns, %s\n",
+            name, count, g_simMainExtiExpected, matched, (matched != 0U) ? (sumNs / (double)matched) : 0.0, worstNs,
+            ok ? "ok" : SimMain_Fail("ERROR"));
+
+    g_simMainExtiExpected = 0U;
+    g_simMainExtiCount = 0U;
+    return ok;
+}
+
+/**
+ * @brief Edge callback of the --exti-bench lines.
+ */
+static void SimMain_ExtiRecord(void *ctx, const ExtiEvt_Event_T *event)
+{
+    (void)ctx;
+    if (g_simMainExtiCount < SIMMAIN_EXTI_EVENTS)
+    {
+        g_simMainExtiSeen[g_simMainExtiCount] = *event;
+    }
+    g_simMainExtiCount++;
+}
+
+/** @} */ // end of SimMain group
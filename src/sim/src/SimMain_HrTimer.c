@@ -0,0 +1,148 @@
+/**
+ * @file SimMain_HrTimer.c
+ * @brief HrTimer bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --hrtimer-bench: bursts of microsecond timers, stops and a periodic timer,
+ * with their lateness. Every check is printed with its verdict and failures
+ * go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "HrTimer.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_HR_TIMERS           (250U)        /**< --hrtimer-bench one-shot timers in a burst */
+#define SIMMAIN_HR_SPREAD_US        (20000U)      /**< --hrtimer-bench burst deadlines spread */
+#define SIMMAIN_HR_PERIOD_US        (250U)        /**< --hrtimer-bench periodic timer */
+#define SIMMAIN_HR_PERIODIC_MS      (50U)         /**< --hrtimer-bench periodic run time */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static HrTimer_T g_simMainHrTimers[SIMMAIN_HR_TIMERS];
+static volatile uint32_t g_simMainHrFired[SIMMAIN_HR_TIMERS];
+static volatile uint32_t g_simMainHrLastDeadline = 0U;
+static volatile uint32_t g_simMainHrDisorder = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_HrTimerFired(void *ctx);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Fire a burst of one-shot timers, stop half of a second one and run a periodic one.
+ *
+ * The burst checks every timer fires once and in deadline order; the
+ * periodic timer wakes this task, whose own wake-up delay is measured on
+ * top of the service's expiry lateness.
+ */
+void SimMain_HrTimerBench(void)
+{
+    uint32_t seed = 0x1234567U;
+    HrTimer_Status_T before;
+    HrTimer_GetStatus(&before);
+
+    /* Burst of one-shot timers at scattered deadlines */
+    g_simMainHrDisorder = 0U;
+    g_simMainHrLastDeadline = HrTimer_Now();
+    uint32_t rejected = 0U;
+    for (uint32_t i = 0U; i < SIMMAIN_HR_TIMERS; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainHrFired[i] = 0U;
+        HrTimer_Setup(&g_simMainHrTimers[i], SimMain_HrTimerFired, (void *)(uintptr_t)i, NULL, 0U);
+        rejected += HrTimer_Start(&g_simMainHrTimers[i], 50U + ((seed >> 8) % SIMMAIN_HR_SPREAD_US), 0U) ? 0U : 1U;
+    }
+    vTaskDelay(pdMS_TO_TICKS((SIMMAIN_HR_SPREAD_US / 1000U) + 2U));
+    uint32_t once = 0U;
+    for (uint32_t i = 0U; i < SIMMAIN_HR_TIMERS; i++)
+    {
+        once += (g_simMainHrFired[i] == 1U) ? 1U : 0U;
+    }
+    HrTimer_Status_T status;
+    HrTimer_GetStatus(&status);
+    fprintf(stderr, "hrtimer burst     : %u timers over %u ms, %u fired once, %u out of order, %u rejected, "
+                    "late max %u ns, %s\n",
+            SIMMAIN_HR_TIMERS, SIMMAIN_HR_SPREAD_US / 1000U, once, g_simMainHrDisorder, rejected,
+            status.late_max_ns,
+            ((once == SIMMAIN_HR_TIMERS) && (g_simMainHrDisorder == 0U) && (rejected == 0U)) ? "ok" : SimMain_Fail("ERROR"));
+
+    /* Stop every other timer of a second burst before it fires */
+    uint32_t stopped = 0U;
+    for (uint32_t i = 0U; i < 100U; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainHrFired[i] = 0U;
+        (void)HrTimer_Start(&g_simMainHrTimers[i], 1000U + ((seed >> 8) % 4000U), 0U);
+    }
+    for (uint32_t i = 0U; i < 100U; i += 2U)
+    {
+        stopped += HrTimer_Stop(&g_simMainHrTimers[i]) ? 1U : 0U;
+    }
+    vTaskDelay(pdMS_TO_TICKS(6U));
+    uint32_t firedStopped = 0U;
+    uint32_t firedKept = 0U;
+    for (uint32_t i = 0U; i < 100U; i++)
+    {
+        firedStopped += ((i % 2U) == 0U) ? g_simMainHrFired[i] : 0U;
+        firedKept += ((i % 2U) != 0U) ? g_simMainHrFired[i] : 0U;
+    }
+    fprintf(stderr, "hrtimer stop      : %u of 100 stopped, %u fired after stop, %u of 50 kept fired, %s\n", stopped,
+            firedStopped, firedKept, ((stopped == 50U) && (firedStopped == 0U) && (firedKept == 50U)) ? "ok" : SimMain_Fail("ERROR"));
+
+    /* Periodic timer waking this task */
+    HrTimer_T periodic;
+    uint32_t wakeups = 0U;
+    uint32_t wakeMaxNs = 0U;
+    uint64_t wakeSumNs = 0U;
+    HrTimer_Setup(&periodic, NULL, NULL, xTaskGetCurrentTaskHandle(), 0x1U);
+    xTaskNotifyStateClearIndexed(NULL, HRTIMER_NOTIFY_INDEX);
+    (void)HrTimer_Start(&periodic, SIMMAIN_HR_PERIOD_US, SIMMAIN_HR_PERIOD_US);
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(SIMMAIN_HR_PERIODIC_MS);
+    while ((int32_t)(end - xTaskGetTickCount()) > 0)
+    {
+        if (xTaskNotifyWaitIndexed(HRTIMER_NOTIFY_INDEX, 0U, 0x1U, NULL, pdMS_TO_TICKS(2U)) != pdTRUE)
+        {
+            break;
+        }
+        uint32_t late = HrTimer_Now() - (periodic.deadline - HRTIMER_US_TO_TICKS(SIMMAIN_HR_PERIOD_US));
+        uint32_t lateNs = (uint32_t)(((uint64_t)late * 1000000000ULL) / HRTIMER_TICK_HZ);
+        wakeMaxNs = (lateNs > wakeMaxNs) ? lateNs : wakeMaxNs;
+        wakeSumNs += lateNs;
+        wakeups++;
+    }
+    (void)HrTimer_Stop(&periodic);
+    xTaskNotifyStateClearIndexed(NULL, HRTIMER_NOTIFY_INDEX);
+    HrTimer_GetStatus(&status);
+    uint32_t expected = (SIMMAIN_HR_PERIODIC_MS * 1000U) / SIMMAIN_HR_PERIOD_US;
+    fprintf(stderr, "hrtimer periodic  : %u us, %u wakeups in %u ms (%u expected), task wake late avg %u / max %u ns, "
+                    "%u missed periods, %s\n",
+            SIMMAIN_HR_PERIOD_US, wakeups, SIMMAIN_HR_PERIODIC_MS, expected,
+            (wakeups != 0U) ? (uint32_t)(wakeSumNs / wakeups) : 0U, wakeMaxNs,
+            status.missed_periods - before.missed_periods,
+            ((wakeups + 2U >= expected) && (wakeups <= expected + 1U)) ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Burst timer expiry: count it and check deadlines come in order.
+ */
+static void SimMain_HrTimerFired(void *ctx)
+{
+    uint32_t index = (uint32_t)(uintptr_t)ctx;
+    uint32_t deadline = g_simMainHrTimers[index].deadline;
+
+    if ((int32_t)(deadline - g_simMainHrLastDeadline) < 0)
+    {
+        g_simMainHrDisorder++;
+    }
+    g_simMainHrLastDeadline = deadline;
+    g_simMainHrFired[index]++;
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,152 @@
+/**
+ * @file SimMain_I2c.c
+ * @brief I2C bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --i2c-bench: I2C1 transactions on the simulated targets and a sensor batch.
+ * Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "I2cDma.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_I2C_EEPROM          (0x50U)       /**< --i2c-bench register file target */
+#define SIMMAIN_I2C_SENSOR          (0x48U)       /**< --i2c-bench sensor target */
+#define SIMMAIN_I2C_BATCH_MS        (100U)        /**< --i2c-bench batch run time */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainI2cTx[257] __attribute__((aligned(32)));
+static uint8_t g_simMainI2cRx[320] __attribute__((aligned(32)));
+static uint8_t g_simMainI2cSample[4][16] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainI2cBatches = 0U;
+static volatile uint32_t g_simMainI2cBatchFailed = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_I2cBatchDone(void *ctx, uint32_t failed);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Check I2C1 transactions against the simulated targets.
+ *
+ * Probes three addresses, only two of which acknowledge, fills the
+ * register file at ::SIMMAIN_I2C_EEPROM in one 257-byte write and reads
+ * it back past the end, both over the 255-byte NBYTES limit. A batch of
+ * register reads then runs every 10 ms for ::SIMMAIN_I2C_BATCH_MS while
+ * this task keeps reading and writing the same targets, sharing the bus.
+ * Rates are in virtual time.
+ */
+void SimMain_I2cBench(void)
+{
+    static const uint8_t probes[] = {SIMMAIN_I2C_SENSOR, SIMMAIN_I2C_EEPROM, 0x51U};
+
+    fprintf(stderr, "i2c probe         :");
+    for (uint32_t i = 0U; i < sizeof(probes); i++)
+    {
+        const I2cDma_Msg_T probe = {NULL, 0U, 0U};
+        I2cDma_Result_T result = I2cDma_TransferWait(probes[i], &probe, 1U);
+        fprintf(stderr, " 0x%02X %s", probes[i],
+                (result == I2CDMA_OK) ? "ack" : ((result == I2CDMA_ERR_NACK) ? "nack" : SimMain_Fail("ERROR")));
+    }
+    fprintf(stderr, "\n");
+
+    /* Register pointer then the whole register file, wrapping back to 0 */
+    g_simMainI2cTx[0] = 0U;
+    for (uint32_t i = 0U; i < 256U; i++)
+    {
+        g_simMainI2cTx[i + 1U] = (uint8_t)((i * 7U) + 3U);
+    }
+    uint32_t start = DWT->CYCCNT;
+    I2cDma_Result_T wr = I2cDma_WriteRead(SIMMAIN_I2C_EEPROM, g_simMainI2cTx, sizeof(g_simMainI2cTx), NULL, 0U);
+    uint32_t wrCycles = DWT->CYCCNT - start;
+    const uint8_t reg = 0x80U;
+    start = DWT->CYCCNT;
+    I2cDma_Result_T rd = I2cDma_WriteRead(SIMMAIN_I2C_EEPROM, &reg, 1U, g_simMainI2cRx, sizeof(g_simMainI2cRx));
+    uint32_t rdCycles = DWT->CYCCNT - start;
+    bool same = (wr == I2CDMA_OK) && (rd == I2CDMA_OK);
+    for (uint32_t i = 0U; i < sizeof(g_simMainI2cRx); i++)
+    {
+        same = same && (g_simMainI2cRx[i] == g_simMainI2cTx[((reg + i) & 0xFFU) + 1U]);
+    }
+    I2cDma_Status_T status;
+    I2cDma_GetStatus(&status);
+    fprintf(stderr, "i2c transfer      : scl %u Hz, write %u B in %.1f us, read %u B in %.1f us, %s\n",
+            status.actual_hz, (uint32_t)sizeof(g_simMainI2cTx), (double)wrCycles * 1e6 / (double)SystemCoreClock,
+            (uint32_t)sizeof(g_simMainI2cRx), (double)rdCycles * 1e6 / (double)SystemCoreClock,
+            same ? "match" : SimMain_Fail("MISMATCH"));
+
+    static I2cDma_Batch_T batch;
+    static const I2cDma_BatchItem_T items[] = {
+        {SIMMAIN_I2C_SENSOR, 0x00U, g_simMainI2cSample[0], 4U},
+        {SIMMAIN_I2C_EEPROM, 0x10U, g_simMainI2cSample[1], 16U},
+        {SIMMAIN_I2C_SENSOR, 0x02U, g_simMainI2cSample[2], 2U},
+        {SIMMAIN_I2C_EEPROM, 0xF8U, g_simMainI2cSample[3], 8U},
+    };
+    batch.items = items;
+    batch.count = sizeof(items) / sizeof(items[0]);
+    batch.period_ms = 10U;
+    batch.cb = SimMain_I2cBatchDone;
+    batch.ctx = NULL;
+    g_simMainI2cBatches = 0U;
+    g_simMainI2cBatchFailed = 0U;
+    if (!I2cDma_BatchStart(&batch))
+    {
+        fprintf(stderr, "I2cDma_BatchStart %s\n", SimMain_Fail("failed"));
+        return;
+    }
+
+    /* Foreground traffic on the same bus while the batch runs */
+    uint32_t foreground = 0U;
+    uint32_t mismatches = 0U;
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(SIMMAIN_I2C_BATCH_MS);
+    while ((int32_t)(end - xTaskGetTickCount()) > 0)
+    {
+        uint8_t msg[5] = {(uint8_t)(0x40U + ((foreground * 4U) & 0x3FU))};
+        uint8_t back[4] = {0U};
+        memcpy(&msg[1], &foreground, sizeof(foreground));
+        bool ok = I2cDma_WriteRead(SIMMAIN_I2C_EEPROM, msg, sizeof(msg), NULL, 0U) == I2CDMA_OK;
+        ok = ok && (I2cDma_WriteRead(SIMMAIN_I2C_EEPROM, msg, 1U, back, sizeof(back)) == I2CDMA_OK);
+        mismatches += (ok && (memcmp(&msg[1], back, sizeof(back)) == 0)) ? 0U : 1U;
+        foreground++;
+        vTaskDelay(pdMS_TO_TICKS(1U));
+    }
+    I2cDma_BatchStop(&batch);
+    while (batch.pending != 0U)
+    {
+        __WFI();
+    }
+
+    bool eeprom = memcmp(g_simMainI2cSample[1], &g_simMainI2cTx[0x10U + 1U], 16U) == 0;
+    eeprom = eeprom && (memcmp(g_simMainI2cSample[3], &g_simMainI2cTx[0xF8U + 1U], 8U) == 0);
+    uint16_t samples = (uint16_t)((g_simMainI2cSample[0][0] << 8) | g_simMainI2cSample[0][1]);
+    fprintf(stderr, "i2c batch         : %u callbacks for %u reads, %u overruns, %u failed, sensor sample %u, "
+                    "eeprom %s, foreground %u transactions %u mismatches\n",
+            g_simMainI2cBatches, g_simMainI2cBatches * batch.count, batch.overruns, g_simMainI2cBatchFailed, samples,
+            eeprom ? "match" : SimMain_Fail("MISMATCH"), foreground, mismatches);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Batch callback of --i2c-bench.
+ */
+static void SimMain_I2cBatchDone(void *ctx, uint32_t failed)
+{
+    (void)ctx;
+    g_simMainI2cBatches++;
+    if (failed != 0U)
+    {
+        g_simMainI2cBatchFailed++;
+    }
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,164 @@
+/**
+ * @file SimMain_I3c.c
+ * @brief I3C bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --i3c-bench: I3C1 dynamic addresses, transfers and in-band interrupts.
+ * Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "I3cCtrl.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_I3C_IMU             (0U)          /**< --i3c-bench IMU, first in ENTDAA order */
+#define SIMMAIN_I3C_PRESSURE        (1U)          /**< --i3c-bench pressure sensor */
+#define SIMMAIN_I3C_FILE            (2U)          /**< --i3c-bench register file */
+#define SIMMAIN_I3C_IBI_MS          (50U)         /**< --i3c-bench in-band interrupt run time */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainI3cTx[201] __attribute__((aligned(32)));
+static uint8_t g_simMainI3cRx[200] __attribute__((aligned(32)));
+
+/* Private Function Prototypes ----------------------------------------------*/
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Check I3C1 addressing, transfers and in-band interrupts on the simulated targets.
+ *
+ * Assigns the dynamic addresses and checks GETPID against the ID read
+ * during ENTDAA, fills part of the register file and reads it back, reads
+ * past the end of the pressure sensor, which ends the read after 3 bytes,
+ * and addresses a dynamic address nobody has. The IMU and pressure
+ * interrupts are then taken for ::SIMMAIN_I3C_IBI_MS while this task keeps
+ * reading the IMU registers, and DISEC stops them. Rates are in virtual
+ * time.
+ */
+void SimMain_I3cBench(void)
+{
+    uint32_t found = 0U;
+    I3cCtrl_Target_T targets[3] = {0};
+    I3cCtrl_Result_T result = I3cCtrl_AssignAddresses(&found);
+
+    fprintf(stderr, "i3c daa           : %s, %u targets", (result == I3CCTRL_OK) ? "ok" : SimMain_Fail("ERROR"), found);
+    for (uint32_t i = 0U; i < 3U; i++)
+    {
+        if (I3cCtrl_GetTarget(i, &targets[i]))
+        {
+            fprintf(stderr, ", 0x%02X pid %012llX bcr 0x%02X dcr 0x%02X", targets[i].dyn_addr,
+                    (unsigned long long)targets[i].pid, targets[i].bcr, targets[i].dcr);
+        }
+    }
+    fprintf(stderr, "\n");
+    if (found < 3U)
+    {
+        return;
+    }
+    const uint8_t imu = targets[SIMMAIN_I3C_IMU].dyn_addr;
+    const uint8_t pressure = targets[SIMMAIN_I3C_PRESSURE].dyn_addr;
+    const uint8_t file = targets[SIMMAIN_I3C_FILE].dyn_addr;
+
+    uint8_t pid[6] = {0U};
+    uint16_t received = 0U;
+    const I3cCtrl_Xfer_T getpid = {
+        .addr = file,
+        .ccc = I3CCTRL_CCC_GETPID,
+        .rx = pid,
+        .rx_len = sizeof(pid),
+    };
+    result = I3cCtrl_TransferWait(&getpid, &received);
+    uint64_t readPid = 0U;
+    for (uint32_t i = 0U; i < sizeof(pid); i++)
+    {
+        readPid = (readPid << 8) | pid[i];
+    }
+    fprintf(stderr, "i3c getpid        : 0x%02X %u B, %s\n", file, received,
+            ((result == I3CCTRL_OK) && (readPid == targets[SIMMAIN_I3C_FILE].pid)) ? "match" : SimMain_Fail("MISMATCH"));
+
+    /* Register pointer then 200 registers */
+    g_simMainI3cTx[0] = 0x20U;
+    for (uint32_t i = 1U; i < sizeof(g_simMainI3cTx); i++)
+    {
+        g_simMainI3cTx[i] = (uint8_t)((i * 13U) + 5U);
+    }
+    uint32_t start = DWT->CYCCNT;
+    I3cCtrl_Result_T wr = I3cCtrl_WriteRead(file, g_simMainI3cTx, sizeof(g_simMainI3cTx), NULL, 0U);
+    uint32_t wrCycles = DWT->CYCCNT - start;
+    start = DWT->CYCCNT;
+    I3cCtrl_Result_T rd = I3cCtrl_WriteRead(file, g_simMainI3cTx, 1U, g_simMainI3cRx, sizeof(g_simMainI3cRx));
+    uint32_t rdCycles = DWT->CYCCNT - start;
+    bool same = (wr == I3CCTRL_OK) && (rd == I3CCTRL_OK) &&
+                (memcmp(g_simMainI3cRx, &g_simMainI3cTx[1], sizeof(g_simMainI3cRx)) == 0);
+    I3cCtrl_Status_T status;
+    I3cCtrl_GetStatus(&status);
+    fprintf(stderr, "i3c transfer      : scl %u Hz, write %u B in %.1f us, read %u B in %.1f us, %s\n",
+            status.actual_hz, (uint32_t)sizeof(g_simMainI3cTx), (double)wrCycles * 1e6 / (double)SystemCoreClock,
+            (uint32_t)sizeof(g_simMainI3cRx), (double)rdCycles * 1e6 / (double)SystemCoreClock,
+            same ? "match" : SimMain_Fail("MISMATCH"));
+
+    const uint8_t reg = 0U;
+    const I3cCtrl_Xfer_T longRead = {
+        .addr = pressure,
+        .ccc = I3CCTRL_NO_CCC,
+        .tx = &reg,
+        .tx_len = 1U,
+        .rx = g_simMainI3cRx,
+        .rx_len = 8U,
+    };
+    result = I3cCtrl_TransferWait(&longRead, &received);
+    I3cCtrl_Result_T nack = I3cCtrl_WriteRead(0x30U, &reg, 1U, NULL, 0U);
+    fprintf(stderr, "i3c short / nack  : 0x%02X read %u of 8 B (%s), 0x30 %s\n", pressure, received,
+            ((result == I3CCTRL_OK) && (received == 3U)) ? "ended by target" : SimMain_Fail("ERROR"),
+            (nack == I3CCTRL_ERR_NACK) ? "nack" : SimMain_Fail("ERROR"));
+
+    /* In-band interrupts while the foreground reads the IMU */
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint32_t wakeups[2] = {0U};
+    uint32_t reads = 0U;
+    uint32_t failed = 0U;
+    (void)I3cCtrl_IbiSubscribe(imu, self, 0x1U);
+    (void)I3cCtrl_IbiSubscribe(pressure, self, 0x2U);
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(SIMMAIN_I3C_IBI_MS);
+    while ((int32_t)(end - xTaskGetTickCount()) > 0)
+    {
+        uint32_t bits = 0U;
+        if (xTaskNotifyWaitIndexed(I3CCTRL_IBI_NOTIFY_INDEX, 0U, UINT32_MAX, &bits, pdMS_TO_TICKS(1U)) == pdTRUE)
+        {
+            wakeups[0] += ((bits & 0x1U) != 0U) ? 1U : 0U;
+            wakeups[1] += ((bits & 0x2U) != 0U) ? 1U : 0U;
+        }
+        uint8_t sample[4];
+        failed += (I3cCtrl_WriteRead(imu, &reg, 1U, sample, sizeof(sample)) == I3CCTRL_OK) ? 0U : 1U;
+        reads++;
+    }
+
+    static const uint8_t disint = I3CCTRL_EVENT_INT;
+    I3cCtrl_Ibi_T before;
+    I3cCtrl_Ibi_T after;
+    I3cCtrl_Ibi_T other;
+    result = I3cCtrl_Ccc(I3CCTRL_CCC_DISEC, I3CCTRL_BROADCAST, &disint, 1U);
+    (void)I3cCtrl_IbiRead(imu, &before);
+    vTaskDelay(pdMS_TO_TICKS(10U));
+    (void)I3cCtrl_IbiRead(imu, &after);
+    (void)I3cCtrl_IbiRead(pressure, &other);
+    (void)I3cCtrl_IbiSubscribe(imu, NULL, 0U);
+    (void)I3cCtrl_IbiSubscribe(pressure, NULL, 0U);
+    xTaskNotifyStateClearIndexed(self, I3CCTRL_IBI_NOTIFY_INDEX);
+    fprintf(stderr, "i3c ibi           : imu %u received, %u wakeups, payload %u B 0x%04X; pressure %u received, "
+                    "%u wakeups, payload %u B; disec %s, %u after; foreground %u reads %u failed\n",
+            before.count, wakeups[0], before.len, before.payload, other.count, wakeups[1], other.len,
+            (result == I3CCTRL_OK) ? "ok" : SimMain_Fail("ERROR"), after.count - before.count, reads, failed);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/** @} */ // end of SimMain group
@@ -0,0 +1,279 @@
+/**
+ * @file SimMain_LogStore.c
+ * @brief LogStore bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --logstore-bench: log store fill past a wrap, read back, remount and
+ * power-loss recovery. Every check is printed with its verdict and failures
+ * go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "LogStore.h"
+#include "stm32n6xx.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_LS_MAGIC            (0x3142534CUL) /**< "LSB1", first word of a --logstore-bench record */
+#define SIMMAIN_LS_RECORD           (200U)        /**< --logstore-bench record payload */
+#define SIMMAIN_LS_RECORDS          (360U)        /**< --logstore-bench records of the fill pass, past one wrap */
+#define SIMMAIN_LS_DURABLE          (8U)          /**< --logstore-bench records flushed before a power loss */
+#define SIMMAIN_LS_AFTER            (16U)         /**< --logstore-bench records appended after recovering */
+#define SIMMAIN_LS_EPOCHS           (5U)          /**< Fill pass, then a cut and a recovery for programs and erases */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief --logstore-bench records of one epoch found while reading the store back.
+ */
+typedef struct
+{
+    uint32_t count;      /**< Records found */
+    uint32_t first;      /**< Lowest sequence number */
+    uint32_t last;       /**< Highest sequence number */
+    bool ordered;        /**< Sequence numbers follow each other without a gap */
+    bool intact;         /**< Every payload matched its pattern */
+} SimMain_LsEpoch_T;
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainLsRecord[LOGSTORE_MAX_RECORD];
+static SimMain_LsEpoch_T g_simMainLsEpochs[SIMMAIN_LS_EPOCHS];
+static uint64_t g_simMainLsCycles = 0U;
+static uint32_t g_simMainLsCyclesMax = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static bool SimMain_LsAppend(uint32_t epoch, uint32_t seq);
+static bool SimMain_LsFill(uint32_t epoch, uint32_t count);
+static bool SimMain_LsCut(uint32_t epoch, uint32_t ops, bool erasesOnly);
+static uint32_t SimMain_LsScan(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Fill the log store past a wrap, read it back, remount it and recover from power losses.
+ *
+ * Bench records carry an epoch and a sequence number so they can be told
+ * apart from the logger output stored alongside them. Every read-back
+ * must find each epoch as one run of consecutive records with intact
+ * payloads: a power loss may only lose the newest records of its epoch.
+ */
+void SimMain_LogStoreBench(void)
+{
+    LogStore_Status_T before;
+    LogStore_Status_T after;
+
+    for (uint32_t i = 0U; i < 1000U; i++)
+    {
+        LogStore_GetStatus(&before);
+        if (before.mounted)
+        {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(1U));
+    }
+    if (!before.mounted)
+    {
+        fprintf(stderr, "logstore mount    : not mounted, %u flash errors, %s\n", before.flash_errors,
+                SimMain_Fail("ERROR"));
+        return;
+    }
+    fprintf(stderr, "logstore mount    : id 0x%06x, %u sectors, %u used, head seq %u, %u us, ok\n", before.jedec_id,
+            before.sectors, before.sectors_used, before.head_seq, before.mount_us);
+
+    /* Fill: producer cost per record and the rate the store task sustains */
+    g_simMainLsCycles = 0U;
+    g_simMainLsCyclesMax = 0U;
+    uint32_t start = DWT->CYCCNT;
+    bool ok = SimMain_LsFill(0U, SIMMAIN_LS_RECORDS) && LogStore_Flush();
+    uint32_t cycles = DWT->CYCCNT - start;
+    LogStore_GetStatus(&after);
+    double usPerCycle = 1e6 / (double)SystemCoreClock;
+    double kib = (double)(after.bytes - before.bytes) / 1024.0;
+    ok = ok && (after.dropped == before.dropped);
+    fprintf(stderr, "logstore append   : %u records of %u B, append avg %.2f / max %.2f us, %.1f KiB to flash "
+                    "at %.1f KiB/s, %u pages, %u erases, %u reclaimed, stage peak %u, %s\n",
+            SIMMAIN_LS_RECORDS, SIMMAIN_LS_RECORD, (double)g_simMainLsCycles * usPerCycle / SIMMAIN_LS_RECORDS,
+            (double)g_simMainLsCyclesMax * usPerCycle, kib,
+            (cycles != 0U) ? (kib * 1e6 / ((double)cycles * usPerCycle)) : 0.0, after.pages - before.pages,
+            after.erases - before.erases, after.reclaimed - before.reclaimed, after.stage_peak, ok ? "ok" : SimMain_Fail("ERROR"));
+
+    /* Read back, then again after a remount */
+    const SimMain_LsEpoch_T *fill = &g_simMainLsEpochs[0];
+    for (uint32_t pass = 0U; pass < 2U; pass++)
+    {
+        bool mounted = (pass == 0U) || LogStore_Mount();
+        start = DWT->CYCCNT;
+        uint32_t records = SimMain_LsScan();
+        cycles = DWT->CYCCNT - start;
+        LogStore_GetStatus(&after);
+        ok = mounted && (fill->count != 0U) && fill->ordered && fill->intact &&
+             (fill->last == (SIMMAIN_LS_RECORDS - 1U)) && ((after.reclaimed == 0U) || (fill->first != 0U));
+        fprintf(stderr, "logstore %-9s: %u records, %u of the bench (seq %u..%u), %u sectors used, read %.1f ms, "
+                        "mount %u us, %s\n",
+                (pass == 0U) ? "read" : "remount", records, fill->count, fill->first, fill->last, after.sectors_used,
+                (double)cycles * usPerCycle / 1000.0, after.mount_us, ok ? "ok" : SimMain_Fail("ERROR"));
+    }
+
+    /* Power lost during a page program, then during the erase opening a sector */
+    (void)SimMain_LsCut(1U, 3U, false);
+    (void)SimMain_LsCut(3U, 1U, true);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Append one bench record, timing the call.
+ *
+ * @retval true  Staged.
+ * @retval false Staging buffer full or store offline.
+ */
+static bool SimMain_LsAppend(uint32_t epoch, uint32_t seq)
+{
+    const uint32_t head[3] = {SIMMAIN_LS_MAGIC, epoch, seq};
+
+    memcpy(g_simMainLsRecord, head, sizeof(head));
+    for (uint32_t i = sizeof(head); i < SIMMAIN_LS_RECORD; i++)
+    {
+        g_simMainLsRecord[i] = (uint8_t)((seq * 7U) + i);
+    }
+
+    uint32_t start = DWT->CYCCNT;
+    bool ok = LogStore_Append(g_simMainLsRecord, SIMMAIN_LS_RECORD);
+    uint32_t cycles = DWT->CYCCNT - start;
+    if (ok)
+    {
+        g_simMainLsCycles += cycles;
+        g_simMainLsCyclesMax = (cycles > g_simMainLsCyclesMax) ? cycles : g_simMainLsCyclesMax;
+    }
+    return ok;
+}
+
+/**
+ * @brief Append @p count records of an epoch, waiting whenever the staging buffer is half full.
+ *
+ * @retval false The store went offline.
+ */
+static bool SimMain_LsFill(uint32_t epoch, uint32_t count)
+{
+    for (uint32_t seq = 0U; seq < count;)
+    {
+        LogStore_Status_T status;
+        LogStore_GetStatus(&status);
+        if (!status.mounted)
+        {
+            return false;
+        }
+        if ((status.stage_level < (LOGSTORE_STAGE_BYTES / 2U)) && SimMain_LsAppend(epoch, seq))
+        {
+            seq++;
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(1U));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Cut the flash supply while appending, power it up, remount and check what survived.
+ *
+ * @param[in] epoch      Epoch of the records appended until the cut; the
+ *                       next one is used after the recovery.
+ * @param[in] ops        Program or erase the supply fails during.
+ * @param[in] erasesOnly Count erases only.
+ */
+static bool SimMain_LsCut(uint32_t epoch, uint32_t ops, bool erasesOnly)
+{
+    LogStore_Status_T before;
+    LogStore_Status_T after;
+
+    LogStore_GetStatus(&before);
+    bool ok = SimMain_LsFill(epoch, SIMMAIN_LS_DURABLE) && LogStore_Flush();
+
+    /* Records keep coming until the failed operation takes the store offline */
+    SimHw_NorCutPower(ops, erasesOnly);
+    uint32_t appended = SIMMAIN_LS_DURABLE;
+    for (uint32_t i = 0U; ok && (i < 5000U); i++)
+    {
+        LogStore_Status_T status;
+        LogStore_GetStatus(&status);
+        if (!status.mounted)
+        {
+            break;
+        }
+        if ((status.stage_level < (LOGSTORE_STAGE_BYTES / 2U)) && SimMain_LsAppend(epoch, appended))
+        {
+            appended++;
+        }
+        else
+        {
+            vTaskDelay(pdMS_TO_TICKS(1U));
+        }
+    }
+    LogStore_GetStatus(&after);
+    ok = ok && !after.mounted;
+
+    SimHw_NorPowerCycle();
+    ok = ok && LogStore_Mount() && SimMain_LsFill(epoch + 1U, SIMMAIN_LS_AFTER) && LogStore_Flush();
+    (void)SimMain_LsScan();
+    LogStore_GetStatus(&after);
+
+    const SimMain_LsEpoch_T *cut = &g_simMainLsEpochs[epoch];
+    const SimMain_LsEpoch_T *next = &g_simMainLsEpochs[epoch + 1U];
+    const SimMain_LsEpoch_T *fill = &g_simMainLsEpochs[0];
+    ok = ok && cut->ordered && cut->intact && (cut->first == 0U) && (cut->count >= SIMMAIN_LS_DURABLE) &&
+         (cut->count <= appended) && next->ordered && next->intact && (next->count == SIMMAIN_LS_AFTER) &&
+         fill->ordered && fill->intact;
+    fprintf(stderr, "logstore cut %-5s: after %u records, %u kept (%u flushed), %u torn, mount %u us, "
+                    "%u appended after, %s\n",
+            erasesOnly ? "erase" : "prog", appended, cut->count, SIMMAIN_LS_DURABLE, after.torn - before.torn,
+            after.mount_us, next->count, ok ? "ok" : SimMain_Fail("ERROR"));
+    return ok;
+}
+
+/**
+ * @brief Read every stored record and sort the bench ones into their epochs.
+ *
+ * @return Records read, bench and others.
+ */
+static uint32_t SimMain_LsScan(void)
+{
+    LogStore_Cursor_T cursor;
+    uint32_t records = 0U;
+    uint32_t length;
+
+    for (uint32_t i = 0U; i < SIMMAIN_LS_EPOCHS; i++)
+    {
+        g_simMainLsEpochs[i] = (SimMain_LsEpoch_T){0U, 0U, 0U, true, true};
+    }
+
+    LogStore_ReadBegin(&cursor);
+    while (LogStore_ReadNext(&cursor, g_simMainLsRecord, sizeof(g_simMainLsRecord), &length))
+    {
+        uint32_t head[3];
+        records++;
+        memcpy(head, g_simMainLsRecord, sizeof(head));
+        if ((length != SIMMAIN_LS_RECORD) || (head[0] != SIMMAIN_LS_MAGIC) || (head[1] >= SIMMAIN_LS_EPOCHS))
+        {
+            continue;
+        }
+
+        SimMain_LsEpoch_T *e = &g_simMainLsEpochs[head[1]];
+        uint32_t seq = head[2];
+        e->ordered = e->ordered && ((e->count == 0U) || (seq == (e->last + 1U)));
+        e->first = (e->count == 0U) ? seq : e->first;
+        e->last = seq;
+        e->count++;
+        for (uint32_t i = sizeof(head); i < SIMMAIN_LS_RECORD; i++)
+        {
+            e->intact = e->intact && (g_simMainLsRecord[i] == (uint8_t)((seq * 7U) + i));
+        }
+    }
+    return records;
+}
+
+/** @} */ // end of SimMain group
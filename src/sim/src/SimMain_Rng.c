@@ -0,0 +1,90 @@
+/**
+ * @file SimMain_Rng.c
+ * @brief RNG bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --rng-bench: RNG pool reads, refill latency and a sustained draw. Every
+ * check is printed with its verdict and failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Rng.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+
+/* Private Function Prototypes ----------------------------------------------*/
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Time pool reads, the refill latency of an empty pool and a sustained draw.
+ *
+ * The refill latency is what a caller polling the RNG for the same bytes
+ * would wait; the sustained draw takes 64-byte blocks back to back,
+ * sleeping on underruns, and checks the bit balance of the output.
+ */
+void SimMain_RngBench(void)
+{
+    static const uint32_t sizes[] = {4U, 16U, 32U, 64U, 128U};
+    uint8_t buf[128];
+
+    vTaskDelay(pdMS_TO_TICKS(2U));
+    fprintf(stderr, "rng bench         :   size  get cyc  get MB/s  refill latency us\n");
+    for (uint32_t i = 0U; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        uint32_t size = sizes[i];
+
+        vTaskDelay(pdMS_TO_TICKS(1U));
+        uint32_t start = DWT->CYCCNT;
+        bool ok = Rng_Get(buf, size);
+        uint32_t cycles = DWT->CYCCNT - start;
+
+        while (Rng_Get(buf, 4U))
+        {
+        }
+        start = DWT->CYCCNT;
+        while (!Rng_Get(buf, size))
+        {
+            __WFI();
+        }
+        uint32_t latency = DWT->CYCCNT - start;
+
+        fprintf(stderr, "                    %6u  %7u  %8.1f  %17.1f%s\n", size, cycles,
+                (cycles != 0U) ? ((double)size * (double)SystemCoreClock / (double)cycles / 1e6) : 0.0,
+                1e6 * (double)latency / (double)SystemCoreClock, ok ? "" : "  (pool not full)");
+    }
+
+    uint64_t ones = 0U;
+    uint32_t blocks = 0U;
+    uint32_t start = DWT->CYCCNT;
+    while (blocks < 256U)
+    {
+        if (!Rng_Get(buf, 64U))
+        {
+            __WFI();
+            continue;
+        }
+        for (uint32_t i = 0U; i < 64U; i++)
+        {
+            ones += (uint64_t)__builtin_popcount(buf[i]);
+        }
+        blocks++;
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    fprintf(stderr, "rng stream        : %u bytes in %.2f ms (%.2f MB/s), ones %.4f\n", blocks * 64U,
+            1e3 * (double)cycles / (double)SystemCoreClock,
+            (cycles != 0U) ? ((double)blocks * 64.0 * (double)SystemCoreClock / (double)cycles / 1e6) : 0.0,
+            (double)ones / ((double)blocks * 64.0 * 8.0));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/** @} */ // end of SimMain group
@@ -0,0 +1,191 @@
+/**
+ * @file SimMain_Sd.c
+ * @brief SD card bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --sd-bench: SD card mount, chained writes and reads, blocking requests.
+ * Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "SdBlk.h"
+#include "stm32n6xx.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_SD_REQUESTS         (16U)         /**< --sd-bench requests per streamed pass */
+#define SIMMAIN_SD_REQ_BLOCKS       (64U)         /**< --sd-bench blocks per streamed request */
+#define SIMMAIN_SD_BYTES            (SIMMAIN_SD_REQUESTS * SIMMAIN_SD_REQ_BLOCKS * SDBLK_BLOCK_SIZE)
+#define SIMMAIN_SD_SINGLES          (16U)         /**< --sd-bench blocking single-block writes and reads */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainSdTx[SIMMAIN_SD_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainSdRx[SIMMAIN_SD_BYTES] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainSdDone = 0U;
+static volatile uint32_t g_simMainSdFailed = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_SdStream(SdBlk_Op_T op, uint32_t eraseHint);
+static void SimMain_SdDone(void *ctx, SdBlk_Result_T result);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Mount the SD card, stream writes and reads through queued requests, then time blocking ones.
+ *
+ * Each streamed pass queues ::SIMMAIN_SD_REQUESTS consecutive requests at
+ * once so the driver merges them into multi-block runs; the second write
+ * pass sends a pre-erase hint for the whole area. The read pass checks
+ * the blocks against what was written.
+ */
+void SimMain_SdBench(void)
+{
+    SdBlk_Info_T info;
+    SdBlk_Result_T mount = SdBlk_Mount(&info);
+
+    if (mount != SDBLK_OK)
+    {
+        fprintf(stderr, "sd mount          : result %d, %s\n", (int)mount, SimMain_Fail("ERROR"));
+        return;
+    }
+    fprintf(stderr, "sd mount          : %u blocks (%u MiB), rca 0x%04x, %u Hz x%u, ok\n", info.blocks,
+            info.blocks / 2048U, info.rca, info.bus_hz, info.bus_width);
+
+    uint32_t seed = 0x2468ACE1U;
+    for (uint32_t i = 0U; i < SIMMAIN_SD_BYTES; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainSdTx[i] = (uint8_t)(seed >> 24);
+    }
+
+    fprintf(stderr, "sd stream         : pass          KiB  requests  runs     MB/s\n");
+    SimMain_SdStream(SDBLK_WRITE, 0U);
+    SimMain_SdStream(SDBLK_WRITE, SIMMAIN_SD_REQUESTS * SIMMAIN_SD_REQ_BLOCKS);
+    SimMain_SdStream(SDBLK_READ, 0U);
+
+    /* Blocking single blocks at scattered addresses past the streamed area */
+    uint32_t first = SIMMAIN_SD_REQUESTS * SIMMAIN_SD_REQ_BLOCKS;
+    uint64_t writeCycles = 0U;
+    uint64_t readCycles = 0U;
+    uint32_t writeMax = 0U;
+    uint32_t readMax = 0U;
+    bool ok = true;
+    for (uint32_t i = 0U; i < SIMMAIN_SD_SINGLES; i++)
+    {
+        const uint8_t *tx = &g_simMainSdTx[i * SDBLK_BLOCK_SIZE];
+        seed = (seed * 1664525U) + 1013904223U;
+        uint32_t lba = first + ((seed >> 8) % (info.blocks - first));
+
+        uint32_t start = DWT->CYCCNT;
+        ok = ok && (SdBlk_Write(lba, tx, 1U, 0U) == SDBLK_OK);
+        uint32_t cycles = DWT->CYCCNT - start;
+        writeCycles += cycles;
+        writeMax = (cycles > writeMax) ? cycles : writeMax;
+
+        memset(g_simMainSdRx, 0, SDBLK_BLOCK_SIZE);
+        start = DWT->CYCCNT;
+        ok = ok && (SdBlk_Read(lba, g_simMainSdRx, 1U) == SDBLK_OK);
+        cycles = DWT->CYCCNT - start;
+        readCycles += cycles;
+        readMax = (cycles > readMax) ? cycles : readMax;
+        ok = ok && (memcmp(tx, g_simMainSdRx, SDBLK_BLOCK_SIZE) == 0);
+    }
+    double usPerCycle = 1e6 / (double)SystemCoreClock;
+    fprintf(stderr, "sd blocking       : %u writes + %u reads of 1 block, write avg %.1f / max %.1f us, "
+                    "read avg %.1f / max %.1f us, %s\n",
+            SIMMAIN_SD_SINGLES, SIMMAIN_SD_SINGLES, (double)writeCycles * usPerCycle / SIMMAIN_SD_SINGLES,
+            (double)writeMax * usPerCycle, (double)readCycles * usPerCycle / SIMMAIN_SD_SINGLES,
+            (double)readMax * usPerCycle, ok ? "ok" : SimMain_Fail("ERROR"));
+
+    /* Requests outside the card or with a misaligned buffer are refused before queueing */
+    const SdBlk_Request_T outside = {SDBLK_READ, info.blocks, 1U, g_simMainSdRx, 0U, NULL, NULL};
+    const SdBlk_Request_T misaligned = {SDBLK_WRITE, 0U, 1U, &g_simMainSdTx[1], 0U, NULL, NULL};
+    bool refused = !SdBlk_Submit(&outside) && !SdBlk_Submit(&misaligned) &&
+                   (SdBlk_Read(info.blocks - 1U, g_simMainSdRx, 2U) == SDBLK_ERR_PARAM);
+    fprintf(stderr, "sd reject         : out of range and misaligned requests refused, %s\n",
+            refused ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Queue one streamed pass at once and wait for its last request.
+ *
+ * @param[in] op        Direction.
+ * @param[in] eraseHint Pre-erase hint of the first write, 0 for none.
+ */
+static void SimMain_SdStream(SdBlk_Op_T op, uint32_t eraseHint)
+{
+    uint32_t bytes = SIMMAIN_SD_REQ_BLOCKS * SDBLK_BLOCK_SIZE;
+    uint8_t *data = (op == SDBLK_READ) ? g_simMainSdRx : g_simMainSdTx;
+    SdBlk_Status_T before;
+    SdBlk_Status_T after;
+
+    if (op == SDBLK_READ)
+    {
+        memset(g_simMainSdRx, 0, sizeof(g_simMainSdRx));
+    }
+    SdBlk_GetStatus(&before);
+    g_simMainSdDone = 0U;
+    g_simMainSdFailed = 0U;
+
+    /* Queued with interrupts masked so only the first request runs alone */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = DWT->CYCCNT;
+    bool ok = true;
+    for (uint32_t i = 0U; i < SIMMAIN_SD_REQUESTS; i++)
+    {
+        const SdBlk_Request_T req = {
+            .op = op,
+            .lba = i * SIMMAIN_SD_REQ_BLOCKS,
+            .blocks = SIMMAIN_SD_REQ_BLOCKS,
+            .buf = &data[i * bytes],
+            .erase_hint = (i == 0U) ? eraseHint : 0U,
+            .cb = SimMain_SdDone,
+            .ctx = NULL,
+        };
+        ok = ok && SdBlk_Submit(&req);
+    }
+    __set_PRIMASK(primask);
+
+    while (ok && ((g_simMainSdDone + g_simMainSdFailed) < SIMMAIN_SD_REQUESTS))
+    {
+        __WFI();
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    SdBlk_GetStatus(&after);
+
+    ok = ok && (g_simMainSdFailed == 0U);
+    if (op == SDBLK_READ)
+    {
+        ok = ok && (memcmp(g_simMainSdTx, g_simMainSdRx, SIMMAIN_SD_BYTES) == 0);
+    }
+    fprintf(stderr, "                    %-12s %5u  %8u  %4u  %7.2f   %s\n",
+            (op == SDBLK_READ) ? "read" : ((eraseHint != 0U) ? "write+erase" : "write"), SIMMAIN_SD_BYTES / 1024U,
+            SIMMAIN_SD_REQUESTS, after.runs - before.runs,
+            (cycles != 0U) ? ((double)SIMMAIN_SD_BYTES * (double)SystemCoreClock / (double)cycles / 1e6) : 0.0,
+            ok ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/**
+ * @brief Completion callback of the --sd-bench streamed requests.
+ */
+static void SimMain_SdDone(void *ctx, SdBlk_Result_T result)
+{
+    (void)ctx;
+    if (result == SDBLK_OK)
+    {
+        g_simMainSdDone++;
+    }
+    else
+    {
+        g_simMainSdFailed++;
+    }
+}
+
+/** @} */ // end of SimMain group
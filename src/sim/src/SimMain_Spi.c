@@ -0,0 +1,175 @@
+/**
+ * @file SimMain_Spi.c
+ * @brief SPI bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --spi-bench: SPI1 transactions through the loopback, chained ones timed.
+ * Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "SpiDma.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_gpio.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_SPI_BYTES           (4096U)       /**< --spi-bench buffers */
+#define SIMMAIN_SPI_SEGMENTS        (8U)          /**< --spi-bench transactions per sequence */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainSpiTx[SIMMAIN_SPI_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainSpiRx[SIMMAIN_SPI_BYTES] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainSpiDone = 0U;
+static volatile uint32_t g_simMainSpiFailed = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static uint32_t SimMain_SpiSequence(const SpiDma_Device_T *dev, bool chained, uint32_t *runs);
+static void SimMain_SpiDone(void *ctx, bool success);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Check SPI1 transactions through the loopback and time chained ones.
+ *
+ * Each device exchanges a buffer, then sends the fill byte and discards
+ * what it receives. A sequence of transactions is then run twice on the
+ * fastest device, once chained with KEEP_CS and once as separate
+ * transfers: the line utilisation shows the gap the CPU leaves between
+ * transfers. Rates are in virtual time.
+ */
+void SimMain_SpiBench(void)
+{
+    static const SpiDma_Device_T devices[] = {
+        {GPIOB, LL_GPIO_PIN_0, 0U, false, 100000000U},
+        {GPIOB, LL_GPIO_PIN_1, 0U, false, 20000000U},
+        {GPIOB, LL_GPIO_PIN_2, 3U, true, 1000000U},
+    };
+    uint32_t seed = 0x13579BDFU;
+
+    for (uint32_t i = 0U; i < SIMMAIN_SPI_BYTES; i++)
+    {
+        seed = (seed * 1664525U) + 1013904223U;
+        g_simMainSpiTx[i] = (uint8_t)(seed >> 24);
+    }
+
+    fprintf(stderr, "spi check         : mode  lsb   sck kHz    bytes  exchange MB/s  loopback  fill  discard\n");
+    for (uint32_t d = 0U; d < (sizeof(devices) / sizeof(devices[0])); d++)
+    {
+        const SpiDma_Device_T *dev = &devices[d];
+        uint32_t size = (dev->max_hz < 10000000U) ? 256U : SIMMAIN_SPI_BYTES;
+
+        if (!SpiDma_InitDevice(dev))
+        {
+            fprintf(stderr, "SpiDma_InitDevice %s\n", SimMain_Fail("failed"));
+            return;
+        }
+
+        memset(g_simMainSpiRx, 0, sizeof(g_simMainSpiRx));
+        uint32_t start = DWT->CYCCNT;
+        bool loop = SpiDma_TransferWait(dev, g_simMainSpiTx, g_simMainSpiRx, (uint16_t)size, 0U);
+        uint32_t cycles = DWT->CYCCNT - start;
+        loop = loop && (memcmp(g_simMainSpiTx, g_simMainSpiRx, size) == 0);
+
+        bool fill = SpiDma_TransferWait(dev, NULL, g_simMainSpiRx, 64U, 0U);
+        for (uint32_t i = 0U; i < 64U; i++)
+        {
+            fill = fill && (g_simMainSpiRx[i] == SPIDMA_FILL_BYTE);
+        }
+        bool discard = SpiDma_TransferWait(dev, g_simMainSpiTx, NULL, 64U, 0U);
+
+        fprintf(stderr, "                    %4u  %3s  %8u  %7u  %13.2f  %8s  %4s  %7s\n", dev->mode,
+                dev->lsb_first ? "yes" : "no", SpiDma_GetDeviceHz(dev) / 1000U, size,
+                (cycles != 0U) ? ((double)size * (double)SystemCoreClock / (double)cycles / 1e6) : 0.0,
+                loop ? "match" : SimMain_Fail("MISMATCH"), fill ? "ok" : SimMain_Fail("BAD"), discard ? "ok" : SimMain_Fail("BAD"));
+    }
+
+    const SpiDma_Device_T *fast = &devices[0];
+    uint32_t bytes = SIMMAIN_SPI_SEGMENTS * (SIMMAIN_SPI_BYTES / SIMMAIN_SPI_SEGMENTS);
+    double lineUs = (double)bytes * 8.0 * 1e6 / (double)SpiDma_GetDeviceHz(fast);
+    fprintf(stderr, "spi chain         : %u x %u B   runs   total us   line busy   result\n", SIMMAIN_SPI_SEGMENTS,
+            SIMMAIN_SPI_BYTES / SIMMAIN_SPI_SEGMENTS);
+    for (uint32_t pass = 0U; pass < 2U; pass++)
+    {
+        uint32_t runs = 0U;
+        memset(g_simMainSpiRx, 0, sizeof(g_simMainSpiRx));
+        uint32_t cycles = SimMain_SpiSequence(fast, pass == 0U, &runs);
+        double us = (double)cycles * 1e6 / (double)SystemCoreClock;
+        bool same = (cycles != 0U) && (memcmp(g_simMainSpiTx, g_simMainSpiRx, bytes) == 0);
+
+        fprintf(stderr, "                    %-9s  %4u  %9.1f  %8.1f %%   %s\n", (pass == 0U) ? "chained" : "separate",
+                runs, us, (us > 0.0) ? (100.0 * lineUs / us) : 0.0, same ? "match" : SimMain_Fail("MISMATCH"));
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Queue ::SIMMAIN_SPI_SEGMENTS transactions at once and wait for the last one.
+ *
+ * @param[out] runs Transfers the driver started for them.
+ *
+ * @return CPU cycles from the first submission to the last callback, 0 on failure.
+ */
+static uint32_t SimMain_SpiSequence(const SpiDma_Device_T *dev, bool chained, uint32_t *runs)
+{
+    uint32_t seg = SIMMAIN_SPI_BYTES / SIMMAIN_SPI_SEGMENTS;
+    SpiDma_Status_T before;
+    SpiDma_Status_T after;
+
+    SpiDma_GetStatus(&before);
+    g_simMainSpiDone = 0U;
+    g_simMainSpiFailed = 0U;
+
+    /* Queued with interrupts masked so the whole sequence is waiting when the first one starts */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t start = DWT->CYCCNT;
+    bool ok = true;
+    for (uint32_t i = 0U; i < SIMMAIN_SPI_SEGMENTS; i++)
+    {
+        const SpiDma_Xfer_T xfer = {
+            .dev = dev,
+            .tx = &g_simMainSpiTx[i * seg],
+            .rx = &g_simMainSpiRx[i * seg],
+            .size = (uint16_t)seg,
+            .flags = (chained && (i != (SIMMAIN_SPI_SEGMENTS - 1U))) ? SPIDMA_XFER_KEEP_CS : 0U,
+            .cb = SimMain_SpiDone,
+            .ctx = NULL,
+        };
+        ok = ok && SpiDma_Submit(&xfer);
+    }
+    __set_PRIMASK(primask);
+
+    while (ok && ((g_simMainSpiDone + g_simMainSpiFailed) < SIMMAIN_SPI_SEGMENTS))
+    {
+        __WFI();
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+
+    SpiDma_GetStatus(&after);
+    *runs = after.runs - before.runs;
+    return (ok && (g_simMainSpiFailed == 0U)) ? cycles : 0U;
+}
+
+/**
+ * @brief Completion callback of the --spi-bench sequences.
+ */
+static void SimMain_SpiDone(void *ctx, bool success)
+{
+    (void)ctx;
+    if (success)
+    {
+        g_simMainSpiDone++;
+    }
+    else
+    {
+        g_simMainSpiFailed++;
+    }
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,118 @@
+/**
+ * @file SimMain_Tickless.c
+ * @brief Tickless idle bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --tickless-bench: a vTaskDelayUntil() loop with and without tickless idle.
+ * Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <math.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "LpTick.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_TICKLESS_PERIOD_MS  (20U)         /**< --tickless-bench vTaskDelayUntil() period */
+#define SIMMAIN_TICKLESS_CYCLES     (10U)         /**< --tickless-bench periods per mode */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_TicklessRun(bool tickless);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Run a vTaskDelayUntil() loop with the tick on every period, then tickless.
+ *
+ * The demo task wakes every tick and is suspended meanwhile, so only this
+ * task and the UART supervisor keep the core from sleeping.
+ */
+void SimMain_TicklessBench(void)
+{
+    LpTick_Status_T status;
+    LpTick_GetStatus(&status);
+    if (status.clock_hz == 0U)
+    {
+        fprintf(stderr, "tickless          : LPTIM1 tick not running, %s\n", SimMain_Fail("ERROR"));
+        return;
+    }
+
+    TaskHandle_t demo = xTaskGetHandle("TestTask");
+    if (demo != NULL)
+    {
+        vTaskSuspend(demo);
+    }
+    bool tickless = status.tickless;
+    SimMain_TicklessRun(false);
+    SimMain_TicklessRun(true);
+    LpTick_SetTickless(tickless);
+    if (demo != NULL)
+    {
+        vTaskResume(demo);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief One mode of --tickless-bench: wake-ups per second and wake-up accuracy.
+ *
+ * The wake-up error is the counter at each wake-up against the boundary of
+ * the tick it was due at, taken from the first wake-up and the period, so
+ * drift in the tick accounting accumulates into it.
+ */
+static void SimMain_TicklessRun(bool tickless)
+{
+    LpTick_SetTickless(tickless);
+    TickType_t wake = xTaskGetTickCount();
+    vTaskDelayUntil(&wake, 1U);
+
+    LpTick_Status_T before;
+    LpTick_GetStatus(&before);
+    uint64_t origin = LpTick_GetCount();
+    uint64_t hz = before.clock_hz;
+    uint64_t periodTicks = pdMS_TO_TICKS(SIMMAIN_TICKLESS_PERIOD_MS);
+    TickType_t first = wake;
+    int64_t errMin = 0;
+    int64_t errMax = 0;
+    for (uint32_t i = 1U; i <= SIMMAIN_TICKLESS_CYCLES; i++)
+    {
+        vTaskDelayUntil(&wake, (TickType_t)periodTicks);
+        uint64_t now = LpTick_GetCount();
+        /* Boundaries fall on floor(k x clock / rate), relative to the first one */
+        uint64_t ideal = ((uint64_t)i * periodTicks * hz) / configTICK_RATE_HZ;
+        int64_t err = (int64_t)(now - origin) - (int64_t)ideal;
+        errMin = (err < errMin) ? err : errMin;
+        errMax = (err > errMax) ? err : errMax;
+    }
+    TickType_t elapsed = xTaskGetTickCount() - first;
+
+    LpTick_Status_T after;
+    LpTick_GetStatus(&after);
+    uint32_t irqs = after.tick_irqs - before.tick_irqs;
+    uint32_t sleeps = after.sleeps - before.sleeps;
+    uint32_t runMs = SIMMAIN_TICKLESS_CYCLES * SIMMAIN_TICKLESS_PERIOD_MS;
+    uint32_t wakeupsPerS = ((irqs + sleeps) * 1000U) / runMs;
+    /* Every wake-up lies within a counter period of its boundary, plus the lead of a late compare,
+     * and every compare write was confirmed */
+    bool accurate = (errMin >= -1) && (errMax <= (int64_t)LPTICK_MIN_LEAD + 1) &&
+                    (after.cmp_timeouts == before.cmp_timeouts);
+    /* The UART supervisor still wakes every 10 ms, so tickless at least thirds the wake-ups */
+    bool quiet = tickless ? (wakeupsPerS * 3U < configTICK_RATE_HZ) : (irqs + 2U >= runMs);
+    fprintf(stderr, "tickless %-9s: %u ms period, %u ticks in %u ms, %u tick irqs + %u sleeps = %u wake-ups/s, "
+                    "%u ticks stepped, wake error %lld..%lld counts (%u Hz), %s\n",
+            tickless ? "on" : "off", SIMMAIN_TICKLESS_PERIOD_MS, (uint32_t)elapsed, runMs, irqs, sleeps,
+            wakeupsPerS, after.ticks_stepped - before.ticks_stepped, (long long)errMin, (long long)errMax,
+            before.clock_hz, ((elapsed == (TickType_t)(SIMMAIN_TICKLESS_CYCLES * periodTicks)) && accurate && quiet)
+                                 ? "ok"
+                                 : SimMain_Fail("ERROR"));
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,216 @@
+/**
+ * @file SimMain_Usb.c
+ * @brief USB bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --usb-bench: enumeration, the log on the CDC port and a stream on the trace
+ * channel. Every check is printed with its verdict and failures go through
+ * ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "UsbDev.h"
+#include "stm32n6xx.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_USB_WAIT_MS         (200U)        /**< --usb-bench longest wait for enumeration or the port */
+#define SIMMAIN_USB_OPEN_MS         (50U)         /**< --usb-bench time the log runs over the CDC port */
+#define SIMMAIN_USB_BUFFERS         (4U)          /**< --usb-bench trace buffers in flight */
+#define SIMMAIN_USB_BUFFER_BYTES    (16384U)      /**< --usb-bench trace buffer size */
+#define SIMMAIN_USB_STREAM_BYTES    (8U * 1024U * 1024U) /**< --usb-bench bytes streamed on the trace channel */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainUsbBuf[SIMMAIN_USB_BUFFERS][SIMMAIN_USB_BUFFER_BYTES] __attribute__((aligned(32)));
+static volatile uint32_t g_simMainUsbDone = 0U;
+static volatile uint32_t g_simMainUsbFailed = 0U;
+static volatile uint32_t g_simMainUsbRx = 0U;
+static char g_simMainUsbText[1024];
+
+/* Private Function Prototypes ----------------------------------------------*/
+static bool SimMain_UsbStream(uint8_t ep);
+static void SimMain_UsbDone(void *ctx, bool success);
+static void SimMain_UsbReceive(void *ctx, const uint8_t *data, uint32_t size);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Attach the simulated USB host, move the log to the CDC port and stream the trace channel.
+ *
+ * The host enumerates the device, then opens the CDC port: the logger
+ * switches from the UART to USB and the text the host writes reaches the
+ * receiver. The trace stream is checked byte for byte through its hash
+ * on the host side. Closing the port and unplugging give the log back to
+ * the UART.
+ */
+void SimMain_UsbBench(void)
+{
+    static const char *const stopBits[] = {"1", "1.5", "2"};
+    SimHw_UsbHost_T host;
+    UsbDev_Status_T status;
+
+    SimHw_UsbAttach(true);
+    SimHw_UsbGetHost(&host);
+    for (uint32_t ms = 0U; !host.configured && (ms < SIMMAIN_USB_WAIT_MS); ms++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(1U));
+        SimHw_UsbGetHost(&host);
+    }
+    UsbDev_GetStatus(&status);
+    bool ok = host.configured && (status.state == USBDEV_CONFIGURED) && (host.vid == USBDEV_VID) &&
+              (host.pid == USBDEV_PID) && (strcmp(host.product, USBDEV_PRODUCT) == 0) && (host.cdc_in_ep == 0x82U) &&
+              (host.cdc_out_ep == 0x02U) && (host.trace_in_ep == 0x83U) && (host.protocol_errors == 0U);
+    fprintf(stderr, "usb enumerate     : %s speed, address %u, %04x:%04x \"%s\", cdc 0x%02x/0x%02x, trace 0x%02x, "
+                    "%u B packets, %u B configuration, %u requests (%u stalled), %.1f ms, %s\n",
+            host.high_speed ? "high" : "full", host.address, host.vid, host.pid, host.product, host.cdc_in_ep,
+            host.cdc_out_ep, host.trace_in_ep, host.bulk_mps, host.config_bytes, host.control_done,
+            host.control_stalled, (double)host.enumerated_ns / 1e6, ok ? "ok" : SimMain_Fail("ERROR"));
+    if (!host.configured)
+    {
+        SimHw_UsbAttach(false);
+        return;
+    }
+
+    /* Opening the port moves the log output from the UART to USB */
+    g_simMainUsbRx = 0U;
+    UsbDev_SetReceiver(SimMain_UsbReceive, NULL);
+    uint64_t logBefore = SimHw_UsbReceived(host.cdc_in_ep, NULL);
+    SimHw_UsbOpen(true);
+    vTaskDelay(pdMS_TO_TICKS(SIMMAIN_USB_OPEN_MS));
+    SimHw_UsbGetHost(&host);
+    UsbDev_GetStatus(&status);
+    uint64_t logBytes = SimHw_UsbReceived(host.cdc_in_ep, NULL) - logBefore;
+    uint32_t got = SimHw_UsbRead(host.cdc_in_ep, g_simMainUsbText, sizeof(g_simMainUsbText) - 1U);
+    g_simMainUsbText[got] = '\0';
+    ok = host.open && status.dtr && (status.line.baudrate == 921600U) && (status.line.data_bits == 8U) &&
+         (status.line.parity == 0U) && (status.line.stop_bits == 0U) && (g_simMainUsbRx == 4U) && (logBytes != 0U) &&
+         (strstr(g_simMainUsbText, "Hello") != NULL);
+    fprintf(stderr, "usb cdc port      : dtr %u, line %u %u%c%s, %u B from the host, %llu B of log in %u ms, %s\n",
+            status.dtr ? 1U : 0U, status.line.baudrate, status.line.data_bits,
+            (status.line.parity < 5U) ? "NOEMS"[status.line.parity] : '?',
+            (status.line.stop_bits < 3U) ? stopBits[status.line.stop_bits] : "?", g_simMainUsbRx,
+            (unsigned long long)logBytes, SIMMAIN_USB_OPEN_MS, ok ? "ok" : SimMain_Fail("ERROR"));
+
+    (void)SimMain_UsbStream(host.trace_in_ep);
+
+    /* Closing the port and unplugging give the log back to the UART */
+    SimHw_UsbOpen(false);
+    vTaskDelay(pdMS_TO_TICKS(5U));
+    SimHw_UsbAttach(false);
+    vTaskDelay(pdMS_TO_TICKS(10U));
+    SimHw_Stats_T before;
+    SimHw_Stats_T after;
+    SimHw_GetStats(&before);
+    vTaskDelay(pdMS_TO_TICKS(20U));
+    SimHw_GetStats(&after);
+    SimHw_UsbGetHost(&host);
+    UsbDev_GetStatus(&status);
+    UsbDev_SetReceiver(NULL, NULL);
+    ok = !host.open && !status.dtr && (status.state == USBDEV_SUSPENDED) && !UsbDev_IsOpen(USBDEV_CDC) &&
+         !UsbDev_IsOpen(USBDEV_TRACE) && (after.usart_tx_bytes > before.usart_tx_bytes) &&
+         (host.protocol_errors == 0U);
+    fprintf(stderr, "usb detach        : %s, %u suspends, %llu B on the UART in 20 ms, %u protocol errors, %s\n",
+            (status.state == USBDEV_SUSPENDED) ? "suspended" : "still active", status.suspends,
+            (unsigned long long)(after.usart_tx_bytes - before.usart_tx_bytes), host.protocol_errors,
+            ok ? "ok" : SimMain_Fail("ERROR"));
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Stream ::SIMMAIN_USB_STREAM_BYTES on the trace channel, resubmitting each buffer once it completes.
+ *
+ * @param[in] ep Trace endpoint address found by the host.
+ *
+ * @retval true  The host received every byte in order.
+ * @retval false A request failed or the host saw other data.
+ */
+static bool SimMain_UsbStream(uint8_t ep)
+{
+    uint32_t buffers = SIMMAIN_USB_STREAM_BYTES / SIMMAIN_USB_BUFFER_BYTES;
+    uint32_t submitted = 0U;
+    uint32_t seed = 0x13579BDFU;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint64_t hostBefore = SimHw_UsbReceived(ep, NULL);
+    UsbDev_Status_T before;
+    UsbDev_Status_T after;
+    SimHw_Stats_T busBefore;
+    SimHw_Stats_T busAfter;
+    bool ok = true;
+
+    UsbDev_GetStatus(&before);
+    SimHw_GetStats(&busBefore);
+    g_simMainUsbDone = 0U;
+    g_simMainUsbFailed = 0U;
+
+    uint32_t start = DWT->CYCCNT;
+    while (ok && (g_simMainUsbDone < buffers))
+    {
+        if ((submitted < buffers) && ((submitted - g_simMainUsbDone) < SIMMAIN_USB_BUFFERS))
+        {
+            uint8_t *buf = g_simMainUsbBuf[submitted % SIMMAIN_USB_BUFFERS];
+            for (uint32_t i = 0U; i < SIMMAIN_USB_BUFFER_BYTES; i++)
+            {
+                seed = (seed * 1664525U) + 1013904223U;
+                buf[i] = (uint8_t)(seed >> 24);
+                hash = (hash ^ buf[i]) * 0x00000100000001B3ULL;
+            }
+            ok = UsbDev_Submit(USBDEV_TRACE, buf, SIMMAIN_USB_BUFFER_BYTES, SimMain_UsbDone, NULL);
+            submitted++;
+        }
+        else
+        {
+            __WFI();
+        }
+        ok = ok && (g_simMainUsbFailed == 0U);
+    }
+    uint32_t cycles = DWT->CYCCNT - start;
+    UsbDev_GetStatus(&after);
+    SimHw_GetStats(&busAfter);
+
+    uint64_t hostHash = 0U;
+    uint64_t hostBytes = SimHw_UsbReceived(ep, &hostHash) - hostBefore;
+    ok = ok && (hostBytes == SIMMAIN_USB_STREAM_BYTES) && (hostHash == hash);
+    double seconds = (double)cycles / (double)SystemCoreClock;
+    fprintf(stderr, "usb trace stream  : %u KiB in %u buffers of %u KiB, %.1f MB/s, bus busy %.1f %%, %u transfers, "
+                    "%u irqs, %s\n",
+            SIMMAIN_USB_STREAM_BYTES / 1024U, buffers, SIMMAIN_USB_BUFFER_BYTES / 1024U,
+            (seconds > 0.0) ? ((double)SIMMAIN_USB_STREAM_BYTES / seconds / 1e6) : 0.0,
+            (seconds > 0.0) ? (100.0 * (double)(busAfter.usb_busy_ns - busBefore.usb_busy_ns) / (seconds * 1e9)) : 0.0,
+            after.transfers - before.transfers, after.irqs - before.irqs, ok ? "ok" : SimMain_Fail("ERROR"));
+    return ok;
+}
+
+/**
+ * @brief Completion callback of the --usb-bench trace buffers.
+ */
+static void SimMain_UsbDone(void *ctx, bool success)
+{
+    (void)ctx;
+    if (success)
+    {
+        g_simMainUsbDone++;
+    }
+    else
+    {
+        g_simMainUsbFailed++;
+    }
+}
+
+/**
+ * @brief Receiver of the CDC port during --usb-bench.
+ */
+static void SimMain_UsbReceive(void *ctx, const uint8_t *data, uint32_t size)
+{
+    (void)ctx;
+    (void)data;
+    g_simMainUsbRx += size;
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,118 @@
+/**
+ * @file SimMain_Venc.c
+ * @brief Venc bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --venc-fps: synthetic frames fed to the encoder pipeline. Every check is
+ * printed with its verdict and failures go through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Venc.h"
+#include "SimVenc.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_VENC_W              (320U)        /**< --venc-fps frame width */
+#define SIMMAIN_VENC_H              (240U)        /**< --venc-fps frame height */
+#define SIMMAIN_VENC_FRAME_BYTES    (SIMMAIN_VENC_W * SIMMAIN_VENC_H * 2U)
+#define SIMMAIN_VENC_RING_BYTES     (64U * 1024U) /**< --venc-fps bitstream ring */
+#define SIMMAIN_VENC_MAX_PACKET     (16U * 1024U) /**< --venc-fps largest packet */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint8_t g_simMainVencFrames[2][SIMMAIN_VENC_FRAME_BYTES] __attribute__((aligned(32)));
+static uint8_t g_simMainVencRing[SIMMAIN_VENC_RING_BYTES] __attribute__((aligned(32)));
+uint32_t g_simMainVencChecksum = 0U;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static void SimMain_VencFill(uint8_t *frame, uint32_t n);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Act as camera and stream consumer of the encoder pipeline.
+ *
+ * Captures a 320x240 YUYV frame every period into the double buffer when
+ * one is free and drains the ring in place, until the run ends.
+ *
+ * @param[in] fps Frames captured per second.
+ */
+void SimMain_VencBench(uint32_t fps)
+{
+    Venc_Config_T config = {
+        .codec = VENC_CODEC_H264,
+        .format = VENC_FMT_YUYV,
+        .width = SIMMAIN_VENC_W,
+        .height = SIMMAIN_VENC_H,
+        .gop = 30U,
+        .quality = 28U,
+        .frames = {g_simMainVencFrames[0], g_simMainVencFrames[1]},
+        .frame_count = 2U,
+        .ring = g_simMainVencRing,
+        .ring_size = SIMMAIN_VENC_RING_BYTES,
+        .max_packet = SIMMAIN_VENC_MAX_PACKET,
+    };
+
+    if (!Venc_Init(&config, SimVenc_Backend()))
+    {
+        fprintf(stderr, "Venc_Init %s\n", SimMain_Fail("failed"));
+        return;
+    }
+
+    TickType_t period = pdMS_TO_TICKS(1000U / fps);
+    TickType_t wake = xTaskGetTickCount();
+    for (uint32_t n = 0U;; n++)
+    {
+        uint8_t *frame = Venc_AcquireFrame();
+        if (frame != NULL)
+        {
+            SimMain_VencFill(frame, n);
+            (void)Venc_SubmitFrame(frame, (uint64_t)xTaskGetTickCount() * 1000U);
+        }
+
+        Venc_Packet_T packet;
+        while (Venc_PeekPacket(&packet))
+        {
+            for (uint32_t i = 0U; i < packet.size; i++)
+            {
+                g_simMainVencChecksum = (g_simMainVencChecksum * 31U) + packet.data[i];
+            }
+            Venc_ReleasePacket();
+        }
+        vTaskDelayUntil(&wake, (period != 0U) ? period : 1U);
+    }
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Draw frame @p n: scrolling bars with a moving noisy square.
+ */
+static void SimMain_VencFill(uint8_t *frame, uint32_t n)
+{
+    uint32_t seed = n;
+    uint32_t sqX = (n * 5U) % (SIMMAIN_VENC_W - 64U);
+    uint32_t sqY = (n * 3U) % (SIMMAIN_VENC_H - 64U);
+
+    for (uint32_t y = 0U; y < SIMMAIN_VENC_H; y++)
+    {
+        uint8_t *line = &frame[y * SIMMAIN_VENC_W * 2U];
+        for (uint32_t x = 0U; x < SIMMAIN_VENC_W; x++)
+        {
+            uint8_t luma = (((x + (n * 4U)) & 0x40U) != 0U) ? 200U : 40U;
+            if ((x >= sqX) && (x < (sqX + 64U)) && (y >= sqY) && (y < (sqY + 64U)))
+            {
+                seed = (seed * 1664525U) + 1013904223U;
+                luma = (uint8_t)(seed >> 24);
+            }
+            line[x * 2U] = luma;
+            line[(x * 2U) + 1U] = 0x80U;
+        }
+    }
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,263 @@
+/**
+ * @file SimMain_Wave.c
+ * @brief GpioWave bench of the host simulation.
+ * @ingroup SimMain
+ * @{
+ *
+ * --wave-bench: compiled GPIO waveforms checked word by word and played once
+ * and in a loop. Every check is printed with its verdict and failures go
+ * through ::SimMain_Fail.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include "SimMain_Bench.h"
+#include <stdio.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "GpioWave.h"
+#include "stm32n6xx.h"
+#include "stm32n6xx_ll_gpio.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMMAIN_WAVE_PORT           GPIOE         /**< --wave-bench port */
+#define SIMMAIN_WAVE_PINS           (0x000FU)     /**< --wave-bench pins 0 to 3 */
+#define SIMMAIN_WAVE_HZ             (1000000U)    /**< --wave-bench step rate */
+#define SIMMAIN_WAVE_WORDS          (512U)        /**< --wave-bench buffer */
+#define SIMMAIN_WAVE_BITS           (16U)         /**< --wave-bench bits clocked out by the single playback */
+#define SIMMAIN_WAVE_LOOP_MS        (20U)         /**< --wave-bench circular run time */
+#define SIMMAIN_WAVE_EDGES          (8192U)       /**< --wave-bench level changes checked per playback */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+
+/* Global Variables ---------------------------------------------------------*/
+static uint32_t g_simMainWaveBuf[SIMMAIN_WAVE_WORDS] __attribute__((aligned(32)));
+static SimHw_GpioEdge_T g_simMainWaveEdges[SIMMAIN_WAVE_EDGES];
+static volatile uint32_t g_simMainWaveEnds = 0U;
+static volatile bool g_simMainWaveOk = false;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static bool SimMain_WaveCheckWords(const GpioWave_Pattern_T *pattern, const uint32_t *words, uint32_t count);
+static bool SimMain_WavePlay(const char *name, uint32_t words, bool circular);
+static void SimMain_WaveDone(void *ctx, bool success);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Compile GPIO waveforms, check the words, then play them once and in a loop and check every edge.
+ *
+ * The single playback clocks a 16-bit word out on a clock, a data and a
+ * latch pin; the looped one is a staircase of steps of 1 to 7 periods on
+ * all four pins. The buffers are checked against the descriptions before
+ * any hardware is involved, the playbacks against the level changes the
+ * model records on the port.
+ */
+void SimMain_WaveBench(void)
+{
+    static const GpioWave_Step_T stair[] = {{0x1U, 1U}, {0x3U, 2U}, {0x2U, 3U}, {0x6U, 4U},
+                                            {0x4U, 5U}, {0xCU, 6U}, {0x8U, 7U}, {0x0U, 4U}};
+    static GpioWave_Step_T frame[(2U * SIMMAIN_WAVE_BITS) + 2U];
+    const uint16_t word = 0xA5C3U;
+
+    /* Clock on pin 0, data on pin 1 set up while the clock is low, latch on pin 2 */
+    uint32_t n = 0U;
+    for (uint32_t bit = 0U; bit < SIMMAIN_WAVE_BITS; bit++)
+    {
+        uint16_t data = (uint16_t)(((word >> (SIMMAIN_WAVE_BITS - 1U - bit)) & 1U) << 1);
+        frame[n++] = (GpioWave_Step_T){data, 3U};
+        frame[n++] = (GpioWave_Step_T){(uint16_t)(data | 0x1U), 2U};
+    }
+    frame[n++] = (GpioWave_Step_T){0x4U, 5U};
+    frame[n] = (GpioWave_Step_T){0x0U, 1U};
+    GpioWave_Pattern_T framePattern = {0x7U, frame, n + 1U};
+    /* The buffer outside the non-cacheable pool must span whole cache lines */
+    uint32_t pad = (8U - (GpioWave_Words(&framePattern) % 8U)) % 8U;
+    frame[n].ticks += pad;
+    GpioWave_Pattern_T stairPattern = {SIMMAIN_WAVE_PINS, stair, sizeof(stair) / sizeof(stair[0])};
+
+    /* Descriptions no buffer can be compiled from */
+    static const GpioWave_Step_T zero[] = {{0x1U, 2U}, {0x0U, 0U}};
+    GpioWave_Pattern_T noPins = {0U, stair, 2U};
+    GpioWave_Pattern_T zeroTicks = {0x1U, zero, 2U};
+    GpioWave_Pattern_T noSteps = {0x1U, stair, 0U};
+    uint32_t stairWords = GpioWave_Words(&stairPattern);
+    bool rejected = (GpioWave_Compile(&noPins, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS) == 0U) &&
+                    (GpioWave_Compile(&zeroTicks, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS) == 0U) &&
+                    (GpioWave_Compile(&noSteps, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS) == 0U) &&
+                    (GpioWave_Compile(NULL, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS) == 0U) &&
+                    (GpioWave_Compile(&stairPattern, g_simMainWaveBuf, stairWords - 1U) == 0U);
+
+    uint32_t frameWords = GpioWave_Compile(&framePattern, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS);
+    bool frameOk = (frameWords == GpioWave_Words(&framePattern)) &&
+                   SimMain_WaveCheckWords(&framePattern, g_simMainWaveBuf, frameWords);
+    stairWords = GpioWave_Compile(&stairPattern, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS);
+    bool stairOk = (stairWords == 32U) && SimMain_WaveCheckWords(&stairPattern, g_simMainWaveBuf, stairWords);
+    fprintf(stderr, "wave compile      : frame %u steps %u words %s, staircase %u steps %u words %s, "
+                    "invalid descriptions %s, %s\n",
+            framePattern.step_count, frameWords, frameOk ? "match" : "differ", stairPattern.step_count, stairWords,
+            stairOk ? "match" : "differ", rejected ? "rejected" : "accepted",
+            (frameOk && stairOk && rejected) ? "ok" : SimMain_Fail("ERROR"));
+
+    LL_GPIO_ResetOutputPin(SIMMAIN_WAVE_PORT, SIMMAIN_WAVE_PINS);
+    (void)GpioWave_Compile(&framePattern, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS);
+    (void)SimMain_WavePlay("wave single      ", frameWords, false);
+    (void)GpioWave_Compile(&stairPattern, g_simMainWaveBuf, SIMMAIN_WAVE_WORDS);
+    (void)SimMain_WavePlay("wave circular    ", stairWords, true);
+    SimHw_GpioProbe(NULL, 0U);
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Check compiled words against their description.
+ *
+ * Each step must start with a word setting and resetting exactly the
+ * driven pins to its levels, followed by zero words for the rest of its
+ * length.
+ */
+static bool SimMain_WaveCheckWords(const GpioWave_Pattern_T *pattern, const uint32_t *words, uint32_t count)
+{
+    uint32_t at = 0U;
+
+    for (uint32_t i = 0U; i < pattern->step_count; i++)
+    {
+        const GpioWave_Step_T *step = &pattern->steps[i];
+        uint32_t set = step->levels & pattern->pins;
+        uint32_t reset = pattern->pins & ~(uint32_t)step->levels;
+        if ((at + step->ticks) > count)
+        {
+            return false;
+        }
+        if (((words[at] & 0xFFFFU) != set) || ((words[at] >> 16) != reset) || ((set & reset) != 0U))
+        {
+            return false;
+        }
+        for (uint32_t t = 1U; t < step->ticks; t++)
+        {
+            if (words[at + t] != 0U)
+            {
+                return false;
+            }
+        }
+        at += step->ticks;
+    }
+    return at == count;
+}
+
+/**
+ * @brief Play the compiled buffer and check the level changes seen on the port.
+ *
+ * Word k is written at update k + 1 after the start: every change must
+ * carry the levels the words give and lie a whole number of periods after
+ * the first one, as many as the words put between them. A looped
+ * playback must also go on across the lap boundary without a gap.
+ *
+ * @param[in] name     Report line label.
+ * @param[in] words    Words compiled in ::g_simMainWaveBuf.
+ * @param[in] circular Loop until stopped instead of playing once.
+ *
+ * @retval true  Every change matched.
+ * @retval false The playback failed or a change was missing, extra or mistimed.
+ */
+static bool SimMain_WavePlay(const char *name, uint32_t words, bool circular)
+{
+    GpioWave_Config_T config = {
+        .port = SIMMAIN_WAVE_PORT,
+        .pins = SIMMAIN_WAVE_PINS,
+        .buffer = g_simMainWaveBuf,
+        .words = words,
+        .rate_hz = SIMMAIN_WAVE_HZ,
+        .circular = circular,
+        .callback = SimMain_WaveDone,
+        .ctx = NULL,
+    };
+    GpioWave_Status_T before;
+    GpioWave_Status_T after;
+    SimHw_Stats_T stats;
+
+    GpioWave_GetStatus(&before);
+    g_simMainWaveEnds = 0U;
+    g_simMainWaveOk = false;
+    SimHw_GpioProbe(SIMMAIN_WAVE_PORT, SIMMAIN_WAVE_PINS);
+    SimHw_GetStats(&stats);
+    uint64_t startNs = stats.now_ns;
+    if (!GpioWave_Start(&config))
+    {
+        fprintf(stderr, "%s: %s start rejected\n", name, SimMain_Fail("ERROR"));
+        return false;
+    }
+
+    uint32_t lapMs = (uint32_t)(((uint64_t)words * 1000U) / SIMMAIN_WAVE_HZ) + 1U;
+    vTaskDelay(pdMS_TO_TICKS(circular ? SIMMAIN_WAVE_LOOP_MS : (lapMs + 1U)));
+    bool running = GpioWave_IsRunning();
+    GpioWave_Stop();
+    uint32_t lost = 0U;
+    uint32_t count = SimHw_GpioEdges(g_simMainWaveEdges, SIMMAIN_WAVE_EDGES, &lost);
+    vTaskDelay(pdMS_TO_TICKS(1U));
+    bool quiet = SimHw_GpioEdges(NULL, SIMMAIN_WAVE_EDGES, NULL) == count;
+    GpioWave_GetStatus(&after);
+
+    /* Replay the words on a model port and compare each change */
+    double periodNs = 1e9 / (double)after.actual_hz;
+    uint16_t levels = 0U;
+    uint32_t matched = 0U;
+    uint64_t firstTick = 0U;
+    double worstNs = 0.0;
+    uint64_t limit = circular ? ((uint64_t)count * words + words) : words;
+    for (uint64_t k = 0U; (k < limit) && (matched < count); k++)
+    {
+        uint32_t w = g_simMainWaveBuf[k % words];
+        uint16_t next = (uint16_t)(((levels & ~(w >> 16)) | w) & SIMMAIN_WAVE_PINS);
+        if (next == levels)
+        {
+            continue;
+        }
+        levels = next;
+        if (g_simMainWaveEdges[matched].levels != levels)
+        {
+            break;
+        }
+        if (matched == 0U)
+        {
+            firstTick = k;
+        }
+        double expected = (double)(k - firstTick) * periodNs;
+        double error = (double)(g_simMainWaveEdges[matched].ns - g_simMainWaveEdges[0].ns) - expected;
+        error = (error < 0.0) ? -error : error;
+        worstNs = (error > worstNs) ? error : worstNs;
+        matched++;
+    }
+    bool timed = worstNs <= (2.0 + ((double)(SIMMAIN_WAVE_LOOP_MS * SIMMAIN_NS_PER_MS) * 1e-6));
+    double firstNs = (count != 0U) ? (double)(g_simMainWaveEdges[0].ns - startNs) : 0.0;
+    uint32_t laps = after.laps - before.laps;
+
+    bool ok = (count != 0U) && (matched == count) && (lost == 0U) && timed && quiet &&
+              (after.dma_errors == before.dma_errors);
+    if (circular)
+    {
+        /* A lap ends one period after its last word is written */
+        uint32_t expectedLaps = (uint32_t)(((uint64_t)SIMMAIN_WAVE_LOOP_MS * after.actual_hz) / 1000U / words);
+        ok = ok && running && (laps + 1U >= expectedLaps) && (laps <= expectedLaps + 1U) &&
+             (after.stopped == before.stopped + 1U) && (g_simMainWaveEnds == 0U);
+    }
+    else
+    {
+        ok = ok && !running && (laps == 1U) && (g_simMainWaveEnds == 1U) && g_simMainWaveOk &&
+             (after.completed == before.completed + 1U);
+    }
+    fprintf(stderr, "%s: %u words at %u Hz, %u laps, %u edges checked of %u (%u lost), first after %.0f ns, "
+                    "worst timing error %.1f ns, %s after the end, %s\n",
+            name, words, after.actual_hz, laps, matched, count, lost, firstNs, worstNs,
+            quiet ? "quiet" : "still moving", ok ? "ok" : SimMain_Fail("ERROR"));
+    return ok;
+}
+
+/**
+ * @brief End callback of the --wave-bench playbacks.
+ */
+static void SimMain_WaveDone(void *ctx, bool success)
+{
+    (void)ctx;
+    g_simMainWaveOk = success;
+    g_simMainWaveEnds++;
+}
+
+/** @} */ // end of SimMain group
@@ -0,0 +1,329 @@
+/**
+ * @file SimPort.c
+ * @brief FreeRTOS port layer for the host simulation.
+ * @ingroup SimPort
+ * @{
+ *
+ * Every task runs on its own host stack as a user-space context, all on a
+ * single host thread. Scheduling follows the Cortex-M port: a yield pends
+ * PendSV, SysTick or the timer set up by the firmware drives the tick and
+ * PendSV switches context once no higher priority exception is running.
+ * Masking uses the simulated BASEPRI so critical sections hold off the
+ * modelled interrupts as on target.
+ *
+ * The FreeRTOS stack of a task only holds a link to its host context; the
+ * task code itself runs on a separate, larger host stack mapped below 2 GB
+ * so the drivers can still pass stack addresses to DMA as 32-bit values.
+ */
+
+/* Includes -----------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32n6xx.h"
+#include "SimHw.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define SIMPORT_HOST_STACK_SIZE  (256U * 1024U) /**< Host stack of one task */
+#define SIMPORT_CRITICAL_NS      (100U)         /**< CPU time charged per critical section */
+#define SIMPORT_NESTING_INIT     (0xaaaaaaaaUL) /**< Nesting before the scheduler starts */
+#define SIMPORT_LINK_OFFSET      (2U)           /**< Words between stack top and the context link */
+#define SIMPORT_FRAME_WORDS      (4U)           /**< Words reserved on the FreeRTOS stack */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Host execution context of one task.
+ */
+typedef struct
+{
+    ucontext_t context;      /**< Saved registers */
+    void *stack;             /**< Host stack */
+    TaskFunction_t code;     /**< Task entry */
+    void *parameters;        /**< Task argument */
+} SimPort_Thread_T;
+
+/* Global Variables ---------------------------------------------------------*/
+/** Critical section nesting, shared by all tasks as on the ARM port. */
+static UBaseType_t uxCriticalNesting = SIMPORT_NESTING_INIT;
+/** Context of the caller of vTaskStartScheduler(), resumed by vPortEndScheduler(). */
+static ucontext_t g_simPortMainContext;
+/** CPU time charged when the outermost critical section exits. */
+static uint32_t g_simPortCriticalNs = SIMPORT_CRITICAL_NS;
+
+extern void *volatile pxCurrentTCB;
+
+/* Private Function Prototypes ----------------------------------------------*/
+static SimPort_Thread_T *SimPort_GetThread(void *tcb);
+static void SimPort_TaskEntry(void);
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Set the CPU time charged per outermost critical section.
+ */
+void SimPort_SetCriticalCost(uint32_t ns)
+{
+    g_simPortCriticalNs = ns;
+}
+
+/**
+ * @brief Create the host context of a new task.
+ *
+ * The context link is kept in the reserved frame at the top of the
+ * FreeRTOS stack, which nothing else touches on the host.
+ */
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters)
+{
+    SimPort_Thread_T *thread = calloc(1U, sizeof(*thread));
+    void *stack = mmap(NULL, SIMPORT_HOST_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    configASSERT((thread != NULL) && (stack != MAP_FAILED));
+
+    SimHw_RegisterMemory(stack, SIMPORT_HOST_STACK_SIZE);
+    thread->stack = stack;
+    thread->code = pxCode;
+    thread->parameters = pvParameters;
+    getcontext(&thread->context);
+    thread->context.uc_stack.ss_sp = stack;
+    thread->context.uc_stack.ss_size = SIMPORT_HOST_STACK_SIZE;
+    thread->context.uc_link = NULL;
+    makecontext(&thread->context, SimPort_TaskEntry, 0);
+
+    pxTopOfStack = (StackType_t *)((uintptr_t)pxTopOfStack & ~(uintptr_t)(portBYTE_ALIGNMENT - 1U));
+    *(SimPort_Thread_T **)(pxTopOfStack - SIMPORT_LINK_OFFSET) = thread;
+    return pxTopOfStack - SIMPORT_FRAME_WORDS;
+}
+
+/**
+ * @brief Tick source setup, SysTick unless the firmware provides its own.
+ *
+ * Weak like in the ARM port.
+ */
+__attribute__((weak)) void vPortSetupTimerInterrupt(void)
+{
+    SysTick->CTRL = 0U;
+    SysTick->VAL = 0U;
+    SysTick->LOAD = (configCPU_CLOCK_HZ / configTICK_RATE_HZ) - 1UL;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/**
+ * @brief Start the first task.
+ *
+ * Sets up the tick and the kernel exception priorities like the ARM port,
+ * then switches to the first task. Returns only after vPortEndScheduler().
+ */
+BaseType_t xPortStartScheduler(void)
+{
+    SCB->SHPR[SysTick_IRQn + 12] = configKERNEL_INTERRUPT_PRIORITY;
+    SCB->SHPR[PendSV_IRQn + 12] = configKERNEL_INTERRUPT_PRIORITY;
+
+    vPortSetupTimerInterrupt();
+
+    uxCriticalNesting = 0U;
+    swapcontext(&g_simPortMainContext, &SimPort_GetThread(pxCurrentTCB)->context);
+    return pdFALSE;
+}
+
+/**
+ * @brief Return to the caller of vTaskStartScheduler().
+ */
+void vPortEndScheduler(void)
+{
+    SysTick->CTRL = 0U;
+    setcontext(&g_simPortMainContext);
+}
+
+/**
+ * @brief Request a context switch through PendSV.
+ */
+void vPortYield(void)
+{
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    __DSB();
+    __ISB();
+}
+
+/**
+ * @brief Enter a critical section.
+ */
+void vPortEnterCritical(void)
+{
+    portDISABLE_INTERRUPTS();
+    uxCriticalNesting++;
+}
+
+/**
+ * @brief Leave a critical section.
+ *
+ * The outermost exit is charged as CPU work before interrupts are unmasked,
+ * so polling loops built on kernel calls make virtual time progress.
+ */
+void vPortExitCritical(void)
+{
+    configASSERT(uxCriticalNesting != 0U);
+    uxCriticalNesting--;
+    if (uxCriticalNesting == 0U)
+    {
+        SimHw_Charge(g_simPortCriticalNs);
+        portENABLE_INTERRUPTS();
+    }
+}
+
+/**
+ * @brief Raise BASEPRI to the syscall priority.
+ *
+ * @return Previous BASEPRI.
+ */
+uint32_t ulSetInterruptMask(void)
+{
+    uint32_t previous = __get_BASEPRI();
+    __set_BASEPRI(configMAX_SYSCALL_INTERRUPT_PRIORITY);
+    return previous;
+}
+
+/**
+ * @brief Restore BASEPRI.
+ */
+void vClearInterruptMask(uint32_t ulMask)
+{
+    __set_BASEPRI(ulMask);
+}
+
+/**
+ * @brief Whether the caller runs in an exception handler.
+ */
+BaseType_t xPortIsInsideInterrupt(void)
+{
+    return (__get_IPSR() != 0U) ? pdTRUE : pdFALSE;
+}
+
+/**
+ * @brief Release the host context of a deleted task.
+ */
+void vPortCleanUpTCB(void *tcb)
+{
+    SimPort_Thread_T *thread = SimPort_GetThread(tcb);
+
+    munmap(thread->stack, SIMPORT_HOST_STACK_SIZE);
+    free(thread);
+}
+
+/**
+ * @brief PendSV: select the next task and switch to it.
+ */
+void PendSV_Handler(void)
+{
+    SimPort_Thread_T *previous = SimPort_GetThread(pxCurrentTCB);
+
+    portDISABLE_INTERRUPTS();
+    vTaskSwitchContext();
+    portENABLE_INTERRUPTS();
+
+    SimPort_Thread_T *next = SimPort_GetThread(pxCurrentTCB);
+    if (next != previous)
+    {
+        swapcontext(&previous->context, &next->context);
+    }
+}
+
+/**
+ * @brief SysTick: advance the kernel tick.
+ */
+void xPortSysTickHandler(void)
+{
+    uint32_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (xTaskIncrementTick() != pdFALSE)
+    {
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/* FreeRTOSConfig.h maps the vector name onto the port handler. */
+#undef SysTick_Handler
+void SysTick_Handler(void)
+{
+    xPortSysTickHandler();
+}
+
+/**
+ * @brief Idle hook: every task is blocked, sleep until the next event.
+ *
+ * Runs before a tickless sleep is considered, so it sleeps at most to the
+ * next interrupt, normally the next tick.
+ */
+void vApplicationIdleHook(void)
+{
+    __WFI();
+}
+
+/**
+ * @brief Memory of the idle task.
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    static StaticTask_t idleTcb;
+    static StackType_t idleStack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idleTcb;
+    *ppxIdleTaskStackBuffer = idleStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/**
+ * @brief Memory of the timer service task.
+ */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    static StaticTask_t timerTcb;
+    static StackType_t timerStack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timerTcb;
+    *ppxTimerTaskStackBuffer = timerStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+/**
+ * @brief configASSERT() failure: report and stop the process.
+ */
+void vSimPortAssertFailed(const char *file, int line)
+{
+    fprintf(stderr, "Assertion failed at %s:%d (t=%llu ns)\n", file, line,
+            (unsigned long long)SimHw_GetTimeNs());
+    abort();
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Host context linked from the stack top saved in a TCB.
+ */
+static SimPort_Thread_T *SimPort_GetThread(void *tcb)
+{
+    StackType_t *topOfStack = *(StackType_t **)tcb;
+    return *(SimPort_Thread_T **)(topOfStack + SIMPORT_FRAME_WORDS - SIMPORT_LINK_OFFSET);
+}
+
+/**
+ * @brief First code run by a task on its host stack.
+ *
+ * A task starts as if returning from the exception that switched to it.
+ */
+static void SimPort_TaskEntry(void)
+{
+    SimPort_Thread_T *thread = SimPort_GetThread(pxCurrentTCB);
+
+    SimHw_EnterThreadMode();
+    uxCriticalNesting = 0U;
+    SimHw_Sync();
+    thread->code(thread->parameters);
+
+    /* Tasks must not return, same check as prvTaskExitError() */
+    vSimPortAssertFailed(__FILE__, __LINE__);
+}
+
+/** @} */ // end of SimPort group
@@ -0,0 +1,250 @@
+/**
+ * @file SimVenc.c
+ * @brief Software stand-in for the VENC behind the Venc pipeline.
+ * @ingroup SimVenc
+ * @{
+ *
+ * Host build only: the firmware has no VENC backend of its own. A task takes each encode request, writes the packet and reports it once
+ * the VENC encode time has passed since the request was picked up, so the
+ * pipeline sees completions at the rate of the hardware. The packet is the
+ * codec framing (H.264 parameter sets and slice start codes, or JPEG SOI
+ * and EOI) around run/value pairs of the quantised luma. Runs never reach
+ * 0xFF and values stay below 0x40, so the payload contains neither a
+ * start code nor a JPEG marker.
+ */
+
+/* Includes ------------------------------------------------------------------*/
+#include "SimVenc.h"
+#include <stddef.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Defines -------------------------------------------------------------------*/
+#define SIMVENC_MAX_RUN (0xFEU)  /**< Longest run of one value */
+#define SIMVENC_MIN_SHIFT (2U)   /**< Quantisation keeping values below 0x40 */
+#define SIMVENC_MAX_SHIFT (6U)   /**< Coarsest quantisation */
+#define SIMVENC_NAL_SPS (0x67U)  /**< Sequence parameter set NAL header */
+#define SIMVENC_NAL_PPS (0x68U)  /**< Picture parameter set NAL header */
+#define SIMVENC_NAL_IDR (0x65U)  /**< IDR slice NAL header */
+#define SIMVENC_NAL_P (0x41U)    /**< Non-IDR slice NAL header */
+
+/* Local Types and Typedefs -------------------------------------------------*/
+/**
+ * @brief Encode request handed to the task.
+ */
+typedef struct
+{
+    const uint8_t *frame; /**< Input frame */
+    uint8_t *out;         /**< Packet destination */
+    uint32_t capacity;    /**< Bytes available at @ref out */
+    bool keyframe;        /**< Emit a key frame */
+} SimVenc_Job_T;
+
+/* Global Variables ----------------------------------------------------------*/
+/** Configuration applied by the pipeline. */
+static Venc_Config_T g_simVencConfig;
+/** Request being served. */
+static SimVenc_Job_T g_simVencJob;
+/** Stand-in encoder task. */
+static TaskHandle_t g_simVencTask = NULL;
+
+/* Private Function Prototypes -----------------------------------------------*/
+/** Backend configure entry. */
+static bool SimVenc_Configure(const Venc_Config_T *config);
+/** Backend encode entry. */
+static bool SimVenc_Encode(const void *frame, uint8_t *out, uint32_t capacity, bool keyframe);
+/** Stand-in encoder task. */
+static void SimVenc_Task(void *pvParameters);
+/** Write the packet of the current request. */
+static uint32_t SimVenc_WritePacket(const SimVenc_Job_T *job);
+/** Luma of pixel @p index. */
+static uint32_t SimVenc_Luma(const uint8_t *frame, uint32_t index);
+
+/** Backend returned by ::SimVenc_Backend. */
+static const Venc_Backend_T g_simVencBackend = {SimVenc_Configure, SimVenc_Encode};
+
+/* Public Functions Implementation ------------------------------------------*/
+/**
+ * @brief Software stand-in for the VENC.
+ */
+const Venc_Backend_T *SimVenc_Backend(void)
+{
+    return &g_simVencBackend;
+}
+
+/* Private Functions Implementation -----------------------------------------*/
+/**
+ * @brief Keep the configuration and create the task on first use.
+ */
+static bool SimVenc_Configure(const Venc_Config_T *config)
+{
+    g_simVencConfig = *config;
+
+    if (g_simVencTask == NULL)
+    {
+        xTaskCreate(SimVenc_Task, "SimVenc", SIMVENC_TASK_STACK_SIZE, NULL, tskIDLE_PRIORITY + 2,
+                    &g_simVencTask);
+    }
+    return g_simVencTask != NULL;
+}
+
+/**
+ * @brief Hand a request to the task, from task or interrupt context.
+ */
+static bool SimVenc_Encode(const void *frame, uint8_t *out, uint32_t capacity, bool keyframe)
+{
+    g_simVencJob.frame = (const uint8_t *)frame;
+    g_simVencJob.out = out;
+    g_simVencJob.capacity = capacity;
+    g_simVencJob.keyframe = keyframe;
+
+    if (xPortIsInsideInterrupt() != pdFALSE)
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(g_simVencTask, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    else
+    {
+        xTaskNotifyGive(g_simVencTask);
+    }
+    return true;
+}
+
+/**
+ * @brief Serve encode requests at the VENC rate.
+ *
+ * @param[in] pvParameters Unused parameter.
+ */
+static void SimVenc_Task(void *pvParameters)
+{
+    (void)pvParameters;
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        TickType_t start = xTaskGetTickCount();
+
+        uint32_t size = SimVenc_WritePacket(&g_simVencJob);
+
+        uint32_t pixels = g_simVencConfig.width * g_simVencConfig.height;
+        uint32_t ms = (pixels + SIMVENC_PIXELS_PER_MS - 1U) / SIMVENC_PIXELS_PER_MS;
+        vTaskDelayUntil(&start, pdMS_TO_TICKS(ms));
+
+        Venc_EncodeDone(size, size != 0U);
+    }
+}
+
+/**
+ * @brief Write the packet of a request.
+ *
+ * @return Packet bytes, 0 if it did not fit in the capacity.
+ */
+static uint32_t SimVenc_WritePacket(const SimVenc_Job_T *job)
+{
+    const Venc_Config_T *cfg = &g_simVencConfig;
+    uint8_t header[16];
+    uint32_t len = 0U;
+    uint32_t shift;
+
+    if (cfg->codec == VENC_CODEC_H264)
+    {
+        static const uint8_t startCode[4] = {0x00U, 0x00U, 0x00U, 0x01U};
+        if (job->keyframe)
+        {
+            for (uint32_t i = 0U; i < 4U; i++)
+            {
+                header[len++] = startCode[i];
+            }
+            header[len++] = SIMVENC_NAL_SPS;
+            header[len++] = (uint8_t)(cfg->width / VENC_ALIGN);
+            header[len++] = (uint8_t)(cfg->height / VENC_ALIGN);
+            for (uint32_t i = 0U; i < 4U; i++)
+            {
+                header[len++] = startCode[i];
+            }
+            header[len++] = SIMVENC_NAL_PPS;
+        }
+        for (uint32_t i = 0U; i < 4U; i++)
+        {
+            header[len++] = startCode[i];
+        }
+        header[len++] = job->keyframe ? SIMVENC_NAL_IDR : SIMVENC_NAL_P;
+        shift = SIMVENC_MIN_SHIFT + (cfg->quality / 13U);
+    }
+    else
+    {
+        header[len++] = 0xFFU; /* SOI */
+        header[len++] = 0xD8U;
+        shift = SIMVENC_MIN_SHIFT + ((100U - cfg->quality) / 25U);
+    }
+    if (shift > SIMVENC_MAX_SHIFT)
+    {
+        shift = SIMVENC_MAX_SHIFT;
+    }
+
+    if (job->capacity < (len + 2U))
+    {
+        return 0U;
+    }
+    for (uint32_t i = 0U; i < len; i++)
+    {
+        job->out[i] = header[i];
+    }
+
+    uint32_t pixels = cfg->width * cfg->height;
+    uint32_t value = SimVenc_Luma(job->frame, 0U) >> shift;
+    uint32_t run = 0U;
+    for (uint32_t i = 0U; i <= pixels; i++)
+    {
+        uint32_t next = (i < pixels) ? (SimVenc_Luma(job->frame, i) >> shift) : 0xFFFFU;
+        if ((next == value) && (run < SIMVENC_MAX_RUN))
+        {
+            run++;
+            continue;
+        }
+        if ((len + 2U) > job->capacity)
+        {
+            return 0U;
+        }
+        job->out[len++] = (uint8_t)run;
+        job->out[len++] = (uint8_t)value;
+        value = next;
+        run = 1U;
+    }
+
+    if (cfg->codec == VENC_CODEC_JPEG)
+    {
+        if ((len + 2U) > job->capacity)
+        {
+            return 0U;
+        }
+        job->out[len++] = 0xFFU; /* EOI */
+        job->out[len++] = 0xD9U;
+    }
+    return len;
+}
+
+/**
+ * @brief Luma of pixel @p index of the configured layout.
+ */
+static uint32_t SimVenc_Luma(const uint8_t *frame, uint32_t index)
+{
+    switch (g_simVencConfig.format)
+    {
+    case VENC_FMT_NV12:
+        return frame[index];
+    case VENC_FMT_YUYV:
+        return frame[index * 2U];
+    default:
+    {
+        uint32_t v = (uint32_t)frame[index * 2U] | ((uint32_t)frame[(index * 2U) + 1U] << 8);
+        uint32_t r = (v >> 11) << 3;
+        uint32_t g = ((v >> 5) & 0x3FU) << 2;
+        uint32_t b = (v & 0x1FU) << 3;
+        return ((r * 77U) + (g * 150U) + (b * 29U)) >> 8;
+    }
+    }
+}
+
+/** @} */ // end of SimVenc group